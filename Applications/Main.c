@@ -12,6 +12,9 @@
 #include "HAPPlatformAccessorySetup+Init.h"
 #include "HAPPlatformBLEPeripheralManager+Init.h"
 #include "HAPPlatformKeyValueStore+Init.h"
+#if HAVE_ASYNC_LOG
+#include "HAPPlatformLog+Init.h"
+#endif
 #include "HAPPlatformMFiHWAuth+Init.h"
 #include "HAPPlatformMFiTokenAuth+Init.h"
 #include "HAPPlatformRunLoop+Init.h"
@@ -21,6 +24,10 @@
 #endif
 
 #include <signal.h>
+#if HAVE_IP_CAPTURE
+#include <stdio.h>
+#endif
+#include <stdlib.h>
 static bool requestedFactoryReset = false;
 static bool clearPairings = false;
 
@@ -44,6 +51,10 @@ static struct {
     HAPPlatformTCPStreamManager tcpStreamManager;
 #endif
 
+#if HAVE_IP_CAPTURE
+    FILE* _Nullable captureFile;
+#endif
+
     HAPPlatformMFiHWAuth mfiHWAuth;
     HAPPlatformMFiTokenAuth mfiTokenAuth;
 } platform;
@@ -73,6 +84,13 @@ extern const HAPAccessory* AppGetAccessoryInfo();
  * Initialize global platform objects.
  */
 static void InitializePlatform() {
+#if HAVE_ASYNC_LOG
+    // Log. Records are written to stderr by a background thread.
+    HAPPlatformLogCreate(&(const HAPPlatformLogOptions) { .format = kHAPPlatformLogFormat_Text,
+                                                          .useBackgroundWriter = true,
+                                                          .maxRecordsPerSecond = 0 });
+#endif
+
     // Key-value store.
     HAPPlatformKeyValueStoreCreate(
             &platform.keyValueStore, &(const HAPPlatformKeyValueStoreOptions) { .rootDirectory = ".HomeKitStore" });
@@ -91,7 +109,10 @@ static void InitializePlatform() {
             &(const HAPPlatformTCPStreamManagerOptions) {
                     .interfaceName = NULL,       // Listen on all available network interfaces.
                     .port = kHAPNetworkPort_Any, // Listen on unused port number from the ephemeral port range.
-                    .maxConcurrentTCPStreams = kHAPIPSessionStorage_DefaultNumElements });
+                    // One TCP stream per session, plus one to accept new connections when all sessions are in use.
+                    .maxConcurrentTCPStreams =
+                            (1 + kHAPIPSessionStorage_MaxAdditionalChunks) * kHAPIPSessionStorage_DefaultNumElements +
+                            1 });
 
     // Service discovery.
     static HAPPlatformServiceDiscovery serviceDiscovery;
@@ -106,7 +127,9 @@ static void InitializePlatform() {
 #if (BLE)
     // BLE peripheral manager. Depends on key-value store.
     static HAPPlatformBLEPeripheralManagerOptions blePMOptions = { 0 };
+#if DARWIN
     blePMOptions.keyValueStore = &platform.keyValueStore;
+#endif
 
     static HAPPlatformBLEPeripheralManager blePeripheralManager;
     HAPPlatformBLEPeripheralManagerCreate(&blePeripheralManager, &blePMOptions);
@@ -152,10 +175,23 @@ static void DeinitializePlatform() {
     HAPPlatformTCPStreamManagerRelease(&platform.tcpStreamManager);
 #endif
 
+#if HAVE_IP_CAPTURE
+    // Session traffic capture.
+    if (platform.captureFile) {
+        fclose(platform.captureFile);
+        platform.captureFile = NULL;
+    }
+#endif
+
     AppDeinitialize();
 
     // Run loop.
     HAPPlatformRunLoopRelease();
+
+#if HAVE_ASYNC_LOG
+    // Log.
+    HAPPlatformLogRelease();
+#endif
 }
 
 /**
@@ -217,9 +253,94 @@ void HandleUpdatedState(HAPAccessoryServerRef* _Nonnull server, void* _Nullable
 }
 
 #if IP
+/**
+ * Element of a chunk of additional IP sessions.
+ *
+ * - Additional sessions use small buffers and borrow larger buffers from the buffer pool when needed.
+ */
+typedef struct {
+    uint8_t ipInboundBuffer[kHAPIPSession_PooledInboundBufferSize];
+    uint8_t ipOutboundBuffer[kHAPIPSession_PooledOutboundBufferSize];
+    HAPIPEventNotificationRef ipEventNotifications[kAttributeCount];
+} IPSessionChunkElement;
+
+/**
+ * Allocates a chunk of additional IP sessions on the heap.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError AllocateIPSessionChunk(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        size_t numSessions,
+        HAPIPSession* _Nullable* _Nonnull sessions,
+        HAPIPSessionSlotRef* _Nullable* _Nonnull sessionSlots,
+        void* _Nullable* _Nonnull allocation,
+        void* _Nullable context HAP_UNUSED) {
+    HAPIPSession* ipSessions = calloc(numSessions, sizeof *ipSessions);
+    HAPIPSessionSlotRef* ipSessionSlots = calloc(numSessions, sizeof *ipSessionSlots);
+    IPSessionChunkElement* elements = calloc(numSessions, sizeof *elements);
+    if (!ipSessions || !ipSessionSlots || !elements) {
+        free(ipSessions);
+        free(ipSessionSlots);
+        free(elements);
+        return kHAPError_OutOfResources;
+    }
+    for (size_t i = 0; i < numSessions; i++) {
+        ipSessions[i].inboundBuffer.bytes = elements[i].ipInboundBuffer;
+        ipSessions[i].inboundBuffer.numBytes = sizeof elements[i].ipInboundBuffer;
+        ipSessions[i].outboundBuffer.bytes = elements[i].ipOutboundBuffer;
+        ipSessions[i].outboundBuffer.numBytes = sizeof elements[i].ipOutboundBuffer;
+        ipSessions[i].eventNotifications = elements[i].ipEventNotifications;
+        ipSessions[i].numEventNotifications = HAPArrayCount(elements[i].ipEventNotifications);
+    }
+    *sessions = ipSessions;
+    *sessionSlots = ipSessionSlots;
+    *allocation = elements;
+    return kHAPError_None;
+}
+
+/**
+ * Releases a chunk of additional IP sessions that has been allocated by AllocateIPSessionChunk.
+ */
+static void ReleaseIPSessionChunk(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        size_t numSessions,
+        HAPIPSession* sessions,
+        HAPIPSessionSlotRef* sessionSlots,
+        void* _Nullable allocation,
+        void* _Nullable context HAP_UNUSED) {
+    HAPPrecondition(numSessions);
+    HAPPrecondition(allocation);
+
+    free(allocation);
+    free(sessionSlots);
+    free(sessions);
+}
+
+#if HAVE_IP_CAPTURE
+/**
+ * Appends HAP over IP session traffic capture data to the capture file.
+ */
+static void HandleIPCapture(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const void* bytes,
+        size_t numBytes,
+        void* _Nullable context HAP_UNUSED) {
+    if (!platform.captureFile) {
+        return;
+    }
+    // Flush every write so that the capture remains usable if the accessory is terminated abnormally.
+    if (fwrite(bytes, 1, numBytes, platform.captureFile) != numBytes || fflush(platform.captureFile)) {
+        HAPLogError(&kHAPLog_Default, "Writing IP capture failed. Capturing is stopped.");
+        fclose(platform.captureFile);
+        platform.captureFile = NULL;
+    }
+}
+#endif
+
 static void InitializeIP() {
     // Prepare accessory server storage.
     static HAPIPSession ipSessions[kHAPIPSessionStorage_DefaultNumElements];
+    static HAPIPSessionSlotRef ipSessionSlots[HAPArrayCount(ipSessions)];
     static uint8_t ipInboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultInboundBufferSize];
     static uint8_t ipOutboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultOutboundBufferSize];
     static HAPIPEventNotificationRef ipEventNotifications[HAPArrayCount(ipSessions)][kAttributeCount];
@@ -234,19 +355,35 @@ static void InitializeIP() {
     static HAPIPReadContextRef ipReadContexts[kAttributeCount];
     static HAPIPWriteContextRef ipWriteContexts[kAttributeCount];
     static uint8_t ipScratchBuffer[kHAPIPSession_DefaultScratchBufferSize];
+    static uint8_t ipBufferPool[4][kHAPIPSession_DefaultInboundBufferSize];
     static HAPIPAccessoryServerStorage ipAccessoryServerStorage = {
         .sessions = ipSessions,
         .numSessions = HAPArrayCount(ipSessions),
+        .sessionSlots = ipSessionSlots,
         .readContexts = ipReadContexts,
         .numReadContexts = HAPArrayCount(ipReadContexts),
         .writeContexts = ipWriteContexts,
         .numWriteContexts = HAPArrayCount(ipWriteContexts),
-        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer }
+        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer },
+        .bufferPool = { .bytes = ipBufferPool,
+                        .numBytesPerBlock = sizeof ipBufferPool[0],
+                        .numBlocks = HAPArrayCount(ipBufferPool) },
+        .sessionChunks = { .allocate = AllocateIPSessionChunk, .release = ReleaseIPSessionChunk }
     };
 
     platform.hapAccessoryServerOptions.ip.transport = &kHAPAccessoryServerTransport_IP;
     platform.hapAccessoryServerOptions.ip.accessoryServerStorage = &ipAccessoryServerStorage;
 
+#if HAVE_IP_CAPTURE
+    // Session traffic capture. Can be replayed with Tools/CaptureReplay.
+    platform.captureFile = fopen("IPCapture.bin", "wb");
+    if (platform.captureFile) {
+        platform.hapAccessoryServerOptions.ip.capture.callback = HandleIPCapture;
+    } else {
+        HAPLogError(&kHAPLog_Default, "Opening IP capture file failed.");
+    }
+#endif
+
     platform.hapPlatform.ip.tcpStreamManager = &platform.tcpStreamManager;
 }
 #endif
@@ -254,6 +391,11 @@ static void InitializeIP() {
 #if BLE
 static void InitializeBLE() {
     static HAPBLEGATTTableElementRef gattTableElements[kAttributeCount];
+    static uint16_t attributeHandleIndex[kHAPBLEAttributeHandleIndex_NumElementsPerGATTTableElement * kAttributeCount];
+    static uint16_t characteristicIndex[kAttributeCount];
+    static uint8_t signatureBytes[kHAPBLESignatureBuffer_NumBytesPerGATTTableElement * kAttributeCount];
+    static HAPPlatformBLEPeripheralManagerGATTAttribute
+            gattDatabaseAttributes[kHAPBLEGATTDatabase_NumAttributesPerGATTTableElement * kAttributeCount];
     static HAPBLESessionCacheElementRef sessionCacheElements[kHAPBLESessionCache_MinElements];
     static HAPSessionRef session;
     static uint8_t procedureBytes[2048];
@@ -262,6 +404,13 @@ static void InitializeBLE() {
     static HAPBLEAccessoryServerStorage bleAccessoryServerStorage = {
         .gattTableElements = gattTableElements,
         .numGATTTableElements = HAPArrayCount(gattTableElements),
+        .attributeHandleIndex = attributeHandleIndex,
+        .numAttributeHandleIndexElements = HAPArrayCount(attributeHandleIndex),
+        .characteristicIndex = characteristicIndex,
+        .numCharacteristicIndexElements = HAPArrayCount(characteristicIndex),
+        .signatureBuffer = { .bytes = signatureBytes, .numBytes = sizeof signatureBytes },
+        .gattDatabaseAttributes = gattDatabaseAttributes,
+        .numGATTDatabaseAttributes = HAPArrayCount(gattDatabaseAttributes),
         .sessionCacheElements = sessionCacheElements,
         .numSessionCacheElements = HAPArrayCount(sessionCacheElements),
         .session = &session,
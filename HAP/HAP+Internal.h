@@ -30,6 +30,8 @@ extern "C" {
 #include "HAPDeviceID.h"
 #include "HAPPDU.h"
 
+#include "HAPAccessorySetup.h"
+
 #include "HAPMFiAuth.h"
 #include "HAPMFiHWAuth+Types.h"
 #include "HAPMFiHWAuth.h"
@@ -60,6 +62,7 @@ extern "C" {
 #include "HAPBLEProtocol+Configuration.h"
 #include "HAPBLEService+Signature.h"
 #include "HAPBLESession.h"
+#include "HAPBLESignatureCache.h"
 
 #include "HAPIP+ByteBuffer.h"
 #include "HAPIPAccessory.h"
@@ -69,15 +72,17 @@ extern "C" {
 #include "HAPIPSession.h"
 
 #include "HAPIPAccessoryServer.h"
+#include "HAPIPCapture.h"
 #include "HAPIPServiceDiscovery.h"
 
 #include "HAP+KeyValueStoreDomains.h"
 #include "HAPAccessory+Info.h"
 #include "HAPAccessoryServer+Internal.h"
-#include "HAPAccessorySetup.h"
 #include "HAPAccessorySetupInfo.h"
 #include "HAPAccessoryValidation.h"
 #include "HAPCharacteristic.h"
+#include "HAPCharacteristicValueCache.h"
+#include "HAPMetrics.h"
 
 #include "HAPJSONUtils.h"
 #include "HAPLog+Attributes.h"
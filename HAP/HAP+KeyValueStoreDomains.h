@@ -100,6 +100,13 @@ extern "C" {
  */
 #define kHAPKeyValueStoreKey_Configuration_BLEBroadcastParameters ((HAPPlatformKeyValueStoreKey) 0x41)
 
+/**
+ * Fingerprint of the most recently published BLE GATT database.
+ *
+ * Format: <fingerprint : uint8_t[16]>
+ */
+#define kHAPKeyValueStoreKey_Configuration_BLEGATTDatabaseFingerprint ((HAPPlatformKeyValueStoreKey) 0x42)
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // kHAPKeyValueStoreDomain_CharacteristicConfiguration.
@@ -215,7 +215,7 @@ void HAPTLVWriterGetScratchBytes(
 /**
  * HomeKit Accessory server.
  */
-typedef HAP_OPAQUE(2418) HAPAccessoryServerRef;
+typedef HAP_OPAQUE(3616) HAPAccessoryServerRef;
 HAP_NONNULL_SUPPORT(HAPAccessoryServerRef)
 
 /**
@@ -746,6 +746,7 @@ struct HAPDataCharacteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -776,6 +777,7 @@ struct HAPDataCharacteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -997,6 +999,7 @@ struct HAPBoolCharacteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -1024,6 +1027,7 @@ struct HAPBoolCharacteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -1289,6 +1293,7 @@ struct HAPUInt8Characteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -1316,6 +1321,7 @@ struct HAPUInt8Characteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -1550,6 +1556,7 @@ struct HAPUInt16Characteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -1577,6 +1584,7 @@ struct HAPUInt16Characteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -1811,6 +1819,7 @@ struct HAPUInt32Characteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -1838,6 +1847,7 @@ struct HAPUInt32Characteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -2072,6 +2082,7 @@ struct HAPUInt64Characteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -2099,6 +2110,7 @@ struct HAPUInt64Characteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -2333,6 +2345,7 @@ struct HAPIntCharacteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -2360,6 +2373,7 @@ struct HAPIntCharacteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -2594,6 +2608,7 @@ struct HAPFloatCharacteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -2621,6 +2636,7 @@ struct HAPFloatCharacteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -2849,6 +2865,7 @@ struct HAPStringCharacteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -2877,6 +2894,7 @@ struct HAPStringCharacteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -3097,6 +3115,7 @@ struct HAPTLV8Characteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -3124,6 +3143,7 @@ struct HAPTLV8Characteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If deferred (HAP over IP only). See HAPAccessoryServerCompleteRequest.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -3235,6 +3255,60 @@ typedef struct {
     const HAPAccessory* accessory;
 } HAPServiceRequest;
 
+/**
+ * Characteristic write that is part of a service batch write request.
+ */
+typedef struct {
+    /**
+     * The characteristic whose value is to be written.
+     */
+    const HAPCharacteristic* characteristic;
+
+    /**
+     * Whether the request appears to have originated from a remote controller, e.g. via Apple TV.
+     */
+    bool remote;
+
+    /**
+     * Additional authorization data.
+     */
+    struct {
+        const void* _Nullable bytes; /**< Raw AAD data, if applicable. */
+        size_t numBytes;             /**< Length of additional authorization data. */
+    } authorizationData;
+
+    /**
+     * Value to write. The member that is set depends on the format of the characteristic.
+     *
+     * - Values have already been checked against the constraints of the characteristic.
+     */
+    union {
+        /** Value of a Data characteristic. */
+        struct {
+            const void* bytes; /**< Value buffer. */
+            size_t numBytes;   /**< Length of value buffer. */
+        } dataValue;
+
+        bool boolValue;            /**< Value of a Bool characteristic. */
+        uint8_t uint8Value;        /**< Value of a UInt8 characteristic. */
+        uint16_t uint16Value;      /**< Value of a UInt16 characteristic. */
+        uint32_t uint32Value;      /**< Value of a UInt32 characteristic. */
+        uint64_t uint64Value;      /**< Value of a UInt64 characteristic. */
+        int32_t intValue;          /**< Value of an Int characteristic. */
+        float floatValue;          /**< Value of a Float characteristic. */
+        const char* stringValue;   /**< Value of a String characteristic. NULL-terminated. */
+        HAPTLVReaderRef tlv8Value; /**< Value of a TLV8 characteristic. */
+    } value;
+
+    /**
+     * Result of the write. Set by the batch write handler.
+     *
+     * - Initialized to kHAPError_None.
+     * - The same errors as for the characteristic's handleWrite callback may be reported.
+     */
+    HAPError status;
+} HAPCharacteristicBatchWrite;
+
 /**
  * HomeKit service.
  */
@@ -3300,6 +3374,47 @@ struct HAPService {
      *   Please ensure that the "format" field of each structure is correct!
      */
     const HAPCharacteristic* _Nullable const* _Nullable characteristics;
+
+    /**
+     * Callbacks.
+     */
+    struct {
+        /**
+         * The callback used to handle all writes to characteristics of the service that are part of a single request.
+         *
+         * - If set, writes that are received over IP are collected per service and handed over together, so that they
+         *   can be applied atomically, e.g. setting On, Brightness, Hue and Saturation of a light bulb in one I/O.
+         *   The handleWrite callbacks of the individual characteristics are not invoked for these writes.
+         *
+         * - The handleWrite callbacks of the individual characteristics must still be provided.
+         *   They are used for Bluetooth LE, where each request writes a single characteristic.
+         *
+         * - The status of each write is reported to the controller individually.
+         *   If an error is returned, it is reported for all writes of the batch.
+         *
+         * - If event notifications are raised for the written characteristics while the callback is running,
+         *   the controller that sent the request is not notified, as for individual writes.
+         *
+         * @param      server               Accessory server.
+         * @param      request              Request.
+         * @param      writes               Writes of the request, in the order in which they were received.
+         * @param      numWrites            Number of writes.
+         * @param      context              The context parameter given to the HAPAccessoryServerCreate function.
+         *
+         * @return kHAPError_None           If the writes have been processed. Per-write errors are set in @p writes.
+         * @return kHAPError_Unknown        If unable to perform operation with requested service or characteristic.
+         * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
+         * @return kHAPError_OutOfResources If out of resources to process request.
+         * @return kHAPError_Busy           If the request failed temporarily.
+         */
+        HAP_RESULT_USE_CHECK
+        HAPError (*_Nullable handleBatchWrite)(
+                HAPAccessoryServerRef* server,
+                const HAPServiceRequest* request,
+                HAPCharacteristicBatchWrite* writes,
+                size_t numWrites,
+                void* _Nullable context);
+    } callbacks;
 };
 HAP_NONNULL_SUPPORT(HAPService)
 
@@ -3583,6 +3698,14 @@ typedef HAP_OPAQUE(64) HAPIPWriteContextRef;
  */
 typedef HAP_OPAQUE(832) HAPIPSessionDescriptorRef;
 
+/**
+ * IP session slot.
+ *
+ * - Holds the scheduling state of an IP session that is scanned periodically by the accessory server.
+ *   Slots are kept in a separate densely packed array so that these scans do not touch the session descriptors.
+ */
+typedef HAP_OPAQUE(32) HAPIPSessionSlotRef;
+
 /**
  * IP event notification.
  */
@@ -3603,6 +3726,21 @@ typedef HAP_OPAQUE(24) HAPIPEventNotificationRef;
  */
 #define kHAPIPSession_DefaultScratchBufferSize ((size_t) 32768)
 
+/**
+ * Recommended size for the inbound buffer of an IP session when a buffer pool is used.
+ */
+#define kHAPIPSession_PooledInboundBufferSize ((size_t) 4096)
+
+/**
+ * Recommended size for the outbound buffer of an IP session when a buffer pool is used.
+ */
+#define kHAPIPSession_PooledOutboundBufferSize ((size_t) 4096)
+
+/**
+ * Maximum number of blocks in an IP buffer pool.
+ */
+#define kHAPIPBufferPool_MaxBlocks ((size_t) 64)
+
 /**
  * IP session.
  *
@@ -3672,6 +3810,59 @@ typedef struct {
  */
 #define kHAPIPSessionStorage_DefaultNumElements ((size_t) 17)
 
+/**
+ * Maximum number of session chunks that an IP accessory server allocates in addition to the initial sessions.
+ */
+#define kHAPIPSessionStorage_MaxAdditionalChunks ((size_t) 7)
+
+/**
+ * Allocates a chunk of additional IP sessions.
+ *
+ * - Each session must be prepared in the same way as the sessions in HAPIPAccessoryServerStorage.
+ *   One session slot must be provided per session.
+ *
+ * - Memory must remain valid while the accessory server is initialized.
+ *   Allocated chunks are reused by the accessory server until it is released (see HAPIPSessionChunkReleaseCallback).
+ *
+ * @param      server               Accessory server.
+ * @param      numSessions          Number of sessions in the chunk.
+ * @param[out] sessions             Sessions. Must contain numSessions elements.
+ * @param[out] sessionSlots         Session slots. Must contain numSessions elements.
+ * @param[out] allocation           Optional pointer that is passed back to the release callback,
+ *                                  e.g., the allocation that backs the buffers of the sessions. NULL by default.
+ * @param      context              The context parameter given to the HAPIPAccessoryServerStorage structure.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If no more sessions can be allocated.
+ */
+typedef HAPError (*HAPIPSessionChunkAllocateCallback)(
+        HAPAccessoryServerRef* server,
+        size_t numSessions,
+        HAPIPSession* _Nullable* _Nonnull sessions,
+        HAPIPSessionSlotRef* _Nullable* _Nonnull sessionSlots,
+        void* _Nullable* _Nonnull allocation,
+        void* _Nullable context);
+
+/**
+ * Releases a chunk of additional IP sessions that has been allocated by a HAPIPSessionChunkAllocateCallback.
+ *
+ * - Called for every allocated chunk when the accessory server is released (see HAPAccessoryServerRelease).
+ *
+ * @param      server               Accessory server.
+ * @param      numSessions          Number of sessions in the chunk.
+ * @param      sessions             Sessions that have been returned by the allocator.
+ * @param      sessionSlots         Session slots that have been returned by the allocator.
+ * @param      allocation           Allocation pointer that has been returned by the allocator.
+ * @param      context              The context parameter given to the HAPIPAccessoryServerStorage structure.
+ */
+typedef void (*HAPIPSessionChunkReleaseCallback)(
+        HAPAccessoryServerRef* server,
+        size_t numSessions,
+        HAPIPSession* sessions,
+        HAPIPSessionSlotRef* sessionSlots,
+        void* _Nullable allocation,
+        void* _Nullable context);
+
 /**
  * IP server storage.
  *
@@ -3689,6 +3880,12 @@ typedef struct {
      *   Each session contains additional memory that needs to be allocated. See HAPIPSession.
      *
      * - At least eight elements are required for IP (Ethernet / Wi-Fi) accessories.
+     *
+     * - When all sessions are in use and a new connection is accepted, additional sessions are allocated
+     *   (see sessionChunks). If that is not possible, the idle session that is least recently used is closed,
+     *   preferring sessions that are not secured over sessions of controllers without admin permissions.
+     *   Sessions of admin controllers are never closed for this reason. To allow this, the TCP stream manager
+     *   should support one more concurrent TCP stream than the maximum number of sessions.
      */
     HAPIPSession* sessions;
 
@@ -3697,6 +3894,17 @@ typedef struct {
      */
     size_t numSessions;
 
+    /**
+     * IP session slots. Optional.
+     *
+     * - If provided, one slot must be provided per session, i.e. this array must contain numSessions elements.
+     *
+     * - If NULL, numSessions * sizeof(HAPIPSessionSlotRef) bytes (plus up to 7 bytes of alignment padding)
+     *   are taken from the beginning of the scratch buffer. Storage configurations from before session slots
+     *   were introduced keep working unchanged, but the scratch buffer available to requests shrinks accordingly.
+     */
+    HAPIPSessionSlotRef* _Nullable sessionSlots;
+
     /**
      * IP read contexts.
      *
@@ -3740,6 +3948,63 @@ typedef struct {
          */
         size_t numBytes;
     } scratchBuffer;
+
+    /**
+     * Buffer pool. Optional.
+     *
+     * - If a buffer pool is provided, the inbound and outbound buffers of each session may be sized for small requests
+     *   (see kHAPIPSession_PooledInboundBufferSize and kHAPIPSession_PooledOutboundBufferSize). A session borrows
+     *   a block from the buffer pool while it receives a request that exceeds its inbound buffer, and while it sends
+     *   a response to a /accessories or /characteristics request. The block is returned once the request completes.
+     *
+     * - If no block is available, the session continues to use its own buffers.
+     */
+    struct {
+        /**
+         * Buffer pool memory. Must contain numBlocks * numBytesPerBlock bytes, or NULL if no buffer pool is used.
+         * Memory must remain valid while the accessory server is initialized.
+         */
+        void* _Nullable bytes;
+
+        /**
+         * Size of each block.
+         *
+         * - It is recommended to use kHAPIPSession_DefaultInboundBufferSize bytes,
+         *   but the optimal size may vary depending on the accessory's attribute database.
+         */
+        size_t numBytesPerBlock;
+
+        /**
+         * Number of blocks. At most kHAPIPBufferPool_MaxBlocks blocks are supported.
+         */
+        size_t numBlocks;
+    } bufferPool;
+
+    /**
+     * Additional IP sessions. Optional.
+     *
+     * - If an allocator is provided, chunks of numSessions additional sessions are allocated when all sessions
+     *   are in use, up to kHAPIPSessionStorage_MaxAdditionalChunks chunks.
+     *
+     * - Additional sessions may use smaller inbound and outbound buffers than the initial sessions
+     *   if a buffer pool is provided (see bufferPool).
+     */
+    struct {
+        /**
+         * Allocates a chunk of additional sessions, or NULL if no additional sessions are allocated.
+         */
+        HAPIPSessionChunkAllocateCallback _Nullable allocate;
+
+        /**
+         * Releases a chunk of additional sessions, or NULL if allocated chunks do not need to be released.
+         */
+        HAPIPSessionChunkReleaseCallback _Nullable release;
+
+        /**
+         * Client context pointer. Will be passed to the allocator and to the release callback.
+         */
+        void* _Nullable context;
+    } sessionChunks;
 } HAPIPAccessoryServerStorage;
 HAP_NONNULL_SUPPORT(HAPIPAccessoryServerStorage)
 
@@ -3760,6 +4025,33 @@ HAP_NONNULL_SUPPORT(HAPIPAccessoryServerTransport)
  */
 typedef HAP_OPAQUE(56) HAPBLEGATTTableElementRef;
 
+/**
+ * Number of BLE attribute handle index elements per BLE GATT table element.
+ *
+ * - A HomeKit service occupies the service declaration and the Service Instance ID characteristic declaration and value.
+ *   A HomeKit characteristic occupies the characteristic declaration and value, the Client Characteristic
+ *   Configuration descriptor and the Characteristic Instance ID descriptor.
+ *
+ * - This is sufficient for BLE peripheral managers that assign consecutive attribute handles.
+ */
+#define kHAPBLEAttributeHandleIndex_NumElementsPerGATTTableElement ((size_t) 4)
+
+/**
+ * Recommended number of BLE signature buffer bytes per BLE GATT table element.
+ *
+ * - Sufficient for the signatures of HomeKit characteristics without long manufacturer descriptions
+ *   or large lists of valid values.
+ */
+#define kHAPBLESignatureBuffer_NumBytesPerGATTTableElement ((size_t) 96)
+
+/**
+ * Number of BLE GATT database attributes per BLE GATT table element.
+ *
+ * - A HomeKit service is published as the service and its Service Instance ID characteristic.
+ *   A HomeKit characteristic is published as the characteristic and its Characteristic Instance ID descriptor.
+ */
+#define kHAPBLEGATTDatabase_NumAttributesPerGATTTableElement ((size_t) 2)
+
 /**
  * Minimum number of BLE session cache elements in a HAPBLEAccessoryServerStorage.
  */
@@ -3771,7 +4063,7 @@ typedef HAP_OPAQUE(56) HAPBLEGATTTableElementRef;
  * - For accessories that support Bluetooth LE, at least kHAPBLESessionCache_MinElements
  *   of these elements must be allocated and provided as part of a HAPBLEAccessoryServerStorage structure.
  */
-typedef HAP_OPAQUE(48) HAPBLESessionCacheElementRef;
+typedef HAP_OPAQUE(56) HAPBLESessionCacheElementRef;
 
 /**
  * HAP-BLE procedure.
@@ -3804,6 +4096,77 @@ typedef struct {
      */
     size_t numGATTTableElements;
 
+    /**
+     * BLE attribute handle index. Optional.
+     *
+     * - If provided, GATT requests are resolved to their BLE GATT table element in constant time.
+     *   Otherwise, the BLE GATT table is searched on every GATT request.
+     *
+     * - kHAPBLEAttributeHandleIndex_NumElementsPerGATTTableElement elements per BLE GATT table element
+     *   are recommended. If the attribute handles do not fit, the BLE GATT table is searched instead.
+     */
+    uint16_t* _Nullable attributeHandleIndex;
+
+    /**
+     * Number of BLE attribute handle index elements.
+     */
+    size_t numAttributeHandleIndexElements;
+
+    /**
+     * BLE characteristic index. Optional.
+     *
+     * - If provided, raised events are resolved to the BLE GATT table element of their characteristic
+     *   in logarithmic time. Otherwise, the BLE GATT table is searched whenever an event is raised.
+     *
+     * - One element per BLE GATT table element is sufficient.
+     */
+    uint16_t* _Nullable characteristicIndex;
+
+    /**
+     * Number of BLE characteristic index elements.
+     */
+    size_t numCharacteristicIndexElements;
+
+    /**
+     * Buffer for precomputed HAP-BLE signature responses. Optional.
+     *
+     * - If provided, the HAP-Characteristic-Signature-Read-Response and HAP-Service-Signature-Read-Response
+     *   of each HomeKit characteristic and service are serialized once when the accessory server is started,
+     *   and signature read requests are answered from this buffer.
+     *
+     * - kHAPBLESignatureBuffer_NumBytesPerGATTTableElement bytes per BLE GATT table element are recommended.
+     *   Signatures that do not fit are serialized on every signature read request instead.
+     */
+    struct {
+        /**
+         * BLE signature buffer.
+         */
+        void* _Nullable bytes;
+
+        /**
+         * Size of BLE signature buffer.
+         */
+        size_t numBytes;
+    } signatureBuffer;
+
+    /**
+     * BLE GATT database attributes. Optional.
+     *
+     * - If provided, the GATT database is fingerprinted and published in a single call when the accessory server
+     *   is started. If the fingerprint is unchanged, the BLE peripheral manager may skip registration,
+     *   and the GATT database is kept while the accessory server is stopped.
+     *   Otherwise, the GATT database is rebuilt attribute by attribute on every start.
+     *
+     * - kHAPBLEGATTDatabase_NumAttributesPerGATTTableElement elements per BLE GATT table element are required.
+     *   If the GATT database does not fit, it is rebuilt attribute by attribute instead.
+     */
+    HAPPlatformBLEPeripheralManagerGATTAttribute* _Nullable gattDatabaseAttributes;
+
+    /**
+     * Number of BLE GATT database attributes.
+     */
+    size_t numGATTDatabaseAttributes;
+
     /**
      * BLE Pair Resume session cache. Storage must remain valid.
      *
@@ -3813,6 +4176,8 @@ typedef struct {
      * - The cache size determines how many different controllers can take advantage of this feature
      *   before they have to do a re-connection with regular speed again.
      *
+     * - Lookups are hashed, so the cost of a Pair Resume does not grow with the cache size.
+     *
      * - At least kHAPBLESessionCache_MinElements elements are required
      *   and must remain valid while the accessory server is initialized.
      */
@@ -3881,6 +4246,167 @@ extern const HAPBLEAccessoryServerTransport kHAPAccessoryServerTransport_BLE;
 HAP_NONNULL_SUPPORT(HAPBLEAccessoryServerTransport)
 /**@}*/
 
+/**
+ * Cached value of a characteristic.
+ */
+typedef HAP_OPAQUE(24) HAPCharacteristicCachedValueRef;
+
+/**
+ * Characteristic value cache entry.
+ *
+ * - While the cached value of a characteristic is valid, reads are served without invoking the read handler.
+ *   This applies to reads over all transports, including reads for event notifications and IP discovery.
+ *
+ * - Cached values are discarded when HAPAccessoryServerRaiseEvent or HAPAccessoryServerRaiseEventOnSession is
+ *   called for the characteristic, or when the characteristic is written successfully.
+ *
+ * - Only values of characteristics with format bool, uint8, uint16, uint32, uint64, int or float are cached.
+ *   Read handlers must not depend on the requesting controller.
+ */
+typedef struct {
+    /** The characteristic whose value is cached. Must be readable. */
+    const HAPCharacteristic* characteristic;
+
+    /** The accessory that provides the characteristic. */
+    const HAPAccessory* accessory;
+
+    /**
+     * Maximum age of a cached value.
+     *
+     * - If this is set to 0, a cached value remains valid until it is discarded.
+     */
+    HAPTime maxAge;
+
+    /** Cached value. Managed by the accessory server. */
+    HAPCharacteristicCachedValueRef cachedValue;
+} HAPCharacteristicValueCacheEntry;
+
+/**
+ * Characteristic value cache statistics.
+ */
+typedef struct {
+    /** Number of reads that have been served from the cache. */
+    uint64_t numHits;
+
+    /** Number of reads of cached characteristics that invoked the read handler. */
+    uint64_t numMisses;
+} HAPCharacteristicValueCacheStatistics;
+
+/**
+ * Number of buckets of a metrics latency histogram.
+ */
+#define kHAPMetricsHistogram_NumBuckets ((size_t) 8)
+
+/**
+ * Latency histogram with fixed buckets.
+ *
+ * Bucket upper bounds (exclusive): 1 ms, 2 ms, 5 ms, 10 ms, 20 ms, 50 ms, 100 ms, unbounded.
+ */
+typedef struct {
+    /** Number of samples per bucket. */
+    uint32_t buckets[kHAPMetricsHistogram_NumBuckets];
+
+    /** Total number of samples. */
+    uint32_t numSamples;
+
+    /** Sum of all sample durations. */
+    HAPTime totalDuration;
+
+    /** Longest sample duration. */
+    HAPTime maxDuration;
+} HAPMetricsHistogram;
+
+/**
+ * Accessory server performance metrics.
+ */
+typedef struct {
+    /**
+     * HAP over IP requests by endpoint.
+     */
+    struct {
+        uint32_t accessories;        /**< GET /accessories. */
+        uint32_t getCharacteristics; /**< GET /characteristics. */
+        uint32_t putCharacteristics; /**< PUT /characteristics. */
+        uint32_t prepare;            /**< PUT /prepare. */
+        uint32_t pairSetup;          /**< POST /pair-setup. */
+        uint32_t pairVerify;         /**< POST /pair-verify. */
+        uint32_t pairings;           /**< POST /pairings. */
+        uint32_t secureMessage;      /**< POST /secure-message. */
+        uint32_t identify;           /**< POST /identify. */
+        uint32_t resource;           /**< POST /resource. */
+        uint32_t other;              /**< Requests to unknown endpoints. */
+    } ipRequests;
+
+    /** Latency of characteristic read handlers. */
+    HAPMetricsHistogram readHandlerLatency;
+
+    /** Latency of characteristic write handlers, including service batch write handlers. */
+    HAPMetricsHistogram writeHandlerLatency;
+
+    /** Number of plaintext bytes that have been encrypted on HAP over IP sessions. */
+    uint64_t numEncryptedBytes;
+
+    /** Number of plaintext bytes that have been decrypted on HAP over IP sessions. */
+    uint64_t numDecryptedBytes;
+
+    /**
+     * HAP over IP event notifications.
+     */
+    struct {
+        /** Number of event notifications that have been sent. */
+        uint32_t numSent;
+
+        /** Number of events that have been merged into an already pending event notification. */
+        uint32_t numCoalesced;
+
+        /** Number of pending event notifications that have been discarded. */
+        uint32_t numDropped;
+    } eventNotifications;
+
+    /** Latency of Pair Setup processing per message. Index 0 corresponds to M1. */
+    HAPMetricsHistogram pairSetup[6];
+
+    /** Latency of Pair Verify processing per message. Index 0 corresponds to M1. */
+    HAPMetricsHistogram pairVerify[4];
+
+    /** Latency of key-value store operations that are issued while processing pairing requests. */
+    HAPMetricsHistogram keyValueStoreLatency;
+
+    /**
+     * HAP over IP sessions.
+     */
+    struct {
+        /** Number of accepted TCP connections. */
+        uint32_t numAccepted;
+
+        /** Number of TCP connections that have been rejected because no session was available. */
+        uint32_t numRejected;
+    } sessions;
+
+    /** Number of times that a HAP over IP inbound or outbound buffer was too small. */
+    uint32_t numBufferFullConditions;
+} HAPAccessoryServerMetrics;
+
+/**
+ * Callback that receives HAP over IP session traffic capture data.
+ *
+ * - The capture data must be appended to the capture in the order in which it is passed to the callback.
+ *   The resulting capture can be replayed with the CaptureReplay tool.
+ *
+ * - Captures contain decrypted requests and therefore sensitive data such as characteristic values.
+ *   Capturing must not be enabled in production accessories.
+ *
+ * @param      server               Accessory server.
+ * @param      bytes                Capture data.
+ * @param      numBytes             Length of capture data.
+ * @param      context              The context parameter given to the HAPAccessoryServerCreate function.
+ */
+typedef void (*HAPIPCaptureCallback)(
+        HAPAccessoryServerRef* server,
+        const void* bytes,
+        size_t numBytes,
+        void* _Nullable context);
+
 /**
  * Accessory server initialization options.
  */
@@ -3917,6 +4443,19 @@ typedef struct {
          * IP accessory server storage. Storage must remain valid.
          */
         HAPIPAccessoryServerStorage* _Nullable accessoryServerStorage;
+
+        /**
+         * Session traffic capture. Optional.
+         *
+         * - If a callback is set, decrypted requests of HAP over IP sessions are recorded together with their
+         *   timing and passed to the callback.
+         */
+        struct {
+            /**
+             * Callback that receives the capture data. NULL to disable capturing.
+             */
+            HAPIPCaptureCallback _Nullable callback;
+        } capture;
     } ip;
 
     /**
@@ -3987,6 +4526,30 @@ typedef struct {
          */
         HAPBLEAdvertisingInterval preferredNotificationDuration;
     } ble;
+
+    /**
+     * Characteristic value cache. Optional.
+     *
+     * - Characteristics that are not listed are always read through their read handlers.
+     */
+    struct {
+        /**
+         * Cache entries. Storage must remain valid.
+         *
+         * - Entries are reordered by the accessory server. Each characteristic may only be listed once.
+         */
+        HAPCharacteristicValueCacheEntry* _Nullable entries;
+
+        /** Number of cache entries. */
+        size_t numEntries;
+    } characteristicValueCache;
+
+    /**
+     * Performance metrics storage. Optional. Storage must remain valid.
+     *
+     * - If this is set to NULL, no metrics are recorded.
+     */
+    HAPAccessoryServerMetrics* _Nullable metrics;
 } HAPAccessoryServerOptions;
 
 /**
@@ -4319,6 +4882,66 @@ void HAPAccessoryServerRaiseEventOnSession(
         const HAPAccessory* accessory,
         HAPSessionRef* session);
 
+/**
+ * Completes a characteristic read or write request whose handler returned kHAPError_InProgress.
+ *
+ * - Read and write handlers must not block. If a value cannot be provided or applied right away, the handler may
+ *   return kHAPError_InProgress instead and complete the request later through this function.
+ *
+ * - The characteristic, service, accessory and session of the request passed to the handler identify the request.
+ *
+ * - For write requests, @p error is reported as the result of the write.
+ *
+ * - For read requests, @p error is reported as the result of the read if it is not kHAPError_None.
+ *   Otherwise, the handleRead callback is invoked again and must now provide the value synchronously.
+ *
+ * - HAP over IP: The HTTP transaction of the session is held open until all deferred requests of the transaction
+ *   have been completed. Other sessions continue to be served meanwhile. Requests can only be deferred for
+ *   transactions with a small number of characteristics, and not while serializing event notifications or the
+ *   accessory attribute database. In these cases, the request fails as if kHAPError_Busy had been returned.
+ *   A request may also be completed from within its handler, before the handler returns kHAPError_InProgress.
+ *   The response is then sent once control has returned to the run loop.
+ *
+ * - HAP over Bluetooth LE: Requests cannot be deferred, because the HAP-BLE response is read right after the
+ *   request has been written. The request fails as if kHAPError_Busy had been returned.
+ *
+ * - Completions of requests that are no longer pending, e.g., because the session has been closed, are ignored.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristic       The characteristic of the request.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ * @param      session              The session on which the request has been received.
+ * @param      error                Result of the request. Must not be kHAPError_InProgress.
+ */
+void HAPAccessoryServerCompleteRequest(
+        HAPAccessoryServerRef* server,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service,
+        const HAPAccessory* accessory,
+        HAPSessionRef* session,
+        HAPError error);
+
+/**
+ * Gets the statistics of the characteristic value cache.
+ *
+ * @param      server               Accessory server.
+ * @param[out] statistics           Characteristic value cache statistics.
+ */
+void HAPAccessoryServerGetCharacteristicValueCacheStatistics(
+        const HAPAccessoryServerRef* server,
+        HAPCharacteristicValueCacheStatistics* statistics);
+
+/**
+ * Gets the performance metrics of an accessory server.
+ *
+ * - If no metrics storage has been provided in HAPAccessoryServerCreate, all metrics are reported as zero.
+ *
+ * @param      server               Accessory server.
+ * @param[out] metrics              Performance metrics.
+ */
+void HAPAccessoryServerGetMetrics(const HAPAccessoryServerRef* server, HAPAccessoryServerMetrics* metrics);
+
 /**
  * Restores the given key-value store to factory settings.
  *
@@ -97,11 +97,7 @@ HAPError HAPAccessoryGetInfoResponse(
         } break;
         case kHAPTransportType_BLE: {
             HAPBLEAccessoryServerGSN gsn;
-            err = HAPNonnull(server->transports.ble)->getGSN(server->platform.keyValueStore, &gsn);
-            if (err) {
-                HAPAssert(err == kHAPError_Unknown);
-                return err;
-            }
+            HAPNonnull(server->transports.ble)->getGSN(server_, &gsn);
             sn = gsn.gsn;
         } break;
     }
@@ -230,7 +226,7 @@ HAPError HAPAccessoryGetInfoResponse(
 
         // Get setup hash.
         HAPAccessorySetupSetupHash setupHash;
-        HAPAccessorySetupGetSetupHash(&setupHash, &setupID, &deviceIDString);
+        HAPAccessorySetupInfoGetSetupHash(server_, &setupHash, &setupID, &deviceIDString);
 
         // Append TLV.
         err = HAPTLVWriterAppend(
@@ -58,6 +58,24 @@ typedef struct {
     /** Maximum number of allowed pairings. */
     HAPPlatformKeyValueStoreKey maxPairings;
 
+    /** Characteristic value cache. */
+    struct {
+        /** Cache entries. */
+        HAPCharacteristicValueCacheEntry* _Nullable entries;
+
+        /** Number of cache entries. */
+        size_t numEntries;
+
+        /** Number of reads that have been served from the cache. */
+        uint64_t numHits;
+
+        /** Number of reads of cached characteristics that invoked the read handler. */
+        uint64_t numMisses;
+    } characteristicValueCache;
+
+    /** Performance metrics storage. NULL if metrics are disabled. */
+    HAPAccessoryServerMetrics* _Nullable metrics;
+
     /** Accessory to serve. */
     const HAPAccessory* _Nullable primaryAccessory;
 
@@ -107,6 +125,23 @@ typedef struct {
             /** Whether setup info should be kept across pairing attempts. */
             bool keepSetupInfo : 1;
         } state;
+
+        /**
+         * Setup hash of the most recently used setup ID and Device ID.
+         */
+        struct {
+            /** Setup ID from which the setup hash was derived. */
+            HAPSetupID setupID;
+
+            /** Device ID from which the setup hash was derived. */
+            HAPDeviceIDString deviceIDString;
+
+            /** Setup hash. */
+            HAPAccessorySetupSetupHash setupHash;
+
+            /** Whether the setup hash has been derived. */
+            bool isAvailable : 1;
+        } setupHash;
     } accessorySetup;
 
     /**
@@ -141,6 +176,26 @@ typedef struct {
         bool keepSetupInfo : 1; /**< Whether setup info should be kept on disconnect. */
     } pairSetup;
 
+    /**
+     * Service batch write that is being collected.
+     *
+     * - While a service is set, characteristic writes to that service are appended to the batch
+     *   instead of invoking the characteristic's write handler.
+     */
+    struct {
+        /** Service whose writes are being collected. NULL if no batch write is being collected. */
+        const HAPService* _Nullable service;
+
+        /** Collected writes. */
+        HAPCharacteristicBatchWrite* _Nullable writes;
+
+        /** Number of collected writes. */
+        size_t numWrites;
+
+        /** Capacity of the writes buffer. */
+        size_t maxWrites;
+    } batchWrite;
+
     /**
      * IP specific attributes.
      */
@@ -148,6 +203,18 @@ typedef struct {
         /** Storage. */
         HAPIPAccessoryServerStorage* _Nullable storage;
 
+        /**
+         * Scratch buffer. Part of storage->scratchBuffer that is not used for session slots
+         * (if session slots are not provided by the IP server storage).
+         */
+        struct {
+            /** Scratch buffer. */
+            void* _Nullable bytes;
+
+            /** Size of scratch buffer. */
+            size_t numBytes;
+        } scratchBuffer;
+
         /** NULL-terminated array of bridged accessories for a bridge accessory. NULL otherwise. */
         const HAPAccessory* _Nullable const* _Nullable bridgedAccessories;
 
@@ -163,6 +230,27 @@ typedef struct {
         /** The number of active sessions served by the accessory server. */
         size_t numSessions;
 
+        /**
+         * Session chunks. The first chunk contains the sessions of the IP server storage,
+         * further chunks are allocated on demand. Each chunk contains storage->numSessions sessions.
+         */
+        struct {
+            /** Sessions. */
+            HAPIPSession* _Nullable sessions;
+
+            /** Session slots. */
+            HAPIPSessionSlotRef* _Nullable sessionSlots;
+
+            /** Allocation pointer that has been returned by the allocator. */
+            void* _Nullable allocation;
+        } sessionChunks[1 + kHAPIPSessionStorage_MaxAdditionalChunks];
+
+        /** The number of session chunks. */
+        size_t numSessionChunks;
+
+        /** Bit mask of buffer pool blocks that are currently borrowed by sessions. */
+        uint64_t bufferPoolBlocksInUse;
+
         /**
          * Characteristic write request context.
          */
@@ -192,8 +280,62 @@ typedef struct {
         /** Timer that on expiry schedules a maximum idle time check. */
         HAPPlatformTimerRef maxIdleTimeTimer;
 
+        /** Timer that on expiry reports deferred requests that have not been completed in time as busy. */
+        HAPPlatformTimerRef deferredRequestTimer;
+
+        /** HTTP transactions of sessions that wait for deferred requests. */
+        HAPIPDeferredTransaction deferredTransactions[kHAPIPAccessoryServer_MaxDeferredTransactions];
+
+        /**
+         * Completions of deferred requests that are reported while the HTTP transaction that defers them is still
+         * being processed, i.e., before the session is waiting for them.
+         */
+        struct {
+            /** The session whose HTTP transaction is being processed. NULL if no transaction is being processed. */
+            const HAPIPSessionDescriptor* _Nullable session;
+
+            /** Completed requests. */
+            struct {
+                /** Accessory instance ID. */
+                uint64_t aid;
+
+                /** Characteristic instance ID. */
+                uint64_t iid;
+
+                /** Result reported by the application. */
+                HAPError error;
+            } requests[kHAPIPSession_MaxDeferredRequests];
+
+            /** Number of completed requests. */
+            size_t numRequests;
+        } earlyCompletions;
+
         /** Currently registered Bonjour service. */
         HAPIPServiceDiscoveryType discoverableService;
+
+        /**
+         * SHA-256 digest of the TXT records of the currently registered Bonjour service.
+         *
+         * - TXT records are only updated if their digest changes.
+         */
+        uint8_t txtRecordsDigest[SHA256_BYTES];
+
+        /**
+         * Session traffic capture.
+         */
+        struct {
+            /** Callback that receives the capture data. NULL if capturing is disabled. */
+            HAPIPCaptureCallback _Nullable callback;
+
+            /** Time at which the last capture record has been created. */
+            HAPTime lastRecordTime;
+
+            /** Capture session ID that has been assigned last. */
+            uint16_t lastSessionID;
+
+            /** Whether or not the capture header has been emitted. */
+            bool isHeaderEmitted;
+        } capture;
     } ip;
 
     /**
@@ -207,6 +349,116 @@ typedef struct {
          */
         HAPBLEAccessoryServerStorage* _Nullable storage;
 
+        /**
+         * Attribute handle index.
+         *
+         * - Element i of the storage's attribute handle index holds the 1-based BLE GATT table element index
+         *   of attribute handle firstHandle + i, or 0 if the attribute handle is not linked to an element.
+         *
+         * - If numHandles is 0, the index is not in use and the BLE GATT table is searched instead.
+         */
+        struct {
+            /** First indexed attribute handle. */
+            HAPPlatformBLEPeripheralManagerAttributeHandle firstHandle;
+
+            /** Number of indexed attribute handles. */
+            size_t numHandles;
+        } attributeHandleIndex;
+
+        /**
+         * Characteristic index.
+         *
+         * - The storage's characteristic index holds the BLE GATT table element indices
+         *   of the numElements HomeKit characteristics, sorted by instance ID.
+         *
+         * - If numElements is 0, the BLE GATT table is searched instead.
+         */
+        struct {
+            /** Number of indexed characteristics. */
+            size_t numElements;
+        } characteristicIndex;
+
+        /**
+         * Signature cache.
+         *
+         * - The storage's signature buffer starts with numEntries index entries sorted by instance ID,
+         *   followed by the serialized signature responses that they refer to.
+         *
+         * - If numEntries is 0, signatures are serialized on every signature read request.
+         */
+        struct {
+            /** Number of cached signatures. */
+            size_t numEntries;
+        } signatureCache;
+
+        /**
+         * GATT database.
+         */
+        struct {
+            /**
+             * Whether or not the GATT database was published in a single call.
+             *
+             * - If set, the GATT database is kept while the accessory server is stopped,
+             *   so that it does not need to be rebuilt when the accessory server is started again.
+             */
+            bool isRetained;
+        } gattDatabase;
+
+        /**
+         * GSN state.
+         *
+         * - Loaded from the key-value store when the accessory server starts.
+         *
+         * - The key-value store holds the current GSN or a GSN that is up to numReservedIncrements increments ahead.
+         */
+        struct {
+            /** Current GSN state. */
+            HAPBLEAccessoryServerGSN current;
+
+            /** Number of remaining GSN increments that are covered by the GSN in the key-value store. */
+            uint16_t numReservedIncrements;
+
+            /** Whether the key-value store holds the current GSN state. */
+            bool isSaved : 1;
+        } gsn;
+
+        /**
+         * Broadcast parameters.
+         *
+         * - Loaded from the key-value store when the accessory server starts and updated whenever they are stored.
+         */
+        HAPBLEAccessoryServerBroadcastParameters broadcastParameters;
+
+        /**
+         * Broadcast configuration of the characteristics.
+         *
+         * - Loaded from the key-value store when the accessory server starts and updated whenever it is stored.
+         */
+        struct {
+            /** Characteristic configuration in key-value store format. */
+            uint8_t bytes[kHAPBLECharacteristic_BroadcastConfigurationBufferSize];
+
+            /** Length of the characteristic configuration. */
+            size_t numBytes;
+
+            /** Key-value store key of the characteristic configuration. */
+            HAPPlatformKeyValueStoreKey key;
+        } broadcastConfiguration;
+
+        /**
+         * Queue of GATT table elements with pending events, in the order in which the events were raised.
+         *
+         * - Elements are identified by their 1-based GATT table index and linked through their connection state.
+         *   0 if the queue is empty.
+         */
+        struct {
+            /** First element of the queue. */
+            uint16_t first;
+
+            /** Last element of the queue. */
+            uint16_t last;
+        } pendingEvents;
+
         /**
          * Connection information.
          */
@@ -235,8 +487,24 @@ typedef struct {
             bool procedureAttached : 1;
         } connection;
 
-        /** Timestamp for Least Recently Used scheme in Pair Resume session cache. */
-        uint32_t sessionCacheTimestamp;
+        /**
+         * Pair Resume session cache state. Must be reset whenever the session cache elements are reset.
+         *
+         * - Entries are referenced by their index + 1. 0 indicates no entry.
+         */
+        struct {
+            /** Most recently used entry. */
+            uint16_t lruHead;
+
+            /** Least recently used entry. */
+            uint16_t lruTail;
+
+            /** First entry of the free list. */
+            uint16_t freeHead;
+
+            /** Number of entries that have been used at least once. */
+            uint16_t numUsedElements;
+        } sessionCache;
 
         /**
          * Advertisement state.
@@ -255,6 +523,34 @@ typedef struct {
 
             bool connected : 1; /**< Whether a controller is connected. */
 
+            /**
+             * Advertisement that was most recently passed to the BLE peripheral manager.
+             *
+             * - The BLE peripheral manager is only updated if the advertisement changes.
+             */
+            struct {
+                /** Advertising interval. */
+                HAPBLEAdvertisingInterval advertisingInterval;
+
+                /** Advertising data. */
+                uint8_t advertisingBytes[/* Maximum Bluetooth 4 limit: */ 31];
+
+                /** Length of advertising data. */
+                uint8_t numAdvertisingBytes;
+
+                /** Scan response data. */
+                uint8_t scanResponseBytes[/* Maximum Bluetooth 4 limit: */ 31];
+
+                /** Length of scan response data. */
+                uint8_t numScanResponseBytes;
+
+                /** Whether advertising has been started or stopped. False if the state is unknown. */
+                bool isPublished : 1;
+
+                /** Whether advertising has been started. */
+                bool isActive : 1;
+            } published;
+
             /**
              * Broadcasted Events.
              *
@@ -83,7 +83,7 @@ HAPError HAPHandleFirmwareUpdate(HAPAccessoryServerRef* server_) {
     // See HomeKit Accessory Protocol Specification R14
     // Section 7.4.7.4 Broadcast Encryption Key expiration and refresh
     if (server->transports.ble) {
-        err = HAPNonnull(server->transports.ble)->broadcast.expireKey(keyValueStore);
+        err = HAPNonnull(server->transports.ble)->broadcast.expireKey(server_);
         if (err) {
             HAPAssert(err == kHAPError_Unknown);
             return err;
@@ -148,6 +148,9 @@ void HAPAccessoryServerCreate(
     // Copy generic options.
     HAPPrecondition(options->maxPairings >= kHAPPairingStorage_MinElements);
     server->maxPairings = options->maxPairings;
+    HAPCharacteristicValueCacheCreate(
+            server_, options->characteristicValueCache.entries, options->characteristicValueCache.numEntries);
+    HAPMetricsCreate(server_, options->metrics);
 
     // Copy platform.
     HAPAssert(sizeof *platform == sizeof server->platform);
@@ -1024,6 +1027,7 @@ HAPError HAPAccessoryServerCleanupPairings(HAPAccessoryServerRef* server_) {
             HAPRawBufferZero(
                     server->ble.storage->sessionCacheElements,
                     server->ble.storage->numSessionCacheElements * sizeof *server->ble.storage->sessionCacheElements);
+            HAPRawBufferZero(&server->ble.sessionCache, sizeof server->ble.sessionCache);
         }
 
         // Purge broadcast encryption key and advertising identifier.
@@ -1037,6 +1041,9 @@ HAPError HAPAccessoryServerCleanupPairings(HAPAccessoryServerRef* server_) {
             HAPAssert(err == kHAPError_Unknown);
             return err;
         }
+        if (server->transports.ble) {
+            HAPRawBufferZero(&server->ble.broadcastParameters, sizeof server->ble.broadcastParameters);
+        }
     }
 
     return kHAPError_None;
@@ -1173,6 +1180,8 @@ void HAPAccessoryServerRaiseEvent(
 
     HAPLogCharacteristicDebug(&logObject, characteristic, service, accessory, "Marking characteristic as modified.");
 
+    HAPCharacteristicValueCacheInvalidate(server_, characteristic, accessory);
+
     if (server->transports.ble) {
         err = HAPNonnull(server->transports.ble)->didRaiseEvent(server_, characteristic, service, accessory, NULL);
         if (err) {
@@ -1208,6 +1217,8 @@ void HAPAccessoryServerRaiseEventOnSession(
 
     HAPError err;
 
+    HAPCharacteristicValueCacheInvalidate(server_, characteristic, accessory);
+
     if (server->transports.ble) {
         err = HAPNonnull(server->transports.ble)->didRaiseEvent(server_, characteristic, service, accessory, session);
         if (err) {
@@ -1228,6 +1239,43 @@ void HAPAccessoryServerRaiseEventOnSession(
     }
 }
 
+void HAPAccessoryServerCompleteRequest(
+        HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service,
+        const HAPAccessory* accessory,
+        HAPSessionRef* session_,
+        HAPError error) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(characteristic);
+    HAPPrecondition(service);
+    HAPPrecondition(accessory);
+    HAPPrecondition(session_);
+    HAPSession* session = (HAPSession*) session_;
+    HAPPrecondition(error != kHAPError_InProgress);
+
+    // Discard value that may have been cached while the request was pending.
+    HAPCharacteristicValueCacheInvalidate(server_, characteristic, accessory);
+
+    switch (session->transportType) {
+        case kHAPTransportType_IP: {
+            if (server->transports.ip) {
+                const HAPAccessoryServerServerEngine* _Nullable serverEngine =
+                        HAPNonnull(server->transports.ip)->serverEngine.get();
+                if (serverEngine && serverEngine->complete_request) {
+                    serverEngine->complete_request(server_, characteristic, service, accessory, session_, error);
+                }
+            }
+        } break;
+        case kHAPTransportType_BLE: {
+            // Requests are never deferred over Bluetooth LE.
+            HAPLogCharacteristicInfo(
+                    &logObject, characteristic, service, accessory, "Ignoring completion: Request is not pending.");
+        } break;
+    }
+}
+
 void HAPAccessoryServerHandleSubscribe(
         HAPAccessoryServerRef* server,
         HAPSessionRef* session_,
@@ -1681,17 +1729,21 @@ void HAPAccessoryServerEnumerateConnectedSessions(
     }
 
     if (server->transports.ip && server->ip.storage) {
-        for (size_t i = 0; shouldContinue && i < server->ip.storage->numSessions; i++) {
-            HAPIPSession* ipSession = &server->ip.storage->sessions[i];
-            HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-            if (!session->server) {
-                continue;
-            }
-            HAPAssert(session->server == server_);
-            if (session->securitySession.type != kHAPIPSecuritySessionType_HAP) {
-                continue;
+        for (size_t j = 0; shouldContinue && j < server->ip.numSessionChunks; j++) {
+            HAPIPSession* sessions = HAPNonnull(server->ip.sessionChunks[j].sessions);
+            const HAPIPSessionSlotRef* sessionSlots = HAPNonnull(server->ip.sessionChunks[j].sessionSlots);
+            for (size_t i = 0; shouldContinue && i < server->ip.storage->numSessions; i++) {
+                const HAPIPSessionSlot* slot = (const HAPIPSessionSlot*) &sessionSlots[i];
+                if (!slot->isActive) {
+                    continue;
+                }
+                HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &sessions[i].descriptor;
+                HAPAssert(session->server == server_);
+                if (session->securitySession.type != kHAPIPSecuritySessionType_HAP) {
+                    continue;
+                }
+                callback(context, server_, &session->securitySession._.hap, &shouldContinue);
             }
-            callback(context, server_, &session->securitySession._.hap, &shouldContinue);
         }
         if (!shouldContinue) {
             return;
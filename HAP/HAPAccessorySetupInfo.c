@@ -338,6 +338,30 @@ HAPSetupInfo* _Nullable HAPAccessorySetupInfoGetSetupInfo(HAPAccessoryServerRef*
 
 //----------------------------------------------------------------------------------------------------------------------
 
+void HAPAccessorySetupInfoGetSetupHash(
+        HAPAccessoryServerRef* server_,
+        HAPAccessorySetupSetupHash* setupHash,
+        const HAPSetupID* setupID,
+        const HAPDeviceIDString* deviceIDString) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(setupHash);
+    HAPPrecondition(setupID);
+    HAPPrecondition(deviceIDString);
+
+    if (!server->accessorySetup.setupHash.isAvailable ||
+        !HAPRawBufferAreEqual(&server->accessorySetup.setupHash.setupID, setupID, sizeof *setupID) ||
+        !HAPRawBufferAreEqual(
+                &server->accessorySetup.setupHash.deviceIDString, deviceIDString, sizeof *deviceIDString)) {
+        HAPAccessorySetupGetSetupHash(&server->accessorySetup.setupHash.setupHash, setupID, deviceIDString);
+        HAPRawBufferCopyBytes(&server->accessorySetup.setupHash.setupID, setupID, sizeof *setupID);
+        HAPRawBufferCopyBytes(
+                &server->accessorySetup.setupHash.deviceIDString, deviceIDString, sizeof *deviceIDString);
+        server->accessorySetup.setupHash.isAvailable = true;
+    }
+    HAPRawBufferCopyBytes(setupHash, &server->accessorySetup.setupHash.setupHash, sizeof *setupHash);
+}
+
 void HAPAccessorySetupInfoHandleAccessoryServerStart(HAPAccessoryServerRef* server_) {
     HAPPrecondition(server_);
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
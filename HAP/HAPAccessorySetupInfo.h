@@ -37,6 +37,22 @@ extern "C" {
  */
 HAPSetupInfo* _Nullable HAPAccessorySetupInfoGetSetupInfo(HAPAccessoryServerRef* server, bool restorePrevious);
 
+/**
+ * Derives the setup hash for a given setup ID and Device ID.
+ *
+ * - The setup hash is only derived again if the setup ID or Device ID differ from the previous call.
+ *
+ * @param      server               Accessory server.
+ * @param[out] setupHash            Setup hash.
+ * @param      setupID              Setup ID.
+ * @param      deviceIDString       Device ID.
+ */
+void HAPAccessorySetupInfoGetSetupHash(
+        HAPAccessoryServerRef* server,
+        HAPAccessorySetupSetupHash* setupHash,
+        const HAPSetupID* setupID,
+        const HAPDeviceIDString* deviceIDString);
+
 /**
  * Handles accessory server start.
  *
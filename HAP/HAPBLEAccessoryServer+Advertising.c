@@ -8,18 +8,80 @@
 
 static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .category = "BLEAccessoryServer" };
 
+/**
+ * Flag in the stored GSN state indicating that the stored GSN is a reserved GSN that is ahead of the current GSN.
+ */
+#define kHAPBLEAccessoryServerGSN_IsReserved ((uint8_t) 0x02)
+
+/**
+ * Advances a GSN by a number of increments.
+ *
+ * - The GSN wraps around to 1 after overflowing its maximum value.
+ *
+ * @param      gsn                  GSN.
+ * @param      numIncrements        Number of increments.
+ *
+ * @return Advanced GSN.
+ */
 HAP_RESULT_USE_CHECK
-HAPError HAPBLEAccessoryServerGetGSN(HAPPlatformKeyValueStoreRef keyValueStore, HAPBLEAccessoryServerGSN* gsn) {
+static uint16_t AdvanceGSN(uint16_t gsn, uint16_t numIncrements) {
+    HAPPrecondition(gsn);
+
+    uint32_t value = (uint32_t) gsn + numIncrements;
+    if (value > UINT16_MAX) {
+        value -= UINT16_MAX;
+    }
+    HAPAssert(value && value <= UINT16_MAX);
+    return (uint16_t) value;
+}
+
+/**
+ * Stores GSN state.
+ *
+ * @param      keyValueStore        Key-value store.
+ * @param      gsn                  GSN state.
+ * @param      isReserved           Whether the GSN is a reserved GSN that is ahead of the current GSN.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If an I/O error occurred.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError
+        StoreGSN(HAPPlatformKeyValueStoreRef keyValueStore, const HAPBLEAccessoryServerGSN* gsn, bool isReserved) {
     HAPPrecondition(keyValueStore);
     HAPPrecondition(gsn);
 
     HAPError err;
 
+    uint8_t gsnBytes[] = { HAPExpandLittleUInt16(gsn->gsn),
+                           (uint8_t)((gsn->didIncrement ? 0x01U : 0x00U) |
+                                     (isReserved ? kHAPBLEAccessoryServerGSN_IsReserved : 0x00U)) };
+    err = HAPPlatformKeyValueStoreSet(
+            keyValueStore,
+            kHAPKeyValueStoreDomain_Configuration,
+            kHAPKeyValueStoreKey_Configuration_BLEGSN,
+            gsnBytes,
+            sizeof gsnBytes);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        return err;
+    }
+
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPBLEAccessoryServerLoadGSN(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    HAPError err;
+
     bool found;
     size_t numBytes;
     uint8_t gsnBytes[sizeof(uint16_t) + sizeof(uint8_t)];
     err = HAPPlatformKeyValueStoreGet(
-            keyValueStore,
+            server->platform.keyValueStore,
             kHAPKeyValueStoreDomain_Configuration,
             kHAPKeyValueStoreKey_Configuration_BLEGSN,
             gsnBytes,
@@ -38,12 +100,74 @@ HAPError HAPBLEAccessoryServerGetGSN(HAPPlatformKeyValueStoreRef keyValueStore,
         return kHAPError_Unknown;
     }
 
-    HAPRawBufferZero(gsn, sizeof *gsn);
-    gsn->gsn = HAPReadLittleUInt16(&gsnBytes[0]);
-    gsn->didIncrement = (gsnBytes[2] & 0x01u) == 0x01;
+    HAPRawBufferZero(&server->ble.gsn, sizeof server->ble.gsn);
+    server->ble.gsn.current.gsn = HAPReadLittleUInt16(&gsnBytes[0]);
+    if (!server->ble.gsn.current.gsn) {
+        HAPLog(&logObject, "Invalid GSN 0.");
+        return kHAPError_Unknown;
+    }
+    bool isReserved = (gsnBytes[2] & kHAPBLEAccessoryServerGSN_IsReserved) == kHAPBLEAccessoryServerGSN_IsReserved;
+    server->ble.gsn.isSaved = !isReserved;
+
+    // GSN updates are only coalesced within a connect / disconnect cycle while the accessory server is running.
+    // After a restart, the next characteristic change increments the GSN again.
+    server->ble.gsn.current.didIncrement = false;
+
+    if (isReserved) {
+        // The accessory server has not been stopped properly and continues with the reserved GSN.
+        // The broadcast encryption key is expired when the GSN is incremented past the key expiration GSN.
+        // If the key expiration GSN is within the skipped range of GSN values, the key is expired now.
+        // See HomeKit Accessory Protocol Specification R14
+        // Section 7.4.7.4 Broadcast Encryption Key expiration and refresh
+        HAPLogInfo(&logObject, "Continuing with reserved GSN: %u.", server->ble.gsn.current.gsn);
+        uint16_t keyExpirationGSN = server->ble.broadcastParameters.keyExpirationGSN;
+        if (keyExpirationGSN) {
+            for (uint16_t i = 1; i <= kHAPBLEAccessoryServer_NumReservedGSNIncrements; i++) {
+                if (AdvanceGSN(keyExpirationGSN, i) == server->ble.gsn.current.gsn) {
+                    err = HAPBLEAccessoryServerBroadcastExpireKey(server_);
+                    if (err) {
+                        HAPAssert(err == kHAPError_Unknown);
+                        return err;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPBLEAccessoryServerSaveGSN(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    HAPError err;
+
+    if (server->ble.gsn.isSaved) {
+        return kHAPError_None;
+    }
+
+    err = StoreGSN(server->platform.keyValueStore, &server->ble.gsn.current, /* isReserved: */ false);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        return err;
+    }
+    server->ble.gsn.numReservedIncrements = 0;
+    server->ble.gsn.isSaved = true;
+
     return kHAPError_None;
 }
 
+void HAPBLEAccessoryServerGetGSN(const HAPAccessoryServerRef* server_, HAPBLEAccessoryServerGSN* gsn) {
+    HAPPrecondition(server_);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) server_;
+    HAPPrecondition(gsn);
+
+    HAPRawBufferCopyBytes(gsn, &server->ble.gsn.current, sizeof *gsn);
+}
+
 HAP_RESULT_USE_CHECK
 HAPError HAPBLEAccessoryServerGetAdvertisingParameters(
         HAPAccessoryServerRef* server_,
@@ -90,8 +214,7 @@ HAPError HAPBLEAccessoryServerGetAdvertisingParameters(
         uint16_t keyExpirationGSN;
         HAPBLEAccessoryServerBroadcastEncryptionKey broadcastKey;
         HAPDeviceID advertisingID;
-        err = HAPBLEAccessoryServerBroadcastGetParameters(
-                server->platform.keyValueStore, &keyExpirationGSN, &broadcastKey, &advertisingID);
+        err = HAPBLEAccessoryServerBroadcastGetParameters(server_, &keyExpirationGSN, &broadcastKey, &advertisingID);
         if (err) {
             HAPAssert(err == kHAPError_Unknown);
             return err;
@@ -101,11 +224,7 @@ HAPError HAPBLEAccessoryServerGetAdvertisingParameters(
             return kHAPError_Unknown;
         }
         HAPBLEAccessoryServerGSN gsn;
-        err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-        if (err) {
-            HAPAssert(err == kHAPError_Unknown);
-            return err;
-        }
+        HAPBLEAccessoryServerGetGSN(server_, &gsn);
 
         // Interval.
         *advertisingInterval = 0;
@@ -299,11 +418,7 @@ HAPError HAPBLEAccessoryServerGetAdvertisingParameters(
         adv += 2;
         /* 0x0F   GSN */ {
             HAPBLEAccessoryServerGSN gsn;
-            err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-            if (err) {
-                HAPAssert(err == kHAPError_Unknown);
-                return err;
-            }
+            HAPBLEAccessoryServerGetGSN(server_, &gsn);
             HAPWriteLittleUInt16(adv, gsn.gsn);
             adv += 2;
         }
@@ -329,7 +444,7 @@ HAPError HAPBLEAccessoryServerGetAdvertisingParameters(
 
                 // Get setup hash.
                 HAPAccessorySetupSetupHash setupHash;
-                HAPAccessorySetupGetSetupHash(&setupHash, &setupID, &deviceIDString);
+                HAPAccessorySetupInfoGetSetupHash(server_, &setupHash, &setupID, &deviceIDString);
 
                 // Append.
                 HAPAssert(sizeof setupHash.bytes == 4);
@@ -522,8 +637,6 @@ HAPError HAPBLEAccessoryServerDidConnect(HAPAccessoryServerRef* server_) {
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
     HAPPrecondition(!server->ble.adv.connected);
 
-    HAPError err;
-
     server->ble.adv.connected = true;
 
     // Stop fast advertisement timer.
@@ -544,24 +657,7 @@ HAPError HAPBLEAccessoryServerDidConnect(HAPAccessoryServerRef* server_) {
     }
 
     // Reset disconnected events coalescing.
-    HAPBLEAccessoryServerGSN gsn;
-    err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
-    gsn.didIncrement = false;
-    uint8_t gsnBytes[] = { HAPExpandLittleUInt16(gsn.gsn), gsn.didIncrement ? (uint8_t) 0x01 : (uint8_t) 0x00 };
-    err = HAPPlatformKeyValueStoreSet(
-            server->platform.keyValueStore,
-            kHAPKeyValueStoreDomain_Configuration,
-            kHAPKeyValueStoreKey_Configuration_BLEGSN,
-            gsnBytes,
-            sizeof gsnBytes);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
+    server->ble.gsn.current.didIncrement = false;
 
     // Reset broadcasted events.
     HAPRawBufferZero(&server->ble.adv.broadcastedEvent, sizeof server->ble.adv.broadcastedEvent);
@@ -597,24 +693,7 @@ HAPError HAPBLEAccessoryServerDidDisconnect(HAPAccessoryServerRef* server_) {
     }
 
     // Reset GSN update coalescing.
-    HAPBLEAccessoryServerGSN gsn;
-    err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
-    gsn.didIncrement = false;
-    uint8_t gsnBytes[] = { HAPExpandLittleUInt16(gsn.gsn), gsn.didIncrement ? (uint8_t) 0x01 : (uint8_t) 0x00 };
-    err = HAPPlatformKeyValueStoreSet(
-            server->platform.keyValueStore,
-            kHAPKeyValueStoreDomain_Configuration,
-            kHAPKeyValueStoreKey_Configuration_BLEGSN,
-            gsnBytes,
-            sizeof gsnBytes);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
+    server->ble.gsn.current.didIncrement = false;
 
     HAPAssert(!server->ble.adv.broadcastedEvent.iid);
 
@@ -644,52 +723,39 @@ static HAPError HAPBLEAccessoryServerIncrementGSN(HAPAccessoryServerRef* server_
 
     HAPError err;
 
-    // Get key expiration GSN.
-    uint16_t keyExpirationGSN;
-    err = HAPBLEAccessoryServerBroadcastGetParameters(server->platform.keyValueStore, &keyExpirationGSN, NULL, NULL);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
-
-    // Get GSN.
-    HAPBLEAccessoryServerGSN gsn;
-    err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
-
     // Expire broadcast encryption key if necessary.
-    if (gsn.gsn == keyExpirationGSN) {
-        err = HAPBLEAccessoryServerBroadcastExpireKey(server->platform.keyValueStore);
+    if (server->ble.gsn.current.gsn == server->ble.broadcastParameters.keyExpirationGSN) {
+        err = HAPBLEAccessoryServerBroadcastExpireKey(server_);
         if (err) {
             HAPAssert(err == kHAPError_Unknown);
             return err;
         }
     }
 
-    // Increment GSN.
-    if (gsn.gsn == UINT16_MAX) {
-        gsn.gsn = 1;
-    } else {
-        gsn.gsn++;
+    // Reserve GSN increments if necessary.
+    // The GSN in the key-value store must not fall behind the current GSN to prevent reuse after a restart.
+    // See HomeKit Accessory Protocol Specification R14
+    // Section 7.4.1.8 Global State Number (GSN)
+    if (!server->ble.gsn.numReservedIncrements) {
+        HAPBLEAccessoryServerGSN reservedGSN = {
+            .gsn = AdvanceGSN(server->ble.gsn.current.gsn, kHAPBLEAccessoryServer_NumReservedGSNIncrements),
+            .didIncrement = true
+        };
+        err = StoreGSN(server->platform.keyValueStore, &reservedGSN, /* isReserved: */ true);
+        if (err) {
+            HAPAssert(err == kHAPError_Unknown);
+            return err;
+        }
+        HAPLogDebug(&logObject, "Reserved GSN: %u.", reservedGSN.gsn);
+        server->ble.gsn.numReservedIncrements = kHAPBLEAccessoryServer_NumReservedGSNIncrements;
     }
-    gsn.didIncrement = true;
-    HAPLogInfo(&logObject, "New GSN: %u.", gsn.gsn);
 
-    // Save GSN state.
-    uint8_t gsnBytes[] = { HAPExpandLittleUInt16(gsn.gsn), gsn.didIncrement ? (uint8_t) 0x01 : (uint8_t) 0x00 };
-    err = HAPPlatformKeyValueStoreSet(
-            server->platform.keyValueStore,
-            kHAPKeyValueStoreDomain_Configuration,
-            kHAPKeyValueStoreKey_Configuration_BLEGSN,
-            gsnBytes,
-            sizeof gsnBytes);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
+    // Increment GSN.
+    server->ble.gsn.current.gsn = AdvanceGSN(server->ble.gsn.current.gsn, 1);
+    server->ble.gsn.current.didIncrement = true;
+    server->ble.gsn.numReservedIncrements--;
+    server->ble.gsn.isSaved = false;
+    HAPLogInfo(&logObject, "New GSN: %u.", server->ble.gsn.current.gsn);
 
     return kHAPError_None;
 }
@@ -743,18 +809,13 @@ HAPError HAPBLEAccessoryServerDidRaiseEvent(
         // Section 7.4.6.2 Broadcasted Events
         if (!server->ble.adv.connected) {
             uint16_t keyExpirationGSN;
-            err = HAPBLEAccessoryServerBroadcastGetParameters(
-                    server->platform.keyValueStore, &keyExpirationGSN, NULL, NULL);
+            err = HAPBLEAccessoryServerBroadcastGetParameters(server_, &keyExpirationGSN, NULL, NULL);
             if (err) {
                 HAPAssert(err == kHAPError_Unknown);
                 return err;
             }
             HAPBLEAccessoryServerGSN gsn;
-            err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-            if (err) {
-                HAPAssert(err == kHAPError_Unknown);
-                return err;
-            }
+            HAPBLEAccessoryServerGetGSN(server_, &gsn);
 
             // Characteristic changes while in a broadcast encryption key expired state shall not use broadcasted events
             // and must fall back to disconnected/connected events until the controller has re-generated a new broadcast
@@ -764,12 +825,8 @@ HAPError HAPBLEAccessoryServerDidRaiseEvent(
             if (keyExpirationGSN && keyExpirationGSN != gsn.gsn) {
                 HAPBLECharacteristicBroadcastInterval interval;
                 bool enabled;
-                err = HAPBLECharacteristicGetBroadcastConfiguration(
-                        characteristic, service, accessory, &enabled, &interval, server->platform.keyValueStore);
-                if (err) {
-                    HAPAssert(err == kHAPError_Unknown);
-                    return err;
-                }
+                HAPBLECharacteristicGetBroadcastConfiguration(
+                        server_, characteristic, service, accessory, &enabled, &interval);
 
                 if (enabled) {
                     // For additional characteristic changes before the completion of the 3 second period and before
@@ -1027,11 +1084,7 @@ HAPError HAPBLEAccessoryServerDidRaiseEvent(
         // Section 7.4.6.3 Disconnected Events
 
         HAPBLEAccessoryServerGSN gsn;
-        err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-        if (err) {
-            HAPAssert(err == kHAPError_Unknown);
-            return err;
-        }
+        HAPBLEAccessoryServerGetGSN(server_, &gsn);
 
         // The GSN should increment only once for multiple characteristic value changes while in in disconnected state
         // until the accessory state changes from disconnected to connected.
@@ -1113,11 +1166,7 @@ HAPError HAPBLEAccessoryServerDidSendEventNotification(
     // See HomeKit Accessory Protocol Specification R14
     // Section 7.4.6.1 Connected Events
     HAPBLEAccessoryServerGSN gsn;
-    err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
+    HAPBLEAccessoryServerGetGSN(server_, &gsn);
 
     // The GSN should increment only once for multiple characteristic value changes while in in disconnected state
     // until the accessory state changes from disconnected to connected.
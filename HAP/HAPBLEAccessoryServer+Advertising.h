@@ -26,16 +26,57 @@ typedef struct {
 } HAPBLEAccessoryServerGSN;
 
 /**
- * BLE: Fetches GSN state.
+ * Number of GSN increments that are reserved in the key-value store at once.
  *
- * @param      keyValueStore        Key-value store
- * @param[out] gsn                  GSN.
+ * - While the accessory server is running, the GSN is kept in RAM. The key-value store holds a GSN that is up to
+ *   this number of increments ahead of the current GSN and is only updated once the reserved increments are used up.
+ *   When the accessory server is stopped, the current GSN is stored.
+ *
+ * - If the accessory server is not stopped properly (e.g., power loss), it continues with the reserved GSN.
+ *   Therefore, a GSN is never reused, but up to this number of GSN values may be skipped.
+ *
+ * @see HomeKit Accessory Protocol Specification R14
+ *      Section 7.4.1.8 Global State Number (GSN)
+ */
+#define kHAPBLEAccessoryServer_NumReservedGSNIncrements ((uint16_t) 16)
+
+/**
+ * BLE: Loads GSN state from the key-value store.
+ *
+ * - The GSN state is kept in the accessory server while it is running.
+ *   This must be called when the accessory server starts, after the broadcast parameters have been loaded.
+ *
+ * - If the GSN has been advanced to a reserved GSN and the broadcast encryption key may have expired
+ *   in the skipped range of GSN values, the broadcast encryption key is expired.
+ *
+ * @param      server               Accessory server.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If an I/O error occurred.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPBLEAccessoryServerLoadGSN(HAPAccessoryServerRef* server);
+
+/**
+ * BLE: Stores the current GSN state in the key-value store.
+ *
+ * - This should be called when the accessory server stops.
+ *
+ * @param      server               Accessory server.
  *
  * @return kHAPError_None           If successful.
  * @return kHAPError_Unknown        If an I/O error occurred.
  */
 HAP_RESULT_USE_CHECK
-HAPError HAPBLEAccessoryServerGetGSN(HAPPlatformKeyValueStoreRef keyValueStore, HAPBLEAccessoryServerGSN* gsn);
+HAPError HAPBLEAccessoryServerSaveGSN(HAPAccessoryServerRef* server);
+
+/**
+ * BLE: Fetches GSN state.
+ *
+ * @param      server               Accessory server.
+ * @param[out] gsn                  GSN.
+ */
+void HAPBLEAccessoryServerGetGSN(const HAPAccessoryServerRef* server, HAPBLEAccessoryServerGSN* gsn);
 
 /**
  * BLE: Get advertisement parameters.
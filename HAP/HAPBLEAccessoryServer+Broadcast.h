@@ -31,10 +31,34 @@ HAP_STATIC_ASSERT(
         HAPBLEAccessoryServerBroadcastEncryptionKey);
 HAP_NONNULL_SUPPORT(HAPBLEAccessoryServerBroadcastEncryptionKey)
 
+/**
+ * BLE: Broadcast parameters.
+ */
+typedef struct {
+    uint16_t keyExpirationGSN;                       /**< GSN after which the key expires. 0 if key is expired. */
+    HAPBLEAccessoryServerBroadcastEncryptionKey key; /**< Broadcast encryption key. */
+    bool hasAdvertisingID;                           /**< Whether an advertising identifier has been set. */
+    HAPDeviceID advertisingID;                       /**< Accessory advertising identifier. */
+} HAPBLEAccessoryServerBroadcastParameters;
+
+/**
+ * BLE: Loads the broadcast parameters from the key-value store.
+ *
+ * - The broadcast parameters are kept in the accessory server while it is running.
+ *   This must be called when the accessory server starts.
+ *
+ * @param      server               Accessory server.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If an I/O error occurred.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPBLEAccessoryServerBroadcastLoadParameters(HAPAccessoryServerRef* server);
+
 /**
  * BLE: Fetches broadcast encryption key parameters.
  *
- * @param      keyValueStore        Key-value store.
+ * @param      server               Accessory server.
  * @param[out] keyExpirationGSN     GSN after which the broadcast encryption key expires. 0 if key is expired.
  * @param[out] broadcastKey         Broadcast encryption key, if available.
  * @param[out] advertisingID        Accessory advertising identifier.
@@ -47,7 +71,7 @@ HAP_NONNULL_SUPPORT(HAPBLEAccessoryServerBroadcastEncryptionKey)
  */
 HAP_RESULT_USE_CHECK
 HAPError HAPBLEAccessoryServerBroadcastGetParameters(
-        HAPPlatformKeyValueStoreRef keyValueStore,
+        const HAPAccessoryServerRef* server,
         uint16_t* keyExpirationGSN,
         HAPBLEAccessoryServerBroadcastEncryptionKey* _Nullable broadcastKey,
         HAPDeviceID* _Nullable advertisingID);
@@ -70,7 +94,7 @@ HAPError HAPBLEAccessoryServerBroadcastGenerateKey(HAPSessionRef* session, const
 /**
  * BLE: Set accessory advertising identifier.
  *
- * @param      keyValueStore        Key-value store.
+ * @param      server               Accessory server.
  * @param      advertisingID        New accessory advertising identifier.
  *
  * @return kHAPError_None           If successful.
@@ -80,14 +104,12 @@ HAPError HAPBLEAccessoryServerBroadcastGenerateKey(HAPSessionRef* session, const
  *      Section 7.4.7.3 Broadcast Encryption Key Generation
  */
 HAP_RESULT_USE_CHECK
-HAPError HAPBLEAccessoryServerBroadcastSetAdvertisingID(
-        HAPPlatformKeyValueStoreRef keyValueStore,
-        const HAPDeviceID* advertisingID);
+HAPError HAPBLEAccessoryServerBroadcastSetAdvertisingID(HAPAccessoryServerRef* server, const HAPDeviceID* advertisingID);
 
 /**
  * BLE: Invalidate broadcast encryption key.
  *
- * @param      keyValueStore        Key-value store.
+ * @param      server               Accessory server.
  *
  * @return kHAPError_None           If successful.
  * @return kHAPError_Unknown        If an I/O error occurred.
@@ -96,7 +118,7 @@ HAPError HAPBLEAccessoryServerBroadcastSetAdvertisingID(
  *      Section 7.4.7.4 Broadcast Encryption Key expiration and refresh
  */
 HAP_RESULT_USE_CHECK
-HAPError HAPBLEAccessoryServerBroadcastExpireKey(HAPPlatformKeyValueStoreRef keyValueStore);
+HAPError HAPBLEAccessoryServerBroadcastExpireKey(HAPAccessoryServerRef* server);
 
 #if __has_feature(nullability)
 #pragma clang assume_nonnull end
@@ -19,8 +19,13 @@ static void Create(HAPAccessoryServerRef* server_, const HAPAccessoryServerOptio
     HAPPrecondition(options->ble.accessoryServerStorage);
     HAPBLEAccessoryServerStorage* storage = options->ble.accessoryServerStorage;
     HAPPrecondition(storage->gattTableElements);
+    HAPPrecondition(!storage->numAttributeHandleIndexElements || storage->attributeHandleIndex);
+    HAPPrecondition(!storage->numCharacteristicIndexElements || storage->characteristicIndex);
+    HAPPrecondition(!storage->signatureBuffer.numBytes || storage->signatureBuffer.bytes);
+    HAPPrecondition(!storage->numGATTDatabaseAttributes || storage->gattDatabaseAttributes);
     HAPPrecondition(storage->sessionCacheElements);
     HAPPrecondition(storage->numSessionCacheElements >= kHAPBLESessionCache_MinElements);
+    HAPPrecondition(storage->numSessionCacheElements <= UINT16_MAX);
     HAPPrecondition(storage->session);
     HAPPrecondition(storage->procedures);
     HAPPrecondition(storage->numProcedures >= 1);
@@ -29,6 +34,7 @@ static void Create(HAPAccessoryServerRef* server_, const HAPAccessoryServerOptio
     HAPRawBufferZero(storage->gattTableElements, storage->numGATTTableElements * sizeof *storage->gattTableElements);
     HAPRawBufferZero(
             storage->sessionCacheElements, storage->numSessionCacheElements * sizeof *storage->sessionCacheElements);
+    HAPRawBufferZero(&server->ble.sessionCache, sizeof server->ble.sessionCache);
     HAPRawBufferZero(storage->session, sizeof *storage->session);
     HAPRawBufferZero(storage->procedures, storage->numProcedures * sizeof *storage->procedures);
     HAPRawBufferZero(storage->procedureBuffer.bytes, storage->procedureBuffer.numBytes);
@@ -67,6 +73,7 @@ static void PrepareStart(HAPAccessoryServerRef* server_) {
     HAPRawBufferZero(storage->gattTableElements, storage->numGATTTableElements * sizeof *storage->gattTableElements);
     HAPRawBufferZero(
             storage->sessionCacheElements, storage->numSessionCacheElements * sizeof *storage->sessionCacheElements);
+    HAPRawBufferZero(&server->ble.sessionCache, sizeof server->ble.sessionCache);
     HAPRawBufferZero(storage->session, sizeof *storage->session);
     HAPRawBufferZero(storage->procedures, storage->numProcedures * sizeof *storage->procedures);
     HAPRawBufferZero(storage->procedureBuffer.bytes, storage->procedureBuffer.numBytes);
@@ -109,6 +116,31 @@ static void Start(HAPAccessoryServerRef* server_) {
     HAPAssert(HAPStringGetNumBytes(primaryAccessory->name) <= 64);
     HAPPlatformBLEPeripheralManagerSetDeviceName(blePeripheralManager, primaryAccessory->name);
 
+    // Load broadcast parameters and GSN.
+    err = HAPBLEAccessoryServerBroadcastLoadParameters(server_);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        HAPFatalError();
+    }
+    err = HAPBLEAccessoryServerLoadGSN(server_);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        HAPFatalError();
+    }
+
+    // Load characteristic broadcast configuration.
+    err = HAPBLECharacteristicLoadBroadcastConfiguration(server_);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        HAPFatalError();
+    }
+
+    // The advertisement state of the BLE peripheral manager is unknown until it is updated.
+    HAPRawBufferZero(&server->ble.adv.published, sizeof server->ble.adv.published);
+
+    // Precompute signatures.
+    HAPBLESignatureCachePrepare(server_);
+
     // Register GATT db.
     HAPBLEPeripheralManagerRegister(server_);
 }
@@ -120,6 +152,8 @@ static void TryStop(HAPAccessoryServerRef* server_, bool* didStop) {
     HAPPlatformBLEPeripheralManagerRef blePeripheralManager = server->platform.ble.blePeripheralManager;
     HAPPrecondition(didStop);
 
+    HAPError err;
+
     *didStop = false;
 
     // Close all connections.
@@ -137,9 +171,20 @@ static void TryStop(HAPAccessoryServerRef* server_, bool* didStop) {
     }
 
     // Stop listening.
-    HAPPlatformBLEPeripheralManagerRemoveAllServices(blePeripheralManager);
+    // A GATT database that was published in a single call is kept so that it can be reused on the next start.
+    if (!server->ble.gattDatabase.isRetained) {
+        HAPPlatformBLEPeripheralManagerRemoveAllServices(blePeripheralManager);
+    }
     HAPPlatformBLEPeripheralManagerSetDelegate(blePeripheralManager, NULL);
 
+    // Save GSN.
+    // If this fails, the reserved GSN is used when the accessory server is started again.
+    err = HAPBLEAccessoryServerSaveGSN(server_);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        HAPLogError(&logObject, "Saving GSN failed.");
+    }
+
     *didStop = true;
 }
 
@@ -178,22 +223,48 @@ static void UpdateAdvertisingData(HAPAccessoryServerRef* server_) {
         // Update advertisement.
         if (isActive) {
             HAPAssert(advertisingInterval);
-            HAPPlatformBLEPeripheralManagerStartAdvertising(
-                    blePeripheralManager,
-                    advertisingInterval,
-                    advertisingBytes,
-                    numAdvertisingBytes,
-                    numScanResponseBytes ? scanResponseBytes : NULL,
-                    numScanResponseBytes);
+            HAPAssert(numAdvertisingBytes <= sizeof server->ble.adv.published.advertisingBytes);
+            HAPAssert(numScanResponseBytes <= sizeof server->ble.adv.published.scanResponseBytes);
+            if (server->ble.adv.published.isPublished && server->ble.adv.published.isActive &&
+                server->ble.adv.published.advertisingInterval == advertisingInterval &&
+                server->ble.adv.published.numAdvertisingBytes == numAdvertisingBytes &&
+                HAPRawBufferAreEqual(
+                        server->ble.adv.published.advertisingBytes, advertisingBytes, numAdvertisingBytes) &&
+                server->ble.adv.published.numScanResponseBytes == numScanResponseBytes &&
+                HAPRawBufferAreEqual(
+                        server->ble.adv.published.scanResponseBytes, scanResponseBytes, numScanResponseBytes)) {
+                HAPLogDebug(&logObject, "Advertisement did not change.");
+            } else {
+                HAPPlatformBLEPeripheralManagerStartAdvertising(
+                        blePeripheralManager,
+                        advertisingInterval,
+                        advertisingBytes,
+                        numAdvertisingBytes,
+                        numScanResponseBytes ? scanResponseBytes : NULL,
+                        numScanResponseBytes);
+                server->ble.adv.published.advertisingInterval = advertisingInterval;
+                HAPRawBufferCopyBytes(
+                        server->ble.adv.published.advertisingBytes, advertisingBytes, numAdvertisingBytes);
+                server->ble.adv.published.numAdvertisingBytes = (uint8_t) numAdvertisingBytes;
+                HAPRawBufferCopyBytes(
+                        server->ble.adv.published.scanResponseBytes, scanResponseBytes, numScanResponseBytes);
+                server->ble.adv.published.numScanResponseBytes = (uint8_t) numScanResponseBytes;
+                server->ble.adv.published.isPublished = true;
+                server->ble.adv.published.isActive = true;
+            }
 
             // Mark advertisement started.
             HAPBLEAccessoryServerDidStartAdvertising(server_);
-        } else {
+        } else if (!server->ble.adv.published.isPublished || server->ble.adv.published.isActive) {
             HAPPlatformBLEPeripheralManagerStopAdvertising(blePeripheralManager);
+            server->ble.adv.published.isPublished = true;
+            server->ble.adv.published.isActive = false;
         }
     } else {
         HAPLogInfo(&logObject, "Stopping advertisement - Server is shutting down.");
         HAPPlatformBLEPeripheralManagerStopAdvertising(blePeripheralManager);
+        server->ble.adv.published.isPublished = true;
+        server->ble.adv.published.isActive = false;
     }
 }
 
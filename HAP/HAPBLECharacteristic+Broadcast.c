@@ -131,95 +131,188 @@ static HAPError GetBroadcastConfiguration(
     return kHAPError_None;
 }
 
+/**
+ * Finds the broadcast configuration of a characteristic in a characteristic configuration.
+ *
+ * - Items of the characteristic configuration are sorted by characteristic ID.
+ *
+ * @param      bytes                Characteristic configuration.
+ * @param      numBytes             Length of characteristic configuration.
+ * @param      cid                  Characteristic ID.
+ * @param[out] found                Whether an item for the characteristic has been found.
+ *
+ * @return Offset of the item for the characteristic if found, or offset at which it would be inserted otherwise.
+ */
 HAP_RESULT_USE_CHECK
-HAPError HAPBLECharacteristicGetBroadcastConfiguration(
-        const HAPCharacteristic* characteristic_,
-        const HAPService* service,
-        const HAPAccessory* accessory,
-        bool* broadcastsEnabled,
-        HAPBLECharacteristicBroadcastInterval* broadcastInterval,
-        HAPPlatformKeyValueStoreRef keyValueStore) {
-    HAPPrecondition(characteristic_);
-    const HAPBaseCharacteristic* characteristic = characteristic_;
-    HAPPrecondition(characteristic->properties.ble.supportsBroadcastNotification);
-    HAPPrecondition(service);
-    HAPPrecondition(accessory);
-    HAPPrecondition(broadcastsEnabled);
-    HAPPrecondition(broadcastInterval);
-    HAPPrecondition(keyValueStore);
+static size_t FindBroadcastConfigurationItem(const uint8_t* bytes, size_t numBytes, uint16_t cid, bool* found) {
+    HAPPrecondition(bytes);
+    HAPPrecondition(numBytes >= 2 && !((numBytes - 2) % 3));
+    HAPPrecondition(found);
+
+    size_t lo = 0;
+    size_t hi = (numBytes - 2) / 3;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        uint16_t itemCID = HAPReadLittleUInt16(&bytes[2 + 3 * mid]);
+        if (itemCID < cid) {
+            lo = mid + 1;
+        } else if (itemCID > cid) {
+            hi = mid;
+        } else {
+            *found = true;
+            return 2 + 3 * mid;
+        }
+    }
+    *found = false;
+    return 2 + 3 * lo;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPBLECharacteristicLoadBroadcastConfiguration(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
 
     HAPError err;
 
-    HAPAssert(accessory->aid == 1);
-    uint16_t aid = (uint16_t) accessory->aid;
-    HAPAssert(characteristic->iid <= UINT16_MAX);
-    uint16_t cid = (uint16_t) characteristic->iid;
+    HAPRawBufferZero(&server->ble.broadcastConfiguration, sizeof server->ble.broadcastConfiguration);
 
     // Get configuration.
-    HAPPlatformKeyValueStoreKey key;
+    uint16_t aid = 1;
+    uint8_t* bytes = server->ble.broadcastConfiguration.bytes;
     size_t numBytes;
-    uint8_t bytes[2 + 3 * 42 + 1]; // 128 + 1, allows for 42 concurrent broadcasts on a single KVS key.
     bool found;
-    err = GetBroadcastConfiguration(aid, &found, bytes, sizeof bytes, &numBytes, &key, keyValueStore);
+    err = GetBroadcastConfiguration(
+            aid,
+            &found,
+            bytes,
+            sizeof server->ble.broadcastConfiguration.bytes,
+            &numBytes,
+            &server->ble.broadcastConfiguration.key,
+            server->platform.keyValueStore);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return err;
     }
     if (!found) {
-        *broadcastsEnabled = false;
-        return kHAPError_None;
+        HAPWriteLittleUInt16(bytes, aid);
+        numBytes = 2;
     }
     HAPAssert(numBytes >= 2 && !((numBytes - 2) % 3));
     HAPAssert(HAPReadLittleUInt16(bytes) == aid);
 
-    // Find characteristic.
+    // Validate configuration.
     for (size_t i = 2; i < numBytes; i += 3) {
-        uint16_t itemCID = HAPReadLittleUInt16(&bytes[i]);
-        if (itemCID < cid) {
-            continue;
-        }
-        if (itemCID > cid) {
-            break;
+        if (i > 2 && HAPReadLittleUInt16(&bytes[i]) <= HAPReadLittleUInt16(&bytes[i - 3])) {
+            HAPLog(&logObject, "Stored broadcast configuration is not sorted.");
+            return kHAPError_Unknown;
         }
-
-        // Found. Extract configuration.
         uint8_t broadcastConfiguration = bytes[i + 2];
         if (!HAPBLECharacteristicIsValidBroadcastInterval(broadcastConfiguration)) {
-            HAPLogCharacteristic(
-                    &logObject,
-                    characteristic,
-                    service,
-                    accessory,
-                    "Invalid stored broadcast interval: 0x%02x.",
-                    broadcastConfiguration);
+            HAPLog(&logObject,
+                   "Invalid stored broadcast interval for characteristic 0x%04x: 0x%02x.",
+                   HAPReadLittleUInt16(&bytes[i]),
+                   broadcastConfiguration);
             return kHAPError_Unknown;
         }
-        *broadcastsEnabled = true;
-        *broadcastInterval = (HAPBLECharacteristicBroadcastInterval) broadcastConfiguration;
-        return kHAPError_None;
     }
+    server->ble.broadcastConfiguration.numBytes = numBytes;
 
-    // Not found.
-    *broadcastsEnabled = false;
+    return kHAPError_None;
+}
+
+void HAPBLECharacteristicGetBroadcastConfiguration(
+        const HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* characteristic_,
+        const HAPService* service,
+        const HAPAccessory* accessory,
+        bool* broadcastsEnabled,
+        HAPBLECharacteristicBroadcastInterval* broadcastInterval) {
+    HAPPrecondition(server_);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) server_;
+    HAPPrecondition(characteristic_);
+    const HAPBaseCharacteristic* characteristic = characteristic_;
+    HAPPrecondition(characteristic->properties.ble.supportsBroadcastNotification);
+    HAPPrecondition(service);
+    HAPPrecondition(accessory);
+    HAPPrecondition(broadcastsEnabled);
+    HAPPrecondition(broadcastInterval);
+
+    HAPAssert(accessory->aid == 1);
+    HAPAssert(characteristic->iid <= UINT16_MAX);
+    uint16_t cid = (uint16_t) characteristic->iid;
+
+    // Find characteristic.
+    const uint8_t* bytes = server->ble.broadcastConfiguration.bytes;
+    size_t numBytes = server->ble.broadcastConfiguration.numBytes;
+    bool found;
+    size_t i = FindBroadcastConfigurationItem(bytes, numBytes, cid, &found);
+    if (!found) {
+        *broadcastsEnabled = false;
+        return;
+    }
+
+    // Found. Extract configuration. Intervals have been validated when loading the configuration.
+    *broadcastsEnabled = true;
+    *broadcastInterval = (HAPBLECharacteristicBroadcastInterval) bytes[i + 2];
+}
+
+/**
+ * Stores an updated characteristic configuration.
+ *
+ * @param      server               Accessory server.
+ * @param      bytes                Characteristic configuration.
+ * @param      numBytes             Length of characteristic configuration.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If an I/O error occurred.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError SaveBroadcastConfiguration(HAPAccessoryServer* server, const uint8_t* bytes, size_t numBytes) {
+    HAPPrecondition(server);
+    HAPPrecondition(bytes);
+    HAPPrecondition(numBytes >= 2 && !((numBytes - 2) % 3));
+    HAPPrecondition(numBytes < sizeof server->ble.broadcastConfiguration.bytes);
+
+    HAPError err;
+
+    HAPPlatformKeyValueStoreKey key = server->ble.broadcastConfiguration.key;
+    if (numBytes == 2) {
+        err = HAPPlatformKeyValueStoreRemove(
+                server->platform.keyValueStore, kHAPKeyValueStoreDomain_CharacteristicConfiguration, key);
+    } else {
+        err = HAPPlatformKeyValueStoreSet(
+                server->platform.keyValueStore,
+                kHAPKeyValueStoreDomain_CharacteristicConfiguration,
+                key,
+                bytes,
+                numBytes);
+    }
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        return err;
+    }
+
+    // Update cached configuration.
+    HAPRawBufferCopyBytes(server->ble.broadcastConfiguration.bytes, bytes, numBytes);
+    server->ble.broadcastConfiguration.numBytes = numBytes;
     return kHAPError_None;
 }
 
 HAP_RESULT_USE_CHECK
 HAPError HAPBLECharacteristicEnableBroadcastNotifications(
+        HAPAccessoryServerRef* server_,
         const HAPCharacteristic* characteristic_,
         const HAPService* service,
         const HAPAccessory* accessory,
-        HAPBLECharacteristicBroadcastInterval broadcastInterval,
-        HAPPlatformKeyValueStoreRef keyValueStore) {
+        HAPBLECharacteristicBroadcastInterval broadcastInterval) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
     HAPPrecondition(characteristic_);
     const HAPBaseCharacteristic* characteristic = characteristic_;
     HAPPrecondition(characteristic->properties.ble.supportsBroadcastNotification);
     HAPPrecondition(service);
     HAPPrecondition(accessory);
     HAPPrecondition(HAPBLECharacteristicIsValidBroadcastInterval(broadcastInterval));
-    HAPPrecondition(keyValueStore);
-
-    HAPError err;
 
     HAPLogCharacteristicInfo(
             &logObject,
@@ -230,64 +323,24 @@ HAPError HAPBLECharacteristicEnableBroadcastNotifications(
             broadcastInterval);
 
     HAPAssert(accessory->aid == 1);
-    uint16_t aid = (uint16_t) accessory->aid;
     HAPAssert(characteristic->iid <= UINT16_MAX);
     uint16_t cid = (uint16_t) characteristic->iid;
 
     // Get configuration.
-    HAPPlatformKeyValueStoreKey key;
-    size_t numBytes;
-    uint8_t bytes[2 + 3 * 42 + 1]; // 128 + 1, allows for 42 concurrent broadcasts on a single KVS key.
-    bool found;
-    err = GetBroadcastConfiguration(aid, &found, bytes, sizeof bytes, &numBytes, &key, keyValueStore);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
-    if (!found) {
-        key = 0;
-        HAPWriteLittleUInt16(bytes, aid);
-        numBytes = 2;
-    }
-    HAPAssert(numBytes >= 2 && !((numBytes - 2) % 3));
-    HAPAssert(HAPReadLittleUInt16(bytes) == aid);
+    uint8_t bytes[kHAPBLECharacteristic_BroadcastConfigurationBufferSize];
+    size_t numBytes = server->ble.broadcastConfiguration.numBytes;
+    HAPRawBufferCopyBytes(bytes, server->ble.broadcastConfiguration.bytes, numBytes);
 
     // Find characteristic.
-    size_t i;
-    for (i = 2; i < numBytes; i += 3) {
-        uint16_t itemCID = HAPReadLittleUInt16(&bytes[i]);
-        if (itemCID < cid) {
-            continue;
-        }
-        if (itemCID > cid) {
-            break;
-        }
-
-        // Found. Extract configuration.
-        uint8_t broadcastConfiguration = bytes[i + 2];
-        if (!HAPBLECharacteristicIsValidBroadcastInterval(broadcastConfiguration)) {
-            HAPLogCharacteristic(
-                    &logObject,
-                    characteristic,
-                    service,
-                    accessory,
-                    "Invalid stored broadcast interval: 0x%02x.",
-                    broadcastConfiguration);
-            return kHAPError_Unknown;
-        }
-
+    bool found;
+    size_t i = FindBroadcastConfigurationItem(bytes, numBytes, cid, &found);
+    if (found) {
         // Update configuration.
-        if ((HAPBLECharacteristicBroadcastInterval) broadcastConfiguration == broadcastInterval) {
+        if ((HAPBLECharacteristicBroadcastInterval) bytes[i + 2] == broadcastInterval) {
             return kHAPError_None;
         }
         bytes[i + 2] = broadcastInterval;
-        err = HAPPlatformKeyValueStoreSet(
-                keyValueStore, kHAPKeyValueStoreDomain_CharacteristicConfiguration, key, bytes, numBytes);
-        if (err) {
-            HAPAssert(err == kHAPError_Unknown);
-            return err;
-        }
-        return kHAPError_None;
+        return SaveBroadcastConfiguration(server, bytes, numBytes);
     }
 
     // Add configuration.
@@ -304,92 +357,43 @@ HAPError HAPBLECharacteristicEnableBroadcastNotifications(
     HAPWriteLittleUInt16(&bytes[i], cid);
     bytes[i + 2] = broadcastInterval;
     numBytes += 3;
-    err = HAPPlatformKeyValueStoreSet(
-            keyValueStore, kHAPKeyValueStoreDomain_CharacteristicConfiguration, key, bytes, numBytes);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
-    return kHAPError_None;
+    return SaveBroadcastConfiguration(server, bytes, numBytes);
 }
 
 HAP_RESULT_USE_CHECK
 HAPError HAPBLECharacteristicDisableBroadcastNotifications(
+        HAPAccessoryServerRef* server_,
         const HAPCharacteristic* characteristic_,
         const HAPService* service,
-        const HAPAccessory* accessory,
-        HAPPlatformKeyValueStoreRef keyValueStore) {
+        const HAPAccessory* accessory) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
     HAPPrecondition(characteristic_);
     const HAPBaseCharacteristic* characteristic = characteristic_;
     HAPPrecondition(characteristic->properties.ble.supportsBroadcastNotification);
     HAPPrecondition(service);
     HAPPrecondition(accessory);
-    HAPPrecondition(keyValueStore);
-
-    HAPError err;
 
     HAPLogCharacteristicInfo(&logObject, characteristic, service, accessory, "Disabling broadcasts.");
 
     HAPAssert(accessory->aid == 1);
-    uint16_t aid = (uint16_t) accessory->aid;
     HAPAssert(characteristic->iid <= UINT16_MAX);
     uint16_t cid = (uint16_t) characteristic->iid;
 
     // Get configuration.
-    HAPPlatformKeyValueStoreKey key;
-    size_t numBytes;
-    uint8_t bytes[2 + 3 * 42 + 1]; // 128 + 1, allows for 42 concurrent broadcasts on a single KVS key.
+    uint8_t bytes[kHAPBLECharacteristic_BroadcastConfigurationBufferSize];
+    size_t numBytes = server->ble.broadcastConfiguration.numBytes;
+    HAPRawBufferCopyBytes(bytes, server->ble.broadcastConfiguration.bytes, numBytes);
+
+    // Find characteristic.
     bool found;
-    err = GetBroadcastConfiguration(aid, &found, bytes, sizeof bytes, &numBytes, &key, keyValueStore);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
+    size_t i = FindBroadcastConfigurationItem(bytes, numBytes, cid, &found);
     if (!found) {
         return kHAPError_None;
     }
-    HAPAssert(numBytes >= 2 && !((numBytes - 2) % 3));
-    HAPAssert(HAPReadLittleUInt16(bytes) == aid);
-
-    // Find characteristic.
-    size_t i;
-    for (i = 2; i < numBytes; i += 3) {
-        uint16_t itemCID = HAPReadLittleUInt16(&bytes[i]);
-        if (itemCID < cid) {
-            continue;
-        }
-        if (itemCID > cid) {
-            break;
-        }
-
-        // Found. Extract configuration.
-        uint8_t broadcastConfiguration = bytes[i + 2];
-        if (!HAPBLECharacteristicIsValidBroadcastInterval(broadcastConfiguration)) {
-            HAPLogCharacteristic(
-                    &logObject,
-                    characteristic,
-                    service,
-                    accessory,
-                    "Invalid stored broadcast interval: 0x%02x.",
-                    broadcastConfiguration);
-            return kHAPError_Unknown;
-        }
 
-        // Remove configuration.
-        numBytes -= 3;
-        HAPRawBufferCopyBytes(&bytes[i], &bytes[i + 3], numBytes - i);
-        if (numBytes == 2) {
-            err = HAPPlatformKeyValueStoreRemove(
-                    keyValueStore, kHAPKeyValueStoreDomain_CharacteristicConfiguration, key);
-        } else {
-            err = HAPPlatformKeyValueStoreSet(
-                    keyValueStore, kHAPKeyValueStoreDomain_CharacteristicConfiguration, key, bytes, numBytes);
-        }
-        if (err) {
-            HAPAssert(err == kHAPError_Unknown);
-            return err;
-        }
-        return kHAPError_None;
-    }
-    return kHAPError_None;
+    // Remove configuration.
+    numBytes -= 3;
+    HAPRawBufferCopyBytes(&bytes[i], &bytes[i + 3], numBytes - i);
+    return SaveBroadcastConfiguration(server, bytes, numBytes);
 }
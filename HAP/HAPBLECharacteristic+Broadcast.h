@@ -44,39 +44,59 @@ HAP_ENUM_BEGIN(uint8_t, HAPBLECharacteristicBroadcastInterval) { /** 20 ms (Defa
 HAP_RESULT_USE_CHECK
 bool HAPBLECharacteristicIsValidBroadcastInterval(uint8_t value);
 
+/**
+ * Capacity of the buffer holding the broadcast configuration of an accessory.
+ *
+ * - 2 bytes accessory ID followed by 3 bytes per characteristic with enabled broadcasts
+ *   (2 bytes characteristic ID, 1 byte broadcast interval), sorted by characteristic ID.
+ *
+ * - Allows for 42 concurrent broadcasts on a single key-value store key. The extra byte detects oversized data.
+ */
+#define kHAPBLECharacteristic_BroadcastConfigurationBufferSize ((size_t)(2 + 3 * 42 + 1))
+
+/**
+ * Loads the broadcast configuration of the characteristics from the key-value store.
+ *
+ * - The broadcast configuration is kept in the accessory server while it is running.
+ *   This must be called when the accessory server starts.
+ *
+ * @param      server               Accessory server.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If an I/O error occurred or if the stored configuration is invalid.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPBLECharacteristicLoadBroadcastConfiguration(HAPAccessoryServerRef* server);
+
 /**
  * Gets the broadcast configuration of a characteristic.
  *
+ * @param      server               Accessory server.
  * @param      characteristic       Characteristic. Characteristic must support broadcasts.
  * @param      service              The service that contains the characteristic.
  * @param      accessory            The accessory that provides the service.
  * @param[out] broadcastsEnabled    Whether broadcast notifications are enabled.
  * @param[out] broadcastInterval    Broadcast interval, if broadcast notifications are enabled.
- * @param      keyValueStore        Key-value store.
- *
- * @return kHAPError_None           If successful.
- * @return kHAPError_Unknown        If an I/O error occurred.
  *
  * @see HomeKit Accessory Protocol Specification R14
  *      Section 7.3.5.8 HAP Characteristic Configuration Procedure
  */
-HAP_RESULT_USE_CHECK
-HAPError HAPBLECharacteristicGetBroadcastConfiguration(
+void HAPBLECharacteristicGetBroadcastConfiguration(
+        const HAPAccessoryServerRef* server,
         const HAPCharacteristic* characteristic,
         const HAPService* service,
         const HAPAccessory* accessory,
         bool* broadcastsEnabled,
-        HAPBLECharacteristicBroadcastInterval* broadcastInterval,
-        HAPPlatformKeyValueStoreRef keyValueStore);
+        HAPBLECharacteristicBroadcastInterval* broadcastInterval);
 
 /**
  * Enables broadcasts for a characteristic.
  *
+ * @param      server               Accessory server.
  * @param      characteristic       Characteristic. Characteristic must support broadcasts.
  * @param      service              The service that contains the characteristic.
  * @param      accessory            The accessory that provides the service.
  * @param      broadcastInterval    Broadcast interval.
- * @param      keyValueStore        Key-value store.
  *
  * @return kHAPError_None           If successful.
  * @return kHAPError_Unknown        If an I/O error occurred.
@@ -86,19 +106,19 @@ HAPError HAPBLECharacteristicGetBroadcastConfiguration(
  */
 HAP_RESULT_USE_CHECK
 HAPError HAPBLECharacteristicEnableBroadcastNotifications(
+        HAPAccessoryServerRef* server,
         const HAPCharacteristic* characteristic,
         const HAPService* service,
         const HAPAccessory* accessory,
-        HAPBLECharacteristicBroadcastInterval broadcastInterval,
-        HAPPlatformKeyValueStoreRef keyValueStore);
+        HAPBLECharacteristicBroadcastInterval broadcastInterval);
 
 /**
  * Disables broadcasts for a characteristic.
  *
+ * @param      server               Accessory server.
  * @param      characteristic       Characteristic. Characteristic must support broadcasts.
  * @param      service              The service that contains the characteristic.
  * @param      accessory            The accessory that provides the service.
- * @param      keyValueStore        Key-value store.
  *
  * @return kHAPError_None           If successful.
  * @return kHAPError_Unknown        If an I/O error occurred.
@@ -108,10 +128,10 @@ HAPError HAPBLECharacteristicEnableBroadcastNotifications(
  */
 HAP_RESULT_USE_CHECK
 HAPError HAPBLECharacteristicDisableBroadcastNotifications(
+        HAPAccessoryServerRef* server,
         const HAPCharacteristic* characteristic,
         const HAPService* service,
-        const HAPAccessory* accessory,
-        HAPPlatformKeyValueStoreRef keyValueStore);
+        const HAPAccessory* accessory);
 
 #if __has_feature(nullability)
 #pragma clang assume_nonnull end
@@ -35,17 +35,17 @@ HAP_ENUM_BEGIN(uint8_t, HAPBLECharacteristicConfigurationProperty) {
 
 HAP_RESULT_USE_CHECK
 HAPError HAPBLECharacteristicHandleConfigurationRequest(
+        HAPAccessoryServerRef* server,
         const HAPCharacteristic* characteristic_,
         const HAPService* service,
         const HAPAccessory* accessory,
-        HAPTLVReaderRef* requestReader,
-        HAPPlatformKeyValueStoreRef keyValueStore) {
+        HAPTLVReaderRef* requestReader) {
+    HAPPrecondition(server);
     HAPPrecondition(characteristic_);
     const HAPBaseCharacteristic* characteristic = characteristic_;
     HAPPrecondition(service);
     HAPPrecondition(accessory);
     HAPPrecondition(requestReader);
-    HAPPrecondition(keyValueStore);
 
     HAPError err;
 
@@ -125,7 +125,7 @@ HAPError HAPBLECharacteristicHandleConfigurationRequest(
 
             // Enable broadcasts.
             err = HAPBLECharacteristicEnableBroadcastNotifications(
-                    characteristic, service, accessory, broadcastInterval, keyValueStore);
+                    server, characteristic, service, accessory, broadcastInterval);
             if (err) {
                 HAPAssert(err == kHAPError_Unknown);
                 return err;
@@ -145,7 +145,7 @@ HAPError HAPBLECharacteristicHandleConfigurationRequest(
             // Disable broadcasts if characteristic supports broadcasts.
             if (characteristic->properties.ble.supportsBroadcastNotification) {
                 err = HAPBLECharacteristicDisableBroadcastNotifications(
-                        characteristic, service, accessory, keyValueStore);
+                        server, characteristic, service, accessory);
                 if (err) {
                     HAPAssert(err == kHAPError_Unknown);
                     return err;
@@ -170,29 +170,25 @@ HAPError HAPBLECharacteristicHandleConfigurationRequest(
 
 HAP_RESULT_USE_CHECK
 HAPError HAPBLECharacteristicGetConfigurationResponse(
+        const HAPAccessoryServerRef* server,
         const HAPCharacteristic* characteristic_,
         const HAPService* service,
         const HAPAccessory* accessory,
-        HAPTLVWriterRef* responseWriter,
-        HAPPlatformKeyValueStoreRef keyValueStore) {
+        HAPTLVWriterRef* responseWriter) {
+    HAPPrecondition(server);
     HAPPrecondition(characteristic_);
     const HAPBaseCharacteristic* characteristic = characteristic_;
     HAPPrecondition(service);
     HAPPrecondition(accessory);
     HAPPrecondition(responseWriter);
-    HAPPrecondition(keyValueStore);
 
     HAPError err;
     uint16_t properties = 0;
     if (characteristic->properties.ble.supportsBroadcastNotification) {
         HAPBLECharacteristicBroadcastInterval broadcastInterval;
         bool broadcastsEnabled;
-        err = HAPBLECharacteristicGetBroadcastConfiguration(
-                characteristic, service, accessory, &broadcastsEnabled, &broadcastInterval, keyValueStore);
-        if (err) {
-            HAPAssert(err == kHAPError_Unknown);
-            return err;
-        }
+        HAPBLECharacteristicGetBroadcastConfiguration(
+                server, characteristic, service, accessory, &broadcastsEnabled, &broadcastInterval);
 
         if (broadcastsEnabled) {
             properties |= kHAPBLECharacteristicConfigurationProperty_EnableBroadcasts;
@@ -8,15 +8,27 @@
 
 HAP_RESULT_USE_CHECK
 HAPError HAPBLECharacteristicGetSignatureReadResponse(
+        const HAPAccessoryServerRef* server,
         const HAPCharacteristic* characteristic,
         const HAPService* service,
         HAPTLVWriterRef* responseWriter) {
+    HAPPrecondition(server);
     HAPPrecondition(characteristic);
     HAPPrecondition(service);
     HAPPrecondition(responseWriter);
 
     HAPError err;
 
+    bool found;
+    err = HAPBLESignatureCacheGet(server, ((const HAPBaseCharacteristic*) characteristic)->iid, responseWriter, &found);
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        return err;
+    }
+    if (found) {
+        return kHAPError_None;
+    }
+
     err = HAPBLEPDUTLVSerializeCharacteristicType(characteristic, responseWriter);
     if (err) {
         HAPAssert(err == kHAPError_OutOfResources);
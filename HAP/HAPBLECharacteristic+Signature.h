@@ -20,6 +20,9 @@ extern "C" {
 /**
  * Serializes the body of a HAP-Characteristic-Signature-Read-Response.
  *
+ * - If the signature has been cached when the accessory server was started, the cached signature is copied.
+ *
+ * @param      server               Accessory server.
  * @param      characteristic       Characteristic that received the request.
  * @param      service              The service that contains the characteristic.
  * @param      responseWriter       Writer to serialize Characteristic Signature into.
@@ -32,6 +35,7 @@ extern "C" {
  */
 HAP_RESULT_USE_CHECK
 HAPError HAPBLECharacteristicGetSignatureReadResponse(
+        const HAPAccessoryServerRef* server,
         const HAPCharacteristic* characteristic,
         const HAPService* service,
         HAPTLVWriterRef* responseWriter);
@@ -31,6 +31,7 @@ extern "C" {
  * @return kHAPError_Unknown        If unable to perform operation with requested service or characteristic.
  * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
  * @return kHAPError_OutOfResources If out of resources to process request, or writer does not have enough capacity.
+ * @return kHAPError_InProgress     If the read handler will complete the request asynchronously.
  *
  * @see HomeKit Accessory Protocol Specification R14
  *      Section 7.3.4.7 HAP-Characteristic-Read-Response
@@ -62,6 +63,7 @@ HAPError HAPBLECharacteristicReadAndSerializeValue(
  * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
  * @return kHAPError_InvalidData    If the controller sent a malformed request, or an out-of-range value.
  * @return kHAPError_OutOfResources If out of resources to process request.
+ * @return kHAPError_InProgress     If the write handler will complete the request asynchronously.
  *
  * @see HomeKit Accessory Protocol Specification R14
  *      Section 7.3.4.4 HAP-Characteristic-Write-Request
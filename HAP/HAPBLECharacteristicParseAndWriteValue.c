@@ -297,7 +297,8 @@ HAPError HAPBLECharacteristicParseAndWriteValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                        err == kHAPError_InProgress);
                 return err;
             }
         }
@@ -333,7 +334,8 @@ HAPError HAPBLECharacteristicParseAndWriteValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                        err == kHAPError_InProgress);
                 return err;
             }
         }
@@ -364,7 +366,8 @@ HAPError HAPBLECharacteristicParseAndWriteValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                        err == kHAPError_InProgress);
                 return err;
             }
         }
@@ -395,7 +398,8 @@ HAPError HAPBLECharacteristicParseAndWriteValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                        err == kHAPError_InProgress);
                 return err;
             }
         }
@@ -420,7 +424,8 @@ HAPError HAPBLECharacteristicParseAndWriteValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                        err == kHAPError_InProgress);
                 return err;
             }
         }
@@ -451,7 +456,8 @@ HAPError HAPBLECharacteristicParseAndWriteValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                        err == kHAPError_InProgress);
                 return err;
             }
         }
@@ -482,7 +488,8 @@ HAPError HAPBLECharacteristicParseAndWriteValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                        err == kHAPError_InProgress);
                 return err;
             }
         }
@@ -514,7 +521,8 @@ HAPError HAPBLECharacteristicParseAndWriteValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                        err == kHAPError_InProgress);
                 return err;
             }
         }
@@ -557,7 +565,8 @@ HAPError HAPBLECharacteristicParseAndWriteValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                        err == kHAPError_InProgress);
                 return err;
             }
         }
@@ -583,7 +592,8 @@ HAPError HAPBLECharacteristicParseAndWriteValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                        err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                        err == kHAPError_InProgress);
                 return err;
             }
         }
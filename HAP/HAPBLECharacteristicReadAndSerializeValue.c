@@ -88,7 +88,7 @@ HAPError HAPBLECharacteristicReadAndSerializeValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                        err == kHAPError_Busy);
+                        err == kHAPError_Busy || err == kHAPError_InProgress);
                 return err;
             }
         }
@@ -111,7 +111,7 @@ HAPError HAPBLECharacteristicReadAndSerializeValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                        err == kHAPError_Busy);
+                        err == kHAPError_Busy || err == kHAPError_InProgress);
                 return err;
             }
             uint8_t* b = bytes;
@@ -137,7 +137,7 @@ HAPError HAPBLECharacteristicReadAndSerializeValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                        err == kHAPError_Busy);
+                        err == kHAPError_Busy || err == kHAPError_InProgress);
                 return err;
             }
             uint8_t* b = bytes;
@@ -163,7 +163,7 @@ HAPError HAPBLECharacteristicReadAndSerializeValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                        err == kHAPError_Busy);
+                        err == kHAPError_Busy || err == kHAPError_InProgress);
                 return err;
             }
             uint8_t* b = bytes;
@@ -189,7 +189,7 @@ HAPError HAPBLECharacteristicReadAndSerializeValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                        err == kHAPError_Busy);
+                        err == kHAPError_Busy || err == kHAPError_InProgress);
                 return err;
             }
             uint8_t* b = bytes;
@@ -215,7 +215,7 @@ HAPError HAPBLECharacteristicReadAndSerializeValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                        err == kHAPError_Busy);
+                        err == kHAPError_Busy || err == kHAPError_InProgress);
                 return err;
             }
             uint8_t* b = bytes;
@@ -241,7 +241,7 @@ HAPError HAPBLECharacteristicReadAndSerializeValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                        err == kHAPError_Busy);
+                        err == kHAPError_Busy || err == kHAPError_InProgress);
                 return err;
             }
             uint8_t* b = bytes;
@@ -267,7 +267,7 @@ HAPError HAPBLECharacteristicReadAndSerializeValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                        err == kHAPError_Busy);
+                        err == kHAPError_Busy || err == kHAPError_InProgress);
                 return err;
             }
             uint32_t bitPattern = HAPFloatGetBitPattern(characteristicValue);
@@ -293,7 +293,7 @@ HAPError HAPBLECharacteristicReadAndSerializeValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                        err == kHAPError_Busy);
+                        err == kHAPError_Busy || err == kHAPError_InProgress);
                 return err;
             }
             numBytes = HAPStringGetNumBytes(bytes);
@@ -319,7 +319,7 @@ HAPError HAPBLECharacteristicReadAndSerializeValue(
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                        err == kHAPError_Busy);
+                        err == kHAPError_Busy || err == kHAPError_InProgress);
                 return err;
             }
 
@@ -117,6 +117,13 @@ typedef struct {
          * - This is only maintained for HomeKit characteristics that support HAP Events.
          */
         bool pendingEvent : 1;
+
+        /**
+         * 1-based GATT table index of the next element in the pending event queue. 0 if this is the last element.
+         *
+         * - This is only valid while pendingEvent is set.
+         */
+        uint16_t nextPendingEvent;
     } connectionState;
 } HAPBLEGATTTableElement;
 HAP_STATIC_ASSERT(sizeof(HAPBLEGATTTableElementRef) >= sizeof(HAPBLEGATTTableElement), HAPBLEGATTTableElement);
@@ -142,7 +149,40 @@ static void ResetEventState(HAPAccessoryServerRef* server_) {
 
         gattAttribute->connectionState.centralSubscribed = false;
         gattAttribute->connectionState.pendingEvent = false;
+        gattAttribute->connectionState.nextPendingEvent = 0;
+    }
+    HAPRawBufferZero(&server->ble.pendingEvents, sizeof server->ble.pendingEvents);
+}
+
+/**
+ * Appends a GATT attribute to the pending event queue.
+ *
+ * - Has no effect if an event is already pending for the GATT attribute.
+ *
+ * @param      server_              Accessory server.
+ * @param      gattAttribute        GATT attribute.
+ */
+static void EnqueuePendingEvent(HAPAccessoryServerRef* server_, HAPBLEGATTTableElement* gattAttribute) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(gattAttribute);
+    HAPBLEGATTTableElement* gattTableElements = (HAPBLEGATTTableElement*) server->ble.storage->gattTableElements;
+    HAPPrecondition(gattAttribute >= gattTableElements);
+    size_t i = (size_t)(gattAttribute - gattTableElements);
+    HAPPrecondition(i < server->ble.storage->numGATTTableElements);
+    HAPPrecondition(i < UINT16_MAX);
+
+    if (gattAttribute->connectionState.pendingEvent) {
+        return;
+    }
+    gattAttribute->connectionState.pendingEvent = true;
+    gattAttribute->connectionState.nextPendingEvent = 0;
+    if (server->ble.pendingEvents.last) {
+        gattTableElements[server->ble.pendingEvents.last - 1].connectionState.nextPendingEvent = (uint16_t)(i + 1);
+    } else {
+        server->ble.pendingEvents.first = (uint16_t)(i + 1);
     }
+    server->ble.pendingEvents.last = (uint16_t)(i + 1);
 }
 
 /**
@@ -205,6 +245,7 @@ void HAPBLEPeripheralManagerRelease(HAPAccessoryServerRef* server_) {
     // Deregister platform callbacks.
     HAPPlatformBLEPeripheralManagerRemoveAllServices(blePeripheralManager);
     HAPPlatformBLEPeripheralManagerSetDelegate(blePeripheralManager, NULL);
+    server->ble.gattDatabase.isRetained = false;
 }
 
 static void HandleConnectedCentral(
@@ -287,23 +328,18 @@ static void SendPendingEventNotifications(HAPAccessoryServerRef* server_) {
 
     HAPError err;
 
-    for (size_t i = 0; i < server->ble.storage->numGATTTableElements; i++) {
-        HAPBLEGATTTableElement* gattAttribute = (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[i];
-        const HAPBaseCharacteristic* characteristic = gattAttribute->characteristic;
-        const HAPService* service = gattAttribute->service;
-        const HAPAccessory* accessory = gattAttribute->accessory;
-        if (!accessory) {
-            break;
-        }
-        HAPAssert(service);
-        if (!characteristic) {
-            continue;
-        }
-        if (!characteristic->properties.supportsEventNotification) {
-            HAPAssert(!gattAttribute->connectionState.centralSubscribed);
-            HAPAssert(!gattAttribute->connectionState.pendingEvent);
-            continue;
-        }
+    // Drain the pending event queue in order. Events that cannot be sent yet remain queued.
+    HAPBLEGATTTableElement* gattTableElements = (HAPBLEGATTTableElement*) server->ble.storage->gattTableElements;
+    uint16_t previous = 0;
+    for (uint16_t current = server->ble.pendingEvents.first, next; current; previous = current, current = next) {
+        HAPAssert(current <= server->ble.storage->numGATTTableElements);
+        HAPBLEGATTTableElement* gattAttribute = &gattTableElements[current - 1];
+        HAPAssert(gattAttribute->connectionState.pendingEvent);
+        next = gattAttribute->connectionState.nextPendingEvent;
+        const HAPBaseCharacteristic* characteristic = HAPNonnullVoid(gattAttribute->characteristic);
+        const HAPService* service = HAPNonnull(gattAttribute->service);
+        const HAPAccessory* accessory = HAPNonnull(gattAttribute->accessory);
+        HAPAssert(characteristic->properties.supportsEventNotification);
         if (characteristic->iid > UINT16_MAX) {
             HAPLogCharacteristicError(
                     &logObject,
@@ -320,9 +356,6 @@ static void SendPendingEventNotifications(HAPAccessoryServerRef* server_) {
         if (!gattAttribute->connectionState.centralSubscribed) {
             continue;
         }
-        if (!gattAttribute->connectionState.pendingEvent) {
-            continue;
-        }
         if (!HAPSessionIsSecured(session)) {
             HAPLogCharacteristicInfo(
                     &logObject,
@@ -370,7 +403,19 @@ static void SendPendingEventNotifications(HAPAccessoryServerRef* server_) {
             HAPAssert(err == kHAPError_OutOfResources);
             HAPFatalError();
         }
+
+        // Remove from pending event queue.
+        if (previous) {
+            gattTableElements[previous - 1].connectionState.nextPendingEvent = next;
+        } else {
+            server->ble.pendingEvents.first = next;
+        }
+        if (server->ble.pendingEvents.last == current) {
+            server->ble.pendingEvents.last = previous;
+        }
         gattAttribute->connectionState.pendingEvent = false;
+        gattAttribute->connectionState.nextPendingEvent = 0;
+        current = previous; // The predecessor of the removed element precedes the next element.
         HAPLogCharacteristicInfo(&logObject, characteristic, service, accessory, "Sent event.");
 
         err = HAPBLEAccessoryServerDidSendEventNotification(server_, characteristic, service, accessory);
@@ -382,7 +427,7 @@ static void SendPendingEventNotifications(HAPAccessoryServerRef* server_) {
 }
 
 /**
- * Gets the GATT attribute structure associated with an attribute handle.
+ * Searches the GATT table for the GATT attribute structure associated with an attribute handle.
  *
  * @param      server_              Accessory server.
  * @param      attributeHandle      GATT attribute handle.
@@ -390,7 +435,7 @@ static void SendPendingEventNotifications(HAPAccessoryServerRef* server_) {
  * @return GATT attribute structure If found.
  * @return NULL                     Otherwise.
  */
-static HAPBLEGATTTableElement* _Nullable GetGATTAttribute(
+static HAPBLEGATTTableElement* _Nullable FindGATTAttribute(
         HAPAccessoryServerRef* server_,
         HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle) {
     HAPPrecondition(server_);
@@ -423,7 +468,262 @@ static HAPBLEGATTTableElement* _Nullable GetGATTAttribute(
             return gattAttribute;
         }
     }
-    HAPLog(&logObject, "GATT attribute structure not found for handle 0x%04x", (unsigned int) attributeHandle);
+    return NULL;
+}
+
+/**
+ * Gets the GATT attribute structure associated with an attribute handle.
+ *
+ * - Uses the attribute handle index if available. Otherwise, the GATT table is searched.
+ *
+ * @param      server_              Accessory server.
+ * @param      attributeHandle      GATT attribute handle.
+ *
+ * @return GATT attribute structure If found.
+ * @return NULL                     Otherwise.
+ */
+static HAPBLEGATTTableElement* _Nullable GetGATTAttribute(
+        HAPAccessoryServerRef* server_,
+        HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(attributeHandle);
+
+    HAPBLEGATTTableElement* _Nullable gattAttribute = NULL;
+    if (server->ble.attributeHandleIndex.numHandles) {
+        HAPAssert(server->ble.storage->attributeHandleIndex);
+        if (attributeHandle >= server->ble.attributeHandleIndex.firstHandle &&
+            (size_t)(attributeHandle - server->ble.attributeHandleIndex.firstHandle) <
+                    server->ble.attributeHandleIndex.numHandles) {
+            uint16_t elementIndex = server->ble.storage->attributeHandleIndex[(
+                    size_t)(attributeHandle - server->ble.attributeHandleIndex.firstHandle)];
+            if (elementIndex) {
+                HAPAssert(elementIndex <= server->ble.storage->numGATTTableElements);
+                gattAttribute =
+                        (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[elementIndex - 1];
+            }
+        }
+#if !HAP_DISABLE_ASSERTS
+        // Consistency check against the GATT table.
+        HAPAssert(gattAttribute == FindGATTAttribute(server_, attributeHandle));
+#endif
+    } else {
+        gattAttribute = FindGATTAttribute(server_, attributeHandle);
+    }
+    if (!gattAttribute) {
+        HAPLog(&logObject, "GATT attribute structure not found for handle 0x%04x", (unsigned int) attributeHandle);
+    }
+    return gattAttribute;
+}
+
+/**
+ * Builds the attribute handle index for the registered GATT table.
+ *
+ * - If no attribute handle index storage is available or the registered attribute handles do not fit,
+ *   the index is left unused and attribute handles are resolved by searching the GATT table.
+ *
+ * @param      server_              Accessory server.
+ * @param      numGATTAttributes    Number of GATT table elements in use.
+ */
+static void BuildAttributeHandleIndex(HAPAccessoryServerRef* server_, size_t numGATTAttributes) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(numGATTAttributes <= server->ble.storage->numGATTTableElements);
+    HAPBLEAccessoryServerStorage* storage = server->ble.storage;
+
+    HAPRawBufferZero(&server->ble.attributeHandleIndex, sizeof server->ble.attributeHandleIndex);
+    if (!storage->attributeHandleIndex || !numGATTAttributes) {
+        return;
+    }
+    if (numGATTAttributes > UINT16_MAX) {
+        HAPLog(&logObject, "Too many GATT attributes for attribute handle index. Searching GATT table instead.");
+        return;
+    }
+
+    // Determine range of attribute handles.
+    HAPPlatformBLEPeripheralManagerAttributeHandle minHandle = UINT16_MAX;
+    HAPPlatformBLEPeripheralManagerAttributeHandle maxHandle = 0;
+    for (size_t i = 0; i < numGATTAttributes; i++) {
+        const HAPBLEGATTTableElement* gattAttribute =
+                (const HAPBLEGATTTableElement*) &storage->gattTableElements[i];
+        const HAPPlatformBLEPeripheralManagerAttributeHandle handles[] = { gattAttribute->valueHandle,
+                                                                           gattAttribute->cccDescriptorHandle,
+                                                                           gattAttribute->iidHandle };
+        for (size_t j = 0; j < HAPArrayCount(handles); j++) {
+            if (handles[j]) {
+                minHandle = HAPMin(minHandle, handles[j]);
+                maxHandle = HAPMax(maxHandle, handles[j]);
+            }
+        }
+    }
+    HAPAssert(minHandle <= maxHandle);
+    size_t numHandles = (size_t)(maxHandle - minHandle) + 1;
+    if (numHandles > storage->numAttributeHandleIndexElements) {
+        HAPLog(&logObject,
+               "Attribute handle index too small (%zu elements needed, %zu available). Searching GATT table instead.",
+               numHandles,
+               storage->numAttributeHandleIndexElements);
+        return;
+    }
+
+    // Link attribute handles to GATT table elements.
+    HAPRawBufferZero(storage->attributeHandleIndex, numHandles * sizeof *storage->attributeHandleIndex);
+    for (size_t i = 0; i < numGATTAttributes; i++) {
+        const HAPBLEGATTTableElement* gattAttribute =
+                (const HAPBLEGATTTableElement*) &storage->gattTableElements[i];
+        const HAPPlatformBLEPeripheralManagerAttributeHandle handles[] = { gattAttribute->valueHandle,
+                                                                           gattAttribute->cccDescriptorHandle,
+                                                                           gattAttribute->iidHandle };
+        for (size_t j = 0; j < HAPArrayCount(handles); j++) {
+            if (handles[j]) {
+                uint16_t* elementIndex = &storage->attributeHandleIndex[(size_t)(handles[j] - minHandle)];
+                HAPAssert(!*elementIndex);
+                *elementIndex = (uint16_t)(i + 1);
+            }
+        }
+    }
+    server->ble.attributeHandleIndex.firstHandle = minHandle;
+    server->ble.attributeHandleIndex.numHandles = numHandles;
+    HAPLogDebug(&logObject, "Attribute handle index covers %zu attribute handles.", numHandles);
+}
+
+/**
+ * Returns the instance ID of the HomeKit characteristic of a GATT table element.
+ *
+ * @param      server               Accessory server.
+ * @param      elementIndex         Index of the GATT table element.
+ *
+ * @return Instance ID of the HomeKit characteristic.
+ */
+HAP_RESULT_USE_CHECK
+static uint64_t GetCharacteristicIID(const HAPAccessoryServer* server, size_t elementIndex) {
+    HAPPrecondition(server);
+    HAPPrecondition(elementIndex < server->ble.storage->numGATTTableElements);
+
+    const HAPBLEGATTTableElement* gattAttribute =
+            (const HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[elementIndex];
+    HAPAssert(gattAttribute->characteristic);
+    return ((const HAPBaseCharacteristic*) gattAttribute->characteristic)->iid;
+}
+
+/**
+ * Builds the characteristic index for the registered GATT table.
+ *
+ * - If no characteristic index storage is available or the HomeKit characteristics do not fit,
+ *   the index is left unused and characteristics are resolved by searching the GATT table.
+ *
+ * @param      server_              Accessory server.
+ * @param      numGATTAttributes    Number of GATT table elements in use.
+ */
+static void BuildCharacteristicIndex(HAPAccessoryServerRef* server_, size_t numGATTAttributes) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(numGATTAttributes <= server->ble.storage->numGATTTableElements);
+    HAPBLEAccessoryServerStorage* storage = server->ble.storage;
+
+    HAPRawBufferZero(&server->ble.characteristicIndex, sizeof server->ble.characteristicIndex);
+    if (!storage->characteristicIndex) {
+        return;
+    }
+    if (numGATTAttributes > UINT16_MAX) {
+        HAPLog(&logObject, "Too many GATT attributes for characteristic index. Searching GATT table instead.");
+        return;
+    }
+
+    // Insert characteristics sorted by instance ID.
+    size_t numElements = 0;
+    for (size_t i = 0; i < numGATTAttributes; i++) {
+        const HAPBLEGATTTableElement* gattAttribute =
+                (const HAPBLEGATTTableElement*) &storage->gattTableElements[i];
+        if (!gattAttribute->characteristic) {
+            continue;
+        }
+        if (numElements == storage->numCharacteristicIndexElements) {
+            HAPLog(&logObject,
+                   "Characteristic index too small (%zu elements available). Searching GATT table instead.",
+                   storage->numCharacteristicIndexElements);
+            return;
+        }
+        uint64_t iid = ((const HAPBaseCharacteristic*) gattAttribute->characteristic)->iid;
+        size_t j = numElements;
+        for (; j && GetCharacteristicIID(server, storage->characteristicIndex[j - 1]) > iid; j--) {
+            storage->characteristicIndex[j] = storage->characteristicIndex[j - 1];
+        }
+        if (j && GetCharacteristicIID(server, storage->characteristicIndex[j - 1]) == iid) {
+            HAPLogError(
+                    &logObject,
+                    "Instance ID 0x%016llx is used multiple times. Searching GATT table instead.",
+                    (unsigned long long) iid);
+            return;
+        }
+        storage->characteristicIndex[j] = (uint16_t) i;
+        numElements++;
+    }
+    server->ble.characteristicIndex.numElements = numElements;
+    HAPLogDebug(&logObject, "Characteristic index covers %zu characteristics.", numElements);
+}
+
+/**
+ * Finds the GATT table element of a HomeKit characteristic.
+ *
+ * @param      server_              Accessory server.
+ * @param      characteristic       The characteristic.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ *
+ * @return GATT table element of the characteristic, if found. NULL otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static HAPBLEGATTTableElement* _Nullable GetCharacteristicGATTAttribute(
+        HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* characteristic_,
+        const HAPService* service,
+        const HAPAccessory* accessory) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(characteristic_);
+    const HAPBaseCharacteristic* characteristic = characteristic_;
+    HAPPrecondition(service);
+    HAPPrecondition(accessory);
+    HAPBLEAccessoryServerStorage* storage = server->ble.storage;
+
+    // Binary search characteristic index, if available.
+    if (server->ble.characteristicIndex.numElements) {
+        HAPAssert(storage->characteristicIndex);
+        size_t lo = 0;
+        size_t hi = server->ble.characteristicIndex.numElements;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            uint16_t elementIndex = storage->characteristicIndex[mid];
+            uint64_t iid = GetCharacteristicIID(server, elementIndex);
+            if (iid < characteristic->iid) {
+                lo = mid + 1;
+            } else if (iid > characteristic->iid) {
+                hi = mid;
+            } else {
+                HAPBLEGATTTableElement* gattAttribute =
+                        (HAPBLEGATTTableElement*) &storage->gattTableElements[elementIndex];
+                if (gattAttribute->characteristic == characteristic && gattAttribute->service == service &&
+                    gattAttribute->accessory == accessory) {
+                    return gattAttribute;
+                }
+                return NULL;
+            }
+        }
+        return NULL;
+    }
+
+    for (size_t i = 0; i < storage->numGATTTableElements; i++) {
+        HAPBLEGATTTableElement* gattAttribute = (HAPBLEGATTTableElement*) &storage->gattTableElements[i];
+        if (!gattAttribute->accessory) {
+            break;
+        }
+
+        if (gattAttribute->characteristic == characteristic && gattAttribute->service == service &&
+            gattAttribute->accessory == accessory) {
+            return gattAttribute;
+        }
+    }
     return NULL;
 }
 
@@ -1453,6 +1753,303 @@ static void HandleReadyToUpdateSubscribers(
     SendPendingEventNotifications(server_);
 }
 
+/**
+ * UUID of the Service Instance ID characteristic.
+ *
+ * - This characteristic contains a static value and does not use HAP-BLE procedures.
+ */
+static const HAPPlatformBLEPeripheralManagerUUID kBLECharacteristicUUID_ServiceInstanceID = {
+    { 0xD1, 0xA0, 0x83, 0x50, 0x00, 0xAA, 0xD3, 0x87, 0x17, 0x48, 0x59, 0xA7, 0x5D, 0xE9, 0x04, 0xE6 }
+};
+
+/**
+ * UUID of the Characteristic Instance ID descriptor.
+ *
+ * - This descriptor contains a static value and does not use HAP-BLE procedures.
+ */
+static const HAPPlatformBLEPeripheralManagerUUID kBLEDescriptorUUID_CharacteristicInstanceID = {
+    { 0x9A, 0x93, 0x96, 0xD7, 0xBD, 0x6A, 0xD9, 0xB5, 0x16, 0x46, 0xD2, 0x81, 0xFE, 0xF0, 0x46, 0xDC }
+};
+
+/**
+ * Gets the GATT attributes that a GATT table element is published as.
+ *
+ * @param      gattAttribute        GATT table element.
+ * @param[out] attributes           GATT attributes. Attribute handles are not filled in.
+ */
+static void GetGATTDatabaseAttributes(
+        const HAPBLEGATTTableElement* gattAttribute,
+        HAPPlatformBLEPeripheralManagerGATTAttribute
+                attributes[_Nonnull kHAPBLEGATTDatabase_NumAttributesPerGATTTableElement]) {
+    HAPPrecondition(gattAttribute);
+    HAPPrecondition(gattAttribute->service);
+    const HAPService* service = gattAttribute->service;
+    HAPPrecondition(attributes);
+
+    HAPRawBufferZero(attributes, kHAPBLEGATTDatabase_NumAttributesPerGATTTableElement * sizeof attributes[0]);
+
+    if (!gattAttribute->characteristic) {
+        // Service.
+        HAPAssert(sizeof *service->serviceType == sizeof(HAPPlatformBLEPeripheralManagerUUID));
+        attributes[0].kind = kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Service;
+        HAPRawBufferCopyBytes(&attributes[0].type, service->serviceType, sizeof attributes[0].type);
+        attributes[0]._.service.isPrimary = true;
+
+        // Service Instance ID characteristic.
+        attributes[1].kind = kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Characteristic;
+        attributes[1].type = kBLECharacteristicUUID_ServiceInstanceID;
+        attributes[1]._.characteristic.properties =
+                (HAPPlatformBLEPeripheralManagerCharacteristicProperties) { .read = true,
+                                                                            .writeWithoutResponse = false,
+                                                                            .write = false,
+                                                                            .notify = false,
+                                                                            .indicate = false };
+        HAPWriteLittleUInt16(attributes[1].constBytes, service->iid);
+        attributes[1].numConstBytes = sizeof(uint16_t);
+        attributes[1].hasConstValue = true;
+    } else {
+        const HAPBaseCharacteristic* characteristic = gattAttribute->characteristic;
+
+        // Characteristic.
+        HAPAssert(sizeof *characteristic->characteristicType == sizeof(HAPPlatformBLEPeripheralManagerUUID));
+        attributes[0].kind = kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Characteristic;
+        HAPRawBufferCopyBytes(&attributes[0].type, characteristic->characteristicType, sizeof attributes[0].type);
+        attributes[0]._.characteristic.properties = (HAPPlatformBLEPeripheralManagerCharacteristicProperties) {
+            .read = true,
+            .writeWithoutResponse = false,
+            .write = true,
+            .notify = false,
+            .indicate = characteristic->properties.supportsEventNotification
+        };
+
+        // Characteristic Instance ID descriptor.
+        attributes[1].kind = kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Descriptor;
+        attributes[1].type = kBLEDescriptorUUID_CharacteristicInstanceID;
+        attributes[1]._.descriptor.properties =
+                (HAPPlatformBLEPeripheralManagerDescriptorProperties) { .read = true, .write = false };
+        HAPWriteLittleUInt16(attributes[1].constBytes, characteristic->iid);
+        attributes[1].numConstBytes = sizeof(uint16_t);
+        attributes[1].hasConstValue = true;
+    }
+}
+
+/**
+ * Stores the attribute handles of published GATT attributes in the GATT table element that they belong to.
+ *
+ * @param      gattAttribute        GATT table element.
+ * @param      attributes           Published GATT attributes of the GATT table element.
+ */
+static void SetGATTDatabaseAttributeHandles(
+        HAPBLEGATTTableElement* gattAttribute,
+        const HAPPlatformBLEPeripheralManagerGATTAttribute
+                attributes[_Nonnull kHAPBLEGATTDatabase_NumAttributesPerGATTTableElement]) {
+    HAPPrecondition(gattAttribute);
+    HAPPrecondition(attributes);
+
+    if (!gattAttribute->characteristic) {
+        HAPAssert(attributes[1].kind == kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Characteristic);
+        gattAttribute->iidHandle = attributes[1]._.characteristic.valueHandle;
+    } else {
+        HAPAssert(attributes[0].kind == kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Characteristic);
+        HAPAssert(attributes[1].kind == kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Descriptor);
+        gattAttribute->valueHandle = attributes[0]._.characteristic.valueHandle;
+        gattAttribute->cccDescriptorHandle = attributes[0]._.characteristic.cccDescriptorHandle;
+        gattAttribute->iidHandle = attributes[1]._.descriptor.descriptorHandle;
+    }
+}
+
+/**
+ * Publishes a GATT attribute through the BLE peripheral manager and fills in its attribute handles.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      attribute            GATT attribute.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If there are not enough resources to publish the GATT attribute.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError AddGATTDatabaseAttribute(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerGATTAttribute* attribute) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(attribute);
+
+    switch (attribute->kind) {
+        case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Service: {
+            return HAPPlatformBLEPeripheralManagerAddService(
+                    blePeripheralManager, &attribute->type, attribute->_.service.isPrimary);
+        }
+        case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Characteristic: {
+            HAPPlatformBLEPeripheralManagerCharacteristicProperties properties =
+                    attribute->_.characteristic.properties;
+            return HAPPlatformBLEPeripheralManagerAddCharacteristic(
+                    blePeripheralManager,
+                    &attribute->type,
+                    properties,
+                    attribute->hasConstValue ? attribute->constBytes : NULL,
+                    attribute->numConstBytes,
+                    &attribute->_.characteristic.valueHandle,
+                    properties.notify || properties.indicate ? &attribute->_.characteristic.cccDescriptorHandle :
+                                                                NULL);
+        }
+        case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Descriptor: {
+            return HAPPlatformBLEPeripheralManagerAddDescriptor(
+                    blePeripheralManager,
+                    &attribute->type,
+                    attribute->_.descriptor.properties,
+                    attribute->hasConstValue ? attribute->constBytes : NULL,
+                    attribute->numConstBytes,
+                    &attribute->_.descriptor.descriptorHandle);
+        }
+    }
+    HAPFatalError();
+}
+
+/**
+ * Computes the fingerprint of a GATT database.
+ *
+ * - Only the layout is covered, i.e., the kinds, types, properties and constant values of the attributes in order.
+ *
+ * @param      attributes           GATT attributes.
+ * @param      numAttributes        Number of GATT attributes.
+ * @param[out] fingerprint          Fingerprint of the GATT database.
+ */
+static void GetGATTDatabaseFingerprint(
+        const HAPPlatformBLEPeripheralManagerGATTAttribute* attributes,
+        size_t numAttributes,
+        HAPPlatformBLEPeripheralManagerDatabaseFingerprint* fingerprint) {
+    HAPPrecondition(attributes);
+    HAPPrecondition(fingerprint);
+
+    uint8_t digest[SHA256_BYTES];
+    HAPRawBufferZero(digest, sizeof digest);
+    for (size_t i = 0; i < numAttributes; i++) {
+        const HAPPlatformBLEPeripheralManagerGATTAttribute* attribute = &attributes[i];
+
+        // Format: <digest> <kind> <type> <properties> <hasConstValue> <numConstBytes> <constBytes>
+        uint8_t bytes[sizeof digest + 1 + sizeof attribute->type + 1 + 1 + 1 + sizeof attribute->constBytes];
+        HAPRawBufferZero(bytes, sizeof bytes);
+        uint8_t* b = bytes;
+        HAPRawBufferCopyBytes(b, digest, sizeof digest);
+        b += sizeof digest;
+        *b++ = attribute->kind;
+        HAPRawBufferCopyBytes(b, attribute->type.bytes, sizeof attribute->type.bytes);
+        b += sizeof attribute->type.bytes;
+        switch (attribute->kind) {
+            case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Service: {
+                *b++ = (uint8_t)(attribute->_.service.isPrimary ? 1U << 0U : 0U);
+            } break;
+            case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Characteristic: {
+                HAPPlatformBLEPeripheralManagerCharacteristicProperties properties =
+                        attribute->_.characteristic.properties;
+                *b++ = (uint8_t)(
+                        (properties.read ? 1U << 0U : 0U) | (properties.writeWithoutResponse ? 1U << 1U : 0U) |
+                        (properties.write ? 1U << 2U : 0U) | (properties.notify ? 1U << 3U : 0U) |
+                        (properties.indicate ? 1U << 4U : 0U));
+            } break;
+            case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Descriptor: {
+                HAPPlatformBLEPeripheralManagerDescriptorProperties properties = attribute->_.descriptor.properties;
+                *b++ = (uint8_t)((properties.read ? 1U << 0U : 0U) | (properties.write ? 1U << 1U : 0U));
+            } break;
+            default: {
+                HAPFatalError();
+            }
+        }
+        *b++ = (uint8_t)(attribute->hasConstValue ? 1U : 0U);
+        HAPAssert(attribute->numConstBytes <= sizeof attribute->constBytes);
+        *b++ = attribute->numConstBytes;
+        HAPRawBufferCopyBytes(b, attribute->constBytes, attribute->numConstBytes);
+        HAP_sha256(digest, bytes, sizeof bytes);
+    }
+    HAPAssert(sizeof fingerprint->bytes <= sizeof digest);
+    HAPRawBufferCopyBytes(fingerprint->bytes, digest, sizeof fingerprint->bytes);
+}
+
+/**
+ * Publishes the GATT database in a single call.
+ *
+ * - The fingerprint of the GATT database is persisted so that unchanged GATT databases can be detected
+ *   across reboots.
+ *
+ * @param      server_              Accessory server.
+ * @param      numGATTAttributes    Number of GATT table elements in use.
+ */
+static void PublishGATTDatabase(HAPAccessoryServerRef* server_, size_t numGATTAttributes) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(server->platform.ble.blePeripheralManager);
+    HAPPlatformBLEPeripheralManagerRef blePeripheralManager = server->platform.ble.blePeripheralManager;
+    HAPBLEAccessoryServerStorage* storage = HAPNonnull(server->ble.storage);
+    HAPPrecondition(storage->gattDatabaseAttributes);
+    HAPPlatformBLEPeripheralManagerGATTAttribute* attributes = storage->gattDatabaseAttributes;
+    size_t numAttributes = numGATTAttributes * kHAPBLEGATTDatabase_NumAttributesPerGATTTableElement;
+    HAPPrecondition(numAttributes <= storage->numGATTDatabaseAttributes);
+
+    HAPError err;
+
+    // Compute GATT database.
+    for (size_t i = 0; i < numGATTAttributes; i++) {
+        GetGATTDatabaseAttributes(
+                (const HAPBLEGATTTableElement*) &storage->gattTableElements[i],
+                &attributes[i * kHAPBLEGATTDatabase_NumAttributesPerGATTTableElement]);
+    }
+    HAPPlatformBLEPeripheralManagerDatabaseFingerprint fingerprint;
+    GetGATTDatabaseFingerprint(attributes, numAttributes, &fingerprint);
+
+    // Compare with the fingerprint of the previously published GATT database.
+    bool isUnchanged = false;
+    bool found;
+    size_t numBytes;
+    HAPPlatformBLEPeripheralManagerDatabaseFingerprint storedFingerprint;
+    err = HAPPlatformKeyValueStoreGet(
+            server->platform.keyValueStore,
+            kHAPKeyValueStoreDomain_Configuration,
+            kHAPKeyValueStoreKey_Configuration_BLEGATTDatabaseFingerprint,
+            storedFingerprint.bytes,
+            sizeof storedFingerprint.bytes,
+            &numBytes,
+            &found);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        HAPLogError(&logObject, "Loading GATT database fingerprint failed. Assuming that it changed.");
+    } else if (found && numBytes == sizeof storedFingerprint.bytes) {
+        isUnchanged = HAPRawBufferAreEqual(storedFingerprint.bytes, fingerprint.bytes, sizeof fingerprint.bytes);
+    }
+
+    // Publish GATT database.
+    err = HAPPlatformBLEPeripheralManagerPublishDatabase(
+            blePeripheralManager, &fingerprint, isUnchanged, attributes, numAttributes);
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        HAPFatalError();
+    }
+    for (size_t i = 0; i < numGATTAttributes; i++) {
+        SetGATTDatabaseAttributeHandles(
+                (HAPBLEGATTTableElement*) &storage->gattTableElements[i],
+                &attributes[i * kHAPBLEGATTDatabase_NumAttributesPerGATTTableElement]);
+    }
+    server->ble.gattDatabase.isRetained = true;
+    HAPLogInfo(
+            &logObject,
+            "Published GATT database (%zu attributes, %s).",
+            numAttributes,
+            isUnchanged ? "unchanged" : "changed");
+
+    // Persist fingerprint.
+    if (!isUnchanged) {
+        err = HAPPlatformKeyValueStoreSet(
+                server->platform.keyValueStore,
+                kHAPKeyValueStoreDomain_Configuration,
+                kHAPKeyValueStoreKey_Configuration_BLEGATTDatabaseFingerprint,
+                fingerprint.bytes,
+                sizeof fingerprint.bytes);
+        if (err) {
+            HAPAssert(err == kHAPError_Unknown);
+            HAPLogError(&logObject, "Saving GATT database fingerprint failed.");
+        }
+    }
+}
+
 void HAPBLEPeripheralManagerRegister(HAPAccessoryServerRef* server_) {
     HAPPrecondition(server_);
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
@@ -1467,7 +2064,9 @@ void HAPBLEPeripheralManagerRegister(HAPAccessoryServerRef* server_) {
     HAPRawBufferZero(
             server->ble.storage->gattTableElements,
             server->ble.storage->numGATTTableElements * sizeof *server->ble.storage->gattTableElements);
-    HAPPlatformBLEPeripheralManagerRemoveAllServices(blePeripheralManager);
+    HAPRawBufferZero(&server->ble.attributeHandleIndex, sizeof server->ble.attributeHandleIndex);
+    HAPRawBufferZero(&server->ble.characteristicIndex, sizeof server->ble.characteristicIndex);
+    HAPRawBufferZero(&server->ble.pendingEvents, sizeof server->ble.pendingEvents);
 
     // Set delegate.
     HAPPlatformBLEPeripheralManagerSetDelegate(
@@ -1480,7 +2079,7 @@ void HAPBLEPeripheralManagerRegister(HAPAccessoryServerRef* server_) {
                                                                .handleReadyToUpdateSubscribers =
                                                                        HandleReadyToUpdateSubscribers });
 
-    // Register DB.
+    // Map GATT table.
     size_t o = 0;
     if (accessory->services) {
         for (size_t i = 0; accessory->services[i]; i++) {
@@ -1500,47 +2099,8 @@ void HAPBLEPeripheralManagerRegister(HAPAccessoryServerRef* server_) {
                     (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[o];
             gattAttribute->accessory = accessory;
             gattAttribute->service = service;
-
-            // Register service.
-            HAPAssert(sizeof *service->serviceType == sizeof(HAPPlatformBLEPeripheralManagerUUID));
-            err = HAPPlatformBLEPeripheralManagerAddService(
-                    blePeripheralManager,
-                    (const HAPPlatformBLEPeripheralManagerUUID*) service->serviceType,
-                    /* isPrimary: */ true);
-            if (err) {
-                HAPAssert(err == kHAPError_OutOfResources);
-                HAPFatalError();
-            }
-
-            // Register Service Instance ID characteristic.
-            // This characteristic contains a static value and does not use HAP-BLE procedures.
-            static const HAPPlatformBLEPeripheralManagerUUID kBLECharacteristicUUID_ServiceInstanceID = {
-                { 0xD1, 0xA0, 0x83, 0x50, 0x00, 0xAA, 0xD3, 0x87, 0x17, 0x48, 0x59, 0xA7, 0x5D, 0xE9, 0x04, 0xE6 }
-            };
-            uint8_t iid[2];
-            HAPWriteLittleUInt16(iid, service->iid);
-            err = HAPPlatformBLEPeripheralManagerAddCharacteristic(
-                    blePeripheralManager,
-                    &kBLECharacteristicUUID_ServiceInstanceID,
-                    (HAPPlatformBLEPeripheralManagerCharacteristicProperties) { .read = true,
-                                                                                .writeWithoutResponse = false,
-                                                                                .write = false,
-                                                                                .notify = false,
-                                                                                .indicate = false },
-                    iid,
-                    sizeof iid,
-                    &gattAttribute->iidHandle,
-                    /* cccDescriptorHandle: */ NULL);
-            if (err) {
-                HAPAssert(err == kHAPError_OutOfResources);
-                HAPFatalError();
-            }
-
-            // Finalize GATT attribute.
-            HAPLogServiceInfo(&logObject, service, accessory, "(service)");
             o++;
 
-            // Register characteristics.
             if (service->characteristics) {
                 for (size_t j = 0; service->characteristics[j]; j++) {
                     const HAPBaseCharacteristic* characteristic = service->characteristics[j];
@@ -1559,79 +2119,62 @@ void HAPBLEPeripheralManagerRegister(HAPAccessoryServerRef* server_) {
                     gattAttribute->accessory = accessory;
                     gattAttribute->service = service;
                     gattAttribute->characteristic = characteristic;
-
-                    // Register characteristic.
-                    HAPAssert(
-                            sizeof *characteristic->characteristicType == sizeof(HAPPlatformBLEPeripheralManagerUUID));
-                    err = HAPPlatformBLEPeripheralManagerAddCharacteristic(
-                            blePeripheralManager,
-                            (const HAPPlatformBLEPeripheralManagerUUID*) characteristic->characteristicType,
-                            (HAPPlatformBLEPeripheralManagerCharacteristicProperties) {
-                                    .read = true,
-                                    .writeWithoutResponse = false,
-                                    .write = true,
-                                    .notify = false,
-                                    .indicate = characteristic->properties.supportsEventNotification },
-                            NULL,
-                            0,
-                            &gattAttribute->valueHandle,
-                            characteristic->properties.supportsEventNotification ? &gattAttribute->cccDescriptorHandle :
-                                                                                   NULL);
-                    if (err) {
-                        HAPAssert(err == kHAPError_OutOfResources);
-                        HAPFatalError();
-                    }
-
-                    // Register Characteristic Instance ID descriptor.
-                    // This descriptor contains a static value and does not use HAP-BLE procedures.
-                    static const HAPPlatformBLEPeripheralManagerUUID kBLEDescriptorUUID_CharacteristicInstanceID = {
-                        { 0x9A,
-                          0x93,
-                          0x96,
-                          0xD7,
-                          0xBD,
-                          0x6A,
-                          0xD9,
-                          0xB5,
-                          0x16,
-                          0x46,
-                          0xD2,
-                          0x81,
-                          0xFE,
-                          0xF0,
-                          0x46,
-                          0xDC }
-                    };
-                    HAPWriteLittleUInt16(iid, characteristic->iid);
-                    err = HAPPlatformBLEPeripheralManagerAddDescriptor(
-                            blePeripheralManager,
-                            &kBLEDescriptorUUID_CharacteristicInstanceID,
-                            (HAPPlatformBLEPeripheralManagerDescriptorProperties) { .read = true, .write = false },
-                            iid,
-                            sizeof iid,
-                            &gattAttribute->iidHandle);
-                    if (err) {
-                        HAPAssert(err == kHAPError_OutOfResources);
-                        HAPFatalError();
-                    }
-
-                    // Finalize GATT attribute.
-                    HAPLogCharacteristicInfo(
-                            &logObject,
-                            characteristic,
-                            service,
-                            accessory,
-                            "val %04x / iid %04x",
-                            gattAttribute->valueHandle,
-                            gattAttribute->iidHandle);
                     o++;
                 }
             }
         }
     }
 
-    // Finalize GATT database.
-    HAPPlatformBLEPeripheralManagerPublishServices(blePeripheralManager);
+    // Register DB.
+    if (server->ble.storage->gattDatabaseAttributes &&
+        server->ble.storage->numGATTDatabaseAttributes >= o * kHAPBLEGATTDatabase_NumAttributesPerGATTTableElement) {
+        PublishGATTDatabase(server_, o);
+    } else {
+        if (server->ble.storage->numGATTDatabaseAttributes) {
+            HAPLog(&logObject,
+                   "GATT database storage not large enough (%zu / %zu attributes). Registering attributes one by one.",
+                   server->ble.storage->numGATTDatabaseAttributes,
+                   o * kHAPBLEGATTDatabase_NumAttributesPerGATTTableElement);
+        }
+        HAPPlatformBLEPeripheralManagerRemoveAllServices(blePeripheralManager);
+        server->ble.gattDatabase.isRetained = false;
+        for (size_t i = 0; i < o; i++) {
+            HAPBLEGATTTableElement* gattAttribute =
+                    (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[i];
+            HAPPlatformBLEPeripheralManagerGATTAttribute
+                    attributes[kHAPBLEGATTDatabase_NumAttributesPerGATTTableElement];
+            GetGATTDatabaseAttributes(gattAttribute, attributes);
+            for (size_t j = 0; j < HAPArrayCount(attributes); j++) {
+                err = AddGATTDatabaseAttribute(blePeripheralManager, &attributes[j]);
+                if (err) {
+                    HAPAssert(err == kHAPError_OutOfResources);
+                    HAPFatalError();
+                }
+            }
+            SetGATTDatabaseAttributeHandles(gattAttribute, attributes);
+        }
+        HAPPlatformBLEPeripheralManagerPublishServices(blePeripheralManager);
+    }
+
+    // Finalize GATT table.
+    for (size_t i = 0; i < o; i++) {
+        const HAPBLEGATTTableElement* gattAttribute =
+                (const HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[i];
+        if (!gattAttribute->characteristic) {
+            HAPLogServiceInfo(&logObject, gattAttribute->service, accessory, "(service)");
+        } else {
+            HAPLogCharacteristicInfo(
+                    &logObject,
+                    gattAttribute->characteristic,
+                    gattAttribute->service,
+                    accessory,
+                    "val %04x / iid %04x",
+                    gattAttribute->valueHandle,
+                    gattAttribute->iidHandle);
+        }
+    }
+    BuildAttributeHandleIndex(server_, o);
+    BuildCharacteristicIndex(server_, o);
 }
 
 void HAPBLEPeripheralManagerRaiseEvent(
@@ -1640,27 +2183,20 @@ void HAPBLEPeripheralManagerRaiseEvent(
         const HAPService* service,
         const HAPAccessory* accessory) {
     HAPPrecondition(server_);
-    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
     HAPPrecondition(characteristic_);
     const HAPBaseCharacteristic* characteristic = characteristic_;
     HAPPrecondition(service);
     HAPPrecondition(accessory);
 
-    for (size_t i = 0; i < server->ble.storage->numGATTTableElements; i++) {
-        HAPBLEGATTTableElement* gattAttribute = (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[i];
-        if (!gattAttribute->accessory) {
-            break;
-        }
-
-        if (gattAttribute->characteristic == characteristic && gattAttribute->service == service &&
-            gattAttribute->accessory == accessory) {
-            HAPLogCharacteristicInfo(&logObject, characteristic, service, accessory, "Scheduling event.");
-            gattAttribute->connectionState.pendingEvent = true;
-            SendPendingEventNotifications(server_);
-            return;
-        }
+    HAPBLEGATTTableElement* _Nullable gattAttribute =
+            GetCharacteristicGATTAttribute(server_, characteristic_, service, accessory);
+    if (!gattAttribute) {
+        HAPLogCharacteristic(&logObject, characteristic, service, accessory, "GATT attribute structure not found.");
+        return;
     }
-    HAPLogCharacteristic(&logObject, characteristic, service, accessory, "GATT attribute structure not found.");
+    HAPLogCharacteristicInfo(&logObject, characteristic, service, accessory, "Scheduling event.");
+    EnqueuePendingEvent(server_, HAPNonnull(gattAttribute));
+    SendPendingEventNotifications(server_);
 }
 
 void HAPBLEPeripheralManagerHandleSessionAccept(HAPAccessoryServerRef* server_, HAPSessionRef* session) {
@@ -278,7 +278,8 @@ static HAPError HAPBLEProcedureProcessTransaction(HAPBLEProcedureRef* bleProcedu
             DestroyRequestBodyAndCreateResponseBodyWriter(bleProcedure_, &writer);
 
             // Serialize HAP-Service-Signature-Read-Response.
-            err = HAPBLEServiceGetSignatureReadResponse(request.iid == iid ? service : NULL, &writer);
+            err = HAPBLEServiceGetSignatureReadResponse(
+                    bleProcedure->server, request.iid == iid ? service : NULL, &writer);
             if (err) {
                 HAPAssert(err == kHAPError_OutOfResources);
                 SEND_ERROR_AND_RETURN(kHAPBLEPDUStatus_InvalidRequest);
@@ -326,7 +327,7 @@ static HAPError HAPBLEProcedureProcessTransaction(HAPBLEProcedureRef* bleProcedu
             DestroyRequestBodyAndCreateResponseBodyWriter(bleProcedure_, &writer);
 
             // Serialize HAP-Characteristic-Signature-Read-Response.
-            err = HAPBLECharacteristicGetSignatureReadResponse(characteristic, service, &writer);
+            err = HAPBLECharacteristicGetSignatureReadResponse(bleProcedure->server, characteristic, service, &writer);
             if (err) {
                 HAPAssert(err == kHAPError_OutOfResources);
                 SEND_ERROR_AND_RETURN(kHAPBLEPDUStatus_InvalidRequest);
@@ -374,7 +375,7 @@ static HAPError HAPBLEProcedureProcessTransaction(HAPBLEProcedureRef* bleProcedu
 
             // Handle HAP-Characteristic-Configuration-Request.
             err = HAPBLECharacteristicHandleConfigurationRequest(
-                    characteristic, service, accessory, &request.bodyReader, server->platform.keyValueStore);
+                    bleProcedure->server, characteristic, service, accessory, &request.bodyReader);
             if (err) {
                 HAPAssert(err == kHAPError_Unknown || err == kHAPError_InvalidData);
                 HAPLogCharacteristic(
@@ -394,9 +395,9 @@ static HAPError HAPBLEProcedureProcessTransaction(HAPBLEProcedureRef* bleProcedu
 
             // Serialize HAP-Characteristic-Configuration-Response.
             err = HAPBLECharacteristicGetConfigurationResponse(
-                    characteristic, service, accessory, &writer, server->platform.keyValueStore);
+                    bleProcedure->server, characteristic, service, accessory, &writer);
             if (err) {
-                HAPAssert(err == kHAPError_Unknown || err == kHAPError_OutOfResources);
+                HAPAssert(err == kHAPError_OutOfResources);
                 SEND_ERROR_AND_RETURN(kHAPBLEPDUStatus_InvalidRequest);
             }
             SEND_RESPONSE_AND_RETURN(&writer);
@@ -879,6 +880,17 @@ static HAPError HAPBLEProcedureProcessTransaction(HAPBLEProcedureRef* bleProcedu
             server->ble.connection.write.characteristic = NULL;
             server->ble.connection.write.service = NULL;
             server->ble.connection.write.accessory = NULL;
+            if (err == kHAPError_InProgress) {
+                // The HAP-BLE response is read right after the request has been written.
+                HAPLogCharacteristic(
+                        &logObject,
+                        characteristic,
+                        service,
+                        accessory,
+                        "%s cannot be deferred over Bluetooth LE. Reporting as busy.",
+                        "HAP-Characteristic-Write-Request");
+                err = kHAPError_Busy;
+            }
             if (err == kHAPError_NotAuthorized) {
                 HAPLogCharacteristic(
                         &logObject,
@@ -1028,6 +1040,17 @@ static HAPError HAPBLEProcedureProcessTransaction(HAPBLEProcedureRef* bleProcedu
             // Serialize HAP-Characteristic-Read-Response.
             err = HAPBLECharacteristicReadAndSerializeValue(
                     bleProcedure->server, bleProcedure->session, characteristic, service, accessory, &writer);
+            if (err == kHAPError_InProgress) {
+                // The HAP-BLE response is read right after the request has been written.
+                HAPLogCharacteristic(
+                        &logObject,
+                        characteristic,
+                        service,
+                        accessory,
+                        "%s cannot be deferred over Bluetooth LE. Reporting as busy.",
+                        "HAP-Characteristic-Read-Request");
+                err = kHAPError_Busy;
+            }
             if (err) {
                 HAPAssert(
                         err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
@@ -35,7 +35,6 @@ HAPError HAPBLEProtocolHandleConfigurationRequest(
         bool* didRequestGetAll,
         HAPPlatformKeyValueStoreRef keyValueStore) {
     HAPPrecondition(server_);
-    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
     HAPPrecondition(session);
     HAPPrecondition(service);
     HAPPrecondition(accessory);
@@ -98,7 +97,7 @@ HAPError HAPBLEProtocolHandleConfigurationRequest(
             return err;
         }
     } else if (advertisingID) {
-        err = HAPBLEAccessoryServerBroadcastSetAdvertisingID(server->platform.keyValueStore, advertisingID);
+        err = HAPBLEAccessoryServerBroadcastSetAdvertisingID(server_, advertisingID);
         if (err) {
             HAPAssert(err == kHAPError_Unknown);
             return err;
@@ -148,11 +147,7 @@ HAPError HAPBLEProtocolGetConfigurationResponse(
 
     // HAP-Param-Current-State-Number.
     HAPBLEAccessoryServerGSN gsn;
-    err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
+    HAPBLEAccessoryServerGetGSN(server_, &gsn);
     uint8_t gsnBytes[] = { HAPExpandLittleUInt16(gsn.gsn) };
     err = HAPTLVWriterAppend(
             responseWriter,
@@ -185,8 +180,7 @@ HAPError HAPBLEProtocolGetConfigurationResponse(
     uint16_t keyExpirationGSN;
     HAPBLEAccessoryServerBroadcastEncryptionKey broadcastKey;
     HAPDeviceID advertisingID;
-    err = HAPBLEAccessoryServerBroadcastGetParameters(
-            server->platform.keyValueStore, &keyExpirationGSN, &broadcastKey, &advertisingID);
+    err = HAPBLEAccessoryServerBroadcastGetParameters(server_, &keyExpirationGSN, &broadcastKey, &advertisingID);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return err;
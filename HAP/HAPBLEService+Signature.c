@@ -7,11 +7,27 @@
 #include "HAP+Internal.h"
 
 HAP_RESULT_USE_CHECK
-HAPError HAPBLEServiceGetSignatureReadResponse(const HAPService* _Nullable service, HAPTLVWriterRef* responseWriter) {
+HAPError HAPBLEServiceGetSignatureReadResponse(
+        const HAPAccessoryServerRef* server,
+        const HAPService* _Nullable service,
+        HAPTLVWriterRef* responseWriter) {
+    HAPPrecondition(server);
     HAPPrecondition(responseWriter);
 
     HAPError err;
 
+    if (service) {
+        bool found;
+        err = HAPBLESignatureCacheGet(server, service->iid, responseWriter, &found);
+        if (err) {
+            HAPAssert(err == kHAPError_OutOfResources);
+            return err;
+        }
+        if (found) {
+            return kHAPError_None;
+        }
+    }
+
     err = HAPBLEPDUTLVSerializeHAPServiceProperties(service, responseWriter);
     if (err) {
         HAPAssert(err == kHAPError_OutOfResources);
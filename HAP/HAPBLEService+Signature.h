@@ -20,6 +20,9 @@ extern "C" {
 /**
  * Serializes the body of a HAP-Service-Signature-Read-Response.
  *
+ * - If the signature has been cached when the accessory server was started, the cached signature is copied.
+ *
+ * @param      server               Accessory server.
  * @param      service              Service. NULL if the request had an invalid IID.
  * @param      responseWriter       Writer to serialize Service Signature into.
  *
@@ -30,7 +33,10 @@ extern "C" {
  *      Section 7.3.4.13 HAP-Service-Signature-Read-Response
  */
 HAP_RESULT_USE_CHECK
-HAPError HAPBLEServiceGetSignatureReadResponse(const HAPService* _Nullable service, HAPTLVWriterRef* responseWriter);
+HAPError HAPBLEServiceGetSignatureReadResponse(
+        const HAPAccessoryServerRef* server,
+        const HAPService* _Nullable service,
+        HAPTLVWriterRef* responseWriter);
 
 #if __has_feature(nullability)
 #pragma clang assume_nonnull end
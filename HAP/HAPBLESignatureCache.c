@@ -0,0 +1,231 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+
+static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .category = "BLESignatureCache" };
+
+/**
+ * Number of bytes of a signature cache index entry.
+ *
+ * Format:
+ * - Instance ID (2 bytes, little endian).
+ * - Offset of the serialized signature in the signature buffer (2 bytes, little endian).
+ * - Length of the serialized signature (2 bytes, little endian).
+ * - Type of the last TLV item of the serialized signature (1 byte).
+ */
+#define kHAPBLESignatureCache_NumEntryBytes ((size_t) 7)
+
+/**
+ * Serializes a signature into the signature buffer and appends an index entry for it.
+ *
+ * @param      server_              Accessory server.
+ * @param      bytes                Signature buffer.
+ * @param      maxBytes             Capacity of signature buffer.
+ * @param[in,out] numEntries        Number of index entries.
+ * @param[in,out] numBytes          Length of signature buffer that is in use.
+ * @param      characteristic       Characteristic. NULL to serialize the signature of the service.
+ * @param      service              The service that contains the characteristic.
+ *
+ * @return true                     If the signature has been cached.
+ * @return false                    If the signature does not fit into the signature buffer.
+ */
+HAP_RESULT_USE_CHECK
+static bool CacheSignature(
+        HAPAccessoryServerRef* server_,
+        uint8_t* bytes,
+        size_t maxBytes,
+        size_t* numEntries,
+        size_t* numBytes,
+        const HAPCharacteristic* _Nullable characteristic,
+        const HAPService* service) {
+    HAPPrecondition(server_);
+    HAPPrecondition(bytes);
+    HAPPrecondition(numEntries);
+    HAPPrecondition(numBytes);
+    HAPPrecondition(*numBytes <= maxBytes);
+    HAPPrecondition(service);
+
+    HAPError err;
+
+    uint64_t iid;
+    HAPTLVWriterRef writer;
+    HAPTLVWriterCreate(&writer, &bytes[*numBytes], maxBytes - *numBytes);
+    if (characteristic) {
+        iid = ((const HAPBaseCharacteristic*) characteristic)->iid;
+        err = HAPBLECharacteristicGetSignatureReadResponse(server_, characteristic, service, &writer);
+    } else {
+        iid = service->iid;
+        err = HAPBLEServiceGetSignatureReadResponse(server_, service, &writer);
+    }
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        return false;
+    }
+    void* signatureBytes;
+    size_t numSignatureBytes;
+    HAPTLVWriterGetBuffer(&writer, &signatureBytes, &numSignatureBytes);
+    HAPAssert(iid <= UINT16_MAX);
+    HAPAssert(*numBytes + numSignatureBytes <= UINT16_MAX);
+
+    uint8_t* entryBytes = &bytes[*numEntries * kHAPBLESignatureCache_NumEntryBytes];
+    HAPWriteLittleUInt16(&entryBytes[0], iid);
+    HAPWriteLittleUInt16(&entryBytes[2], *numBytes);
+    HAPWriteLittleUInt16(&entryBytes[4], numSignatureBytes);
+    entryBytes[6] = (uint8_t)((const HAPTLVWriter*) &writer)->lastType;
+    (*numEntries)++;
+    *numBytes += numSignatureBytes;
+    return true;
+}
+
+void HAPBLESignatureCachePrepare(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(server->ble.storage);
+    HAPBLEAccessoryServerStorage* storage = server->ble.storage;
+    HAPPrecondition(server->primaryAccessory);
+    const HAPAccessory* accessory = server->primaryAccessory;
+
+    // Signatures are serialized on every request while the cache is empty.
+    server->ble.signatureCache.numEntries = 0;
+    if (!storage->signatureBuffer.bytes) {
+        return;
+    }
+    uint8_t* bytes = storage->signatureBuffer.bytes;
+    size_t maxBytes = HAPMin(storage->signatureBuffer.numBytes, (size_t) UINT16_MAX);
+
+    // Reserve index.
+    size_t numSignatures = 0;
+    if (accessory->services) {
+        for (size_t i = 0; accessory->services[i]; i++) {
+            const HAPService* service = accessory->services[i];
+            numSignatures++;
+            if (service->characteristics) {
+                for (size_t j = 0; service->characteristics[j]; j++) {
+                    numSignatures++;
+                }
+            }
+        }
+    }
+    if (numSignatures * kHAPBLESignatureCache_NumEntryBytes > maxBytes) {
+        HAPLog(&logObject,
+               "Signature buffer too small (%zu bytes needed for index, %zu available). Not caching signatures.",
+               numSignatures * kHAPBLESignatureCache_NumEntryBytes,
+               maxBytes);
+        return;
+    }
+
+    // Serialize signatures.
+    size_t numEntries = 0;
+    size_t numBytes = numSignatures * kHAPBLESignatureCache_NumEntryBytes;
+    if (accessory->services) {
+        for (size_t i = 0; accessory->services[i]; i++) {
+            const HAPService* service = accessory->services[i];
+            if (!CacheSignature(server_, bytes, maxBytes, &numEntries, &numBytes, NULL, service)) {
+                HAPLogService(&logObject, service, accessory, "Signature does not fit into signature buffer.");
+            }
+            if (service->characteristics) {
+                for (size_t j = 0; service->characteristics[j]; j++) {
+                    const HAPCharacteristic* characteristic = service->characteristics[j];
+                    if (!CacheSignature(server_, bytes, maxBytes, &numEntries, &numBytes, characteristic, service)) {
+                        HAPLogCharacteristic(
+                                &logObject,
+                                characteristic,
+                                service,
+                                accessory,
+                                "Signature does not fit into signature buffer.");
+                    }
+                }
+            }
+        }
+    }
+
+    // Sort index by instance ID.
+    for (size_t i = 1; i < numEntries; i++) {
+        uint8_t entryBytes[kHAPBLESignatureCache_NumEntryBytes];
+        HAPRawBufferCopyBytes(
+                entryBytes, &bytes[i * kHAPBLESignatureCache_NumEntryBytes], kHAPBLESignatureCache_NumEntryBytes);
+        uint16_t iid = HAPReadLittleUInt16(&entryBytes[0]);
+        size_t j = i;
+        for (; j && HAPReadLittleUInt16(&bytes[(j - 1) * kHAPBLESignatureCache_NumEntryBytes]) > iid; j--) {
+            HAPRawBufferCopyBytes(
+                    &bytes[j * kHAPBLESignatureCache_NumEntryBytes],
+                    &bytes[(j - 1) * kHAPBLESignatureCache_NumEntryBytes],
+                    kHAPBLESignatureCache_NumEntryBytes);
+        }
+        HAPRawBufferCopyBytes(
+                &bytes[j * kHAPBLESignatureCache_NumEntryBytes], entryBytes, kHAPBLESignatureCache_NumEntryBytes);
+    }
+    for (size_t i = 1; i < numEntries; i++) {
+        if (HAPReadLittleUInt16(&bytes[(i - 1) * kHAPBLESignatureCache_NumEntryBytes]) ==
+            HAPReadLittleUInt16(&bytes[i * kHAPBLESignatureCache_NumEntryBytes])) {
+            HAPLogError(
+                    &logObject,
+                    "Instance ID 0x%04x is used multiple times. Not caching signatures.",
+                    HAPReadLittleUInt16(&bytes[i * kHAPBLESignatureCache_NumEntryBytes]));
+            return;
+        }
+    }
+
+    server->ble.signatureCache.numEntries = numEntries;
+    HAPLogDebug(
+            &logObject,
+            "Cached %zu of %zu signatures (%zu bytes).",
+            numEntries,
+            numSignatures,
+            numBytes - (numSignatures - numEntries) * kHAPBLESignatureCache_NumEntryBytes);
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPBLESignatureCacheGet(
+        const HAPAccessoryServerRef* server_,
+        uint64_t iid,
+        HAPTLVWriterRef* responseWriter,
+        bool* found) {
+    HAPPrecondition(server_);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) server_;
+    HAPPrecondition(responseWriter);
+    HAPTLVWriter* writer = (HAPTLVWriter*) responseWriter;
+    HAPPrecondition(!writer->numBytes);
+    HAPPrecondition(found);
+
+    *found = false;
+    if (!server->ble.signatureCache.numEntries || iid > UINT16_MAX) {
+        return kHAPError_None;
+    }
+    HAPAssert(server->ble.storage);
+    const uint8_t* bytes = server->ble.storage->signatureBuffer.bytes;
+    HAPAssert(bytes);
+
+    // Binary search index.
+    size_t lo = 0;
+    size_t hi = server->ble.signatureCache.numEntries;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const uint8_t* entryBytes = &bytes[mid * kHAPBLESignatureCache_NumEntryBytes];
+        uint16_t entryIID = HAPReadLittleUInt16(&entryBytes[0]);
+        if (entryIID < iid) {
+            lo = mid + 1;
+        } else if (entryIID > iid) {
+            hi = mid;
+        } else {
+            *found = true;
+            size_t offset = HAPReadLittleUInt16(&entryBytes[2]);
+            size_t numBytes = HAPReadLittleUInt16(&entryBytes[4]);
+            if (numBytes > writer->maxBytes) {
+                HAPLog(&logObject, "Not enough memory to write cached signature.");
+                return kHAPError_OutOfResources;
+            }
+            if (numBytes) {
+                HAPRawBufferCopyBytes(HAPNonnullVoid(writer->bytes), &bytes[offset], numBytes);
+            }
+            writer->numBytes = numBytes;
+            writer->lastType = entryBytes[6];
+            return kHAPError_None;
+        }
+    }
+    return kHAPError_None;
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#ifndef HAP_BLE_SIGNATURE_CACHE_H
+#define HAP_BLE_SIGNATURE_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "HAP+Internal.h"
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull begin
+#endif
+
+/**
+ * Serializes the signatures of all HomeKit services and characteristics of the primary accessory
+ * into the signature buffer of the BLE accessory server storage.
+ *
+ * - If no signature buffer is provided, the signature cache is left empty.
+ *
+ * - Signatures that do not fit into the signature buffer are not cached.
+ *
+ * @param      server               Accessory server.
+ */
+void HAPBLESignatureCachePrepare(HAPAccessoryServerRef* server);
+
+/**
+ * Appends the cached signature of a HomeKit service or characteristic to a writer.
+ *
+ * @param      server               Accessory server.
+ * @param      iid                  Instance ID of the HomeKit service or characteristic.
+ * @param      responseWriter       Empty writer to append the cached signature to.
+ * @param[out] found                True if a cached signature was found. False otherwise.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If writer does not have enough capacity.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPBLESignatureCacheGet(
+        const HAPAccessoryServerRef* server,
+        uint64_t iid,
+        HAPTLVWriterRef* responseWriter,
+        bool* found);
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull end
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
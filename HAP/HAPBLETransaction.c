@@ -8,6 +8,26 @@
 
 static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .category = "BLETransaction" };
 
+/**
+ * Control Field of a continuation fragment of a HAP-BLE request.
+ *
+ * - Fragmentation status: Continuation. PDU Type: Request. Length: 1 Byte.
+ *
+ * @see HomeKit Accessory Protocol Specification R14
+ *      Section 7.3.3.1 HAP PDU Header - Control Field
+ */
+#define kHAPBLETransaction_RequestContinuationControlField ((uint8_t)(1 << 7))
+
+/**
+ * Control Field of a continuation fragment of a HAP-BLE response.
+ *
+ * - Fragmentation status: Continuation. PDU Type: Response. Length: 1 Byte.
+ *
+ * @see HomeKit Accessory Protocol Specification R14
+ *      Section 7.3.3.1 HAP PDU Header - Control Field
+ */
+#define kHAPBLETransaction_ResponseContinuationControlField ((uint8_t)(1 << 7 | 1 << 1))
+
 void HAPBLETransactionCreate(HAPBLETransaction* bleTransaction, void* _Nullable bodyBytes, size_t numBodyBytes)
         HAP_DIAGNOSE_ERROR(!bodyBytes && numBodyBytes, "empty buffer cannot have a length") {
     HAPPrecondition(bleTransaction);
@@ -20,6 +40,7 @@ void HAPBLETransactionCreate(HAPBLETransaction* bleTransaction, void* _Nullable
 
 /**
  * Appends a body fragment to the combined body in a transaction.
+ * The fragment is copied directly to its final offset in the combined body.
  * If the transaction buffer is not large enough, input fragment is discarded.
  *
  * @param      bleTransaction       Transaction.
@@ -89,6 +110,26 @@ HAPError HAPBLETransactionHandleWrite(HAPBLETransaction* bleTransaction, const v
             // Section 7.3.3.5 HAP PDU Fragmentation Scheme
             // See HomeKit Accessory Protocol Specification R14
             // Section 7.3.5.6 HAP Fragmented Writes
+            const uint8_t* b = bytes;
+            size_t numRemainingBodyBytes =
+                    bleTransaction->_.request.totalBodyBytes - bleTransaction->_.request.bodyOffset;
+            if (numBytes >= kHAPBLEPDU_NumContinuationHeaderBytes &&
+                b[0] == kHAPBLETransaction_RequestContinuationControlField &&
+                numBytes - kHAPBLEPDU_NumContinuationHeaderBytes <= numRemainingBodyBytes) {
+                // Fast path for well-formed continuations: The header is fixed, so the body is appended in place.
+                if (b[1] != bleTransaction->_.request.tid) {
+                    HAPLog(&logObject, "Continuation fragment has different TID as the previous fragments.");
+                    return kHAPError_InvalidData;
+                }
+                TryAppendBodyFragment(
+                        bleTransaction,
+                        numBytes > kHAPBLEPDU_NumContinuationHeaderBytes ? &b[kHAPBLEPDU_NumContinuationHeaderBytes] :
+                                                                           NULL,
+                        numBytes - kHAPBLEPDU_NumContinuationHeaderBytes);
+                return kHAPError_None;
+            }
+
+            // Malformed continuation. Deserialize for diagnostics.
             HAPBLEPDU pdu;
             err = HAPBLEPDUDeserializeContinuation(
                     &pdu,
@@ -267,7 +308,9 @@ HAPError HAPBLETransactionHandleRead(
         }
         case kHAPBLETransactionState_WritingResponse: {
             // Send next response fragment.
-            // Calculate header length.
+            // The header is fixed, so it is written directly and the body fragment is copied from the serialized body.
+            // See HomeKit Accessory Protocol Specification R14
+            // Section 7.3.3.5 HAP PDU Fragmentation Scheme
             size_t numHeaderBytes = kHAPBLEPDU_NumContinuationHeaderBytes;
             if (maxBytes < numHeaderBytes) {
                 HAPLog(&logObject, "Not enough capacity for Continuation PDU header.");
@@ -283,21 +326,18 @@ HAPError HAPBLETransactionHandleRead(
             HAPAssert(bleTransaction->_.response.bodyBytes);
 
             // Serialize HAP-BLE PDU.
-            HAPBLEPDU pdu;
-            HAPRawBufferZero(&pdu, sizeof pdu);
-            pdu.controlField.fragmentationStatus = kHAPBLEPDUFragmentationStatus_Continuation;
-            pdu.controlField.type = kHAPBLEPDUType_Response;
-            pdu.controlField.length = kHAPBLEPDUControlFieldLength_1Byte;
-            pdu.fixedParams.continuation.tid = bleTransaction->_.response.tid;
-            pdu.body.totalBodyBytes = (uint16_t) bleTransaction->_.response.totalBodyBytes;
-            pdu.body.bytes = (uint8_t*) bleTransaction->_.response.bodyBytes + bleTransaction->_.response.bodyOffset;
-            pdu.body.numBytes = (uint16_t) numFragmentBytes;
-
-            err = HAPBLEPDUSerialize(&pdu, bytes, maxBytes, numBytes);
-            if (err) {
-                HAPAssert(err == kHAPError_OutOfResources);
-                return err;
+            uint8_t* b = bytes;
+            b[0] = kHAPBLETransaction_ResponseContinuationControlField;
+            b[1] = bleTransaction->_.response.tid;
+            if (!numFragmentBytes) {
+                HAPLog(&logObject, "Sending empty continuation fragment.");
+            } else {
+                HAPRawBufferCopyBytes(
+                        &b[numHeaderBytes],
+                        (const uint8_t*) bleTransaction->_.response.bodyBytes + bleTransaction->_.response.bodyOffset,
+                        numFragmentBytes);
             }
+            *numBytes = numHeaderBytes + numFragmentBytes;
 
             // Advance buffer.
             bleTransaction->_.response.bodyOffset += numFragmentBytes;
@@ -44,6 +44,172 @@ bool HAPCharacteristicWriteRequiresAdminPermissions(const HAPCharacteristic* cha
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Prepares a characteristic write before it is handed over to the characteristic's write handler.
+ *
+ * - The cached value of the characteristic is discarded.
+ *
+ * - If a batch write is being collected for the service, the write is appended to it.
+ *
+ * @param      server_              Accessory server.
+ * @param      characteristic       The characteristic whose value is to be written.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ * @param      remote               Whether the request appears to have originated from a remote controller.
+ * @param      authorizationDataBytes Additional authorization data, if applicable.
+ * @param      numAuthorizationDataBytes Length of additional authorization data.
+ *
+ * @return Batch write to which the value must be stored, if a batch write is being collected for the service.
+ * @return NULL                     Otherwise. The characteristic's write handler must be invoked.
+ */
+HAP_RESULT_USE_CHECK
+static HAPCharacteristicBatchWrite* _Nullable PrepareCharacteristicWrite(
+        HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* characteristic,
+        const HAPService* _Nullable service,
+        const HAPAccessory* accessory,
+        bool remote,
+        const void* _Nullable authorizationDataBytes,
+        size_t numAuthorizationDataBytes) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(characteristic);
+    HAPPrecondition(accessory);
+
+    HAPCharacteristicValueCacheInvalidate(server_, characteristic, accessory);
+
+    if (!server->batchWrite.service || server->batchWrite.service != service) {
+        return NULL;
+    }
+    HAPAssert(server->batchWrite.writes);
+    HAPAssert(server->batchWrite.numWrites < server->batchWrite.maxWrites);
+
+    HAPCharacteristicBatchWrite* batchWrite = &server->batchWrite.writes[server->batchWrite.numWrites];
+    server->batchWrite.numWrites++;
+    HAPRawBufferZero(batchWrite, sizeof *batchWrite);
+    batchWrite->characteristic = characteristic;
+    batchWrite->remote = remote;
+    batchWrite->authorizationData.bytes = authorizationDataBytes;
+    batchWrite->authorizationData.numBytes = numAuthorizationDataBytes;
+    return batchWrite;
+}
+
+/**
+ * Prepares a characteristic write request of any format. See PrepareCharacteristicWrite.
+ */
+#define PrepareWrite(server, request) \
+    PrepareCharacteristicWrite( \
+            (server), \
+            (const HAPCharacteristic*) (request)->characteristic, \
+            (request)->service, \
+            (request)->accessory, \
+            (request)->remote, \
+            (request)->authorizationData.bytes, \
+            (request)->authorizationData.numBytes)
+
+void HAPServiceBeginBatchWrite(
+        HAPAccessoryServerRef* server_,
+        const HAPService* service,
+        HAPCharacteristicBatchWrite* writes,
+        size_t maxWrites) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(service);
+    HAPPrecondition(service->callbacks.handleBatchWrite);
+    HAPPrecondition(writes);
+    HAPPrecondition(!server->batchWrite.service);
+
+    server->batchWrite.service = service;
+    server->batchWrite.writes = writes;
+    server->batchWrite.numWrites = 0;
+    server->batchWrite.maxWrites = maxWrites;
+}
+
+HAP_RESULT_USE_CHECK
+size_t HAPServiceEndBatchWrite(
+        HAPAccessoryServerRef* server_,
+        const HAPServiceRequest* request,
+        void* _Nullable context) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(request);
+    HAPPrecondition(request->service);
+    HAPPrecondition(request->service == server->batchWrite.service);
+    HAPPrecondition(request->accessory);
+
+    HAPError err;
+
+    HAPCharacteristicBatchWrite* writes = HAPNonnull(server->batchWrite.writes);
+    size_t numWrites = server->batchWrite.numWrites;
+    if (numWrites) {
+        // Call handler.
+        HAPLogServiceInfo(
+                &logObject,
+                request->service,
+                request->accessory,
+                "Calling batch write handler (%lu writes).",
+                (unsigned long) numWrites);
+        HAPTime startTime = HAPMetricsGetTime(server_);
+        err = request->service->callbacks.handleBatchWrite(server_, request, writes, numWrites, context);
+        HAPMetricsRecordLatency(server_, writeHandlerLatency, startTime);
+        if (err) {
+            HAPAssert(
+                    err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
+                    err == kHAPError_Busy || err == kHAPError_InProgress);
+            HAPLogService(
+                    &logObject,
+                    request->service,
+                    request->accessory,
+                    "Batch write handler failed with error %u.",
+                    err);
+            for (size_t i = 0; i < numWrites; i++) {
+                writes[i].status = err;
+            }
+        }
+        for (size_t i = 0; i < numWrites; i++) {
+            HAPAssert(
+                    writes[i].status == kHAPError_None || writes[i].status == kHAPError_Unknown ||
+                    writes[i].status == kHAPError_InvalidState || writes[i].status == kHAPError_InvalidData ||
+                    writes[i].status == kHAPError_OutOfResources || writes[i].status == kHAPError_NotAuthorized ||
+                    writes[i].status == kHAPError_Busy || writes[i].status == kHAPError_InProgress);
+
+            // Discard value that may have been cached while the batch write handler was running.
+            if (writes[i].status == kHAPError_None) {
+                HAPCharacteristicValueCacheInvalidate(server_, writes[i].characteristic, request->accessory);
+            }
+        }
+    }
+
+    server->batchWrite.service = NULL;
+    server->batchWrite.writes = NULL;
+    server->batchWrite.numWrites = 0;
+    server->batchWrite.maxWrites = 0;
+    return numWrites;
+}
+
+HAP_RESULT_USE_CHECK
+bool HAPServiceIsBatchWriteTarget(
+        HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(characteristic);
+    HAPPrecondition(service);
+
+    if (server->batchWrite.service != service) {
+        return false;
+    }
+    for (size_t i = 0; i < server->batchWrite.numWrites; i++) {
+        if (HAPNonnull(server->batchWrite.writes)[i].characteristic == characteristic) {
+            return true;
+        }
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 #define IS_VALUE_IN_RANGE(value, constraints) \
     ((value) >= (constraints).minimumValue && (value) <= (constraints).maximumValue && \
      (!(constraints).stepValue || ((value) - (constraints).minimumValue) % (constraints).stepValue == 0))
@@ -107,12 +273,14 @@ HAPError HAPDataCharacteristicHandleRead(
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleRead(
             server, request, valueBytes, maxValueBytes, numValueBytes, context);
+    HAPMetricsRecordLatency(server, readHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                err == kHAPError_Busy);
+                err == kHAPError_Busy || err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -165,14 +333,25 @@ HAPError HAPDataCharacteristicHandleWrite(
         return kHAPError_InvalidData;
     }
 
+    // Discard cached value and collect into service batch write, if applicable.
+    HAPCharacteristicBatchWrite* _Nullable batchWrite = PrepareWrite(server, request);
+    if (batchWrite) {
+        batchWrite->value.dataValue.bytes = valueBytes;
+        batchWrite->value.dataValue.numBytes = numValueBytes;
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleWrite(server, request, valueBytes, numValueBytes, context);
+    HAPMetricsRecordLatency(server, writeHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -183,6 +362,9 @@ HAPError HAPDataCharacteristicHandleWrite(
         return err;
     }
 
+    // Discard value that may have been cached while the write handler was running.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->accessory);
+
     return kHAPError_None;
 }
 
@@ -265,14 +447,22 @@ HAPError HAPBoolCharacteristicHandleRead(
 
     HAPError err;
 
+    // Serve cached value, if available.
+    if (HAPCharacteristicValueCacheGetValue(
+                server, request->characteristic, request->service, request->accessory, value, sizeof *value)) {
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleRead(server, request, value, context);
+    HAPMetricsRecordLatency(server, readHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                err == kHAPError_Busy);
+                err == kHAPError_Busy || err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -287,6 +477,9 @@ HAPError HAPBoolCharacteristicHandleRead(
     HAPAssert(HAPBoolCharacteristicIsValueFulfillingConstraints(
             request->characteristic, request->service, request->accessory, *value));
 
+    // Cache value.
+    HAPCharacteristicValueCacheSetValue(server, request->characteristic, request->accessory, value, sizeof *value);
+
     return kHAPError_None;
 }
 
@@ -312,14 +505,24 @@ HAPError HAPBoolCharacteristicHandleWrite(
         return kHAPError_InvalidData;
     }
 
+    // Discard cached value and collect into service batch write, if applicable.
+    HAPCharacteristicBatchWrite* _Nullable batchWrite = PrepareWrite(server, request);
+    if (batchWrite) {
+        batchWrite->value.boolValue = value;
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleWrite(server, request, value, context);
+    HAPMetricsRecordLatency(server, writeHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -330,6 +533,9 @@ HAPError HAPBoolCharacteristicHandleWrite(
         return err;
     }
 
+    // Discard value that may have been cached while the write handler was running.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->accessory);
+
     return kHAPError_None;
 }
 
@@ -474,14 +680,22 @@ HAPError HAPUInt8CharacteristicHandleRead(
 
     HAPError err;
 
+    // Serve cached value, if available.
+    if (HAPCharacteristicValueCacheGetValue(
+                server, request->characteristic, request->service, request->accessory, value, sizeof *value)) {
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleRead(server, request, value, context);
+    HAPMetricsRecordLatency(server, readHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                err == kHAPError_Busy);
+                err == kHAPError_Busy || err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -496,6 +710,9 @@ HAPError HAPUInt8CharacteristicHandleRead(
     HAPAssert(HAPUInt8CharacteristicIsValueFulfillingConstraints(
             request->characteristic, request->service, request->accessory, *value));
 
+    // Cache value.
+    HAPCharacteristicValueCacheSetValue(server, request->characteristic, request->accessory, value, sizeof *value);
+
     return kHAPError_None;
 }
 
@@ -521,14 +738,24 @@ HAPError HAPUInt8CharacteristicHandleWrite(
         return kHAPError_InvalidData;
     }
 
+    // Discard cached value and collect into service batch write, if applicable.
+    HAPCharacteristicBatchWrite* _Nullable batchWrite = PrepareWrite(server, request);
+    if (batchWrite) {
+        batchWrite->value.uint8Value = value;
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleWrite(server, request, value, context);
+    HAPMetricsRecordLatency(server, writeHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -539,6 +766,9 @@ HAPError HAPUInt8CharacteristicHandleWrite(
         return err;
     }
 
+    // Discard value that may have been cached while the write handler was running.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->accessory);
+
     return kHAPError_None;
 }
 
@@ -630,14 +860,22 @@ HAPError HAPUInt16CharacteristicHandleRead(
 
     HAPError err;
 
+    // Serve cached value, if available.
+    if (HAPCharacteristicValueCacheGetValue(
+                server, request->characteristic, request->service, request->accessory, value, sizeof *value)) {
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleRead(server, request, value, context);
+    HAPMetricsRecordLatency(server, readHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                err == kHAPError_Busy);
+                err == kHAPError_Busy || err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -652,6 +890,9 @@ HAPError HAPUInt16CharacteristicHandleRead(
     HAPAssert(HAPUInt16CharacteristicIsValueFulfillingConstraints(
             request->characteristic, request->service, request->accessory, *value));
 
+    // Cache value.
+    HAPCharacteristicValueCacheSetValue(server, request->characteristic, request->accessory, value, sizeof *value);
+
     return kHAPError_None;
 }
 
@@ -677,14 +918,24 @@ HAPError HAPUInt16CharacteristicHandleWrite(
         return kHAPError_InvalidData;
     }
 
+    // Discard cached value and collect into service batch write, if applicable.
+    HAPCharacteristicBatchWrite* _Nullable batchWrite = PrepareWrite(server, request);
+    if (batchWrite) {
+        batchWrite->value.uint16Value = value;
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleWrite(server, request, value, context);
+    HAPMetricsRecordLatency(server, writeHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -695,6 +946,9 @@ HAPError HAPUInt16CharacteristicHandleWrite(
         return err;
     }
 
+    // Discard value that may have been cached while the write handler was running.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->accessory);
+
     return kHAPError_None;
 }
 
@@ -786,14 +1040,22 @@ HAPError HAPUInt32CharacteristicHandleRead(
 
     HAPError err;
 
+    // Serve cached value, if available.
+    if (HAPCharacteristicValueCacheGetValue(
+                server, request->characteristic, request->service, request->accessory, value, sizeof *value)) {
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleRead(server, request, value, context);
+    HAPMetricsRecordLatency(server, readHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                err == kHAPError_Busy);
+                err == kHAPError_Busy || err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -808,6 +1070,9 @@ HAPError HAPUInt32CharacteristicHandleRead(
     HAPAssert(HAPUInt32CharacteristicIsValueFulfillingConstraints(
             request->characteristic, request->service, request->accessory, *value));
 
+    // Cache value.
+    HAPCharacteristicValueCacheSetValue(server, request->characteristic, request->accessory, value, sizeof *value);
+
     return kHAPError_None;
 }
 
@@ -833,14 +1098,24 @@ HAPError HAPUInt32CharacteristicHandleWrite(
         return kHAPError_InvalidData;
     }
 
+    // Discard cached value and collect into service batch write, if applicable.
+    HAPCharacteristicBatchWrite* _Nullable batchWrite = PrepareWrite(server, request);
+    if (batchWrite) {
+        batchWrite->value.uint32Value = value;
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleWrite(server, request, value, context);
+    HAPMetricsRecordLatency(server, writeHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -851,6 +1126,9 @@ HAPError HAPUInt32CharacteristicHandleWrite(
         return err;
     }
 
+    // Discard value that may have been cached while the write handler was running.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->accessory);
+
     return kHAPError_None;
 }
 
@@ -942,14 +1220,22 @@ HAPError HAPUInt64CharacteristicHandleRead(
 
     HAPError err;
 
+    // Serve cached value, if available.
+    if (HAPCharacteristicValueCacheGetValue(
+                server, request->characteristic, request->service, request->accessory, value, sizeof *value)) {
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleRead(server, request, value, context);
+    HAPMetricsRecordLatency(server, readHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                err == kHAPError_Busy);
+                err == kHAPError_Busy || err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -964,6 +1250,9 @@ HAPError HAPUInt64CharacteristicHandleRead(
     HAPAssert(HAPUInt64CharacteristicIsValueFulfillingConstraints(
             request->characteristic, request->service, request->accessory, *value));
 
+    // Cache value.
+    HAPCharacteristicValueCacheSetValue(server, request->characteristic, request->accessory, value, sizeof *value);
+
     return kHAPError_None;
 }
 
@@ -989,14 +1278,24 @@ HAPError HAPUInt64CharacteristicHandleWrite(
         return kHAPError_InvalidData;
     }
 
+    // Discard cached value and collect into service batch write, if applicable.
+    HAPCharacteristicBatchWrite* _Nullable batchWrite = PrepareWrite(server, request);
+    if (batchWrite) {
+        batchWrite->value.uint64Value = value;
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleWrite(server, request, value, context);
+    HAPMetricsRecordLatency(server, writeHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -1007,6 +1306,9 @@ HAPError HAPUInt64CharacteristicHandleWrite(
         return err;
     }
 
+    // Discard value that may have been cached while the write handler was running.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->accessory);
+
     return kHAPError_None;
 }
 
@@ -1098,14 +1400,22 @@ HAPError HAPIntCharacteristicHandleRead(
 
     HAPError err;
 
+    // Serve cached value, if available.
+    if (HAPCharacteristicValueCacheGetValue(
+                server, request->characteristic, request->service, request->accessory, value, sizeof *value)) {
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleRead(server, request, value, context);
+    HAPMetricsRecordLatency(server, readHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                err == kHAPError_Busy);
+                err == kHAPError_Busy || err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -1120,6 +1430,9 @@ HAPError HAPIntCharacteristicHandleRead(
     HAPAssert(HAPIntCharacteristicIsValueFulfillingConstraints(
             request->characteristic, request->service, request->accessory, *value));
 
+    // Cache value.
+    HAPCharacteristicValueCacheSetValue(server, request->characteristic, request->accessory, value, sizeof *value);
+
     return kHAPError_None;
 }
 
@@ -1145,14 +1458,24 @@ HAPError HAPIntCharacteristicHandleWrite(
         return kHAPError_InvalidData;
     }
 
+    // Discard cached value and collect into service batch write, if applicable.
+    HAPCharacteristicBatchWrite* _Nullable batchWrite = PrepareWrite(server, request);
+    if (batchWrite) {
+        batchWrite->value.intValue = value;
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleWrite(server, request, value, context);
+    HAPMetricsRecordLatency(server, writeHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -1163,6 +1486,9 @@ HAPError HAPIntCharacteristicHandleWrite(
         return err;
     }
 
+    // Discard value that may have been cached while the write handler was running.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->accessory);
+
     return kHAPError_None;
 }
 
@@ -1310,14 +1636,22 @@ HAPError HAPFloatCharacteristicHandleRead(
 
     HAPError err;
 
+    // Serve cached value, if available.
+    if (HAPCharacteristicValueCacheGetValue(
+                server, request->characteristic, request->service, request->accessory, value, sizeof *value)) {
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleRead(server, request, value, context);
+    HAPMetricsRecordLatency(server, readHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                err == kHAPError_Busy);
+                err == kHAPError_Busy || err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -1335,6 +1669,9 @@ HAPError HAPFloatCharacteristicHandleRead(
     // Round to step.
     *value = HAPFloatCharacteristicRoundValueToStep(request->characteristic, *value);
 
+    // Cache value.
+    HAPCharacteristicValueCacheSetValue(server, request->characteristic, request->accessory, value, sizeof *value);
+
     return kHAPError_None;
 }
 
@@ -1363,14 +1700,24 @@ HAPError HAPFloatCharacteristicHandleWrite(
     // Round to step.
     value = HAPFloatCharacteristicRoundValueToStep(request->characteristic, value);
 
+    // Discard cached value and collect into service batch write, if applicable.
+    HAPCharacteristicBatchWrite* _Nullable batchWrite = PrepareWrite(server, request);
+    if (batchWrite) {
+        batchWrite->value.floatValue = value;
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleWrite(server, request, value, context);
+    HAPMetricsRecordLatency(server, writeHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -1381,6 +1728,9 @@ HAPError HAPFloatCharacteristicHandleWrite(
         return err;
     }
 
+    // Discard value that may have been cached while the write handler was running.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->accessory);
+
     return kHAPError_None;
 }
 
@@ -1489,11 +1839,13 @@ HAPError HAPStringCharacteristicHandleRead(
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleRead(server, request, value, maxValueBytes, context);
+    HAPMetricsRecordLatency(server, readHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                err == kHAPError_Busy);
+                err == kHAPError_Busy || err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -1557,14 +1909,24 @@ HAPError HAPStringCharacteristicHandleWrite(
         return kHAPError_InvalidData;
     }
 
+    // Discard cached value and collect into service batch write, if applicable.
+    HAPCharacteristicBatchWrite* _Nullable batchWrite = PrepareWrite(server, request);
+    if (batchWrite) {
+        batchWrite->value.stringValue = value;
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleWrite(server, request, value, context);
+    HAPMetricsRecordLatency(server, writeHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -1575,6 +1937,9 @@ HAPError HAPStringCharacteristicHandleWrite(
         return err;
     }
 
+    // Discard value that may have been cached while the write handler was running.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->accessory);
+
     return kHAPError_None;
 }
 
@@ -1646,11 +2011,13 @@ HAPError HAPTLV8CharacteristicHandleRead(
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleRead(server, request, responseWriter, context);
+    HAPMetricsRecordLatency(server, readHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
-                err == kHAPError_Busy);
+                err == kHAPError_Busy || err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -1681,14 +2048,24 @@ HAPError HAPTLV8CharacteristicHandleWrite(
 
     HAPError err;
 
+    // Discard cached value and collect into service batch write, if applicable.
+    HAPCharacteristicBatchWrite* _Nullable batchWrite = PrepareWrite(server, request);
+    if (batchWrite) {
+        HAPRawBufferCopyBytes(&batchWrite->value.tlv8Value, requestReader, sizeof batchWrite->value.tlv8Value);
+        return kHAPError_None;
+    }
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
+    HAPTime startTime = HAPMetricsGetTime(server);
     err = request->characteristic->callbacks.handleWrite(server, request, requestReader, context);
+    HAPMetricsRecordLatency(server, writeHandlerLatency, startTime);
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
-                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy);
+                err == kHAPError_OutOfResources || err == kHAPError_NotAuthorized || err == kHAPError_Busy ||
+                err == kHAPError_InProgress);
         HAPLogCharacteristic(
                 &logObject,
                 request->characteristic,
@@ -1699,6 +2076,9 @@ HAPError HAPTLV8CharacteristicHandleWrite(
         return err;
     }
 
+    // Discard value that may have been cached while the write handler was running.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->accessory);
+
     return kHAPError_None;
 }
 
@@ -306,6 +306,57 @@ bool HAPCharacteristicReadRequiresAdminPermissions(const HAPCharacteristic* char
 HAP_RESULT_USE_CHECK
 bool HAPCharacteristicWriteRequiresAdminPermissions(const HAPCharacteristic* characteristic);
 
+/**
+ * Starts collecting characteristic writes to a service that provides a batch write handler.
+ *
+ * - While collecting, the HAPXxxCharacteristicHandleWrite functions validate the value as usual,
+ *   but store it in @p writes instead of invoking the characteristic's write handler.
+ *
+ * @param      server               Accessory server.
+ * @param      service              Service whose writes are collected.
+ * @param      writes               Buffer for the collected writes.
+ * @param      maxWrites            Capacity of @p writes. Must fit all writes that will be collected.
+ */
+void HAPServiceBeginBatchWrite(
+        HAPAccessoryServerRef* server,
+        const HAPService* service,
+        HAPCharacteristicBatchWrite* writes,
+        size_t maxWrites);
+
+/**
+ * Invokes the service batch write handler with the collected writes, and stops collecting.
+ *
+ * - On return, the status of each collected write is set. Writes are stored in collection order.
+ * - The batch write handler is not invoked if no writes have been collected.
+ *
+ * @param      server               Accessory server.
+ * @param      request              Request.
+ * @param      context              The context parameter given to the HAPAccessoryServerCreate function.
+ *
+ * @return Number of collected writes.
+ */
+HAP_RESULT_USE_CHECK
+size_t HAPServiceEndBatchWrite(
+        HAPAccessoryServerRef* server,
+        const HAPServiceRequest* request,
+        void* _Nullable context);
+
+/**
+ * Returns whether a characteristic is written by the service batch write that is being collected or handled.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristic       Characteristic.
+ * @param      service              The service that contains the characteristic.
+ *
+ * @return true                     If the characteristic is written by the current service batch write.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+bool HAPServiceIsBatchWriteTarget(
+        HAPAccessoryServerRef* server,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service);
+
 /**
  * Reads a Data characteristic value.
  *
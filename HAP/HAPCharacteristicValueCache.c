@@ -0,0 +1,236 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+
+static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .category = "CharacteristicValueCache" };
+
+/**
+ * Compares the key of a cache entry with the given characteristic and accessory.
+ *
+ * - Entries are ordered by accessory, then by characteristic.
+ *
+ * @param      entry                Cache entry.
+ * @param      characteristic       The characteristic.
+ * @param      accessory            The accessory that provides the characteristic.
+ *
+ * @return A negative value if the entry is ordered before the given key, a positive value if it is ordered after it,
+ *         0 if the entry belongs to the given characteristic.
+ */
+HAP_RESULT_USE_CHECK
+static int CompareEntry(
+        const HAPCharacteristicValueCacheEntry* entry,
+        const HAPCharacteristic* characteristic,
+        const HAPAccessory* accessory) {
+    HAPPrecondition(entry);
+    HAPPrecondition(characteristic);
+    HAPPrecondition(accessory);
+
+    uintptr_t entryAccessory = (uintptr_t) entry->accessory;
+    uintptr_t entryCharacteristic = (uintptr_t) entry->characteristic;
+    if (entryAccessory != (uintptr_t) accessory) {
+        return entryAccessory < (uintptr_t) accessory ? -1 : 1;
+    }
+    if (entryCharacteristic != (uintptr_t) characteristic) {
+        return entryCharacteristic < (uintptr_t) characteristic ? -1 : 1;
+    }
+    return 0;
+}
+
+void HAPCharacteristicValueCacheCreate(
+        HAPAccessoryServerRef* server_,
+        HAPCharacteristicValueCacheEntry* _Nullable entries,
+        size_t numEntries) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(!numEntries || entries);
+
+    for (size_t i = 0; i < numEntries; i++) {
+        HAPCharacteristicValueCacheEntry* entry = &entries[i];
+        HAPPrecondition(entry->characteristic);
+        HAPPrecondition(entry->accessory);
+        const HAPBaseCharacteristic* characteristic = entry->characteristic;
+        HAPPrecondition(characteristic->properties.readable);
+        switch (characteristic->format) {
+            case kHAPCharacteristicFormat_Bool:
+            case kHAPCharacteristicFormat_UInt8:
+            case kHAPCharacteristicFormat_UInt16:
+            case kHAPCharacteristicFormat_UInt32:
+            case kHAPCharacteristicFormat_UInt64:
+            case kHAPCharacteristicFormat_Int:
+            case kHAPCharacteristicFormat_Float: {
+            } break;
+            case kHAPCharacteristicFormat_Data:
+            case kHAPCharacteristicFormat_String:
+            case kHAPCharacteristicFormat_TLV8: {
+                HAPLogError(
+                        &logObject,
+                        "[%016llX] [%016llX %s] Values of format data, string or TLV8 cannot be cached.",
+                        (unsigned long long) ((const HAPAccessory*) entry->accessory)->aid,
+                        (unsigned long long) characteristic->iid,
+                        characteristic->debugDescription);
+                HAPFatalError();
+            }
+        }
+        HAPRawBufferZero(&entry->cachedValue, sizeof entry->cachedValue);
+    }
+
+    // Sort entries so that they can be looked up with a binary search.
+    // Insertion sort is sufficient as this is only done once and cache configurations are small.
+    for (size_t i = 1; i < numEntries; i++) {
+        HAPCharacteristicValueCacheEntry entry = entries[i];
+        size_t j = i;
+        while (j && CompareEntry(&entries[j - 1], entry.characteristic, entry.accessory) > 0) {
+            entries[j] = entries[j - 1];
+            j--;
+        }
+        entries[j] = entry;
+    }
+    for (size_t i = 1; i < numEntries; i++) {
+        HAPCharacteristicValueCacheEntry* entry = &entries[i];
+        if (!CompareEntry(&entries[i - 1], entry->characteristic, entry->accessory)) {
+            HAPLogError(
+                    &logObject,
+                    "[%016llX] [%016llX %s] Characteristic is listed more than once.",
+                    (unsigned long long) ((const HAPAccessory*) entry->accessory)->aid,
+                    (unsigned long long) ((const HAPBaseCharacteristic*) entry->characteristic)->iid,
+                    ((const HAPBaseCharacteristic*) entry->characteristic)->debugDescription);
+            HAPFatalError();
+        }
+    }
+
+    server->characteristicValueCache.entries = entries;
+    server->characteristicValueCache.numEntries = numEntries;
+    server->characteristicValueCache.numHits = 0;
+    server->characteristicValueCache.numMisses = 0;
+}
+
+/**
+ * Finds the cache entry of a characteristic.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristic       The characteristic.
+ * @param      accessory            The accessory that provides the characteristic.
+ *
+ * @return Cache entry, if the characteristic is cached. NULL otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static HAPCharacteristicValueCacheEntry* _Nullable GetEntry(
+        HAPAccessoryServer* server,
+        const HAPCharacteristic* characteristic,
+        const HAPAccessory* accessory) {
+    HAPPrecondition(server);
+    HAPPrecondition(characteristic);
+    HAPPrecondition(accessory);
+
+    // Entries have been sorted in HAPCharacteristicValueCacheCreate.
+    size_t lo = 0;
+    size_t hi = server->characteristicValueCache.numEntries;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        HAPCharacteristicValueCacheEntry* entry = &HAPNonnull(server->characteristicValueCache.entries)[mid];
+        int result = CompareEntry(entry, characteristic, accessory);
+        if (result < 0) {
+            lo = mid + 1;
+        } else if (result > 0) {
+            hi = mid;
+        } else {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+HAP_RESULT_USE_CHECK
+bool HAPCharacteristicValueCacheGetValue(
+        HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service,
+        const HAPAccessory* accessory,
+        void* valueBytes,
+        size_t numValueBytes) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(characteristic);
+    HAPPrecondition(service);
+    HAPPrecondition(accessory);
+    HAPPrecondition(valueBytes);
+    HAPPrecondition(numValueBytes <= sizeof(uint64_t));
+
+    HAPCharacteristicValueCacheEntry* _Nullable entry = GetEntry(server, characteristic, accessory);
+    if (!entry) {
+        return false;
+    }
+    HAPCharacteristicCachedValue* cachedValue = (HAPCharacteristicCachedValue*) &entry->cachedValue;
+    if (cachedValue->isValid && entry->maxAge) {
+        HAPTime now = HAPPlatformClockGetCurrent();
+        HAPAssert(now >= cachedValue->timestamp);
+        if (now - cachedValue->timestamp > entry->maxAge) {
+            cachedValue->isValid = false;
+        }
+    }
+    if (!cachedValue->isValid) {
+        server->characteristicValueCache.numMisses++;
+        return false;
+    }
+
+    server->characteristicValueCache.numHits++;
+    HAPLogCharacteristicDebug(&logObject, characteristic, service, accessory, "Serving cached value.");
+    HAPRawBufferCopyBytes(valueBytes, cachedValue->bytes, numValueBytes);
+    return true;
+}
+
+void HAPCharacteristicValueCacheSetValue(
+        HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* characteristic,
+        const HAPAccessory* accessory,
+        const void* valueBytes,
+        size_t numValueBytes) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(characteristic);
+    HAPPrecondition(accessory);
+    HAPPrecondition(valueBytes);
+    HAPPrecondition(numValueBytes <= sizeof(uint64_t));
+
+    HAPCharacteristicValueCacheEntry* _Nullable entry = GetEntry(server, characteristic, accessory);
+    if (!entry) {
+        return;
+    }
+    HAPCharacteristicCachedValue* cachedValue = (HAPCharacteristicCachedValue*) &entry->cachedValue;
+    HAPRawBufferCopyBytes(cachedValue->bytes, valueBytes, numValueBytes);
+    cachedValue->timestamp = HAPPlatformClockGetCurrent();
+    cachedValue->isValid = true;
+}
+
+void HAPCharacteristicValueCacheInvalidate(
+        HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* characteristic,
+        const HAPAccessory* accessory) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(characteristic);
+    HAPPrecondition(accessory);
+
+    HAPCharacteristicValueCacheEntry* _Nullable entry = GetEntry(server, characteristic, accessory);
+    if (!entry) {
+        return;
+    }
+    HAPCharacteristicCachedValue* cachedValue = (HAPCharacteristicCachedValue*) &entry->cachedValue;
+    cachedValue->isValid = false;
+}
+
+void HAPAccessoryServerGetCharacteristicValueCacheStatistics(
+        const HAPAccessoryServerRef* server_,
+        HAPCharacteristicValueCacheStatistics* statistics) {
+    HAPPrecondition(server_);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) server_;
+    HAPPrecondition(statistics);
+
+    HAPRawBufferZero(statistics, sizeof *statistics);
+    statistics->numHits = server->characteristicValueCache.numHits;
+    statistics->numMisses = server->characteristicValueCache.numMisses;
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#ifndef HAP_CHARACTERISTIC_VALUE_CACHE_H
+#define HAP_CHARACTERISTIC_VALUE_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "HAP+Internal.h"
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull begin
+#endif
+
+/**
+ * Cached value of a characteristic.
+ */
+typedef struct {
+    /** Value bytes. */
+    uint8_t bytes[sizeof(uint64_t)];
+
+    /** Time at which the value has been cached. */
+    HAPTime timestamp;
+
+    /** Whether the value is valid. */
+    bool isValid : 1;
+} HAPCharacteristicCachedValue;
+HAP_STATIC_ASSERT(
+        sizeof(HAPCharacteristicCachedValueRef) >= sizeof(HAPCharacteristicCachedValue),
+        HAPCharacteristicCachedValue);
+
+/**
+ * Initializes the characteristic value cache.
+ *
+ * @param      server               Accessory server.
+ * @param      entries              Cache entries.
+ * @param      numEntries           Length of @p entries.
+ */
+void HAPCharacteristicValueCacheCreate(
+        HAPAccessoryServerRef* server,
+        HAPCharacteristicValueCacheEntry* _Nullable entries,
+        size_t numEntries);
+
+/**
+ * Looks up the cached value of a characteristic.
+ *
+ * - Reads of characteristics that are not cached are not counted.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristic       The characteristic that is read.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ * @param[out] valueBytes           Value buffer.
+ * @param      numValueBytes        Length of value buffer.
+ *
+ * @return true                     If a valid cached value has been copied into the value buffer.
+ * @return false                    Otherwise. The read handler has to be invoked.
+ */
+HAP_RESULT_USE_CHECK
+bool HAPCharacteristicValueCacheGetValue(
+        HAPAccessoryServerRef* server,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service,
+        const HAPAccessory* accessory,
+        void* valueBytes,
+        size_t numValueBytes);
+
+/**
+ * Stores the value that has been read from the read handler of a characteristic.
+ *
+ * - The value is only stored if the characteristic is cached.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristic       The characteristic that has been read.
+ * @param      accessory            The accessory that provides the characteristic.
+ * @param      valueBytes           Value buffer.
+ * @param      numValueBytes        Length of value buffer.
+ */
+void HAPCharacteristicValueCacheSetValue(
+        HAPAccessoryServerRef* server,
+        const HAPCharacteristic* characteristic,
+        const HAPAccessory* accessory,
+        const void* valueBytes,
+        size_t numValueBytes);
+
+/**
+ * Discards the cached value of a characteristic.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristic       The characteristic whose value has changed.
+ * @param      accessory            The accessory that provides the characteristic.
+ */
+void HAPCharacteristicValueCacheInvalidate(
+        HAPAccessoryServerRef* server,
+        const HAPCharacteristic* characteristic,
+        const HAPAccessory* accessory);
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull end
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
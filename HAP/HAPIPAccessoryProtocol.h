@@ -35,6 +35,7 @@ typedef struct {
         } stringValue;
     } value;
     bool ev;
+    bool isPending; /**< Whether the read handler has deferred the completion of the request. */
 } HAPIPReadContext;
 HAP_STATIC_ASSERT(sizeof(HAPIPReadContextRef) >= sizeof(HAPIPReadContext), HAPIPReadContext);
 
@@ -102,6 +103,9 @@ typedef struct {
     bool remote;
     HAPIPEventNotificationState ev;
     bool response;
+    bool isHandled; /**< Whether the write request has been handled. */
+    bool isBatched; /**< Whether the value is written by the service batch write handler. */
+    bool isPending; /**< Whether the write or read handler has deferred the completion of the request. */
 } HAPIPWriteContext;
 HAP_STATIC_ASSERT(sizeof(HAPIPWriteContextRef) >= sizeof(HAPIPWriteContext), HAPIPWriteContext);
 
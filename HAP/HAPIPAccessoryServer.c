@@ -140,6 +140,27 @@ static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .categor
  */
 #define kHAPIPSession_MaxIdleTime ((HAPTime)(60 * HAPSecond))
 
+/**
+ * Minimum time an IP session that is not secured must stay idle before it may be closed to make room for a new
+ * connection.
+ *
+ * - Gives controllers that have just connected time to send their first request, e.g., to start Pair Verify.
+ */
+#define kHAPIPSession_MinIdleTimeBeforeEviction ((HAPTime)(2 * HAPSecond))
+
+/**
+ * Minimum time an IP session that is not secured and holds a partially received request must stay idle
+ * before it may be closed to make room for a new connection.
+ */
+#define kHAPIPSession_MinPartialRequestIdleTimeBeforeEviction ((HAPTime)(10 * HAPSecond))
+
+/**
+ * Maximum time the application may take to complete the deferred requests of a HTTP transaction.
+ *
+ * - Deferred requests that have not been completed by then are reported as busy.
+ */
+#define kHAPIPSession_MaxDeferredRequestTime ((HAPTime)(10 * HAPSecond))
+
 /**
  * Maximum delay during which event notifications will be coalesced into a single message.
  */
@@ -253,6 +274,8 @@ static void HandlePendingTCPStream(HAPPlatformTCPStreamManagerRef tcpStreamManag
 
 static void schedule_max_idle_time_timer(HAPAccessoryServerRef* server_);
 
+static void ScheduleDeferredRequestTimer(HAPAccessoryServerRef* server_);
+
 static void HAPIPSessionDestroy(HAPIPSession* ipSession) {
     HAPPrecondition(ipSession);
 
@@ -263,6 +286,8 @@ static void HAPIPSessionDestroy(HAPIPSession* ipSession) {
 
     HAPLogDebug(&logObject, "session:%p:releasing session", (const void*) session);
 
+    HAPAssert(session->slot);
+    HAPRawBufferZero(HAPNonnull(session->slot), sizeof *session->slot);
     HAPRawBufferZero(&ipSession->descriptor, sizeof ipSession->descriptor);
     HAPRawBufferZero(ipSession->inboundBuffer.bytes, ipSession->inboundBuffer.numBytes);
     HAPRawBufferZero(ipSession->outboundBuffer.bytes, ipSession->outboundBuffer.numBytes);
@@ -270,6 +295,86 @@ static void HAPIPSessionDestroy(HAPIPSession* ipSession) {
             ipSession->eventNotifications, ipSession->numEventNotifications * sizeof *ipSession->eventNotifications);
 }
 
+/**
+ * Returns the number of IP sessions that are currently available, including the ones in use.
+ *
+ * @param      server               Accessory server.
+ *
+ * @return Number of IP sessions.
+ */
+HAP_RESULT_USE_CHECK
+static size_t GetNumSessions(const HAPAccessoryServer* server) {
+    HAPPrecondition(server);
+    HAPPrecondition(server->ip.storage);
+
+    return server->ip.numSessionChunks * server->ip.storage->numSessions;
+}
+
+/**
+ * Returns the IP session slot with a given index.
+ *
+ * @param      server               Accessory server.
+ * @param      i                    Session index. Must be less than GetNumSessions.
+ *
+ * @return IP session slot.
+ */
+HAP_RESULT_USE_CHECK
+static HAPIPSessionSlot* GetSessionSlot(const HAPAccessoryServer* server, size_t i) {
+    HAPPrecondition(server);
+    HAPPrecondition(server->ip.storage);
+
+    size_t numSessionsPerChunk = server->ip.storage->numSessions;
+    HAPAssert(i / numSessionsPerChunk < server->ip.numSessionChunks);
+    return (HAPIPSessionSlot*) &HAPNonnull(
+            server->ip.sessionChunks[i / numSessionsPerChunk].sessionSlots)[i % numSessionsPerChunk];
+}
+
+/**
+ * Returns the IP session with a given index.
+ *
+ * @param      server               Accessory server.
+ * @param      i                    Session index. Must be less than GetNumSessions.
+ *
+ * @return IP session.
+ */
+HAP_RESULT_USE_CHECK
+static HAPIPSession* GetSession(const HAPAccessoryServer* server, size_t i) {
+    HAPPrecondition(server);
+    HAPPrecondition(server->ip.storage);
+
+    size_t numSessionsPerChunk = server->ip.storage->numSessions;
+    HAPAssert(i / numSessionsPerChunk < server->ip.numSessionChunks);
+    return &HAPNonnull(server->ip.sessionChunks[i / numSessionsPerChunk].sessions)[i % numSessionsPerChunk];
+}
+
+/**
+ * Returns the IP session that contains a given session descriptor.
+ *
+ * @param      session              IP session descriptor.
+ *
+ * @return IP session.
+ */
+HAP_RESULT_USE_CHECK
+static HAPIPSession* GetIPSession(const HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPPrecondition(session->slot);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+
+    size_t numSessionsPerChunk = server->ip.storage->numSessions;
+    for (size_t j = 0; j < server->ip.numSessionChunks; j++) {
+        const HAPIPSessionSlotRef* sessionSlots = HAPNonnull(server->ip.sessionChunks[j].sessionSlots);
+        const HAPIPSessionSlotRef* slot = (const HAPIPSessionSlotRef*) session->slot;
+        if (slot < sessionSlots || slot >= &sessionSlots[numSessionsPerChunk]) {
+            continue;
+        }
+        HAPIPSession* ipSession = &HAPNonnull(server->ip.sessionChunks[j].sessions)[slot - sessionSlots];
+        HAPAssert((const HAPIPSessionDescriptor*) &ipSession->descriptor == session);
+        return ipSession;
+    }
+    HAPFatalError();
+}
+
 static void collect_garbage(HAPAccessoryServerRef* server_) {
     HAPPrecondition(server_);
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
@@ -280,15 +385,14 @@ static void collect_garbage(HAPAccessoryServerRef* server_) {
     }
 
     size_t n = 0;
-    for (size_t i = 0; i < server->ip.storage->numSessions; i++) {
-        HAPIPSession* ipSession = &server->ip.storage->sessions[i];
-        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-        if (!session->server) {
+    for (size_t i = 0; i < GetNumSessions(server); i++) {
+        const HAPIPSessionSlot* slot = GetSessionSlot(server, i);
+        if (!slot->isActive) {
             continue;
         }
 
-        if (session->state == kHAPIPSessionState_Idle) {
-            HAPIPSessionDestroy(ipSession);
+        if (slot->state == kHAPIPSessionState_Idle) {
+            HAPIPSessionDestroy(GetSession(server, i));
             HAPAssert(server->ip.numSessions > 0);
             server->ip.numSessions--;
         } else {
@@ -313,6 +417,10 @@ static void collect_garbage(HAPAccessoryServerRef* server_) {
         HAPPlatformTimerDeregister(server->ip.maxIdleTimeTimer);
         server->ip.maxIdleTimeTimer = 0;
     }
+    if (server->ip.deferredRequestTimer) {
+        HAPPlatformTimerDeregister(server->ip.deferredRequestTimer);
+        server->ip.deferredRequestTimer = 0;
+    }
     HAPLogDebug(&logObject, "Completing accessory server state transition.");
     if (server->ip.nextState == kHAPIPAccessoryServerState_Running) {
         server->ip.state = kHAPIPAccessoryServerState_Running;
@@ -389,22 +497,22 @@ static void schedule_max_idle_time_timer(HAPAccessoryServerRef* server_) {
         HAPPlatformTCPStreamManagerCloseListener(HAPNonnull(server->platform.ip.tcpStreamManager));
     }
 
-    for (size_t i = 0; i < server->ip.storage->numSessions; i++) {
-        HAPIPSession* ipSession = &server->ip.storage->sessions[i];
-        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-        if (!session->server) {
+    bool isIdleTimeoutEnforced = (server->ip.numSessions == GetNumSessions(server)) ||
+                                 (server->ip.state == kHAPIPAccessoryServerState_Stopping);
+
+    for (size_t i = 0; i < GetNumSessions(server); i++) {
+        const HAPIPSessionSlot* slot = GetSessionSlot(server, i);
+        if (!slot->isActive || (slot->state == kHAPIPSessionState_Idle) || !isIdleTimeoutEnforced) {
             continue;
         }
 
-        if ((session->state == kHAPIPSessionState_Reading) && (session->inboundBuffer.position == 0) &&
+        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &GetSession(server, i)->descriptor;
+        if ((slot->state == kHAPIPSessionState_Reading) && (session->inboundBuffer.position == 0) &&
             (server->ip.state == kHAPIPAccessoryServerState_Stopping)) {
             CloseSession(session);
-        } else if (
-                ((session->state == kHAPIPSessionState_Reading) || (session->state == kHAPIPSessionState_Writing)) &&
-                ((server->ip.numSessions == server->ip.storage->numSessions) ||
-                 (server->ip.state == kHAPIPAccessoryServerState_Stopping))) {
-            HAPAssert(clock_now_ms >= session->stamp);
-            HAPTime dt_ms = clock_now_ms - session->stamp;
+        } else {
+            HAPAssert(clock_now_ms >= slot->stamp);
+            HAPTime dt_ms = clock_now_ms - slot->stamp;
             if (dt_ms < kHAPIPSession_MaxIdleTime) {
                 HAPAssert(kHAPIPSession_MaxIdleTime <= INT64_MAX);
                 int64_t t_ms = (int64_t)(kHAPIPSession_MaxIdleTime - dt_ms);
@@ -451,10 +559,10 @@ static void RegisterSession(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
     HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
-    HAPPrecondition(server->ip.numSessions < server->ip.storage->numSessions);
+    HAPPrecondition(server->ip.numSessions < GetNumSessions(server));
 
     server->ip.numSessions++;
-    if (server->ip.numSessions == server->ip.storage->numSessions) {
+    if (server->ip.numSessions == GetNumSessions(server)) {
         schedule_max_idle_time_timer(session->server);
     }
 }
@@ -465,16 +573,36 @@ static void handle_characteristic_unsubscribe_request(
         const HAPService* svc,
         const HAPAccessory* acc);
 
+static void ReturnBufferPoolBlocks(HAPIPSessionDescriptor* session, bool force);
+
+/**
+ * Discards the recorded requests of the current HTTP transaction.
+ *
+ * @param      session              IP session descriptor.
+ */
+static void ClearDeferredRequests(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+
+    if (!session->deferredTransaction) {
+        return;
+    }
+    HAPIPDeferredTransaction* transaction = HAPNonnull(session->deferredTransaction);
+    HAPAssert(transaction->isActive);
+    HAPRawBufferZero(transaction, sizeof *transaction);
+    session->deferredTransaction = NULL;
+}
+
 static void CloseSession(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
     HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
 
-    HAPAssert(session->state != kHAPIPSessionState_Idle);
+    HAPAssert(session->slot->state != kHAPIPSessionState_Idle);
 
     HAPError err;
 
     HAPLogDebug(&logObject, "session:%p:closing", (const void*) session);
+    HAPIPCaptureCloseSession(session);
 
     while (session->numEventNotifications) {
         HAPIPEventNotification* eventNotification =
@@ -485,8 +613,9 @@ static void CloseSession(HAPIPSessionDescriptor* session) {
         get_db_ctx(
                 session->server, eventNotification->aid, eventNotification->iid, &characteristic, &service, &accessory);
         if (eventNotification->flag) {
-            HAPAssert(session->numEventNotificationFlags);
-            session->numEventNotificationFlags--;
+            HAPAssert(session->slot->numEventNotificationFlags);
+            session->slot->numEventNotificationFlags--;
+            HAPMetricsIncrementCounter(session->server, eventNotifications.numDropped);
         }
         session->numEventNotifications--;
         handle_characteristic_unsubscribe_request(session, characteristic, service, accessory);
@@ -508,12 +637,14 @@ static void CloseSession(HAPIPSessionDescriptor* session) {
         HAPAssert(!session->securitySession.isSecured);
         HAPAssert(!session->securitySession.isOpen);
     }
+    ClearDeferredRequests(session);
+    ReturnBufferPoolBlocks(session, /* force: */ true);
     if (session->tcpStreamIsOpen) {
         HAPLogDebug(&logObject, "session:%p:closing TCP stream", (const void*) session);
         HAPPlatformTCPStreamClose(HAPNonnull(server->platform.ip.tcpStreamManager), session->tcpStream);
         session->tcpStreamIsOpen = false;
     }
-    session->state = kHAPIPSessionState_Idle;
+    session->slot->state = kHAPIPSessionState_Idle;
     if (!server->ip.garbageCollectionTimer) {
         err = HAPPlatformTimerRegister(
                 &server->ip.garbageCollectionTimer, 0, handle_garbage_collection_timer, session->server);
@@ -547,10 +678,304 @@ static void write_msg(HAPIPByteBuffer* b, const char* msg) {
     HAPAssert(!err);
 }
 
+/**
+ * Borrows a block from the buffer pool.
+ *
+ * @param      server_              Accessory server.
+ *
+ * @return Block of storage->bufferPool.numBytesPerBlock bytes, or NULL if no block is available.
+ */
+HAP_RESULT_USE_CHECK
+static char* _Nullable BorrowBufferPoolBlock(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    const HAPIPAccessoryServerStorage* storage = HAPNonnull(server->ip.storage);
+
+    if (!storage->bufferPool.bytes) {
+        return NULL;
+    }
+    for (size_t i = 0; i < storage->bufferPool.numBlocks; i++) {
+        uint64_t mask = (uint64_t) 1 << i;
+        if (!(server->ip.bufferPoolBlocksInUse & mask)) {
+            server->ip.bufferPoolBlocksInUse |= mask;
+            return &((char*) storage->bufferPool.bytes)[i * storage->bufferPool.numBytesPerBlock];
+        }
+    }
+    HAPLogInfo(&logObject, "All %lu buffer pool blocks are in use.", (unsigned long) storage->bufferPool.numBlocks);
+    return NULL;
+}
+
+/**
+ * Returns a block to the buffer pool.
+ *
+ * @param      server_              Accessory server.
+ * @param      block                Block that has been borrowed using BorrowBufferPoolBlock.
+ */
+static void ReturnBufferPoolBlock(HAPAccessoryServerRef* server_, char* block) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    const HAPIPAccessoryServerStorage* storage = HAPNonnull(server->ip.storage);
+    HAPPrecondition(storage->bufferPool.bytes);
+    HAPPrecondition(block >= (char*) storage->bufferPool.bytes);
+
+    size_t i = (size_t)(block - (char*) storage->bufferPool.bytes) / storage->bufferPool.numBytesPerBlock;
+    HAPAssert(i < storage->bufferPool.numBlocks);
+    HAPAssert(block == &((char*) storage->bufferPool.bytes)[i * storage->bufferPool.numBytesPerBlock]);
+    uint64_t mask = (uint64_t) 1 << i;
+    HAPAssert(server->ip.bufferPoolBlocksInUse & mask);
+    server->ip.bufferPoolBlocksInUse &= ~mask;
+}
+
+/**
+ * Rebases a pointer into the inbound buffer after the inbound buffer data has been moved.
+ *
+ * @param[in,out] token             Pointer into the old inbound buffer, or NULL.
+ * @param      oldData              Old inbound buffer data.
+ * @param      newData              New inbound buffer data.
+ */
+static void RebaseInboundToken(char* _Nullable* token, const char* oldData, char* newData) {
+    HAPPrecondition(token);
+
+    if (*token) {
+        HAPAssert(*token >= oldData);
+        *token = &newData[*token - oldData];
+    }
+}
+
+/**
+ * Moves the inbound buffer of a session to a block of the buffer pool so that a request that does not fit into
+ * the inbound buffer of the session can be received.
+ *
+ * - The inbound buffer must be full.
+ *
+ * @param      session              IP session descriptor.
+ *
+ * @return true                     If the inbound buffer has been enlarged.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool EnlargeInboundBuffer(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(session->inboundBuffer.position == session->inboundBuffer.limit);
+    HAPPrecondition(session->inboundBuffer.limit == session->inboundBuffer.capacity);
+    HAPPrecondition(!session->inboundBufferOffset);
+
+    if (session->inboundBufferIsPooled ||
+        server->ip.storage->bufferPool.numBytesPerBlock <= session->inboundBuffer.capacity) {
+        return false;
+    }
+    char* block = BorrowBufferPoolBlock(session->server);
+    if (!block) {
+        return false;
+    }
+
+    char* data = session->inboundBuffer.data;
+    HAPRawBufferCopyBytes(block, data, session->inboundBuffer.position);
+    RebaseInboundToken(&session->httpMethod.bytes, data, block);
+    RebaseInboundToken(&session->httpURI.bytes, data, block);
+    RebaseInboundToken(&session->httpHeaderFieldName.bytes, data, block);
+    RebaseInboundToken(&session->httpHeaderFieldValue.bytes, data, block);
+    RebaseInboundToken(&session->httpReader.result_token, data, block);
+    session->inboundBuffer.data = block;
+    session->inboundBuffer.capacity = server->ip.storage->bufferPool.numBytesPerBlock;
+    session->inboundBuffer.limit = session->inboundBuffer.capacity;
+    session->inboundBufferIsPooled = true;
+    HAPLogDebug(&logObject, "session:%p:borrowed inbound buffer pool block", (const void*) session);
+    return true;
+}
+
+/**
+ * Moves the outbound buffer of a session to a block of the buffer pool so that a large response can be prepared.
+ *
+ * - The outbound buffer must be empty.
+ *
+ * @param      session              IP session descriptor.
+ */
+static void EnlargeOutboundBuffer(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+
+    if (session->outboundBufferIsPooled || (session->outboundBuffer.position != 0) ||
+        server->ip.storage->bufferPool.numBytesPerBlock <= session->outboundBuffer.capacity) {
+        return;
+    }
+    char* block = BorrowBufferPoolBlock(session->server);
+    if (!block) {
+        return;
+    }
+
+    session->outboundBuffer.data = block;
+    session->outboundBuffer.capacity = server->ip.storage->bufferPool.numBytesPerBlock;
+    session->outboundBuffer.limit = session->outboundBuffer.capacity;
+    session->outboundBufferIsPooled = true;
+    HAPLogDebug(&logObject, "session:%p:borrowed outbound buffer pool block", (const void*) session);
+}
+
+/**
+ * Determines whether the response to the current request of a session scales with the accessory attribute database.
+ *
+ * - This is the case for GET /accessories and for GET /characteristics requests for multiple characteristics.
+ *   Responses to other requests fit into the outbound buffer of the session.
+ *
+ * @param      session              IP session descriptor.
+ *
+ * @return true                     If the response may not fit into the outbound buffer of the session.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool HasLargeResponse(const HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+
+    if (!session->httpMethod.bytes || !session->httpURI.bytes) {
+        return false;
+    }
+    const char* method = HAPNonnull(session->httpMethod.bytes);
+    const char* uri = HAPNonnull(session->httpURI.bytes);
+    size_t numURIBytes = session->httpURI.numBytes;
+    if (session->httpMethod.numBytes != 3 || !HAPRawBufferAreEqual(method, "GET", 3)) {
+        return false;
+    }
+    if (numURIBytes == 12 && HAPRawBufferAreEqual(uri, "/accessories", 12)) {
+        return true;
+    }
+    if (numURIBytes > 17 && HAPRawBufferAreEqual(uri, "/characteristics?", 17)) {
+        // Instance IDs in the id parameter are separated by commas.
+        for (size_t i = 17; i < numURIBytes; i++) {
+            if (uri[i] == ',') {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns the buffer pool blocks of a session once the session no longer needs them.
+ *
+ * - The inbound buffer block is only returned if the pending inbound data fits into the inbound buffer of the session.
+ *
+ * @param      session              IP session descriptor.
+ * @param      force                Whether blocks should be returned even if buffered data is discarded.
+ */
+static void ReturnBufferPoolBlocks(HAPIPSessionDescriptor* session, bool force) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+
+    if (!session->inboundBufferIsPooled && !session->outboundBufferIsPooled) {
+        return;
+    }
+
+    HAPIPSession* ipSession = GetIPSession(session);
+
+    if (session->inboundBufferIsPooled &&
+        (force || session->inboundBuffer.position < ipSession->inboundBuffer.numBytes)) {
+        char* block = session->inboundBuffer.data - session->inboundBufferOffset;
+        if (!force) {
+            HAPAssert(session->inboundBufferMark <= session->inboundBuffer.position);
+            HAPRawBufferCopyBytes(
+                    ipSession->inboundBuffer.bytes, session->inboundBuffer.data, session->inboundBuffer.position);
+        }
+        session->inboundBufferOffset = 0;
+        session->inboundBuffer.data = ipSession->inboundBuffer.bytes;
+        session->inboundBuffer.capacity = ipSession->inboundBuffer.numBytes;
+        session->inboundBuffer.limit = session->inboundBuffer.capacity;
+        session->inboundBufferIsPooled = false;
+        ReturnBufferPoolBlock(session->server, block);
+        HAPLogDebug(&logObject, "session:%p:returned inbound buffer pool block", (const void*) session);
+    }
+    if (session->outboundBufferIsPooled) {
+        HAPAssert(force || session->outboundBuffer.position == 0);
+        char* block = session->outboundBuffer.data;
+        session->outboundBuffer.data = ipSession->outboundBuffer.bytes;
+        session->outboundBuffer.capacity = ipSession->outboundBuffer.numBytes;
+        session->outboundBuffer.position = 0;
+        session->outboundBuffer.limit = session->outboundBuffer.capacity;
+        session->outboundBufferMark = 0;
+        session->outboundBufferIsPooled = false;
+        ReturnBufferPoolBlock(session->server, block);
+        HAPLogDebug(&logObject, "session:%p:returned outbound buffer pool block", (const void*) session);
+    }
+}
+
+/**
+ * Discards a completed request from the front of the inbound buffer.
+ *
+ * - The inbound buffer is advanced past the discarded bytes instead of moving the remaining data to the front.
+ *   Once no data remains, the inbound buffer is rewound.
+ *
+ * @param      session              IP session descriptor.
+ * @param      numBytes             Number of bytes to discard.
+ */
+static void DiscardInboundBytes(HAPIPSessionDescriptor* session, size_t numBytes) {
+    HAPPrecondition(session);
+    HAPIPByteBuffer* b = &session->inboundBuffer;
+    HAPPrecondition(b->data);
+    HAPPrecondition(numBytes <= b->position);
+    HAPPrecondition(b->position <= b->limit);
+    HAPPrecondition(b->limit <= b->capacity);
+
+    if (numBytes == b->limit) {
+        b->data -= session->inboundBufferOffset;
+        b->capacity += session->inboundBufferOffset;
+        b->position = 0;
+        b->limit = 0;
+        session->inboundBufferOffset = 0;
+        return;
+    }
+
+    b->data += numBytes;
+    b->capacity -= numBytes;
+    b->position -= numBytes;
+    b->limit -= numBytes;
+    session->inboundBufferOffset += numBytes;
+}
+
+/**
+ * Moves the data of the inbound buffer to the front to make room for more data.
+ *
+ * - The inbound buffer must be full.
+ *
+ * @param      session              IP session descriptor.
+ *
+ * @return true                     If room has been made.
+ * @return false                    If the inbound buffer already starts at the front.
+ */
+HAP_RESULT_USE_CHECK
+static bool CompactInboundBuffer(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPIPByteBuffer* b = &session->inboundBuffer;
+    HAPPrecondition(b->data);
+    HAPPrecondition(b->position == b->limit);
+    HAPPrecondition(b->limit == b->capacity);
+
+    if (!session->inboundBufferOffset) {
+        return false;
+    }
+
+    char* data = b->data;
+    char* base = data - session->inboundBufferOffset;
+    HAPRawBufferCopyBytes(base, data, b->position);
+    RebaseInboundToken(&session->httpMethod.bytes, data, base);
+    RebaseInboundToken(&session->httpURI.bytes, data, base);
+    RebaseInboundToken(&session->httpHeaderFieldName.bytes, data, base);
+    RebaseInboundToken(&session->httpHeaderFieldValue.bytes, data, base);
+    RebaseInboundToken(&session->httpReader.result_token, data, base);
+    b->data = base;
+    b->capacity += session->inboundBufferOffset;
+    b->limit = b->capacity;
+    session->inboundBufferOffset = 0;
+    return true;
+}
+
 static void prepare_reading_request(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
 
+    ReturnBufferPoolBlocks(session, /* force: */ false);
+
     util_http_reader_init(&session->httpReader, util_HTTP_READER_TYPE_REQUEST);
     session->httpReaderPosition = 0;
     session->httpParserError = false;
@@ -667,6 +1092,7 @@ static void write_characteristic_write_response(
             HAPAssert(!err && (session->outboundBuffer.position - mark == content_length));
         } else {
             HAPLog(&logObject, "Out of resources (outbound buffer too small).");
+            HAPMetricsIncrementCounter(session->server, numBufferFullConditions);
             session->outboundBuffer.position = mark;
             write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_OutOfResources);
         }
@@ -703,15 +1129,14 @@ static void schedule_event_notifications(HAPAccessoryServerRef* server_) {
 
     HAPError err;
 
-    for (size_t i = 0; i < server->ip.storage->numSessions; i++) {
-        HAPIPSession* ipSession = &server->ip.storage->sessions[i];
-        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-        if (!session->server) {
+    for (size_t i = 0; i < GetNumSessions(server); i++) {
+        const HAPIPSessionSlot* slot = GetSessionSlot(server, i);
+        if (!slot->isActive || (slot->state != kHAPIPSessionState_Reading) || !slot->numEventNotificationFlags) {
             continue;
         }
 
-        if ((session->state == kHAPIPSessionState_Reading) && (session->inboundBuffer.position == 0) &&
-            (session->numEventNotificationFlags > 0)) {
+        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &GetSession(server, i)->descriptor;
+        if (session->inboundBuffer.position == 0) {
             write_event_notifications(session);
         }
     }
@@ -719,17 +1144,17 @@ static void schedule_event_notifications(HAPAccessoryServerRef* server_) {
     HAPTime clock_now_ms = HAPPlatformClockGetCurrent();
     int64_t timeout_ms = -1;
 
-    for (size_t i = 0; i < server->ip.storage->numSessions; i++) {
-        HAPIPSession* ipSession = &server->ip.storage->sessions[i];
-        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-        if (!session->server) {
+    for (size_t i = 0; i < GetNumSessions(server); i++) {
+        const HAPIPSessionSlot* slot = GetSessionSlot(server, i);
+        if (!slot->isActive || (slot->state != kHAPIPSessionState_Reading) || !slot->numEventNotificationFlags) {
             continue;
         }
 
-        if ((session->state == kHAPIPSessionState_Reading) && (session->inboundBuffer.position == 0) &&
-            (session->numEventNotificationFlags > 0)) {
-            HAPAssert(clock_now_ms >= session->eventNotificationStamp);
-            HAPTime dt_ms = clock_now_ms - session->eventNotificationStamp;
+        const HAPIPSessionDescriptor* session =
+                (const HAPIPSessionDescriptor*) &GetSession(server, i)->descriptor;
+        if (session->inboundBuffer.position == 0) {
+            HAPAssert(clock_now_ms >= slot->eventNotificationStamp);
+            HAPTime dt_ms = clock_now_ms - slot->eventNotificationStamp;
             HAP_DIAGNOSTIC_PUSH
             HAP_DIAGNOSTIC_IGNORED_ARMCC(186)
             HAP_DIAGNOSTIC_IGNORED_GCC("-Wtype-limits")
@@ -841,13 +1266,95 @@ static int32_t ConvertCharacteristicWriteErrorToStatusCode(HAPError error) {
         case kHAPError_NotAuthorized: {
             return kHAPIPAccessoryServerStatusCode_InsufficientAuthorization;
         }
-        case kHAPError_Busy: {
+        case kHAPError_Busy:
+        case kHAPError_InProgress: {
             return kHAPIPAccessoryServerStatusCode_ResourceIsBusy;
         }
     }
     HAPFatalError();
 }
 
+/**
+ * Completes a characteristic write request after the write handler has been invoked.
+ *
+ * - If the characteristic supports write response, or if a response was requested, the value is read back.
+ *
+ * @param      session              IP session descriptor.
+ * @param      characteristic       The characteristic that has been written.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ * @param      context              Request context.
+ * @param      dataBuffer           Buffer for values of type data, string or TLV8.
+ */
+static void complete_characteristic_write_request(
+        HAPIPSessionDescriptor* session,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service,
+        const HAPAccessory* accessory,
+        HAPIPWriteContextRef* context,
+        HAPIPByteBuffer* dataBuffer) {
+    HAPPrecondition(session);
+    HAPPrecondition(characteristic);
+    HAPPrecondition(service);
+    HAPPrecondition(accessory);
+    HAPPrecondition(context);
+    HAPPrecondition(dataBuffer);
+
+    const HAPBaseCharacteristic* baseCharacteristic = characteristic;
+    HAPIPWriteContext* writeContext = (HAPIPWriteContext*) context;
+
+    if (writeContext->status == kHAPIPAccessoryServerStatusCode_Success) {
+        if (baseCharacteristic->properties.ip.supportsWriteResponse) {
+            HAPIPByteBuffer dataBufferSnapshot;
+            HAPRawBufferCopyBytes(&dataBufferSnapshot, dataBuffer, sizeof dataBufferSnapshot);
+            HAPIPReadContext readContext;
+            HAPRawBufferZero(&readContext, sizeof readContext);
+            readContext.aid = writeContext->aid;
+            readContext.iid = writeContext->iid;
+            handle_characteristic_read_request(
+                    session,
+                    characteristic,
+                    service,
+                    accessory,
+                    (HAPIPReadContextRef*) &readContext,
+                    dataBuffer);
+            writeContext->status = readContext.status;
+            writeContext->isPending = readContext.isPending;
+            if (writeContext->status == kHAPIPAccessoryServerStatusCode_Success) {
+                if (writeContext->response) {
+                    switch (baseCharacteristic->format) {
+                        case kHAPCharacteristicFormat_Bool:
+                        case kHAPCharacteristicFormat_UInt8:
+                        case kHAPCharacteristicFormat_UInt16:
+                        case kHAPCharacteristicFormat_UInt32:
+                        case kHAPCharacteristicFormat_UInt64: {
+                            writeContext->value.unsignedIntValue = readContext.value.unsignedIntValue;
+                        } break;
+                        case kHAPCharacteristicFormat_Int: {
+                            writeContext->value.intValue = readContext.value.intValue;
+                        } break;
+                        case kHAPCharacteristicFormat_Float: {
+                            writeContext->value.floatValue = readContext.value.floatValue;
+                        } break;
+                        case kHAPCharacteristicFormat_Data:
+                        case kHAPCharacteristicFormat_String:
+                        case kHAPCharacteristicFormat_TLV8: {
+                            writeContext->value.stringValue.bytes = readContext.value.stringValue.bytes;
+                            writeContext->value.stringValue.numBytes =
+                                    readContext.value.stringValue.numBytes;
+                        } break;
+                    }
+                } else {
+                    // Ignore value of read operation and revert possible changes to data buffer.
+                    HAPRawBufferCopyBytes(dataBuffer, &dataBufferSnapshot, sizeof *dataBuffer);
+                }
+            }
+        } else if (writeContext->response) {
+            writeContext->status = kHAPIPAccessoryServerStatusCode_ReadFromWriteOnlyCharacteristic;
+        }
+    }
+}
+
 static void handle_characteristic_write_request(
         HAPIPSessionDescriptor* session,
         const HAPCharacteristic* characteristic,
@@ -857,6 +1364,7 @@ static void handle_characteristic_write_request(
         HAPIPByteBuffer* dataBuffer) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
     HAPPrecondition(session->securitySession.type == kHAPIPSecuritySessionType_HAP);
     HAPPrecondition(session->securitySession.isOpen);
     HAPPrecondition(session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled);
@@ -915,8 +1423,8 @@ static void handle_characteristic_write_request(
             } else if (writeContext->ev == kHAPIPEventNotificationState_Disabled) {
                 session->numEventNotifications--;
                 if (((HAPIPEventNotification*) &session->eventNotifications[i])->flag) {
-                    HAPAssert(session->numEventNotificationFlags > 0);
-                    session->numEventNotificationFlags--;
+                    HAPAssert(session->slot->numEventNotificationFlags > 0);
+                    session->slot->numEventNotificationFlags--;
                 }
                 while (i < session->numEventNotifications) {
                     HAPRawBufferCopyBytes(
@@ -962,6 +1470,7 @@ static void handle_characteristic_write_request(
                 }
             }
             if (writeContext->status == kHAPIPAccessoryServerStatusCode_Success) {
+                size_t numBatchWrites = server->batchWrite.numWrites;
                 switch (baseCharacteristic->format) {
                     case kHAPCharacteristicFormat_Data: {
                         if (writeContext->type == kHAPIPWriteValueType_String) {
@@ -989,6 +1498,7 @@ static void handle_characteristic_write_request(
                                         writeContext->value.stringValue.numBytes,
                                         HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                                 writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
+                                writeContext->isPending = err == kHAPError_InProgress;
                             } else {
                                 writeContext->status = kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
                             }
@@ -1013,6 +1523,7 @@ static void handle_characteristic_write_request(
                                     (bool) writeContext->value.unsignedIntValue,
                                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                             writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
+                            writeContext->isPending = err == kHAPError_InProgress;
                         } else {
                             writeContext->status = kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
                         }
@@ -1034,6 +1545,7 @@ static void handle_characteristic_write_request(
                                     (uint8_t) writeContext->value.unsignedIntValue,
                                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                             writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
+                            writeContext->isPending = err == kHAPError_InProgress;
                         } else {
                             writeContext->status = kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
                         }
@@ -1055,6 +1567,7 @@ static void handle_characteristic_write_request(
                                     (uint16_t) writeContext->value.unsignedIntValue,
                                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                             writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
+                            writeContext->isPending = err == kHAPError_InProgress;
                         } else {
                             writeContext->status = kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
                         }
@@ -1076,6 +1589,7 @@ static void handle_characteristic_write_request(
                                     (uint32_t) writeContext->value.unsignedIntValue,
                                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                             writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
+                            writeContext->isPending = err == kHAPError_InProgress;
                         } else {
                             writeContext->status = kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
                         }
@@ -1096,6 +1610,7 @@ static void handle_characteristic_write_request(
                                     writeContext->value.unsignedIntValue,
                                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                             writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
+                            writeContext->isPending = err == kHAPError_InProgress;
                         } else {
                             writeContext->status = kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
                         }
@@ -1121,6 +1636,7 @@ static void handle_characteristic_write_request(
                                     writeContext->value.intValue,
                                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                             writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
+                            writeContext->isPending = err == kHAPError_InProgress;
                         } else {
                             writeContext->status = kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
                         }
@@ -1151,6 +1667,7 @@ static void handle_characteristic_write_request(
                                     writeContext->value.floatValue,
                                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                             writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
+                            writeContext->isPending = err == kHAPError_InProgress;
                         } else {
                             writeContext->status = kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
                         }
@@ -1185,6 +1702,11 @@ static void handle_characteristic_write_request(
                                         &dataBuffer->data[dataBuffer->position],
                                         HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                                 writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
+                                writeContext->isPending = err == kHAPError_InProgress;
+                                if (server->batchWrite.numWrites != numBatchWrites) {
+                                    // Keep the value until the service batch write handler has been invoked.
+                                    dataBuffer->position += writeContext->value.stringValue.numBytes + 1;
+                                }
                             }
                         } else {
                             writeContext->status = kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
@@ -1219,60 +1741,19 @@ static void handle_characteristic_write_request(
                                         &tlvReader,
                                         HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                                 writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
+                                writeContext->isPending = err == kHAPError_InProgress;
                             } else {
                                 writeContext->status = kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
                             }
                         }
                     } break;
                 }
-                if (writeContext->status == kHAPIPAccessoryServerStatusCode_Success) {
-                    if (baseCharacteristic->properties.ip.supportsWriteResponse) {
-                        HAPIPByteBuffer dataBufferSnapshot;
-                        HAPRawBufferCopyBytes(&dataBufferSnapshot, dataBuffer, sizeof dataBufferSnapshot);
-                        HAPIPReadContext readContext;
-                        HAPRawBufferZero(&readContext, sizeof readContext);
-                        readContext.aid = writeContext->aid;
-                        readContext.iid = writeContext->iid;
-                        handle_characteristic_read_request(
-                                session,
-                                characteristic,
-                                service,
-                                accessory,
-                                (HAPIPReadContextRef*) &readContext,
-                                dataBuffer);
-                        writeContext->status = readContext.status;
-                        if (writeContext->status == kHAPIPAccessoryServerStatusCode_Success) {
-                            if (writeContext->response) {
-                                switch (baseCharacteristic->format) {
-                                    case kHAPCharacteristicFormat_Bool:
-                                    case kHAPCharacteristicFormat_UInt8:
-                                    case kHAPCharacteristicFormat_UInt16:
-                                    case kHAPCharacteristicFormat_UInt32:
-                                    case kHAPCharacteristicFormat_UInt64: {
-                                        writeContext->value.unsignedIntValue = readContext.value.unsignedIntValue;
-                                    } break;
-                                    case kHAPCharacteristicFormat_Int: {
-                                        writeContext->value.intValue = readContext.value.intValue;
-                                    } break;
-                                    case kHAPCharacteristicFormat_Float: {
-                                        writeContext->value.floatValue = readContext.value.floatValue;
-                                    } break;
-                                    case kHAPCharacteristicFormat_Data:
-                                    case kHAPCharacteristicFormat_String:
-                                    case kHAPCharacteristicFormat_TLV8: {
-                                        writeContext->value.stringValue.bytes = readContext.value.stringValue.bytes;
-                                        writeContext->value.stringValue.numBytes =
-                                                readContext.value.stringValue.numBytes;
-                                    } break;
-                                }
-                            } else {
-                                // Ignore value of read operation and revert possible changes to data buffer.
-                                HAPRawBufferCopyBytes(dataBuffer, &dataBufferSnapshot, sizeof *dataBuffer);
-                            }
-                        }
-                    } else if (writeContext->response) {
-                        writeContext->status = kHAPIPAccessoryServerStatusCode_ReadFromWriteOnlyCharacteristic;
-                    }
+                if (server->batchWrite.numWrites != numBatchWrites) {
+                    // Completed once the service batch write handler has been invoked.
+                    writeContext->isBatched = true;
+                } else {
+                    complete_characteristic_write_request(
+                            session, characteristic, service, accessory, context, dataBuffer);
                 }
             }
         } else {
@@ -1281,9 +1762,475 @@ static void handle_characteristic_write_request(
     }
 }
 
+/**
+ * Handles a characteristic write request that is part of a set of characteristic write requests.
+ *
+ * @param      session              IP session descriptor.
+ * @param      characteristic       The characteristic whose value is to be written.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ * @param      context              Request context.
+ * @param      dataBuffer           Buffer for values of type data, string or TLV8.
+ * @param      timedWrite           Whether the request was a valid Execute Write Request or a regular Write Request.
+ */
+static void handle_characteristic_write_request_in_set(
+        HAPIPSessionDescriptor* session,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service,
+        const HAPAccessory* accessory,
+        HAPIPWriteContextRef* context,
+        HAPIPByteBuffer* dataBuffer,
+        bool timedWrite) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(characteristic);
+    HAPPrecondition(service);
+    HAPPrecondition(accessory);
+    HAPPrecondition(context);
+    HAPPrecondition(dataBuffer);
+
+    HAPIPWriteContext* writeContext = (HAPIPWriteContext*) context;
+
+    server->ip.characteristicWriteRequestContext.ipSession = GetIPSession(session);
+    server->ip.characteristicWriteRequestContext.characteristic = characteristic;
+    server->ip.characteristicWriteRequestContext.service = service;
+    server->ip.characteristicWriteRequestContext.accessory = accessory;
+    const HAPBaseCharacteristic* baseCharacteristic = characteristic;
+    if ((writeContext->type != kHAPIPWriteValueType_None) && baseCharacteristic->properties.requiresTimedWrite &&
+        !timedWrite) {
+        // If the accessory receives a standard write request on a characteristic which requires timed write,
+        // the accessory must respond with HAP status error code -70410 (HAPIPStatusErrorCodeInvalidWrite).
+        // See HomeKit Accessory Protocol Specification R14
+        // Section 6.7.2.4 Timed Write Procedures
+        HAPLogCharacteristic(
+                &logObject, characteristic, service, accessory, "Rejected write: Only timed writes are supported.");
+        writeContext->status = kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
+    } else {
+        handle_characteristic_write_request(session, characteristic, service, accessory, context, dataBuffer);
+    }
+    server->ip.characteristicWriteRequestContext.ipSession = NULL;
+    server->ip.characteristicWriteRequestContext.characteristic = NULL;
+    server->ip.characteristicWriteRequestContext.service = NULL;
+    server->ip.characteristicWriteRequestContext.accessory = NULL;
+}
+
+/**
+ * Allocates memory for service batch writes from a data buffer.
+ *
+ * @param      dataBuffer           Buffer for values of type data, string or TLV8.
+ * @param      numWrites            Number of batch writes.
+ *
+ * @return Batch writes, if successful. NULL if the data buffer is too small.
+ */
+HAP_RESULT_USE_CHECK
+static HAPCharacteristicBatchWrite* _Nullable AllocateBatchWrites(HAPIPByteBuffer* dataBuffer, size_t numWrites) {
+    HAPPrecondition(dataBuffer);
+    HAPPrecondition(dataBuffer->data);
+    HAPPrecondition(dataBuffer->position <= dataBuffer->limit);
+    HAPPrecondition(dataBuffer->limit <= dataBuffer->capacity);
+
+    HAP_DIAGNOSTIC_PUSH
+    HAP_DIAGNOSTIC_IGNORED_MSVC(4146)
+    uintptr_t o = (uintptr_t)(-(uintptr_t) &dataBuffer->data[dataBuffer->position] & (sizeof(uint64_t) - 1));
+    HAP_DIAGNOSTIC_POP
+    size_t numBytes = dataBuffer->limit - dataBuffer->position;
+    if (numBytes < o || (numBytes - o) / sizeof(HAPCharacteristicBatchWrite) < numWrites) {
+        return NULL;
+    }
+    HAPCharacteristicBatchWrite* writes = (void*) &dataBuffer->data[dataBuffer->position + o];
+    dataBuffer->position += o + numWrites * sizeof(HAPCharacteristicBatchWrite);
+    return writes;
+}
+
+/**
+ * Handles all characteristic write requests of a set that target a service with a batch write handler.
+ *
+ * - Values are validated individually and then handed over to the service batch write handler together.
+ *
+ * @param      session              IP session descriptor.
+ * @param      service              The service that provides a batch write handler.
+ * @param      accessory            The accessory that provides the service.
+ * @param      contexts             Request contexts. Contexts that target other services are ignored.
+ * @param      numContexts          Length of @p contexts.
+ * @param      dataBuffer           Buffer for values of type data, string or TLV8.
+ * @param      timedWrite           Whether the request was a valid Execute Write Request or a regular Write Request.
+ */
+static void handle_service_batch_write_requests(
+        HAPIPSessionDescriptor* session,
+        const HAPService* service,
+        const HAPAccessory* accessory,
+        HAPIPWriteContextRef* contexts,
+        size_t numContexts,
+        HAPIPByteBuffer* dataBuffer,
+        bool timedWrite) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(service);
+    HAPPrecondition(service->callbacks.handleBatchWrite);
+    HAPPrecondition(accessory);
+    HAPPrecondition(contexts);
+    HAPPrecondition(dataBuffer);
+
+    const HAPCharacteristic* characteristic;
+    const HAPService* characteristicService;
+    const HAPAccessory* characteristicAccessory;
+
+    size_t maxWrites = 0;
+    for (size_t i = 0; i < numContexts; i++) {
+        HAPIPWriteContext* writeContext = (HAPIPWriteContext*) &contexts[i];
+        get_db_ctx(
+                session->server,
+                writeContext->aid,
+                writeContext->iid,
+                &characteristic,
+                &characteristicService,
+                &characteristicAccessory);
+        if (!characteristic || characteristicService != service || characteristicAccessory != accessory) {
+            continue;
+        }
+        writeContext->isHandled = true;
+        maxWrites++;
+    }
+    HAPAssert(maxWrites);
+
+    HAPCharacteristicBatchWrite* _Nullable writes = AllocateBatchWrites(dataBuffer, maxWrites);
+    if (!writes) {
+        HAPLogService(&logObject, service, accessory, "Out of resources (data buffer too small for batch write).");
+        HAPMetricsIncrementCounter(session->server, numBufferFullConditions);
+    } else {
+        HAPServiceBeginBatchWrite(session->server, service, HAPNonnull(writes), maxWrites);
+    }
+
+    // Collect values.
+    for (size_t i = 0; i < numContexts; i++) {
+        HAPIPWriteContext* writeContext = (HAPIPWriteContext*) &contexts[i];
+        get_db_ctx(
+                session->server,
+                writeContext->aid,
+                writeContext->iid,
+                &characteristic,
+                &characteristicService,
+                &characteristicAccessory);
+        if (!characteristic || characteristicService != service || characteristicAccessory != accessory) {
+            continue;
+        }
+        if (!writes) {
+            writeContext->status = kHAPIPAccessoryServerStatusCode_OutOfResources;
+            continue;
+        }
+        handle_characteristic_write_request_in_set(
+                session, HAPNonnull(characteristic), service, accessory, &contexts[i], dataBuffer, timedWrite);
+    }
+    if (!writes) {
+        return;
+    }
+
+    // Call batch write handler.
+    server->ip.characteristicWriteRequestContext.ipSession = GetIPSession(session);
+    server->ip.characteristicWriteRequestContext.characteristic = NULL;
+    server->ip.characteristicWriteRequestContext.service = service;
+    server->ip.characteristicWriteRequestContext.accessory = accessory;
+    size_t numWrites = HAPServiceEndBatchWrite(
+            session->server,
+            &(const HAPServiceRequest) { .transportType = kHAPTransportType_IP,
+                                         .session = &session->securitySession._.hap,
+                                         .service = service,
+                                         .accessory = accessory },
+            HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
+    server->ip.characteristicWriteRequestContext.ipSession = NULL;
+    server->ip.characteristicWriteRequestContext.service = NULL;
+    server->ip.characteristicWriteRequestContext.accessory = NULL;
+
+    // Complete requests. Batch writes are stored in the same order as the contexts.
+    size_t n = 0;
+    for (size_t i = 0; i < numContexts; i++) {
+        HAPIPWriteContext* writeContext = (HAPIPWriteContext*) &contexts[i];
+        if (!writeContext->isBatched) {
+            continue;
+        }
+        HAPAssert(n < numWrites);
+        const HAPCharacteristicBatchWrite* write = &HAPNonnull(writes)[n];
+        n++;
+        HAPAssert(((const HAPBaseCharacteristic*) write->characteristic)->iid == writeContext->iid);
+        writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(write->status);
+        writeContext->isPending = write->status == kHAPError_InProgress;
+        complete_characteristic_write_request(
+                session, write->characteristic, service, accessory, &contexts[i], dataBuffer);
+    }
+    HAPAssert(n == numWrites);
+}
+
+/**
+ * Returns the recorded request at a given position of the current HTTP transaction.
+ *
+ * @param      session              IP session descriptor.
+ * @param      index                Position of the request in the transaction.
+ * @param      characteristic       The characteristic of the request.
+ * @param      accessory            The accessory that provides the characteristic.
+ *
+ * @return Recorded request, if the transaction is processed again after deferred requests have been completed.
+ *         NULL otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static const HAPIPDeferredRequest* _Nullable GetDeferredRequest(
+        const HAPIPSessionDescriptor* session,
+        size_t index,
+        const HAPCharacteristic* characteristic,
+        const HAPAccessory* accessory) {
+    HAPPrecondition(session);
+    HAPPrecondition(characteristic);
+    HAPPrecondition(accessory);
+
+    if (!session->deferredTransaction) {
+        return NULL;
+    }
+    const HAPIPDeferredTransaction* transaction = HAPNonnull(session->deferredTransaction);
+    if (index >= transaction->numRequests) {
+        return NULL;
+    }
+    const HAPIPDeferredRequest* deferredRequest = &transaction->requests[index];
+    if ((deferredRequest->iid != ((const HAPBaseCharacteristic*) characteristic)->iid) ||
+        (deferredRequest->aid != accessory->aid)) {
+        return NULL;
+    }
+    return deferredRequest;
+}
+
+/**
+ * Prepares recording the requests of the current HTTP transaction after some of them have been deferred.
+ *
+ * - Transactions with more than kHAPIPSession_MaxDeferredRequests requests cannot be deferred.
+ *   Their deferred requests are reported as busy instead.
+ *
+ * - If more than kHAPIPAccessoryServer_MaxDeferredTransactions sessions would be waiting,
+ *   the deferred requests are reported as busy instead.
+ *
+ * - Requests that are deferred again while the transaction is processed after its deferred requests have been
+ *   completed are reported as busy instead. This bounds the time that a session waits.
+ *
+ * @param      session              IP session descriptor.
+ * @param      numRequests          Number of requests in the transaction.
+ * @param      numPendingRequests   Number of requests that have been deferred.
+ *
+ * @return true                     If the requests of the transaction must be recorded.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool BeginDeferredRequests(HAPIPSessionDescriptor* session, size_t numRequests, size_t numPendingRequests) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->slot);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(numPendingRequests <= numRequests);
+
+    if (!numPendingRequests) {
+        return false;
+    }
+    if (session->deferredTransaction) {
+        HAPLog(&logObject,
+               "session:%p:Reporting %zu deferred requests as busy: Transaction has already been deferred.",
+               (const void*) session,
+               numPendingRequests);
+        return false;
+    }
+    if (numRequests > kHAPIPSession_MaxDeferredRequests) {
+        HAPLog(&logObject,
+               "session:%p:Reporting %zu deferred requests as busy: Transaction has too many requests (%zu).",
+               (const void*) session,
+               numPendingRequests,
+               numRequests);
+        return false;
+    }
+    HAPIPDeferredTransaction* _Nullable transaction = NULL;
+    for (size_t i = 0; i < HAPArrayCount(server->ip.deferredTransactions); i++) {
+        if (!server->ip.deferredTransactions[i].isActive) {
+            transaction = &server->ip.deferredTransactions[i];
+            break;
+        }
+    }
+    if (!transaction) {
+        HAPLog(&logObject,
+               "session:%p:Reporting %zu deferred requests as busy: Too many sessions are waiting.",
+               (const void*) session,
+               numPendingRequests);
+        return false;
+    }
+    HAPLogDebug(&logObject, "session:%p:waiting for %zu deferred requests", (const void*) session, numPendingRequests);
+    HAPRawBufferZero(HAPNonnull(transaction), sizeof *transaction);
+    transaction->isActive = true;
+    transaction->numRequests = (uint8_t) numRequests;
+    transaction->numPendingRequests = (uint8_t) numPendingRequests;
+    session->deferredTransaction = transaction;
+    session->slot->state = kHAPIPSessionState_Waiting;
+    session->slot->stamp = HAPPlatformClockGetCurrent();
+    ScheduleDeferredRequestTimer(session->server);
+    return true;
+}
+
+/**
+ * Starts collecting completions of deferred requests while the handlers of the current HTTP transaction are invoked.
+ *
+ * - The application may complete a request before the session is waiting for it, e.g., from within the handler
+ *   that returned kHAPError_InProgress. Such completions are applied by EndCharacteristicRequests.
+ *
+ * @param      session              IP session descriptor.
+ */
+static void BeginCharacteristicRequests(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(!server->ip.earlyCompletions.session);
+
+    HAPRawBufferZero(&server->ip.earlyCompletions, sizeof server->ip.earlyCompletions);
+    server->ip.earlyCompletions.session = session;
+}
+
+/**
+ * Applies the completions that have been collected while the handlers of the current HTTP transaction were invoked,
+ * and stops collecting them.
+ *
+ * - If the transaction has not been deferred, its deferred requests are reported as busy,
+ *   and the collected completions are discarded.
+ *
+ * - If all deferred requests have been completed, the transaction is processed again
+ *   once control has returned to the run loop.
+ *
+ * @param      session              IP session descriptor.
+ */
+static void EndCharacteristicRequests(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(server->ip.earlyCompletions.session == session);
+
+    if (session->slot->state == kHAPIPSessionState_Waiting) {
+        HAPAssert(session->deferredTransaction);
+        HAPIPDeferredTransaction* transaction = HAPNonnull(session->deferredTransaction);
+        for (size_t i = 0; i < server->ip.earlyCompletions.numRequests; i++) {
+            const uint64_t aid = server->ip.earlyCompletions.requests[i].aid;
+            const uint64_t iid = server->ip.earlyCompletions.requests[i].iid;
+            HAPIPDeferredRequest* _Nullable deferredRequest = NULL;
+            for (size_t j = 0; j < transaction->numRequests; j++) {
+                HAPIPDeferredRequest* t = &transaction->requests[j];
+                if (t->isPending && (t->iid == iid) && (t->aid == aid)) {
+                    deferredRequest = t;
+                    break;
+                }
+            }
+            if (!deferredRequest) {
+                HAPLogInfo(
+                        &logObject,
+                        "session:%p:Ignoring completion of aid %llu iid %llu: Request is not pending.",
+                        (const void*) session,
+                        (unsigned long long) aid,
+                        (unsigned long long) iid);
+                continue;
+            }
+            deferredRequest->error = server->ip.earlyCompletions.requests[i].error;
+            deferredRequest->isPending = false;
+            HAPAssert(transaction->numPendingRequests);
+            transaction->numPendingRequests--;
+        }
+        if (!transaction->numPendingRequests) {
+            ScheduleDeferredRequestTimer(session->server);
+        }
+    } else if (server->ip.earlyCompletions.numRequests) {
+        HAPLog(&logObject,
+               "session:%p:Ignoring %zu completions: Transaction has not been deferred.",
+               (const void*) session,
+               server->ip.earlyCompletions.numRequests);
+    }
+    HAPRawBufferZero(&server->ip.earlyCompletions, sizeof server->ip.earlyCompletions);
+}
+
+/**
+ * Records a request of the current HTTP transaction.
+ *
+ * @param      session              IP session descriptor.
+ * @param      index                Position of the request in the transaction.
+ * @param      aid                  Accessory instance ID.
+ * @param      iid                  Characteristic instance ID.
+ * @param      status               HAP status code of the request.
+ * @param      response             Whether the value is included in the response of a write request.
+ * @param      isPending            Whether the request has been deferred.
+ */
+static void RecordDeferredRequest(
+        HAPIPSessionDescriptor* session,
+        size_t index,
+        uint64_t aid,
+        uint64_t iid,
+        int32_t status,
+        bool response,
+        bool isPending) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->deferredTransaction);
+    HAPIPDeferredTransaction* transaction = HAPNonnull(session->deferredTransaction);
+    HAPPrecondition(index < transaction->numRequests);
+
+    HAPIPDeferredRequest* deferredRequest = &transaction->requests[index];
+    deferredRequest->aid = aid;
+    deferredRequest->iid = iid;
+    deferredRequest->status = status;
+    deferredRequest->error = kHAPError_None;
+    deferredRequest->response = response;
+    deferredRequest->isDeferred = isPending;
+    deferredRequest->isPending = isPending;
+}
+
+/**
+ * Records the results of a set of characteristic write requests if any of them has been deferred.
+ *
+ * - Once all deferred requests have been completed, the response is built from the recorded results.
+ *   The request body is not parsed a second time, as parsing has already decoded values in place.
+ *
+ * @param      session              IP session descriptor.
+ * @param      contexts             Request contexts.
+ * @param      numContexts          Length of @p contexts.
+ *
+ * @return true                     If the response must be deferred until all deferred requests have been completed.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool DeferCharacteristicWriteRequests(
+        HAPIPSessionDescriptor* session,
+        HAPIPWriteContextRef* contexts,
+        size_t numContexts) {
+    HAPPrecondition(session);
+    HAPPrecondition(contexts);
+
+    size_t numPendingRequests = 0;
+    for (size_t i = 0; i < numContexts; i++) {
+        if (((const HAPIPWriteContext*) &contexts[i])->isPending) {
+            numPendingRequests++;
+        }
+    }
+    if (!BeginDeferredRequests(session, numContexts, numPendingRequests)) {
+        EndCharacteristicRequests(session);
+        return false;
+    }
+    for (size_t i = 0; i < numContexts; i++) {
+        const HAPIPWriteContext* writeContext = (const HAPIPWriteContext*) &contexts[i];
+        RecordDeferredRequest(
+                session,
+                i,
+                writeContext->aid,
+                writeContext->iid,
+                writeContext->status,
+                writeContext->response,
+                writeContext->isPending);
+    }
+    EndCharacteristicRequests(session);
+    return true;
+}
+
 /**
  * Handles a set of characteristic write requests.
  *
+ * - Write requests that target a service with a batch write handler are handed over together,
+ *   after all other write requests of the set have been handled.
+ *
  * @param      session              IP session descriptor.
  * @param      contexts             Request contexts.
  * @param      numContexts          Length of @p contexts.
@@ -1302,7 +2249,6 @@ static int handle_characteristic_write_requests(
         bool timedWrite) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
-    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
     HAPPrecondition(session->securitySession.type == kHAPIPSecuritySessionType_HAP);
     HAPPrecondition(session->securitySession.isOpen);
     HAPPrecondition(session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled);
@@ -1310,8 +2256,7 @@ static int handle_characteristic_write_requests(
     HAPPrecondition(contexts);
     HAPPrecondition(dataBuffer);
 
-    int r = 0;
-
+    bool hasBatchWrites = false;
     for (size_t i = 0; i < numContexts; i++) {
         HAPIPWriteContext* writeContext = (HAPIPWriteContext*) &contexts[i];
         const HAPCharacteristic* characteristic;
@@ -1321,53 +2266,105 @@ static int handle_characteristic_write_requests(
         if (characteristic) {
             HAPAssert(service);
             HAPAssert(accessory);
-            server->ip.characteristicWriteRequestContext.ipSession = NULL;
-            for (size_t j = 0; j < server->ip.storage->numSessions; j++) {
-                HAPIPSession* ipSession = &server->ip.storage->sessions[j];
-                HAPIPSessionDescriptor* t = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-                if (t->server && (t == session)) {
-                    HAPAssert(!server->ip.characteristicWriteRequestContext.ipSession);
-                    server->ip.characteristicWriteRequestContext.ipSession = ipSession;
-                }
-            }
-            HAPAssert(server->ip.characteristicWriteRequestContext.ipSession);
-            server->ip.characteristicWriteRequestContext.characteristic = characteristic;
-            server->ip.characteristicWriteRequestContext.service = service;
-            server->ip.characteristicWriteRequestContext.accessory = accessory;
-            const HAPBaseCharacteristic* baseCharacteristic = characteristic;
-            if ((writeContext->type != kHAPIPWriteValueType_None) &&
-                baseCharacteristic->properties.requiresTimedWrite && !timedWrite) {
-                // If the accessory receives a standard write request on a characteristic which requires timed write,
-                // the accessory must respond with HAP status error code -70410 (HAPIPStatusErrorCodeInvalidWrite).
-                // See HomeKit Accessory Protocol Specification R14
-                // Section 6.7.2.4 Timed Write Procedures
-                HAPLogCharacteristic(
-                        &logObject,
-                        characteristic,
-                        service,
-                        accessory,
-                        "Rejected write: Only timed writes are supported.");
-                writeContext->status = kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
+            if (service->callbacks.handleBatchWrite) {
+                hasBatchWrites = true;
+                continue;
             } else {
-                handle_characteristic_write_request(
-                        session, characteristic, service, accessory, &contexts[i], dataBuffer);
+                handle_characteristic_write_request_in_set(
+                        session, characteristic, service, accessory, &contexts[i], dataBuffer, timedWrite);
             }
-            server->ip.characteristicWriteRequestContext.ipSession = NULL;
-            server->ip.characteristicWriteRequestContext.characteristic = NULL;
-            server->ip.characteristicWriteRequestContext.service = NULL;
-            server->ip.characteristicWriteRequestContext.accessory = NULL;
         } else {
             writeContext->status = kHAPIPAccessoryServerStatusCode_ResourceDoesNotExist;
         }
-        if ((r == 0) && (writeContext->status != kHAPIPAccessoryServerStatusCode_Success)) {
+        writeContext->isHandled = true;
+    }
+
+    if (hasBatchWrites) {
+        for (size_t i = 0; i < numContexts; i++) {
+            HAPIPWriteContext* writeContext = (HAPIPWriteContext*) &contexts[i];
+            if (writeContext->isHandled) {
+                continue;
+            }
+            const HAPCharacteristic* characteristic;
+            const HAPService* service;
+            const HAPAccessory* accessory;
+            get_db_ctx(session->server, writeContext->aid, writeContext->iid, &characteristic, &service, &accessory);
+            HAPAssert(characteristic);
+            handle_service_batch_write_requests(
+                    session, HAPNonnull(service), HAPNonnull(accessory), contexts, numContexts, dataBuffer, timedWrite);
+            HAPAssert(writeContext->isHandled);
+        }
+    }
+
+    int r = 0;
+    for (size_t i = 0; i < numContexts; i++) {
+        HAPIPWriteContext* writeContext = (HAPIPWriteContext*) &contexts[i];
+        if ((writeContext->status != kHAPIPAccessoryServerStatusCode_Success) || writeContext->response) {
             r = -1;
         }
-        if ((r == 0) && writeContext->response) {
+    }
+
+    return r;
+}
+
+/**
+ * Sends the response to a PUT /characteristics request after all its deferred requests have been completed.
+ *
+ * - The response is built from the recorded results. Values are read back again where the response includes them.
+ *
+ * @param      session              IP session descriptor.
+ */
+static void write_deferred_characteristic_write_response(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(session->deferredTransaction);
+    const HAPIPDeferredTransaction* transaction = HAPNonnull(session->deferredTransaction);
+    HAPPrecondition(transaction->numRequests <= server->ip.storage->numWriteContexts);
+
+    HAPIPByteBuffer dataBuffer;
+    dataBuffer.data = HAPNonnull(server->ip.scratchBuffer.bytes);
+    dataBuffer.capacity = server->ip.scratchBuffer.numBytes;
+    dataBuffer.limit = server->ip.scratchBuffer.numBytes;
+    dataBuffer.position = 0;
+
+    int r = 0;
+    for (size_t i = 0; i < transaction->numRequests; i++) {
+        const HAPIPDeferredRequest* deferredRequest = &transaction->requests[i];
+        HAPAssert(!deferredRequest->isPending);
+        HAPIPWriteContext* writeContext = (HAPIPWriteContext*) &server->ip.storage->writeContexts[i];
+        HAPRawBufferZero(writeContext, sizeof *writeContext);
+        writeContext->aid = deferredRequest->aid;
+        writeContext->iid = deferredRequest->iid;
+        writeContext->response = deferredRequest->response;
+        writeContext->status = deferredRequest->isDeferred ?
+                                       ConvertCharacteristicWriteErrorToStatusCode(deferredRequest->error) :
+                                       deferredRequest->status;
+        if (deferredRequest->isDeferred || deferredRequest->response) {
+            const HAPCharacteristic* characteristic;
+            const HAPService* service;
+            const HAPAccessory* accessory;
+            get_db_ctx(session->server, writeContext->aid, writeContext->iid, &characteristic, &service, &accessory);
+            if (characteristic) {
+                complete_characteristic_write_request(
+                        session,
+                        HAPNonnull(characteristic),
+                        HAPNonnull(service),
+                        HAPNonnull(accessory),
+                        &server->ip.storage->writeContexts[i],
+                        &dataBuffer);
+            }
+        }
+        if ((writeContext->status != kHAPIPAccessoryServerStatusCode_Success) || writeContext->response) {
             r = -1;
         }
     }
 
-    return r;
+    if (r == 0) {
+        write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_NoContent);
+    } else {
+        write_characteristic_write_response(session, server->ip.storage->writeContexts, transaction->numRequests);
+    }
 }
 
 static void put_characteristics(HAPIPSessionDescriptor* session) {
@@ -1386,6 +2383,12 @@ static void put_characteristics(HAPIPSessionDescriptor* session) {
     uint64_t pid;
     HAPIPByteBuffer data_buffer;
 
+    if (session->deferredTransaction) {
+        // The request body has already been decoded in place when the transaction was deferred.
+        write_deferred_characteristic_write_response(session);
+        return;
+    }
+
     HAPAssert(session->inboundBuffer.data);
     HAPAssert(session->inboundBuffer.position <= session->inboundBuffer.limit);
     HAPAssert(session->inboundBuffer.limit <= session->inboundBuffer.capacity);
@@ -1419,16 +2422,19 @@ static void put_characteristics(HAPIPSessionDescriptor* session) {
             } else if (contexts_count == 0) {
                 write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_NoContent);
             } else {
-                data_buffer.data = server->ip.storage->scratchBuffer.bytes;
-                data_buffer.capacity = server->ip.storage->scratchBuffer.numBytes;
-                data_buffer.limit = server->ip.storage->scratchBuffer.numBytes;
+                data_buffer.data = HAPNonnull(server->ip.scratchBuffer.bytes);
+                data_buffer.capacity = server->ip.scratchBuffer.numBytes;
+                data_buffer.limit = server->ip.scratchBuffer.numBytes;
                 data_buffer.position = 0;
                 HAPAssert(data_buffer.data);
                 HAPAssert(data_buffer.position <= data_buffer.limit);
                 HAPAssert(data_buffer.limit <= data_buffer.capacity);
+                BeginCharacteristicRequests(session);
                 r = handle_characteristic_write_requests(
                         session, server->ip.storage->writeContexts, contexts_count, &data_buffer, pid_valid);
-                if (r == 0) {
+                if (DeferCharacteristicWriteRequests(session, server->ip.storage->writeContexts, contexts_count)) {
+                    // Response is sent once all deferred requests have been completed.
+                } else if (r == 0) {
                     write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_NoContent);
                 } else {
                     write_characteristic_write_response(session, server->ip.storage->writeContexts, contexts_count);
@@ -1479,7 +2485,8 @@ static int32_t ConvertCharacteristicReadErrorToStatusCode(HAPError error) {
         case kHAPError_NotAuthorized: {
             return kHAPIPAccessoryServerStatusCode_InsufficientAuthorization;
         }
-        case kHAPError_Busy: {
+        case kHAPError_Busy:
+        case kHAPError_InProgress: {
             return kHAPIPAccessoryServerStatusCode_ResourceIsBusy;
         }
     }
@@ -1536,6 +2543,7 @@ static void handle_characteristic_read_request(
                     &sval_length,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
+            readContext->isPending = err == kHAPError_InProgress;
             if (readContext->status == kHAPIPAccessoryServerStatusCode_Success) {
                 if (sval_length <= data_buffer->limit - data_buffer->position) {
                     util_base64_encode(
@@ -1570,6 +2578,7 @@ static void handle_characteristic_read_request(
                     &bool_val,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
+            readContext->isPending = err == kHAPError_InProgress;
             if (readContext->status == kHAPIPAccessoryServerStatusCode_Success) {
                 readContext->value.unsignedIntValue = bool_val ? 1 : 0;
             }
@@ -1585,6 +2594,7 @@ static void handle_characteristic_read_request(
                     &uint8_val,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
+            readContext->isPending = err == kHAPError_InProgress;
             if (readContext->status == kHAPIPAccessoryServerStatusCode_Success) {
                 readContext->value.unsignedIntValue = uint8_val;
             }
@@ -1601,6 +2611,7 @@ static void handle_characteristic_read_request(
                     &uint16_val,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
+            readContext->isPending = err == kHAPError_InProgress;
             if (readContext->status == kHAPIPAccessoryServerStatusCode_Success) {
                 readContext->value.unsignedIntValue = uint16_val;
             }
@@ -1617,6 +2628,7 @@ static void handle_characteristic_read_request(
                     &uint32_val,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
+            readContext->isPending = err == kHAPError_InProgress;
             if (readContext->status == kHAPIPAccessoryServerStatusCode_Success) {
                 readContext->value.unsignedIntValue = uint32_val;
             }
@@ -1633,6 +2645,7 @@ static void handle_characteristic_read_request(
                     &uint64_val,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
+            readContext->isPending = err == kHAPError_InProgress;
             if (readContext->status == kHAPIPAccessoryServerStatusCode_Success) {
                 readContext->value.unsignedIntValue = uint64_val;
             }
@@ -1648,6 +2661,7 @@ static void handle_characteristic_read_request(
                     &int_val,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
+            readContext->isPending = err == kHAPError_InProgress;
             if (readContext->status == kHAPIPAccessoryServerStatusCode_Success) {
                 readContext->value.intValue = int_val;
             }
@@ -1663,6 +2677,7 @@ static void handle_characteristic_read_request(
                     &float_val,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
+            readContext->isPending = err == kHAPError_InProgress;
             if (readContext->status == kHAPIPAccessoryServerStatusCode_Success) {
                 readContext->value.floatValue = float_val;
             }
@@ -1680,6 +2695,7 @@ static void handle_characteristic_read_request(
                     data_buffer->limit - data_buffer->position,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
+            readContext->isPending = err == kHAPError_InProgress;
             if (readContext->status == kHAPIPAccessoryServerStatusCode_Success) {
                 sval_length = HAPStringGetNumBytes(&data_buffer->data[data_buffer->position]);
                 if (sval_length < data_buffer->limit - data_buffer->position) {
@@ -1707,6 +2723,7 @@ static void handle_characteristic_read_request(
                     &tlv8_writer,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
+            readContext->isPending = err == kHAPError_InProgress;
             if (readContext->status == kHAPIPAccessoryServerStatusCode_Success) {
                 if (((HAPTLVWriter*) &tlv8_writer)->numBytes <= data_buffer->limit - data_buffer->position) {
                     util_base64_encode(
@@ -1789,7 +2806,16 @@ static int handle_characteristic_read_requests(
                             chr->properties.ip.controlPoint) {
                         readContext->status = kHAPIPAccessoryServerStatusCode_UnableToPerformOperation;
                     } else {
-                        handle_characteristic_read_request(session, chr, svc, acc, &contexts[i], data_buffer);
+                        const HAPIPDeferredRequest* _Nullable deferredRequest =
+                                session_context == kHAPIPSessionContext_GetCharacteristics ?
+                                        GetDeferredRequest(session, i, c, HAPNonnull(acc)) :
+                                        NULL;
+                        if (deferredRequest && deferredRequest->isDeferred && deferredRequest->error) {
+                            HAPAssert(!deferredRequest->isPending);
+                            readContext->status = ConvertCharacteristicReadErrorToStatusCode(deferredRequest->error);
+                        } else {
+                            handle_characteristic_read_request(session, chr, svc, acc, &contexts[i], data_buffer);
+                        }
                     }
                 } else {
                     readContext->status = kHAPIPAccessoryServerStatusCode_ReadFromWriteOnlyCharacteristic;
@@ -1808,6 +2834,53 @@ static int handle_characteristic_read_requests(
     return r;
 }
 
+/**
+ * Records a set of characteristic read requests if any of them has been deferred.
+ *
+ * - Once all deferred requests have been completed, the HTTP transaction is processed again.
+ *   Read handlers of requests that have been completed successfully are invoked a second time
+ *   and must then provide the value synchronously. Otherwise, the request is reported as busy.
+ *
+ * @param      session              IP session descriptor.
+ * @param      contexts             Request contexts.
+ * @param      numContexts          Length of @p contexts.
+ *
+ * @return true                     If the response must be deferred until all deferred requests have been completed.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool DeferCharacteristicReadRequests(
+        HAPIPSessionDescriptor* session,
+        HAPIPReadContextRef* contexts,
+        size_t numContexts) {
+    HAPPrecondition(session);
+    HAPPrecondition(contexts);
+
+    size_t numPendingRequests = 0;
+    for (size_t i = 0; i < numContexts; i++) {
+        if (((const HAPIPReadContext*) &contexts[i])->isPending) {
+            numPendingRequests++;
+        }
+    }
+    if (!BeginDeferredRequests(session, numContexts, numPendingRequests)) {
+        EndCharacteristicRequests(session);
+        return false;
+    }
+    for (size_t i = 0; i < numContexts; i++) {
+        const HAPIPReadContext* readContext = (const HAPIPReadContext*) &contexts[i];
+        RecordDeferredRequest(
+                session,
+                i,
+                readContext->aid,
+                readContext->iid,
+                readContext->status,
+                /* response: */ false,
+                readContext->isPending);
+    }
+    EndCharacteristicRequests(session);
+    return true;
+}
+
 static void get_characteristics(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
@@ -1839,19 +2912,24 @@ static void get_characteristics(HAPIPSessionDescriptor* session) {
             if (contexts_count == 0) {
                 write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_NoContent);
             } else {
-                data_buffer.data = server->ip.storage->scratchBuffer.bytes;
-                data_buffer.capacity = server->ip.storage->scratchBuffer.numBytes;
-                data_buffer.limit = server->ip.storage->scratchBuffer.numBytes;
+                data_buffer.data = HAPNonnull(server->ip.scratchBuffer.bytes);
+                data_buffer.capacity = server->ip.scratchBuffer.numBytes;
+                data_buffer.limit = server->ip.scratchBuffer.numBytes;
                 data_buffer.position = 0;
                 HAPAssert(data_buffer.data);
                 HAPAssert(data_buffer.position <= data_buffer.limit);
                 HAPAssert(data_buffer.limit <= data_buffer.capacity);
+                BeginCharacteristicRequests(session);
                 r = handle_characteristic_read_requests(
                         session,
                         kHAPIPSessionContext_GetCharacteristics,
                         server->ip.storage->readContexts,
                         contexts_count,
                         &data_buffer);
+                if (DeferCharacteristicReadRequests(session, server->ip.storage->readContexts, contexts_count)) {
+                    // Response is sent once all deferred requests have been completed.
+                    return;
+                }
                 content_length = HAPIPAccessoryProtocolGetNumCharacteristicReadResponseBytes(
                         HAPNonnull(session->server), server->ip.storage->readContexts, contexts_count, &parameters);
                 HAPAssert(session->outboundBuffer.data);
@@ -1884,6 +2962,7 @@ static void get_characteristics(HAPIPSessionDescriptor* session) {
                         HAPAssert(!err && (session->outboundBuffer.position - mark == content_length));
                     } else {
                         HAPLog(&logObject, "Out of resources (outbound buffer too small).");
+                        HAPMetricsIncrementCounter(session->server, numBufferFullConditions);
                         session->outboundBuffer.position = mark;
                         write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_OutOfResources);
                     }
@@ -2054,13 +3133,13 @@ static void handle_accessory_serialization(HAPIPSessionDescriptor* session) {
                     (const void*) session);
         }
 
-        session->state = kHAPIPSessionState_Writing;
+        session->slot->state = kHAPIPSessionState_Writing;
 
         session->accessorySerializationIsInProgress = true;
     } else {
         session->accessorySerializationIsInProgress = false;
 
-        session->state = kHAPIPSessionState_Reading;
+        session->slot->state = kHAPIPSessionState_Reading;
         prepare_reading_request(session);
         if (session->inboundBuffer.position != 0) {
             handle_input(session);
@@ -2119,8 +3198,8 @@ static void handle_pairing_data(
     HAPTLVReaderRef tlv8_reader;
     HAPTLVWriterRef tlv8_writer;
 
-    char* scratchBuffer = server->ip.storage->scratchBuffer.bytes;
-    size_t maxScratchBufferBytes = server->ip.storage->scratchBuffer.numBytes;
+    char* scratchBuffer = HAPNonnull(server->ip.scratchBuffer.bytes);
+    size_t maxScratchBufferBytes = server->ip.scratchBuffer.numBytes;
 
     HAPAssert(session->inboundBuffer.data);
     HAPAssert(session->inboundBuffer.position <= session->inboundBuffer.limit);
@@ -2168,16 +3247,18 @@ static void handle_pairing_data(
                                     p_tlv8_buffer,
                                     tlv8_length);
                             session->outboundBuffer.position += tlv8_length;
-                            for (size_t i = 0; i < server->ip.storage->numSessions; i++) {
-                                HAPIPSession* ipSession = &server->ip.storage->sessions[i];
-                                HAPIPSessionDescriptor* t = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-                                if (!t->server) {
+                            for (size_t i = 0; i < GetNumSessions(server); i++) {
+                                const HAPIPSessionSlot* slot =
+                                        GetSessionSlot(server, i);
+                                if (!slot->isActive || (slot->state != kHAPIPSessionState_Reading)) {
                                     continue;
                                 }
 
                                 // Other sessions whose pairing has been removed during the pairing session
                                 // need to be closed as soon as possible.
-                                if (t != session && t->state == kHAPIPSessionState_Reading &&
+                                HAPIPSessionDescriptor* t =
+                                        (HAPIPSessionDescriptor*) &GetSession(server, i)->descriptor;
+                                if (t != session &&
                                     t->securitySession.type == kHAPIPSecuritySessionType_HAP &&
                                     t->securitySession.isSecured && !HAPSessionIsSecured(&t->securitySession._.hap)) {
                                     HAPLogInfo(&logObject, "Closing other session whose pairing has been removed.");
@@ -2186,6 +3267,7 @@ static void handle_pairing_data(
                             }
                         } else {
                             HAPLog(&logObject, "Invalid configuration (outbound buffer too small).");
+                            HAPMetricsIncrementCounter(session->server, numBufferFullConditions);
                             session->outboundBuffer.position = mark;
                             write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_InternalServerError);
                         }
@@ -2210,6 +3292,7 @@ static void handle_pairing_data(
             }
         } else {
             HAPLog(&logObject, "Invalid configuration (inbound buffer too small).");
+            HAPMetricsIncrementCounter(session->server, numBufferFullConditions);
             write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_InternalServerError);
         }
     } else {
@@ -2324,12 +3407,12 @@ static void handle_secure_message(HAPIPSessionDescriptor* session) {
 
 #define DestroyRequestBodyAndCreateResponseBodyWriter(responseWriter) \
     do { \
-        size_t numBytes = server->ip.storage->scratchBuffer.numBytes; \
+        size_t numBytes = server->ip.scratchBuffer.numBytes; \
         if (numBytes > UINT16_MAX) { \
             /* Maximum for HAP-BLE PDU. */ \
             numBytes = UINT16_MAX; \
         } \
-        HAPTLVWriterCreate(responseWriter, server->ip.storage->scratchBuffer.bytes, numBytes); \
+        HAPTLVWriterCreate(responseWriter, HAPNonnull(server->ip.scratchBuffer.bytes), numBytes); \
     } while (0)
 
     // Handle request.
@@ -2474,6 +3557,7 @@ SendResponse : {
         HAPAssert(err == kHAPError_OutOfResources);
         session->outboundBuffer.position = mark;
         HAPLog(&logObject, "/secure-message response: Invalid configuration (outbound buffer too small for headers).");
+        HAPMetricsIncrementCounter(session->server, numBufferFullConditions);
         write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_InternalServerError);
         return;
     }
@@ -2481,6 +3565,7 @@ SendResponse : {
         HAPAssert(err == kHAPError_OutOfResources);
         session->outboundBuffer.position = mark;
         HAPLog(&logObject, "/secure-message response: Invalid configuration (outbound buffer too small for body).");
+        HAPMetricsIncrementCounter(session->server, numBufferFullConditions);
         write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_InternalServerError);
         return;
     }
@@ -2567,6 +3652,7 @@ static void handle_http_request(HAPIPSessionDescriptor* session) {
     HAPAssert(session->httpReader.state == util_HTTP_READER_STATE_DONE);
     HAPAssert(!session->httpParserError);
 
+    HAPTraceBegin(kHAPTraceEvent_HTTPRequest, (uintptr_t) session, session->httpURI.numBytes);
     {
         HAPPrecondition(session->securitySession.type == kHAPIPSecuritySessionType_HAP);
 
@@ -2589,12 +3675,14 @@ static void handle_http_request(HAPIPSessionDescriptor* session) {
                 HAPRawBufferAreEqual(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
                 if (!session->securitySession.isSecured) {
                     // Close existing transient session.
-                    for (size_t i = 0; i < server->ip.storage->numSessions; i++) {
-                        HAPIPSession* ipSession = &server->ip.storage->sessions[i];
-                        HAPIPSessionDescriptor* t = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-                        if (!t->server) {
+                    for (size_t i = 0; i < GetNumSessions(server); i++) {
+                        const HAPIPSessionSlot* slot =
+                                GetSessionSlot(server, i);
+                        if (!slot->isActive) {
                             continue;
                         }
+                        HAPIPSessionDescriptor* t =
+                                (HAPIPSessionDescriptor*) &GetSession(server, i)->descriptor;
                         // TODO Make this finish writing ongoing responses. Similar to Remove Pairing.
                         if (t != session && t->securitySession.type == kHAPIPSecuritySessionType_HAP &&
                             HAPSessionIsTransient(&t->securitySession._.hap)) {
@@ -2855,6 +3943,7 @@ static void handle_http_request(HAPIPSessionDescriptor* session) {
             }
         }
     }
+    HAPTraceEnd(kHAPTraceEvent_HTTPRequest, (uintptr_t) session, session->httpURI.numBytes);
 }
 
 static void handle_http(HAPIPSessionDescriptor* session) {
@@ -2882,14 +3971,24 @@ static void handle_http(HAPIPSessionDescriptor* session) {
                 session->httpReaderPosition + content_length,
                 "session:%p:>",
                 (const void*) session);
+        if (HasLargeResponse(session)) {
+            EnlargeOutboundBuffer(session);
+        }
         handle_http_request(session);
-        HAPIPByteBufferShiftLeft(&session->inboundBuffer, session->httpReaderPosition + content_length);
+        if (session->slot->state == kHAPIPSessionState_Waiting) {
+            // Request is kept in the inbound buffer and processed again once all deferred requests have been
+            // completed. This may already be the case if they have been completed from within their handlers.
+            HAPAssert(session->deferredTransaction);
+            return;
+        }
+        ClearDeferredRequests(session);
+        DiscardInboundBytes(session, session->httpReaderPosition + content_length);
         if (session->accessorySerializationIsInProgress) {
             // Session is already prepared for writing
             HAPAssert(session->outboundBuffer.data);
             HAPAssert(session->outboundBuffer.position <= session->outboundBuffer.limit);
             HAPAssert(session->outboundBuffer.limit <= session->outboundBuffer.capacity);
-            HAPAssert(session->state == kHAPIPSessionState_Writing);
+            HAPAssert(session->slot->state == kHAPIPSessionState_Writing);
         } else {
             HAPAssert(session->outboundBuffer.data);
             HAPAssert(session->outboundBuffer.position <= session->outboundBuffer.limit);
@@ -2907,6 +4006,7 @@ static void handle_http(HAPIPSessionDescriptor* session) {
                         session->outboundBuffer.limit - session->outboundBuffer.position);
                 if (encrypted_length > session->outboundBuffer.capacity - session->outboundBuffer.position) {
                     HAPLog(&logObject, "Out of resources (outbound buffer too small).");
+                    HAPMetricsIncrementCounter(session->server, numBufferFullConditions);
                     session->outboundBuffer.limit = session->outboundBuffer.capacity;
                     write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_OutOfResources);
                     HAPIPByteBufferFlip(&session->outboundBuffer);
@@ -2918,7 +4018,7 @@ static void handle_http(HAPIPSessionDescriptor* session) {
                         HAPNonnull(session->server), &session->securitySession._.hap, &session->outboundBuffer);
                 HAPAssert(encrypted_length == session->outboundBuffer.limit - session->outboundBuffer.position);
             }
-            session->state = kHAPIPSessionState_Writing;
+            session->slot->state = kHAPIPSessionState_Writing;
         }
     }
 }
@@ -3181,6 +4281,75 @@ static void read_http(HAPIPSessionDescriptor* session) {
               session->httpParserError)));
 }
 
+/**
+ * Checks whether the path of an HTTP request URI matches an endpoint.
+ *
+ * @param      uriBytes             URI path, without query.
+ * @param      numURIBytes          Length of URI path.
+ * @param      endpoint             Endpoint path.
+ *
+ * @return true                     If the URI path matches the endpoint.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool IsHTTPEndpoint(const char* uriBytes, size_t numURIBytes, const char* endpoint) {
+    HAPPrecondition(uriBytes);
+    HAPPrecondition(endpoint);
+
+    size_t numEndpointBytes = HAPStringGetNumBytes(endpoint);
+    return numURIBytes == numEndpointBytes && HAPRawBufferAreEqual(uriBytes, endpoint, numEndpointBytes);
+}
+
+/**
+ * Counts a received HTTP request in the performance metrics of the accessory server.
+ *
+ * @param      session              IP session descriptor.
+ */
+static void CountHTTPRequest(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+
+    if (!server->metrics) {
+        return;
+    }
+    HAPAccessoryServerMetrics* metrics = HAPNonnull(server->metrics);
+
+    // Strip query.
+    const char* uri = HAPNonnull(session->httpURI.bytes);
+    size_t numURIBytes = 0;
+    while (numURIBytes < session->httpURI.numBytes && uri[numURIBytes] != '?') {
+        numURIBytes++;
+    }
+
+    if (IsHTTPEndpoint(uri, numURIBytes, "/accessories")) {
+        metrics->ipRequests.accessories++;
+    } else if (IsHTTPEndpoint(uri, numURIBytes, "/characteristics")) {
+        if ((session->httpMethod.numBytes == 3) &&
+            HAPRawBufferAreEqual(HAPNonnull(session->httpMethod.bytes), "PUT", 3)) {
+            metrics->ipRequests.putCharacteristics++;
+        } else {
+            metrics->ipRequests.getCharacteristics++;
+        }
+    } else if (IsHTTPEndpoint(uri, numURIBytes, "/prepare")) {
+        metrics->ipRequests.prepare++;
+    } else if (IsHTTPEndpoint(uri, numURIBytes, "/pair-setup")) {
+        metrics->ipRequests.pairSetup++;
+    } else if (IsHTTPEndpoint(uri, numURIBytes, "/pair-verify")) {
+        metrics->ipRequests.pairVerify++;
+    } else if (IsHTTPEndpoint(uri, numURIBytes, "/pairings")) {
+        metrics->ipRequests.pairings++;
+    } else if (IsHTTPEndpoint(uri, numURIBytes, "/secure-message")) {
+        metrics->ipRequests.secureMessage++;
+    } else if (IsHTTPEndpoint(uri, numURIBytes, "/identify")) {
+        metrics->ipRequests.identify++;
+    } else if (IsHTTPEndpoint(uri, numURIBytes, "/resource")) {
+        metrics->ipRequests.resource++;
+    } else {
+        metrics->ipRequests.other++;
+    }
+}
+
 static void handle_input(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
@@ -3199,10 +4368,17 @@ static void handle_input(HAPIPSessionDescriptor* session) {
         if (!session->securitySession.isSecured) {
             HAPLogDebug(&logObject, "Established HAP security session.");
             session->securitySession.isSecured = true;
+            HAPIPCaptureOpenSession(session);
         }
         session->inboundBuffer.position = session->inboundBufferMark;
         r = HAPIPSecurityProtocolDecryptData(
                 HAPNonnull(session->server), &session->securitySession._.hap, &session->inboundBuffer);
+        if (r == 0) {
+            HAPIPCaptureData(
+                    session,
+                    &session->inboundBuffer.data[session->inboundBufferMark],
+                    session->inboundBuffer.position - session->inboundBufferMark);
+        }
     } else {
         HAPAssert(
                 session->securitySession.type != kHAPIPSecuritySessionType_HAP || !session->securitySession.isSecured);
@@ -3216,13 +4392,15 @@ static void handle_input(HAPIPSessionDescriptor* session) {
             CloseSession(session);
         } else {
             if (session->httpReader.state == util_HTTP_READER_STATE_DONE) {
+                CountHTTPRequest(session);
                 handle_http(session);
             }
             session->inboundBufferMark = session->inboundBuffer.position;
             session->inboundBuffer.position = session->inboundBuffer.limit;
             session->inboundBuffer.limit = session->inboundBuffer.capacity;
-            if ((session->state == kHAPIPSessionState_Reading) &&
-                (session->inboundBuffer.position == session->inboundBuffer.limit)) {
+            if ((session->slot->state == kHAPIPSessionState_Reading) &&
+                (session->inboundBuffer.position == session->inboundBuffer.limit) &&
+                !CompactInboundBuffer(session) && !EnlargeInboundBuffer(session)) {
                 log_protocol_error(
                         kHAPLogType_Info,
                         "Unexpected request. Closing connection (inbound buffer too small).",
@@ -3230,6 +4408,7 @@ static void handle_input(HAPIPSessionDescriptor* session) {
                         __func__,
                         HAP_FILE,
                         __LINE__);
+                HAPMetricsIncrementCounter(session->server, numBufferFullConditions);
                 CloseSession(session);
             }
         }
@@ -3253,18 +4432,18 @@ static void write_event_notifications(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session->securitySession.type == kHAPIPSecuritySessionType_HAP);
     HAPPrecondition(session->securitySession.isOpen);
     HAPPrecondition(!HAPSessionIsTransient(&session->securitySession._.hap));
-    HAPPrecondition(session->state == kHAPIPSessionState_Reading);
+    HAPPrecondition(session->slot->state == kHAPIPSessionState_Reading);
     HAPPrecondition(session->inboundBuffer.position == 0);
-    HAPPrecondition(session->numEventNotificationFlags > 0);
-    HAPPrecondition(session->numEventNotificationFlags <= session->numEventNotifications);
+    HAPPrecondition(session->slot->numEventNotificationFlags > 0);
+    HAPPrecondition(session->slot->numEventNotificationFlags <= session->numEventNotifications);
     HAPPrecondition(session->numEventNotifications <= session->maxEventNotifications);
 
     HAPError err;
 
     if (session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled) {
         HAPTime clock_now_ms = HAPPlatformClockGetCurrent();
-        HAPAssert(clock_now_ms >= session->eventNotificationStamp);
-        HAPTime dt_ms = clock_now_ms - session->eventNotificationStamp;
+        HAPAssert(clock_now_ms >= session->slot->eventNotificationStamp);
+        HAPTime dt_ms = clock_now_ms - session->slot->eventNotificationStamp;
 
         size_t numReadContexts = 0;
 
@@ -3274,7 +4453,7 @@ static void write_event_notifications(HAPIPSessionDescriptor* session) {
                 bool notifyNow;
                 if (dt_ms >= kHAPIPAccessoryServer_MaxEventNotificationDelay) {
                     notifyNow = true;
-                    session->eventNotificationStamp = clock_now_ms;
+                    session->slot->eventNotificationStamp = clock_now_ms;
                 } else {
                     // Network-based notifications must be coalesced by the accessory using a delay of no less than
                     // 1 second. The exception to this rule includes notifications for the following characteristics
@@ -3315,17 +4494,17 @@ static void write_event_notifications(HAPIPSessionDescriptor* session) {
                     readContext->iid = eventNotification->iid;
                     numReadContexts++;
                     eventNotification->flag = false;
-                    HAPAssert(session->numEventNotificationFlags > 0);
-                    session->numEventNotificationFlags--;
+                    HAPAssert(session->slot->numEventNotificationFlags > 0);
+                    session->slot->numEventNotificationFlags--;
                 }
             }
         }
 
         if (numReadContexts > 0) {
             HAPIPByteBuffer data_buffer;
-            data_buffer.data = server->ip.storage->scratchBuffer.bytes;
-            data_buffer.capacity = server->ip.storage->scratchBuffer.numBytes;
-            data_buffer.limit = server->ip.storage->scratchBuffer.numBytes;
+            data_buffer.data = HAPNonnull(server->ip.scratchBuffer.bytes);
+            data_buffer.capacity = server->ip.scratchBuffer.numBytes;
+            data_buffer.limit = server->ip.scratchBuffer.numBytes;
             data_buffer.position = 0;
             HAPAssert(data_buffer.data);
             HAPAssert(data_buffer.position <= data_buffer.limit);
@@ -3378,18 +4557,21 @@ static void write_event_notifications(HAPIPSessionDescriptor* session) {
                         HAPIPSecurityProtocolEncryptData(
                                 HAPNonnull(session->server), &session->securitySession._.hap, &session->outboundBuffer);
                         HAPAssert(encrypted_length == session->outboundBuffer.limit - session->outboundBuffer.position);
-                        session->state = kHAPIPSessionState_Writing;
+                        session->slot->state = kHAPIPSessionState_Writing;
                     } else {
                         HAPLog(&logObject, "Skipping event notifications (outbound buffer too small).");
+                        HAPMetricsIncrementCounter(session->server, numBufferFullConditions);
+                        HAPMetricsAddToCounter(session->server, eventNotifications.numDropped, numReadContexts);
                         HAPIPByteBufferClear(&session->outboundBuffer);
                     }
                 } else {
                     HAPAssert(kHAPIPAccessoryServer_SessionSecurityDisabled);
                     HAP_DIAGNOSTIC_IGNORED_ICCARM(Pe111)
-                    session->state = kHAPIPSessionState_Writing;
+                    session->slot->state = kHAPIPSessionState_Writing;
                     HAP_DIAGNOSTIC_RESTORE_ICCARM(Pe111)
                 }
-                if (session->state == kHAPIPSessionState_Writing) {
+                if (session->slot->state == kHAPIPSessionState_Writing) {
+                    HAPMetricsAddToCounter(session->server, eventNotifications.numSent, numReadContexts);
                     HAPPlatformTCPStreamEvent interests = { .hasBytesAvailable = false, .hasSpaceAvailable = true };
                     HAPPlatformTCPStreamUpdateInterests(
                             HAPNonnull(server->platform.ip.tcpStreamManager),
@@ -3400,6 +4582,8 @@ static void write_event_notifications(HAPIPSessionDescriptor* session) {
                 }
             } else {
                 HAPLog(&logObject, "Skipping event notifications (outbound buffer too small).");
+                HAPMetricsIncrementCounter(session->server, numBufferFullConditions);
+                HAPMetricsAddToCounter(session->server, eventNotifications.numDropped, numReadContexts);
                 session->outboundBuffer.position = mark;
             }
         }
@@ -3408,12 +4592,13 @@ static void write_event_notifications(HAPIPSessionDescriptor* session) {
             HAPIPEventNotification* eventNotification = (HAPIPEventNotification*) &session->eventNotifications[i];
             if (eventNotification->flag) {
                 eventNotification->flag = false;
-                HAPAssert(session->numEventNotificationFlags > 0);
-                session->numEventNotificationFlags--;
+                HAPAssert(session->slot->numEventNotificationFlags > 0);
+                session->slot->numEventNotificationFlags--;
+                HAPMetricsIncrementCounter(session->server, eventNotifications.numDropped);
             }
         }
-        HAPAssert(session->numEventNotificationFlags == 0);
-        session->eventNotificationStamp = HAPPlatformClockGetCurrent();
+        HAPAssert(session->slot->numEventNotificationFlags == 0);
+        session->slot->eventNotificationStamp = HAPPlatformClockGetCurrent();
     }
 }
 
@@ -3422,21 +4607,22 @@ static void handle_io_progression(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session->server);
     HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
 
-    if ((session->state == kHAPIPSessionState_Reading) && (session->inboundBuffer.position == 0)) {
+    if ((session->slot->state == kHAPIPSessionState_Reading) && (session->inboundBuffer.position == 0)) {
         if (server->ip.state == kHAPIPAccessoryServerState_Stopping) {
             CloseSession(session);
         } else {
             HAPAssert(server->ip.state == kHAPIPAccessoryServerState_Running);
-            if (session->numEventNotificationFlags > 0) {
+            if (session->slot->numEventNotificationFlags > 0) {
                 HAPAssert(session->securitySession.type == kHAPIPSecuritySessionType_HAP);
                 schedule_event_notifications(session->server);
             }
         }
     }
     if (session->tcpStreamIsOpen) {
-        HAPPlatformTCPStreamEvent interests = { .hasBytesAvailable = (session->state == kHAPIPSessionState_Reading),
-                                                .hasSpaceAvailable = (session->state == kHAPIPSessionState_Writing) };
-        if ((session->state == kHAPIPSessionState_Reading) || (session->state == kHAPIPSessionState_Writing)) {
+        HAPIPSessionState state = session->slot->state;
+        HAPPlatformTCPStreamEvent interests = { .hasBytesAvailable = (state == kHAPIPSessionState_Reading),
+                                                .hasSpaceAvailable = (state == kHAPIPSessionState_Writing) };
+        if ((state == kHAPIPSessionState_Reading) || (state == kHAPIPSessionState_Writing)) {
             HAPPlatformTCPStreamUpdateInterests(
                     HAPNonnull(server->platform.ip.tcpStreamManager),
                     session->tcpStream,
@@ -3457,7 +4643,7 @@ static void handle_output_completion(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session->server);
     HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
 
-    HAPAssert(session->state == kHAPIPSessionState_Writing);
+    HAPAssert(session->slot->state == kHAPIPSessionState_Writing);
     if (session->securitySession.isOpen && session->securitySession.receivedConfig) {
         HAPLogDebug(&logObject, "Completed sending of Wi-Fi configuration response.");
 
@@ -3470,7 +4656,7 @@ static void handle_output_completion(HAPIPSessionDescriptor* session) {
         session->securitySession._.mfiSAP.receivedConfigured = false;
         HAPAssert(server->ip.state == kHAPIPAccessoryServerState_Stopping);
     }
-    session->state = kHAPIPSessionState_Reading;
+    session->slot->state = kHAPIPSessionState_Reading;
     prepare_reading_request(session);
     if (session->inboundBuffer.position != 0) {
         handle_input(session);
@@ -3610,22 +4796,188 @@ static void HandleTCPStreamEvent(
     HAPAssert(session->tcpStreamIsOpen);
 
     HAPTime clock_now_ms = HAPPlatformClockGetCurrent();
+    uint32_t eventFlags = (uint32_t)((event.hasBytesAvailable ? 1U : 0U) | (event.hasSpaceAvailable ? 2U : 0U));
+    HAPTraceBegin(kHAPTraceEvent_TCPStreamEvent, (uintptr_t) session, eventFlags);
 
     if (event.hasBytesAvailable) {
         HAPAssert(!event.hasSpaceAvailable);
-        HAPAssert(session->state == kHAPIPSessionState_Reading);
-        session->stamp = clock_now_ms;
+        HAPAssert(session->slot->state == kHAPIPSessionState_Reading);
+        session->slot->stamp = clock_now_ms;
         ReadInboundData(session);
         handle_io_progression(session);
     }
 
     if (event.hasSpaceAvailable) {
         HAPAssert(!event.hasBytesAvailable);
-        HAPAssert(session->state == kHAPIPSessionState_Writing);
-        session->stamp = clock_now_ms;
+        HAPAssert(session->slot->state == kHAPIPSessionState_Writing);
+        session->slot->stamp = clock_now_ms;
         WriteOutboundData(session);
         handle_io_progression(session);
     }
+
+    HAPTraceEnd(kHAPTraceEvent_TCPStreamEvent, (uintptr_t) session, eventFlags);
+}
+
+/**
+ * Finds an IP session that is not in use.
+ *
+ * @param      server               Accessory server.
+ * @param[out] index                Index of the IP session, if found.
+ *
+ * @return true                     If an IP session that is not in use has been found.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool FindFreeSession(const HAPAccessoryServer* server, size_t* index) {
+    HAPPrecondition(server);
+    HAPPrecondition(index);
+
+    for (size_t i = 0; i < GetNumSessions(server); i++) {
+        const HAPIPSessionSlot* slot = GetSessionSlot(server, i);
+        if (!slot->isActive) {
+            *index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Allocates a chunk of additional IP sessions, if supported by the IP server storage.
+ *
+ * @param      server_              Accessory server.
+ * @param[out] index                Index of the first IP session of the new chunk, if successful.
+ *
+ * @return true                     If a chunk of additional IP sessions has been allocated.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool AllocateSessionChunk(HAPAccessoryServerRef* server_, size_t* index) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(index);
+
+    HAPError err;
+
+    HAPIPAccessoryServerStorage* storage = HAPNonnull(server->ip.storage);
+    if (!storage->sessionChunks.allocate || server->ip.numSessionChunks == HAPArrayCount(server->ip.sessionChunks)) {
+        return false;
+    }
+
+    HAPIPSession* _Nullable sessions = NULL;
+    HAPIPSessionSlotRef* _Nullable sessionSlots = NULL;
+    void* _Nullable allocation = NULL;
+    err = storage->sessionChunks.allocate(
+            server_, storage->numSessions, &sessions, &sessionSlots, &allocation, storage->sessionChunks.context);
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        HAPLog(&logObject, "Failed to allocate additional sessions.");
+        return false;
+    }
+    HAPAssert(sessions);
+    HAPAssert(sessionSlots);
+    for (size_t i = 0; i < storage->numSessions; i++) {
+        HAPIPSession* ipSession = &sessions[i];
+        HAPPrecondition(ipSession->inboundBuffer.bytes);
+        HAPPrecondition(ipSession->outboundBuffer.bytes);
+        HAPPrecondition(ipSession->eventNotifications);
+        HAPRawBufferZero(&ipSession->descriptor, sizeof ipSession->descriptor);
+        HAPRawBufferZero(ipSession->inboundBuffer.bytes, ipSession->inboundBuffer.numBytes);
+        HAPRawBufferZero(ipSession->outboundBuffer.bytes, ipSession->outboundBuffer.numBytes);
+        HAPRawBufferZero(
+                ipSession->eventNotifications,
+                ipSession->numEventNotifications * sizeof *ipSession->eventNotifications);
+    }
+    HAPRawBufferZero(HAPNonnull(sessionSlots), storage->numSessions * sizeof *sessionSlots);
+
+    *index = GetNumSessions(server);
+    server->ip.sessionChunks[server->ip.numSessionChunks].sessions = sessions;
+    server->ip.sessionChunks[server->ip.numSessionChunks].sessionSlots = sessionSlots;
+    server->ip.sessionChunks[server->ip.numSessionChunks].allocation = allocation;
+    server->ip.numSessionChunks++;
+    HAPLogInfo(&logObject, "Allocated additional sessions (%lu total).", (unsigned long) GetNumSessions(server));
+    return true;
+}
+
+/**
+ * Closes an idle IP session to make room for a new connection.
+ *
+ * - Only sessions that are waiting for a request are considered. Sessions that are not secured may be closed after
+ *   staying idle for kHAPIPSession_MinIdleTimeBeforeEviction, or for
+ *   kHAPIPSession_MinPartialRequestIdleTimeBeforeEviction if they hold a partially received request. Secured
+ *   sessions of controllers without admin permissions may only be closed after staying idle for
+ *   kHAPIPSession_MaxIdleTime. Sessions of admin controllers and the session in which a pairing is currently taking
+ *   place are never closed.
+ *
+ * - Sessions that are not secured are closed before secured sessions. Among those, the least recently used one
+ *   is closed.
+ *
+ * @param      server_              Accessory server.
+ * @param[out] index                Index of the IP session that has been closed and released, if successful.
+ *
+ * @return true                     If an IP session has been closed and released.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool EvictIdleSession(HAPAccessoryServerRef* server_, size_t* index) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(index);
+
+    HAPTime clock_now_ms = HAPPlatformClockGetCurrent();
+
+    bool found = false;
+    bool foundIsSecured = false;
+    HAPTime foundStamp = 0;
+    for (size_t i = 0; i < GetNumSessions(server); i++) {
+        const HAPIPSessionSlot* slot = GetSessionSlot(server, i);
+        if (!slot->isActive || (slot->state != kHAPIPSessionState_Reading)) {
+            continue;
+        }
+        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &GetSession(server, i)->descriptor;
+        bool isSecured = session->securitySession.isSecured;
+        if (session->securitySession.type == kHAPIPSecuritySessionType_HAP) {
+            if (&session->securitySession._.hap == server->pairSetup.sessionThatIsCurrentlyPairing) {
+                continue;
+            }
+            if (isSecured && HAPSessionControllerIsAdmin(&session->securitySession._.hap)) {
+                continue;
+            }
+        }
+        HAPAssert(clock_now_ms >= slot->stamp);
+        HAPTime dt_ms = clock_now_ms - slot->stamp;
+        if (isSecured) {
+            if ((session->inboundBuffer.position != 0) || (dt_ms < kHAPIPSession_MaxIdleTime)) {
+                continue;
+            }
+        } else {
+            HAPTime minIdleTime = session->inboundBuffer.position != 0 ?
+                                          kHAPIPSession_MinPartialRequestIdleTimeBeforeEviction :
+                                          kHAPIPSession_MinIdleTimeBeforeEviction;
+            if (dt_ms < minIdleTime) {
+                continue;
+            }
+        }
+        if (found && ((isSecured && !foundIsSecured) || ((isSecured == foundIsSecured) && slot->stamp >= foundStamp))) {
+            continue;
+        }
+        found = true;
+        foundIsSecured = isSecured;
+        foundStamp = slot->stamp;
+        *index = i;
+    }
+    if (!found) {
+        return false;
+    }
+
+    HAPIPSession* ipSession = GetSession(server, *index);
+    HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
+    HAPLogInfo(&logObject, "session:%p:closing idle session to accept new connection", (const void*) session);
+    CloseSession(session);
+    HAPIPSessionDestroy(ipSession);
+    HAPAssert(server->ip.numSessions > 0);
+    server->ip.numSessions--;
+    return true;
 }
 
 static void HandlePendingTCPStream(HAPPlatformTCPStreamManagerRef tcpStreamManager, void* _Nullable context) {
@@ -3649,31 +5001,32 @@ static void HandlePendingTCPStream(HAPPlatformTCPStreamManagerRef tcpStreamManag
         return;
     }
 
-    // Find free IP session.
-    HAPIPSession* ipSession = NULL;
-    for (size_t i = 0; i < server->ip.storage->numSessions; i++) {
-        HAPIPSessionDescriptor* descriptor = (HAPIPSessionDescriptor*) &server->ip.storage->sessions[i].descriptor;
-        if (!descriptor->server) {
-            ipSession = &server->ip.storage->sessions[i];
-            break;
-        }
-    }
-    if (!ipSession) {
+    // Find free IP session. If all sessions are in use, allocate additional sessions or close an idle session.
+    size_t i;
+    if (!FindFreeSession(server, &i) && !AllocateSessionChunk(server_, &i) && !EvictIdleSession(server_, &i)) {
         HAPLog(&logObject,
                "Failed to allocate session."
                " (Number of supported accessory server sessions should be consistent with"
                " the maximum number of concurrent streams supported by TCP stream manager.)");
         HAPPlatformTCPStreamClose(HAPNonnull(server->platform.ip.tcpStreamManager), tcpStream);
+        HAPMetricsIncrementCounter(server_, sessions.numRejected);
         return;
     }
+    HAPIPSession* ipSession = GetSession(server, i);
+    HAPIPSessionSlot* slot = GetSessionSlot(server, i);
+    HAPAssert(!slot->isActive);
+
+    HAPRawBufferZero(slot, sizeof *slot);
+    slot->isActive = true;
 
     HAPIPSessionDescriptor* t = (HAPIPSessionDescriptor*) &ipSession->descriptor;
     HAPRawBufferZero(t, sizeof *t);
     t->server = server_;
+    t->slot = slot;
     t->tcpStream = tcpStream;
     t->tcpStreamIsOpen = true;
-    t->state = kHAPIPSessionState_Idle;
-    t->stamp = HAPPlatformClockGetCurrent();
+    t->slot->state = kHAPIPSessionState_Idle;
+    t->slot->stamp = HAPPlatformClockGetCurrent();
     t->securitySession.isOpen = false;
     t->securitySession.isSecured = false;
     t->inboundBuffer.position = 0;
@@ -3681,6 +5034,7 @@ static void HandlePendingTCPStream(HAPPlatformTCPStreamManagerRef tcpStreamManag
     t->inboundBuffer.capacity = ipSession->inboundBuffer.numBytes;
     t->inboundBuffer.data = ipSession->inboundBuffer.bytes;
     t->inboundBufferMark = 0;
+    t->inboundBufferOffset = 0;
     t->outboundBuffer.position = 0;
     t->outboundBuffer.limit = ipSession->outboundBuffer.numBytes;
     t->outboundBuffer.capacity = ipSession->outboundBuffer.numBytes;
@@ -3688,12 +5042,12 @@ static void HandlePendingTCPStream(HAPPlatformTCPStreamManagerRef tcpStreamManag
     t->eventNotifications = ipSession->eventNotifications;
     t->maxEventNotifications = ipSession->numEventNotifications;
     t->numEventNotifications = 0;
-    t->numEventNotificationFlags = 0;
-    t->eventNotificationStamp = 0;
+    t->slot->numEventNotificationFlags = 0;
+    t->slot->eventNotificationStamp = 0;
     t->timedWriteExpirationTime = 0;
     t->timedWritePID = 0;
     OpenSecuritySession(t);
-    t->state = kHAPIPSessionState_Reading;
+    t->slot->state = kHAPIPSessionState_Reading;
     prepare_reading_request(t);
     HAPAssert(t->tcpStreamIsOpen);
     HAPPlatformTCPStreamEvent interests = { .hasBytesAvailable = true, .hasSpaceAvailable = false };
@@ -3701,6 +5055,7 @@ static void HandlePendingTCPStream(HAPPlatformTCPStreamManagerRef tcpStreamManag
             HAPNonnull(server->platform.ip.tcpStreamManager), t->tcpStream, interests, HandleTCPStreamEvent, t);
 
     RegisterSession(t);
+    HAPMetricsIncrementCounter(server_, sessions.numAccepted);
 
     HAPLogDebug(&logObject, "session:%p:accepted", (const void*) t);
 }
@@ -3719,6 +5074,23 @@ static void engine_init(HAPAccessoryServerRef* server_) {
             &logObject,
             "Storage configuration: sessions = %lu",
             (unsigned long) (server->ip.storage->numSessions * sizeof(HAPIPSession)));
+    HAPLogDebug(
+            &logObject,
+            "Storage configuration: sessionSlots = %lu",
+            (unsigned long) (server->ip.storage->numSessions * sizeof(HAPIPSessionSlotRef)));
+    if (server->ip.storage->sessionChunks.allocate) {
+        HAPLogDebug(
+                &logObject,
+                "Storage configuration: maxSessions = %lu",
+                (unsigned long) (HAPArrayCount(server->ip.sessionChunks) * server->ip.storage->numSessions));
+    }
+    if (server->ip.storage->bufferPool.bytes) {
+        HAPLogDebug(
+                &logObject,
+                "Storage configuration: bufferPool = %lu x %lu",
+                (unsigned long) server->ip.storage->bufferPool.numBlocks,
+                (unsigned long) server->ip.storage->bufferPool.numBytesPerBlock);
+    }
     for (size_t i = 0; i < server->ip.storage->numSessions;) {
         size_t j;
         for (j = i + 1; j < server->ip.storage->numSessions; j++) {
@@ -3799,7 +5171,7 @@ static void engine_init(HAPAccessoryServerRef* server_) {
     HAPLogDebug(
             &logObject,
             "Storage configuration: scratchBuffer.numBytes = %lu",
-            (unsigned long) server->ip.storage->scratchBuffer.numBytes);
+            (unsigned long) server->ip.scratchBuffer.numBytes);
 
     HAPAssert(server->ip.state == kHAPIPAccessoryServerState_Undefined);
 
@@ -3822,8 +5194,21 @@ static HAPError engine_deinit(HAPAccessoryServerRef* server_) {
     HAPAssert(storage->writeContexts);
     HAPRawBufferZero(storage->writeContexts, storage->numWriteContexts * sizeof *storage->writeContexts);
 
-    HAPAssert(storage->scratchBuffer.bytes);
-    HAPRawBufferZero(storage->scratchBuffer.bytes, storage->scratchBuffer.numBytes);
+    HAPAssert(server->ip.scratchBuffer.bytes);
+    HAPRawBufferZero(HAPNonnull(server->ip.scratchBuffer.bytes), server->ip.scratchBuffer.numBytes);
+
+    // Release additional sessions. The first chunk is provided by the IP server storage.
+    for (size_t i = 1; i < server->ip.numSessionChunks; i++) {
+        HAPIPSession* sessions = HAPNonnull(server->ip.sessionChunks[i].sessions);
+        HAPIPSessionSlotRef* sessionSlots = HAPNonnull(server->ip.sessionChunks[i].sessionSlots);
+        void* _Nullable allocation = server->ip.sessionChunks[i].allocation;
+        HAPRawBufferZero(&server->ip.sessionChunks[i], sizeof server->ip.sessionChunks[i]);
+        if (storage->sessionChunks.release) {
+            storage->sessionChunks.release(
+                    server_, storage->numSessions, sessions, sessionSlots, allocation, storage->sessionChunks.context);
+        }
+    }
+    server->ip.numSessionChunks = 1;
 
     server->ip.state = kHAPIPAccessoryServerState_Undefined;
 
@@ -3954,12 +5339,13 @@ static HAPError engine_raise_event_on_session_(
     uint64_t aid = accessory_->aid;
     uint64_t iid = ((const HAPBaseCharacteristic*) characteristic_)->iid;
 
-    for (size_t i = 0; i < server->ip.storage->numSessions; i++) {
-        HAPIPSession* ipSession = &server->ip.storage->sessions[i];
-        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-        if (!session->server) {
+    for (size_t i = 0; i < GetNumSessions(server); i++) {
+        const HAPIPSessionSlot* slot = GetSessionSlot(server, i);
+        if (!slot->isActive) {
             continue;
         }
+        HAPIPSession* ipSession = GetSession(server, i);
+        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
         if (session->securitySession.type != kHAPIPSecuritySessionType_HAP) {
             if (!securitySession_) {
                 HAPLogDebug(&logObject, "Not flagging event pending on non-HAP session.");
@@ -3974,10 +5360,18 @@ static HAPError engine_raise_event_on_session_(
             continue;
         }
 
-        if ((ipSession != server->ip.characteristicWriteRequestContext.ipSession) ||
-            (characteristic_ != server->ip.characteristicWriteRequestContext.characteristic) ||
-            (service_ != server->ip.characteristicWriteRequestContext.service) ||
-            (accessory_ != server->ip.characteristicWriteRequestContext.accessory)) {
+        // Do not notify the controller about values that it has written itself.
+        bool isWriteRequestSource = (ipSession == server->ip.characteristicWriteRequestContext.ipSession) &&
+                                    (service_ == server->ip.characteristicWriteRequestContext.service) &&
+                                    (accessory_ == server->ip.characteristicWriteRequestContext.accessory);
+        if (isWriteRequestSource) {
+            if (server->ip.characteristicWriteRequestContext.characteristic) {
+                isWriteRequestSource = characteristic_ == server->ip.characteristicWriteRequestContext.characteristic;
+            } else {
+                isWriteRequestSource = HAPServiceIsBatchWriteTarget(server_, characteristic_, service_);
+            }
+        }
+        if (!isWriteRequestSource) {
             HAPAssert(session->numEventNotifications <= session->maxEventNotifications);
             size_t j = 0;
             while ((j < session->numEventNotifications) &&
@@ -3993,8 +5387,10 @@ static HAPError engine_raise_event_on_session_(
             if ((j < session->numEventNotifications) &&
                 !((HAPIPEventNotification*) &session->eventNotifications[j])->flag) {
                 ((HAPIPEventNotification*) &session->eventNotifications[j])->flag = true;
-                session->numEventNotificationFlags++;
+                session->slot->numEventNotificationFlags++;
                 events_raised++;
+            } else if (j < session->numEventNotifications) {
+                HAPMetricsIncrementCounter(server_, eventNotifications.numCoalesced);
             }
         }
     }
@@ -4045,6 +5441,199 @@ static HAPError engine_raise_event_on_session(
     return engine_raise_event_on_session_(server, characteristic, service, accessory, session);
 }
 
+/**
+ * Processes the HTTP transaction of a session again after all its deferred requests have been completed.
+ *
+ * @param      session              IP session descriptor.
+ */
+static void ResumeDeferredTransaction(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->slot->state == kHAPIPSessionState_Waiting);
+    HAPPrecondition(session->deferredTransaction);
+    HAPPrecondition(!HAPNonnull(session->deferredTransaction)->numPendingRequests);
+
+    // The inbound buffer is restored to the state in which handle_input handed the request over.
+    HAPLogDebug(&logObject, "session:%p:resuming deferred transaction", (const void*) session);
+    HAPIPByteBuffer* inboundBuffer = &session->inboundBuffer;
+    session->slot->state = kHAPIPSessionState_Reading;
+    inboundBuffer->limit = inboundBuffer->position;
+    inboundBuffer->position = session->inboundBufferMark;
+    handle_http(session);
+    session->inboundBufferMark = inboundBuffer->position;
+    inboundBuffer->position = inboundBuffer->limit;
+    inboundBuffer->limit = inboundBuffer->capacity;
+    handle_io_progression(session);
+}
+
+static void handle_deferred_request_timer(HAPPlatformTimerRef timer, void* _Nullable context) {
+    HAPPrecondition(context);
+    HAPAccessoryServerRef* server_ = context;
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(timer == server->ip.deferredRequestTimer);
+    server->ip.deferredRequestTimer = 0;
+
+    HAPTime clock_now_ms = HAPPlatformClockGetCurrent();
+
+    for (size_t i = 0; i < GetNumSessions(server); i++) {
+        const HAPIPSessionSlot* slot = GetSessionSlot(server, i);
+        if (!slot->isActive || (slot->state != kHAPIPSessionState_Waiting)) {
+            continue;
+        }
+
+        // Transactions whose deferred requests have all been completed before the session started waiting
+        // are processed again right away.
+        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &GetSession(server, i)->descriptor;
+        HAPAssert(session->deferredTransaction);
+        HAPIPDeferredTransaction* transaction = HAPNonnull(session->deferredTransaction);
+        if (transaction->numPendingRequests) {
+            HAPAssert(clock_now_ms >= slot->stamp);
+            if (clock_now_ms - slot->stamp < kHAPIPSession_MaxDeferredRequestTime) {
+                continue;
+            }
+
+            HAPLog(&logObject,
+                   "session:%p:Reporting %u deferred requests as busy: Not completed in time.",
+                   (const void*) session,
+                   transaction->numPendingRequests);
+            for (size_t j = 0; j < transaction->numRequests; j++) {
+                HAPIPDeferredRequest* deferredRequest = &transaction->requests[j];
+                if (deferredRequest->isPending) {
+                    deferredRequest->error = kHAPError_Busy;
+                    deferredRequest->isPending = false;
+                }
+            }
+            transaction->numPendingRequests = 0;
+        }
+        ResumeDeferredTransaction(session);
+    }
+
+    ScheduleDeferredRequestTimer(server_);
+}
+
+/**
+ * Schedules the timer that reports deferred requests as busy once they have not been completed in time.
+ *
+ * @param      server_              Accessory server.
+ */
+static void ScheduleDeferredRequestTimer(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    HAPError err;
+
+    if (server->ip.deferredRequestTimer) {
+        HAPPlatformTimerDeregister(server->ip.deferredRequestTimer);
+        server->ip.deferredRequestTimer = 0;
+    }
+
+    bool hasDeadline = false;
+    HAPTime deadline_ms = 0;
+    for (size_t i = 0; i < GetNumSessions(server); i++) {
+        const HAPIPSessionSlot* slot = GetSessionSlot(server, i);
+        if (!slot->isActive || (slot->state != kHAPIPSessionState_Waiting)) {
+            continue;
+        }
+        const HAPIPSessionDescriptor* session = (const HAPIPSessionDescriptor*) &GetSession(server, i)->descriptor;
+        HAPAssert(session->deferredTransaction);
+        HAPAssert(slot->stamp <= UINT64_MAX - kHAPIPSession_MaxDeferredRequestTime);
+        HAPTime t_ms = slot->stamp;
+        if (HAPNonnull(session->deferredTransaction)->numPendingRequests) {
+            t_ms += kHAPIPSession_MaxDeferredRequestTime;
+        }
+        if (!hasDeadline || (t_ms < deadline_ms)) {
+            hasDeadline = true;
+            deadline_ms = t_ms;
+        }
+    }
+    if (!hasDeadline) {
+        return;
+    }
+
+    err = HAPPlatformTimerRegister(
+            &server->ip.deferredRequestTimer, deadline_ms, handle_deferred_request_timer, server_);
+    if (err) {
+        HAPLog(&logObject, "Not enough resources to schedule deferred request timer!");
+        HAPFatalError();
+    }
+    HAPAssert(server->ip.deferredRequestTimer);
+}
+
+static void engine_complete_request(
+        HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service,
+        const HAPAccessory* accessory,
+        HAPSessionRef* securitySession,
+        HAPError error) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(characteristic);
+    HAPPrecondition(service);
+    HAPPrecondition(accessory);
+    HAPPrecondition(securitySession);
+
+    HAPIPSessionDescriptor* _Nullable session = NULL;
+    for (size_t i = 0; i < GetNumSessions(server); i++) {
+        const HAPIPSessionSlot* slot = GetSessionSlot(server, i);
+        if (!slot->isActive || (slot->state != kHAPIPSessionState_Waiting)) {
+            continue;
+        }
+        HAPIPSessionDescriptor* t = (HAPIPSessionDescriptor*) &GetSession(server, i)->descriptor;
+        if ((t->securitySession.type == kHAPIPSecuritySessionType_HAP) &&
+            (&t->securitySession._.hap == securitySession)) {
+            session = t;
+            break;
+        }
+    }
+    if (!session) {
+        const HAPIPSessionDescriptor* _Nullable t = server->ip.earlyCompletions.session;
+        if (t && (t->securitySession.type == kHAPIPSecuritySessionType_HAP) &&
+            (&t->securitySession._.hap == securitySession)) {
+            // The transaction of the session is still being processed. The completion is applied once it has been
+            // recorded which requests have been deferred.
+            if (server->ip.earlyCompletions.numRequests == HAPArrayCount(server->ip.earlyCompletions.requests)) {
+                HAPLogCharacteristicError(
+                        &logObject, characteristic, service, accessory, "Ignoring completion: Too many completions.");
+                return;
+            }
+            size_t i = server->ip.earlyCompletions.numRequests;
+            server->ip.earlyCompletions.requests[i].aid = accessory->aid;
+            server->ip.earlyCompletions.requests[i].iid = ((const HAPBaseCharacteristic*) characteristic)->iid;
+            server->ip.earlyCompletions.requests[i].error = error;
+            server->ip.earlyCompletions.numRequests++;
+            return;
+        }
+        HAPLogCharacteristicError(
+                &logObject, characteristic, service, accessory, "Ignoring completion: Session is not waiting.");
+        return;
+    }
+
+    HAPAssert(session->deferredTransaction);
+    HAPIPDeferredTransaction* transaction = HAPNonnull(session->deferredTransaction);
+    HAPIPDeferredRequest* _Nullable deferredRequest = NULL;
+    for (size_t i = 0; i < transaction->numRequests; i++) {
+        HAPIPDeferredRequest* t = &transaction->requests[i];
+        if (t->isPending && (t->iid == ((const HAPBaseCharacteristic*) characteristic)->iid) &&
+            (t->aid == accessory->aid)) {
+            deferredRequest = t;
+            break;
+        }
+    }
+    if (!deferredRequest) {
+        HAPLogCharacteristicInfo(
+                &logObject, characteristic, service, accessory, "Ignoring completion: Request is not pending.");
+        return;
+    }
+    deferredRequest->error = error;
+    deferredRequest->isPending = false;
+    HAPAssert(transaction->numPendingRequests);
+    transaction->numPendingRequests--;
+    if (transaction->numPendingRequests) {
+        return;
+    }
+    ResumeDeferredTransaction(session);
+}
+
 static void Create(HAPAccessoryServerRef* server_, const HAPAccessoryServerOptions* options) {
     HAPPrecondition(server_);
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
@@ -4069,6 +5658,11 @@ static void Create(HAPAccessoryServerRef* server_, const HAPAccessoryServerOptio
     HAPPrecondition(storage->scratchBuffer.bytes);
     HAPPrecondition(storage->sessions);
     HAPPrecondition(storage->numSessions);
+    if (storage->bufferPool.bytes) {
+        HAPPrecondition(storage->bufferPool.numBytesPerBlock);
+        HAPPrecondition(storage->bufferPool.numBlocks);
+        HAPPrecondition(storage->bufferPool.numBlocks <= kHAPIPBufferPool_MaxBlocks);
+    }
     for (size_t i = 0; i < storage->numSessions; i++) {
         HAPIPSession* session = &storage->sessions[i];
         HAPPrecondition(session->inboundBuffer.bytes);
@@ -4078,6 +5672,19 @@ static void Create(HAPAccessoryServerRef* server_, const HAPAccessoryServerOptio
     HAPRawBufferZero(storage->readContexts, storage->numReadContexts * sizeof *storage->readContexts);
     HAPRawBufferZero(storage->writeContexts, storage->numWriteContexts * sizeof *storage->writeContexts);
     HAPRawBufferZero(storage->scratchBuffer.bytes, storage->scratchBuffer.numBytes);
+    server->ip.scratchBuffer.bytes = storage->scratchBuffer.bytes;
+    server->ip.scratchBuffer.numBytes = storage->scratchBuffer.numBytes;
+    HAPIPSessionSlotRef* sessionSlots = storage->sessionSlots;
+    if (!sessionSlots) {
+        // Session slots are taken from the beginning of the scratch buffer.
+        size_t numPaddingBytes = (size_t)(-(uintptr_t) storage->scratchBuffer.bytes & (sizeof(uint64_t) - 1));
+        size_t numSessionSlotBytes = numPaddingBytes + storage->numSessions * sizeof *sessionSlots;
+        HAPPrecondition(storage->scratchBuffer.numBytes > numSessionSlotBytes);
+        sessionSlots = (HAPIPSessionSlotRef*) (void*) &((uint8_t*) storage->scratchBuffer.bytes)[numPaddingBytes];
+        server->ip.scratchBuffer.bytes = &((uint8_t*) storage->scratchBuffer.bytes)[numSessionSlotBytes];
+        server->ip.scratchBuffer.numBytes -= numSessionSlotBytes;
+    }
+    HAPRawBufferZero(sessionSlots, storage->numSessions * sizeof *sessionSlots);
     for (size_t i = 0; i < storage->numSessions; i++) {
         HAPIPSession* ipSession = &storage->sessions[i];
         HAPRawBufferZero(&ipSession->descriptor, sizeof ipSession->descriptor);
@@ -4088,6 +5695,13 @@ static void Create(HAPAccessoryServerRef* server_, const HAPAccessoryServerOptio
                 ipSession->numEventNotifications * sizeof *ipSession->eventNotifications);
     }
     server->ip.storage = options->ip.accessoryServerStorage;
+    HAPRawBufferZero(server->ip.sessionChunks, sizeof server->ip.sessionChunks);
+    server->ip.sessionChunks[0].sessions = storage->sessions;
+    server->ip.sessionChunks[0].sessionSlots = sessionSlots;
+    server->ip.numSessionChunks = 1;
+
+    // Initialize session traffic capture.
+    HAPIPCaptureCreate(server_, options->ip.capture.callback);
 
     // Install server engine.
     HAPNonnull(server->transports.ip)->serverEngine.install();
@@ -4098,11 +5712,14 @@ static void PrepareStart(HAPAccessoryServerRef* server_) {
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
 
     HAPIPAccessoryServerStorage* storage = HAPNonnull(server->ip.storage);
+    server->ip.bufferPoolBlocksInUse = 0;
     HAPRawBufferZero(storage->readContexts, storage->numReadContexts * sizeof *storage->readContexts);
     HAPRawBufferZero(storage->writeContexts, storage->numWriteContexts * sizeof *storage->writeContexts);
-    HAPRawBufferZero(storage->scratchBuffer.bytes, storage->scratchBuffer.numBytes);
-    for (size_t i = 0; i < storage->numSessions; i++) {
-        HAPIPSession* ipSession = &storage->sessions[i];
+    HAPRawBufferZero(HAPNonnull(server->ip.scratchBuffer.bytes), server->ip.scratchBuffer.numBytes);
+    for (size_t i = 0; i < GetNumSessions(server); i++) {
+        HAPIPSessionSlot* slot = GetSessionSlot(server, i);
+        HAPRawBufferZero(slot, sizeof *slot);
+        HAPIPSession* ipSession = GetSession(server, i);
         HAPRawBufferZero(&ipSession->descriptor, sizeof ipSession->descriptor);
         HAPRawBufferZero(ipSession->inboundBuffer.bytes, ipSession->inboundBuffer.numBytes);
         HAPRawBufferZero(ipSession->outboundBuffer.bytes, ipSession->outboundBuffer.numBytes);
@@ -4159,7 +5776,9 @@ const HAPAccessoryServerServerEngine HAPIPAccessoryServerServerEngine = { .init
                                                                           .stop = engine_stop,
                                                                           .raise_event = engine_raise_event,
                                                                           .raise_event_on_session =
-                                                                                  engine_raise_event_on_session };
+                                                                                  engine_raise_event_on_session,
+                                                                          .complete_request =
+                                                                                  engine_complete_request };
 
 HAP_RESULT_USE_CHECK
 size_t HAPAccessoryServerGetIPSessionIndex(const HAPAccessoryServerRef* server_, const HAPSessionRef* session) {
@@ -4167,13 +5786,12 @@ size_t HAPAccessoryServerGetIPSessionIndex(const HAPAccessoryServerRef* server_,
     const HAPAccessoryServer* server = (const HAPAccessoryServer*) server_;
     HAPPrecondition(session);
 
-    const HAPIPAccessoryServerStorage* storage = HAPNonnull(server->ip.storage);
-
-    for (size_t i = 0; i < storage->numSessions; i++) {
-        HAPIPSessionDescriptor* t = (HAPIPSessionDescriptor*) &storage->sessions[i].descriptor;
-        if (!t->server) {
+    for (size_t i = 0; i < GetNumSessions(server); i++) {
+        const HAPIPSessionSlot* slot = GetSessionSlot(server, i);
+        if (!slot->isActive) {
             continue;
         }
+        HAPIPSessionDescriptor* t = (HAPIPSessionDescriptor*) &GetSession(server, i)->descriptor;
         if (t->securitySession.type != kHAPIPSecuritySessionType_HAP) {
             continue;
         }
@@ -39,6 +39,13 @@ typedef struct {
             const HAPService* service,
             const HAPAccessory* accessory,
             const HAPSessionRef* session);
+    void (*complete_request)(
+            HAPAccessoryServerRef* server,
+            const HAPCharacteristic* characteristic,
+            const HAPService* service,
+            const HAPAccessory* accessory,
+            HAPSessionRef* session,
+            HAPError error);
 } HAPAccessoryServerServerEngine;
 
 extern const HAPAccessoryServerServerEngine HAPIPAccessoryServerServerEngine;
@@ -123,9 +130,73 @@ HAP_ENUM_BEGIN(uint8_t, HAPIPSessionState) { /** Accessory server session is idl
                                              kHAPIPSessionState_Reading,
 
                                              /** Accessory server session is writing. */
-                                             kHAPIPSessionState_Writing
+                                             kHAPIPSessionState_Writing,
+
+                                             /** Accessory server session is waiting for deferred requests. */
+                                             kHAPIPSessionState_Waiting
 } HAP_ENUM_END(uint8_t, HAPIPSessionState);
 
+/**
+ * Maximum number of characteristics in a single HTTP transaction for which requests may be deferred.
+ */
+#define kHAPIPSession_MaxDeferredRequests ((size_t) 8)
+
+/**
+ * Maximum number of sessions that may wait for deferred requests at the same time.
+ *
+ * - Further sessions report their deferred requests as busy.
+ */
+#define kHAPIPAccessoryServer_MaxDeferredTransactions ((size_t) 4)
+
+/**
+ * Characteristic request of a HTTP transaction whose completion has been deferred.
+ *
+ * - When a handler of a request in a transaction returns kHAPError_InProgress, the results of all requests in
+ *   the transaction are recorded, and the response is built from them once all deferred requests have completed.
+ */
+typedef struct {
+    /** Accessory instance ID. */
+    uint64_t aid;
+
+    /** Characteristic instance ID. */
+    uint64_t iid;
+
+    /** HAP status code of the request as of the first time the transaction has been processed. */
+    int32_t status;
+
+    /** Result reported by the application when completing a deferred request. */
+    HAPError error;
+
+    /** Flag indicating whether the value is included in the response of a write request. */
+    bool response : 1;
+
+    /** Flag indicating whether the handler of the request returned kHAPError_InProgress. */
+    bool isDeferred : 1;
+
+    /** Flag indicating whether the application has not yet completed the deferred request. */
+    bool isPending : 1;
+} HAPIPDeferredRequest;
+
+/**
+ * HTTP transaction of a session that waits for deferred requests.
+ *
+ * - Transactions are taken from a small table in the accessory server while a session is waiting,
+ *   so that sessions that never defer requests do not reserve space for them.
+ */
+typedef struct {
+    /** Recorded requests of the transaction, indexed by position in the transaction. */
+    HAPIPDeferredRequest requests[kHAPIPSession_MaxDeferredRequests];
+
+    /** Number of recorded requests. */
+    uint8_t numRequests;
+
+    /** Number of deferred requests that have not yet been completed by the application. */
+    uint8_t numPendingRequests;
+
+    /** Flag indicating whether the transaction is assigned to a session. */
+    bool isActive;
+} HAPIPDeferredTransaction;
+
 /**
  * HTTP/1.1 Content Type.
  */
@@ -157,6 +228,30 @@ typedef struct {
 } HAPIPEventNotification;
 HAP_STATIC_ASSERT(sizeof(HAPIPEventNotificationRef) >= sizeof(HAPIPEventNotification), event_notification);
 
+/**
+ * IP specific accessory server session slot.
+ *
+ * - Contains the session state that is evaluated when scanning all sessions, e.g., for garbage collection,
+ *   idle timeouts, and event notification scheduling. All other session state is kept in the session descriptor.
+ */
+typedef struct {
+    /** Time stamp of last activity on this session. */
+    HAPTime stamp;
+
+    /** Time stamp of last event notification on this session. */
+    HAPTime eventNotificationStamp;
+
+    /** The number of raised events on this session. */
+    size_t numEventNotificationFlags;
+
+    /** IP session state. */
+    HAPIPSessionState state;
+
+    /** Flag indicating whether the slot is in use by a session. */
+    bool isActive;
+} HAPIPSessionSlot;
+HAP_STATIC_ASSERT(sizeof(HAPIPSessionSlotRef) >= sizeof(HAPIPSessionSlot), HAPIPSessionSlot);
+
 /**
  * IP specific accessory server session descriptor.
  */
@@ -164,17 +259,17 @@ typedef struct {
     /** Accessory server serving this session. */
     HAPAccessoryServerRef* _Nullable server;
 
+    /** Session slot containing the scheduling state of this session. */
+    HAPIPSessionSlot* _Nullable slot;
+
     /** TCP stream. */
     HAPPlatformTCPStreamRef tcpStream;
 
     /** Flag indicating whether the TCP stream is open. */
     bool tcpStreamIsOpen;
 
-    /** IP session state. */
-    HAPIPSessionState state;
-
-    /** Time stamp of last activity on this session. */
-    HAPTime stamp;
+    /** Capture session ID. 0 if the session is not being captured. */
+    uint16_t captureSessionID;
 
     /** Security session. */
     HAPIPSecuritySession securitySession;
@@ -185,6 +280,17 @@ typedef struct {
     /** Marked inbound buffer position indicating the position until which the buffer has been decrypted. */
     size_t inboundBufferMark;
 
+    /**
+     * Number of bytes of completed requests in front of the inbound buffer.
+     *
+     * - When a request completes, the inbound buffer is advanced past it instead of moving pipelined data
+     *   to the front. The inbound buffer is rewound once it is empty, or compacted once it is full.
+     */
+    size_t inboundBufferOffset;
+
+    /** Flag indicating whether the inbound buffer is a block borrowed from the buffer pool. */
+    bool inboundBufferIsPooled;
+
     /** Outbound buffer. */
     HAPIPByteBuffer outboundBuffer;
 
@@ -194,6 +300,9 @@ typedef struct {
      */
     size_t outboundBufferMark;
 
+    /** Flag indicating whether the outbound buffer is a block borrowed from the buffer pool. */
+    bool outboundBufferIsPooled;
+
     /** HTTP reader. */
     struct util_http_reader httpReader;
 
@@ -298,16 +407,6 @@ typedef struct {
      */
     size_t numEventNotifications;
 
-    /**
-     * The number of raised events on this session.
-     */
-    size_t numEventNotificationFlags;
-
-    /**
-     * Time stamp of last event notification on this session.
-     */
-    HAPTime eventNotificationStamp;
-
     /**
      * Time when the request expires. 0 if no timed write in progress.
      */
@@ -327,6 +426,11 @@ typedef struct {
      * Flag indicating whether incremental serialization of accessory attribute database is in progress.
      */
     bool accessorySerializationIsInProgress;
+
+    /**
+     * HTTP transaction waiting for deferred requests. NULL if no requests of the current transaction are recorded.
+     */
+    HAPIPDeferredTransaction* _Nullable deferredTransaction;
 } HAPIPSessionDescriptor;
 HAP_STATIC_ASSERT(sizeof(HAPIPSessionDescriptorRef) >= sizeof(HAPIPSessionDescriptor), HAPIPSessionDescriptor);
 
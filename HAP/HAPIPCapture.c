@@ -0,0 +1,196 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+
+static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .category = "IPCapture" };
+
+/**
+ * Emits a capture record.
+ *
+ * @param      server               Accessory server.
+ * @param      type                 Record type.
+ * @param      sessionID            Capture session ID.
+ * @param      bytes                Payload.
+ * @param      numBytes             Length of payload.
+ */
+static void EmitRecord(
+        HAPAccessoryServer* server,
+        HAPIPCaptureRecordType type,
+        uint16_t sessionID,
+        const void* _Nullable bytes,
+        size_t numBytes) {
+    HAPPrecondition(server);
+    HAPPrecondition(server->ip.capture.callback);
+    HAPPrecondition(!numBytes || bytes);
+    HAPPrecondition(numBytes <= UINT32_MAX);
+
+    // The header is emitted lazily because the client context is not yet available when the server is created.
+    if (!server->ip.capture.isHeaderEmitted) {
+        uint8_t header[kHAPIPCapture_NumHeaderBytes];
+        HAPRawBufferCopyBytes(&header[0], "HAPCAPTR", 8);
+        HAPWriteLittleUInt32(&header[8], kHAPIPCapture_Version);
+        HAPWriteLittleUInt32(&header[12], 0);
+        server->ip.capture.callback((HAPAccessoryServerRef*) server, header, sizeof header, server->context);
+        server->ip.capture.isHeaderEmitted = true;
+    }
+
+    HAPTime now = HAPPlatformClockGetCurrent();
+    HAPTime delay = now >= server->ip.capture.lastRecordTime ? now - server->ip.capture.lastRecordTime : 0;
+    server->ip.capture.lastRecordTime = now;
+
+    uint8_t header[kHAPIPCapture_NumRecordHeaderBytes];
+    header[0] = type;
+    header[1] = 0;
+    HAPWriteLittleUInt16(&header[2], sessionID);
+    HAPWriteLittleUInt32(&header[4], (uint32_t) HAPMin(delay / HAPMillisecond, (HAPTime) UINT32_MAX));
+    HAPWriteLittleUInt32(&header[8], (uint32_t) numBytes);
+    server->ip.capture.callback((HAPAccessoryServerRef*) server, header, sizeof header, server->context);
+    if (numBytes) {
+        server->ip.capture.callback((HAPAccessoryServerRef*) server, HAPNonnull(bytes), numBytes, server->context);
+    }
+}
+
+void HAPIPCaptureCreate(HAPAccessoryServerRef* server_, HAPIPCaptureCallback _Nullable callback) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    HAPRawBufferZero(&server->ip.capture, sizeof server->ip.capture);
+    if (!callback) {
+        return;
+    }
+    HAPLogInfo(&logObject, "Capturing HAP over IP session traffic. Captures contain sensitive data.");
+    server->ip.capture.callback = callback;
+    server->ip.capture.lastRecordTime = HAPPlatformClockGetCurrent();
+}
+
+void HAPIPCaptureOpenSession(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(!session->captureSessionID);
+
+    if (!server->ip.capture.callback) {
+        return;
+    }
+
+    server->ip.capture.lastSessionID++;
+    if (!server->ip.capture.lastSessionID) {
+        server->ip.capture.lastSessionID++;
+    }
+    session->captureSessionID = server->ip.capture.lastSessionID;
+    HAPLogDebug(&logObject, "session:%p:capturing as %u", (const void*) session, session->captureSessionID);
+    EmitRecord(server, kHAPIPCaptureRecordType_Open, session->captureSessionID, NULL, 0);
+}
+
+void HAPIPCaptureData(HAPIPSessionDescriptor* session, const void* bytes, size_t numBytes) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(bytes);
+
+    if (!session->captureSessionID || !numBytes) {
+        return;
+    }
+    HAPAssert(server->ip.capture.callback);
+    EmitRecord(server, kHAPIPCaptureRecordType_Data, session->captureSessionID, bytes, numBytes);
+}
+
+void HAPIPCaptureCloseSession(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+
+    if (!session->captureSessionID) {
+        return;
+    }
+    HAPAssert(server->ip.capture.callback);
+    EmitRecord(server, kHAPIPCaptureRecordType_Close, session->captureSessionID, NULL, 0);
+    session->captureSessionID = 0;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPIPCaptureValidateHeader(const void* bytes_, size_t numBytes) {
+    HAPPrecondition(bytes_);
+    const uint8_t* bytes = bytes_;
+
+    if (numBytes < kHAPIPCapture_NumHeaderBytes) {
+        HAPLog(&logObject, "Capture too short: %zu bytes.", numBytes);
+        return kHAPError_InvalidData;
+    }
+    if (!HAPRawBufferAreEqual(&bytes[0], "HAPCAPTR", 8)) {
+        HAPLog(&logObject, "Capture has invalid magic.");
+        return kHAPError_InvalidData;
+    }
+    uint32_t version = HAPReadLittleUInt32(&bytes[8]);
+    if (version != kHAPIPCapture_Version) {
+        HAPLog(&logObject, "Capture has unsupported version %lu.", (unsigned long) version);
+        return kHAPError_InvalidData;
+    }
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPIPCaptureGetNextRecord(
+        const void* bytes_,
+        size_t numBytes,
+        size_t* offset,
+        bool* found,
+        HAPIPCaptureRecord* record) {
+    HAPPrecondition(bytes_);
+    const uint8_t* bytes = bytes_;
+    HAPPrecondition(offset);
+    HAPPrecondition(*offset >= kHAPIPCapture_NumHeaderBytes);
+    HAPPrecondition(*offset <= numBytes);
+    HAPPrecondition(found);
+    HAPPrecondition(record);
+
+    *found = false;
+    if (*offset == numBytes) {
+        return kHAPError_None;
+    }
+    if (numBytes - *offset < kHAPIPCapture_NumRecordHeaderBytes) {
+        HAPLog(&logObject, "Truncated record header at offset %zu.", *offset);
+        return kHAPError_InvalidData;
+    }
+    const uint8_t* header = &bytes[*offset];
+    HAPRawBufferZero(record, sizeof *record);
+    record->type = header[0];
+    record->sessionID = HAPReadLittleUInt16(&header[2]);
+    record->delay = HAPReadLittleUInt32(&header[4]);
+    record->numBytes = HAPReadLittleUInt32(&header[8]);
+    switch (record->type) {
+        case kHAPIPCaptureRecordType_Open:
+        case kHAPIPCaptureRecordType_Close: {
+            if (record->numBytes) {
+                HAPLog(&logObject, "Unexpected payload at offset %zu.", *offset);
+                return kHAPError_InvalidData;
+            }
+        } break;
+        case kHAPIPCaptureRecordType_Data: {
+            if (!record->numBytes) {
+                HAPLog(&logObject, "Empty data record at offset %zu.", *offset);
+                return kHAPError_InvalidData;
+            }
+        } break;
+        default: {
+            HAPLog(&logObject, "Unknown record type %u at offset %zu.", header[0], *offset);
+            return kHAPError_InvalidData;
+        }
+    }
+    if (!record->sessionID) {
+        HAPLog(&logObject, "Invalid session ID at offset %zu.", *offset);
+        return kHAPError_InvalidData;
+    }
+    if (numBytes - *offset - kHAPIPCapture_NumRecordHeaderBytes < record->numBytes) {
+        HAPLog(&logObject, "Truncated record payload at offset %zu.", *offset);
+        return kHAPError_InvalidData;
+    }
+    record->bytes = record->numBytes ? &header[kHAPIPCapture_NumRecordHeaderBytes] : NULL;
+    *offset += kHAPIPCapture_NumRecordHeaderBytes + record->numBytes;
+    *found = true;
+    return kHAPError_None;
+}
@@ -0,0 +1,153 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#ifndef HAP_IP_CAPTURE_H
+#define HAP_IP_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "HAP+Internal.h"
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull begin
+#endif
+
+/**
+ * Number of bytes of the capture header.
+ *
+ * - 8 bytes magic "HAPCAPTR", 4 bytes version, 4 reserved bytes (little endian).
+ */
+#define kHAPIPCapture_NumHeaderBytes ((size_t) 16)
+
+/**
+ * Number of bytes of a capture record header. The record header is followed by the record payload.
+ *
+ * - 1 byte type, 1 reserved byte, 2 bytes session ID, 4 bytes milliseconds since the previous record,
+ *   4 bytes payload length (little endian).
+ */
+#define kHAPIPCapture_NumRecordHeaderBytes ((size_t) 12)
+
+/**
+ * Capture format version.
+ */
+#define kHAPIPCapture_Version ((uint32_t) 1)
+
+/**
+ * Capture record type.
+ */
+HAP_ENUM_BEGIN(uint8_t, HAPIPCaptureRecordType) {
+    /** A HAP session has been secured. No payload. */
+    kHAPIPCaptureRecordType_Open = 1,
+
+    /** Decrypted request data has been received. Payload: Decrypted data. */
+    kHAPIPCaptureRecordType_Data,
+
+    /** The session has been closed. No payload. */
+    kHAPIPCaptureRecordType_Close
+} HAP_ENUM_END(uint8_t, HAPIPCaptureRecordType);
+
+/**
+ * Capture record.
+ */
+typedef struct {
+    /** Record type. */
+    HAPIPCaptureRecordType type;
+
+    /** Capture session ID. */
+    uint16_t sessionID;
+
+    /** Time since the previous record in milliseconds. */
+    uint32_t delay;
+
+    /** Payload. */
+    const void* _Nullable bytes;
+
+    /** Length of payload. */
+    size_t numBytes;
+} HAPIPCaptureRecord;
+
+/**
+ * Initializes session traffic capture.
+ *
+ * - The capture header is emitted together with the first record.
+ *
+ * @param      server               Accessory server.
+ * @param      callback             Callback that receives the capture data. NULL to disable capturing.
+ */
+void HAPIPCaptureCreate(HAPAccessoryServerRef* server, HAPIPCaptureCallback _Nullable callback);
+
+/**
+ * Starts capturing a session that has just been secured.
+ *
+ * - Has no effect if capturing is disabled.
+ *
+ * @param      session              IP session descriptor.
+ */
+void HAPIPCaptureOpenSession(HAPIPSessionDescriptor* session);
+
+/**
+ * Captures decrypted request data of a session.
+ *
+ * - Has no effect if the session is not being captured.
+ *
+ * @param      session              IP session descriptor.
+ * @param      bytes                Decrypted data.
+ * @param      numBytes             Length of decrypted data.
+ */
+void HAPIPCaptureData(HAPIPSessionDescriptor* session, const void* bytes, size_t numBytes);
+
+/**
+ * Stops capturing a session that is being closed.
+ *
+ * - Has no effect if the session is not being captured.
+ *
+ * @param      session              IP session descriptor.
+ */
+void HAPIPCaptureCloseSession(HAPIPSessionDescriptor* session);
+
+/**
+ * Validates the header of a capture.
+ *
+ * @param      bytes                Capture.
+ * @param      numBytes             Length of capture.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidData    If the capture header is malformed or has an unsupported version.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPIPCaptureValidateHeader(const void* bytes, size_t numBytes);
+
+/**
+ * Parses the next record of a capture.
+ *
+ * @param      bytes                Capture.
+ * @param      numBytes             Length of capture.
+ * @param[in,out] offset            Offset of the next record. Must initially be kHAPIPCapture_NumHeaderBytes.
+ * @param[out] found                Whether or not a record has been found. False at the end of the capture.
+ * @param[out] record               Record, if found. The payload points into the capture.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidData    If the record is malformed or truncated.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPIPCaptureGetNextRecord(
+        const void* bytes,
+        size_t numBytes,
+        size_t* offset,
+        bool* found,
+        HAPIPCaptureRecord* record);
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull end
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -39,6 +39,8 @@ void HAPIPSecurityProtocolEncryptData(HAPAccessoryServerRef* server_, HAPSession
     HAPAssert(buffer->position <= buffer->capacity - numEncryptedBytes);
 
     size_t position = buffer->position;
+    size_t numPlaintextBytes = buffer->limit - buffer->position;
+    HAPTraceBegin(kHAPTraceEvent_Encrypt, numPlaintextBytes, 0);
 
     while (position < buffer->limit) {
         size_t numFrameBytes = buffer->limit - position > kHAPIPSecurityProtocol_MaxFrameBytes ?
@@ -69,6 +71,7 @@ void HAPIPSecurityProtocolEncryptData(HAPAccessoryServerRef* server_, HAPSession
                 /* aad length: */
                 kHAPIPSecurityProtocol_NumAADBytes);
         HAPAssert(!err);
+        HAPMetricsAddToCounter(server_, numEncryptedBytes, numFrameBytes);
 
         position += numFrameBytes + kHAPIPSecurityProtocol_NumAADBytes + CHACHA20_POLY1305_TAG_BYTES;
         buffer->limit += kHAPIPSecurityProtocol_NumAADBytes + CHACHA20_POLY1305_TAG_BYTES;
@@ -76,6 +79,8 @@ void HAPIPSecurityProtocolEncryptData(HAPAccessoryServerRef* server_, HAPSession
         HAPAssert(position <= buffer->limit);
         HAPAssert(buffer->limit <= buffer->capacity);
     }
+
+    HAPTraceEnd(kHAPTraceEvent_Encrypt, numPlaintextBytes, 0);
 }
 
 HAP_RESULT_USE_CHECK
@@ -92,17 +97,25 @@ HAPError HAPIPSecurityProtocolDecryptData(
 
     HAPError err;
 
+    // The plaintext of each frame is stored directly behind the plaintext of the previous frame, so that the AAD and
+    // tag bytes do not need to be removed by moving the remaining data. Frames are decrypted into a separate buffer
+    // first, as the crypto PAL does not allow plaintext and ciphertext to partially overlap.
+    uint8_t frameBytes[kHAPIPSecurityProtocol_MaxFrameBytes];
+    size_t position = buffer->position;
+    size_t numAvailableBytes = buffer->limit - buffer->position;
+    HAPTraceBegin(kHAPTraceEvent_Decrypt, numAvailableBytes, 0);
     for (;;) {
-        if (buffer->limit - buffer->position < kHAPIPSecurityProtocol_NumAADBytes) {
+        if (buffer->limit - position < kHAPIPSecurityProtocol_NumAADBytes) {
             break;
         }
 
-        size_t numFrameBytes = HAPReadLittleUInt16(&buffer->data[buffer->position]);
+        size_t numFrameBytes = HAPReadLittleUInt16(&buffer->data[position]);
         if (numFrameBytes > kHAPIPSecurityProtocol_MaxFrameBytes) {
+            HAPTraceEnd(kHAPTraceEvent_Decrypt, numAvailableBytes, 0);
             return kHAPError_InvalidData;
         }
 
-        if (buffer->limit - buffer->position <
+        if (buffer->limit - position <
             +numFrameBytes + kHAPIPSecurityProtocol_NumAADBytes + CHACHA20_POLY1305_TAG_BYTES) {
             break;
         }
@@ -111,33 +124,36 @@ HAPError HAPIPSecurityProtocolDecryptData(
                 server_,
                 session,
                 /* plaintext: */
-                &buffer->data[buffer->position],
+                frameBytes,
                 /* ciphertext: */
-                &buffer->data[buffer->position + kHAPIPSecurityProtocol_NumAADBytes],
+                &buffer->data[position + kHAPIPSecurityProtocol_NumAADBytes],
                 /* ciphertext length: */
                 numFrameBytes + CHACHA20_POLY1305_TAG_BYTES,
                 /* aad: */
-                &buffer->data[buffer->position],
+                &buffer->data[position],
                 /* aad length: */
                 kHAPIPSecurityProtocol_NumAADBytes);
         if (err) {
+            HAPTraceEnd(kHAPTraceEvent_Decrypt, numAvailableBytes, 0);
             return kHAPError_InvalidData;
         }
+        HAPMetricsAddToCounter(server_, numDecryptedBytes, numFrameBytes);
 
-        HAPRawBufferCopyBytes(
-                &buffer->data[buffer->position + numFrameBytes],
-                &buffer
-                         ->data[buffer->position + numFrameBytes + kHAPIPSecurityProtocol_NumAADBytes +
-                                CHACHA20_POLY1305_TAG_BYTES],
-                buffer->limit - (buffer->position + numFrameBytes + kHAPIPSecurityProtocol_NumAADBytes +
-                                 CHACHA20_POLY1305_TAG_BYTES));
-
+        HAPRawBufferCopyBytes(&buffer->data[buffer->position], frameBytes, numFrameBytes);
         buffer->position += numFrameBytes;
-        buffer->limit -= kHAPIPSecurityProtocol_NumAADBytes + CHACHA20_POLY1305_TAG_BYTES;
+        position += numFrameBytes + kHAPIPSecurityProtocol_NumAADBytes + CHACHA20_POLY1305_TAG_BYTES;
 
-        HAPAssert(buffer->position <= buffer->limit);
-        HAPAssert(buffer->limit <= buffer->capacity);
+        HAPAssert(buffer->position <= position);
+        HAPAssert(position <= buffer->limit);
     }
 
+    // Move the incomplete frame, if any, behind the plaintext.
+    HAPRawBufferCopyBytes(&buffer->data[buffer->position], &buffer->data[position], buffer->limit - position);
+    buffer->limit -= position - buffer->position;
+
+    HAPAssert(buffer->position <= buffer->limit);
+    HAPAssert(buffer->limit <= buffer->capacity);
+
+    HAPTraceEnd(kHAPTraceEvent_Decrypt, numAvailableBytes, buffer->position);
     return kHAPError_None;
 }
@@ -44,6 +44,10 @@ void HAPIPSecurityProtocolEncryptData(HAPAccessoryServerRef* server, HAPSessionR
 /**
  * Decrypts data received over a HomeKit session.
  *
+ * - Complete frames between the buffer's position and limit are decrypted. Their plaintext replaces them in the
+ *   buffer. On return, the plaintext ends at the buffer's position, and an incomplete frame, if any, is stored
+ *   between the position and the limit.
+ *
  * @param      server               Accessory server.
  * @param      session              The session over which the data has been received.
  * @param      buffer               Encrypted data to be decrypted.
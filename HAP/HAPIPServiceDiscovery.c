@@ -12,6 +12,88 @@
 
 static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .category = "IPServiceDiscovery" };
 
+/**
+ * Computes the digest of a list of TXT records.
+ *
+ * @param[out] digest               Digest.
+ * @param      txtRecords           TXT records.
+ * @param      numTXTRecords        Number of TXT records.
+ */
+static void GetTXTRecordsDigest(
+        uint8_t digest[_Nonnull SHA256_BYTES],
+        const HAPPlatformServiceDiscoveryTXTRecord* txtRecords,
+        size_t numTXTRecords) {
+    HAPPrecondition(digest);
+    HAPPrecondition(txtRecords);
+
+    // Each TXT record is serialized as its NULL-terminated key, followed by the length and bytes of its value.
+    uint8_t bytes[512];
+    size_t numBytes = 0;
+    for (size_t i = 0; i < numTXTRecords; i++) {
+        size_t numKeyBytes = HAPStringGetNumBytes(txtRecords[i].key) + 1;
+        size_t numValueBytes = txtRecords[i].value.numBytes;
+        HAPAssert(numValueBytes <= UINT8_MAX);
+        HAPAssert(numKeyBytes + 1 + numValueBytes <= sizeof bytes - numBytes);
+        HAPRawBufferCopyBytes(&bytes[numBytes], txtRecords[i].key, numKeyBytes);
+        numBytes += numKeyBytes;
+        bytes[numBytes++] = (uint8_t) numValueBytes;
+        if (numValueBytes) {
+            HAPRawBufferCopyBytes(&bytes[numBytes], HAPNonnullVoid(txtRecords[i].value.bytes), numValueBytes);
+            numBytes += numValueBytes;
+        }
+    }
+    HAP_sha256(digest, bytes, numBytes);
+}
+
+/**
+ * Registers a Bonjour service, or updates its TXT records if it is already registered.
+ *
+ * - The TXT records of a registered service are only updated if they changed.
+ *
+ * @param      server_              Accessory server.
+ * @param      type                 Service discovery type.
+ * @param      protocol             Protocol of the service.
+ * @param      txtRecords           TXT records.
+ * @param      numTXTRecords        Number of TXT records.
+ */
+static void RegisterOrUpdateService(
+        HAPAccessoryServerRef* server_,
+        HAPIPServiceDiscoveryType type,
+        const char* protocol,
+        HAPPlatformServiceDiscoveryTXTRecord* txtRecords,
+        size_t numTXTRecords) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(type);
+    HAPPrecondition(!server->ip.discoverableService || server->ip.discoverableService == type);
+    HAPPrecondition(protocol);
+    HAPPrecondition(txtRecords);
+
+    uint8_t digest[SHA256_BYTES];
+    GetTXTRecordsDigest(digest, txtRecords, numTXTRecords);
+
+    if (!server->ip.discoverableService) {
+        server->ip.discoverableService = type;
+        HAPLogInfo(&logObject, "Registering %s service.", protocol);
+        HAPPlatformServiceDiscoveryRegister(
+                HAPNonnull(server->platform.ip.serviceDiscovery),
+                server->primaryAccessory->name,
+                protocol,
+                HAPPlatformTCPStreamManagerGetListenerPort(HAPNonnull(server->platform.ip.tcpStreamManager)),
+                txtRecords,
+                numTXTRecords);
+    } else {
+        if (HAPRawBufferAreEqual(server->ip.txtRecordsDigest, digest, sizeof digest)) {
+            HAPLogDebug(&logObject, "Not updating %s service: TXT records did not change.", protocol);
+            return;
+        }
+        HAPLogInfo(&logObject, "Updating %s service.", protocol);
+        HAPPlatformServiceDiscoveryUpdateTXTRecords(
+                HAPNonnull(server->platform.ip.serviceDiscovery), txtRecords, numTXTRecords);
+    }
+    HAPRawBufferCopyBytes(server->ip.txtRecordsDigest, digest, sizeof digest);
+}
+
 /** _hap service. */
 #define kServiceDiscoveryProtocol_HAP "_hap._tcp"
 
@@ -159,7 +241,7 @@ void HAPIPServiceDiscoverySetHAPService(HAPAccessoryServerRef* server_) {
     if (hasSetupID) {
         // Get raw setup hash from setup ID.
         HAPAccessorySetupSetupHash setupHash;
-        HAPAccessorySetupGetSetupHash(&setupHash, &setupID, &deviceIDString);
+        HAPAccessorySetupInfoGetSetupHash(server_, &setupHash, &setupID, &deviceIDString);
 
         // Base64 encode.
         size_t numSetupHashBytes;
@@ -178,22 +260,8 @@ void HAPIPServiceDiscoverySetHAPService(HAPAccessoryServerRef* server_) {
 
     // Register service.
     HAPAssert(numTXTRecords <= HAPArrayCount(txtRecords));
-    if (!server->ip.discoverableService) {
-        server->ip.discoverableService = kHAPIPServiceDiscoveryType_HAP;
-        HAPLogInfo(&logObject, "Registering %s service.", kServiceDiscoveryProtocol_HAP);
-        HAPPlatformServiceDiscoveryRegister(
-                HAPNonnull(server->platform.ip.serviceDiscovery),
-                server->primaryAccessory->name,
-                kServiceDiscoveryProtocol_HAP,
-                HAPPlatformTCPStreamManagerGetListenerPort(HAPNonnull(server->platform.ip.tcpStreamManager)),
-                txtRecords,
-                numTXTRecords);
-    } else {
-        HAPAssert(server->ip.discoverableService == kHAPIPServiceDiscoveryType_HAP);
-        HAPLogInfo(&logObject, "Updating %s service.", kServiceDiscoveryProtocol_HAP);
-        HAPPlatformServiceDiscoveryUpdateTXTRecords(
-                HAPNonnull(server->platform.ip.serviceDiscovery), txtRecords, numTXTRecords);
-    }
+    RegisterOrUpdateService(
+            server_, kHAPIPServiceDiscoveryType_HAP, kServiceDiscoveryProtocol_HAP, txtRecords, numTXTRecords);
 }
 
 /**
@@ -299,22 +367,12 @@ void HAPIPServiceDiscoverySetMFiConfigService(HAPAccessoryServerRef* server_) {
 
     // Register service.
     HAPAssert(numTXTRecords <= HAPArrayCount(txtRecords));
-    if (!server->ip.discoverableService) {
-        server->ip.discoverableService = kHAPIPServiceDiscoveryType_MFiConfig;
-        HAPLogInfo(&logObject, "Registering %s service.", kServiceDiscoveryProtocol_MFiConfig);
-        HAPPlatformServiceDiscoveryRegister(
-                HAPNonnull(server->platform.ip.serviceDiscovery),
-                server->primaryAccessory->name,
-                kServiceDiscoveryProtocol_MFiConfig,
-                HAPPlatformTCPStreamManagerGetListenerPort(HAPNonnull(server->platform.ip.tcpStreamManager)),
-                txtRecords,
-                numTXTRecords);
-    } else {
-        HAPAssert(server->ip.discoverableService == kHAPIPServiceDiscoveryType_MFiConfig);
-        HAPLogInfo(&logObject, "Updating %s service.", kServiceDiscoveryProtocol_MFiConfig);
-        HAPPlatformServiceDiscoveryUpdateTXTRecords(
-                HAPNonnull(server->platform.ip.serviceDiscovery), txtRecords, numTXTRecords);
-    }
+    RegisterOrUpdateService(
+            server_,
+            kHAPIPServiceDiscoveryType_MFiConfig,
+            kServiceDiscoveryProtocol_MFiConfig,
+            txtRecords,
+            numTXTRecords);
 }
 
 void HAPIPServiceDiscoveryStop(HAPAccessoryServerRef* server_) {
@@ -325,6 +383,7 @@ void HAPIPServiceDiscoveryStop(HAPAccessoryServerRef* server_) {
         HAPLogInfo(&logObject, "Stopping service discovery.");
         HAPPlatformServiceDiscoveryStop(HAPNonnull(server->platform.ip.serviceDiscovery));
         server->ip.discoverableService = kHAPIPServiceDiscoveryType_None;
+        HAPRawBufferZero(server->ip.txtRecordsDigest, sizeof server->ip.txtRecordsDigest);
     }
 }
 
@@ -0,0 +1,68 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+
+/**
+ * Upper bounds (exclusive) of the latency histogram buckets, except for the last unbounded bucket.
+ */
+static const HAPTime kHAPMetricsHistogram_BucketBounds[kHAPMetricsHistogram_NumBuckets - 1] = {
+    1 * HAPMillisecond, 2 * HAPMillisecond, 5 * HAPMillisecond, 10 * HAPMillisecond,
+    20 * HAPMillisecond, 50 * HAPMillisecond, 100 * HAPMillisecond
+};
+
+void HAPMetricsCreate(HAPAccessoryServerRef* server_, HAPAccessoryServerMetrics* _Nullable metrics) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    if (metrics) {
+        HAPRawBufferZero(HAPNonnull(metrics), sizeof *metrics);
+    }
+    server->metrics = metrics;
+}
+
+HAP_RESULT_USE_CHECK
+HAPTime HAPMetricsGetTime(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    if (!server->metrics) {
+        return 0;
+    }
+    return HAPPlatformClockGetCurrent();
+}
+
+void HAPMetricsHistogramAddSample(HAPMetricsHistogram* histogram, HAPTime startTime) {
+    HAPPrecondition(histogram);
+
+    HAPTime now = HAPPlatformClockGetCurrent();
+    HAPTime duration = now >= startTime ? now - startTime : 0;
+
+    size_t i;
+    for (i = 0; i < HAPArrayCount(kHAPMetricsHistogram_BucketBounds); i++) {
+        if (duration < kHAPMetricsHistogram_BucketBounds[i]) {
+            break;
+        }
+    }
+    histogram->buckets[i]++;
+    histogram->numSamples++;
+    histogram->totalDuration += duration;
+    if (duration > histogram->maxDuration) {
+        histogram->maxDuration = duration;
+    }
+}
+
+void HAPAccessoryServerGetMetrics(const HAPAccessoryServerRef* server_, HAPAccessoryServerMetrics* metrics) {
+    HAPPrecondition(server_);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) server_;
+    HAPPrecondition(metrics);
+
+    if (!server->metrics) {
+        HAPRawBufferZero(metrics, sizeof *metrics);
+        return;
+    }
+    HAPRawBufferCopyBytes(metrics, HAPNonnull(server->metrics), sizeof *metrics);
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#ifndef HAP_METRICS_H
+#define HAP_METRICS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "HAP+Internal.h"
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull begin
+#endif
+
+/**
+ * Initializes performance metrics recording.
+ *
+ * @param      server               Accessory server.
+ * @param      metrics              Metrics storage. NULL to disable metrics.
+ */
+void HAPMetricsCreate(HAPAccessoryServerRef* server, HAPAccessoryServerMetrics* _Nullable metrics);
+
+/**
+ * Gets the start time of a latency measurement.
+ *
+ * - If metrics are disabled, the clock is not queried.
+ *
+ * @param      server               Accessory server.
+ *
+ * @return Current time if metrics are enabled, 0 otherwise.
+ */
+HAP_RESULT_USE_CHECK
+HAPTime HAPMetricsGetTime(HAPAccessoryServerRef* server);
+
+/**
+ * Adds a sample to a latency histogram.
+ *
+ * @param      histogram            Latency histogram.
+ * @param      startTime            Start time of the measurement, as returned by HAPMetricsGetTime.
+ */
+void HAPMetricsHistogramAddSample(HAPMetricsHistogram* histogram, HAPTime startTime);
+
+/**
+ * Adds a value to a metrics counter, if metrics are enabled.
+ *
+ * @param      server               Accessory server.
+ * @param      counter              Name of the counter field in HAPAccessoryServerMetrics.
+ * @param      value                Value to add.
+ */
+#define HAPMetricsAddToCounter(server, counter, value) \
+    do { \
+        HAPAccessoryServer* metricsServer_ = (HAPAccessoryServer*) (server); \
+        if (metricsServer_->metrics) { \
+            HAPNonnull(metricsServer_->metrics)->counter += (value); \
+        } \
+    } while (0)
+
+/**
+ * Increments a metrics counter, if metrics are enabled.
+ *
+ * @param      server               Accessory server.
+ * @param      counter              Name of the counter field in HAPAccessoryServerMetrics.
+ */
+#define HAPMetricsIncrementCounter(server, counter) HAPMetricsAddToCounter(server, counter, 1)
+
+/**
+ * Records the latency of an operation into a histogram, if metrics are enabled.
+ *
+ * @param      server               Accessory server.
+ * @param      histogram            Name of the histogram field in HAPAccessoryServerMetrics.
+ * @param      startTime            Start time of the operation, as returned by HAPMetricsGetTime.
+ */
+#define HAPMetricsRecordLatency(server, histogram, startTime) \
+    do { \
+        HAPAccessoryServer* metricsServer_ = (HAPAccessoryServer*) (server); \
+        if (metricsServer_->metrics) { \
+            HAPMetricsHistogramAddSample(&HAPNonnull(metricsServer_->metrics)->histogram, (startTime)); \
+        } \
+    } while (0)
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull end
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -8,18 +8,183 @@
 
 /**
  * BLE: Pair Resume cache entry.
+ *
+ * The cache is organized as follows:
+ * - Session IDs are looked up through an open-addressed hash table with linear probing.
+ *   The table has two slots per entry, so it is never more than half full.
+ *   The slots are co-located in the entries: Slot i is stored in entry i / 2.
+ * - Valid entries are linked into a doubly-linked list in Least Recently Used order.
+ * - Valid entries are linked into per-pairing buckets. The head of bucket i is stored in entry i.
+ * - Free entries are linked into a singly-linked free list. Entries that have never been used are not linked
+ *   but are allocated in order after the free list is exhausted.
+ *
+ * Entries are referenced by their index + 1. 0 indicates no entry, so all-zero storage is an empty cache
+ * when the cache state in the accessory server is also zero.
  */
 typedef struct {
     HAPPairingBLESessionID sessionID;
     uint8_t sharedSecret[X25519_SCALAR_BYTES];
-    int pairingID;
-    uint32_t lastUsed; // 0: invalid, >0: timestamp
+    uint16_t slots[2];      // Co-located hash table slots.
+    uint16_t pairingBucket; // Co-located head of the pairing bucket.
+    uint16_t pairingPrev;
+    uint16_t pairingNext;
+    uint16_t lruPrev; // Towards the most recently used entry.
+    uint16_t lruNext; // Towards the least recently used entry. Next free entry, if the entry is free.
+    int16_t pairingID;
 } HAPPairingBLESessionCacheEntry;
 
 HAP_STATIC_ASSERT(
         sizeof(HAPBLESessionCacheElementRef) >= sizeof(HAPPairingBLESessionCacheEntry),
         HAPPairingBLESessionCacheEntry);
 
+HAP_RESULT_USE_CHECK
+static HAPPairingBLESessionCacheEntry* GetEntry(HAPAccessoryServer* server, uint16_t ref) {
+    HAPPrecondition(server);
+    HAPPrecondition(ref);
+    HAPPrecondition(ref <= server->ble.storage->numSessionCacheElements);
+
+    return (HAPPairingBLESessionCacheEntry*) &server->ble.storage->sessionCacheElements[ref - 1];
+}
+
+HAP_RESULT_USE_CHECK
+static size_t GetNumSlots(const HAPAccessoryServer* server) {
+    HAPPrecondition(server);
+
+    return 2 * server->ble.storage->numSessionCacheElements;
+}
+
+HAP_RESULT_USE_CHECK
+static uint16_t* GetSlot(HAPAccessoryServer* server, size_t slotIndex) {
+    HAPPrecondition(server);
+    HAPPrecondition(slotIndex < GetNumSlots(server));
+
+    HAPPairingBLESessionCacheEntry* entry =
+            (HAPPairingBLESessionCacheEntry*) &server->ble.storage->sessionCacheElements[slotIndex / 2];
+    return &entry->slots[slotIndex % 2];
+}
+
+/**
+ * Returns the home slot of a session ID.
+ *
+ * - Session IDs are derived from the shared secret using HKDF, so their bytes are uniformly distributed.
+ */
+HAP_RESULT_USE_CHECK
+static size_t GetHomeSlotIndex(const HAPAccessoryServer* server, const HAPPairingBLESessionID* sessionID) {
+    HAPPrecondition(server);
+    HAPPrecondition(sessionID);
+
+    return HAPReadLittleUInt32(sessionID->value) % GetNumSlots(server);
+}
+
+/**
+ * Finds the slot that references an entry with a given session ID.
+ *
+ * @param      server               Accessory server.
+ * @param      sessionID            Session ID.
+ * @param[out] slotIndex            Slot index, if found.
+ *
+ * @return true                     If an entry with the session ID was found.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool FindSlot(HAPAccessoryServer* server, const HAPPairingBLESessionID* sessionID, size_t* slotIndex) {
+    HAPPrecondition(server);
+    HAPPrecondition(sessionID);
+    HAPPrecondition(slotIndex);
+
+    // The table is at most half full, so probing always ends at an empty slot.
+    size_t numSlots = GetNumSlots(server);
+    for (size_t i = GetHomeSlotIndex(server, sessionID);; i = (i + 1) % numSlots) {
+        uint16_t ref = *GetSlot(server, i);
+        if (!ref) {
+            return false;
+        }
+        if (HAPRawBufferAreEqual(&GetEntry(server, ref)->sessionID, sessionID, sizeof *sessionID)) {
+            *slotIndex = i;
+            return true;
+        }
+    }
+}
+
+/**
+ * Clears a hash table slot, moving back subsequent entries of the probe sequence so that lookups remain correct.
+ *
+ * @param      server               Accessory server.
+ * @param      slotIndex            Slot index.
+ */
+static void ClearSlot(HAPAccessoryServer* server, size_t slotIndex) {
+    HAPPrecondition(server);
+
+    size_t numSlots = GetNumSlots(server);
+    size_t i = slotIndex;
+    *GetSlot(server, i) = 0;
+    for (size_t j = (i + 1) % numSlots;; j = (j + 1) % numSlots) {
+        uint16_t ref = *GetSlot(server, j);
+        if (!ref) {
+            break;
+        }
+
+        // Entries whose home slot lies cyclically in (i, j] are still reachable.
+        size_t k = GetHomeSlotIndex(server, &GetEntry(server, ref)->sessionID);
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) {
+            continue;
+        }
+        *GetSlot(server, i) = ref;
+        *GetSlot(server, j) = 0;
+        i = j;
+    }
+}
+
+/**
+ * Removes a valid entry from the cache and adds it to the free list.
+ *
+ * @param      server               Accessory server.
+ * @param      ref                  Entry reference.
+ * @param      slotIndex            Slot index of the entry.
+ */
+static void RemoveEntry(HAPAccessoryServer* server, uint16_t ref, size_t slotIndex) {
+    HAPPrecondition(server);
+    HAPPrecondition(*GetSlot(server, slotIndex) == ref);
+
+    HAPPairingBLESessionCacheEntry* entry = GetEntry(server, ref);
+
+    // Remove from hash table.
+    ClearSlot(server, slotIndex);
+
+    // Remove from LRU list.
+    if (entry->lruPrev) {
+        GetEntry(server, entry->lruPrev)->lruNext = entry->lruNext;
+    } else {
+        server->ble.sessionCache.lruHead = entry->lruNext;
+    }
+    if (entry->lruNext) {
+        GetEntry(server, entry->lruNext)->lruPrev = entry->lruPrev;
+    } else {
+        server->ble.sessionCache.lruTail = entry->lruPrev;
+    }
+
+    // Remove from pairing bucket.
+    if (entry->pairingPrev) {
+        GetEntry(server, entry->pairingPrev)->pairingNext = entry->pairingNext;
+    } else {
+        size_t bucket = (size_t) entry->pairingID % server->ble.storage->numSessionCacheElements;
+        GetEntry(server, (uint16_t)(bucket + 1))->pairingBucket = entry->pairingNext;
+    }
+    if (entry->pairingNext) {
+        GetEntry(server, entry->pairingNext)->pairingPrev = entry->pairingPrev;
+    }
+
+    // Add to free list.
+    HAPRawBufferZero(&entry->sessionID, sizeof entry->sessionID);
+    HAPRawBufferZero(entry->sharedSecret, sizeof entry->sharedSecret);
+    entry->pairingID = 0;
+    entry->pairingPrev = 0;
+    entry->pairingNext = 0;
+    entry->lruPrev = 0;
+    entry->lruNext = server->ble.sessionCache.freeHead;
+    server->ble.sessionCache.freeHead = ref;
+}
+
 void HAPPairingBLESessionCacheFetch(
         HAPAccessoryServerRef* server_,
         const HAPPairingBLESessionID* sessionID,
@@ -33,16 +198,14 @@ void HAPPairingBLESessionCacheFetch(
     HAPPrecondition(pairingID);
 
     // Fetch session.
-    for (size_t i = 0; i < server->ble.storage->numSessionCacheElements; i++) {
-        HAPPairingBLESessionCacheEntry* cacheEntry =
-                (HAPPairingBLESessionCacheEntry*) &server->ble.storage->sessionCacheElements[i];
-
-        if (cacheEntry->lastUsed && HAPRawBufferAreEqual(&cacheEntry->sessionID, sessionID, sizeof *sessionID)) {
-            HAPRawBufferCopyBytes(sharedSecret, cacheEntry->sharedSecret, sizeof cacheEntry->sharedSecret);
-            *pairingID = cacheEntry->pairingID;
-            HAPRawBufferZero(cacheEntry, sizeof *cacheEntry);
-            return;
-        }
+    size_t slotIndex;
+    if (FindSlot(server, sessionID, &slotIndex)) {
+        uint16_t ref = *GetSlot(server, slotIndex);
+        HAPPairingBLESessionCacheEntry* cacheEntry = GetEntry(server, ref);
+        HAPRawBufferCopyBytes(sharedSecret, cacheEntry->sharedSecret, sizeof cacheEntry->sharedSecret);
+        *pairingID = cacheEntry->pairingID;
+        RemoveEntry(server, ref, slotIndex);
+        return;
     }
 
     // Not found.
@@ -60,45 +223,67 @@ void HAPPairingBLESessionCacheSave(
     HAPPrecondition(sessionID);
     HAPPrecondition(sharedSecret);
     HAPPrecondition(pairingID >= 0);
+    HAPPrecondition(pairingID <= INT16_MAX);
+
+    size_t numEntries = server->ble.storage->numSessionCacheElements;
+
+    // Replace existing session with the same session ID.
+    size_t slotIndex;
+    if (FindSlot(server, sessionID, &slotIndex)) {
+        RemoveEntry(server, *GetSlot(server, slotIndex), slotIndex);
+    }
 
     // Find free cache entry.
-    size_t index = 0;
-    {
-        // Search least recently used.
-        uint32_t min = UINT32_MAX;
-        for (size_t i = 0; i < server->ble.storage->numSessionCacheElements; i++) {
-            HAPPairingBLESessionCacheEntry* cacheEntry =
-                    (HAPPairingBLESessionCacheEntry*) &server->ble.storage->sessionCacheElements[i];
-
-            if (cacheEntry->lastUsed < min) {
-                min = cacheEntry->lastUsed;
-                index = i;
-            }
-        }
+    uint16_t ref;
+    if (server->ble.sessionCache.freeHead) {
+        ref = server->ble.sessionCache.freeHead;
+    } else if (server->ble.sessionCache.numUsedElements < numEntries) {
+        // Never used entry. Not linked into the free list.
+        ref = ++server->ble.sessionCache.numUsedElements;
+    } else {
+        // Evict least recently used.
+        ref = server->ble.sessionCache.lruTail;
+        HAPAssert(ref);
+        bool found = FindSlot(server, &GetEntry(server, ref)->sessionID, &slotIndex);
+        HAPAssert(found);
+        RemoveEntry(server, ref, slotIndex);
+    }
+    HAPPairingBLESessionCacheEntry* cacheEntry = GetEntry(server, ref);
+    if (ref == server->ble.sessionCache.freeHead) {
+        server->ble.sessionCache.freeHead = cacheEntry->lruNext;
     }
-    HAPPairingBLESessionCacheEntry* cacheEntry =
-            (HAPPairingBLESessionCacheEntry*) &server->ble.storage->sessionCacheElements[index];
 
     // Save session.
     HAPRawBufferCopyBytes(&cacheEntry->sessionID, sessionID, sizeof *sessionID);
     HAPRawBufferCopyBytes(cacheEntry->sharedSecret, sharedSecret, sizeof cacheEntry->sharedSecret);
-    cacheEntry->pairingID = pairingID;
-
-    // Update least recently used.
-    server->ble.sessionCacheTimestamp++;
-    if (server->ble.sessionCacheTimestamp == 0) {
-        // Overflow => reset time stamps.
-        for (size_t i = 0; i < server->ble.storage->numSessionCacheElements; i++) {
-            HAPPairingBLESessionCacheEntry* e =
-                    (HAPPairingBLESessionCacheEntry*) &server->ble.storage->sessionCacheElements[i];
-
-            if (e->lastUsed) {
-                e->lastUsed = 1;
-            }
-        }
-        server->ble.sessionCacheTimestamp = 2;
+    cacheEntry->pairingID = (int16_t) pairingID;
+
+    // Add to hash table.
+    size_t numSlots = GetNumSlots(server);
+    for (slotIndex = GetHomeSlotIndex(server, sessionID); *GetSlot(server, slotIndex);
+         slotIndex = (slotIndex + 1) % numSlots) {
     }
-    cacheEntry->lastUsed = server->ble.sessionCacheTimestamp;
+    *GetSlot(server, slotIndex) = ref;
+
+    // Add to LRU list as most recently used.
+    cacheEntry->lruPrev = 0;
+    cacheEntry->lruNext = server->ble.sessionCache.lruHead;
+    if (cacheEntry->lruNext) {
+        GetEntry(server, cacheEntry->lruNext)->lruPrev = ref;
+    } else {
+        server->ble.sessionCache.lruTail = ref;
+    }
+    server->ble.sessionCache.lruHead = ref;
+
+    // Add to pairing bucket.
+    HAPPairingBLESessionCacheEntry* bucketEntry =
+            GetEntry(server, (uint16_t)((size_t) pairingID % numEntries + 1));
+    cacheEntry->pairingPrev = 0;
+    cacheEntry->pairingNext = bucketEntry->pairingBucket;
+    if (cacheEntry->pairingNext) {
+        GetEntry(server, cacheEntry->pairingNext)->pairingPrev = ref;
+    }
+    bucketEntry->pairingBucket = ref;
 }
 
 void HAPPairingBLESessionCacheInvalidateEntriesForPairing(HAPAccessoryServerRef* server_, int pairingID) {
@@ -107,13 +292,22 @@ void HAPPairingBLESessionCacheInvalidateEntriesForPairing(HAPAccessoryServerRef*
     HAPPrecondition(server->transports.ble);
     HAPPrecondition(pairingID >= 0);
 
-    // Remove sessions for pairing. There may be multiple (e.g. pairing synced to multiple controllers).
-    for (size_t i = 0; i < server->ble.storage->numSessionCacheElements; i++) {
-        HAPPairingBLESessionCacheEntry* cacheEntry =
-                (HAPPairingBLESessionCacheEntry*) &server->ble.storage->sessionCacheElements[i];
+    if (pairingID > INT16_MAX) {
+        return;
+    }
 
+    // Remove sessions for pairing. There may be multiple (e.g. pairing synced to multiple controllers).
+    size_t bucket = (size_t) pairingID % server->ble.storage->numSessionCacheElements;
+    uint16_t ref = GetEntry(server, (uint16_t)(bucket + 1))->pairingBucket;
+    while (ref) {
+        HAPPairingBLESessionCacheEntry* cacheEntry = GetEntry(server, ref);
+        uint16_t nextRef = cacheEntry->pairingNext;
         if (cacheEntry->pairingID == pairingID) {
-            HAPRawBufferZero(cacheEntry, sizeof *cacheEntry);
+            size_t slotIndex;
+            bool found = FindSlot(server, &cacheEntry->sessionID, &slotIndex);
+            HAPAssert(found);
+            RemoveEntry(server, ref, slotIndex);
         }
+        ref = nextRef;
     }
 }
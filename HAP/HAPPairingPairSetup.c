@@ -168,6 +168,7 @@ static HAPError HAPPairingPairSetupGetM2(
     bool found;
     size_t numBytes;
     uint8_t numAuthAttemptsBytes[sizeof(uint8_t)];
+    HAPTime startTime = HAPMetricsGetTime(server_);
     err = HAPPlatformKeyValueStoreGet(
             server->platform.keyValueStore,
             kHAPKeyValueStoreDomain_Configuration,
@@ -176,6 +177,7 @@ static HAPError HAPPairingPairSetupGetM2(
             sizeof numAuthAttemptsBytes,
             &numBytes,
             &found);
+    HAPMetricsRecordLatency(server_, keyValueStoreLatency, startTime);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return err;
@@ -501,6 +503,7 @@ static HAPError HAPPairingPairSetupGetM4(
             bool found;
             size_t numBytes;
             uint8_t numAuthAttemptsBytes[sizeof(uint8_t)];
+            HAPTime startTime = HAPMetricsGetTime(server_);
             err = HAPPlatformKeyValueStoreGet(
                     server->platform.keyValueStore,
                     kHAPKeyValueStoreDomain_Configuration,
@@ -509,6 +512,7 @@ static HAPError HAPPairingPairSetupGetM4(
                     sizeof numAuthAttemptsBytes,
                     &numBytes,
                     &found);
+            HAPMetricsRecordLatency(server_, keyValueStoreLatency, startTime);
             if (err) {
                 HAPAssert(err == kHAPError_Unknown);
                 return err;
@@ -523,12 +527,14 @@ static HAPError HAPPairingPairSetupGetM4(
             HAPAssert(numAuthAttempts < UINT8_MAX);
             numAuthAttempts++;
             numAuthAttemptsBytes[0] = numAuthAttempts;
+            startTime = HAPMetricsGetTime(server_);
             err = HAPPlatformKeyValueStoreSet(
                     server->platform.keyValueStore,
                     kHAPKeyValueStoreDomain_Configuration,
                     kHAPKeyValueStoreKey_Configuration_NumUnsuccessfulAuthAttempts,
                     numAuthAttemptsBytes,
                     sizeof numAuthAttemptsBytes);
+            HAPMetricsRecordLatency(server_, keyValueStoreLatency, startTime);
             if (err) {
                 HAPAssert(err == kHAPError_Unknown);
                 return err;
@@ -541,10 +547,12 @@ static HAPError HAPPairingPairSetupGetM4(
         }
 
         // Reset authentication attempts counter.
+        HAPTime startTime = HAPMetricsGetTime(server_);
         err = HAPPlatformKeyValueStoreRemove(
                 server->platform.keyValueStore,
                 kHAPKeyValueStoreDomain_Configuration,
                 kHAPKeyValueStoreKey_Configuration_NumUnsuccessfulAuthAttempts);
+        HAPMetricsRecordLatency(server_, keyValueStoreLatency, startTime);
         if (err) {
             HAPAssert(err == kHAPError_Unknown);
             return err;
@@ -1016,8 +1024,10 @@ static HAPError HAPPairingPairSetupProcessM5(
     HAPAssert(sizeof pairing.publicKey.value == 32);
     HAPRawBufferCopyBytes(&pairingBytes[37], pairing.publicKey.value, 32);
     pairingBytes[69] = pairing.permissions;
+    HAPTime startTime = HAPMetricsGetTime(server_);
     err = HAPPlatformKeyValueStoreSet(
             server->platform.keyValueStore, kHAPKeyValueStoreDomain_Pairings, 0, pairingBytes, sizeof pairingBytes);
+    HAPMetricsRecordLatency(server_, keyValueStoreLatency, startTime);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return err;
@@ -1278,6 +1288,8 @@ HAPError HAPPairingPairSetupHandleWrite(
     HAPTLVReaderGetScratchBytes(requestReader, &bytes, &maxBytes);
 
     // Process request.
+    HAPTime startTime = HAPMetricsGetTime(server_);
+    HAPTraceBegin(kHAPTraceEvent_PairSetupWrite, session->state.pairSetup.state, 0);
     switch (session->state.pairSetup.state) {
         case 0: {
             session->state.pairSetup.state++;
@@ -1289,6 +1301,7 @@ HAPError HAPPairingPairSetupHandleWrite(
             if (err) {
                 HAPAssert(err == kHAPError_InvalidData);
             }
+            HAPMetricsRecordLatency(server_, pairSetup[0], startTime);
         } break;
         case 2: {
             session->state.pairSetup.state++;
@@ -1300,6 +1313,7 @@ HAPError HAPPairingPairSetupHandleWrite(
             if (err) {
                 HAPAssert(err == kHAPError_InvalidData);
             }
+            HAPMetricsRecordLatency(server_, pairSetup[2], startTime);
         } break;
         case 4: {
             session->state.pairSetup.state++;
@@ -1313,12 +1327,14 @@ HAPError HAPPairingPairSetupHandleWrite(
             if (err) {
                 HAPAssert(err == kHAPError_InvalidData || err == kHAPError_OutOfResources);
             }
+            HAPMetricsRecordLatency(server_, pairSetup[4], startTime);
         } break;
         default: {
             HAPLog(&logObject, "Received unexpected Pair Setup write in state M%u.", session->state.pairSetup.state);
             err = kHAPError_InvalidState;
         } break;
     }
+    HAPTraceEnd(kHAPTraceEvent_PairSetupWrite, session->state.pairSetup.state, err);
     if (err) {
         HAPPairingPairSetupResetForSession(server_, session_);
         return err;
@@ -1403,6 +1419,8 @@ HAPError HAPPairingPairSetupHandleRead(
     }
 
     // Process request.
+    HAPTime startTime = HAPMetricsGetTime(server);
+    HAPTraceBegin(kHAPTraceEvent_PairSetupRead, session->state.pairSetup.state, 0);
     switch (session->state.pairSetup.state) {
         case 1: {
             session->state.pairSetup.state++;
@@ -1410,6 +1428,7 @@ HAPError HAPPairingPairSetupHandleRead(
             if (err) {
                 HAPAssert(err == kHAPError_Unknown || err == kHAPError_OutOfResources);
             }
+            HAPMetricsRecordLatency(server, pairSetup[1], startTime);
         } break;
         case 3: {
             session->state.pairSetup.state++;
@@ -1417,6 +1436,7 @@ HAPError HAPPairingPairSetupHandleRead(
             if (err) {
                 HAPAssert(err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources);
             }
+            HAPMetricsRecordLatency(server, pairSetup[3], startTime);
         } break;
         case 5: {
             session->state.pairSetup.state++;
@@ -1424,12 +1444,14 @@ HAPError HAPPairingPairSetupHandleRead(
             if (err) {
                 HAPAssert(err == kHAPError_OutOfResources);
             }
+            HAPMetricsRecordLatency(server, pairSetup[5], startTime);
         } break;
         default: {
             HAPLog(&logObject, "Received unexpected Pair Setup read in state M%u.", session->state.pairSetup.state);
             err = kHAPError_InvalidState;
         } break;
     }
+    HAPTraceEnd(kHAPTraceEvent_PairSetupRead, session->state.pairSetup.state, err);
     if (err) {
         HAPPairingPairSetupResetForSession(server, session_);
         return err;
@@ -833,7 +833,9 @@ static HAPError HAPPairingPairVerifyProcessM3(
     pairing.numIdentifierBytes = (uint8_t) identifierTLV.value.numBytes;
     HAPPlatformKeyValueStoreKey key;
     bool found;
+    HAPTime startTime = HAPMetricsGetTime(server_);
     err = HAPPairingFind(server->platform.keyValueStore, &pairing, &key, &found);
+    HAPMetricsRecordLatency(server_, keyValueStoreLatency, startTime);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return err;
@@ -1012,6 +1014,8 @@ HAPError HAPPairingPairVerifyHandleWrite(
     }
 
     // Process request.
+    HAPTime startTime = HAPMetricsGetTime(server);
+    HAPTraceBegin(kHAPTraceEvent_PairVerifyWrite, session->state.pairVerify.state, 0);
     switch (session->state.pairVerify.state) {
         case 0: {
             session->state.pairVerify.state++;
@@ -1028,6 +1032,7 @@ HAPError HAPPairingPairVerifyHandleWrite(
             if (err) {
                 HAPAssert(err == kHAPError_InvalidData || err == kHAPError_OutOfResources);
             }
+            HAPMetricsRecordLatency(server, pairVerify[0], startTime);
         } break;
         case 2: {
             session->state.pairVerify.state++;
@@ -1041,12 +1046,14 @@ HAPError HAPPairingPairVerifyHandleWrite(
             if (err) {
                 HAPAssert(err == kHAPError_InvalidData || err == kHAPError_OutOfResources);
             }
+            HAPMetricsRecordLatency(server, pairVerify[2], startTime);
         } break;
         default: {
             HAPLog(&logObject, "Received unexpected Pair Verify write in state M%d.", session->state.pairVerify.state);
             err = kHAPError_InvalidState;
         } break;
     }
+    HAPTraceEnd(kHAPTraceEvent_PairVerifyWrite, session->state.pairVerify.state, err);
     if (err) {
         HAPPairingPairVerifyReset(session_);
         return err;
@@ -1131,6 +1138,8 @@ HAPError HAPPairingPairVerifyHandleRead(
     }
 
     // Process request.
+    HAPTime startTime = HAPMetricsGetTime(server);
+    HAPTraceBegin(kHAPTraceEvent_PairVerifyRead, session->state.pairVerify.state, 0);
     switch (session->state.pairVerify.state) {
         case 1: {
             session->state.pairVerify.state++;
@@ -1145,6 +1154,7 @@ HAPError HAPPairingPairVerifyHandleRead(
                     HAPAssert(err == kHAPError_OutOfResources);
                 }
             }
+            HAPMetricsRecordLatency(server, pairVerify[1], startTime);
         } break;
         case 3: {
             session->state.pairVerify.state++;
@@ -1152,12 +1162,14 @@ HAPError HAPPairingPairVerifyHandleRead(
             if (err) {
                 HAPAssert(err == kHAPError_OutOfResources);
             }
+            HAPMetricsRecordLatency(server, pairVerify[3], startTime);
         } break;
         default: {
             HAPLog(&logObject, "Received unexpected Pair Verify read in state M%u.", session->state.pairVerify.state);
             err = kHAPError_InvalidState;
         } break;
     }
+    HAPTraceEnd(kHAPTraceEvent_PairVerifyRead, session->state.pairVerify.state, err);
     if (err) {
         HAPPairingPairVerifyReset(session_);
         return err;
@@ -157,7 +157,9 @@ static HAPError HAPPairingPairingsAddPairingProcessM1(
     pairing.numIdentifierBytes = (uint8_t) tlvs->identifierTLV->value.numBytes;
     HAPPlatformKeyValueStoreKey key;
     bool found;
+    HAPTime startTime = HAPMetricsGetTime(server_);
     err = HAPPairingFind(server->platform.keyValueStore, &pairing, &key, &found);
+    HAPMetricsRecordLatency(server_, keyValueStoreLatency, startTime);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return err;
@@ -188,12 +190,14 @@ static HAPError HAPPairingPairingsAddPairingProcessM1(
         HAPAssert(sizeof pairing.publicKey.value == 32);
         HAPRawBufferCopyBytes(&pairingBytes[37], pairing.publicKey.value, 32);
         pairingBytes[69] = pairing.permissions;
+        startTime = HAPMetricsGetTime(server_);
         err = HAPPlatformKeyValueStoreSet(
                 server->platform.keyValueStore,
                 kHAPKeyValueStoreDomain_Pairings,
                 key,
                 pairingBytes,
                 sizeof pairingBytes);
+        HAPMetricsRecordLatency(server_, keyValueStoreLatency, startTime);
         if (err) {
             HAPAssert(err == kHAPError_Unknown);
             return err;
@@ -213,6 +217,7 @@ static HAPError HAPPairingPairingsAddPairingProcessM1(
             size_t numBytes;
             uint8_t pairingBytes
                     [sizeof(HAPPairingID) + sizeof(uint8_t) + sizeof(HAPPairingPublicKey) + sizeof(uint8_t)];
+            startTime = HAPMetricsGetTime(server_);
             err = HAPPlatformKeyValueStoreGet(
                     server->platform.keyValueStore,
                     kHAPKeyValueStoreDomain_Pairings,
@@ -221,6 +226,7 @@ static HAPError HAPPairingPairingsAddPairingProcessM1(
                     sizeof pairingBytes,
                     &numBytes,
                     &found);
+            HAPMetricsRecordLatency(server_, keyValueStoreLatency, startTime);
             if (err) {
                 HAPAssert(err == kHAPError_Unknown);
                 return err;
@@ -263,12 +269,14 @@ static HAPError HAPPairingPairingsAddPairingProcessM1(
         HAPAssert(sizeof pairing.publicKey.value == 32);
         HAPRawBufferCopyBytes(&pairingBytes[37], pairing.publicKey.value, 32);
         pairingBytes[69] = pairing.permissions;
+        startTime = HAPMetricsGetTime(server_);
         err = HAPPlatformKeyValueStoreSet(
                 server->platform.keyValueStore,
                 kHAPKeyValueStoreDomain_Pairings,
                 key,
                 pairingBytes,
                 sizeof pairingBytes);
+        HAPMetricsRecordLatency(server_, keyValueStoreLatency, startTime);
         if (err) {
             HAPAssert(err == kHAPError_Unknown);
             HAPLog(&logObject, "Add Pairing M1: Failed to add pairing.");
@@ -472,7 +480,9 @@ static HAPError HAPPairingPairingsRemovePairingGetM2(
     pairing.numIdentifierBytes = (uint8_t) session->state.pairings.removedPairingIDLength;
     HAPPlatformKeyValueStoreKey key;
     bool found;
+    HAPTime startTime = HAPMetricsGetTime(server_);
     err = HAPPairingFind(server->platform.keyValueStore, &pairing, &key, &found);
+    HAPMetricsRecordLatency(server_, keyValueStoreLatency, startTime);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return err;
@@ -483,7 +493,9 @@ static HAPError HAPPairingPairingsRemovePairingGetM2(
     // accessory must return success.
     if (found) {
         // Remove the pairing.
+        startTime = HAPMetricsGetTime(server_);
         err = HAPPlatformKeyValueStoreRemove(server->platform.keyValueStore, kHAPKeyValueStoreDomain_Pairings, key);
+        HAPMetricsRecordLatency(server_, keyValueStoreLatency, startTime);
         if (err) {
             HAPAssert(err == kHAPError_Unknown);
             HAPLog(&logObject, "Remove Pairing M2: Failed to remove pairing.");
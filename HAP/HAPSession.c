@@ -146,6 +146,7 @@ bool HAPSessionIsSecured(const HAPSessionRef* session_) {
     bool found;
     size_t numBytes;
     uint8_t pairingBytes[sizeof(HAPPairingID) + sizeof(uint8_t) + sizeof(HAPPairingPublicKey) + sizeof(uint8_t)];
+    HAPTime startTime = HAPMetricsGetTime(HAPNonnull(session->server));
     err = HAPPlatformKeyValueStoreGet(
             server->platform.keyValueStore,
             kHAPKeyValueStoreDomain_Pairings,
@@ -154,6 +155,7 @@ bool HAPSessionIsSecured(const HAPSessionRef* session_) {
             sizeof pairingBytes,
             &numBytes,
             &found);
+    HAPMetricsRecordLatency(session->server, keyValueStoreLatency, startTime);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return false;
@@ -206,6 +208,7 @@ bool HAPSessionControllerIsAdmin(const HAPSessionRef* session_) {
     bool found;
     size_t numBytes;
     uint8_t pairingBytes[sizeof(HAPPairingID) + sizeof(uint8_t) + sizeof(HAPPairingPublicKey) + sizeof(uint8_t)];
+    HAPTime startTime = HAPMetricsGetTime(HAPNonnull(session->server));
     err = HAPPlatformKeyValueStoreGet(
             server->platform.keyValueStore,
             kHAPKeyValueStoreDomain_Pairings,
@@ -214,6 +217,7 @@ bool HAPSessionControllerIsAdmin(const HAPSessionRef* session_) {
             sizeof pairingBytes,
             &numBytes,
             &found);
+    HAPMetricsRecordLatency(session->server, keyValueStoreLatency, startTime);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return false;
@@ -436,6 +436,21 @@ static void copy_and_free_if_overlapping(uint8_t** tmp, uint8_t** out, size_t n)
     }
 }
 
+/**
+ * Expands a nonce to the 96-bit nonce length of the IETF ChaCha20-Poly1305 construction.
+ *
+ * - Shorter nonces are padded with leading zeros. OpenSSL 1.1 does this implicitly for shorter IV lengths,
+ *   but OpenSSL 3.0 only accepts the full nonce length.
+ */
+static void expand_chacha20_poly1305_nonce(
+        uint8_t nonce[CHACHA20_POLY1305_NONCE_BYTES_MAX],
+        const uint8_t* n,
+        size_t n_len) {
+    HAPPrecondition(n_len <= CHACHA20_POLY1305_NONCE_BYTES_MAX);
+    memset(nonce, 0, CHACHA20_POLY1305_NONCE_BYTES_MAX - n_len);
+    memcpy(&nonce[CHACHA20_POLY1305_NONCE_BYTES_MAX - n_len], n, n_len);
+}
+
 void HAP_chacha20_poly1305_init(
         HAP_chacha20_poly1305_ctx* ctx,
         const uint8_t* n HAP_UNUSED,
@@ -461,9 +476,11 @@ void HAP_chacha20_poly1305_update_enc(
         HAPAssert(ret == 1);
         ret = EVP_CIPHER_CTX_ctrl(handle->ctx, EVP_CTRL_AEAD_SET_TAG, CHACHA20_POLY1305_TAG_BYTES, NULL);
         HAPAssert(ret == 1);
-        ret = EVP_CIPHER_CTX_ctrl(handle->ctx, EVP_CTRL_AEAD_SET_IVLEN, n_len, NULL);
+        uint8_t nonce[CHACHA20_POLY1305_NONCE_BYTES_MAX];
+        expand_chacha20_poly1305_nonce(nonce, n, n_len);
+        ret = EVP_CIPHER_CTX_ctrl(handle->ctx, EVP_CTRL_AEAD_SET_IVLEN, sizeof nonce, NULL);
         HAPAssert(ret == 1);
-        ret = EVP_EncryptInit_ex(handle->ctx, NULL, NULL, k, n);
+        ret = EVP_EncryptInit_ex(handle->ctx, NULL, NULL, k, nonce);
         HAPAssert(ret == 1);
     }
     if (m_len > 0) {
@@ -514,9 +531,11 @@ void HAP_chacha20_poly1305_update_dec(
         handle->ctx = EVP_CIPHER_CTX_new();
         int ret = EVP_DecryptInit_ex(handle->ctx, EVP_chacha20_poly1305(), 0, 0, 0);
         HAPAssert(ret == 1);
-        ret = EVP_CIPHER_CTX_ctrl(handle->ctx, EVP_CTRL_AEAD_SET_IVLEN, n_len, NULL);
+        uint8_t nonce[CHACHA20_POLY1305_NONCE_BYTES_MAX];
+        expand_chacha20_poly1305_nonce(nonce, n, n_len);
+        ret = EVP_CIPHER_CTX_ctrl(handle->ctx, EVP_CTRL_AEAD_SET_IVLEN, sizeof nonce, NULL);
         HAPAssert(ret == 1);
-        ret = EVP_DecryptInit_ex(handle->ctx, NULL, NULL, k, n);
+        ret = EVP_DecryptInit_ex(handle->ctx, NULL, NULL, k, nonce);
         HAPAssert(ret == 1);
     }
     if (c_len > 0) {
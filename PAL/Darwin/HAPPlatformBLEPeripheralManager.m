@@ -623,6 +623,66 @@ void HAPPlatformBLEPeripheralManagerPublishServices(HAPPlatformBLEPeripheralMana
     [peripheral publishServices];
 }
 
+HAP_RESULT_USE_CHECK
+HAPError HAPPlatformBLEPeripheralManagerPublishDatabase(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        const HAPPlatformBLEPeripheralManagerDatabaseFingerprint* fingerprint,
+        bool isUnchanged HAP_UNUSED,
+        HAPPlatformBLEPeripheralManagerGATTAttribute* attributes,
+        size_t numAttributes) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(fingerprint);
+    HAPPrecondition(attributes);
+
+    HAPLog(&logObject, __func__);
+
+    // CoreBluetooth assigns attribute handles when services are added, so the GATT database is always rebuilt.
+    HAPPlatformBLEPeripheralManagerRemoveAllServices(blePeripheralManager);
+    for (size_t i = 0; i < numAttributes; i++) {
+        HAPPlatformBLEPeripheralManagerGATTAttribute* attribute = &attributes[i];
+
+        HAPError err;
+        switch (attribute->kind) {
+            case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Service: {
+                err = HAPPlatformBLEPeripheralManagerAddService(
+                        blePeripheralManager, &attribute->type, attribute->_.service.isPrimary);
+            } break;
+            case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Characteristic: {
+                HAPPlatformBLEPeripheralManagerCharacteristicProperties properties =
+                        attribute->_.characteristic.properties;
+                err = HAPPlatformBLEPeripheralManagerAddCharacteristic(
+                        blePeripheralManager,
+                        &attribute->type,
+                        properties,
+                        attribute->hasConstValue ? attribute->constBytes : NULL,
+                        attribute->numConstBytes,
+                        &attribute->_.characteristic.valueHandle,
+                        properties.notify || properties.indicate ? &attribute->_.characteristic.cccDescriptorHandle :
+                                                                    NULL);
+            } break;
+            case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Descriptor: {
+                err = HAPPlatformBLEPeripheralManagerAddDescriptor(
+                        blePeripheralManager,
+                        &attribute->type,
+                        attribute->_.descriptor.properties,
+                        attribute->hasConstValue ? attribute->constBytes : NULL,
+                        attribute->numConstBytes,
+                        &attribute->_.descriptor.descriptorHandle);
+            } break;
+            default: {
+                HAPFatalError();
+            }
+        }
+        if (err) {
+            HAPAssert(err == kHAPError_OutOfResources);
+            return err;
+        }
+    }
+    HAPPlatformBLEPeripheralManagerPublishServices(blePeripheralManager);
+
+    return kHAPError_None;
+}
+
 void HAPPlatformBLEPeripheralManagerStartAdvertising(
         HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
         HAPBLEAdvertisingInterval advertisingInterval,
@@ -75,7 +75,8 @@ HAP_ENUM_BEGIN(uint8_t, HAPError) {
     kHAPError_InvalidData,    /**< Data has unexpected format. */
     kHAPError_OutOfResources, /**< Out of resources. */
     kHAPError_NotAuthorized,  /**< Insufficient authorization. */
-    kHAPError_Busy            /**< Operation failed temporarily, retry later. */
+    kHAPError_Busy,           /**< Operation failed temporarily, retry later. */
+    kHAPError_InProgress      /**< Operation has been started and will be completed asynchronously. */
 } HAP_ENUM_END(uint8_t, HAPError);
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1451,6 +1452,7 @@ void HAPSHA1Checksum(uint8_t checksum[_Nonnull kHAPSHA1Checksum_NumBytes], const
 
 #include "HAPAssert.h"
 #include "HAPLog.h"
+#include "HAPTrace.h"
 
 // Functions to convert a _Nullable type to its _Nonnull variant.
 #if __has_feature(nullability) && __has_attribute(overloadable)
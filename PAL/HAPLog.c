@@ -16,6 +16,473 @@ const HAPLogObject kHAPLog_Default = { .subsystem = NULL, .category = NULL };
  */
 #define kHAPLogMessage_MaxBytes ((size_t)(2 * 1024))
 
+#if HAP_LOG_CACHE_ENABLED_TYPES
+/**
+ * Number of entries of the enabled log types cache. Must be a power of two.
+ */
+#define kHAPLogEnabledTypesCache_NumEntries ((size_t) 32)
+
+/**
+ * Cache of the enabled log types per log object.
+ *
+ * - Each entry packs the address of a log object with its HAPPlatformLogEnabledTypes into a single word,
+ *   so that entries can be read and written atomically without locking. Log objects are at least 4-byte aligned.
+ */
+static uintptr_t enabledTypesCache[kHAPLogEnabledTypesCache_NumEntries];
+HAP_STATIC_ASSERT(kHAPPlatformLogEnabledTypes_None == 0, kHAPPlatformLogEnabledTypes_None_IsZero);
+HAP_STATIC_ASSERT(kHAPPlatformLogEnabledTypes_Debug <= 3, kHAPPlatformLogEnabledTypes_FitTwoBits);
+#endif
+HAP_STATIC_ASSERT(sizeof(double) == sizeof(uint64_t), double_FitsDeferredArgument);
+
+HAP_RESULT_USE_CHECK
+bool HAPLogIsTypeEnabled(const HAPLogObject* _Nullable log, HAPLogType type) {
+    if (!log) {
+        return false;
+    }
+
+#if HAP_LOG_CACHE_ENABLED_TYPES
+    uintptr_t key = (uintptr_t) log;
+    HAPAssert(!(key & 3));
+    size_t i = ((key >> 3) ^ (key >> 9)) & (kHAPLogEnabledTypesCache_NumEntries - 1);
+    uintptr_t entry = __atomic_load_n(&enabledTypesCache[i], __ATOMIC_RELAXED);
+    HAPPlatformLogEnabledTypes enabledTypes;
+    if ((entry & ~(uintptr_t) 3) == key) {
+        enabledTypes = (HAPPlatformLogEnabledTypes)(entry & 3);
+    } else {
+        enabledTypes = HAPPlatformLogGetEnabledTypes(log);
+        __atomic_store_n(&enabledTypesCache[i], key | (uintptr_t) enabledTypes, __ATOMIC_RELAXED);
+    }
+#else
+    HAPPlatformLogEnabledTypes enabledTypes = HAPPlatformLogGetEnabledTypes(log);
+#endif
+
+    switch (enabledTypes) {
+        case kHAPPlatformLogEnabledTypes_None: {
+            return false;
+        }
+        case kHAPPlatformLogEnabledTypes_Default: {
+            return type != kHAPLogType_Info && type != kHAPLogType_Debug;
+        }
+        case kHAPPlatformLogEnabledTypes_Info: {
+            return type != kHAPLogType_Debug;
+        }
+        case kHAPPlatformLogEnabledTypes_Debug: {
+            return true;
+        }
+    }
+    HAPFatalError();
+}
+
+void HAPLogInvalidateEnabledTypes(void) {
+#if HAP_LOG_CACHE_ENABLED_TYPES
+    for (size_t i = 0; i < kHAPLogEnabledTypesCache_NumEntries; i++) {
+        __atomic_store_n(&enabledTypesCache[i], 0, __ATOMIC_RELAXED);
+    }
+#endif
+}
+
+/**
+ * Parsed conversion specification of a format string.
+ */
+typedef struct {
+    /** Conversion specification, including the leading '%'. NULL-terminated. */
+    char specification[16];
+
+    /** Length modifier. 0: none, 1: 'l', 2: 'll', 3: 'z'. */
+    uint8_t length;
+
+    /** Conversion specifier. */
+    char specifier;
+} ConversionSpecification;
+
+/**
+ * Parses a conversion specification of a format string.
+ *
+ * - The same syntax as in HAPStringWithFormatAndArguments is accepted.
+ *
+ * @param      format               Format string, starting at the '%' of the conversion specification.
+ * @param[out] conversion           Parsed conversion specification.
+ *
+ * @return Length of the conversion specification in the format string.
+ */
+HAP_RESULT_USE_CHECK
+static size_t ParseConversionSpecification(const char* format, ConversionSpecification* conversion) {
+    HAPPrecondition(format[0] == '%');
+    HAPPrecondition(conversion);
+
+    size_t i = 1;
+    while (format[i] == '0' || format[i] == '+' || format[i] == ' ') {
+        i++;
+    }
+    while (format[i] >= '0' && format[i] <= '9') {
+        i++;
+    }
+    conversion->length = 0;
+    if (format[i] == 'l') {
+        conversion->length = 1;
+        i++;
+        if (format[i] == 'l') {
+            conversion->length = 2;
+            i++;
+        }
+    } else if (format[i] == 'z') {
+        conversion->length = 3;
+        i++;
+    }
+    conversion->specifier = format[i];
+    if (format[i]) {
+        i++;
+    }
+    HAPPrecondition(i < sizeof conversion->specification);
+    HAPRawBufferCopyBytes(conversion->specification, format, i);
+    conversion->specification[i] = '\0';
+    return i;
+}
+
+HAP_PRINTFLIKE(2, 0)
+HAP_RESULT_USE_CHECK
+HAPError HAPLogDeferredMessageCreate(HAPLogDeferredMessage* message, const char* format, va_list arguments) {
+    HAPPrecondition(message);
+    HAPPrecondition(format);
+
+    message->format = format;
+    size_t numArguments = 0;
+    size_t numStringBytes = 0;
+    for (size_t i = 0; format[i];) {
+        if (format[i] != '%') {
+            i++;
+            continue;
+        }
+        ConversionSpecification conversion;
+        i += ParseConversionSpecification(&format[i], &conversion);
+        if (conversion.specifier == '%') {
+            continue;
+        }
+        if (numArguments == kHAPLogDeferredMessage_MaxArguments) {
+            return kHAPError_OutOfResources;
+        }
+        uint64_t* argument = &message->arguments[numArguments++];
+        switch (conversion.specifier) {
+            case 'd':
+            case 'i': {
+                if (conversion.length == 0) {
+                    *argument = (uint64_t)(int64_t) va_arg(arguments, int);
+                } else if (conversion.length == 1) {
+                    *argument = (uint64_t)(int64_t) va_arg(arguments, long);
+                } else if (conversion.length == 2) {
+                    *argument = (uint64_t)(int64_t) va_arg(arguments, long long);
+                } else {
+                    *argument = (uint64_t) va_arg(arguments, size_t);
+                }
+            } break;
+            case 'x':
+            case 'X':
+            case 'u': {
+                if (conversion.length == 0) {
+                    *argument = (uint64_t) va_arg(arguments, unsigned int);
+                } else if (conversion.length == 1) {
+                    *argument = (uint64_t) va_arg(arguments, unsigned long);
+                } else if (conversion.length == 2) {
+                    *argument = (uint64_t) va_arg(arguments, unsigned long long);
+                } else {
+                    *argument = (uint64_t) va_arg(arguments, size_t);
+                }
+            } break;
+            case 'p': {
+                *argument = (uint64_t)(uintptr_t) va_arg(arguments, void*);
+            } break;
+            case 's': {
+                const char* _Nullable string = va_arg(arguments, const char*);
+                if (!string) {
+                    string = "(null)";
+                }
+                size_t numBytes = HAPStringGetNumBytes(string) + 1;
+                if (numBytes > sizeof message->stringBytes - numStringBytes) {
+                    return kHAPError_OutOfResources;
+                }
+                HAPRawBufferCopyBytes(&message->stringBytes[numStringBytes], string, numBytes);
+                *argument = numStringBytes;
+                numStringBytes += numBytes;
+            } break;
+            case 'c': {
+                *argument = (uint64_t) va_arg(arguments, int);
+            } break;
+            case 'g': {
+                double value = va_arg(arguments, double);
+                HAPRawBufferCopyBytes(argument, &value, sizeof value);
+            } break;
+            default: {
+                HAPLogError(&kHAPLog_Default, "Unsupported format string type specifier: %%%c", conversion.specifier);
+                HAPPreconditionFailure();
+            }
+        }
+    }
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPLogDeferredMessageGetDescription(const HAPLogDeferredMessage* message, char* bytes, size_t maxBytes) {
+    HAPPrecondition(message);
+    HAPPrecondition(message->format);
+    HAPPrecondition(bytes);
+
+    HAPError err;
+
+    const char* format = message->format;
+    size_t numArguments = 0;
+    size_t n = 0;
+    for (size_t i = 0; format[i];) {
+        if (format[i] != '%') {
+            if (n + 1 >= maxBytes) {
+                return kHAPError_OutOfResources;
+            }
+            bytes[n++] = format[i++];
+            continue;
+        }
+
+        // Format each conversion with the original specification so that the result matches HAPStringWithFormat.
+        ConversionSpecification conversion;
+        i += ParseConversionSpecification(&format[i], &conversion);
+        if (n >= maxBytes) {
+            return kHAPError_OutOfResources;
+        }
+        if (conversion.specifier == '%') {
+            err = HAPStringWithFormat(&bytes[n], maxBytes - n, "%%");
+        } else {
+            HAPAssert(numArguments < kHAPLogDeferredMessage_MaxArguments);
+            uint64_t argument = message->arguments[numArguments++];
+            HAP_DIAGNOSTIC_PUSH
+            HAP_DIAGNOSTIC_IGNORED_CLANG("-Wformat-nonliteral")
+            HAP_DIAGNOSTIC_IGNORED_GCC("-Wformat-nonliteral")
+            switch (conversion.specifier) {
+                case 'd':
+                case 'i': {
+                    if (conversion.length == 0) {
+                        err = HAPStringWithFormat(
+                                &bytes[n], maxBytes - n, conversion.specification, (int) (int64_t) argument);
+                    } else if (conversion.length == 1) {
+                        err = HAPStringWithFormat(
+                                &bytes[n], maxBytes - n, conversion.specification, (long) (int64_t) argument);
+                    } else if (conversion.length == 2) {
+                        err = HAPStringWithFormat(
+                                &bytes[n], maxBytes - n, conversion.specification, (long long) (int64_t) argument);
+                    } else {
+                        err = HAPStringWithFormat(&bytes[n], maxBytes - n, conversion.specification, (size_t) argument);
+                    }
+                } break;
+                case 'x':
+                case 'X':
+                case 'u': {
+                    if (conversion.length == 0) {
+                        err = HAPStringWithFormat(
+                                &bytes[n], maxBytes - n, conversion.specification, (unsigned int) argument);
+                    } else if (conversion.length == 1) {
+                        err = HAPStringWithFormat(
+                                &bytes[n], maxBytes - n, conversion.specification, (unsigned long) argument);
+                    } else if (conversion.length == 2) {
+                        err = HAPStringWithFormat(
+                                &bytes[n], maxBytes - n, conversion.specification, (unsigned long long) argument);
+                    } else {
+                        err = HAPStringWithFormat(&bytes[n], maxBytes - n, conversion.specification, (size_t) argument);
+                    }
+                } break;
+                case 'p': {
+                    err = HAPStringWithFormat(
+                            &bytes[n], maxBytes - n, conversion.specification, (void*) (uintptr_t) argument);
+                } break;
+                case 's': {
+                    HAPAssert(argument < sizeof message->stringBytes);
+                    err = HAPStringWithFormat(
+                            &bytes[n], maxBytes - n, conversion.specification, &message->stringBytes[argument]);
+                } break;
+                case 'c': {
+                    err = HAPStringWithFormat(&bytes[n], maxBytes - n, conversion.specification, (int) argument);
+                } break;
+                case 'g': {
+                    double value;
+                    HAPRawBufferCopyBytes(&value, &argument, sizeof value);
+                    err = HAPStringWithFormat(&bytes[n], maxBytes - n, conversion.specification, value);
+                } break;
+                default: {
+                    HAPFatalError();
+                }
+            }
+            HAP_DIAGNOSTIC_POP
+        }
+        if (err) {
+            HAPAssert(err == kHAPError_OutOfResources);
+            return err;
+        }
+        n += HAPStringGetNumBytes(&bytes[n]);
+    }
+    if (n >= maxBytes) {
+        return kHAPError_OutOfResources;
+    }
+    bytes[n] = '\0';
+    return kHAPError_None;
+}
+
+#if HAP_LOG_DEFERRED
+/**
+ * Maximum number of buffer bytes that are kept with a deferred log.
+ */
+#define kHAPLogDeferred_MaxBufferBytes ((size_t) 64)
+
+/**
+ * Deferred log.
+ */
+typedef struct {
+    /** Sequence number + 1 once the log has been fully recorded. */
+    uint32_t sequenceNumber;
+
+    /** Log object. */
+    const HAPLogObject* _Nullable log;
+
+    /** Log type. */
+    HAPLogType type;
+
+    /** Unformatted log message. */
+    HAPLogDeferredMessage message;
+
+    /** Whether a buffer has been logged. */
+    bool hasBuffer;
+
+    /** Length of the logged buffer. */
+    size_t numBufferBytes;
+
+    /** Start of the logged buffer. */
+    uint8_t bufferBytes[kHAPLogDeferred_MaxBufferBytes];
+} HAPLogDeferredRecord;
+
+/**
+ * Deferred logs.
+ */
+static struct {
+    /** Records. */
+    HAPLogDeferredRecord records[HAP_LOG_DEFERRED_NUM_RECORDS];
+
+    /** Total number of records that have been claimed. */
+    uint32_t numRecords;
+
+    /** Number of records that have been flushed. */
+    uint32_t numFlushedRecords;
+} deferredLogs;
+
+/**
+ * Claims the next deferred log record.
+ *
+ * @return Sequence number of the claimed record.
+ */
+HAP_RESULT_USE_CHECK
+static uint32_t ClaimDeferredRecord(void) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_fetch_add(&deferredLogs.numRecords, 1, __ATOMIC_RELAXED);
+#else
+    return deferredLogs.numRecords++;
+#endif
+}
+
+/**
+ * Records a log without formatting it.
+ *
+ * @param      log                  Log object.
+ * @param      bytes                Buffer, if any.
+ * @param      numBytes             Length of buffer.
+ * @param      type                 Log type.
+ * @param      format               Format string.
+ * @param      args                 Arguments.
+ *
+ * @return true                     If the log has been deferred.
+ * @return false                    If the log needs to be emitted immediately.
+ */
+HAP_PRINTFLIKE(5, 0)
+HAP_RESULT_USE_CHECK
+static bool DeferLog(
+        const HAPLogObject* log,
+        const void* _Nullable bytes,
+        size_t numBytes,
+        HAPLogType type,
+        const char* format,
+        va_list args) {
+    HAPError err;
+
+    if (type != kHAPLogType_Debug && type != kHAPLogType_Info) {
+        return false;
+    }
+
+    HAPLogDeferredMessage message;
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    err = HAPLogDeferredMessageCreate(&message, format, argsCopy);
+    va_end(argsCopy);
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        return false;
+    }
+
+    uint32_t sequenceNumber = ClaimDeferredRecord();
+    HAPLogDeferredRecord* record = &deferredLogs.records[sequenceNumber & (HAP_LOG_DEFERRED_NUM_RECORDS - 1)];
+    record->sequenceNumber = 0;
+    record->log = log;
+    record->type = type;
+    HAPRawBufferCopyBytes(&record->message, &message, sizeof message);
+    record->hasBuffer = bytes != NULL;
+    record->numBufferBytes = numBytes;
+    if (bytes) {
+        HAPRawBufferCopyBytes(record->bufferBytes, HAPNonnullVoid(bytes), HAPMin(numBytes, sizeof record->bufferBytes));
+    }
+    record->sequenceNumber = sequenceNumber + 1;
+    return true;
+}
+#endif
+
+void HAPLogFlushDeferred(void) {
+#if HAP_LOG_DEFERRED
+    HAPError err;
+
+    uint32_t numRecords = deferredLogs.numRecords;
+    uint32_t sequenceNumber = deferredLogs.numFlushedRecords;
+    if (numRecords - sequenceNumber > HAP_LOG_DEFERRED_NUM_RECORDS) {
+        sequenceNumber = numRecords - HAP_LOG_DEFERRED_NUM_RECORDS;
+    }
+    deferredLogs.numFlushedRecords = numRecords;
+
+    for (; sequenceNumber != numRecords; sequenceNumber++) {
+        const HAPLogDeferredRecord* record =
+                &deferredLogs.records[sequenceNumber & (HAP_LOG_DEFERRED_NUM_RECORDS - 1)];
+        if (record->sequenceNumber != sequenceNumber + 1 || !record->log) {
+            // Overwritten or not yet fully recorded.
+            continue;
+        }
+
+        char message[kHAPLogMessage_MaxBytes];
+        err = HAPLogDeferredMessageGetDescription(&record->message, message, sizeof message);
+        if (err) {
+            HAPPlatformLogCapture(HAPNonnull(record->log), kHAPLogType_Error, "<Log message too long>", NULL, 0);
+            continue;
+        }
+        if (record->numBufferBytes > sizeof record->bufferBytes) {
+            size_t numMessageBytes = HAPStringGetNumBytes(message);
+            err = HAPStringWithFormat(
+                    &message[numMessageBytes],
+                    sizeof message - numMessageBytes,
+                    " (first %zu of %zu bytes)",
+                    sizeof record->bufferBytes,
+                    record->numBufferBytes);
+            if (err) {
+                HAPAssert(err == kHAPError_OutOfResources);
+            }
+        }
+        HAPPlatformLogCapture(
+                HAPNonnull(record->log),
+                record->type,
+                message,
+                record->hasBuffer ? record->bufferBytes : NULL,
+                HAPMin(record->numBufferBytes, sizeof record->bufferBytes));
+    }
+#endif
+}
+
 HAP_PRINTFLIKE(5, 0)
 static void
         Capture(const HAPLogObject* _Nullable const log,
@@ -31,24 +498,19 @@ static void
     }
 
     // Check if logs are enabled.
-    HAPPlatformLogEnabledTypes enabledTypes = HAPPlatformLogGetEnabledTypes(log);
-    switch (enabledTypes) {
-        case kHAPPlatformLogEnabledTypes_None: {
-            return;
-        }
-        case kHAPPlatformLogEnabledTypes_Default: {
-            if (type == kHAPLogType_Info || type == kHAPLogType_Debug) {
-                return;
-            }
-        } break;
-        case kHAPPlatformLogEnabledTypes_Info: {
-            if (type == kHAPLogType_Debug) {
-                return;
-            }
-        } break;
-        case kHAPPlatformLogEnabledTypes_Debug: {
-        } break;
+    if (!HAPLogIsTypeEnabled(log, type)) {
+        return;
+    }
+
+#if HAP_LOG_DEFERRED
+    if (DeferLog(log, bytes, numBytes, type, format, args)) {
+        return;
+    }
+    if (type == kHAPLogType_Error || type == kHAPLogType_Fault) {
+        // Emit the context of the error first.
+        HAPLogFlushDeferred();
     }
+#endif
 
     // Format log message.
     char message[kHAPLogMessage_MaxBytes];
@@ -37,6 +37,36 @@ extern "C" {
 #error "Invalid HAP_LOG_SENSITIVE."
 #endif
 
+// Validate flag for deferred logging.
+// 0 - Logs are formatted when they are logged. Default.
+// 1 - Info and Debug logs are recorded unformatted and only formatted and emitted when HAPLogFlushDeferred is called
+//     or when an Error or Fault log is emitted. Log format strings must be string literals.
+#ifndef HAP_LOG_DEFERRED
+#define HAP_LOG_DEFERRED (0)
+#endif
+#if HAP_LOG_DEFERRED < 0 || HAP_LOG_DEFERRED > 1
+#error "Invalid HAP_LOG_DEFERRED."
+#endif
+
+// Validate flag for caching the enabled log types.
+// 0 - HAPPlatformLogGetEnabledTypes is queried for every log. Default.
+// 1 - The enabled log types are cached per log object. HAPLogInvalidateEnabledTypes must be called whenever the
+//     enabled log types reported by HAPPlatformLogGetEnabledTypes change. Requires __atomic builtins (GCC / Clang).
+#ifndef HAP_LOG_CACHE_ENABLED_TYPES
+#define HAP_LOG_CACHE_ENABLED_TYPES (0)
+#endif
+#if HAP_LOG_CACHE_ENABLED_TYPES < 0 || HAP_LOG_CACHE_ENABLED_TYPES > 1
+#error "Invalid HAP_LOG_CACHE_ENABLED_TYPES."
+#endif
+
+// Number of logs that are kept when deferred logging is enabled. Must be a power of two.
+#ifndef HAP_LOG_DEFERRED_NUM_RECORDS
+#define HAP_LOG_DEFERRED_NUM_RECORDS (32)
+#endif
+#if HAP_LOG_DEFERRED_NUM_RECORDS <= 0 || (HAP_LOG_DEFERRED_NUM_RECORDS & (HAP_LOG_DEFERRED_NUM_RECORDS - 1))
+#error "Invalid HAP_LOG_DEFERRED_NUM_RECORDS."
+#endif
+
 /**
  * Log object.
  */
@@ -92,6 +122,96 @@ HAP_ENUM_BEGIN(uint8_t, HAPLogType) {
     kHAPLogType_Fault
 } HAP_ENUM_END(uint8_t, HAPLogType);
 
+/**
+ * Returns whether logs of a given type are enabled for a log object.
+ *
+ * - The log macros perform this check before their arguments are evaluated.
+ *   It may also be used to skip expensive preparation of log arguments.
+ *
+ * - If HAP_LOG_CACHE_ENABLED_TYPES is set, the enabled log types reported by HAPPlatformLogGetEnabledTypes are
+ *   cached per log object. HAPLogInvalidateEnabledTypes must then be called when they change.
+ *
+ * @param      log                  Log object.
+ * @param      type                 Log type.
+ *
+ * @return true                     If logs of the given type are enabled.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+bool HAPLogIsTypeEnabled(const HAPLogObject* _Nullable log, HAPLogType type);
+
+/**
+ * Discards the cached enabled log types of all log objects.
+ *
+ * - Must be called when the enabled log types reported by HAPPlatformLogGetEnabledTypes change.
+ *   Has no effect unless HAP_LOG_CACHE_ENABLED_TYPES is set.
+ *
+ * - May be called from any thread.
+ */
+void HAPLogInvalidateEnabledTypes(void);
+
+/**
+ * Formats and emits all logs that have been deferred, oldest first.
+ *
+ * - Has no effect unless HAP_LOG_DEFERRED is set.
+ */
+void HAPLogFlushDeferred(void);
+
+/**
+ * Maximum number of arguments of a deferred log message.
+ */
+#define kHAPLogDeferredMessage_MaxArguments ((size_t) 12)
+
+/**
+ * Maximum number of bytes of string arguments of a deferred log message, including NULL terminators.
+ */
+#define kHAPLogDeferredMessage_MaxStringBytes ((size_t) 192)
+
+/**
+ * Unformatted log message.
+ */
+typedef struct {
+    /** Format string. Must outlive the message. */
+    const char* _Nullable format;
+
+    /** Arguments. Strings are stored as offsets into stringBytes. Doubles are stored bitwise. */
+    uint64_t arguments[kHAPLogDeferredMessage_MaxArguments];
+
+    /** Copies of string arguments. */
+    char stringBytes[kHAPLogDeferredMessage_MaxStringBytes];
+} HAPLogDeferredMessage;
+
+/**
+ * Records a format string and its arguments without formatting them.
+ *
+ * - Only the conversions that are supported by HAPStringWithFormat may be used.
+ *
+ * @param[out] message              Unformatted log message.
+ * @param      format               Format string. Must outlive the message.
+ * @param      arguments            Arguments.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If there are too many arguments or the strings are too long.
+ */
+HAP_PRINTFLIKE(2, 0)
+HAP_RESULT_USE_CHECK
+HAPError HAPLogDeferredMessageCreate(HAPLogDeferredMessage* message, const char* format, va_list arguments);
+
+/**
+ * Formats a log message that has been recorded with HAPLogDeferredMessageCreate.
+ *
+ * - The result is identical to formatting the original format string and arguments with HAPStringWithFormat.
+ *
+ * @param      message              Unformatted log message.
+ * @param[out] bytes                Buffer to fill with the formatted message. Will be NULL-terminated.
+ * @param      maxBytes             Capacity of buffer.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If the buffer is not large enough.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPLogDeferredMessageGetDescription(const HAPLogDeferredMessage* message, char* bytes, size_t maxBytes);
+
 /**
  * Logs the contents of a buffer and a message at a specific logging level.
  *
@@ -130,7 +250,7 @@ HAP_ENUM_BEGIN(uint8_t, HAPLogType) {
  */
 #define HAPLogBuffer(log, bytes, numBytes, ...) \
     do { \
-        if (HAP_LOG_LEVEL >= 1) { \
+        if (HAP_LOG_LEVEL >= 1 && HAPLogIsTypeEnabled(log, kHAPLogType_Default)) { \
             HAPLogBufferInternal(log, bytes, numBytes, __VA_ARGS__); \
         } \
     } while (0)
@@ -144,7 +264,7 @@ HAP_ENUM_BEGIN(uint8_t, HAPLogType) {
  */
 #define HAPLogBufferInfo(log, bytes, numBytes, ...) \
     do { \
-        if (HAP_LOG_LEVEL >= 2) { \
+        if (HAP_LOG_LEVEL >= 2 && HAPLogIsTypeEnabled(log, kHAPLogType_Info)) { \
             HAPLogBufferInfoInternal(log, bytes, numBytes, __VA_ARGS__); \
         } \
     } while (0)
@@ -158,7 +278,7 @@ HAP_ENUM_BEGIN(uint8_t, HAPLogType) {
  */
 #define HAPLogBufferDebug(log, bytes, numBytes, ...) \
     do { \
-        if (HAP_LOG_LEVEL >= 3) { \
+        if (HAP_LOG_LEVEL >= 3 && HAPLogIsTypeEnabled(log, kHAPLogType_Debug)) { \
             HAPLogBufferDebugInternal(log, bytes, numBytes, __VA_ARGS__); \
         } \
     } while (0)
@@ -172,7 +292,7 @@ HAP_ENUM_BEGIN(uint8_t, HAPLogType) {
  */
 #define HAPLogBufferError(log, bytes, numBytes, ...) \
     do { \
-        if (HAP_LOG_LEVEL >= 1) { \
+        if (HAP_LOG_LEVEL >= 1 && HAPLogIsTypeEnabled(log, kHAPLogType_Error)) { \
             HAPLogBufferErrorInternal(log, bytes, numBytes, __VA_ARGS__); \
         } \
     } while (0)
@@ -186,7 +306,7 @@ HAP_ENUM_BEGIN(uint8_t, HAPLogType) {
  */
 #define HAPLogBufferFault(log, bytes, numBytes, ...) \
     do { \
-        if (HAP_LOG_LEVEL >= 1) { \
+        if (HAP_LOG_LEVEL >= 1 && HAPLogIsTypeEnabled(log, kHAPLogType_Fault)) { \
             HAPLogBufferFaultInternal(log, bytes, numBytes, __VA_ARGS__); \
         } \
     } while (0)
@@ -225,7 +345,7 @@ HAP_ENUM_BEGIN(uint8_t, HAPLogType) {
  */
 #define HAPLog(log, ...) \
     do { \
-        if (HAP_LOG_LEVEL >= 1) { \
+        if (HAP_LOG_LEVEL >= 1 && HAPLogIsTypeEnabled(log, kHAPLogType_Default)) { \
             HAPLogInternal(log, __VA_ARGS__); \
         } \
     } while (0)
@@ -237,7 +357,7 @@ HAP_ENUM_BEGIN(uint8_t, HAPLogType) {
  */
 #define HAPLogInfo(log, ...) \
     do { \
-        if (HAP_LOG_LEVEL >= 2) { \
+        if (HAP_LOG_LEVEL >= 2 && HAPLogIsTypeEnabled(log, kHAPLogType_Info)) { \
             HAPLogInfoInternal(log, __VA_ARGS__); \
         } \
     } while (0)
@@ -249,7 +369,7 @@ HAP_ENUM_BEGIN(uint8_t, HAPLogType) {
  */
 #define HAPLogDebug(log, ...) \
     do { \
-        if (HAP_LOG_LEVEL >= 3) { \
+        if (HAP_LOG_LEVEL >= 3 && HAPLogIsTypeEnabled(log, kHAPLogType_Debug)) { \
             HAPLogDebugInternal(log, __VA_ARGS__); \
         } \
     } while (0)
@@ -261,7 +381,7 @@ HAP_ENUM_BEGIN(uint8_t, HAPLogType) {
  */
 #define HAPLogError(log, ...) \
     do { \
-        if (HAP_LOG_LEVEL >= 1) { \
+        if (HAP_LOG_LEVEL >= 1 && HAPLogIsTypeEnabled(log, kHAPLogType_Error)) { \
             HAPLogErrorInternal(log, __VA_ARGS__); \
         } \
     } while (0)
@@ -273,7 +393,7 @@ HAP_ENUM_BEGIN(uint8_t, HAPLogType) {
  */
 #define HAPLogFault(log, ...) \
     do { \
-        if (HAP_LOG_LEVEL >= 1) { \
+        if (HAP_LOG_LEVEL >= 1 && HAPLogIsTypeEnabled(log, kHAPLogType_Fault)) { \
             HAPLogFaultInternal(log, __VA_ARGS__); \
         } \
     } while (0)
@@ -348,6 +348,124 @@ HAPError HAPPlatformBLEPeripheralManagerAddDescriptor(
  */
 void HAPPlatformBLEPeripheralManagerPublishServices(HAPPlatformBLEPeripheralManagerRef blePeripheralManager);
 
+/**
+ * GATT database fingerprint.
+ *
+ * - Identifies the layout of a GATT database, i.e., the kinds, types, properties and constant values
+ *   of its attributes in order. GATT databases with the same fingerprint are assigned the same attribute handles.
+ */
+typedef struct {
+    uint8_t bytes[16]; /**< Opaque. */
+} HAPPlatformBLEPeripheralManagerDatabaseFingerprint;
+HAP_STATIC_ASSERT(
+        sizeof(HAPPlatformBLEPeripheralManagerDatabaseFingerprint) == 16,
+        HAPPlatformBLEPeripheralManagerDatabaseFingerprint);
+
+/**
+ * Kind of a GATT attribute.
+ */
+HAP_ENUM_BEGIN(uint8_t, HAPPlatformBLEPeripheralManagerGATTAttributeKind) {
+    /** Service. */
+    kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Service = 1,
+
+    /** Characteristic. It is associated with the most recent service. */
+    kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Characteristic,
+
+    /** Descriptor. It is associated with the most recent characteristic. */
+    kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Descriptor
+} HAP_ENUM_END(uint8_t, HAPPlatformBLEPeripheralManagerGATTAttributeKind);
+
+/**
+ * Maximum length of the constant value of a GATT attribute.
+ */
+#define kHAPPlatformBLEPeripheralManagerGATTAttribute_MaxConstBytes ((size_t) 8)
+
+/**
+ * GATT attribute of a GATT database that is published in a single call.
+ */
+typedef struct {
+    /** Kind of the attribute. */
+    HAPPlatformBLEPeripheralManagerGATTAttributeKind kind;
+
+    /** The Bluetooth-specific 128-bit UUID that identifies the attribute. */
+    HAPPlatformBLEPeripheralManagerUUID type;
+
+    /** Kind-specific parameters. */
+    union {
+        /** Service. */
+        struct {
+            /** Whether the type of service is primary or secondary. */
+            bool isPrimary;
+        } service;
+
+        /** Characteristic. */
+        struct {
+            /** The properties of the characteristic. */
+            HAPPlatformBLEPeripheralManagerCharacteristicProperties properties;
+
+            /** Attribute handle of the Characteristic Value declaration. Filled in when published. */
+            HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle;
+
+            /**
+             * Attribute handle of the Client Characteristic Configuration descriptor. Filled in when published.
+             * 0 if neither notify nor indicate properties are set.
+             */
+            HAPPlatformBLEPeripheralManagerAttributeHandle cccDescriptorHandle;
+        } characteristic;
+
+        /** Descriptor. */
+        struct {
+            /** The properties of the descriptor. */
+            HAPPlatformBLEPeripheralManagerDescriptorProperties properties;
+
+            /** Attribute handle of the descriptor. Filled in when published. */
+            HAPPlatformBLEPeripheralManagerAttributeHandle descriptorHandle;
+        } descriptor;
+    } _;
+
+    /** Value of a characteristic or descriptor if constant. */
+    uint8_t constBytes[kHAPPlatformBLEPeripheralManagerGATTAttribute_MaxConstBytes];
+
+    /** Length of the constant value. */
+    uint8_t numConstBytes;
+
+    /** Whether or not the value of a characteristic or descriptor is constant. */
+    bool hasConstValue;
+} HAPPlatformBLEPeripheralManagerGATTAttribute;
+
+/**
+ * Publishes a complete GATT database in a single call.
+ *
+ * - This is equivalent to HAPPlatformBLEPeripheralManagerRemoveAllServices, followed by the corresponding
+ *   AddService, AddCharacteristic and AddDescriptor call for each attribute in order, followed by
+ *   HAPPlatformBLEPeripheralManagerPublishServices. It may be called whether or not services are published.
+ *
+ * - The attribute handles of the characteristics and descriptors are filled in.
+ *
+ * - If the published GATT database has the same fingerprint, it may be kept instead of being rebuilt.
+ *   The attribute handles that were assigned when it was published must be reported in that case.
+ *
+ * - isUnchanged is set if the fingerprint matches the one of the GATT database that was published before the
+ *   accessory server was last started, possibly before a reboot. BLE stacks that retain their GATT database
+ *   in persistent memory may use it to skip registration.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      fingerprint          Fingerprint of the GATT database.
+ * @param      isUnchanged          Whether the fingerprint matches the one that was published before the last start.
+ * @param      attributes           GATT attributes, starting with a service.
+ * @param      numAttributes        Number of GATT attributes.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If there are not enough resources to publish the GATT database.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPPlatformBLEPeripheralManagerPublishDatabase(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        const HAPPlatformBLEPeripheralManagerDatabaseFingerprint* fingerprint,
+        bool isUnchanged,
+        HAPPlatformBLEPeripheralManagerGATTAttribute* attributes,
+        size_t numAttributes);
+
 /**
  * Advertises BLE peripheral manager data or updates advertised data.
  *
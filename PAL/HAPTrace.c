@@ -0,0 +1,153 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAPPlatform.h"
+
+#if HAP_TRACE
+/**
+ * Trace ring buffer.
+ */
+static struct {
+    /** Records. */
+    HAPTraceRecord records[HAP_TRACE_NUM_RECORDS];
+
+    /** Total number of records that have been claimed since the last reset. */
+    uint32_t numRecords;
+} trace;
+
+/**
+ * Claims the next record of the trace ring buffer.
+ *
+ * @return Sequence number of the claimed record.
+ */
+HAP_RESULT_USE_CHECK
+static uint32_t ClaimRecord(void) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_fetch_add(&trace.numRecords, 1, __ATOMIC_RELAXED);
+#else
+    return trace.numRecords++;
+#endif
+}
+#endif
+
+void HAPTraceRecordEvent(HAPTraceEvent event, HAPTracePhase phase, uint32_t arg0, uint32_t arg1) {
+#if HAP_TRACE
+    uint32_t sequenceNumber = ClaimRecord();
+    HAPTraceRecord* record = &trace.records[sequenceNumber & (HAP_TRACE_NUM_RECORDS - 1)];
+    record->timestamp = HAPPlatformClockGetCurrent();
+    record->sequenceNumber = sequenceNumber;
+    record->event = event;
+    record->phase = phase;
+    record->args[0] = arg0;
+    record->args[1] = arg1;
+#else
+    (void) event;
+    (void) phase;
+    (void) arg0;
+    (void) arg1;
+#endif
+}
+
+void HAPTraceReset(void) {
+#if HAP_TRACE
+    HAPRawBufferZero(&trace, sizeof trace);
+#endif
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPTraceSerialize(void* bytes_, size_t maxBytes, size_t* numBytes) {
+    HAPPrecondition(bytes_);
+    uint8_t* bytes = bytes_;
+    HAPPrecondition(numBytes);
+
+    uint32_t numRecords = 0;
+#if HAP_TRACE
+    uint32_t totalRecords = trace.numRecords;
+    numRecords = HAPMin(totalRecords, (uint32_t) HAP_TRACE_NUM_RECORDS);
+#endif
+
+    if (maxBytes < kHAPTrace_NumHeaderBytes + numRecords * kHAPTrace_NumRecordBytes) {
+        return kHAPError_OutOfResources;
+    }
+
+    HAPRawBufferCopyBytes(&bytes[0], "HAPTRACE", 8);
+    HAPWriteLittleUInt32(&bytes[8], kHAPTrace_Version);
+    HAPWriteLittleUInt32(&bytes[12], numRecords);
+    *numBytes = kHAPTrace_NumHeaderBytes;
+
+#if HAP_TRACE
+    // Records that are claimed concurrently may not be fully written yet and are serialized as is.
+    for (uint32_t i = 0; i < numRecords; i++) {
+        const HAPTraceRecord* record = &trace.records[(totalRecords - numRecords + i) & (HAP_TRACE_NUM_RECORDS - 1)];
+        uint8_t* recordBytes = &bytes[*numBytes];
+        HAPWriteLittleUInt64(&recordBytes[0], record->timestamp);
+        HAPWriteLittleUInt32(&recordBytes[8], record->sequenceNumber);
+        HAPWriteLittleUInt16(&recordBytes[12], record->event);
+        recordBytes[14] = record->phase;
+        recordBytes[15] = 0;
+        HAPWriteLittleUInt32(&recordBytes[16], record->args[0]);
+        HAPWriteLittleUInt32(&recordBytes[20], record->args[1]);
+        *numBytes += kHAPTrace_NumRecordBytes;
+    }
+#endif
+
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+const char* _Nullable HAPTraceEventGetName(HAPTraceEvent event) {
+    switch (event) {
+        case kHAPTraceEvent_RunLoopTimer: {
+            return "RunLoopTimer";
+        }
+        case kHAPTraceEvent_RunLoopFileHandle: {
+            return "RunLoopFileHandle";
+        }
+        case kHAPTraceEvent_RunLoopCallback: {
+            return "RunLoopCallback";
+        }
+        case kHAPTraceEvent_TCPStreamEvent: {
+            return "TCPStreamEvent";
+        }
+        case kHAPTraceEvent_HTTPRequest: {
+            return "HTTPRequest";
+        }
+        case kHAPTraceEvent_Encrypt: {
+            return "Encrypt";
+        }
+        case kHAPTraceEvent_Decrypt: {
+            return "Decrypt";
+        }
+        case kHAPTraceEvent_PairSetupWrite: {
+            return "PairSetupWrite";
+        }
+        case kHAPTraceEvent_PairSetupRead: {
+            return "PairSetupRead";
+        }
+        case kHAPTraceEvent_PairVerifyWrite: {
+            return "PairVerifyWrite";
+        }
+        case kHAPTraceEvent_PairVerifyRead: {
+            return "PairVerifyRead";
+        }
+        case kHAPTraceEvent_KeyValueStoreGet: {
+            return "KeyValueStoreGet";
+        }
+        case kHAPTraceEvent_KeyValueStoreSet: {
+            return "KeyValueStoreSet";
+        }
+        case kHAPTraceEvent_KeyValueStoreRemove: {
+            return "KeyValueStoreRemove";
+        }
+        case kHAPTraceEvent_KeyValueStoreEnumerate: {
+            return "KeyValueStoreEnumerate";
+        }
+        case kHAPTraceEvent_KeyValueStorePurgeDomain: {
+            return "KeyValueStorePurgeDomain";
+        }
+    }
+    return NULL;
+}
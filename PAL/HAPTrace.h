@@ -0,0 +1,245 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#ifndef HAP_TRACE_H
+#define HAP_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "HAPBase.h"
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull begin
+#endif
+
+// Validate flag for tracing.
+// 0 - Trace points are compiled out. Default.
+// 1 - Trace points record into the trace ring buffer.
+#ifndef HAP_TRACE
+#define HAP_TRACE (0)
+#endif
+#if HAP_TRACE < 0 || HAP_TRACE > 1
+#error "Invalid HAP_TRACE."
+#endif
+
+// Number of records in the trace ring buffer. Must be a power of two.
+#ifndef HAP_TRACE_NUM_RECORDS
+#define HAP_TRACE_NUM_RECORDS (512)
+#endif
+#if HAP_TRACE_NUM_RECORDS <= 0 || (HAP_TRACE_NUM_RECORDS & (HAP_TRACE_NUM_RECORDS - 1))
+#error "Invalid HAP_TRACE_NUM_RECORDS."
+#endif
+
+/**
+ * Trace event.
+ */
+HAP_ENUM_BEGIN(uint8_t, HAPTraceEvent) {
+    /** HAPPlatformRunLoop timer callback. arg0: Timer. */
+    kHAPTraceEvent_RunLoopTimer = 1,
+
+    /** HAPPlatformRunLoop file handle callback. arg0: File descriptor. */
+    kHAPTraceEvent_RunLoopFileHandle,
+
+    /** HAPPlatformRunLoop scheduled callback. arg0: Context size. */
+    kHAPTraceEvent_RunLoopCallback,
+
+    /** IP TCP stream event. arg0: IP session. arg1: Event flags. */
+    kHAPTraceEvent_TCPStreamEvent,
+
+    /** IP HTTP request. arg0: IP session. arg1: URI length. */
+    kHAPTraceEvent_HTTPRequest,
+
+    /** IP security protocol encryption. arg0: Number of plaintext bytes. */
+    kHAPTraceEvent_Encrypt,
+
+    /** IP security protocol decryption. arg0: Number of available bytes. arg1 (End): Number of decrypted bytes. */
+    kHAPTraceEvent_Decrypt,
+
+    /** Pair Setup write. arg0: State. arg1 (End): Error. */
+    kHAPTraceEvent_PairSetupWrite,
+
+    /** Pair Setup read. arg0: State. arg1 (End): Error. */
+    kHAPTraceEvent_PairSetupRead,
+
+    /** Pair Verify write. arg0: State. arg1 (End): Error. */
+    kHAPTraceEvent_PairVerifyWrite,
+
+    /** Pair Verify read. arg0: State. arg1 (End): Error. */
+    kHAPTraceEvent_PairVerifyRead,
+
+    /** Key-value store get. arg0: Domain. arg1: Key. */
+    kHAPTraceEvent_KeyValueStoreGet,
+
+    /** Key-value store set. arg0: Domain. arg1: Key. */
+    kHAPTraceEvent_KeyValueStoreSet,
+
+    /** Key-value store remove. arg0: Domain. arg1: Key. */
+    kHAPTraceEvent_KeyValueStoreRemove,
+
+    /** Key-value store enumeration. arg0: Domain. */
+    kHAPTraceEvent_KeyValueStoreEnumerate,
+
+    /** Key-value store domain purge. arg0: Domain. */
+    kHAPTraceEvent_KeyValueStorePurgeDomain
+} HAP_ENUM_END(uint8_t, HAPTraceEvent);
+
+/**
+ * Trace event phase.
+ */
+HAP_ENUM_BEGIN(uint8_t, HAPTracePhase) {
+    /** Start of a duration. */
+    kHAPTracePhase_Begin = 1,
+
+    /** End of a duration. */
+    kHAPTracePhase_End,
+
+    /** Instant event. */
+    kHAPTracePhase_Instant
+} HAP_ENUM_END(uint8_t, HAPTracePhase);
+
+/**
+ * Trace record.
+ */
+typedef struct {
+    /** Time at which the record has been created. */
+    HAPTime timestamp;
+
+    /** Sequence number. Orders records that have been created within the same millisecond. */
+    uint32_t sequenceNumber;
+
+    /** Event. */
+    HAPTraceEvent event;
+
+    /** Phase. */
+    HAPTracePhase phase;
+
+    /** Event specific arguments. */
+    uint32_t args[2];
+} HAPTraceRecord;
+
+/**
+ * Number of bytes of the serialized trace header.
+ *
+ * - 8 bytes magic "HAPTRACE", 4 bytes version, 4 bytes number of records (little endian).
+ */
+#define kHAPTrace_NumHeaderBytes ((size_t) 16)
+
+/**
+ * Number of bytes of a serialized trace record.
+ *
+ * - 8 bytes timestamp, 4 bytes sequence number, 2 bytes event, 1 byte phase, 1 reserved byte,
+ *   2 x 4 bytes arguments (little endian).
+ */
+#define kHAPTrace_NumRecordBytes ((size_t) 24)
+
+/**
+ * Serialization format version.
+ */
+#define kHAPTrace_Version ((uint32_t) 1)
+
+/**
+ * Maximum number of bytes of a serialized trace.
+ */
+#define kHAPTrace_MaxBytes (kHAPTrace_NumHeaderBytes + (size_t) HAP_TRACE_NUM_RECORDS * kHAPTrace_NumRecordBytes)
+
+/**
+ * Appends a record to the trace ring buffer. The oldest record is overwritten when the ring buffer is full.
+ *
+ * - Use the HAPTraceBegin, HAPTraceEnd and HAPTraceInstant macros instead so that trace points are compiled out
+ *   unless HAP_TRACE is set.
+ *
+ * - May be called from any thread. Records are claimed without locking.
+ *
+ * @param      event                Event.
+ * @param      phase                Phase.
+ * @param      arg0                 First event specific argument.
+ * @param      arg1                 Second event specific argument.
+ */
+void HAPTraceRecordEvent(HAPTraceEvent event, HAPTracePhase phase, uint32_t arg0, uint32_t arg1);
+
+/**
+ * Discards all records of the trace ring buffer.
+ */
+void HAPTraceReset(void);
+
+/**
+ * Serializes the records of the trace ring buffer, oldest record first.
+ *
+ * - The serialized trace can be converted to Chrome trace JSON with the TraceDump tool.
+ *
+ * @param[out] bytes                Buffer to serialize into.
+ * @param      maxBytes             Capacity of buffer. kHAPTrace_MaxBytes are always sufficient.
+ * @param[out] numBytes             Number of serialized bytes.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If the buffer is not large enough to hold all records.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPTraceSerialize(void* bytes, size_t maxBytes, size_t* numBytes);
+
+/**
+ * Gets the name of a trace event.
+ *
+ * @param      event                Event.
+ *
+ * @return Name of the event, or NULL if the event is unknown.
+ */
+HAP_RESULT_USE_CHECK
+const char* _Nullable HAPTraceEventGetName(HAPTraceEvent event);
+
+/**
+ * Records the start of a duration.
+ *
+ * @param      event                Event.
+ * @param      arg0                 First event specific argument.
+ * @param      arg1                 Second event specific argument.
+ */
+#define HAPTraceBegin(event, arg0, arg1) \
+    do { \
+        if (HAP_TRACE) { \
+            HAPTraceRecordEvent((event), kHAPTracePhase_Begin, (uint32_t)(arg0), (uint32_t)(arg1)); \
+        } \
+    } while (0)
+
+/**
+ * Records the end of a duration.
+ *
+ * @param      event                Event.
+ * @param      arg0                 First event specific argument.
+ * @param      arg1                 Second event specific argument.
+ */
+#define HAPTraceEnd(event, arg0, arg1) \
+    do { \
+        if (HAP_TRACE) { \
+            HAPTraceRecordEvent((event), kHAPTracePhase_End, (uint32_t)(arg0), (uint32_t)(arg1)); \
+        } \
+    } while (0)
+
+/**
+ * Records an instant event.
+ *
+ * @param      event                Event.
+ * @param      arg0                 First event specific argument.
+ * @param      arg1                 Second event specific argument.
+ */
+#define HAPTraceInstant(event, arg0, arg1) \
+    do { \
+        if (HAP_TRACE) { \
+            HAPTraceRecordEvent((event), kHAPTracePhase_Instant, (uint32_t)(arg0), (uint32_t)(arg1)); \
+        } \
+    } while (0)
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull end
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -79,9 +79,19 @@ struct HAPPlatformBLEPeripheralManager {
     uint8_t scanResponseBytes[31];
     uint8_t numScanResponseBytes;
     HAPBLEAdvertisingInterval advertisingInterval;
+    size_t numAdvertisingStarts;
+
+    HAPPlatformBLEPeripheralManagerDatabaseFingerprint databaseFingerprint;
+    size_t numDatabaseRegistrations;
+
+    struct {
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle;
+        HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle;
+    } pendingIndication;
 
     bool isDeviceAddressSet : 1;
     bool didPublishAttributes : 1;
+    bool hasDatabaseFingerprint : 1;
     bool isConnected : 1;
     /**@endcond */
 };
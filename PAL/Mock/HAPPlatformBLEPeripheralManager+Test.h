@@ -28,6 +28,31 @@ extern "C" {
 HAP_RESULT_USE_CHECK
 bool HAPPlatformBLEPeripheralManagerIsAdvertising(HAPPlatformBLEPeripheralManagerRef blePeripheralManager);
 
+/**
+ * Returns how many times advertising has been started.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ *
+ * @return Number of HAPPlatformBLEPeripheralManagerStartAdvertising calls.
+ */
+HAP_RESULT_USE_CHECK
+size_t HAPPlatformBLEPeripheralManagerGetNumAdvertisingStarts(HAPPlatformBLEPeripheralManagerRef blePeripheralManager);
+
+/**
+ * Returns how many times a GATT database has been built.
+ *
+ * - GATT databases that are kept by HAPPlatformBLEPeripheralManagerPublishDatabase because their fingerprint
+ *   is unchanged are not counted.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ *
+ * @return Number of HAPPlatformBLEPeripheralManagerPublishServices calls and rebuilds of the GATT database
+ *         by HAPPlatformBLEPeripheralManagerPublishDatabase.
+ */
+HAP_RESULT_USE_CHECK
+size_t HAPPlatformBLEPeripheralManagerGetNumDatabaseRegistrations(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager);
+
 /**
  * Returns the Bluetooth device address (BD_ADDR) that is currently being advertised.
  *
@@ -66,6 +91,32 @@ HAPError HAPPlatformBLEPeripheralManagerGetAdvertisingData(
         size_t maxScanResponseBytes,
         size_t* numScanResponseBytes);
 
+/**
+ * Gets the Handle Value Indication that is awaiting confirmation by the central.
+ *
+ * - Only one Handle Value Indication may await confirmation at a time. Further Handle Value Indications are
+ *   rejected with kHAPError_InvalidState until HAPPlatformBLEPeripheralManagerConfirmHandleValueIndication is called.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param[out] valueHandle          Attribute handle of the indicated Characteristic Value declaration.
+ *
+ * @return true                     If a Handle Value Indication is awaiting confirmation.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+bool HAPPlatformBLEPeripheralManagerGetPendingHandleValueIndication(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerAttributeHandle* valueHandle);
+
+/**
+ * Confirms the Handle Value Indication that is awaiting confirmation by the central.
+ *
+ * - The delegate is informed that further Handle Value Indications may be sent.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ */
+void HAPPlatformBLEPeripheralManagerConfirmHandleValueIndication(HAPPlatformBLEPeripheralManagerRef blePeripheralManager);
+
 #if __has_feature(nullability)
 #pragma clang assume_nonnull end
 #endif
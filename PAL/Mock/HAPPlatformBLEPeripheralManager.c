@@ -70,6 +70,7 @@ void HAPPlatformBLEPeripheralManagerRemoveAllServices(
             blePeripheralManager->attributes,
             blePeripheralManager->numAttributes * sizeof blePeripheralManager->attributes[0]);
     blePeripheralManager->didPublishAttributes = false;
+    blePeripheralManager->hasDatabaseFingerprint = false;
 }
 
 HAP_RESULT_USE_CHECK
@@ -305,6 +306,142 @@ void HAPPlatformBLEPeripheralManagerPublishServices(HAPPlatformBLEPeripheralMana
     HAPPrecondition(!blePeripheralManager->didPublishAttributes);
 
     blePeripheralManager->didPublishAttributes = true;
+    blePeripheralManager->numDatabaseRegistrations++;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPPlatformBLEPeripheralManagerPublishDatabase(
+        HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager,
+        const HAPPlatformBLEPeripheralManagerDatabaseFingerprint* _Nonnull fingerprint,
+        bool isUnchanged HAP_UNUSED,
+        HAPPlatformBLEPeripheralManagerGATTAttribute* _Nonnull attributes,
+        size_t numAttributes) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(blePeripheralManager->isDeviceAddressSet);
+    HAPPrecondition(!blePeripheralManager->isConnected);
+    HAPPrecondition(fingerprint);
+    HAPPrecondition(attributes);
+
+    // Keep the published GATT database if its layout is unchanged.
+    // The GATT database is held in RAM, so it is only kept while the BLE peripheral manager is alive.
+    if (blePeripheralManager->didPublishAttributes && blePeripheralManager->hasDatabaseFingerprint &&
+        HAPRawBufferAreEqual(
+                blePeripheralManager->databaseFingerprint.bytes, fingerprint->bytes, sizeof fingerprint->bytes)) {
+        for (size_t i = 0; i < numAttributes; i++) {
+            HAPPlatformBLEPeripheralManagerGATTAttribute* attribute = &attributes[i];
+            HAPAssert(i < blePeripheralManager->numAttributes);
+            const HAPPlatformBLEPeripheralManagerAttribute* publishedAttribute = &blePeripheralManager->attributes[i];
+
+            switch (attribute->kind) {
+                case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Service: {
+                    HAPAssert(publishedAttribute->type == kHAPPlatformBLEPeripheralManagerAttributeType_Service);
+                } break;
+                case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Characteristic: {
+                    HAPAssert(
+                            publishedAttribute->type == kHAPPlatformBLEPeripheralManagerAttributeType_Characteristic);
+                    attribute->_.characteristic.valueHandle = publishedAttribute->_.characteristic.valueHandle;
+                    attribute->_.characteristic.cccDescriptorHandle =
+                            publishedAttribute->_.characteristic.cccDescriptorHandle;
+                } break;
+                case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Descriptor: {
+                    HAPAssert(publishedAttribute->type == kHAPPlatformBLEPeripheralManagerAttributeType_Descriptor);
+                    attribute->_.descriptor.descriptorHandle = publishedAttribute->_.descriptor.handle;
+                } break;
+                default: {
+                    HAPFatalError();
+                }
+            }
+        }
+        HAPLogInfo(&logObject, "Kept published GATT database (%zu attributes).", numAttributes);
+        return kHAPError_None;
+    }
+
+    // Rebuild the GATT database in a single pass.
+    HAPPlatformBLEPeripheralManagerRemoveAllServices(blePeripheralManager);
+    if (numAttributes > blePeripheralManager->numAttributes) {
+        HAPLog(&logObject,
+               "Not enough resources to publish GATT database (have space for %zu GATT attributes).",
+               blePeripheralManager->numAttributes);
+        return kHAPError_OutOfResources;
+    }
+    bool inService = false;
+    bool inCharacteristic = false;
+    HAPPlatformBLEPeripheralManagerAttributeHandle handle = 0;
+    for (size_t i = 0; i < numAttributes; i++) {
+        HAPPlatformBLEPeripheralManagerGATTAttribute* attribute = &attributes[i];
+        HAPPlatformBLEPeripheralManagerAttribute* publishedAttribute = &blePeripheralManager->attributes[i];
+
+        switch (attribute->kind) {
+            case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Service: {
+                inService = true;
+                inCharacteristic = false;
+
+                if (handle >= UINT16_MAX - 1) {
+                    HAPLog(&logObject, "Not enough resources to publish GATT database (GATT database is full).");
+                    HAPPlatformBLEPeripheralManagerRemoveAllServices(blePeripheralManager);
+                    return kHAPError_OutOfResources;
+                }
+
+                publishedAttribute->type = kHAPPlatformBLEPeripheralManagerAttributeType_Service;
+                publishedAttribute->_.service.type = attribute->type;
+                publishedAttribute->_.service.isPrimary = attribute->_.service.isPrimary;
+                publishedAttribute->_.service.handle = ++handle;
+            } break;
+            case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Characteristic: {
+                HAPPrecondition(inService);
+                inCharacteristic = true;
+
+                HAPPlatformBLEPeripheralManagerCharacteristicProperties properties =
+                        attribute->_.characteristic.properties;
+                HAPPlatformBLEPeripheralManagerAttributeHandle numNeededHandles = 2;
+                if (properties.indicate || properties.notify) {
+                    numNeededHandles++;
+                }
+                if (handle >= UINT16_MAX - numNeededHandles) {
+                    HAPLog(&logObject, "Not enough resources to publish GATT database (GATT database is full).");
+                    HAPPlatformBLEPeripheralManagerRemoveAllServices(blePeripheralManager);
+                    return kHAPError_OutOfResources;
+                }
+
+                publishedAttribute->type = kHAPPlatformBLEPeripheralManagerAttributeType_Characteristic;
+                publishedAttribute->_.characteristic.type = attribute->type;
+                publishedAttribute->_.characteristic.properties = properties;
+                publishedAttribute->_.characteristic.handle = ++handle;
+                publishedAttribute->_.characteristic.valueHandle = ++handle;
+                if (properties.indicate || properties.notify) {
+                    publishedAttribute->_.characteristic.cccDescriptorHandle = ++handle;
+                }
+
+                attribute->_.characteristic.valueHandle = publishedAttribute->_.characteristic.valueHandle;
+                attribute->_.characteristic.cccDescriptorHandle =
+                        publishedAttribute->_.characteristic.cccDescriptorHandle;
+            } break;
+            case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Descriptor: {
+                HAPPrecondition(inCharacteristic);
+
+                if (handle >= UINT16_MAX - 1) {
+                    HAPLog(&logObject, "Not enough resources to publish GATT database (GATT database is full).");
+                    HAPPlatformBLEPeripheralManagerRemoveAllServices(blePeripheralManager);
+                    return kHAPError_OutOfResources;
+                }
+
+                publishedAttribute->type = kHAPPlatformBLEPeripheralManagerAttributeType_Descriptor;
+                publishedAttribute->_.descriptor.type = attribute->type;
+                publishedAttribute->_.descriptor.properties = attribute->_.descriptor.properties;
+                publishedAttribute->_.descriptor.handle = ++handle;
+
+                attribute->_.descriptor.descriptorHandle = publishedAttribute->_.descriptor.handle;
+            } break;
+            default: {
+                HAPFatalError();
+            }
+        }
+    }
+    blePeripheralManager->databaseFingerprint = *fingerprint;
+    blePeripheralManager->hasDatabaseFingerprint = true;
+    blePeripheralManager->didPublishAttributes = true;
+    blePeripheralManager->numDatabaseRegistrations++;
+    return kHAPError_None;
 }
 
 void HAPPlatformBLEPeripheralManagerStartAdvertising(
@@ -334,6 +471,7 @@ void HAPPlatformBLEPeripheralManagerStartAdvertising(
     }
     blePeripheralManager->numScanResponseBytes = (uint8_t) numScanResponseBytes;
     blePeripheralManager->advertisingInterval = advertisingInterval;
+    blePeripheralManager->numAdvertisingStarts++;
 }
 
 void HAPPlatformBLEPeripheralManagerStopAdvertising(HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager) {
@@ -355,6 +493,22 @@ bool HAPPlatformBLEPeripheralManagerIsAdvertising(HAPPlatformBLEPeripheralManage
     return blePeripheralManager->advertisingInterval != 0;
 }
 
+HAP_RESULT_USE_CHECK
+size_t HAPPlatformBLEPeripheralManagerGetNumAdvertisingStarts(
+        HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager) {
+    HAPPrecondition(blePeripheralManager);
+
+    return blePeripheralManager->numAdvertisingStarts;
+}
+
+HAP_RESULT_USE_CHECK
+size_t HAPPlatformBLEPeripheralManagerGetNumDatabaseRegistrations(
+        HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager) {
+    HAPPrecondition(blePeripheralManager);
+
+    return blePeripheralManager->numDatabaseRegistrations;
+}
+
 void HAPPlatformBLEPeripheralManagerGetDeviceAddress(
         HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager,
         HAPPlatformBLEPeripheralManagerDeviceAddress* _Nonnull deviceAddress) {
@@ -429,7 +583,37 @@ HAPError HAPPlatformBLEPeripheralManagerSendHandleValueIndication(
     HAPPrecondition(valueHandle);
     HAPPrecondition(!numBytes || bytes);
 
-    (void) connectionHandle;
-    HAPLogError(&logObject, "[NYI] %s.", __func__);
-    HAPFatalError();
+    if (blePeripheralManager->pendingIndication.valueHandle) {
+        HAPLog(&logObject, "Handle Value Indication is awaiting confirmation.");
+        return kHAPError_InvalidState;
+    }
+    HAPLogInfo(&logObject, "Sending Handle Value Indication for handle 0x%04x.", (unsigned int) valueHandle);
+    blePeripheralManager->pendingIndication.connectionHandle = connectionHandle;
+    blePeripheralManager->pendingIndication.valueHandle = valueHandle;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+bool HAPPlatformBLEPeripheralManagerGetPendingHandleValueIndication(
+        HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerAttributeHandle* _Nonnull valueHandle) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(valueHandle);
+
+    *valueHandle = blePeripheralManager->pendingIndication.valueHandle;
+    return *valueHandle != 0;
+}
+
+void HAPPlatformBLEPeripheralManagerConfirmHandleValueIndication(
+        HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(blePeripheralManager->pendingIndication.valueHandle);
+
+    HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle =
+            blePeripheralManager->pendingIndication.connectionHandle;
+    HAPRawBufferZero(&blePeripheralManager->pendingIndication, sizeof blePeripheralManager->pendingIndication);
+    if (blePeripheralManager->delegate.handleReadyToUpdateSubscribers) {
+        blePeripheralManager->delegate.handleReadyToUpdateSubscribers(
+                blePeripheralManager, connectionHandle, blePeripheralManager->delegate.context);
+    }
 }
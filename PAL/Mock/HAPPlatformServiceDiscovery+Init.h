@@ -33,6 +33,7 @@ struct HAPPlatformServiceDiscovery {
         } value;
     } txtRecords[16];
     HAPNetworkPort port;
+    size_t numTXTRecordUpdates;
     /**@endcond */
 };
 
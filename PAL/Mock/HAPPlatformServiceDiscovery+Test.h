@@ -64,6 +64,18 @@ const char* HAPPlatformServiceDiscoveryGetProtocol(HAPPlatformServiceDiscoveryRe
 HAP_RESULT_USE_CHECK
 HAPNetworkPort HAPPlatformServiceDiscoveryGetPort(HAPPlatformServiceDiscoveryRef serviceDiscovery);
 
+/**
+ * Returns how many times the TXT records of the currently advertised service have been updated.
+ *
+ * - This can only be called if a service is currently being advertised.
+ *
+ * @param      serviceDiscovery     Service discovery.
+ *
+ * @return Number of HAPPlatformServiceDiscoveryUpdateTXTRecords calls since the service was registered.
+ */
+HAP_RESULT_USE_CHECK
+size_t HAPPlatformServiceDiscoveryGetNumTXTRecordUpdates(HAPPlatformServiceDiscoveryRef serviceDiscovery);
+
 /**
  * Callback that should be invoked for each TXT record.
  *
@@ -99,6 +99,8 @@ void HAPPlatformServiceDiscoveryUpdateTXTRecords(
         serviceDiscovery->txtRecords[i].value.numBytes = (uint8_t) txtRecords[i].value.numBytes;
     }
 
+    serviceDiscovery->numTXTRecordUpdates++;
+
     HAPAssert(HAPPlatformServiceDiscoveryIsAdvertising(serviceDiscovery));
 }
 
@@ -145,6 +147,14 @@ HAPNetworkPort HAPPlatformServiceDiscoveryGetPort(HAPPlatformServiceDiscoveryRef
     return serviceDiscovery->port;
 }
 
+HAP_RESULT_USE_CHECK
+size_t HAPPlatformServiceDiscoveryGetNumTXTRecordUpdates(HAPPlatformServiceDiscoveryRef serviceDiscovery) {
+    HAPPrecondition(serviceDiscovery);
+    HAPPrecondition(HAPPlatformServiceDiscoveryIsAdvertising(serviceDiscovery));
+
+    return serviceDiscovery->numTXTRecordUpdates;
+}
+
 void HAPPlatformServiceDiscoveryEnumerateTXTRecords(
         HAPPlatformServiceDiscoveryRef serviceDiscovery,
         HAPPlatformServiceDiscoveryEnumerateTXTRecordsCallback callback,
@@ -147,6 +147,7 @@ static void Invalidate(HAPPlatformTCPStreamManagerRef tcpStreamManager, HAPPlatf
     free(tcpStream->rx.bytes);
     free(tcpStream->tx.bytes);
     HAPRawBufferZero(tcpStream, sizeof *tcpStream);
+    tcpStream->tcpStreamManager = tcpStreamManager;
 }
 
 void HAPPlatformTCPStreamCloseOutput(
@@ -278,7 +279,8 @@ HAPError HAPPlatformTCPStreamRead(
             tcpStream->rx.numBytes - *numBytes);
     tcpStream->rx.numBytes -= *numBytes;
 
-    if (!*numBytes && !tcpStream->rx.isClosed) {
+    // Report end of stream once the client has closed the connection and all its data has been read.
+    if (!*numBytes && !tcpStream->rx.isClientClosed) {
         return kHAPError_Busy;
     }
     return kHAPError_None;
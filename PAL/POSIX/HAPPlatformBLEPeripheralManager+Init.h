@@ -4,4 +4,187 @@
 // you may not use this file except in compliance with the License.
 // See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
 
-#include "../Mock/HAPPlatformBLEPeripheralManager+Init.h"
+#ifndef HAP_PLATFORM_BLE_PERIPHERAL_MANAGER_INIT_H
+#define HAP_PLATFORM_BLE_PERIPHERAL_MANAGER_INIT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sys/un.h>
+
+#include "HAPPlatform.h"
+#include "HAPPlatformBLEPeripheralManager+Socket.h"
+#include "HAPPlatformFileHandle.h"
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull begin
+#endif
+
+/**@file
+ * BLE peripheral manager implementation for POSIX.
+ *
+ * There is no Bluetooth radio. Instead, the GATT database is exposed to a single central over a Unix domain socket.
+ * This allows exercising the BLE transport end to end on a host, e.g., for benchmarks.
+ * The wire protocol is described in HAPPlatformBLEPeripheralManager+Socket.h.
+ *
+ * The following limitations apply if this code is not modified:
+ * - Constant values of characteristics and descriptors are limited to
+ *   kHAPPlatformBLEPeripheralManager_MaxConstBytes bytes.
+ * - The GATT database is limited to kHAPPlatformBLEPeripheralManager_MaxAttributes attributes.
+ *
+ * **Example**
+
+   @code{.c}
+   // Allocate BLE peripheral manager object.
+   static HAPPlatformBLEPeripheralManager blePeripheralManager;
+
+   // Initialize BLE peripheral manager object.
+   HAPPlatformBLEPeripheralManagerCreate(&blePeripheralManager,
+       &(const HAPPlatformBLEPeripheralManagerOptions) {
+           // Listen on kHAPPlatformBLEPeripheralManagerSocket_DefaultPath.
+           .socketPath = NULL
+   });
+
+   @endcode
+ */
+
+/**
+ * Maximum number of GATT attributes (services, characteristics, and descriptors).
+ */
+#define kHAPPlatformBLEPeripheralManager_MaxAttributes ((size_t) 256)
+
+/**
+ * Maximum length of a constant value of a characteristic or descriptor.
+ */
+#define kHAPPlatformBLEPeripheralManager_MaxConstBytes ((size_t) 8)
+
+/**
+ * BLE peripheral manager initialization options.
+ */
+typedef struct {
+    /**
+     * Path of the Unix domain socket on which to listen for a central.
+     *
+     * - A value of NULL will use kHAPPlatformBLEPeripheralManagerSocket_DefaultPath.
+     * - An existing file at the path is replaced.
+     */
+    const char* _Nullable socketPath;
+} HAPPlatformBLEPeripheralManagerOptions;
+
+// Opaque type. Do not use directly.
+/**@cond */
+HAP_ENUM_BEGIN(uint8_t, HAPPlatformBLEPeripheralManagerAttributeType) {
+    kHAPPlatformBLEPeripheralManagerAttributeType_None,
+    kHAPPlatformBLEPeripheralManagerAttributeType_Service,
+    kHAPPlatformBLEPeripheralManagerAttributeType_Characteristic,
+    kHAPPlatformBLEPeripheralManagerAttributeType_Descriptor
+} HAP_ENUM_END(uint8_t, HAPPlatformBLEPeripheralManagerAttributeType);
+
+typedef struct {
+    HAPPlatformBLEPeripheralManagerUUID type;
+    HAPPlatformBLEPeripheralManagerAttributeType attributeType;
+    HAPPlatformBLEPeripheralManagerAttributeHandle handle;
+    HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle;
+    HAPPlatformBLEPeripheralManagerAttributeHandle cccDescriptorHandle;
+    HAPPlatformBLEPeripheralManagerSocketProperty properties;
+    uint8_t constBytes[kHAPPlatformBLEPeripheralManager_MaxConstBytes];
+    uint8_t numConstBytes;
+    bool hasConstValue : 1;
+} HAPPlatformBLEPeripheralManagerAttribute;
+/**@endcond */
+
+/**
+ * BLE peripheral manager.
+ */
+struct HAPPlatformBLEPeripheralManager {
+    // Opaque type. Do not access the instance fields directly.
+    /**@cond */
+    char socketPath[sizeof((struct sockaddr_un*) NULL)->sun_path];
+
+    HAPPlatformBLEPeripheralManagerAttribute attributes[kHAPPlatformBLEPeripheralManager_MaxAttributes];
+    size_t numAttributes;
+    HAPPlatformBLEPeripheralManagerDatabaseFingerprint databaseFingerprint;
+
+    HAPPlatformBLEPeripheralManagerDelegate delegate;
+    HAPPlatformBLEPeripheralManagerDeviceAddress deviceAddress;
+    char deviceName[64 + 1];
+
+    uint8_t advertisingBytes[31];
+    uint8_t numAdvertisingBytes;
+    uint8_t scanResponseBytes[31];
+    uint8_t numScanResponseBytes;
+    HAPBLEAdvertisingInterval advertisingInterval;
+
+    struct {
+        int fileDescriptor;
+        HAPPlatformFileHandleRef fileHandle;
+    } listener;
+
+    struct {
+        int fileDescriptor;
+        HAPPlatformFileHandleRef fileHandle;
+
+        uint8_t inboundBytes[kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes +
+                             kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes];
+        size_t numInboundBytes;
+        uint8_t outboundBytes[2 * (kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes +
+                                   kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes)];
+        size_t numOutboundBytes;
+
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle;
+        uint16_t mtu;
+
+        struct {
+            HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle;
+            uint8_t bytes[kHAPPlatformBLEPeripheralManager_MaxAttributeBytes];
+            size_t numBytes;
+        } readValue;
+
+        struct {
+            HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle;
+            uint8_t bytes[kHAPPlatformBLEPeripheralManager_MaxAttributeBytes];
+            size_t numBytes;
+        } preparedValue;
+
+        HAPPlatformBLEPeripheralManagerAttributeHandle pendingIndicationHandle;
+        HAPPlatformTimerRef disconnectTimer;
+        bool isConnected : 1;
+    } central;
+
+    HAPPlatformBLEPeripheralManagerConnectionHandle lastConnectionHandle;
+
+    bool isDeviceAddressSet : 1;
+    bool didPublishAttributes : 1;
+    bool hasDatabaseFingerprint : 1;
+    /**@endcond */
+};
+
+/**
+ * Initializes the BLE peripheral manager.
+ *
+ * @param[out] blePeripheralManager Pointer to an allocated but uninitialized HAPPlatformBLEPeripheralManager structure.
+ * @param      options              Initialization options.
+ */
+void HAPPlatformBLEPeripheralManagerCreate(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        const HAPPlatformBLEPeripheralManagerOptions* options);
+
+/**
+ * Releases resources associated with an initialized BLE peripheral manager instance.
+ *
+ * - Closes the socket and removes it from the file system.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ */
+void HAPPlatformBLEPeripheralManagerRelease(HAPPlatformBLEPeripheralManagerRef blePeripheralManager);
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull end
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,257 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#ifndef HAP_PLATFORM_BLE_PERIPHERAL_MANAGER_SOCKET_H
+#define HAP_PLATFORM_BLE_PERIPHERAL_MANAGER_SOCKET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "HAPPlatform.h"
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull begin
+#endif
+
+/**@file
+ * Wire protocol of the BLE peripheral manager for POSIX.
+ *
+ * The BLE peripheral manager emulates a single BLE link over a Unix domain stream socket.
+ * A central opens the socket, optionally fetches the advertisement, and then connects.
+ * Only one socket is accepted at a time. Closing the socket terminates the connection.
+ *
+ * All messages are framed as follows. Multi-byte integers are little endian.
+ *
+ * - Opcode (1 byte).
+ * - Payload length (2 bytes). At most kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes.
+ * - Payload.
+ *
+ * Every request of the central is answered by a response with the opcode of the request ORed with
+ * kHAPPlatformBLEPeripheralManagerSocketOpcode_Response. The first payload byte of a response
+ * is a status (see HAPPlatformBLEPeripheralManagerSocketStatus). The central must not send
+ * a request before the response to its previous request has been received.
+ *
+ * Attribute Protocol limits are enforced based on the negotiated ATT_MTU:
+ * - Read responses contain at most ATT_MTU - 1 bytes. Longer values are read in parts using an offset.
+ * - Write requests contain at most ATT_MTU - 3 bytes. Longer values are written with Prepare Write requests
+ *   of at most ATT_MTU - 5 bytes each, followed by an Execute Write request.
+ * - Handle Value Indications contain at most ATT_MTU - 3 bytes.
+ *
+ * @see Bluetooth Core Specification Version 5
+ *      Vol 3 Part F Section 3.4 Attribute Protocol PDUs
+ */
+
+/**
+ * Default path of the socket.
+ */
+#define kHAPPlatformBLEPeripheralManagerSocket_DefaultPath ".HomeKitBLE.socket"
+
+/**
+ * Length of the frame header.
+ */
+#define kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes ((size_t) 3)
+
+/**
+ * Maximum payload length of a frame.
+ */
+#define kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes ((size_t) 1024)
+
+/**
+ * Default ATT_MTU before the MTU has been exchanged.
+ */
+#define kHAPPlatformBLEPeripheralManagerSocket_DefaultMTU ((uint16_t) 23)
+
+/**
+ * Largest ATT_MTU supported by the BLE peripheral manager.
+ *
+ * - Allows transferring an attribute value of kHAPPlatformBLEPeripheralManager_MaxAttributeBytes with one request.
+ */
+#define kHAPPlatformBLEPeripheralManagerSocket_MaxMTU ((uint16_t) 517)
+
+/**
+ * Length of an entry of a Discover response.
+ *
+ * Format:
+ * - Kind (1 byte, see HAPPlatformBLEPeripheralManagerSocketAttributeKind).
+ * - Attribute handle of the declaration (2 bytes).
+ * - UUID (16 bytes).
+ * - Properties (1 byte, see HAPPlatformBLEPeripheralManagerSocketProperty).
+ * - Value handle (2 bytes). Only characteristics, 0 otherwise.
+ * - Client Characteristic Configuration descriptor handle (2 bytes). Only characteristics, 0 if none.
+ */
+#define kHAPPlatformBLEPeripheralManagerSocket_NumDiscoverEntryBytes ((size_t) 24)
+
+/**
+ * Opcode.
+ */
+HAP_ENUM_BEGIN(uint8_t, HAPPlatformBLEPeripheralManagerSocketOpcode) {
+    /**
+     * Connect. Only accepted while advertising.
+     *
+     * Request: Empty.
+     * Response: Status, Connection handle (2 bytes).
+     */
+    kHAPPlatformBLEPeripheralManagerSocketOpcode_Connect = 0x01,
+
+    /**
+     * Exchange MTU.
+     *
+     * Request: Client Rx MTU (2 bytes).
+     * Response: Status, Server Rx MTU (2 bytes).
+     */
+    kHAPPlatformBLEPeripheralManagerSocketOpcode_ExchangeMTU = 0x02,
+
+    /**
+     * Discover attributes, in ascending order of their handles.
+     *
+     * Request: Starting handle (2 bytes).
+     * Response: Status, Discover entries. No entries once the end of the GATT database has been reached.
+     */
+    kHAPPlatformBLEPeripheralManagerSocketOpcode_Discover = 0x03,
+
+    /**
+     * Read. The value is fetched from the delegate when the offset is 0.
+     *
+     * Request: Attribute handle (2 bytes), Offset (2 bytes).
+     * Response: Status, Part of the value.
+     */
+    kHAPPlatformBLEPeripheralManagerSocketOpcode_Read = 0x04,
+
+    /**
+     * Write.
+     *
+     * Request: Attribute handle (2 bytes), Value.
+     * Response: Status.
+     */
+    kHAPPlatformBLEPeripheralManagerSocketOpcode_Write = 0x05,
+
+    /**
+     * Prepare Write. Parts must be sent in order.
+     *
+     * Request: Attribute handle (2 bytes), Offset (2 bytes), Part of the value.
+     * Response: Status.
+     */
+    kHAPPlatformBLEPeripheralManagerSocketOpcode_PrepareWrite = 0x06,
+
+    /**
+     * Execute Write.
+     *
+     * Request: Flags (1 byte). 0x01 to write the prepared value, 0x00 to discard it.
+     * Response: Status.
+     */
+    kHAPPlatformBLEPeripheralManagerSocketOpcode_ExecuteWrite = 0x07,
+
+    /**
+     * Handle Value Indication. Sent by the BLE peripheral manager. Not a request.
+     *
+     * Payload: Attribute handle (2 bytes), Value.
+     */
+    kHAPPlatformBLEPeripheralManagerSocketOpcode_Indication = 0x08,
+
+    /**
+     * Handle Value Confirmation. Sent by the central in reply to a Handle Value Indication. Not a request.
+     *
+     * Payload: Empty.
+     */
+    kHAPPlatformBLEPeripheralManagerSocketOpcode_Confirmation = 0x09,
+
+    /**
+     * Fetch advertisement. Also accepted while not connected.
+     *
+     * Request: Empty.
+     * Response: Status, Advertising interval (2 bytes), Advertising data length (1 byte), Advertising data,
+     *           Scan response length (1 byte), Scan response.
+     */
+    kHAPPlatformBLEPeripheralManagerSocketOpcode_GetAdvertisement = 0x0A,
+
+    /**
+     * Flag that marks a response.
+     */
+    kHAPPlatformBLEPeripheralManagerSocketOpcode_Response = 0x80
+} HAP_ENUM_END(uint8_t, HAPPlatformBLEPeripheralManagerSocketOpcode);
+
+/**
+ * Status of a response. Values match the Attribute Protocol error codes.
+ *
+ * @see Bluetooth Core Specification Version 5
+ *      Vol 3 Part F Section 3.4.1.1 Error Response
+ */
+HAP_ENUM_BEGIN(uint8_t, HAPPlatformBLEPeripheralManagerSocketStatus) {
+    /** Success. */
+    kHAPPlatformBLEPeripheralManagerSocketStatus_Success = 0x00,
+
+    /** The attribute handle is not valid. */
+    kHAPPlatformBLEPeripheralManagerSocketStatus_InvalidHandle = 0x01,
+
+    /** The attribute cannot be read. */
+    kHAPPlatformBLEPeripheralManagerSocketStatus_ReadNotPermitted = 0x02,
+
+    /** The attribute cannot be written. */
+    kHAPPlatformBLEPeripheralManagerSocketStatus_WriteNotPermitted = 0x03,
+
+    /** The request is not supported in the current state. */
+    kHAPPlatformBLEPeripheralManagerSocketStatus_RequestNotSupported = 0x06,
+
+    /** The offset is past the end of the attribute value. */
+    kHAPPlatformBLEPeripheralManagerSocketStatus_InvalidOffset = 0x07,
+
+    /** The value is too long. */
+    kHAPPlatformBLEPeripheralManagerSocketStatus_InvalidAttributeValueLength = 0x0D,
+
+    /** The request could not be completed. */
+    kHAPPlatformBLEPeripheralManagerSocketStatus_UnlikelyError = 0x0E,
+
+    /** Insufficient resources to complete the request. */
+    kHAPPlatformBLEPeripheralManagerSocketStatus_InsufficientResources = 0x11
+} HAP_ENUM_END(uint8_t, HAPPlatformBLEPeripheralManagerSocketStatus);
+
+/**
+ * Kind of a Discover entry.
+ */
+HAP_ENUM_BEGIN(uint8_t, HAPPlatformBLEPeripheralManagerSocketAttributeKind) {
+    /** Service. */
+    kHAPPlatformBLEPeripheralManagerSocketAttributeKind_Service = 0x01,
+
+    /** Characteristic. */
+    kHAPPlatformBLEPeripheralManagerSocketAttributeKind_Characteristic = 0x02,
+
+    /** Descriptor. */
+    kHAPPlatformBLEPeripheralManagerSocketAttributeKind_Descriptor = 0x03
+} HAP_ENUM_END(uint8_t, HAPPlatformBLEPeripheralManagerSocketAttributeKind);
+
+/**
+ * Property bits of a Discover entry.
+ */
+HAP_OPTIONS_BEGIN(uint8_t, HAPPlatformBLEPeripheralManagerSocketProperty) {
+    /** Service: Primary service. */
+    kHAPPlatformBLEPeripheralManagerSocketProperty_Primary = 1U << 0U,
+
+    /** Characteristic, descriptor: Read. */
+    kHAPPlatformBLEPeripheralManagerSocketProperty_Read = 1U << 1U,
+
+    /** Characteristic: Write Without Response. */
+    kHAPPlatformBLEPeripheralManagerSocketProperty_WriteWithoutResponse = 1U << 2U,
+
+    /** Characteristic, descriptor: Write. */
+    kHAPPlatformBLEPeripheralManagerSocketProperty_Write = 1U << 3U,
+
+    /** Characteristic: Notify. */
+    kHAPPlatformBLEPeripheralManagerSocketProperty_Notify = 1U << 4U,
+
+    /** Characteristic: Indicate. */
+    kHAPPlatformBLEPeripheralManagerSocketProperty_Indicate = 1U << 5U
+} HAP_OPTIONS_END(uint8_t, HAPPlatformBLEPeripheralManagerSocketProperty);
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull end
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -4,4 +4,1750 @@
 // you may not use this file except in compliance with the License.
 // See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
 
-#include "../Mock/HAPPlatformBLEPeripheralManager.c"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "HAPPlatform+Init.h"
+#include "HAPPlatformBLEPeripheralManager+Init.h"
+#include "HAPPlatformLog+Init.h"
+
+static const HAPLogObject logObject = { .subsystem = kHAPPlatform_LogSubsystem, .category = "BLEPeripheralManager" };
+
+/**
+ * Largest connection handle. Connection handles are assigned round-robin starting at 1.
+ *
+ * @see Bluetooth Core Specification Version 5
+ *      Vol 2 Part E Section 5.3.1 Primary Controller Handles
+ */
+#define kMaxConnectionHandle ((HAPPlatformBLEPeripheralManagerConnectionHandle) 0x0EFF)
+
+/**
+ * Sets all fields of the central connection to their initial values.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ */
+static void InitializeCentral(HAPPlatformBLEPeripheralManagerRef blePeripheralManager) {
+    HAPPrecondition(blePeripheralManager);
+
+    HAPRawBufferZero(&blePeripheralManager->central, sizeof blePeripheralManager->central);
+    blePeripheralManager->central.fileDescriptor = -1;
+}
+
+/**
+ * Makes a file descriptor nonblocking.
+ *
+ * @param      fileDescriptor       File descriptor.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If the nonblocking flag could not be set.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError SetNonblocking(int fileDescriptor) {
+    int e = fcntl(fileDescriptor, F_SETFL, O_NONBLOCK);
+    if (e == -1) {
+        HAPPlatformLogPOSIXError(
+                kHAPLogType_Error,
+                "System call 'fcntl' to set file descriptor flags to 'non-blocking' failed.",
+                errno,
+                __func__,
+                HAP_FILE,
+                __LINE__);
+        return kHAPError_Unknown;
+    }
+    return kHAPError_None;
+}
+
+static void HandleListenerFileHandleCallback(
+        HAPPlatformFileHandleRef fileHandle,
+        HAPPlatformFileHandleEvent fileHandleEvents,
+        void* _Nullable context);
+
+/**
+ * Enables or disables accepting centrals.
+ *
+ * - While a central is attached, further centrals wait in the listen backlog until it has detached.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      isAccepting          Whether or not centrals are accepted.
+ */
+static void SetAcceptingCentrals(HAPPlatformBLEPeripheralManagerRef blePeripheralManager, bool isAccepting) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(blePeripheralManager->listener.fileHandle);
+
+    HAPPlatformFileHandleUpdateInterests(
+            blePeripheralManager->listener.fileHandle,
+            (HAPPlatformFileHandleEvent) {
+                    .isReadyForReading = isAccepting, .isReadyForWriting = false, .hasErrorConditionPending = false },
+            HandleListenerFileHandleCallback,
+            blePeripheralManager);
+}
+
+/**
+ * Closes the socket of the central. If the central is connected, the delegate is informed.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ */
+static void DisconnectCentral(HAPPlatformBLEPeripheralManagerRef blePeripheralManager) {
+    HAPPrecondition(blePeripheralManager);
+
+    if (blePeripheralManager->central.fileDescriptor == -1) {
+        return;
+    }
+
+    if (blePeripheralManager->central.disconnectTimer) {
+        HAPPlatformTimerDeregister(blePeripheralManager->central.disconnectTimer);
+        blePeripheralManager->central.disconnectTimer = 0;
+    }
+    HAPPlatformFileHandleDeregister(blePeripheralManager->central.fileHandle);
+    HAPLogDebug(&logObject, "close(%d);", blePeripheralManager->central.fileDescriptor);
+    int e = close(blePeripheralManager->central.fileDescriptor);
+    if (e != 0) {
+        int _errno = errno;
+        HAPAssert(e == -1);
+        HAPPlatformLogPOSIXError(
+                kHAPLogType_Debug,
+                "System call 'close' on central socket failed.",
+                _errno,
+                __func__,
+                HAP_FILE,
+                __LINE__);
+    }
+
+    bool wasConnected = blePeripheralManager->central.isConnected;
+    HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle = blePeripheralManager->central.connectionHandle;
+    InitializeCentral(blePeripheralManager);
+    if (blePeripheralManager->listener.fileHandle) {
+        SetAcceptingCentrals(blePeripheralManager, true);
+    }
+
+    if (wasConnected) {
+        HAPLogInfo(&logObject, "Central disconnected (connection handle 0x%04x).", connectionHandle);
+        if (blePeripheralManager->delegate.handleDisconnectedCentral) {
+            blePeripheralManager->delegate.handleDisconnectedCentral(
+                    blePeripheralManager, connectionHandle, blePeripheralManager->delegate.context);
+        }
+    }
+}
+
+static void DisconnectTimerExpired(HAPPlatformTimerRef timer, void* _Nullable context) {
+    HAPPrecondition(context);
+    HAPPlatformBLEPeripheralManagerRef blePeripheralManager = context;
+    HAPPrecondition(timer == blePeripheralManager->central.disconnectTimer);
+    blePeripheralManager->central.disconnectTimer = 0;
+
+    DisconnectCentral(blePeripheralManager);
+}
+
+/**
+ * Schedules closing the socket of the central.
+ *
+ * - The socket is closed asynchronously so that this may be called from within delegate callbacks.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ */
+static void ScheduleDisconnect(HAPPlatformBLEPeripheralManagerRef blePeripheralManager) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(blePeripheralManager->central.fileDescriptor != -1);
+
+    if (blePeripheralManager->central.disconnectTimer) {
+        return;
+    }
+    HAPError err = HAPPlatformTimerRegister(
+            &blePeripheralManager->central.disconnectTimer, 0, DisconnectTimerExpired, blePeripheralManager);
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        HAPLogError(&logObject, "Not enough resources to schedule disconnect.");
+        HAPFatalError();
+    }
+}
+
+static void HandleCentralFileHandleCallback(
+        HAPPlatformFileHandleRef fileHandle,
+        HAPPlatformFileHandleEvent fileHandleEvents,
+        void* _Nullable context);
+
+/**
+ * Writes as much of the outbound buffer as possible to the socket of the central.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ */
+static void FlushOutboundBytes(HAPPlatformBLEPeripheralManagerRef blePeripheralManager) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(blePeripheralManager->central.fileDescriptor != -1);
+
+    while (blePeripheralManager->central.numOutboundBytes) {
+        ssize_t n = send(
+                blePeripheralManager->central.fileDescriptor,
+                blePeripheralManager->central.outboundBytes,
+                blePeripheralManager->central.numOutboundBytes,
+                MSG_NOSIGNAL);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (n == -1) {
+            HAPPlatformLogPOSIXError(
+                    kHAPLogType_Debug,
+                    "System call 'send' on central socket failed.",
+                    errno,
+                    __func__,
+                    HAP_FILE,
+                    __LINE__);
+            blePeripheralManager->central.numOutboundBytes = 0;
+            ScheduleDisconnect(blePeripheralManager);
+            return;
+        }
+        HAPAssert((size_t) n <= blePeripheralManager->central.numOutboundBytes);
+        blePeripheralManager->central.numOutboundBytes -= (size_t) n;
+        HAPRawBufferCopyBytes(
+                blePeripheralManager->central.outboundBytes,
+                &blePeripheralManager->central.outboundBytes[n],
+                blePeripheralManager->central.numOutboundBytes);
+    }
+
+    HAPPlatformFileHandleUpdateInterests(
+            blePeripheralManager->central.fileHandle,
+            (HAPPlatformFileHandleEvent) { .isReadyForReading = true,
+                                           .isReadyForWriting = blePeripheralManager->central.numOutboundBytes != 0,
+                                           .hasErrorConditionPending = false },
+            HandleCentralFileHandleCallback,
+            blePeripheralManager);
+}
+
+/**
+ * Sends a frame to the central.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      opcode               Opcode.
+ * @param      bytes                Payload.
+ * @param      numBytes             Length of payload.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If the outbound buffer is full.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError SendFrame(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        uint8_t opcode,
+        const void* _Nullable bytes,
+        size_t numBytes) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(blePeripheralManager->central.fileDescriptor != -1);
+    HAPPrecondition(!numBytes || bytes);
+    HAPPrecondition(numBytes <= kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes);
+
+    size_t numFreeBytes =
+            sizeof blePeripheralManager->central.outboundBytes - blePeripheralManager->central.numOutboundBytes;
+    if (numFreeBytes < kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes + numBytes) {
+        HAPLog(&logObject, "Not enough space in outbound buffer (%zu / %zu bytes).", numBytes, numFreeBytes);
+        return kHAPError_OutOfResources;
+    }
+    uint8_t* frameBytes = &blePeripheralManager->central.outboundBytes[blePeripheralManager->central.numOutboundBytes];
+    frameBytes[0] = opcode;
+    HAPWriteLittleUInt16(&frameBytes[1], numBytes);
+    if (numBytes) {
+        HAPRawBufferCopyBytes(
+                &frameBytes[kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes], HAPNonnullVoid(bytes), numBytes);
+    }
+    blePeripheralManager->central.numOutboundBytes += kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes + numBytes;
+
+    FlushOutboundBytes(blePeripheralManager);
+    return kHAPError_None;
+}
+
+/**
+ * Sends a response to the central.
+ *
+ * - The central must wait for the response to a request before it sends the next request.
+ *   Centrals that do not follow this rule are disconnected once the outbound buffer fills up.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      opcode               Opcode of the request.
+ * @param      status               Status.
+ * @param      bytes                Payload following the status.
+ * @param      numBytes             Length of payload following the status.
+ */
+static void SendResponse(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        uint8_t opcode,
+        HAPPlatformBLEPeripheralManagerSocketStatus status,
+        const void* _Nullable bytes,
+        size_t numBytes) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(!numBytes || bytes);
+    HAPPrecondition(numBytes < kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes);
+
+    if (blePeripheralManager->central.fileDescriptor == -1 || blePeripheralManager->central.disconnectTimer) {
+        return;
+    }
+
+    uint8_t payload[kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes];
+    payload[0] = status;
+    if (numBytes) {
+        HAPRawBufferCopyBytes(&payload[1], HAPNonnullVoid(bytes), numBytes);
+    }
+    HAPError err = SendFrame(
+            blePeripheralManager,
+            opcode | kHAPPlatformBLEPeripheralManagerSocketOpcode_Response,
+            payload,
+            1 + numBytes);
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        HAPLog(&logObject, "Central does not wait for responses. Disconnecting.");
+        ScheduleDisconnect(blePeripheralManager);
+    }
+}
+
+/**
+ * Returns the largest attribute handle that is in use.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ *
+ * @return Largest attribute handle that is in use. 0 if the GATT database is empty.
+ */
+HAP_RESULT_USE_CHECK
+static HAPPlatformBLEPeripheralManagerAttributeHandle
+        GetLastAttributeHandle(HAPPlatformBLEPeripheralManagerRef blePeripheralManager) {
+    HAPPrecondition(blePeripheralManager);
+
+    if (!blePeripheralManager->numAttributes) {
+        return 0;
+    }
+    const HAPPlatformBLEPeripheralManagerAttribute* attribute =
+            &blePeripheralManager->attributes[blePeripheralManager->numAttributes - 1];
+    if (attribute->cccDescriptorHandle) {
+        return attribute->cccDescriptorHandle;
+    }
+    if (attribute->valueHandle) {
+        return attribute->valueHandle;
+    }
+    return attribute->handle;
+}
+
+/**
+ * Appends an attribute to the GATT database.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      numHandles           Number of attribute handles that the attribute occupies.
+ * @param[out] attribute            Appended attribute. Its handle is set.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If the GATT database is full.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError AppendAttribute(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerAttributeHandle numHandles,
+        HAPPlatformBLEPeripheralManagerAttribute* _Nonnull* _Nonnull attribute) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(numHandles);
+    HAPPrecondition(attribute);
+
+    if (blePeripheralManager->numAttributes == HAPArrayCount(blePeripheralManager->attributes)) {
+        HAPLog(&logObject,
+               "Not enough resources to add GATT attribute (have space for %zu GATT attributes).",
+               HAPArrayCount(blePeripheralManager->attributes));
+        return kHAPError_OutOfResources;
+    }
+    HAPPlatformBLEPeripheralManagerAttributeHandle handle = GetLastAttributeHandle(blePeripheralManager);
+    if (handle > UINT16_MAX - numHandles) {
+        HAPLog(&logObject, "Not enough resources to add GATT attribute (GATT database is full).");
+        return kHAPError_OutOfResources;
+    }
+
+    *attribute = &blePeripheralManager->attributes[blePeripheralManager->numAttributes];
+    HAPRawBufferZero(*attribute, sizeof **attribute);
+    (*attribute)->handle = (HAPPlatformBLEPeripheralManagerAttributeHandle)(handle + 1);
+    blePeripheralManager->numAttributes++;
+    return kHAPError_None;
+}
+
+/**
+ * Stores the constant value of a characteristic or descriptor.
+ *
+ * @param      attribute            Attribute.
+ * @param      constBytes           Constant value. NULL if the value is not constant.
+ * @param      constNumBytes        Length of constant value.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If the constant value is too long.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError SetConstValue(
+        HAPPlatformBLEPeripheralManagerAttribute* attribute,
+        const void* _Nullable constBytes,
+        size_t constNumBytes) {
+    HAPPrecondition(attribute);
+    HAPPrecondition(!constNumBytes || constBytes);
+
+    if (!constBytes) {
+        return kHAPError_None;
+    }
+    if (constNumBytes > sizeof attribute->constBytes) {
+        HAPLog(&logObject,
+               "Constant value too long (%zu / %zu bytes).",
+               constNumBytes,
+               sizeof attribute->constBytes);
+        return kHAPError_OutOfResources;
+    }
+    if (constNumBytes) {
+        HAPRawBufferCopyBytes(attribute->constBytes, HAPNonnullVoid(constBytes), constNumBytes);
+    }
+    attribute->numConstBytes = (uint8_t) constNumBytes;
+    attribute->hasConstValue = true;
+    return kHAPError_None;
+}
+
+/**
+ * Access to an attribute handle.
+ */
+typedef struct {
+    /** Attribute that contains the handle. NULL if the handle is not in use. */
+    const HAPPlatformBLEPeripheralManagerAttribute* _Nullable attribute;
+
+    /** Whether or not the handle refers to a declaration. */
+    bool isDeclaration : 1;
+
+    /** Whether or not the handle may be read. */
+    bool isReadable : 1;
+
+    /** Whether or not the handle may be written. */
+    bool isWritable : 1;
+
+    /** Whether or not the value is constant. */
+    bool hasConstValue : 1;
+} AttributeAccess;
+
+/**
+ * Looks up an attribute handle.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      attributeHandle      Attribute handle.
+ *
+ * @return Access to the attribute handle.
+ */
+HAP_RESULT_USE_CHECK
+static AttributeAccess GetAttributeAccess(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle) {
+    HAPPrecondition(blePeripheralManager);
+
+    AttributeAccess access;
+    HAPRawBufferZero(&access, sizeof access);
+
+    // Handles are assigned in ascending order.
+    size_t lo = 0;
+    size_t hi = blePeripheralManager->numAttributes;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (blePeripheralManager->attributes[mid].handle <= attributeHandle) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (!lo) {
+        return access;
+    }
+    const HAPPlatformBLEPeripheralManagerAttribute* attribute = &blePeripheralManager->attributes[lo - 1];
+
+    HAPPlatformBLEPeripheralManagerSocketProperty properties = attribute->properties;
+    if (attributeHandle == attribute->handle) {
+        access.attribute = attribute;
+        access.isDeclaration =
+                attribute->attributeType != kHAPPlatformBLEPeripheralManagerAttributeType_Descriptor;
+        if (!access.isDeclaration) {
+            access.isReadable = (properties & kHAPPlatformBLEPeripheralManagerSocketProperty_Read) != 0;
+            access.isWritable =
+                    !attribute->hasConstValue && (properties & kHAPPlatformBLEPeripheralManagerSocketProperty_Write);
+            access.hasConstValue = attribute->hasConstValue;
+        }
+    } else if (attributeHandle == attribute->valueHandle) {
+        access.attribute = attribute;
+        access.isReadable = (properties & kHAPPlatformBLEPeripheralManagerSocketProperty_Read) != 0;
+        access.isWritable = !attribute->hasConstValue &&
+                            (properties & (kHAPPlatformBLEPeripheralManagerSocketProperty_Write |
+                                           kHAPPlatformBLEPeripheralManagerSocketProperty_WriteWithoutResponse));
+        access.hasConstValue = attribute->hasConstValue;
+    } else if (attributeHandle == attribute->cccDescriptorHandle) {
+        access.attribute = attribute;
+        access.isReadable = true;
+        access.isWritable = true;
+    }
+    return access;
+}
+
+/**
+ * Maps an error of a delegate callback to a status.
+ *
+ * @param      err                  Error returned by the delegate.
+ * @param      isWrite              Whether or not the error was returned by a write request.
+ *
+ * @return Status.
+ */
+HAP_RESULT_USE_CHECK
+static HAPPlatformBLEPeripheralManagerSocketStatus GetStatusForError(HAPError err, bool isWrite) {
+    switch (err) {
+        case kHAPError_None: {
+            return kHAPPlatformBLEPeripheralManagerSocketStatus_Success;
+        }
+        case kHAPError_InvalidState: {
+            return isWrite ? kHAPPlatformBLEPeripheralManagerSocketStatus_WriteNotPermitted :
+                             kHAPPlatformBLEPeripheralManagerSocketStatus_ReadNotPermitted;
+        }
+        case kHAPError_OutOfResources: {
+            return kHAPPlatformBLEPeripheralManagerSocketStatus_InsufficientResources;
+        }
+        default: {
+            return kHAPPlatformBLEPeripheralManagerSocketStatus_UnlikelyError;
+        }
+    }
+}
+
+/**
+ * Forwards a complete write to the delegate.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      attributeHandle      Attribute handle.
+ * @param      bytes                Value.
+ * @param      numBytes             Length of value.
+ *
+ * @return Status.
+ */
+HAP_RESULT_USE_CHECK
+static HAPPlatformBLEPeripheralManagerSocketStatus WriteValue(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle,
+        void* bytes,
+        size_t numBytes) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(bytes);
+
+    if (!blePeripheralManager->delegate.handleWriteRequest) {
+        return kHAPPlatformBLEPeripheralManagerSocketStatus_WriteNotPermitted;
+    }
+    HAPError err = blePeripheralManager->delegate.handleWriteRequest(
+            blePeripheralManager,
+            blePeripheralManager->central.connectionHandle,
+            attributeHandle,
+            bytes,
+            numBytes,
+            blePeripheralManager->delegate.context);
+    return GetStatusForError(err, /* isWrite: */ true);
+}
+
+/**
+ * Handles a Connect request.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      opcode               Opcode.
+ * @param      numBytes             Length of payload.
+ */
+static void HandleConnect(HAPPlatformBLEPeripheralManagerRef blePeripheralManager, uint8_t opcode, size_t numBytes) {
+    HAPPrecondition(blePeripheralManager);
+
+    if (numBytes) {
+        SendResponse(blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_UnlikelyError, NULL, 0);
+        return;
+    }
+    if (blePeripheralManager->central.isConnected || !blePeripheralManager->didPublishAttributes ||
+        !blePeripheralManager->advertisingInterval) {
+        HAPLog(&logObject, "Rejecting connection: Not connectable.");
+        SendResponse(
+                blePeripheralManager,
+                opcode,
+                kHAPPlatformBLEPeripheralManagerSocketStatus_RequestNotSupported,
+                NULL,
+                0);
+        return;
+    }
+
+    blePeripheralManager->lastConnectionHandle = (HAPPlatformBLEPeripheralManagerConnectionHandle)(
+            blePeripheralManager->lastConnectionHandle % kMaxConnectionHandle + 1);
+    blePeripheralManager->central.connectionHandle = blePeripheralManager->lastConnectionHandle;
+    blePeripheralManager->central.mtu = kHAPPlatformBLEPeripheralManagerSocket_DefaultMTU;
+    blePeripheralManager->central.isConnected = true;
+    HAPLogInfo(
+            &logObject,
+            "Central connected (connection handle 0x%04x).",
+            blePeripheralManager->central.connectionHandle);
+
+    uint8_t bytes[2];
+    HAPWriteLittleUInt16(bytes, blePeripheralManager->central.connectionHandle);
+    SendResponse(
+            blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_Success, bytes, sizeof bytes);
+
+    if (blePeripheralManager->delegate.handleConnectedCentral) {
+        blePeripheralManager->delegate.handleConnectedCentral(
+                blePeripheralManager,
+                blePeripheralManager->central.connectionHandle,
+                blePeripheralManager->delegate.context);
+    }
+}
+
+/**
+ * Handles an Exchange MTU request.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      opcode               Opcode.
+ * @param      bytes                Payload.
+ * @param      numBytes             Length of payload.
+ */
+static void HandleExchangeMTU(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        uint8_t opcode,
+        const uint8_t* bytes,
+        size_t numBytes) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(bytes);
+
+    if (numBytes != 2) {
+        SendResponse(blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_UnlikelyError, NULL, 0);
+        return;
+    }
+    uint16_t clientMTU = HAPReadLittleUInt16(bytes);
+    blePeripheralManager->central.mtu = HAPMax(
+            kHAPPlatformBLEPeripheralManagerSocket_DefaultMTU,
+            HAPMin(clientMTU, kHAPPlatformBLEPeripheralManagerSocket_MaxMTU));
+    HAPLogDebug(&logObject, "ATT_MTU: %u.", blePeripheralManager->central.mtu);
+
+    uint8_t responseBytes[2];
+    HAPWriteLittleUInt16(responseBytes, kHAPPlatformBLEPeripheralManagerSocket_MaxMTU);
+    SendResponse(
+            blePeripheralManager,
+            opcode,
+            kHAPPlatformBLEPeripheralManagerSocketStatus_Success,
+            responseBytes,
+            sizeof responseBytes);
+}
+
+/**
+ * Handles a Discover request.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      opcode               Opcode.
+ * @param      bytes                Payload.
+ * @param      numBytes             Length of payload.
+ */
+static void HandleDiscover(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        uint8_t opcode,
+        const uint8_t* bytes,
+        size_t numBytes) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(bytes);
+
+    if (numBytes != 2) {
+        SendResponse(blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_UnlikelyError, NULL, 0);
+        return;
+    }
+    HAPPlatformBLEPeripheralManagerAttributeHandle startHandle = HAPReadLittleUInt16(bytes);
+
+    uint8_t responseBytes[kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes - 1];
+    size_t numResponseBytes = 0;
+    for (size_t i = 0; i < blePeripheralManager->numAttributes; i++) {
+        const HAPPlatformBLEPeripheralManagerAttribute* attribute = &blePeripheralManager->attributes[i];
+        if (attribute->handle < startHandle) {
+            continue;
+        }
+        if (sizeof responseBytes - numResponseBytes < kHAPPlatformBLEPeripheralManagerSocket_NumDiscoverEntryBytes) {
+            break;
+        }
+        uint8_t* entryBytes = &responseBytes[numResponseBytes];
+        switch (attribute->attributeType) {
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Service: {
+                entryBytes[0] = kHAPPlatformBLEPeripheralManagerSocketAttributeKind_Service;
+            } break;
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Characteristic: {
+                entryBytes[0] = kHAPPlatformBLEPeripheralManagerSocketAttributeKind_Characteristic;
+            } break;
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Descriptor: {
+                entryBytes[0] = kHAPPlatformBLEPeripheralManagerSocketAttributeKind_Descriptor;
+            } break;
+            default:
+                HAPFatalError();
+        }
+        HAPWriteLittleUInt16(&entryBytes[1], attribute->handle);
+        HAPRawBufferCopyBytes(&entryBytes[3], attribute->type.bytes, sizeof attribute->type.bytes);
+        entryBytes[19] = attribute->properties;
+        HAPWriteLittleUInt16(&entryBytes[20], attribute->valueHandle);
+        HAPWriteLittleUInt16(&entryBytes[22], attribute->cccDescriptorHandle);
+        numResponseBytes += kHAPPlatformBLEPeripheralManagerSocket_NumDiscoverEntryBytes;
+    }
+    SendResponse(
+            blePeripheralManager,
+            opcode,
+            kHAPPlatformBLEPeripheralManagerSocketStatus_Success,
+            responseBytes,
+            numResponseBytes);
+}
+
+/**
+ * Handles a Read request.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      opcode               Opcode.
+ * @param      bytes                Payload.
+ * @param      numBytes             Length of payload.
+ */
+static void HandleRead(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        uint8_t opcode,
+        const uint8_t* bytes,
+        size_t numBytes) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(bytes);
+
+    if (numBytes != 4) {
+        SendResponse(blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_UnlikelyError, NULL, 0);
+        return;
+    }
+    HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle = HAPReadLittleUInt16(&bytes[0]);
+    size_t offset = HAPReadLittleUInt16(&bytes[2]);
+
+    AttributeAccess access = GetAttributeAccess(blePeripheralManager, attributeHandle);
+    if (!access.attribute) {
+        SendResponse(blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_InvalidHandle, NULL, 0);
+        return;
+    }
+    if (!access.isReadable) {
+        SendResponse(
+                blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_ReadNotPermitted, NULL, 0);
+        return;
+    }
+
+    // The value is fetched when a read starts. Subsequent parts are served from the fetched value.
+    if (!offset) {
+        blePeripheralManager->central.readValue.attributeHandle = 0;
+        blePeripheralManager->central.readValue.numBytes = 0;
+        if (access.hasConstValue) {
+            const HAPPlatformBLEPeripheralManagerAttribute* attribute = HAPNonnull(access.attribute);
+            HAPRawBufferCopyBytes(
+                    blePeripheralManager->central.readValue.bytes, attribute->constBytes, attribute->numConstBytes);
+            blePeripheralManager->central.readValue.numBytes = attribute->numConstBytes;
+        } else {
+            if (!blePeripheralManager->delegate.handleReadRequest) {
+                SendResponse(
+                        blePeripheralManager,
+                        opcode,
+                        kHAPPlatformBLEPeripheralManagerSocketStatus_ReadNotPermitted,
+                        NULL,
+                        0);
+                return;
+            }
+            size_t numValueBytes;
+            HAPError err = blePeripheralManager->delegate.handleReadRequest(
+                    blePeripheralManager,
+                    blePeripheralManager->central.connectionHandle,
+                    attributeHandle,
+                    blePeripheralManager->central.readValue.bytes,
+                    sizeof blePeripheralManager->central.readValue.bytes,
+                    &numValueBytes,
+                    blePeripheralManager->delegate.context);
+            if (err) {
+                SendResponse(
+                        blePeripheralManager, opcode, GetStatusForError(err, /* isWrite: */ false), NULL, 0);
+                return;
+            }
+            HAPAssert(numValueBytes <= sizeof blePeripheralManager->central.readValue.bytes);
+            blePeripheralManager->central.readValue.numBytes = numValueBytes;
+        }
+        blePeripheralManager->central.readValue.attributeHandle = attributeHandle;
+    }
+    if (blePeripheralManager->central.readValue.attributeHandle != attributeHandle ||
+        offset > blePeripheralManager->central.readValue.numBytes) {
+        SendResponse(blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_InvalidOffset, NULL, 0);
+        return;
+    }
+
+    size_t numPartBytes = HAPMin(
+            blePeripheralManager->central.readValue.numBytes - offset, (size_t) blePeripheralManager->central.mtu - 1);
+    SendResponse(
+            blePeripheralManager,
+            opcode,
+            kHAPPlatformBLEPeripheralManagerSocketStatus_Success,
+            &blePeripheralManager->central.readValue.bytes[offset],
+            numPartBytes);
+}
+
+/**
+ * Handles a Write request.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      opcode               Opcode.
+ * @param      bytes                Payload.
+ * @param      numBytes             Length of payload.
+ */
+static void HandleWrite(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        uint8_t opcode,
+        uint8_t* bytes,
+        size_t numBytes) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(bytes);
+
+    if (numBytes < 2) {
+        SendResponse(blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_UnlikelyError, NULL, 0);
+        return;
+    }
+    HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle = HAPReadLittleUInt16(&bytes[0]);
+    size_t numValueBytes = numBytes - 2;
+
+    AttributeAccess access = GetAttributeAccess(blePeripheralManager, attributeHandle);
+    if (!access.attribute) {
+        SendResponse(blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_InvalidHandle, NULL, 0);
+        return;
+    }
+    if (!access.isWritable) {
+        SendResponse(
+                blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_WriteNotPermitted, NULL, 0);
+        return;
+    }
+    if (numValueBytes > (size_t) blePeripheralManager->central.mtu - 3) {
+        SendResponse(
+                blePeripheralManager,
+                opcode,
+                kHAPPlatformBLEPeripheralManagerSocketStatus_InvalidAttributeValueLength,
+                NULL,
+                0);
+        return;
+    }
+
+    HAPPlatformBLEPeripheralManagerSocketStatus status =
+            WriteValue(blePeripheralManager, attributeHandle, &bytes[2], numValueBytes);
+    SendResponse(blePeripheralManager, opcode, status, NULL, 0);
+}
+
+/**
+ * Handles a Prepare Write request.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      opcode               Opcode.
+ * @param      bytes                Payload.
+ * @param      numBytes             Length of payload.
+ */
+static void HandlePrepareWrite(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        uint8_t opcode,
+        const uint8_t* bytes,
+        size_t numBytes) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(bytes);
+
+    if (numBytes < 4) {
+        SendResponse(blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_UnlikelyError, NULL, 0);
+        return;
+    }
+    HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle = HAPReadLittleUInt16(&bytes[0]);
+    size_t offset = HAPReadLittleUInt16(&bytes[2]);
+    size_t numPartBytes = numBytes - 4;
+
+    AttributeAccess access = GetAttributeAccess(blePeripheralManager, attributeHandle);
+    if (!access.attribute) {
+        SendResponse(blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_InvalidHandle, NULL, 0);
+        return;
+    }
+    if (!access.isWritable) {
+        SendResponse(
+                blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_WriteNotPermitted, NULL, 0);
+        return;
+    }
+    if (numPartBytes > (size_t) blePeripheralManager->central.mtu - 5) {
+        SendResponse(
+                blePeripheralManager,
+                opcode,
+                kHAPPlatformBLEPeripheralManagerSocketStatus_InvalidAttributeValueLength,
+                NULL,
+                0);
+        return;
+    }
+
+    // Only one attribute may be written at a time, and its parts must be sent in order.
+    if (blePeripheralManager->central.preparedValue.attributeHandle &&
+        blePeripheralManager->central.preparedValue.attributeHandle != attributeHandle) {
+        SendResponse(
+                blePeripheralManager,
+                opcode,
+                kHAPPlatformBLEPeripheralManagerSocketStatus_RequestNotSupported,
+                NULL,
+                0);
+        return;
+    }
+    if (offset != blePeripheralManager->central.preparedValue.numBytes) {
+        SendResponse(blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_InvalidOffset, NULL, 0);
+        return;
+    }
+    if (numPartBytes > sizeof blePeripheralManager->central.preparedValue.bytes - offset) {
+        SendResponse(
+                blePeripheralManager,
+                opcode,
+                kHAPPlatformBLEPeripheralManagerSocketStatus_InvalidAttributeValueLength,
+                NULL,
+                0);
+        return;
+    }
+    if (numPartBytes) {
+        HAPRawBufferCopyBytes(&blePeripheralManager->central.preparedValue.bytes[offset], &bytes[4], numPartBytes);
+    }
+    blePeripheralManager->central.preparedValue.attributeHandle = attributeHandle;
+    blePeripheralManager->central.preparedValue.numBytes += numPartBytes;
+    SendResponse(blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_Success, NULL, 0);
+}
+
+/**
+ * Handles an Execute Write request.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      opcode               Opcode.
+ * @param      bytes                Payload.
+ * @param      numBytes             Length of payload.
+ */
+static void HandleExecuteWrite(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        uint8_t opcode,
+        const uint8_t* bytes,
+        size_t numBytes) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(bytes);
+
+    if (numBytes != 1) {
+        SendResponse(blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_UnlikelyError, NULL, 0);
+        return;
+    }
+    HAPPlatformBLEPeripheralManagerSocketStatus status = kHAPPlatformBLEPeripheralManagerSocketStatus_Success;
+    HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle =
+            blePeripheralManager->central.preparedValue.attributeHandle;
+    size_t numValueBytes = blePeripheralManager->central.preparedValue.numBytes;
+    blePeripheralManager->central.preparedValue.attributeHandle = 0;
+    blePeripheralManager->central.preparedValue.numBytes = 0;
+    if ((bytes[0] & 0x01) && attributeHandle) {
+        status = WriteValue(
+                blePeripheralManager,
+                attributeHandle,
+                blePeripheralManager->central.preparedValue.bytes,
+                numValueBytes);
+    }
+    SendResponse(blePeripheralManager, opcode, status, NULL, 0);
+}
+
+/**
+ * Handles a Handle Value Confirmation.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ */
+static void HandleConfirmation(HAPPlatformBLEPeripheralManagerRef blePeripheralManager) {
+    HAPPrecondition(blePeripheralManager);
+
+    if (!blePeripheralManager->central.pendingIndicationHandle) {
+        HAPLog(&logObject, "Received unexpected Handle Value Confirmation. Disconnecting.");
+        ScheduleDisconnect(blePeripheralManager);
+        return;
+    }
+    blePeripheralManager->central.pendingIndicationHandle = 0;
+    if (blePeripheralManager->delegate.handleReadyToUpdateSubscribers) {
+        blePeripheralManager->delegate.handleReadyToUpdateSubscribers(
+                blePeripheralManager,
+                blePeripheralManager->central.connectionHandle,
+                blePeripheralManager->delegate.context);
+    }
+}
+
+/**
+ * Handles a Get Advertisement request.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      opcode               Opcode.
+ * @param      numBytes             Length of payload.
+ */
+static void HandleGetAdvertisement(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        uint8_t opcode,
+        size_t numBytes) {
+    HAPPrecondition(blePeripheralManager);
+
+    if (numBytes) {
+        SendResponse(blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_UnlikelyError, NULL, 0);
+        return;
+    }
+    if (!blePeripheralManager->advertisingInterval) {
+        SendResponse(
+                blePeripheralManager,
+                opcode,
+                kHAPPlatformBLEPeripheralManagerSocketStatus_RequestNotSupported,
+                NULL,
+                0);
+        return;
+    }
+
+    uint8_t bytes[2 + 1 + sizeof blePeripheralManager->advertisingBytes + 1 +
+                  sizeof blePeripheralManager->scanResponseBytes];
+    size_t o = 0;
+    HAPWriteLittleUInt16(&bytes[o], blePeripheralManager->advertisingInterval);
+    o += 2;
+    bytes[o++] = blePeripheralManager->numAdvertisingBytes;
+    HAPRawBufferCopyBytes(
+            &bytes[o], blePeripheralManager->advertisingBytes, blePeripheralManager->numAdvertisingBytes);
+    o += blePeripheralManager->numAdvertisingBytes;
+    bytes[o++] = blePeripheralManager->numScanResponseBytes;
+    HAPRawBufferCopyBytes(
+            &bytes[o], blePeripheralManager->scanResponseBytes, blePeripheralManager->numScanResponseBytes);
+    o += blePeripheralManager->numScanResponseBytes;
+    SendResponse(blePeripheralManager, opcode, kHAPPlatformBLEPeripheralManagerSocketStatus_Success, bytes, o);
+}
+
+/**
+ * Handles a frame that has been received from the central.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      opcode               Opcode.
+ * @param      bytes                Payload.
+ * @param      numBytes             Length of payload.
+ */
+static void HandleFrame(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        uint8_t opcode,
+        uint8_t* bytes,
+        size_t numBytes) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(bytes);
+
+    if (opcode == kHAPPlatformBLEPeripheralManagerSocketOpcode_GetAdvertisement) {
+        HandleGetAdvertisement(blePeripheralManager, opcode, numBytes);
+        return;
+    }
+    if (opcode == kHAPPlatformBLEPeripheralManagerSocketOpcode_Connect) {
+        HandleConnect(blePeripheralManager, opcode, numBytes);
+        return;
+    }
+    if (!blePeripheralManager->central.isConnected) {
+        SendResponse(
+                blePeripheralManager,
+                opcode,
+                kHAPPlatformBLEPeripheralManagerSocketStatus_RequestNotSupported,
+                NULL,
+                0);
+        return;
+    }
+    switch (opcode) {
+        case kHAPPlatformBLEPeripheralManagerSocketOpcode_ExchangeMTU: {
+            HandleExchangeMTU(blePeripheralManager, opcode, bytes, numBytes);
+        } break;
+        case kHAPPlatformBLEPeripheralManagerSocketOpcode_Discover: {
+            HandleDiscover(blePeripheralManager, opcode, bytes, numBytes);
+        } break;
+        case kHAPPlatformBLEPeripheralManagerSocketOpcode_Read: {
+            HandleRead(blePeripheralManager, opcode, bytes, numBytes);
+        } break;
+        case kHAPPlatformBLEPeripheralManagerSocketOpcode_Write: {
+            HandleWrite(blePeripheralManager, opcode, bytes, numBytes);
+        } break;
+        case kHAPPlatformBLEPeripheralManagerSocketOpcode_PrepareWrite: {
+            HandlePrepareWrite(blePeripheralManager, opcode, bytes, numBytes);
+        } break;
+        case kHAPPlatformBLEPeripheralManagerSocketOpcode_ExecuteWrite: {
+            HandleExecuteWrite(blePeripheralManager, opcode, bytes, numBytes);
+        } break;
+        case kHAPPlatformBLEPeripheralManagerSocketOpcode_Confirmation: {
+            HandleConfirmation(blePeripheralManager);
+        } break;
+        default: {
+            HAPLog(&logObject, "Received frame with unknown opcode 0x%02x.", opcode);
+            SendResponse(
+                    blePeripheralManager,
+                    opcode & ~kHAPPlatformBLEPeripheralManagerSocketOpcode_Response,
+                    kHAPPlatformBLEPeripheralManagerSocketStatus_RequestNotSupported,
+                    NULL,
+                    0);
+        } break;
+    }
+}
+
+/**
+ * Reads from the socket of the central and handles all complete frames.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ */
+static void ReceiveFrames(HAPPlatformBLEPeripheralManagerRef blePeripheralManager) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(blePeripheralManager->central.fileDescriptor != -1);
+
+    uint8_t* inboundBytes = blePeripheralManager->central.inboundBytes;
+    HAPAssert(blePeripheralManager->central.numInboundBytes < sizeof blePeripheralManager->central.inboundBytes);
+    ssize_t n;
+    do {
+        n = recv(
+                blePeripheralManager->central.fileDescriptor,
+                &inboundBytes[blePeripheralManager->central.numInboundBytes],
+                sizeof blePeripheralManager->central.inboundBytes - blePeripheralManager->central.numInboundBytes,
+                0);
+    } while (n == -1 && errno == EINTR);
+    if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return;
+    }
+    if (n <= 0) {
+        if (n == -1) {
+            HAPPlatformLogPOSIXError(
+                    kHAPLogType_Debug,
+                    "System call 'recv' on central socket failed.",
+                    errno,
+                    __func__,
+                    HAP_FILE,
+                    __LINE__);
+        }
+        DisconnectCentral(blePeripheralManager);
+        return;
+    }
+    blePeripheralManager->central.numInboundBytes += (size_t) n;
+
+    size_t o = 0;
+    while (!blePeripheralManager->central.disconnectTimer &&
+           blePeripheralManager->central.numInboundBytes - o >= kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes) {
+        uint8_t opcode = inboundBytes[o];
+        size_t numPayloadBytes = HAPReadLittleUInt16(&inboundBytes[o + 1]);
+        if (numPayloadBytes > kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes) {
+            HAPLog(&logObject, "Received frame that is too long (%zu bytes). Disconnecting.", numPayloadBytes);
+            ScheduleDisconnect(blePeripheralManager);
+            break;
+        }
+        if (blePeripheralManager->central.numInboundBytes - o <
+            kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes + numPayloadBytes) {
+            break;
+        }
+        HandleFrame(
+                blePeripheralManager,
+                opcode,
+                &inboundBytes[o + kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes],
+                numPayloadBytes);
+        if (blePeripheralManager->central.fileDescriptor == -1) {
+            return;
+        }
+        o += kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes + numPayloadBytes;
+    }
+    blePeripheralManager->central.numInboundBytes -= o;
+    HAPRawBufferCopyBytes(inboundBytes, &inboundBytes[o], blePeripheralManager->central.numInboundBytes);
+}
+
+static void HandleCentralFileHandleCallback(
+        HAPPlatformFileHandleRef fileHandle,
+        HAPPlatformFileHandleEvent fileHandleEvents,
+        void* _Nullable context) {
+    HAPPrecondition(context);
+    HAPPlatformBLEPeripheralManagerRef blePeripheralManager = context;
+    HAPPrecondition(fileHandle == blePeripheralManager->central.fileHandle);
+
+    if (fileHandleEvents.isReadyForWriting) {
+        FlushOutboundBytes(blePeripheralManager);
+    }
+    if (fileHandleEvents.isReadyForReading && blePeripheralManager->central.fileDescriptor != -1 &&
+        !blePeripheralManager->central.disconnectTimer) {
+        ReceiveFrames(blePeripheralManager);
+    }
+}
+
+static void HandleListenerFileHandleCallback(
+        HAPPlatformFileHandleRef fileHandle,
+        HAPPlatformFileHandleEvent fileHandleEvents,
+        void* _Nullable context) {
+    HAPPrecondition(context);
+    HAPPlatformBLEPeripheralManagerRef blePeripheralManager = context;
+    HAPPrecondition(fileHandle == blePeripheralManager->listener.fileHandle);
+
+    HAPError err;
+
+    if (!fileHandleEvents.isReadyForReading) {
+        return;
+    }
+
+    HAPLogDebug(&logObject, "accept(%d, NULL, NULL);", blePeripheralManager->listener.fileDescriptor);
+    int fileDescriptor = accept(blePeripheralManager->listener.fileDescriptor, NULL, NULL);
+    if (fileDescriptor == -1) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED) {
+            HAPPlatformLogPOSIXError(
+                    kHAPLogType_Error,
+                    "System call 'accept' on BLE peripheral manager socket failed.",
+                    errno,
+                    __func__,
+                    HAP_FILE,
+                    __LINE__);
+        }
+        return;
+    }
+
+    HAPAssert(blePeripheralManager->central.fileDescriptor == -1);
+
+    err = SetNonblocking(fileDescriptor);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        HAPLogError(&logObject, "Failed to configure central socket as non-blocking.");
+        (void) close(fileDescriptor);
+        return;
+    }
+
+    HAPPlatformFileHandleRef centralFileHandle;
+    err = HAPPlatformFileHandleRegister(
+            &centralFileHandle,
+            fileDescriptor,
+            (HAPPlatformFileHandleEvent) {
+                    .isReadyForReading = true, .isReadyForWriting = false, .hasErrorConditionPending = false },
+            HandleCentralFileHandleCallback,
+            blePeripheralManager);
+    if (err) {
+        HAPLogError(&logObject, "Failed to register central file handle.");
+        HAPFatalError();
+    }
+    HAPAssert(centralFileHandle);
+
+    InitializeCentral(blePeripheralManager);
+    blePeripheralManager->central.fileDescriptor = fileDescriptor;
+    blePeripheralManager->central.fileHandle = centralFileHandle;
+    HAPLogDebug(&logObject, "Central attached.");
+
+    // There is only one link.
+    SetAcceptingCentrals(blePeripheralManager, false);
+}
+
+void HAPPlatformBLEPeripheralManagerCreate(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        const HAPPlatformBLEPeripheralManagerOptions* options) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(options);
+
+    HAPError err;
+    int e;
+
+    HAPRawBufferZero(blePeripheralManager, sizeof *blePeripheralManager);
+    InitializeCentral(blePeripheralManager);
+
+    const char* socketPath =
+            options->socketPath ? HAPNonnull(options->socketPath) : kHAPPlatformBLEPeripheralManagerSocket_DefaultPath;
+    size_t numSocketPathBytes = HAPStringGetNumBytes(socketPath);
+    if (!numSocketPathBytes || numSocketPathBytes >= sizeof blePeripheralManager->socketPath) {
+        HAPLogError(&logObject, "Invalid socket path.");
+        HAPFatalError();
+    }
+    HAPRawBufferCopyBytes(blePeripheralManager->socketPath, socketPath, numSocketPathBytes);
+
+    int fileDescriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fileDescriptor == -1) {
+        HAPLogError(&logObject, "Failed to open BLE peripheral manager socket.");
+        HAPFatalError();
+    }
+
+    struct sockaddr_un sun;
+    HAPRawBufferZero(&sun, sizeof sun);
+    sun.sun_family = AF_UNIX;
+    HAPRawBufferCopyBytes(sun.sun_path, blePeripheralManager->socketPath, numSocketPathBytes);
+    (void) unlink(blePeripheralManager->socketPath);
+    HAPLogDebug(&logObject, "bind(%d, %s);", fileDescriptor, blePeripheralManager->socketPath);
+    e = bind(fileDescriptor, (struct sockaddr*) &sun, sizeof sun);
+    if (e != 0) {
+        int _errno = errno;
+        HAPAssert(e == -1);
+        HAPPlatformLogPOSIXError(
+                kHAPLogType_Error,
+                "System call 'bind' on BLE peripheral manager socket failed.",
+                _errno,
+                __func__,
+                HAP_FILE,
+                __LINE__);
+        HAPFatalError();
+    }
+    e = listen(fileDescriptor, 1);
+    if (e != 0) {
+        int _errno = errno;
+        HAPAssert(e == -1);
+        HAPPlatformLogPOSIXError(
+                kHAPLogType_Error,
+                "System call 'listen' on BLE peripheral manager socket failed.",
+                _errno,
+                __func__,
+                HAP_FILE,
+                __LINE__);
+        HAPFatalError();
+    }
+    err = SetNonblocking(fileDescriptor);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        HAPLogError(&logObject, "Failed to configure BLE peripheral manager socket as non-blocking.");
+        HAPFatalError();
+    }
+
+    HAPPlatformFileHandleRef fileHandle;
+    err = HAPPlatformFileHandleRegister(
+            &fileHandle,
+            fileDescriptor,
+            (HAPPlatformFileHandleEvent) {
+                    .isReadyForReading = true, .isReadyForWriting = false, .hasErrorConditionPending = false },
+            HandleListenerFileHandleCallback,
+            blePeripheralManager);
+    if (err) {
+        HAPLogError(&logObject, "Failed to register BLE peripheral manager file handle.");
+        HAPFatalError();
+    }
+    HAPAssert(fileHandle);
+
+    blePeripheralManager->listener.fileDescriptor = fileDescriptor;
+    blePeripheralManager->listener.fileHandle = fileHandle;
+    HAPLogInfo(&logObject, "Listening for centrals on %s.", blePeripheralManager->socketPath);
+}
+
+void HAPPlatformBLEPeripheralManagerRelease(HAPPlatformBLEPeripheralManagerRef blePeripheralManager) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(blePeripheralManager->listener.fileHandle);
+
+    DisconnectCentral(blePeripheralManager);
+
+    HAPPlatformFileHandleDeregister(blePeripheralManager->listener.fileHandle);
+    HAPLogDebug(&logObject, "close(%d);", blePeripheralManager->listener.fileDescriptor);
+    int e = close(blePeripheralManager->listener.fileDescriptor);
+    if (e != 0) {
+        int _errno = errno;
+        HAPAssert(e == -1);
+        HAPPlatformLogPOSIXError(
+                kHAPLogType_Debug,
+                "System call 'close' on BLE peripheral manager socket failed.",
+                _errno,
+                __func__,
+                HAP_FILE,
+                __LINE__);
+    }
+    (void) unlink(blePeripheralManager->socketPath);
+    blePeripheralManager->listener.fileDescriptor = -1;
+    blePeripheralManager->listener.fileHandle = 0;
+}
+
+void HAPPlatformBLEPeripheralManagerSetDelegate(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        const HAPPlatformBLEPeripheralManagerDelegate* _Nullable delegate) {
+    HAPPrecondition(blePeripheralManager);
+
+    if (delegate) {
+        blePeripheralManager->delegate = *delegate;
+    } else {
+        HAPRawBufferZero(&blePeripheralManager->delegate, sizeof blePeripheralManager->delegate);
+    }
+}
+
+void HAPPlatformBLEPeripheralManagerSetDeviceAddress(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        const HAPPlatformBLEPeripheralManagerDeviceAddress* deviceAddress) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(!blePeripheralManager->central.isConnected);
+    HAPPrecondition(deviceAddress);
+
+    blePeripheralManager->deviceAddress = *deviceAddress;
+    blePeripheralManager->isDeviceAddressSet = true;
+}
+
+void HAPPlatformBLEPeripheralManagerSetDeviceName(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        const char* deviceName) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(deviceName);
+
+    size_t numDeviceNameBytes = HAPStringGetNumBytes(deviceName);
+    HAPPrecondition(numDeviceNameBytes < sizeof blePeripheralManager->deviceName);
+
+    HAPRawBufferZero(blePeripheralManager->deviceName, sizeof blePeripheralManager->deviceName);
+    HAPRawBufferCopyBytes(blePeripheralManager->deviceName, deviceName, numDeviceNameBytes);
+}
+
+void HAPPlatformBLEPeripheralManagerRemoveAllServices(HAPPlatformBLEPeripheralManagerRef blePeripheralManager) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(!blePeripheralManager->central.isConnected);
+
+    HAPRawBufferZero(blePeripheralManager->attributes, sizeof blePeripheralManager->attributes);
+    blePeripheralManager->numAttributes = 0;
+    blePeripheralManager->didPublishAttributes = false;
+    blePeripheralManager->hasDatabaseFingerprint = false;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPPlatformBLEPeripheralManagerAddService(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        const HAPPlatformBLEPeripheralManagerUUID* type,
+        bool isPrimary) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(!blePeripheralManager->didPublishAttributes);
+    HAPPrecondition(type);
+
+    HAPError err;
+
+    HAPPlatformBLEPeripheralManagerAttribute* attribute;
+    err = AppendAttribute(blePeripheralManager, 1, &attribute);
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        return err;
+    }
+    attribute->type = *type;
+    attribute->attributeType = kHAPPlatformBLEPeripheralManagerAttributeType_Service;
+    if (isPrimary) {
+        attribute->properties |= kHAPPlatformBLEPeripheralManagerSocketProperty_Primary;
+    }
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPPlatformBLEPeripheralManagerAddCharacteristic(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        const HAPPlatformBLEPeripheralManagerUUID* type,
+        HAPPlatformBLEPeripheralManagerCharacteristicProperties properties,
+        const void* _Nullable constBytes,
+        size_t constNumBytes,
+        HAPPlatformBLEPeripheralManagerAttributeHandle* valueHandle,
+        HAPPlatformBLEPeripheralManagerAttributeHandle* _Nullable cccDescriptorHandle) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(!blePeripheralManager->didPublishAttributes);
+    HAPPrecondition(blePeripheralManager->numAttributes);
+    HAPPrecondition(type);
+    HAPPrecondition(!constNumBytes || constBytes);
+    HAPPrecondition(valueHandle);
+    if (properties.notify || properties.indicate) {
+        HAPPrecondition(cccDescriptorHandle);
+    } else {
+        HAPPrecondition(!cccDescriptorHandle);
+    }
+
+    HAPError err;
+
+    bool hasCCCDescriptor = properties.notify || properties.indicate;
+    HAPPlatformBLEPeripheralManagerAttribute* attribute;
+    err = AppendAttribute(blePeripheralManager, hasCCCDescriptor ? 3 : 2, &attribute);
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        return err;
+    }
+    err = SetConstValue(attribute, constBytes, constNumBytes);
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        blePeripheralManager->numAttributes--;
+        return err;
+    }
+    attribute->type = *type;
+    attribute->attributeType = kHAPPlatformBLEPeripheralManagerAttributeType_Characteristic;
+    attribute->valueHandle = (HAPPlatformBLEPeripheralManagerAttributeHandle)(attribute->handle + 1);
+    if (hasCCCDescriptor) {
+        attribute->cccDescriptorHandle = (HAPPlatformBLEPeripheralManagerAttributeHandle)(attribute->handle + 2);
+    }
+    if (properties.read) {
+        attribute->properties |= kHAPPlatformBLEPeripheralManagerSocketProperty_Read;
+    }
+    if (properties.writeWithoutResponse) {
+        attribute->properties |= kHAPPlatformBLEPeripheralManagerSocketProperty_WriteWithoutResponse;
+    }
+    if (properties.write) {
+        attribute->properties |= kHAPPlatformBLEPeripheralManagerSocketProperty_Write;
+    }
+    if (properties.notify) {
+        attribute->properties |= kHAPPlatformBLEPeripheralManagerSocketProperty_Notify;
+    }
+    if (properties.indicate) {
+        attribute->properties |= kHAPPlatformBLEPeripheralManagerSocketProperty_Indicate;
+    }
+
+    *valueHandle = attribute->valueHandle;
+    if (cccDescriptorHandle) {
+        *cccDescriptorHandle = attribute->cccDescriptorHandle;
+    }
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPPlatformBLEPeripheralManagerAddDescriptor(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        const HAPPlatformBLEPeripheralManagerUUID* type,
+        HAPPlatformBLEPeripheralManagerDescriptorProperties properties,
+        const void* _Nullable constBytes,
+        size_t constNumBytes,
+        HAPPlatformBLEPeripheralManagerAttributeHandle* descriptorHandle) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(!blePeripheralManager->didPublishAttributes);
+    HAPPrecondition(blePeripheralManager->numAttributes);
+    HAPPrecondition(
+            blePeripheralManager->attributes[blePeripheralManager->numAttributes - 1].attributeType !=
+            kHAPPlatformBLEPeripheralManagerAttributeType_Service);
+    HAPPrecondition(type);
+    HAPPrecondition(!constNumBytes || constBytes);
+    HAPPrecondition(descriptorHandle);
+
+    HAPError err;
+
+    HAPPlatformBLEPeripheralManagerAttribute* attribute;
+    err = AppendAttribute(blePeripheralManager, 1, &attribute);
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        return err;
+    }
+    err = SetConstValue(attribute, constBytes, constNumBytes);
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        blePeripheralManager->numAttributes--;
+        return err;
+    }
+    attribute->type = *type;
+    attribute->attributeType = kHAPPlatformBLEPeripheralManagerAttributeType_Descriptor;
+    if (properties.read) {
+        attribute->properties |= kHAPPlatformBLEPeripheralManagerSocketProperty_Read;
+    }
+    if (properties.write) {
+        attribute->properties |= kHAPPlatformBLEPeripheralManagerSocketProperty_Write;
+    }
+
+    *descriptorHandle = attribute->handle;
+    return kHAPError_None;
+}
+
+void HAPPlatformBLEPeripheralManagerPublishServices(HAPPlatformBLEPeripheralManagerRef blePeripheralManager) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(blePeripheralManager->isDeviceAddressSet);
+    HAPPrecondition(!blePeripheralManager->didPublishAttributes);
+
+    HAPLogInfo(
+            &logObject,
+            "Published GATT database (%zu attributes, %u handles).",
+            blePeripheralManager->numAttributes,
+            GetLastAttributeHandle(blePeripheralManager));
+    blePeripheralManager->didPublishAttributes = true;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPPlatformBLEPeripheralManagerPublishDatabase(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        const HAPPlatformBLEPeripheralManagerDatabaseFingerprint* fingerprint,
+        bool isUnchanged HAP_UNUSED,
+        HAPPlatformBLEPeripheralManagerGATTAttribute* attributes,
+        size_t numAttributes) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(blePeripheralManager->isDeviceAddressSet);
+    HAPPrecondition(!blePeripheralManager->central.isConnected);
+    HAPPrecondition(fingerprint);
+    HAPPrecondition(attributes);
+
+    HAPError err;
+
+    // Keep the published GATT database if its layout is unchanged.
+    // The GATT database is held in RAM, so it is only kept while the process is running.
+    if (blePeripheralManager->didPublishAttributes && blePeripheralManager->hasDatabaseFingerprint &&
+        HAPRawBufferAreEqual(
+                blePeripheralManager->databaseFingerprint.bytes, fingerprint->bytes, sizeof fingerprint->bytes)) {
+        HAPAssert(numAttributes == blePeripheralManager->numAttributes);
+        for (size_t i = 0; i < numAttributes; i++) {
+            HAPPlatformBLEPeripheralManagerGATTAttribute* attribute = &attributes[i];
+            const HAPPlatformBLEPeripheralManagerAttribute* publishedAttribute = &blePeripheralManager->attributes[i];
+            HAPAssert(HAPRawBufferAreEqual(
+                    publishedAttribute->type.bytes, attribute->type.bytes, sizeof attribute->type.bytes));
+
+            switch (attribute->kind) {
+                case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Service: {
+                    HAPAssert(
+                            publishedAttribute->attributeType == kHAPPlatformBLEPeripheralManagerAttributeType_Service);
+                } break;
+                case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Characteristic: {
+                    HAPAssert(
+                            publishedAttribute->attributeType ==
+                            kHAPPlatformBLEPeripheralManagerAttributeType_Characteristic);
+                    attribute->_.characteristic.valueHandle = publishedAttribute->valueHandle;
+                    attribute->_.characteristic.cccDescriptorHandle = publishedAttribute->cccDescriptorHandle;
+                } break;
+                case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Descriptor: {
+                    HAPAssert(
+                            publishedAttribute->attributeType ==
+                            kHAPPlatformBLEPeripheralManagerAttributeType_Descriptor);
+                    attribute->_.descriptor.descriptorHandle = publishedAttribute->handle;
+                } break;
+                default: {
+                    HAPFatalError();
+                }
+            }
+        }
+        HAPLogInfo(&logObject, "Kept published GATT database (%zu attributes).", numAttributes);
+        return kHAPError_None;
+    }
+
+    // Rebuild the GATT database in a single pass.
+    HAPPlatformBLEPeripheralManagerRemoveAllServices(blePeripheralManager);
+    for (size_t i = 0; i < numAttributes; i++) {
+        HAPPlatformBLEPeripheralManagerGATTAttribute* attribute = &attributes[i];
+
+        HAPPlatformBLEPeripheralManagerAttributeHandle numHandles = 1;
+        bool hasCCCDescriptor = false;
+        if (attribute->kind == kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Characteristic) {
+            hasCCCDescriptor =
+                    attribute->_.characteristic.properties.notify || attribute->_.characteristic.properties.indicate;
+            numHandles = hasCCCDescriptor ? 3 : 2;
+        }
+        HAPPlatformBLEPeripheralManagerAttribute* publishedAttribute;
+        err = AppendAttribute(blePeripheralManager, numHandles, &publishedAttribute);
+        if (!err && attribute->hasConstValue) {
+            err = SetConstValue(publishedAttribute, attribute->constBytes, attribute->numConstBytes);
+        }
+        if (err) {
+            HAPAssert(err == kHAPError_OutOfResources);
+            HAPPlatformBLEPeripheralManagerRemoveAllServices(blePeripheralManager);
+            return err;
+        }
+        publishedAttribute->type = attribute->type;
+
+        switch (attribute->kind) {
+            case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Service: {
+                publishedAttribute->attributeType = kHAPPlatformBLEPeripheralManagerAttributeType_Service;
+                if (attribute->_.service.isPrimary) {
+                    publishedAttribute->properties |= kHAPPlatformBLEPeripheralManagerSocketProperty_Primary;
+                }
+            } break;
+            case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Characteristic: {
+                HAPPrecondition(i);
+                HAPPlatformBLEPeripheralManagerCharacteristicProperties properties =
+                        attribute->_.characteristic.properties;
+                publishedAttribute->attributeType = kHAPPlatformBLEPeripheralManagerAttributeType_Characteristic;
+                publishedAttribute->valueHandle =
+                        (HAPPlatformBLEPeripheralManagerAttributeHandle)(publishedAttribute->handle + 1);
+                if (hasCCCDescriptor) {
+                    publishedAttribute->cccDescriptorHandle =
+                            (HAPPlatformBLEPeripheralManagerAttributeHandle)(publishedAttribute->handle + 2);
+                }
+                if (properties.read) {
+                    publishedAttribute->properties |= kHAPPlatformBLEPeripheralManagerSocketProperty_Read;
+                }
+                if (properties.writeWithoutResponse) {
+                    publishedAttribute->properties |=
+                            kHAPPlatformBLEPeripheralManagerSocketProperty_WriteWithoutResponse;
+                }
+                if (properties.write) {
+                    publishedAttribute->properties |= kHAPPlatformBLEPeripheralManagerSocketProperty_Write;
+                }
+                if (properties.notify) {
+                    publishedAttribute->properties |= kHAPPlatformBLEPeripheralManagerSocketProperty_Notify;
+                }
+                if (properties.indicate) {
+                    publishedAttribute->properties |= kHAPPlatformBLEPeripheralManagerSocketProperty_Indicate;
+                }
+
+                attribute->_.characteristic.valueHandle = publishedAttribute->valueHandle;
+                attribute->_.characteristic.cccDescriptorHandle = publishedAttribute->cccDescriptorHandle;
+            } break;
+            case kHAPPlatformBLEPeripheralManagerGATTAttributeKind_Descriptor: {
+                HAPPrecondition(
+                        i && blePeripheralManager->attributes[i - 1].attributeType !=
+                                     kHAPPlatformBLEPeripheralManagerAttributeType_Service);
+                publishedAttribute->attributeType = kHAPPlatformBLEPeripheralManagerAttributeType_Descriptor;
+                if (attribute->_.descriptor.properties.read) {
+                    publishedAttribute->properties |= kHAPPlatformBLEPeripheralManagerSocketProperty_Read;
+                }
+                if (attribute->_.descriptor.properties.write) {
+                    publishedAttribute->properties |= kHAPPlatformBLEPeripheralManagerSocketProperty_Write;
+                }
+
+                attribute->_.descriptor.descriptorHandle = publishedAttribute->handle;
+            } break;
+            default: {
+                HAPFatalError();
+            }
+        }
+    }
+    blePeripheralManager->databaseFingerprint = *fingerprint;
+    blePeripheralManager->hasDatabaseFingerprint = true;
+    HAPPlatformBLEPeripheralManagerPublishServices(blePeripheralManager);
+    return kHAPError_None;
+}
+
+void HAPPlatformBLEPeripheralManagerStartAdvertising(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        HAPBLEAdvertisingInterval advertisingInterval,
+        const void* advertisingBytes,
+        size_t numAdvertisingBytes,
+        const void* _Nullable scanResponseBytes,
+        size_t numScanResponseBytes) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(blePeripheralManager->isDeviceAddressSet);
+    HAPPrecondition(blePeripheralManager->didPublishAttributes);
+    HAPPrecondition(advertisingInterval);
+    HAPPrecondition(advertisingBytes);
+    HAPPrecondition(numAdvertisingBytes);
+    HAPPrecondition(numAdvertisingBytes <= sizeof blePeripheralManager->advertisingBytes);
+    HAPPrecondition(!numScanResponseBytes || scanResponseBytes);
+    HAPPrecondition(numScanResponseBytes <= sizeof blePeripheralManager->scanResponseBytes);
+
+    HAPRawBufferCopyBytes(blePeripheralManager->advertisingBytes, advertisingBytes, numAdvertisingBytes);
+    blePeripheralManager->numAdvertisingBytes = (uint8_t) numAdvertisingBytes;
+    if (numScanResponseBytes) {
+        HAPRawBufferCopyBytes(
+                blePeripheralManager->scanResponseBytes, HAPNonnullVoid(scanResponseBytes), numScanResponseBytes);
+    }
+    blePeripheralManager->numScanResponseBytes = (uint8_t) numScanResponseBytes;
+    blePeripheralManager->advertisingInterval = advertisingInterval;
+}
+
+void HAPPlatformBLEPeripheralManagerStopAdvertising(HAPPlatformBLEPeripheralManagerRef blePeripheralManager) {
+    HAPPrecondition(blePeripheralManager);
+
+    blePeripheralManager->numAdvertisingBytes = 0;
+    blePeripheralManager->numScanResponseBytes = 0;
+    blePeripheralManager->advertisingInterval = 0;
+}
+
+void HAPPlatformBLEPeripheralManagerCancelCentralConnection(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle) {
+    HAPPrecondition(blePeripheralManager);
+
+    if (!blePeripheralManager->central.isConnected ||
+        blePeripheralManager->central.connectionHandle != connectionHandle) {
+        HAPLog(&logObject, "Not disconnecting connection handle 0x%04x: Not connected.", connectionHandle);
+        return;
+    }
+    HAPLogInfo(&logObject, "Disconnecting central (connection handle 0x%04x).", connectionHandle);
+    ScheduleDisconnect(blePeripheralManager);
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPPlatformBLEPeripheralManagerSendHandleValueIndication(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle,
+        const void* _Nullable bytes,
+        size_t numBytes) HAP_DIAGNOSE_ERROR(!bytes && numBytes, "empty buffer cannot have a length") {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(valueHandle);
+    HAPPrecondition(!numBytes || bytes);
+    HAPPrecondition(numBytes <= kHAPPlatformBLEPeripheralManager_MaxAttributeBytes);
+
+    HAPError err;
+
+    if (!blePeripheralManager->central.isConnected ||
+        blePeripheralManager->central.connectionHandle != connectionHandle ||
+        blePeripheralManager->central.disconnectTimer) {
+        HAPLog(&logObject, "Not sending Handle Value Indication: Not connected.");
+        return kHAPError_InvalidState;
+    }
+    if (blePeripheralManager->central.pendingIndicationHandle) {
+        HAPLog(&logObject, "Handle Value Indication is awaiting confirmation.");
+        return kHAPError_InvalidState;
+    }
+    if (numBytes > (size_t) blePeripheralManager->central.mtu - 3) {
+        HAPLog(&logObject,
+               "Truncating Handle Value Indication to ATT_MTU - 3 (%zu / %u bytes).",
+               numBytes,
+               blePeripheralManager->central.mtu - 3);
+        numBytes = (size_t) blePeripheralManager->central.mtu - 3;
+    }
+
+    uint8_t frameBytes[2 + kHAPPlatformBLEPeripheralManager_MaxAttributeBytes];
+    HAPWriteLittleUInt16(frameBytes, valueHandle);
+    if (numBytes) {
+        HAPRawBufferCopyBytes(&frameBytes[2], HAPNonnullVoid(bytes), numBytes);
+    }
+    err = SendFrame(
+            blePeripheralManager, kHAPPlatformBLEPeripheralManagerSocketOpcode_Indication, frameBytes, 2 + numBytes);
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        return kHAPError_InvalidState;
+    }
+    HAPLogDebug(&logObject, "Sent Handle Value Indication for handle 0x%04x.", valueHandle);
+    blePeripheralManager->central.pendingIndicationHandle = valueHandle;
+    return kHAPError_None;
+}
@@ -216,15 +216,20 @@ HAPError HAPPlatformKeyValueStoreGet(
 
     HAPError err;
 
+    HAPTraceBegin(kHAPTraceEvent_KeyValueStoreGet, domain, key);
+
     // Get file name.
     char filePath[PATH_MAX];
     err = GetFilePath(keyValueStore, domain, key, filePath, sizeof filePath);
     if (err) {
         HAPAssert(err == kHAPError_OutOfResources);
+        HAPTraceEnd(kHAPTraceEvent_KeyValueStoreGet, domain, key);
         return kHAPError_Unknown;
     }
 
-    return HAPPlatformFileManagerReadFile(filePath, bytes, maxBytes, numBytes, found);
+    err = HAPPlatformFileManagerReadFile(filePath, bytes, maxBytes, numBytes, found);
+    HAPTraceEnd(kHAPTraceEvent_KeyValueStoreGet, domain, key);
+    return err;
 }
 
 HAP_RESULT_USE_CHECK
@@ -240,17 +245,21 @@ HAPError HAPPlatformKeyValueStoreSet(
 
     HAPError err;
 
+    HAPTraceBegin(kHAPTraceEvent_KeyValueStoreSet, domain, key);
+
     char filePath[PATH_MAX];
 
     // Get file name.
     err = GetFilePath(keyValueStore, domain, key, filePath, sizeof filePath);
     if (err) {
         HAPAssert(err == kHAPError_OutOfResources);
+        HAPTraceEnd(kHAPTraceEvent_KeyValueStoreSet, domain, key);
         return kHAPError_Unknown;
     }
 
     // Write the KVS file.
     err = HAPPlatformFileManagerWriteFile(filePath, bytes, numBytes);
+    HAPTraceEnd(kHAPTraceEvent_KeyValueStoreSet, domain, key);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return err;
@@ -269,17 +278,21 @@ HAPError HAPPlatformKeyValueStoreRemove(
 
     HAPError err;
 
+    HAPTraceBegin(kHAPTraceEvent_KeyValueStoreRemove, domain, key);
+
     char filePath[PATH_MAX];
 
     // Get file name.
     err = GetFilePath(keyValueStore, domain, key, filePath, sizeof filePath);
     if (err) {
         HAPAssert(err == kHAPError_OutOfResources);
+        HAPTraceEnd(kHAPTraceEvent_KeyValueStoreRemove, domain, key);
         return kHAPError_Unknown;
     }
 
     // Remove file.
     err = HAPPlatformFileManagerRemoveFile(filePath);
+    HAPTraceEnd(kHAPTraceEvent_KeyValueStoreRemove, domain, key);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return err;
@@ -381,6 +394,7 @@ HAPError HAPPlatformKeyValueStoreEnumerate(
     HAPPrecondition(keyValueStore->rootDirectory);
     HAPPrecondition(callback);
 
+    HAPTraceBegin(kHAPTraceEvent_KeyValueStoreEnumerate, domain, 0);
     int e =
             enumdir(keyValueStore->rootDirectory,
                     EnumdirCallback,
@@ -390,6 +404,7 @@ HAPError HAPPlatformKeyValueStoreEnumerate(
                             .body = callback,
                             .context = context,
                     });
+    HAPTraceEnd(kHAPTraceEvent_KeyValueStoreEnumerate, domain, 0);
     if (e) {
         HAPAssert(e == -1);
         return kHAPError_Unknown;
@@ -428,7 +443,9 @@ HAPError HAPPlatformKeyValueStorePurgeDomain(
 
     HAPError err;
 
+    HAPTraceBegin(kHAPTraceEvent_KeyValueStorePurgeDomain, domain, 0);
     err = HAPPlatformKeyValueStoreEnumerate(keyValueStore, domain, PurgeDomainEnumerateCallback, NULL);
+    HAPTraceEnd(kHAPTraceEvent_KeyValueStorePurgeDomain, domain, 0);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return err;
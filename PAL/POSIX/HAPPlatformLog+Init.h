@@ -17,6 +17,70 @@ extern "C" {
 #pragma clang assume_nonnull begin
 #endif
 
+/**
+ * Log output format.
+ */
+HAP_ENUM_BEGIN(uint8_t, HAPPlatformLogFormat) {
+    /** Human readable text with ANSI color codes. */
+    kHAPPlatformLogFormat_Text,
+
+    /** RFC 5424 syslog messages. The subsystem is reported as APP-NAME, the category as MSGID. */
+    kHAPPlatformLogFormat_Syslog,
+
+    /** Text with sd-daemon(3) priority prefixes, for stderr that is connected to systemd-journald. */
+    kHAPPlatformLogFormat_Journal
+} HAP_ENUM_END(uint8_t, HAPPlatformLogFormat);
+
+/**
+ * Log options.
+ */
+typedef struct {
+    /** Output format. */
+    HAPPlatformLogFormat format;
+
+    /**
+     * Whether log records should be written to stderr by a background thread.
+     *
+     * - Records are formatted on the logging thread and handed to the background thread through a lock-free queue.
+     *   The background thread writes batches of records with a single writev call.
+     *
+     * - When the queue is full, records are dropped and the number of dropped records is reported later.
+     *
+     * - Fault records are never dropped. They are written synchronously once all queued records have been written.
+     */
+    bool useBackgroundWriter;
+
+    /**
+     * Maximum number of records that are logged per second. 0 if unlimited.
+     *
+     * - Fault records are never rate limited.
+     */
+    uint32_t maxRecordsPerSecond;
+} HAPPlatformLogOptions;
+
+/**
+ * Configures logging.
+ *
+ * - Without configuration, records are written synchronously as text without rate limiting.
+ *
+ * - /!\ Must be called before other threads start logging.
+ *
+ * @param      options              Initialization options.
+ */
+void HAPPlatformLogCreate(const HAPPlatformLogOptions* options);
+
+/**
+ * Writes all queued records and stops the background writer, if any.
+ *
+ * - /!\ Must be called after other threads have stopped logging.
+ */
+void HAPPlatformLogRelease(void);
+
+/**
+ * Blocks until all queued records have been written.
+ */
+void HAPPlatformLogFlush(void);
+
 /**
  * Logs a POSIX error, for example fetched from errno.
  *
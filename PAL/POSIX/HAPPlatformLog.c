@@ -5,9 +5,15 @@
 // See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
 
 #include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
 #include <time.h>
+#include <unistd.h>
 #ifdef _WIN32
 #include <Windows.h>
 #else
@@ -28,6 +34,390 @@
 
 static const HAPLogObject logObject = { .subsystem = kHAPPlatform_LogSubsystem, .category = "Log" };
 
+/**
+ * Maximum number of bytes of a formatted log record that is handed to the background writer.
+ *
+ * - Longer records are written synchronously in chunks of this size.
+ */
+#define kHAPPlatformLog_MaxRecordBytes ((size_t) 2048)
+
+/**
+ * Number of records that may be queued for the background writer. Must be a power of two.
+ */
+#define kHAPPlatformLog_NumQueuedRecords ((uint32_t) 128)
+HAP_STATIC_ASSERT(
+        !(kHAPPlatformLog_NumQueuedRecords & (kHAPPlatformLog_NumQueuedRecords - 1)),
+        kHAPPlatformLog_NumQueuedRecords_IsPowerOfTwo);
+
+/**
+ * Maximum number of records that the background writer writes with a single writev call.
+ *
+ * - POSIX guarantees that writev accepts at least 16 buffers (_XOPEN_IOV_MAX).
+ */
+#define kHAPPlatformLog_MaxBatchRecords ((size_t) 16)
+
+/**
+ * Queued log record.
+ */
+typedef struct {
+    /**
+     * Sequence number of the slot.
+     *
+     * - Equal to the enqueue position when the slot is free.
+     * - Equal to the enqueue position + 1 when the slot holds a record.
+     */
+    uint32_t sequenceNumber;
+
+    /** Number of formatted bytes. */
+    uint32_t numBytes;
+
+    /** Formatted bytes. */
+    char bytes[kHAPPlatformLog_MaxRecordBytes];
+} HAPPlatformLogQueuedRecord;
+
+/**
+ * Log state.
+ */
+static struct {
+    /** Output format. */
+    HAPPlatformLogFormat format;
+
+    /** Maximum number of records that are logged per second. 0 if unlimited. */
+    uint32_t maxRecordsPerSecond;
+
+    /** Rate limiting state. */
+    struct {
+        /** Second for which records are being counted. */
+        uint64_t second;
+
+        /** Number of records that have been logged in the current second. */
+        uint32_t numRecords;
+    } rateLimit;
+
+    /** Number of records that have been dropped and not yet been reported. */
+    uint32_t numDroppedRecords;
+
+    /** Lock that serializes writes to stderr. */
+    volatile bool outputLock;
+
+    /** Background writer. */
+    struct {
+        /** Whether the background writer is running. */
+        bool isActive;
+
+        /** Queued records. Multiple producers, single consumer. */
+        HAPPlatformLogQueuedRecord* _Nullable records;
+
+        /** Position at which the next record is enqueued. */
+        uint32_t enqueuePosition;
+
+        /** Position from which the next record is dequeued. */
+        uint32_t dequeuePosition;
+
+        /** Thread. */
+        pthread_t thread;
+
+        /** Mutex protecting the wakeup condition. */
+        pthread_mutex_t mutex;
+
+        /** Condition that is signalled when the background writer is woken up. */
+        pthread_cond_t condition;
+
+        /** Whether the background writer is waiting for records. */
+        bool isSleeping;
+
+        /** Whether the background writer should exit once the queue is empty. */
+        bool shouldStop;
+    } writer;
+} logState = { .writer = { .mutex = PTHREAD_MUTEX_INITIALIZER, .condition = PTHREAD_COND_INITIALIZER } };
+
+/**
+ * Per-thread cache of the formatted time of the current second.
+ */
+static __thread struct {
+    /** Second that has been formatted. */
+    time_t second;
+
+    /** Broken-down UTC time. */
+    struct tm utc;
+
+    /** Whether the cache is valid. */
+    bool isValid;
+} timeCache;
+
+/**
+ * Per-thread buffer into which log records are formatted.
+ */
+static __thread char recordBuffer[kHAPPlatformLog_MaxRecordBytes];
+
+/**
+ * Writes bytes to stderr. Errors are ignored.
+ *
+ * @param      bytes                Bytes to write.
+ * @param      numBytes             Length of bytes.
+ */
+static void WriteBytes(const char* bytes, size_t numBytes) {
+    while (numBytes) {
+        ssize_t n = write(STDERR_FILENO, bytes, numBytes);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        bytes += n;
+        numBytes -= (size_t) n;
+    }
+}
+
+/**
+ * Writes a batch of buffers to stderr. Errors are ignored.
+ *
+ * @param      iov                  Buffers to write. Modified to track partial writes.
+ * @param      numIOV               Number of buffers.
+ */
+static void WriteBuffers(struct iovec* iov, int numIOV) {
+    while (numIOV) {
+        ssize_t n = writev(STDERR_FILENO, iov, numIOV);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        while (numIOV && (size_t) n >= iov->iov_len) {
+            n -= (ssize_t) iov->iov_len;
+            iov++;
+            numIOV--;
+        }
+        if (numIOV) {
+            iov->iov_base = (char*) iov->iov_base + n;
+            iov->iov_len -= (size_t) n;
+        }
+    }
+}
+
+static void AcquireOutputLock(void) {
+    while (__atomic_test_and_set(&logState.outputLock, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+}
+
+static void ReleaseOutputLock(void) {
+    __atomic_clear(&logState.outputLock, __ATOMIC_RELEASE);
+}
+
+/**
+ * Enqueues a formatted record for the background writer.
+ *
+ * @param      bytes                Formatted record.
+ * @param      numBytes             Length of formatted record.
+ *
+ * @return true                     If successful.
+ * @return false                    If the queue is full.
+ */
+HAP_RESULT_USE_CHECK
+static bool EnqueueRecord(const char* bytes, size_t numBytes) {
+    HAPPrecondition(numBytes <= kHAPPlatformLog_MaxRecordBytes);
+    HAPPrecondition(logState.writer.records);
+
+    // Claim a slot.
+    HAPPlatformLogQueuedRecord* record;
+    uint32_t position = __atomic_load_n(&logState.writer.enqueuePosition, __ATOMIC_RELAXED);
+    for (;;) {
+        record = &logState.writer.records[position & (kHAPPlatformLog_NumQueuedRecords - 1)];
+        uint32_t sequenceNumber = __atomic_load_n(&record->sequenceNumber, __ATOMIC_ACQUIRE);
+        int32_t difference = (int32_t)(sequenceNumber - position);
+        if (difference == 0) {
+            if (__atomic_compare_exchange_n(
+                        &logState.writer.enqueuePosition,
+                        &position,
+                        position + 1,
+                        /* weak: */ true,
+                        __ATOMIC_RELAXED,
+                        __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (difference < 0) {
+            return false;
+        } else {
+            position = __atomic_load_n(&logState.writer.enqueuePosition, __ATOMIC_RELAXED);
+        }
+    }
+
+    // Publish record.
+    HAPRawBufferCopyBytes(record->bytes, bytes, numBytes);
+    record->numBytes = (uint32_t) numBytes;
+    __atomic_store_n(&record->sequenceNumber, position + 1, __ATOMIC_RELEASE);
+
+    // Wake up background writer.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n(&logState.writer.isSleeping, false, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&logState.writer.mutex);
+        pthread_cond_signal(&logState.writer.condition);
+        pthread_mutex_unlock(&logState.writer.mutex);
+    }
+    return true;
+}
+
+/**
+ * Returns whether a record is ready to be dequeued at the given position.
+ *
+ * @param      position             Dequeue position.
+ * @param      memoryOrder          Memory order of the load.
+ *
+ * @return true                     If a record is ready.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool IsRecordReady(uint32_t position, int memoryOrder) {
+    HAPPrecondition(logState.writer.records);
+
+    const HAPPlatformLogQueuedRecord* record =
+            &logState.writer.records[position & (kHAPPlatformLog_NumQueuedRecords - 1)];
+    return __atomic_load_n(&record->sequenceNumber, memoryOrder) == position + 1;
+}
+
+/**
+ * Writes a note about records that have been dropped since the last note.
+ */
+static void ReportDroppedRecords(void) {
+    uint32_t numDroppedRecords = __atomic_exchange_n(&logState.numDroppedRecords, 0, __ATOMIC_RELAXED);
+    if (numDroppedRecords) {
+        char note[64];
+        int n = snprintf(note, sizeof note, "[%lu log records dropped]\n", (unsigned long) numDroppedRecords);
+        if (n > 0) {
+            WriteBytes(note, HAPMin((size_t) n, sizeof note - 1));
+        }
+    }
+}
+
+/**
+ * Background writer thread.
+ */
+static void* _Nullable WriterMain(void* _Nullable context HAP_UNUSED) {
+    for (;;) {
+        // Collect batch.
+        struct iovec iov[kHAPPlatformLog_MaxBatchRecords];
+        size_t numRecords = 0;
+        uint32_t position = logState.writer.dequeuePosition;
+        while (numRecords < kHAPPlatformLog_MaxBatchRecords && IsRecordReady(position, __ATOMIC_ACQUIRE)) {
+            HAPPlatformLogQueuedRecord* record =
+                    &logState.writer.records[position & (kHAPPlatformLog_NumQueuedRecords - 1)];
+            iov[numRecords].iov_base = record->bytes;
+            iov[numRecords].iov_len = record->numBytes;
+            numRecords++;
+            position++;
+        }
+
+        if (numRecords) {
+            // Write batch.
+            AcquireOutputLock();
+            WriteBuffers(iov, (int) numRecords);
+            ReportDroppedRecords();
+            ReleaseOutputLock();
+
+            // Release slots.
+            for (size_t i = 0; i < numRecords; i++) {
+                uint32_t dequeuePosition = logState.writer.dequeuePosition;
+                HAPPlatformLogQueuedRecord* record =
+                        &logState.writer.records[dequeuePosition & (kHAPPlatformLog_NumQueuedRecords - 1)];
+                __atomic_store_n(
+                        &record->sequenceNumber, dequeuePosition + kHAPPlatformLog_NumQueuedRecords, __ATOMIC_RELEASE);
+                __atomic_store_n(&logState.writer.dequeuePosition, dequeuePosition + 1, __ATOMIC_RELEASE);
+            }
+            continue;
+        }
+
+        // Wait for more records.
+        pthread_mutex_lock(&logState.writer.mutex);
+        __atomic_store_n(&logState.writer.isSleeping, true, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (IsRecordReady(logState.writer.dequeuePosition, __ATOMIC_SEQ_CST)) {
+            __atomic_store_n(&logState.writer.isSleeping, false, __ATOMIC_RELAXED);
+        } else if (logState.writer.shouldStop) {
+            pthread_mutex_unlock(&logState.writer.mutex);
+            break;
+        } else {
+            while (__atomic_load_n(&logState.writer.isSleeping, __ATOMIC_SEQ_CST)) {
+                pthread_cond_wait(&logState.writer.condition, &logState.writer.mutex);
+            }
+        }
+        pthread_mutex_unlock(&logState.writer.mutex);
+    }
+
+    AcquireOutputLock();
+    ReportDroppedRecords();
+    ReleaseOutputLock();
+    return NULL;
+}
+
+void HAPPlatformLogCreate(const HAPPlatformLogOptions* options) {
+    HAPPrecondition(options);
+    HAPPrecondition(!logState.writer.isActive);
+
+    logState.format = options->format;
+    logState.maxRecordsPerSecond = options->maxRecordsPerSecond;
+
+    if (options->useBackgroundWriter) {
+        logState.writer.records = calloc(kHAPPlatformLog_NumQueuedRecords, sizeof(HAPPlatformLogQueuedRecord));
+        if (!logState.writer.records) {
+            HAPLogError(&logObject, "Cannot allocate log queue: Continuing with synchronous logging.");
+            return;
+        }
+        for (uint32_t i = 0; i < kHAPPlatformLog_NumQueuedRecords; i++) {
+            logState.writer.records[i].sequenceNumber = i;
+        }
+        logState.writer.enqueuePosition = 0;
+        logState.writer.dequeuePosition = 0;
+        logState.writer.isSleeping = false;
+        logState.writer.shouldStop = false;
+
+        int e = pthread_create(&logState.writer.thread, /* attr: */ NULL, WriterMain, NULL);
+        if (e) {
+            HAPLogError(
+                    &logObject,
+                    "`pthread_create` failed to create log thread (%d): Continuing with synchronous logging.",
+                    e);
+            free(logState.writer.records);
+            logState.writer.records = NULL;
+            return;
+        }
+        __atomic_store_n(&logState.writer.isActive, true, __ATOMIC_RELEASE);
+    }
+}
+
+void HAPPlatformLogRelease(void) {
+    if (!logState.writer.isActive) {
+        return;
+    }
+
+    pthread_mutex_lock(&logState.writer.mutex);
+    logState.writer.shouldStop = true;
+    __atomic_store_n(&logState.writer.isSleeping, false, __ATOMIC_SEQ_CST);
+    pthread_cond_signal(&logState.writer.condition);
+    pthread_mutex_unlock(&logState.writer.mutex);
+
+    int e = pthread_join(logState.writer.thread, NULL);
+    if (e) {
+        HAPFatalError();
+    }
+
+    __atomic_store_n(&logState.writer.isActive, false, __ATOMIC_RELEASE);
+    free(logState.writer.records);
+    logState.writer.records = NULL;
+}
+
+void HAPPlatformLogFlush(void) {
+    if (!__atomic_load_n(&logState.writer.isActive, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    while (__atomic_load_n(&logState.writer.dequeuePosition, __ATOMIC_ACQUIRE) !=
+           __atomic_load_n(&logState.writer.enqueuePosition, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+}
+
 void HAPPlatformLogPOSIXError(
         HAPLogType type,
         const char* _Nonnull message,
@@ -78,6 +468,284 @@ HAPPlatformLogEnabledTypes HAPPlatformLogGetEnabledTypes(const HAPLogObject* _No
     }
 }
 
+/**
+ * Determines whether a record exceeds the rate limit.
+ *
+ * @param      type                 Log type.
+ *
+ * @return true                     If the record should be dropped.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool IsRateLimited(HAPLogType type) {
+    if (!logState.maxRecordsPerSecond || type == kHAPLogType_Fault) {
+        return false;
+    }
+
+    // HAPPlatformClockGetCurrent is not used as it may log itself.
+    struct timespec now;
+    if (clock_gettime(CLOCK_MONOTONIC, &now)) {
+        return false;
+    }
+
+    // Concurrent callers may briefly overshoot the limit when a new second starts.
+    uint64_t second = (uint64_t) now.tv_sec;
+    uint64_t currentSecond = __atomic_load_n(&logState.rateLimit.second, __ATOMIC_RELAXED);
+    if (second != currentSecond &&
+        __atomic_compare_exchange_n(
+                &logState.rateLimit.second,
+                &currentSecond,
+                second,
+                /* weak: */ false,
+                __ATOMIC_RELAXED,
+                __ATOMIC_RELAXED)) {
+        __atomic_store_n(&logState.rateLimit.numRecords, 0, __ATOMIC_RELAXED);
+    }
+    return __atomic_add_fetch(&logState.rateLimit.numRecords, 1, __ATOMIC_RELAXED) > logState.maxRecordsPerSecond;
+}
+
+/**
+ * Record writer. Formats a log record into the per-thread record buffer.
+ *
+ * - If the record does not fit into the record buffer it is written synchronously in chunks.
+ */
+typedef struct {
+    /** Number of formatted bytes in the record buffer. */
+    size_t numBytes;
+
+    /** Whether the record is being written synchronously and the output lock is held. */
+    bool isWritingSynchronously;
+} RecordWriter;
+
+/**
+ * Starts writing the current record synchronously.
+ *
+ * - Queued records are written first to preserve ordering.
+ *
+ * @param      writer               Record writer.
+ */
+static void BeginWritingSynchronously(RecordWriter* writer) {
+    HAPPrecondition(writer);
+    HAPPrecondition(!writer->isWritingSynchronously);
+
+    HAPPlatformLogFlush();
+    AcquireOutputLock();
+    writer->isWritingSynchronously = true;
+}
+
+static void AppendBytes(RecordWriter* writer, const char* bytes, size_t numBytes) {
+    HAPPrecondition(writer);
+    HAPPrecondition(bytes);
+
+    while (numBytes) {
+        if (writer->numBytes == sizeof recordBuffer) {
+            if (!writer->isWritingSynchronously) {
+                BeginWritingSynchronously(writer);
+            }
+            WriteBytes(recordBuffer, writer->numBytes);
+            writer->numBytes = 0;
+        }
+        size_t n = HAPMin(numBytes, sizeof recordBuffer - writer->numBytes);
+        HAPRawBufferCopyBytes(&recordBuffer[writer->numBytes], bytes, n);
+        writer->numBytes += n;
+        bytes += n;
+        numBytes -= n;
+    }
+}
+
+static void AppendString(RecordWriter* writer, const char* string) {
+    AppendBytes(writer, string, HAPStringGetNumBytes(string));
+}
+
+HAP_PRINTFLIKE(2, 3)
+static void AppendFormat(RecordWriter* writer, const char* format, ...) {
+    char bytes[64];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(bytes, sizeof bytes, format, args);
+    va_end(args);
+    if (n > 0) {
+        AppendBytes(writer, bytes, HAPMin((size_t) n, sizeof bytes - 1));
+    }
+}
+
+/**
+ * Appends the current UTC time.
+ *
+ * @param      writer               Record writer.
+ * @param      format               Log format.
+ */
+static void AppendTime(RecordWriter* writer, HAPPlatformLogFormat format) {
+#ifdef _WIN32
+    SYSTEMTIME now;
+    GetSystemTime(&now);
+    AppendFormat(
+            writer,
+            "%04d-%02d-%02d'T'%02d:%02d:%02d'Z'",
+            now.wYear,
+            now.wMonth,
+            now.wDay,
+            now.wHour,
+            now.wMinute,
+            now.wSecond);
+    (void) format;
+#else
+    struct timeval now;
+    int e = gettimeofday(&now, NULL);
+    if (e) {
+        AppendString(writer, format == kHAPPlatformLogFormat_Syslog ? "-" : "");
+        return;
+    }
+    if (!timeCache.isValid || timeCache.second != now.tv_sec) {
+        if (!gmtime_r(&now.tv_sec, &timeCache.utc)) {
+            timeCache.isValid = false;
+            AppendString(writer, format == kHAPPlatformLogFormat_Syslog ? "-" : "");
+            return;
+        }
+        timeCache.second = now.tv_sec;
+        timeCache.isValid = true;
+    }
+    const struct tm* gmt = &timeCache.utc;
+    if (format == kHAPPlatformLogFormat_Syslog) {
+        AppendFormat(
+                writer,
+                "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+                1900 + gmt->tm_year,
+                1 + gmt->tm_mon,
+                gmt->tm_mday,
+                gmt->tm_hour,
+                gmt->tm_min,
+                gmt->tm_sec,
+                (int) (now.tv_usec / 1000));
+    } else {
+        AppendFormat(
+                writer,
+                "%04d-%02d-%02d'T'%02d:%02d:%02d'Z'",
+                1900 + gmt->tm_year,
+                1 + gmt->tm_mon,
+                gmt->tm_mday,
+                gmt->tm_hour,
+                gmt->tm_min,
+                gmt->tm_sec);
+    }
+#endif
+}
+
+/**
+ * Gets the syslog severity of a log type.
+ *
+ * @param      type                 Log type.
+ *
+ * @return Syslog severity.
+ */
+HAP_RESULT_USE_CHECK
+static int GetSeverity(HAPLogType type) {
+    switch (type) {
+        case kHAPLogType_Debug: {
+            return 7; // debug
+        }
+        case kHAPLogType_Info: {
+            return 6; // info
+        }
+        case kHAPLogType_Default: {
+            return 5; // notice
+        }
+        case kHAPLogType_Error: {
+            return 3; // err
+        }
+        case kHAPLogType_Fault: {
+            return 2; // crit
+        }
+    }
+    HAPFatalError();
+}
+
+/**
+ * Appends the prefix of a line of a structured log record.
+ *
+ * @param      writer               Record writer.
+ * @param      log                  Log object.
+ * @param      type                 Log type.
+ * @param      format               Log format. Must be a structured format.
+ */
+static void AppendStructuredPrefix(
+        RecordWriter* writer,
+        const HAPLogObject* log,
+        HAPLogType type,
+        HAPPlatformLogFormat format) {
+    switch (format) {
+        case kHAPPlatformLogFormat_Syslog: {
+            // Facility user (1).
+            AppendFormat(writer, "<%d>1 ", 1 * 8 + GetSeverity(type));
+            AppendTime(writer, format);
+            AppendString(writer, " - ");
+            AppendString(writer, log->subsystem ? log->subsystem : "-");
+            AppendString(writer, " - ");
+            AppendString(writer, log->category ? log->category : "-");
+            AppendString(writer, " - ");
+        } break;
+        case kHAPPlatformLogFormat_Journal: {
+            AppendFormat(writer, "<%d>", GetSeverity(type));
+            if (log->subsystem) {
+                AppendString(writer, "[");
+                AppendString(writer, log->subsystem);
+                if (log->category) {
+                    AppendString(writer, ":");
+                    AppendString(writer, log->category);
+                }
+                AppendString(writer, "] ");
+            }
+        } break;
+        case kHAPPlatformLogFormat_Text: {
+            HAPFatalError();
+        }
+    }
+}
+
+/**
+ * Appends one line of a hex dump.
+ *
+ * @param      writer               Record writer.
+ * @param      bytes                Buffer.
+ * @param      numBytes             Length of buffer.
+ * @param      offset               Offset of the line within the buffer.
+ *
+ * @return Offset of the next line.
+ */
+HAP_RESULT_USE_CHECK
+static size_t AppendHexDumpLine(RecordWriter* writer, const uint8_t* bytes, size_t numBytes, size_t offset) {
+    static const char hexDigits[] = "0123456789abcdef";
+
+    char line[128];
+    size_t n = 0;
+    int e = snprintf(line, sizeof line, "    %04zx ", offset);
+    HAPAssert(e > 0 && (size_t) e < sizeof line);
+    n += (size_t) e;
+    for (size_t i = 0; i < 8 * 4; i++) {
+        if (i % 4 == 0) {
+            line[n++] = ' ';
+        }
+        if (offset + i < numBytes) {
+            line[n++] = hexDigits[bytes[offset + i] >> 4];
+            line[n++] = hexDigits[bytes[offset + i] & 0xF];
+        } else {
+            line[n++] = ' ';
+            line[n++] = ' ';
+        }
+    }
+    for (size_t i = 0; i < 4; i++) {
+        line[n++] = ' ';
+    }
+    for (size_t i = 0; i < 8 * 4 && offset != numBytes; i++) {
+        uint8_t c = bytes[offset++];
+        line[n++] = (32 <= c && c < 127) ? (char) c : '.';
+    }
+    line[n++] = '\n';
+    HAPAssert(n <= sizeof line);
+    AppendBytes(writer, line, n);
+    return offset;
+}
+
 void HAPPlatformLogCapture(
         const HAPLogObject* _Nonnull log,
         HAPLogType type,
@@ -88,144 +756,109 @@ void HAPPlatformLogCapture(
     HAPPrecondition(message);
     HAPPrecondition(!numBufferBytes || bufferBytes);
 
-    static volatile bool captureLock = 0;
-    while (__atomic_test_and_set(&captureLock, __ATOMIC_SEQ_CST))
-        ;
+    if (IsRateLimited(type)) {
+        __atomic_add_fetch(&logState.numDroppedRecords, 1, __ATOMIC_RELAXED);
+        return;
+    }
 
-    // Format log message.
-    bool logHandled = false;
+    HAPPlatformLogFormat format = logState.format;
+    RecordWriter writer = { .numBytes = 0, .isWritingSynchronously = false };
 
-    // Perform regular logging.
-    if (!logHandled) {
+    if (format == kHAPPlatformLogFormat_Text) {
         // Color.
         switch (type) {
             case kHAPLogType_Debug: {
-                fprintf(stderr, "\x1B[0m");
+                AppendString(&writer, "\x1B[0m");
             } break;
             case kHAPLogType_Info: {
-                fprintf(stderr, "\x1B[32m");
+                AppendString(&writer, "\x1B[32m");
             } break;
             case kHAPLogType_Default: {
-                fprintf(stderr, "\x1B[35m");
+                AppendString(&writer, "\x1B[35m");
             } break;
             case kHAPLogType_Error: {
-                fprintf(stderr, "\x1B[31m");
+                AppendString(&writer, "\x1B[31m");
             } break;
             case kHAPLogType_Fault: {
-                fprintf(stderr, "\x1B[1m\x1B[31m");
+                AppendString(&writer, "\x1B[1m\x1B[31m");
             } break;
         }
 
-// Time.
-#ifdef _WIN32
-        SYSTEMTIME now;
-        GetSystemTime(&now);
-        (void) fprintf(
-                stderr,
-                "%04d-%02d-%02d'T'%02d:%02d:%02d'Z'",
-                now.wYear,
-                now.wMonth,
-                now.wDay,
-                now.wHour,
-                now.wMinute,
-                now.wSecond);
-#else
-        struct timeval now;
-        int err = gettimeofday(&now, NULL);
-        if (!err) {
-            struct tm g;
-            struct tm* gmt = gmtime_r(&now.tv_sec, &g);
-            if (gmt) {
-                (void) fprintf(
-                        stderr,
-                        "%04d-%02d-%02d'T'%02d:%02d:%02d'Z'",
-                        1900 + gmt->tm_year,
-                        1 + gmt->tm_mon,
-                        gmt->tm_mday,
-                        gmt->tm_hour,
-                        gmt->tm_min,
-                        gmt->tm_sec);
-            }
-        }
-#endif
-        (void) fprintf(stderr, "\t");
+        // Time.
+        AppendTime(&writer, format);
+        AppendString(&writer, "\t");
 
         // Type.
         switch (type) {
             case kHAPLogType_Debug: {
-                (void) fprintf(stderr, "Debug");
+                AppendString(&writer, "Debug");
             } break;
             case kHAPLogType_Info: {
-                (void) fprintf(stderr, "Info");
+                AppendString(&writer, "Info");
             } break;
             case kHAPLogType_Default: {
-                (void) fprintf(stderr, "Default");
+                AppendString(&writer, "Default");
             } break;
             case kHAPLogType_Error: {
-                (void) fprintf(stderr, "Error");
+                AppendString(&writer, "Error");
             } break;
             case kHAPLogType_Fault: {
-                (void) fprintf(stderr, "Fault");
+                AppendString(&writer, "Fault");
             } break;
         }
-        (void) fprintf(stderr, "\t");
+        AppendString(&writer, "\t");
 
         // Subsystem / Category.
         if (log->subsystem) {
-            (void) fprintf(stderr, "[%s", log->subsystem);
+            AppendString(&writer, "[");
+            AppendString(&writer, log->subsystem);
             if (log->category) {
-                (void) fprintf(stderr, ":%s", log->category);
+                AppendString(&writer, ":");
+                AppendString(&writer, log->category);
             }
-            (void) fprintf(stderr, "] ");
-        }
-
-        // Message.
-        (void) fprintf(stderr, "%s", message);
-        (void) fprintf(stderr, "\n");
-
-        // Buffer.
-        if (bufferBytes) {
-            size_t i, n;
-            const uint8_t* b = bufferBytes;
-            size_t length = numBufferBytes;
-            if (length == 0) {
-                (void) fprintf(stderr, "\n");
-            } else {
-                i = 0;
-                do {
-                    (void) fprintf(stderr, "    %04zx ", i);
-                    for (n = 0; n != 8 * 4; n++) {
-                        if (n % 4 == 0) {
-                            (void) fprintf(stderr, " ");
-                        }
-                        if ((n <= length) && (i < length - n)) {
-                            (void) fprintf(stderr, "%02x", b[i + n] & 0xff);
-                        } else {
-                            (void) fprintf(stderr, "  ");
-                        }
-                    };
-                    (void) fprintf(stderr, "    ");
-                    for (n = 0; n != 8 * 4; n++) {
-                        if (i != length) {
-                            if ((32 <= b[i]) && (b[i] < 127)) {
-                                (void) fprintf(stderr, "%c", b[i]);
-                            } else {
-                                (void) fprintf(stderr, ".");
-                            }
-                            i++;
-                        }
-                    }
-                    (void) fprintf(stderr, "\n");
-                } while (i != length);
+            AppendString(&writer, "] ");
+        }
+    } else {
+        AppendStructuredPrefix(&writer, log, type, format);
+    }
+
+    // Message.
+    AppendString(&writer, message);
+    AppendString(&writer, "\n");
+
+    // Buffer.
+    if (bufferBytes) {
+        if (!numBufferBytes) {
+            if (format == kHAPPlatformLogFormat_Text) {
+                AppendString(&writer, "\n");
             }
+        } else {
+            size_t offset = 0;
+            do {
+                if (format != kHAPPlatformLogFormat_Text) {
+                    AppendStructuredPrefix(&writer, log, type, format);
+                }
+                offset = AppendHexDumpLine(&writer, bufferBytes, numBufferBytes, offset);
+            } while (offset != numBufferBytes);
         }
+    }
 
+    if (format == kHAPPlatformLogFormat_Text) {
         // Reset color.
-        fprintf(stderr, "\x1B[0m");
+        AppendString(&writer, "\x1B[0m");
     }
 
     // Finish log.
-    (void) fflush(stderr);
-
-    __atomic_clear(&captureLock, __ATOMIC_SEQ_CST);
+    if (!writer.isWritingSynchronously) {
+        if (type != kHAPLogType_Fault && __atomic_load_n(&logState.writer.isActive, __ATOMIC_ACQUIRE)) {
+            if (!EnqueueRecord(recordBuffer, writer.numBytes)) {
+                __atomic_add_fetch(&logState.numDroppedRecords, 1, __ATOMIC_RELAXED);
+            }
+            return;
+        }
+        BeginWritingSynchronously(&writer);
+    }
+    WriteBytes(recordBuffer, writer.numBytes);
+    ReportDroppedRecords();
+    ReleaseOutputLock();
 }
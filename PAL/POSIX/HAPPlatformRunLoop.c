@@ -284,7 +284,11 @@ static void ProcessSelectedFileHandles(
 
                 if (fileHandleEvents.isReadyForReading || fileHandleEvents.isReadyForWriting ||
                     fileHandleEvents.hasErrorConditionPending) {
+                    // The file handle may be deregistered by the callback.
+                    int fileDescriptor = fileHandle->fileDescriptor;
+                    HAPTraceBegin(kHAPTraceEvent_RunLoopFileHandle, fileDescriptor, 0);
                     fileHandle->callback((HAPPlatformFileHandleRef) fileHandle, fileHandleEvents, fileHandle->context);
+                    HAPTraceEnd(kHAPTraceEvent_RunLoopFileHandle, fileDescriptor, 0);
                 }
             }
         }
@@ -362,7 +366,9 @@ static void ProcessExpiredTimers(void) {
         runLoop.timers = runLoop.timers->nextTimer;
 
         // Invoke callback.
+        HAPTraceBegin(kHAPTraceEvent_RunLoopTimer, (uintptr_t) expiredTimer, 0);
         expiredTimer->callback((HAPPlatformTimerRef) expiredTimer, expiredTimer->context);
+        HAPTraceEnd(kHAPTraceEvent_RunLoopTimer, (uintptr_t) expiredTimer, 0);
 
         // Free memory.
         HAPPlatformFreeSafe(expiredTimer);
@@ -456,7 +462,9 @@ static void HandleSelfPipeFileHandleCallback(
         __atomic_signal_fence(__ATOMIC_SEQ_CST);
         __atomic_thread_fence(__ATOMIC_SEQ_CST);
 
+        HAPTraceBegin(kHAPTraceEvent_RunLoopCallback, contextSize, 0);
         callback(contextSize ? &runLoop.selfPipeBytes[0] : NULL, contextSize);
+        HAPTraceEnd(kHAPTraceEvent_RunLoopCallback, contextSize, 0);
 
         HAPRawBufferCopyBytes(
                 &runLoop.selfPipeBytes[0], &runLoop.selfPipeBytes[contextSize], runLoop.numSelfPipeBytes - contextSize);
@@ -0,0 +1,252 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+// Measures the encoders and decoders that are on the hot path of request processing:
+// TLV, JSON, HTTP, Base64, float conversion, UTF-8 validation and UUID formatting.
+//
+// The float and UUID benchmarks convert a fixed set of representative values per iteration.
+//
+// Results are printed as one JSON object per line.
+
+#include "HAP+Internal.h"
+
+#include "../Harness/HAPBench.c"
+
+#include "util_base64.h"
+#include "util_http_reader.h"
+#include "util_json_reader.h"
+
+static const char* const kBenchmark = "Codec";
+
+/** Scratch buffer into which results are written. */
+static uint8_t outputBytes[4096];
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/** TLV items resembling a Pair Setup M3 request. The public key is fragmented. */
+static uint8_t tlvPublicKey[384];
+static uint8_t tlvProof[64];
+static const uint8_t tlvState[] = { 3 };
+
+/** Serialized TLV items. */
+static uint8_t tlvBytes[512];
+static size_t numTLVBytes;
+
+/**
+ * Serializes the TLV items.
+ *
+ * @return Number of serialized bytes.
+ */
+HAP_RESULT_USE_CHECK
+static size_t EncodeTLV(void* bytes, size_t maxBytes) {
+    HAPError err;
+
+    HAPTLVWriterRef writer;
+    HAPTLVWriterCreate(&writer, bytes, maxBytes);
+    err = HAPTLVWriterAppend(
+            &writer, &(const HAPTLV) { .type = 0x06, .value = { .bytes = tlvState, .numBytes = sizeof tlvState } });
+    HAPBenchExpect(!err, "HAPTLVWriterAppend failed.");
+    err = HAPTLVWriterAppend(
+            &writer,
+            &(const HAPTLV) { .type = 0x03, .value = { .bytes = tlvPublicKey, .numBytes = sizeof tlvPublicKey } });
+    HAPBenchExpect(!err, "HAPTLVWriterAppend failed.");
+    err = HAPTLVWriterAppend(
+            &writer, &(const HAPTLV) { .type = 0x04, .value = { .bytes = tlvProof, .numBytes = sizeof tlvProof } });
+    HAPBenchExpect(!err, "HAPTLVWriterAppend failed.");
+
+    void* writtenBytes;
+    size_t numBytes;
+    HAPTLVWriterGetBuffer(&writer, &writtenBytes, &numBytes);
+    return numBytes;
+}
+
+static void WriteTLV(void* _Nullable context HAP_UNUSED) {
+    size_t numBytes = EncodeTLV(outputBytes, sizeof outputBytes);
+    HAPBenchExpect(numBytes == numTLVBytes, "Unexpected TLV length.");
+}
+
+static void ReadTLV(void* _Nullable context HAP_UNUSED) {
+    HAPError err;
+
+    // The reader merges fragments in place, so each iteration starts from a fresh copy.
+    HAPRawBufferCopyBytes(outputBytes, tlvBytes, numTLVBytes);
+    HAPTLVReaderRef reader;
+    HAPTLVReaderCreate(&reader, outputBytes, numTLVBytes);
+    size_t numTLVs = 0;
+    for (;;) {
+        bool found;
+        HAPTLV tlv;
+        err = HAPTLVReaderGetNext(&reader, &found, &tlv);
+        HAPBenchExpect(!err, "HAPTLVReaderGetNext failed.");
+        if (!found) {
+            break;
+        }
+        numTLVs++;
+    }
+    HAPBenchExpect(numTLVs == 3, "Unexpected number of TLV items.");
+}
+
+static void PrepareTLV(void) {
+    for (size_t i = 0; i < sizeof tlvPublicKey; i++) {
+        tlvPublicKey[i] = (uint8_t) i;
+    }
+    for (size_t i = 0; i < sizeof tlvProof; i++) {
+        tlvProof[i] = (uint8_t)(0xFF - i);
+    }
+    numTLVBytes = EncodeTLV(tlvBytes, sizeof tlvBytes);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/** Body of a PUT /characteristics request. */
+static const char jsonBytes[] =
+        "{\"characteristics\":["
+        "{\"aid\":1,\"iid\":9,\"value\":true},"
+        "{\"aid\":1,\"iid\":10,\"value\":42,\"ev\":true},"
+        "{\"aid\":1,\"iid\":11,\"value\":21.5},"
+        "{\"aid\":1,\"iid\":12,\"value\":\"Living Room\",\"r\":true}"
+        "],\"pid\":11122333}";
+
+static void ReadJSON(void* _Nullable context HAP_UNUSED) {
+    struct util_json_reader reader;
+    util_json_reader_init(&reader);
+    size_t numBytes = 0;
+    while (numBytes < sizeof jsonBytes - 1) {
+        numBytes += util_json_reader_read(&reader, &jsonBytes[numBytes], sizeof jsonBytes - 1 - numBytes);
+        HAPBenchExpect(reader.state != util_JSON_READER_STATE_ERROR, "Malformed JSON.");
+    }
+    HAPBenchExpect(reader.state == util_JSON_READER_STATE_COMPLETED_OBJECT, "Incomplete JSON.");
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/** HTTP request header. */
+static const char httpBytes[] =
+        "PUT /characteristics HTTP/1.1\r\n"
+        "Host: Acme-Light-Bulb._hap._tcp.local\r\n"
+        "Content-Type: application/hap+json\r\n"
+        "Content-Length: 210\r\n"
+        "\r\n";
+
+static void ReadHTTP(void* _Nullable context HAP_UNUSED) {
+    // The reader does not modify the buffer but its interface is not const-qualified.
+    HAPRawBufferCopyBytes(outputBytes, httpBytes, sizeof httpBytes - 1);
+    struct util_http_reader reader;
+    util_http_reader_init(&reader, util_HTTP_READER_TYPE_REQUEST);
+    size_t numBytes = 0;
+    while (reader.state != util_HTTP_READER_STATE_DONE) {
+        HAPBenchExpect(numBytes < sizeof httpBytes - 1, "Incomplete HTTP request.");
+        numBytes += util_http_reader_read(&reader, (char*) &outputBytes[numBytes], sizeof httpBytes - 1 - numBytes);
+        HAPBenchExpect(reader.state != util_HTTP_READER_STATE_ERROR, "Malformed HTTP request.");
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/** Data to Base64 encode. */
+static uint8_t base64Data[768];
+
+/** Base64 encoded data. */
+static char base64Bytes[util_base64_encoded_len(sizeof base64Data)];
+
+static void EncodeBase64(void* _Nullable context HAP_UNUSED) {
+    size_t numBytes;
+    util_base64_encode(base64Data, sizeof base64Data, (char*) outputBytes, sizeof outputBytes, &numBytes);
+}
+
+static void DecodeBase64(void* _Nullable context HAP_UNUSED) {
+    size_t numBytes;
+    HAPError err = util_base64_decode(base64Bytes, sizeof base64Bytes, outputBytes, sizeof outputBytes, &numBytes);
+    HAPBenchExpect(!err && numBytes == sizeof base64Data, "util_base64_decode failed.");
+}
+
+static void PrepareBase64(void) {
+    for (size_t i = 0; i < sizeof base64Data; i++) {
+        base64Data[i] = (uint8_t)(i * 7);
+    }
+    size_t numBytes;
+    util_base64_encode(base64Data, sizeof base64Data, base64Bytes, sizeof base64Bytes, &numBytes);
+    HAPBenchExpect(numBytes == sizeof base64Bytes, "util_base64_encode failed.");
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/** Float values as they typically appear in characteristic values. */
+static const float floatValues[] = { 0.0F, 1.0F, 21.5F, -12.25F, 100.0F, 0.1F, 3.14159274F, 1e-7F };
+
+static const char* const floatDescriptions[] = { "0", "1", "21.5", "-12.25", "100", "0.1", "3.14159274", "1e-07" };
+
+static void GetFloatDescriptions(void* _Nullable context HAP_UNUSED) {
+    for (size_t i = 0; i < HAPArrayCount(floatValues); i++) {
+        HAPError err = HAPFloatGetDescription((char*) outputBytes, sizeof outputBytes, floatValues[i]);
+        HAPBenchExpect(!err, "HAPFloatGetDescription failed.");
+    }
+}
+
+static void ParseFloats(void* _Nullable context HAP_UNUSED) {
+    for (size_t i = 0; i < HAPArrayCount(floatDescriptions); i++) {
+        float value;
+        HAPError err = HAPFloatFromString(floatDescriptions[i], &value);
+        HAPBenchExpect(!err, "HAPFloatFromString failed.");
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/** Mix of ASCII and multi-byte UTF-8 sequences. */
+static uint8_t utf8Bytes[1024];
+
+static void ValidateUTF8(void* _Nullable context HAP_UNUSED) {
+    HAPBenchExpect(HAPUTF8IsValidData(utf8Bytes, sizeof utf8Bytes), "Invalid UTF-8.");
+}
+
+/** "Wohnzimmer Lampe " followed by "ü" (2 bytes), "€" (3 bytes) and "🏠" (4 bytes). */
+static const char utf8Pattern[] = "Wohnzimmer Lampe \xC3\xBC\xE2\x82\xAC\xF0\x9F\x8F\xA0 ";
+
+static void PrepareUTF8(void) {
+    size_t numPatternBytes = sizeof utf8Pattern - 1;
+    size_t i = 0;
+    for (; i + numPatternBytes <= sizeof utf8Bytes; i += numPatternBytes) {
+        HAPRawBufferCopyBytes(&utf8Bytes[i], utf8Pattern, numPatternBytes);
+    }
+    for (; i < sizeof utf8Bytes; i++) {
+        utf8Bytes[i] = ' ';
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static const HAPUUID customUUID = { { 0x91, 0x52, 0x76, 0xBB, 0x26, 0x00, 0x00, 0x80,
+                                      0x00, 0x10, 0x00, 0x00, 0x78, 0x56, 0x34, 0x12 } };
+
+static void GetUUIDDescriptions(void* _Nullable context HAP_UNUSED) {
+    HAPError err;
+    err = HAPUUIDGetDescription(&kHAPServiceType_LightBulb, (char*) outputBytes, sizeof outputBytes);
+    HAPBenchExpect(!err, "HAPUUIDGetDescription failed.");
+    err = HAPUUIDGetDescription(&customUUID, (char*) outputBytes, sizeof outputBytes);
+    HAPBenchExpect(!err, "HAPUUIDGetDescription failed.");
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main() {
+    PrepareTLV();
+    PrepareBase64();
+    PrepareUTF8();
+
+    HAPBenchRun(kBenchmark, NULL, "TLVWriter", numTLVBytes, WriteTLV, NULL);
+    HAPBenchRun(kBenchmark, NULL, "TLVReader", numTLVBytes, ReadTLV, NULL);
+    HAPBenchRun(kBenchmark, NULL, "JSONReader", sizeof jsonBytes - 1, ReadJSON, NULL);
+    HAPBenchRun(kBenchmark, NULL, "HTTPReader", sizeof httpBytes - 1, ReadHTTP, NULL);
+    HAPBenchRun(kBenchmark, NULL, "Base64Encode", sizeof base64Data, EncodeBase64, NULL);
+    HAPBenchRun(kBenchmark, NULL, "Base64Decode", sizeof base64Bytes, DecodeBase64, NULL);
+    HAPBenchRun(kBenchmark, NULL, "FloatGetDescription", 0, GetFloatDescriptions, NULL);
+    HAPBenchRun(kBenchmark, NULL, "FloatFromString", 0, ParseFloats, NULL);
+    HAPBenchRun(kBenchmark, NULL, "UTF8IsValidData", sizeof utf8Bytes, ValidateUTF8, NULL);
+    HAPBenchRun(kBenchmark, NULL, "UUIDGetDescription", 0, GetUUIDDescriptions, NULL);
+
+    return 0;
+}
@@ -0,0 +1,350 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+// Measures the HAP_* crypto primitives of a crypto backend.
+//
+// The benchmark is built and run once for each crypto backend that is supported on the platform.
+// The backend is reported as the extension of the executable name, e.g. "OpenSSL" or "MbedTLS".
+//
+// Results are printed as one JSON object per line.
+
+#include "HAP+Internal.h"
+
+#include "../Harness/HAPBench.c"
+
+static const char* const kBenchmark = "Crypto";
+
+/** Name of the crypto backend. */
+static const char* backend;
+
+/** Message sizes for bulk operations. 1024 bytes is the maximum IP security protocol frame length. */
+static const size_t messageSizes[] = { 64, 1024 };
+
+static uint8_t message[1024];
+static uint8_t output[1024];
+static const uint8_t key[32] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B,
+                                 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16,
+                                 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20 };
+static const uint8_t nonce[CHACHA20_POLY1305_NONCE_BYTES_MAX] = { 0 };
+static const uint8_t aad[] = "Pair-Verify-Encrypt-Salt";
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void SHA1(void* _Nullable context) {
+    uint8_t md[SHA1_BYTES];
+    HAP_sha1(md, message, *(const size_t*) context);
+}
+
+static void SHA256(void* _Nullable context) {
+    uint8_t md[SHA256_BYTES];
+    HAP_sha256(md, message, *(const size_t*) context);
+}
+
+static void SHA512(void* _Nullable context) {
+    uint8_t md[SHA512_BYTES];
+    HAP_sha512(md, message, *(const size_t*) context);
+}
+
+static void HMACSHA1(void* _Nullable context) {
+    uint8_t r[HMAC_SHA1_BYTES];
+    HAP_hmac_sha1_aad(r, key, sizeof key, message, *(const size_t*) context, aad, sizeof aad - 1);
+}
+
+static void HKDFSHA512(void* _Nullable context HAP_UNUSED) {
+    uint8_t r[32];
+    HAP_hkdf_sha512(r, sizeof r, key, sizeof key, aad, sizeof aad - 1, aad, sizeof aad - 1);
+}
+
+static void PBKDF2HMACSHA1(void* _Nullable context HAP_UNUSED) {
+    uint8_t r[32];
+    HAP_pbkdf2_hmac_sha1(r, sizeof r, key, sizeof key, aad, sizeof aad - 1, /* count: */ 1000);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void ChaCha20Poly1305Encrypt(void* _Nullable context) {
+    uint8_t tag[CHACHA20_POLY1305_TAG_BYTES];
+    HAP_chacha20_poly1305_encrypt(tag, output, message, *(const size_t*) context, nonce, sizeof nonce, key);
+}
+
+static void ChaCha20Poly1305EncryptAAD(void* _Nullable context) {
+    uint8_t tag[CHACHA20_POLY1305_TAG_BYTES];
+    HAP_chacha20_poly1305_encrypt_aad(
+            tag, output, message, *(const size_t*) context, aad, sizeof aad - 1, nonce, sizeof nonce, key);
+}
+
+/** Ciphertext and tags of the message, for each message size. */
+static uint8_t ciphertexts[HAPArrayCount(messageSizes)][sizeof message];
+static uint8_t tags[HAPArrayCount(messageSizes)][CHACHA20_POLY1305_TAG_BYTES];
+static uint8_t aadTags[HAPArrayCount(messageSizes)][CHACHA20_POLY1305_TAG_BYTES];
+
+static void ChaCha20Poly1305Decrypt(void* _Nullable context) {
+    size_t i = *(const size_t*) context;
+    int e = HAP_chacha20_poly1305_decrypt(tags[i], output, ciphertexts[i], messageSizes[i], nonce, sizeof nonce, key);
+    HAPBenchExpect(!e, "HAP_chacha20_poly1305_decrypt failed.");
+}
+
+static void ChaCha20Poly1305DecryptAAD(void* _Nullable context) {
+    size_t i = *(const size_t*) context;
+    int e = HAP_chacha20_poly1305_decrypt_aad(
+            aadTags[i], output, ciphertexts[i], messageSizes[i], aad, sizeof aad - 1, nonce, sizeof nonce, key);
+    HAPBenchExpect(!e, "HAP_chacha20_poly1305_decrypt_aad failed.");
+}
+
+static void ChaCha20Poly1305Streaming(void* _Nullable context) {
+    size_t numBytes = *(const size_t*) context;
+    HAP_chacha20_poly1305_ctx ctx;
+    uint8_t tag[CHACHA20_POLY1305_TAG_BYTES];
+    HAP_chacha20_poly1305_init(&ctx, nonce, sizeof nonce, key);
+    HAP_chacha20_poly1305_update_enc_aad(&ctx, aad, sizeof aad - 1, nonce, sizeof nonce, key);
+    HAP_chacha20_poly1305_update_enc(&ctx, output, message, numBytes / 2, nonce, sizeof nonce, key);
+    HAP_chacha20_poly1305_update_enc(
+            &ctx, &output[numBytes / 2], &message[numBytes / 2], numBytes - numBytes / 2, nonce, sizeof nonce, key);
+    HAP_chacha20_poly1305_final_enc(&ctx, tag);
+
+    HAP_chacha20_poly1305_init(&ctx, nonce, sizeof nonce, key);
+    HAP_chacha20_poly1305_update_dec_aad(&ctx, aad, sizeof aad - 1, nonce, sizeof nonce, key);
+    HAP_chacha20_poly1305_update_dec(&ctx, output, output, numBytes, nonce, sizeof nonce, key);
+    int e = HAP_chacha20_poly1305_final_dec(&ctx, tag);
+    HAPBenchExpect(!e, "HAP_chacha20_poly1305_final_dec failed.");
+}
+
+static void AESCTR(void* _Nullable context) {
+    size_t numBytes = *(const size_t*) context;
+    static const uint8_t iv[16] = { 0 };
+    HAP_aes_ctr_ctx ctx;
+    HAP_aes_ctr_init(&ctx, key, 16, iv);
+    HAP_aes_ctr_encrypt(&ctx, output, message, numBytes);
+    HAP_aes_ctr_done(&ctx);
+
+    HAP_aes_ctr_init(&ctx, key, 16, iv);
+    HAP_aes_ctr_decrypt(&ctx, output, output, numBytes);
+    HAP_aes_ctr_done(&ctx);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static uint8_t ed25519PublicKey[ED25519_PUBLIC_KEY_BYTES];
+static uint8_t ed25519Signature[ED25519_BYTES];
+
+static void Ed25519PublicKey(void* _Nullable context HAP_UNUSED) {
+    uint8_t pk[ED25519_PUBLIC_KEY_BYTES];
+    HAP_ed25519_public_key(pk, key);
+}
+
+static void Ed25519Sign(void* _Nullable context HAP_UNUSED) {
+    uint8_t sig[ED25519_BYTES];
+    HAP_ed25519_sign(sig, message, 64, key, ed25519PublicKey);
+}
+
+static void Ed25519Verify(void* _Nullable context HAP_UNUSED) {
+    int e = HAP_ed25519_verify(ed25519Signature, message, 64, ed25519PublicKey);
+    HAPBenchExpect(!e, "HAP_ed25519_verify failed.");
+}
+
+static uint8_t x25519PublicKey[X25519_BYTES];
+
+static void X25519ScalarMultBase(void* _Nullable context HAP_UNUSED) {
+    uint8_t r[X25519_BYTES];
+    HAP_X25519_scalarmult_base(r, key);
+}
+
+static void X25519ScalarMult(void* _Nullable context HAP_UNUSED) {
+    uint8_t r[X25519_BYTES];
+    HAP_X25519_scalarmult(r, key, x25519PublicKey);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static const uint8_t srpUser[] = "Pair-Setup";
+static const uint8_t srpPassword[] = "111-22-333";
+static uint8_t srpSalt[SRP_SALT_BYTES];
+static uint8_t srpVerifier[SRP_VERIFIER_BYTES];
+static uint8_t srpPublicKeyA[SRP_PUBLIC_KEY_BYTES];
+static uint8_t srpPublicKeyB[SRP_PUBLIC_KEY_BYTES];
+static uint8_t srpScramblingParameter[SRP_SCRAMBLING_PARAMETER_BYTES];
+static uint8_t srpPremasterSecret[SRP_PREMASTER_SECRET_BYTES];
+static uint8_t srpSessionKey[SRP_SESSION_KEY_BYTES];
+static uint8_t srpProofM1[SRP_PROOF_BYTES];
+
+static void SRPVerifier(void* _Nullable context HAP_UNUSED) {
+    uint8_t v[SRP_VERIFIER_BYTES];
+    HAP_srp_verifier(v, srpSalt, srpUser, sizeof srpUser - 1, srpPassword, sizeof srpPassword - 1);
+}
+
+static void SRPPublicKey(void* _Nullable context HAP_UNUSED) {
+    uint8_t b[SRP_PUBLIC_KEY_BYTES];
+    HAP_srp_public_key(b, key, srpVerifier);
+}
+
+static void SRPScramblingParameter(void* _Nullable context HAP_UNUSED) {
+    uint8_t u[SRP_SCRAMBLING_PARAMETER_BYTES];
+    HAP_srp_scrambling_parameter(u, srpPublicKeyA, srpPublicKeyB);
+}
+
+static void SRPPremasterSecret(void* _Nullable context HAP_UNUSED) {
+    uint8_t s[SRP_PREMASTER_SECRET_BYTES];
+    int e = HAP_srp_premaster_secret(s, srpPublicKeyA, key, srpScramblingParameter, srpVerifier);
+    HAPBenchExpect(!e, "HAP_srp_premaster_secret failed.");
+}
+
+static void SRPSessionKey(void* _Nullable context HAP_UNUSED) {
+    uint8_t k[SRP_SESSION_KEY_BYTES];
+    HAP_srp_session_key(k, srpPremasterSecret);
+}
+
+static void SRPProofM1(void* _Nullable context HAP_UNUSED) {
+    uint8_t m1[SRP_PROOF_BYTES];
+    HAP_srp_proof_m1(m1, srpUser, sizeof srpUser - 1, srpSalt, srpPublicKeyA, srpPublicKeyB, srpSessionKey);
+}
+
+static void SRPProofM2(void* _Nullable context HAP_UNUSED) {
+    uint8_t m2[SRP_PROOF_BYTES];
+    HAP_srp_proof_m2(m2, srpPublicKeyA, srpProofM1, srpSessionKey);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void ConstantTimeEqual(void* _Nullable context) {
+    size_t numBytes = *(const size_t*) context;
+    HAPBenchExpect(HAP_constant_time_equal(message, message, numBytes), "HAP_constant_time_equal failed.");
+}
+
+static void ConstantTimeIsZero(void* _Nullable context) {
+    size_t numBytes = *(const size_t*) context;
+    HAPBenchExpect(!HAP_constant_time_is_zero(message, numBytes), "HAP_constant_time_is_zero failed.");
+}
+
+static void ConstantTimeFillZero(void* _Nullable context) {
+    HAP_constant_time_fill_zero(output, *(const size_t*) context);
+}
+
+static void ConstantTimeCopy(void* _Nullable context) {
+    HAP_constant_time_copy(output, message, *(const size_t*) context);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void Prepare(void) {
+    for (size_t i = 0; i < sizeof message; i++) {
+        message[i] = (uint8_t)(i * 13 + 1);
+    }
+
+    for (size_t i = 0; i < HAPArrayCount(messageSizes); i++) {
+        HAP_chacha20_poly1305_encrypt(tags[i], ciphertexts[i], message, messageSizes[i], nonce, sizeof nonce, key);
+        HAP_chacha20_poly1305_encrypt_aad(
+                aadTags[i], output, message, messageSizes[i], aad, sizeof aad - 1, nonce, sizeof nonce, key);
+    }
+
+    HAP_ed25519_public_key(ed25519PublicKey, key);
+    HAP_ed25519_sign(ed25519Signature, message, 64, key, ed25519PublicKey);
+
+    uint8_t x25519SecretKey[X25519_SCALAR_BYTES];
+    for (size_t i = 0; i < sizeof x25519SecretKey; i++) {
+        x25519SecretKey[i] = (uint8_t)(0xA0 + i);
+    }
+    HAP_X25519_scalarmult_base(x25519PublicKey, x25519SecretKey);
+
+    for (size_t i = 0; i < sizeof srpSalt; i++) {
+        srpSalt[i] = (uint8_t) i;
+    }
+    HAP_srp_verifier(srpVerifier, srpSalt, srpUser, sizeof srpUser - 1, srpPassword, sizeof srpPassword - 1);
+    HAP_srp_public_key(srpPublicKeyB, key, srpVerifier);
+    // Any group element serves as the controller's public key for measurement purposes.
+    uint8_t srpSecretKeyA[SRP_SECRET_KEY_BYTES];
+    for (size_t i = 0; i < sizeof srpSecretKeyA; i++) {
+        srpSecretKeyA[i] = (uint8_t)(0x55 + i);
+    }
+    HAP_srp_public_key(srpPublicKeyA, srpSecretKeyA, srpVerifier);
+    HAP_srp_scrambling_parameter(srpScramblingParameter, srpPublicKeyA, srpPublicKeyB);
+    int e = HAP_srp_premaster_secret(srpPremasterSecret, srpPublicKeyA, key, srpScramblingParameter, srpVerifier);
+    HAPBenchExpect(!e, "HAP_srp_premaster_secret failed.");
+    HAP_srp_session_key(srpSessionKey, srpPremasterSecret);
+    HAP_srp_proof_m1(srpProofM1, srpUser, sizeof srpUser - 1, srpSalt, srpPublicKeyA, srpPublicKeyB, srpSessionKey);
+}
+
+/**
+ * Runs a bulk benchmark for each message size.
+ *
+ * @param      name                 Name of the operation.
+ * @param      function             Function to measure. Context is a pointer to the message size.
+ */
+static void RunForMessageSizes(const char* name, HAPBenchFunction function) {
+    for (size_t i = 0; i < HAPArrayCount(messageSizes); i++) {
+        char description[64];
+        HAPError err =
+                HAPStringWithFormat(description, sizeof description, "%s/%lu", name, (unsigned long) messageSizes[i]);
+        HAPBenchExpect(!err, "Name too long.");
+        HAPBenchRun(kBenchmark, backend, description, messageSizes[i], function, (void*) &messageSizes[i]);
+    }
+}
+
+/** Indices into messageSizes. */
+static const size_t messageSizeIndices[] = { 0, 1 };
+HAP_STATIC_ASSERT(HAPArrayCount(messageSizeIndices) == HAPArrayCount(messageSizes), IndicesCoverMessageSizes);
+
+/**
+ * Runs a bulk benchmark for each message size, passing the index of the message size as context.
+ *
+ * @param      name                 Name of the operation.
+ * @param      function             Function to measure. Context is a pointer to the index of the message size.
+ */
+static void RunForMessageSizeIndices(const char* name, HAPBenchFunction function) {
+    for (size_t i = 0; i < HAPArrayCount(messageSizes); i++) {
+        char description[64];
+        HAPError err =
+                HAPStringWithFormat(description, sizeof description, "%s/%lu", name, (unsigned long) messageSizes[i]);
+        HAPBenchExpect(!err, "Name too long.");
+        HAPBenchRun(kBenchmark, backend, description, messageSizes[i], function, (void*) &messageSizeIndices[i]);
+    }
+}
+
+int main(int argc HAP_UNUSED, char* argv[]) {
+    // The executable name ends with the name of the crypto backend.
+    backend = "Unknown";
+    for (const char* c = argv[0]; *c; c++) {
+        if (*c == '.') {
+            backend = c + 1;
+        }
+    }
+
+    Prepare();
+
+    RunForMessageSizes("sha1", SHA1);
+    RunForMessageSizes("sha256", SHA256);
+    RunForMessageSizes("sha512", SHA512);
+    RunForMessageSizes("hmac_sha1_aad", HMACSHA1);
+    HAPBenchRun(kBenchmark, backend, "hkdf_sha512", 0, HKDFSHA512, NULL);
+    HAPBenchRun(kBenchmark, backend, "pbkdf2_hmac_sha1/1000", 0, PBKDF2HMACSHA1, NULL);
+
+    RunForMessageSizes("chacha20_poly1305_encrypt", ChaCha20Poly1305Encrypt);
+    RunForMessageSizeIndices("chacha20_poly1305_decrypt", ChaCha20Poly1305Decrypt);
+    RunForMessageSizes("chacha20_poly1305_encrypt_aad", ChaCha20Poly1305EncryptAAD);
+    RunForMessageSizeIndices("chacha20_poly1305_decrypt_aad", ChaCha20Poly1305DecryptAAD);
+    RunForMessageSizes("chacha20_poly1305_streaming", ChaCha20Poly1305Streaming);
+    RunForMessageSizes("aes_ctr", AESCTR);
+
+    HAPBenchRun(kBenchmark, backend, "ed25519_public_key", 0, Ed25519PublicKey, NULL);
+    HAPBenchRun(kBenchmark, backend, "ed25519_sign", 0, Ed25519Sign, NULL);
+    HAPBenchRun(kBenchmark, backend, "ed25519_verify", 0, Ed25519Verify, NULL);
+    HAPBenchRun(kBenchmark, backend, "X25519_scalarmult_base", 0, X25519ScalarMultBase, NULL);
+    HAPBenchRun(kBenchmark, backend, "X25519_scalarmult", 0, X25519ScalarMult, NULL);
+
+    HAPBenchRun(kBenchmark, backend, "srp_verifier", 0, SRPVerifier, NULL);
+    HAPBenchRun(kBenchmark, backend, "srp_public_key", 0, SRPPublicKey, NULL);
+    HAPBenchRun(kBenchmark, backend, "srp_scrambling_parameter", 0, SRPScramblingParameter, NULL);
+    HAPBenchRun(kBenchmark, backend, "srp_premaster_secret", 0, SRPPremasterSecret, NULL);
+    HAPBenchRun(kBenchmark, backend, "srp_session_key", 0, SRPSessionKey, NULL);
+    HAPBenchRun(kBenchmark, backend, "srp_proof_m1", 0, SRPProofM1, NULL);
+    HAPBenchRun(kBenchmark, backend, "srp_proof_m2", 0, SRPProofM2, NULL);
+
+    RunForMessageSizes("constant_time_equal", ConstantTimeEqual);
+    RunForMessageSizes("constant_time_is_zero", ConstantTimeIsZero);
+    RunForMessageSizes("constant_time_fill_zero", ConstantTimeFillZero);
+    RunForMessageSizes("constant_time_copy", ConstantTimeCopy);
+
+    return 0;
+}
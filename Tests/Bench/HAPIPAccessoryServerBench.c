@@ -0,0 +1,723 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+// Measures end-to-end throughput and latency of the IP accessory server on the Mock PAL.
+//
+// Controllers are connected through the Mock TCP stream manager and registered as separate pairings. Their
+// security sessions are established with fixed session keys as if Pair Verify had completed, so that the
+// measurements are not dominated by pairing. Each operation is sent by one controller, and the next operation is
+// only started once the accessory server has responded. Operations are picked from a weighted mix of:
+// - get:         GET /characteristics of two characteristics.
+// - put:         PUT /characteristics of one characteristic.
+// - accessories: GET /accessories.
+// - events:      An event is raised and delivered to all controllers.
+//
+// Usage: HAPIPAccessoryServerBench [--controllers=<n>] [--requests=<n>] [--mix=get:<w>,put:<w>,accessories:<w>,events:<w>]
+//
+// Without --mix, each operation is measured on its own, followed by a typical mix.
+// Results are printed as one JSON object per line.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "HAP+Internal.h"
+
+// Benchmarks are built with the Release build type, so the Mock PAL headers are not on the include path.
+#include "../../PAL/Mock/HAPPlatform+Init.h"
+
+#include "../Harness/TemplateDB.c"
+
+#define kIID_LightBulb           ((uint64_t) 0x0030)
+#define kIID_LightBulbOn         ((uint64_t) 0x0031)
+#define kIID_LightBulbBrightness ((uint64_t) 0x0032)
+
+/** Number of attributes of the light bulb service. */
+#define kLightBulbAttributeCount ((size_t) 3)
+
+/** Maximum number of controllers. */
+#define kMaxControllers ((size_t) 16)
+
+/** Maximum number of operations per scenario. */
+#define kMaxOperations ((size_t) 100000)
+
+/** Delay after which pending event notifications are sent. */
+#define kEventNotificationDelay ((HAPTime)(1 * HAPSecond))
+
+/** Maximum number of run loop iterations to wait for a response. */
+#define kMaxReceiveIterations ((size_t) 1000)
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#if defined(__GLIBC__)
+
+// Allocations are counted by interposing the allocator. The HomeKit ADK itself does not allocate memory,
+// but crypto backends may.
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t numElements, size_t size);
+extern void* __libc_realloc(void* _Nullable ptr, size_t size);
+
+static size_t numAllocations;
+
+void* malloc(size_t size) {
+    numAllocations++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t numElements, size_t size) {
+    numAllocations++;
+    return __libc_calloc(numElements, size);
+}
+
+void* realloc(void* _Nullable ptr, size_t size) {
+    numAllocations++;
+    return __libc_realloc(ptr, size);
+}
+
+#define kCountsAllocations (true)
+
+#else
+
+static size_t numAllocations;
+
+#define kCountsAllocations (false)
+
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/** State of the accessory. */
+static struct {
+    bool on;
+    int32_t brightness;
+} state;
+
+HAP_RESULT_USE_CHECK
+static HAPError IdentifyAccessory(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPAccessoryIdentifyRequest* request HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleOnRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPBoolCharacteristicReadRequest* request HAP_UNUSED,
+        bool* value,
+        void* _Nullable context HAP_UNUSED) {
+    *value = state.on;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleOnWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPBoolCharacteristicWriteRequest* request HAP_UNUSED,
+        bool value,
+        void* _Nullable context HAP_UNUSED) {
+    state.on = value;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleBrightnessRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPIntCharacteristicReadRequest* request HAP_UNUSED,
+        int32_t* value,
+        void* _Nullable context HAP_UNUSED) {
+    *value = state.brightness;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleBrightnessWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPIntCharacteristicWriteRequest* request HAP_UNUSED,
+        int32_t value,
+        void* _Nullable context HAP_UNUSED) {
+    state.brightness = value;
+    return kHAPError_None;
+}
+
+static const HAPBoolCharacteristic onCharacteristic = {
+    .format = kHAPCharacteristicFormat_Bool,
+    .iid = kIID_LightBulbOn,
+    .characteristicType = &kHAPCharacteristicType_On,
+    .debugDescription = kHAPCharacteristicDebugDescription_On,
+    .properties = { .readable = true, .writable = true, .supportsEventNotification = true },
+    .callbacks = { .handleRead = HandleOnRead, .handleWrite = HandleOnWrite }
+};
+
+static const HAPIntCharacteristic brightnessCharacteristic = {
+    .format = kHAPCharacteristicFormat_Int,
+    .iid = kIID_LightBulbBrightness,
+    .characteristicType = &kHAPCharacteristicType_Brightness,
+    .debugDescription = kHAPCharacteristicDebugDescription_Brightness,
+    .properties = { .readable = true, .writable = true, .supportsEventNotification = true },
+    .units = kHAPCharacteristicUnits_Percentage,
+    .constraints = { .minimumValue = 0, .maximumValue = 100, .stepValue = 1 },
+    .callbacks = { .handleRead = HandleBrightnessRead, .handleWrite = HandleBrightnessWrite }
+};
+
+static const HAPService lightBulbService = {
+    .iid = kIID_LightBulb,
+    .serviceType = &kHAPServiceType_LightBulb,
+    .debugDescription = kHAPServiceDebugDescription_LightBulb,
+    .properties = { .primaryService = true },
+    .characteristics = (const HAPCharacteristic* const[]) { &onCharacteristic, &brightnessCharacteristic, NULL }
+};
+
+static const HAPAccessory accessory = { .aid = 1,
+                                        .category = kHAPAccessoryCategory_Lighting,
+                                        .name = "Acme Bench",
+                                        .manufacturer = "Acme",
+                                        .model = "Bench1,1",
+                                        .serialNumber = "099DB48E9E28",
+                                        .firmwareVersion = "1",
+                                        .hardwareVersion = "1",
+                                        .services = (const HAPService* const[]) { &accessoryInformationService,
+                                                                                  &hapProtocolInformationService,
+                                                                                  &pairingService,
+                                                                                  &lightBulbService,
+                                                                                  NULL },
+                                        .callbacks = { .identify = IdentifyAccessory } };
+
+static void HandleUpdatedAccessoryServerState(HAPAccessoryServerRef* server HAP_UNUSED, void* _Nullable context HAP_UNUSED) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/** Accessory server. */
+static HAPAccessoryServerRef accessoryServer;
+
+/** Accessory server that is used for controller side encryption. Does not record metrics. */
+static HAPAccessoryServerRef controllerServer;
+
+/** Performance metrics of the accessory server. */
+static HAPAccessoryServerMetrics metrics;
+
+/** Connected controller. */
+typedef struct {
+    HAPPlatformTCPStreamRef tcpStream;
+
+    /** Controller side of the security session. */
+    HAPSessionRef session;
+} Controller;
+
+static Controller controllers[kMaxControllers];
+static size_t numControllers = 4;
+
+/** Buffer into which messages are received and decrypted. */
+static uint8_t receiveBytes[32 * 1024];
+
+/** Latency of each operation of the current scenario, in nanoseconds. */
+static uint64_t latencies[kMaxOperations];
+
+/**
+ * Aborts the benchmark if a condition does not hold.
+ *
+ * - HAPAssert is compiled out in Release builds.
+ */
+static void Expect(bool condition, const char* description) {
+    if (!condition) {
+        fprintf(stderr, "Benchmark failed: %s\n", description);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static uint64_t GetNanoseconds(void) {
+    struct timespec t;
+    int e = clock_gettime(CLOCK_MONOTONIC, &t);
+    Expect(!e, "clock_gettime failed.");
+    return (uint64_t) t.tv_sec * 1000000000 + (uint64_t) t.tv_nsec;
+}
+
+/**
+ * Sends an encrypted request to the accessory server.
+ */
+static void SendRequest(Controller* controller, const char* request, size_t numRequestBytes) {
+    HAPError err;
+
+    static uint8_t bytes[4096];
+    Expect(HAPIPSecurityProtocolGetNumEncryptedBytes(numRequestBytes) <= sizeof bytes, "Request too long.");
+    HAPRawBufferCopyBytes(bytes, request, numRequestBytes);
+    HAPIPByteBuffer buffer = { .data = (char*) bytes, .capacity = sizeof bytes, .limit = numRequestBytes };
+    HAPIPSecurityProtocolEncryptData(&controllerServer, &controller->session, &buffer);
+
+    size_t numBytesWritten;
+    err = HAPPlatformTCPStreamClientWrite(
+            HAPNonnull(platform.ip.tcpStreamManager), controller->tcpStream, bytes, buffer.limit, &numBytesWritten);
+    Expect(!err && numBytesWritten == buffer.limit, "Request could not be written.");
+}
+
+/**
+ * Checks whether the body of a chunked HTTP message has been received completely.
+ *
+ * @param      bytes                Received body.
+ * @param      numBytes             Length of received body.
+ *
+ * @return true                     If the terminating chunk has been received.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool IsChunkedBodyComplete(const uint8_t* bytes, size_t numBytes) {
+    size_t i = 0;
+    for (;;) {
+        size_t numChunkBytes = 0;
+        size_t numDigits = 0;
+        for (; i < numBytes; i++, numDigits++) {
+            uint8_t c = bytes[i];
+            if (c >= '0' && c <= '9') {
+                numChunkBytes = numChunkBytes * 16 + (size_t)(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                numChunkBytes = numChunkBytes * 16 + (size_t)(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                numChunkBytes = numChunkBytes * 16 + (size_t)(c - 'A' + 10);
+            } else {
+                break;
+            }
+        }
+        if (i + 2 > numBytes) {
+            return false;
+        }
+        Expect(numDigits && HAPRawBufferAreEqual(&bytes[i], "\r\n", 2), "Malformed chunk.");
+        i += 2;
+        if (numChunkBytes > numBytes - i || numBytes - i - numChunkBytes < 2) {
+            return false;
+        }
+        i += numChunkBytes + 2;
+        if (!numChunkBytes) {
+            Expect(i == numBytes, "Unexpected data after message.");
+            return true;
+        }
+    }
+}
+
+/**
+ * Checks whether a complete HTTP message has been received.
+ *
+ * @param      bytes                Received plaintext.
+ * @param      numBytes             Length of received plaintext.
+ *
+ * @return true                     If a complete message has been received.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool IsMessageComplete(const uint8_t* bytes, size_t numBytes) {
+    static const char contentLength[] = "\r\nContent-Length: ";
+    static const char chunked[] = "\r\nTransfer-Encoding: chunked\r\n";
+    size_t numBodyBytes = 0;
+    bool isChunked = false;
+    for (size_t i = 0; i + 4 <= numBytes; i++) {
+        if (i + sizeof contentLength - 1 <= numBytes &&
+            HAPRawBufferAreEqual(&bytes[i], contentLength, sizeof contentLength - 1)) {
+            for (size_t j = i + sizeof contentLength - 1; j < numBytes && bytes[j] >= '0' && bytes[j] <= '9'; j++) {
+                numBodyBytes = numBodyBytes * 10 + (size_t)(bytes[j] - '0');
+            }
+        }
+        if (i + sizeof chunked - 1 <= numBytes && HAPRawBufferAreEqual(&bytes[i], chunked, sizeof chunked - 1)) {
+            isChunked = true;
+        }
+        if (HAPRawBufferAreEqual(&bytes[i], "\r\n\r\n", 4)) {
+            size_t numHeaderBytes = i + 4;
+            if (isChunked) {
+                return IsChunkedBodyComplete(&bytes[numHeaderBytes], numBytes - numHeaderBytes);
+            }
+            Expect(numBytes <= numHeaderBytes + numBodyBytes, "Unexpected data after message.");
+            return numBytes == numHeaderBytes + numBodyBytes;
+        }
+    }
+    return false;
+}
+
+/**
+ * Receives and decrypts one message from the accessory server.
+ *
+ * @param      controller           Controller.
+ * @param      statusLine           Expected start of the status line.
+ */
+static void ReceiveMessage(Controller* controller, const char* statusLine) {
+    HAPError err;
+
+    HAPIPByteBuffer buffer = { .data = (char*) receiveBytes, .capacity = sizeof receiveBytes };
+    for (size_t i = 0;; i++) {
+        Expect(i < kMaxReceiveIterations, "Timed out waiting for message.");
+        HAPPlatformClockAdvance(0);
+
+        size_t numBytes;
+        err = HAPPlatformTCPStreamClientRead(
+                HAPNonnull(platform.ip.tcpStreamManager),
+                controller->tcpStream,
+                &receiveBytes[buffer.limit],
+                buffer.capacity - buffer.limit,
+                &numBytes);
+        if (err == kHAPError_Busy) {
+            continue;
+        }
+        Expect(!err && numBytes, "Connection closed.");
+        buffer.limit += numBytes;
+        err = HAPIPSecurityProtocolDecryptData(&controllerServer, &controller->session, &buffer);
+        Expect(!err, "Decryption failed.");
+        if (IsMessageComplete(receiveBytes, buffer.position)) {
+            break;
+        }
+    }
+    Expect(buffer.position == buffer.limit, "Unexpected data after message.");
+    size_t numStatusLineBytes = HAPStringGetNumBytes(statusLine);
+    Expect(buffer.position >= numStatusLineBytes && HAPRawBufferAreEqual(receiveBytes, statusLine, numStatusLineBytes),
+           "Unexpected status.");
+}
+
+/**
+ * Sends a PUT /characteristics request with the given body and waits for the response.
+ */
+static void WriteCharacteristics(Controller* controller, const char* body) {
+    HAPError err;
+
+    char request[512];
+    err = HAPStringWithFormat(
+            request,
+            sizeof request,
+            "PUT /characteristics HTTP/1.1\r\n"
+            "Content-Type: application/hap+json\r\n"
+            "Content-Length: %lu\r\n\r\n"
+            "%s",
+            (unsigned long) HAPStringGetNumBytes(body),
+            body);
+    Expect(!err, "Request too long.");
+    SendRequest(controller, request, HAPStringGetNumBytes(request));
+    ReceiveMessage(controller, "HTTP/1.1 204 ");
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Operation.
+ */
+HAP_ENUM_BEGIN(uint8_t, Operation) {
+    /** GET /characteristics. */
+    kOperation_Get,
+
+    /** PUT /characteristics. */
+    kOperation_Put,
+
+    /** GET /accessories. */
+    kOperation_Accessories,
+
+    /** Event notification to all controllers. */
+    kOperation_Event
+} HAP_ENUM_END(uint8_t, Operation);
+
+#define kNumOperations ((size_t) 4)
+
+static const char* const operationNames[kNumOperations] = { "get", "put", "accessories", "events" };
+
+/**
+ * Benchmark scenario.
+ */
+typedef struct {
+    /** Name. */
+    const char* name;
+
+    /** Relative weight of each operation. */
+    uint32_t weights[kNumOperations];
+} Scenario;
+
+static void RunOperation(Operation operation, size_t operationIndex) {
+    Controller* controller = &controllers[operationIndex % numControllers];
+    switch (operation) {
+        case kOperation_Get: {
+            static const char request[] = "GET /characteristics?id=1.49,1.50 HTTP/1.1\r\n\r\n";
+            SendRequest(controller, request, sizeof request - 1);
+            ReceiveMessage(controller, "HTTP/1.1 200 ");
+        } break;
+        case kOperation_Put: {
+            HAPError err;
+            char body[128];
+            err = HAPStringWithFormat(
+                    body,
+                    sizeof body,
+                    "{\"characteristics\":[{\"aid\":1,\"iid\":50,\"value\":%lu}]}",
+                    (unsigned long) (operationIndex % 101));
+            Expect(!err, "Request too long.");
+            WriteCharacteristics(controller, body);
+        } break;
+        case kOperation_Accessories: {
+            static const char request[] = "GET /accessories HTTP/1.1\r\n\r\n";
+            SendRequest(controller, request, sizeof request - 1);
+            ReceiveMessage(controller, "HTTP/1.1 200 ");
+        } break;
+        case kOperation_Event: {
+            state.brightness = (int32_t)(operationIndex % 101);
+            HAPAccessoryServerRaiseEvent(&accessoryServer, &brightnessCharacteristic, &lightBulbService, &accessory);
+            HAPPlatformClockAdvance(kEventNotificationDelay);
+            for (size_t i = 0; i < numControllers; i++) {
+                ReceiveMessage(&controllers[i], "EVENT/1.0 200 ");
+            }
+        } break;
+    }
+}
+
+static int CompareLatencies(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*) a;
+    uint64_t y = *(const uint64_t*) b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static void RunScenario(const Scenario* scenario, size_t numOperations) {
+    uint32_t totalWeight = 0;
+    for (size_t i = 0; i < kNumOperations; i++) {
+        totalWeight += scenario->weights[i];
+    }
+    Expect(totalWeight, "Scenario has no operations.");
+
+    HAPAccessoryServerMetrics startMetrics = metrics;
+    size_t startNumAllocations = numAllocations;
+    size_t numOperationsByType[kNumOperations] = { 0 };
+
+    // Operations are picked with a fixed seed so that runs are reproducible.
+    uint32_t random = 1;
+    uint64_t startTime = GetNanoseconds();
+    for (size_t i = 0; i < numOperations; i++) {
+        random = random * 1103515245 + 12345;
+        uint32_t r = (random >> 16) % totalWeight;
+        Operation operation = 0;
+        while (r >= scenario->weights[operation]) {
+            r -= scenario->weights[operation];
+            operation++;
+        }
+        numOperationsByType[operation]++;
+
+        uint64_t operationStartTime = GetNanoseconds();
+        RunOperation(operation, i);
+        latencies[i] = GetNanoseconds() - operationStartTime;
+    }
+    uint64_t totalNanoseconds = GetNanoseconds() - startTime;
+
+    qsort(latencies, numOperations, sizeof latencies[0], CompareLatencies);
+
+    printf("{\"benchmark\":\"IPAccessoryServer\",\"scenario\":\"%s\",\"numControllers\":%lu,\"numOperations\":%lu,",
+           scenario->name,
+           (unsigned long) numControllers,
+           (unsigned long) numOperations);
+    printf("\"mix\":{");
+    for (size_t i = 0; i < kNumOperations; i++) {
+        printf("%s\"%s\":%lu", i ? "," : "", operationNames[i], (unsigned long) numOperationsByType[i]);
+    }
+    printf("},\"operationsPerSecond\":%.1f,\"p50LatencyUs\":%.2f,\"p99LatencyUs\":%.2f,",
+           (double) numOperations * 1e9 / (double) totalNanoseconds,
+           (double) latencies[numOperations / 2] / 1e3,
+           (double) latencies[numOperations * 99 / 100] / 1e3);
+    printf("\"numEncryptedBytes\":%llu,\"numDecryptedBytes\":%llu,",
+           (unsigned long long) (metrics.numEncryptedBytes - startMetrics.numEncryptedBytes),
+           (unsigned long long) (metrics.numDecryptedBytes - startMetrics.numDecryptedBytes));
+    if (kCountsAllocations) {
+        printf("\"numAllocations\":%lu}\n", (unsigned long) (numAllocations - startNumAllocations));
+    } else {
+        printf("\"numAllocations\":null}\n");
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+HAP_RESULT_USE_CHECK
+static bool HasPrefix(const char* string, const char* prefix) {
+    return strncmp(string, prefix, HAPStringGetNumBytes(prefix)) == 0;
+}
+
+HAP_RESULT_USE_CHECK
+static bool ParseSize(const char* description, size_t minimumValue, size_t maximumValue, size_t* value) {
+    uint64_t v;
+    HAPError err = HAPUInt64FromString(description, &v);
+    if (err || v < minimumValue || v > maximumValue) {
+        return false;
+    }
+    *value = (size_t) v;
+    return true;
+}
+
+/**
+ * Parses a mix of the form get:<w>,put:<w>,accessories:<w>,events:<w>. Omitted operations have weight 0.
+ */
+HAP_RESULT_USE_CHECK
+static bool ParseMix(const char* description, Scenario* scenario) {
+    HAPRawBufferZero(scenario->weights, sizeof scenario->weights);
+    const char* s = description;
+    while (*s) {
+        const char* separator = strchr(s, ':');
+        if (!separator) {
+            return false;
+        }
+        size_t i;
+        for (i = 0; i < kNumOperations; i++) {
+            size_t numNameBytes = HAPStringGetNumBytes(operationNames[i]);
+            if ((size_t)(separator - s) == numNameBytes && HAPRawBufferAreEqual(s, operationNames[i], numNameBytes)) {
+                break;
+            }
+        }
+        if (i == kNumOperations) {
+            return false;
+        }
+        char* end;
+        unsigned long weight = strtoul(separator + 1, &end, 10);
+        if (end == separator + 1 || weight > UINT16_MAX || (*end && *end != ',')) {
+            return false;
+        }
+        scenario->weights[i] = (uint32_t) weight;
+        s = *end ? end + 1 : end;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    HAPError err;
+
+    size_t numOperations = 2000;
+    static Scenario customScenario = { .name = "custom" };
+    bool hasCustomScenario = false;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool isValid;
+        if (HasPrefix(arg, "--controllers=")) {
+            isValid = ParseSize(&arg[sizeof "--controllers=" - 1], 1, kMaxControllers, &numControllers);
+        } else if (HasPrefix(arg, "--requests=")) {
+            isValid = ParseSize(&arg[sizeof "--requests=" - 1], 1, kMaxOperations, &numOperations);
+        } else if (HasPrefix(arg, "--mix=")) {
+            isValid = ParseMix(&arg[sizeof "--mix=" - 1], &customScenario);
+            hasCustomScenario = true;
+        } else {
+            isValid = false;
+        }
+        if (!isValid) {
+            fprintf(stderr,
+                    "Usage: %s [--controllers=1...%lu] [--requests=1...%lu] "
+                    "[--mix=get:<w>,put:<w>,accessories:<w>,events:<w>]\n",
+                    argv[0],
+                    (unsigned long) kMaxControllers,
+                    (unsigned long) kMaxOperations);
+            return EXIT_FAILURE;
+        }
+    }
+
+    HAPPlatformCreate();
+
+    // Prepare accessory server storage. One session more than controllers is provided so that the
+    // maximum idle time is not enforced while virtual time advances for event notifications.
+    static HAPIPSession ipSessions[kMaxControllers + 1];
+    static HAPIPSessionSlotRef ipSessionSlots[HAPArrayCount(ipSessions)];
+    static uint8_t ipInboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultInboundBufferSize];
+    static uint8_t ipOutboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultOutboundBufferSize];
+    static HAPIPEventNotificationRef
+            ipEventNotifications[HAPArrayCount(ipSessions)][kAttributeCount + kLightBulbAttributeCount];
+    for (size_t i = 0; i < HAPArrayCount(ipSessions); i++) {
+        ipSessions[i].inboundBuffer.bytes = ipInboundBuffers[i];
+        ipSessions[i].inboundBuffer.numBytes = sizeof ipInboundBuffers[i];
+        ipSessions[i].outboundBuffer.bytes = ipOutboundBuffers[i];
+        ipSessions[i].outboundBuffer.numBytes = sizeof ipOutboundBuffers[i];
+        ipSessions[i].eventNotifications = ipEventNotifications[i];
+        ipSessions[i].numEventNotifications = HAPArrayCount(ipEventNotifications[i]);
+    }
+    static HAPIPReadContextRef ipReadContexts[kAttributeCount + kLightBulbAttributeCount];
+    static HAPIPWriteContextRef ipWriteContexts[kAttributeCount + kLightBulbAttributeCount];
+    static uint8_t ipScratchBuffer[kHAPIPSession_DefaultScratchBufferSize];
+    static HAPIPAccessoryServerStorage ipAccessoryServerStorage = {
+        .sessions = ipSessions,
+        .numSessions = HAPArrayCount(ipSessions),
+        .sessionSlots = ipSessionSlots,
+        .readContexts = ipReadContexts,
+        .numReadContexts = HAPArrayCount(ipReadContexts),
+        .writeContexts = ipWriteContexts,
+        .numWriteContexts = HAPArrayCount(ipWriteContexts),
+        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer }
+    };
+
+    // Initialize and start accessory server.
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = HAPMax(kMaxControllers, kHAPPairingStorage_MinElements),
+                    .ip = { .transport = &kHAPAccessoryServerTransport_IP,
+                            .accessoryServerStorage = &ipAccessoryServerStorage },
+                    .metrics = &metrics },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+    HAPAccessoryServerStart(&accessoryServer, &accessory);
+    HAPPlatformClockAdvance(0);
+    Expect(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running, "Server not running.");
+
+    // Register one admin pairing per controller.
+    for (size_t i = 0; i < numControllers; i++) {
+        uint8_t pairingBytes[sizeof(HAPPairingID) + sizeof(uint8_t) + sizeof(HAPPairingPublicKey) + sizeof(uint8_t)];
+        HAPRawBufferZero(pairingBytes, sizeof pairingBytes);
+        pairingBytes[0] = (uint8_t) i;
+        pairingBytes[sizeof(HAPPairingID)] = 1;
+        pairingBytes[sizeof pairingBytes - 1] = 0x01;
+        err = HAPPlatformKeyValueStoreSet(
+                platform.keyValueStore,
+                kHAPKeyValueStoreDomain_Pairings,
+                (HAPPlatformKeyValueStoreKey) i,
+                pairingBytes,
+                sizeof pairingBytes);
+        Expect(!err, "Pairing could not be stored.");
+    }
+
+    // Connect controllers and establish security sessions as if Pair Verify had completed.
+    for (size_t i = 0; i < numControllers; i++) {
+        Controller* controller = &controllers[i];
+        err = HAPPlatformTCPStreamManagerConnectToListener(
+                HAPNonnull(platform.ip.tcpStreamManager), &controller->tcpStream);
+        Expect(!err, "Connection failed.");
+        HAPPlatformClockAdvance(0);
+
+        HAPIPSessionDescriptor* descriptor = NULL;
+        for (size_t j = 0; j < HAPArrayCount(ipSessions); j++) {
+            HAPIPSessionDescriptor* t = (HAPIPSessionDescriptor*) &ipSessions[j].descriptor;
+            if (t->tcpStreamIsOpen && t->tcpStream == controller->tcpStream) {
+                descriptor = t;
+            }
+        }
+        Expect(descriptor && descriptor->securitySession.isOpen, "Connection not accepted.");
+        HAPSession* accessorySession = (HAPSession*) &HAPNonnull(descriptor)->securitySession._.hap;
+        HAPSession* session = (HAPSession*) &controller->session;
+        accessorySession->hap.active = true;
+        accessorySession->hap.pairingID = (int) i;
+        session->hap.active = true;
+        for (size_t j = 0; j < sizeof(HAPSessionKey); j++) {
+            accessorySession->hap.controllerToAccessory.controlChannel.key.bytes[j] = (uint8_t)(i + j);
+            accessorySession->hap.accessoryToController.controlChannel.key.bytes[j] = (uint8_t)(0x80 + i + j);
+            // The controller encrypts with the keys of the opposite direction.
+            session->hap.accessoryToController.controlChannel.key.bytes[j] = (uint8_t)(i + j);
+            session->hap.controllerToAccessory.controlChannel.key.bytes[j] = (uint8_t)(0x80 + i + j);
+        }
+
+        // Subscribe to brightness events.
+        WriteCharacteristics(controller, "{\"characteristics\":[{\"aid\":1,\"iid\":50,\"ev\":true}]}");
+    }
+
+    if (hasCustomScenario) {
+        RunScenario(&customScenario, numOperations);
+    } else {
+        static const Scenario scenarios[] = {
+            { .name = "get", .weights = { 1, 0, 0, 0 } },         { .name = "put", .weights = { 0, 1, 0, 0 } },
+            { .name = "accessories", .weights = { 0, 0, 1, 0 } }, { .name = "events", .weights = { 0, 0, 0, 1 } },
+            { .name = "mixed", .weights = { 60, 30, 5, 5 } },
+        };
+        for (size_t i = 0; i < HAPArrayCount(scenarios); i++) {
+            RunScenario(&scenarios[i], numOperations);
+        }
+    }
+
+    for (size_t i = 0; i < numControllers; i++) {
+        HAPPlatformTCPStreamManagerClientClose(HAPNonnull(platform.ip.tcpStreamManager), controllers[i].tcpStream);
+    }
+    HAPPlatformClockAdvance(0);
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+// Measures the cost of the periodic IP session scans (garbage collection, maximum idle time,
+// event notification scheduling) for the session descriptor layout where the scheduling state is embedded
+// in each session, and for the layout where it is kept in the densely packed session slot array.
+//
+// Each scan is measured with warm caches (back-to-back scans) and with cold caches (a large buffer is touched
+// between scans, as happens in the accessory server when other work runs between timer callbacks).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "HAP+Internal.h"
+
+/**
+ * Session layout before the scheduling state was moved into session slots.
+ * The scheduling state was stored as part of the session descriptor.
+ */
+typedef struct {
+    HAPIPSessionSlot embeddedSlot;
+    HAPIPSession ipSession;
+} EmbeddedSession;
+
+/** Maximum number of sessions that are benchmarked. */
+#define kMaxSessions ((size_t) 256)
+
+/** Size of the buffer that is touched to evict caches between cold scans. */
+#define kEvictionBufferSize ((size_t) 8 * 1024 * 1024)
+
+static EmbeddedSession embeddedSessions[kMaxSessions];
+static HAPIPSession ipSessions[kMaxSessions];
+static HAPIPSessionSlotRef ipSessionSlots[kMaxSessions];
+static uint8_t evictionBuffer[kEvictionBufferSize];
+
+static volatile size_t sink;
+
+static uint64_t GetNanoseconds(void) {
+    struct timespec t;
+    int e = clock_gettime(CLOCK_MONOTONIC, &t);
+    HAPAssert(!e);
+    return (uint64_t) t.tv_sec * 1000000000 + (uint64_t) t.tv_nsec;
+}
+
+static void EvictCaches(void) {
+    for (size_t i = 0; i < sizeof evictionBuffer; i += 64) {
+        evictionBuffer[i]++;
+    }
+}
+
+static void PrepareSessions(size_t numSessions) {
+    HAPRawBufferZero(embeddedSessions, sizeof embeddedSessions);
+    HAPRawBufferZero(ipSessions, sizeof ipSessions);
+    HAPRawBufferZero(ipSessionSlots, sizeof ipSessionSlots);
+
+    // All sessions are open and waiting for requests. One session has a pending event notification.
+    for (size_t i = 0; i < numSessions; i++) {
+        HAPIPSessionSlot* slot = (HAPIPSessionSlot*) &ipSessionSlots[i];
+        slot->isActive = true;
+        slot->state = kHAPIPSessionState_Reading;
+        slot->numEventNotificationFlags = (i == numSessions / 2) ? 1 : 0;
+        embeddedSessions[i].embeddedSlot = *slot;
+    }
+}
+
+HAP_RESULT_USE_CHECK
+static size_t ScanEmbeddedSessions(size_t numSessions) {
+    size_t n = 0;
+    for (size_t i = 0; i < numSessions; i++) {
+        const EmbeddedSession* session = &embeddedSessions[i];
+        const HAPIPSessionDescriptor* descriptor = (const HAPIPSessionDescriptor*) &session->ipSession.descriptor;
+        if (!session->embeddedSlot.isActive) {
+            continue;
+        }
+        if ((session->embeddedSlot.state == kHAPIPSessionState_Reading) && (descriptor->inboundBuffer.position == 0) &&
+            (session->embeddedSlot.numEventNotificationFlags > 0)) {
+            n++;
+        }
+    }
+    return n;
+}
+
+HAP_RESULT_USE_CHECK
+static size_t ScanSessionSlots(size_t numSessions) {
+    size_t n = 0;
+    for (size_t i = 0; i < numSessions; i++) {
+        const HAPIPSessionSlot* slot = (const HAPIPSessionSlot*) &ipSessionSlots[i];
+        if (!slot->isActive || (slot->state != kHAPIPSessionState_Reading) || !slot->numEventNotificationFlags) {
+            continue;
+        }
+        const HAPIPSessionDescriptor* descriptor = (const HAPIPSessionDescriptor*) &ipSessions[i].descriptor;
+        if (descriptor->inboundBuffer.position == 0) {
+            n++;
+        }
+    }
+    return n;
+}
+
+typedef size_t (*ScanFunction)(size_t numSessions);
+
+static void RunBenchmark(const char* layout, ScanFunction scan, size_t numSessions, bool coldCaches) {
+    size_t numIterations = coldCaches ? 200 : 100000;
+    uint64_t totalNanoseconds = 0;
+
+    for (size_t i = 0; i < numIterations; i++) {
+        if (coldCaches) {
+            EvictCaches();
+        }
+        uint64_t start = GetNanoseconds();
+        sink = scan(numSessions);
+        totalNanoseconds += GetNanoseconds() - start;
+        HAPAssert(sink == 1);
+    }
+
+    printf("{\"benchmark\":\"IPSessionScan\",\"layout\":\"%s\",\"numSessions\":%lu,\"caches\":\"%s\","
+           "\"nsPerScan\":%.1f}\n",
+           layout,
+           (unsigned long) numSessions,
+           coldCaches ? "cold" : "warm",
+           (double) totalNanoseconds / (double) numIterations);
+}
+
+int main() {
+    static const size_t numSessionsList[] = { 8, kHAPIPSessionStorage_DefaultNumElements, 64, kMaxSessions };
+
+    for (size_t i = 0; i < HAPArrayCount(numSessionsList); i++) {
+        size_t numSessions = numSessionsList[i];
+        HAPAssert(numSessions <= kMaxSessions);
+        PrepareSessions(numSessions);
+        for (int coldCaches = 0; coldCaches <= 1; coldCaches++) {
+            RunBenchmark("embedded", ScanEmbeddedSessions, numSessions, coldCaches);
+            RunBenchmark("slots", ScanSessionSlots, numSessions, coldCaches);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,272 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+#include "Harness/HAPIPTestSession.c"
+#include "Harness/TemplateDB.c"
+
+#define kIID_LightBulb           ((uint64_t) 0x0030)
+#define kIID_LightBulbOn         ((uint64_t) 0x0031)
+#define kIID_LightBulbBrightness ((uint64_t) 0x0032)
+
+/** Number of attributes of the light bulb service. */
+#define kLightBulbAttributeCount ((size_t) 3)
+
+/** Number of connected controllers. */
+#define kNumControllers ((size_t) 1)
+
+/** State of the test. */
+static struct {
+    bool on;
+    int32_t brightness;
+} test;
+
+HAP_RESULT_USE_CHECK
+static HAPError IdentifyAccessory(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPAccessoryIdentifyRequest* request HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleOnRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPBoolCharacteristicReadRequest* request HAP_UNUSED,
+        bool* value,
+        void* _Nullable context HAP_UNUSED) {
+    *value = test.on;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleOnWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPBoolCharacteristicWriteRequest* request HAP_UNUSED,
+        bool value,
+        void* _Nullable context HAP_UNUSED) {
+    test.on = value;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleBrightnessRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPIntCharacteristicReadRequest* request HAP_UNUSED,
+        int32_t* value,
+        void* _Nullable context HAP_UNUSED) {
+    *value = test.brightness;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleBrightnessWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPIntCharacteristicWriteRequest* request HAP_UNUSED,
+        int32_t value,
+        void* _Nullable context HAP_UNUSED) {
+    test.brightness = value;
+    return kHAPError_None;
+}
+
+static const HAPBoolCharacteristic onCharacteristic = {
+    .format = kHAPCharacteristicFormat_Bool,
+    .iid = kIID_LightBulbOn,
+    .characteristicType = &kHAPCharacteristicType_On,
+    .debugDescription = kHAPCharacteristicDebugDescription_On,
+    .properties = { .readable = true, .writable = true, .supportsEventNotification = true },
+    .callbacks = { .handleRead = HandleOnRead, .handleWrite = HandleOnWrite }
+};
+
+static const HAPIntCharacteristic brightnessCharacteristic = {
+    .format = kHAPCharacteristicFormat_Int,
+    .iid = kIID_LightBulbBrightness,
+    .characteristicType = &kHAPCharacteristicType_Brightness,
+    .debugDescription = kHAPCharacteristicDebugDescription_Brightness,
+    .properties = { .readable = true, .writable = true, .supportsEventNotification = true },
+    .units = kHAPCharacteristicUnits_Percentage,
+    .constraints = { .minimumValue = 0, .maximumValue = 100, .stepValue = 1 },
+    .callbacks = { .handleRead = HandleBrightnessRead, .handleWrite = HandleBrightnessWrite }
+};
+
+static const HAPService lightBulbService = {
+    .iid = kIID_LightBulb,
+    .serviceType = &kHAPServiceType_LightBulb,
+    .debugDescription = kHAPServiceDebugDescription_LightBulb,
+    .properties = { .primaryService = true },
+    .characteristics = (const HAPCharacteristic* const[]) { &onCharacteristic, &brightnessCharacteristic, NULL }
+};
+
+static const HAPAccessory accessory = { .aid = 1,
+                                        .category = kHAPAccessoryCategory_Lighting,
+                                        .name = "Acme Test",
+                                        .manufacturer = "Acme",
+                                        .model = "Test1,1",
+                                        .serialNumber = "099DB48E9E28",
+                                        .firmwareVersion = "1",
+                                        .hardwareVersion = "1",
+                                        .services = (const HAPService* const[]) { &accessoryInformationService,
+                                                                                  &hapProtocolInformationService,
+                                                                                  &pairingService,
+                                                                                  &lightBulbService,
+                                                                                  NULL },
+                                        .callbacks = { .identify = IdentifyAccessory } };
+
+static void HandleUpdatedAccessoryServerState(HAPAccessoryServerRef* server HAP_UNUSED, void* _Nullable context HAP_UNUSED) {
+}
+
+/** Accessory server. */
+static HAPAccessoryServerRef accessoryServer;
+
+int main() {
+    HAPPlatformCreate();
+
+    HAPAccessoryServerMetrics metrics;
+
+    // Without metrics storage, all metrics are reported as zero.
+    static HAPAccessoryServerRef serverWithoutMetrics;
+    HAPAccessoryServerGetMetrics(&serverWithoutMetrics, &metrics);
+    {
+        HAPAccessoryServerMetrics zeroMetrics;
+        HAPRawBufferZero(&zeroMetrics, sizeof zeroMetrics);
+        HAPAssert(HAPRawBufferAreEqual(&metrics, &zeroMetrics, sizeof metrics));
+    }
+
+    // Prepare accessory server storage.
+    static HAPIPSession ipSessions[kNumControllers];
+    static HAPIPSessionSlotRef ipSessionSlots[HAPArrayCount(ipSessions)];
+    static uint8_t ipInboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultInboundBufferSize];
+    static uint8_t ipOutboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultOutboundBufferSize];
+    static HAPIPEventNotificationRef
+            ipEventNotifications[HAPArrayCount(ipSessions)][kAttributeCount + kLightBulbAttributeCount];
+    for (size_t i = 0; i < HAPArrayCount(ipSessions); i++) {
+        ipSessions[i].inboundBuffer.bytes = ipInboundBuffers[i];
+        ipSessions[i].inboundBuffer.numBytes = sizeof ipInboundBuffers[i];
+        ipSessions[i].outboundBuffer.bytes = ipOutboundBuffers[i];
+        ipSessions[i].outboundBuffer.numBytes = sizeof ipOutboundBuffers[i];
+        ipSessions[i].eventNotifications = ipEventNotifications[i];
+        ipSessions[i].numEventNotifications = HAPArrayCount(ipEventNotifications[i]);
+    }
+    static HAPIPReadContextRef ipReadContexts[kAttributeCount + kLightBulbAttributeCount];
+    static HAPIPWriteContextRef ipWriteContexts[kAttributeCount + kLightBulbAttributeCount];
+    static uint8_t ipScratchBuffer[kHAPIPSession_DefaultScratchBufferSize];
+    static HAPIPAccessoryServerStorage ipAccessoryServerStorage = {
+        .sessions = ipSessions,
+        .numSessions = HAPArrayCount(ipSessions),
+        .sessionSlots = ipSessionSlots,
+        .readContexts = ipReadContexts,
+        .numReadContexts = HAPArrayCount(ipReadContexts),
+        .writeContexts = ipWriteContexts,
+        .numWriteContexts = HAPArrayCount(ipWriteContexts),
+        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer }
+    };
+
+    // Initialize accessory server.
+    static HAPAccessoryServerMetrics metricsStorage;
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ip = { .transport = &kHAPAccessoryServerTransport_IP,
+                            .accessoryServerStorage = &ipAccessoryServerStorage },
+                    .metrics = &metricsStorage },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+
+    // Start accessory server.
+    HAPAccessoryServerStart(&accessoryServer, &accessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+
+    // Register a paired admin controller.
+    HAPIPTestSessionAddPairing(&accessoryServer, /* key: */ 0, /* isAdmin: */ true);
+
+    // Connect controllers and establish security sessions as if Pair Verify had completed.
+    static HAPIPTestSession controllers[kNumControllers];
+    for (size_t i = 0; i < HAPArrayCount(controllers); i++) {
+        HAPIPTestSessionOpen(&controllers[i], &accessoryServer, /* pairingID: */ 0);
+    }
+
+    static char response[4096];
+    HAPIPTestSession* controller = &controllers[0];
+    test.brightness = 42;
+
+    HAPAccessoryServerGetMetrics(&accessoryServer, &metrics);
+    HAPAssert(metrics.sessions.numAccepted == 1);
+    HAPAssert(metrics.sessions.numRejected == 0);
+
+    // Requests are counted by endpoint.
+    HAPIPTestSessionSendRequest(controller, "GET /accessories HTTP/1.1\r\n\r\n");
+    HAPIPTestSessionReceiveResponse(controller, response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 200 ", 13));
+    HAPIPTestSessionSendRequest(controller, "GET /characteristics?id=1.49,1.50 HTTP/1.1\r\n\r\n");
+    HAPIPTestSessionReceiveResponse(controller, response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 200 ", 13));
+    HAPIPTestSessionSendWriteRequest(controller, "{\"characteristics\":[{\"aid\":1,\"iid\":49,\"value\":true}]}");
+    HAPIPTestSessionReceiveResponse(controller, response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 204 ", 13));
+    HAPIPTestSessionSendRequest(controller, "GET /unknown HTTP/1.1\r\n\r\n");
+    HAPIPTestSessionReceiveResponse(controller, response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 404 ", 13));
+
+    HAPAccessoryServerGetMetrics(&accessoryServer, &metrics);
+    HAPAssert(metrics.ipRequests.accessories == 1);
+    HAPAssert(metrics.ipRequests.getCharacteristics == 1);
+    HAPAssert(metrics.ipRequests.putCharacteristics == 1);
+    HAPAssert(metrics.ipRequests.other == 1);
+    HAPAssert(metrics.ipRequests.pairSetup == 0);
+    HAPAssert(metrics.ipRequests.pairVerify == 0);
+    HAPAssert(metrics.writeHandlerLatency.numSamples == 1);
+    HAPAssert(metrics.readHandlerLatency.numSamples >= 2);
+    HAPAssert(metrics.keyValueStoreLatency.numSamples > 0);
+
+    // All traffic of the session is encrypted.
+    HAPAssert(metrics.numDecryptedBytes == controller->numRequestBytes);
+    HAPAssert(metrics.numEncryptedBytes == controller->numResponseBytes);
+
+    // Events that are raised while an event notification is already pending are coalesced.
+    HAPIPTestSessionSendWriteRequest(controller, "{\"characteristics\":[{\"aid\":1,\"iid\":50,\"ev\":true}]}");
+    HAPIPTestSessionReceiveResponse(controller, response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 204 ", 13));
+    HAPPlatformClockAdvance(2 * HAPSecond);
+    test.brightness = 50;
+    HAPAccessoryServerRaiseEvent(&accessoryServer, &brightnessCharacteristic, &lightBulbService, &accessory);
+    HAPAccessoryServerRaiseEvent(&accessoryServer, &brightnessCharacteristic, &lightBulbService, &accessory);
+    HAPIPTestSessionReceiveResponse(controller, response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "EVENT/1.0 200 ", 14));
+    HAPAssert(HAPIPTestStringContains(response, "{\"aid\":1,\"iid\":50,\"value\":50}"));
+
+    HAPAccessoryServerGetMetrics(&accessoryServer, &metrics);
+    HAPAssert(metrics.eventNotifications.numSent == 1);
+    HAPAssert(metrics.eventNotifications.numCoalesced == 1);
+    HAPAssert(metrics.eventNotifications.numDropped == 0);
+    HAPAssert(metrics.numBufferFullConditions == 0);
+    HAPAssert(metrics.numDecryptedBytes == controller->numRequestBytes);
+    HAPAssert(metrics.numEncryptedBytes == controller->numResponseBytes);
+
+    HAPIPTestSessionClose(controller);
+
+    // Latency samples are sorted into fixed buckets.
+    {
+        HAPMetricsHistogram histogram;
+        HAPRawBufferZero(&histogram, sizeof histogram);
+        HAPTime now = HAPPlatformClockGetCurrent();
+        HAPMetricsHistogramAddSample(&histogram, now);
+        HAPMetricsHistogramAddSample(&histogram, now - 7 * HAPMillisecond);
+        HAPMetricsHistogramAddSample(&histogram, now - 100 * HAPMillisecond);
+        HAPAssert(histogram.buckets[0] == 1);
+        HAPAssert(histogram.buckets[3] == 1);
+        HAPAssert(histogram.buckets[kHAPMetricsHistogram_NumBuckets - 1] == 1);
+        HAPAssert(histogram.numSamples == 3);
+        HAPAssert(histogram.totalDuration == 107 * HAPMillisecond);
+        HAPAssert(histogram.maxDuration == 100 * HAPMillisecond);
+    }
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+#include "HAPPlatformBLEPeripheralManager+Test.h"
+
+#include "Harness/TemplateDB.c"
+
+static void HandleUpdatedAccessoryServerState(HAPAccessoryServerRef* server HAP_UNUSED, void* _Nullable context HAP_UNUSED) {
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError IdentifyAccessory(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPAccessoryIdentifyRequest* request HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    HAPFatalError();
+}
+
+static const HAPAccessory accessory = { .aid = 1,
+                                        .category = kHAPAccessoryCategory_Other,
+                                        .name = "Acme Test",
+                                        .manufacturer = "Acme",
+                                        .model = "Test1,1",
+                                        .serialNumber = "099DB48E9E28",
+                                        .firmwareVersion = "1",
+                                        .hardwareVersion = "1",
+                                        .services = (const HAPService* const[]) { &accessoryInformationService,
+                                                                                  &hapProtocolInformationService,
+                                                                                  &pairingService,
+                                                                                  NULL },
+                                        .callbacks = { .identify = IdentifyAccessory } };
+
+int main() {
+    HAPPlatformCreate();
+
+    // Prepare accessory server storage.
+    static HAPBLEGATTTableElementRef gattTableElements[kAttributeCount];
+    static HAPBLESessionCacheElementRef sessionCacheElements[kHAPBLESessionCache_MinElements];
+    static HAPSessionRef session;
+    static uint8_t procedureBytes[2048];
+    static HAPBLEProcedureRef procedures[1];
+    static HAPBLEAccessoryServerStorage bleAccessoryServerStorage = {
+        .gattTableElements = gattTableElements,
+        .numGATTTableElements = HAPArrayCount(gattTableElements),
+        .sessionCacheElements = sessionCacheElements,
+        .numSessionCacheElements = HAPArrayCount(sessionCacheElements),
+        .session = &session,
+        .procedures = procedures,
+        .numProcedures = HAPArrayCount(procedures),
+        .procedureBuffer = { .bytes = procedureBytes, .numBytes = sizeof procedureBytes },
+    };
+
+    // Initialize accessory server.
+    static HAPAccessoryServerRef accessoryServer;
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ble = { .transport = &kHAPAccessoryServerTransport_BLE,
+                             .accessoryServerStorage = &bleAccessoryServerStorage,
+                             .preferredAdvertisingInterval = kHAPBLEAdvertisingInterval_Minimum,
+                             .preferredNotificationDuration = kHAPBLENotification_MinDuration } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+
+    // Setup hashes are only recomputed when the setup ID or the Device ID changes.
+    {
+        const HAPSetupID setupID = { .stringValue = "7OSX" };
+        const HAPSetupID otherSetupID = { .stringValue = "8OSX" };
+        const HAPDeviceIDString deviceIDString = { .stringValue = "00:11:22:33:44:55" };
+
+        HAPAccessorySetupSetupHash expectedSetupHash;
+        HAPAccessorySetupGetSetupHash(&expectedSetupHash, &setupID, &deviceIDString);
+        for (size_t i = 0; i < 2; i++) {
+            HAPAccessorySetupSetupHash setupHash;
+            HAPAccessorySetupInfoGetSetupHash(&accessoryServer, &setupHash, &setupID, &deviceIDString);
+            HAPAssert(HAPRawBufferAreEqual(&setupHash, &expectedSetupHash, sizeof setupHash));
+        }
+
+        HAPAccessorySetupGetSetupHash(&expectedSetupHash, &otherSetupID, &deviceIDString);
+        HAPAccessorySetupSetupHash setupHash;
+        HAPAccessorySetupInfoGetSetupHash(&accessoryServer, &setupHash, &otherSetupID, &deviceIDString);
+        HAPAssert(HAPRawBufferAreEqual(&setupHash, &expectedSetupHash, sizeof setupHash));
+    }
+
+    // Start accessory server.
+    HAPAccessoryServerStart(&accessoryServer, &accessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+    HAPAssert(HAPPlatformBLEPeripheralManagerIsAdvertising(platform.ble.blePeripheralManager));
+    size_t numAdvertisingStarts =
+            HAPPlatformBLEPeripheralManagerGetNumAdvertisingStarts(platform.ble.blePeripheralManager);
+    HAPAssert(numAdvertisingStarts);
+
+    // Advertisement is not restarted if it did not change.
+    HAPAccessoryServerUpdateAdvertisingData(&accessoryServer);
+    HAPAccessoryServerUpdateAdvertisingData(&accessoryServer);
+    HAPAssert(HAPPlatformBLEPeripheralManagerIsAdvertising(platform.ble.blePeripheralManager));
+    HAPAssert(
+            HAPPlatformBLEPeripheralManagerGetNumAdvertisingStarts(platform.ble.blePeripheralManager) ==
+            numAdvertisingStarts);
+
+    // Advertisement is restarted when the advertising interval changes after the initial fast advertising period.
+    HAPPlatformClockAdvance(HAPMinute);
+    HAPAssert(HAPPlatformBLEPeripheralManagerIsAdvertising(platform.ble.blePeripheralManager));
+    HAPAssert(
+            HAPPlatformBLEPeripheralManagerGetNumAdvertisingStarts(platform.ble.blePeripheralManager) >
+            numAdvertisingStarts);
+    numAdvertisingStarts = HAPPlatformBLEPeripheralManagerGetNumAdvertisingStarts(platform.ble.blePeripheralManager);
+    HAPAccessoryServerUpdateAdvertisingData(&accessoryServer);
+    HAPAssert(
+            HAPPlatformBLEPeripheralManagerGetNumAdvertisingStarts(platform.ble.blePeripheralManager) ==
+            numAdvertisingStarts);
+
+    // Advertisement is republished after a restart of the accessory server.
+    HAPAccessoryServerStop(&accessoryServer);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Idle);
+    HAPAssert(!HAPPlatformBLEPeripheralManagerIsAdvertising(platform.ble.blePeripheralManager));
+    HAPAccessoryServerStart(&accessoryServer, &accessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+    HAPAssert(HAPPlatformBLEPeripheralManagerIsAdvertising(platform.ble.blePeripheralManager));
+    HAPAssert(
+            HAPPlatformBLEPeripheralManagerGetNumAdvertisingStarts(platform.ble.blePeripheralManager) >
+            numAdvertisingStarts);
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+#include "HAPPlatformBLEPeripheralManager+Init.h"
+
+#include "Harness/HAPBLETestAccessory.c"
+#include "Harness/TemplateDB.c"
+
+int main() {
+    HAPError err;
+    HAPPlatformCreate();
+
+    // Prepare accessory server storage.
+    static HAPBLEGATTTableElementRef gattTableElements[kHAPBLETestAccessory_NumAttributes];
+    static uint16_t
+            attributeHandleIndex[kHAPBLEAttributeHandleIndex_NumElementsPerGATTTableElement *
+                                 kHAPBLETestAccessory_NumAttributes];
+    static HAPBLESessionCacheElementRef sessionCacheElements[kHAPBLESessionCache_MinElements];
+    static HAPSessionRef session;
+    static uint8_t procedureBytes[2048];
+    static HAPBLEProcedureRef procedures[1];
+    static HAPBLEAccessoryServerStorage bleAccessoryServerStorage = {
+        .gattTableElements = gattTableElements,
+        .numGATTTableElements = HAPArrayCount(gattTableElements),
+        .attributeHandleIndex = attributeHandleIndex,
+        .numAttributeHandleIndexElements = HAPArrayCount(attributeHandleIndex),
+        .sessionCacheElements = sessionCacheElements,
+        .numSessionCacheElements = HAPArrayCount(sessionCacheElements),
+        .session = &session,
+        .procedures = procedures,
+        .numProcedures = HAPArrayCount(procedures),
+        .procedureBuffer = { .bytes = procedureBytes, .numBytes = sizeof procedureBytes },
+    };
+
+    // Initialize accessory server.
+    static HAPAccessoryServerRef accessoryServer;
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ble = { .transport = &kHAPAccessoryServerTransport_BLE,
+                             .accessoryServerStorage = &bleAccessoryServerStorage,
+                             .preferredAdvertisingInterval = kHAPBLEAdvertisingInterval_Minimum,
+                             .preferredNotificationDuration = kHAPBLENotification_MinDuration } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HAPBLETestAccessoryHandleUpdatedState },
+            /* context: */ NULL);
+
+    // Start accessory server.
+    HAPAccessoryServerStart(&accessoryServer, &bleTestAccessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+
+    // The attribute handle index is in use.
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) &accessoryServer;
+    HAPAssert(server->ble.attributeHandleIndex.numHandles);
+    HAPAssert(server->ble.attributeHandleIndex.numHandles <= HAPArrayCount(attributeHandleIndex));
+
+    // Connect central.
+    HAPPlatformBLEPeripheralManager* blePeripheralManager = HAPNonnull(platform.ble.blePeripheralManager);
+    HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle = 1;
+    HAPAssert(blePeripheralManager->delegate.handleConnectedCentral);
+    blePeripheralManager->delegate.handleConnectedCentral(
+            blePeripheralManager, connectionHandle, blePeripheralManager->delegate.context);
+
+    // Resolve every attribute handle that is linked to a GATT table element.
+    // In builds with assertions enabled, every lookup is checked against a search of the GATT table.
+    size_t numInstanceIDHandles = 0;
+    size_t numCCCDescriptorHandles = 0;
+    for (size_t i = 0; i < blePeripheralManager->numAttributes; i++) {
+        const HAPPlatformBLEPeripheralManagerAttribute* attribute = &blePeripheralManager->attributes[i];
+        uint8_t bytes[2];
+        switch (attribute->type) {
+            case kHAPPlatformBLEPeripheralManagerAttributeType_None:
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Service: {
+            } break;
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Characteristic: {
+                if (!attribute->_.characteristic.properties.write) {
+                    // Service Instance ID characteristic.
+                    HAPWriteLittleUInt16(bytes, 0);
+                    err = blePeripheralManager->delegate.handleWriteRequest(
+                            blePeripheralManager,
+                            connectionHandle,
+                            attribute->_.characteristic.valueHandle,
+                            bytes,
+                            sizeof bytes,
+                            blePeripheralManager->delegate.context);
+                    HAPAssert(err == kHAPError_InvalidState);
+                    numInstanceIDHandles++;
+                }
+                if (attribute->_.characteristic.cccDescriptorHandle) {
+                    HAPWriteLittleUInt16(bytes, 0x0002);
+                    err = blePeripheralManager->delegate.handleWriteRequest(
+                            blePeripheralManager,
+                            connectionHandle,
+                            attribute->_.characteristic.cccDescriptorHandle,
+                            bytes,
+                            sizeof bytes,
+                            blePeripheralManager->delegate.context);
+                    HAPAssert(!err);
+                    HAPWriteLittleUInt16(bytes, 0);
+                    err = blePeripheralManager->delegate.handleWriteRequest(
+                            blePeripheralManager,
+                            connectionHandle,
+                            attribute->_.characteristic.cccDescriptorHandle,
+                            bytes,
+                            sizeof bytes,
+                            blePeripheralManager->delegate.context);
+                    HAPAssert(!err);
+                    numCCCDescriptorHandles++;
+                }
+            } break;
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Descriptor: {
+                // Characteristic Instance ID descriptor.
+                HAPWriteLittleUInt16(bytes, 0);
+                err = blePeripheralManager->delegate.handleWriteRequest(
+                        blePeripheralManager,
+                        connectionHandle,
+                        attribute->_.descriptor.handle,
+                        bytes,
+                        sizeof bytes,
+                        blePeripheralManager->delegate.context);
+                HAPAssert(err == kHAPError_InvalidState);
+                numInstanceIDHandles++;
+            } break;
+        }
+    }
+    HAPAssert(numInstanceIDHandles == kHAPBLETestAccessory_NumAttributes);
+    // On, Brightness and Hue.
+    HAPAssert(numCCCDescriptorHandles == 3);
+
+    return 0;
+}
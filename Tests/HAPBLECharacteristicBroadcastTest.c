@@ -0,0 +1,187 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+#include "Harness/HAPBLETestAccessory.c"
+#include "Harness/TemplateDB.c"
+
+/**
+ * Checks the broadcast configuration of a characteristic.
+ */
+static void VerifyBroadcastConfiguration(
+        HAPAccessoryServerRef* server,
+        const HAPCharacteristic* characteristic,
+        bool expectedBroadcastsEnabled,
+        HAPBLECharacteristicBroadcastInterval expectedBroadcastInterval) {
+    bool broadcastsEnabled;
+    HAPBLECharacteristicBroadcastInterval broadcastInterval;
+    HAPBLECharacteristicGetBroadcastConfiguration(
+            server, characteristic, &lightBulbService, &bleTestAccessory, &broadcastsEnabled, &broadcastInterval);
+    HAPAssert(broadcastsEnabled == expectedBroadcastsEnabled);
+    if (broadcastsEnabled) {
+        HAPAssert(broadcastInterval == expectedBroadcastInterval);
+    }
+}
+
+int main() {
+    HAPError err;
+    HAPPlatformCreate();
+
+    // Prepare accessory server storage.
+    static HAPBLEGATTTableElementRef gattTableElements[kHAPBLETestAccessory_NumAttributes];
+    static HAPBLESessionCacheElementRef sessionCacheElements[kHAPBLESessionCache_MinElements];
+    static HAPSessionRef session;
+    static uint8_t procedureBytes[2048];
+    static HAPBLEProcedureRef procedures[1];
+    static HAPBLEAccessoryServerStorage bleAccessoryServerStorage = {
+        .gattTableElements = gattTableElements,
+        .numGATTTableElements = HAPArrayCount(gattTableElements),
+        .sessionCacheElements = sessionCacheElements,
+        .numSessionCacheElements = HAPArrayCount(sessionCacheElements),
+        .session = &session,
+        .procedures = procedures,
+        .numProcedures = HAPArrayCount(procedures),
+        .procedureBuffer = { .bytes = procedureBytes, .numBytes = sizeof procedureBytes },
+    };
+
+    // Initialize accessory server.
+    static HAPAccessoryServerRef accessoryServer;
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ble = { .transport = &kHAPAccessoryServerTransport_BLE,
+                             .accessoryServerStorage = &bleAccessoryServerStorage,
+                             .preferredAdvertisingInterval = kHAPBLEAdvertisingInterval_Minimum,
+                             .preferredNotificationDuration = kHAPBLENotification_MinDuration } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HAPBLETestAccessoryHandleUpdatedState },
+            /* context: */ NULL);
+
+    // Start accessory server.
+    HAPAccessoryServerStart(&accessoryServer, &bleTestAccessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+
+    // Broadcasts are disabled by default.
+    VerifyBroadcastConfiguration(&accessoryServer, &lightBulbOnCharacteristic, false, 0);
+    VerifyBroadcastConfiguration(&accessoryServer, &lightBulbBrightnessCharacteristic, false, 0);
+    VerifyBroadcastConfiguration(&accessoryServer, &lightBulbHueCharacteristic, false, 0);
+
+    // Enable broadcasts out of order.
+    err = HAPBLECharacteristicEnableBroadcastNotifications(
+            &accessoryServer,
+            &lightBulbHueCharacteristic,
+            &lightBulbService,
+            &bleTestAccessory,
+            kHAPBLECharacteristicBroadcastInterval_2560Ms);
+    HAPAssert(!err);
+    err = HAPBLECharacteristicEnableBroadcastNotifications(
+            &accessoryServer,
+            &lightBulbOnCharacteristic,
+            &lightBulbService,
+            &bleTestAccessory,
+            kHAPBLECharacteristicBroadcastInterval_20Ms);
+    HAPAssert(!err);
+    err = HAPBLECharacteristicEnableBroadcastNotifications(
+            &accessoryServer,
+            &lightBulbBrightnessCharacteristic,
+            &lightBulbService,
+            &bleTestAccessory,
+            kHAPBLECharacteristicBroadcastInterval_20Ms);
+    HAPAssert(!err);
+    err = HAPBLECharacteristicEnableBroadcastNotifications(
+            &accessoryServer,
+            &lightBulbBrightnessCharacteristic,
+            &lightBulbService,
+            &bleTestAccessory,
+            kHAPBLECharacteristicBroadcastInterval_1280Ms);
+    HAPAssert(!err);
+    VerifyBroadcastConfiguration(
+            &accessoryServer, &lightBulbOnCharacteristic, true, kHAPBLECharacteristicBroadcastInterval_20Ms);
+    VerifyBroadcastConfiguration(
+            &accessoryServer, &lightBulbBrightnessCharacteristic, true, kHAPBLECharacteristicBroadcastInterval_1280Ms);
+    VerifyBroadcastConfiguration(
+            &accessoryServer, &lightBulbHueCharacteristic, true, kHAPBLECharacteristicBroadcastInterval_2560Ms);
+
+    // The configuration is stored sorted by characteristic ID.
+    {
+        uint8_t bytes[kHAPBLECharacteristic_BroadcastConfigurationBufferSize];
+        size_t numBytes;
+        bool found;
+        err = HAPPlatformKeyValueStoreGet(
+                platform.keyValueStore,
+                kHAPKeyValueStoreDomain_CharacteristicConfiguration,
+                0,
+                bytes,
+                sizeof bytes,
+                &numBytes,
+                &found);
+        HAPAssert(!err);
+        HAPAssert(found);
+        const uint8_t expectedBytes[] = { 0x01, 0x00, 0x31, 0x00, 0x01, 0x32, 0x00, 0x02, 0x33, 0x00, 0x03 };
+        HAPAssert(numBytes == sizeof expectedBytes);
+        HAPAssert(HAPRawBufferAreEqual(bytes, expectedBytes, sizeof expectedBytes));
+    }
+
+    // Reads are served without accessing the key-value store.
+    err = HAPPlatformKeyValueStorePurgeDomain(
+            platform.keyValueStore, kHAPKeyValueStoreDomain_CharacteristicConfiguration);
+    HAPAssert(!err);
+    VerifyBroadcastConfiguration(
+            &accessoryServer, &lightBulbBrightnessCharacteristic, true, kHAPBLECharacteristicBroadcastInterval_1280Ms);
+
+    // Disable broadcasts. The remaining configuration is stored.
+    err = HAPBLECharacteristicDisableBroadcastNotifications(
+            &accessoryServer, &lightBulbBrightnessCharacteristic, &lightBulbService, &bleTestAccessory);
+    HAPAssert(!err);
+    err = HAPBLECharacteristicDisableBroadcastNotifications(
+            &accessoryServer, &lightBulbBrightnessCharacteristic, &lightBulbService, &bleTestAccessory);
+    HAPAssert(!err);
+    VerifyBroadcastConfiguration(
+            &accessoryServer, &lightBulbOnCharacteristic, true, kHAPBLECharacteristicBroadcastInterval_20Ms);
+    VerifyBroadcastConfiguration(&accessoryServer, &lightBulbBrightnessCharacteristic, false, 0);
+    VerifyBroadcastConfiguration(
+            &accessoryServer, &lightBulbHueCharacteristic, true, kHAPBLECharacteristicBroadcastInterval_2560Ms);
+
+    // The configuration is loaded when the accessory server is started again.
+    HAPAccessoryServerStop(&accessoryServer);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Idle);
+    HAPAccessoryServerStart(&accessoryServer, &bleTestAccessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+    VerifyBroadcastConfiguration(
+            &accessoryServer, &lightBulbOnCharacteristic, true, kHAPBLECharacteristicBroadcastInterval_20Ms);
+    VerifyBroadcastConfiguration(&accessoryServer, &lightBulbBrightnessCharacteristic, false, 0);
+    VerifyBroadcastConfiguration(
+            &accessoryServer, &lightBulbHueCharacteristic, true, kHAPBLECharacteristicBroadcastInterval_2560Ms);
+
+    // Removing the last configuration removes the key-value store entry.
+    err = HAPBLECharacteristicDisableBroadcastNotifications(
+            &accessoryServer, &lightBulbOnCharacteristic, &lightBulbService, &bleTestAccessory);
+    HAPAssert(!err);
+    err = HAPBLECharacteristicDisableBroadcastNotifications(
+            &accessoryServer, &lightBulbHueCharacteristic, &lightBulbService, &bleTestAccessory);
+    HAPAssert(!err);
+    {
+        bool found;
+        err = HAPPlatformKeyValueStoreGet(
+                platform.keyValueStore,
+                kHAPKeyValueStoreDomain_CharacteristicConfiguration,
+                0,
+                NULL,
+                0,
+                NULL,
+                &found);
+        HAPAssert(!err);
+        HAPAssert(!found);
+    }
+
+    return 0;
+}
@@ -0,0 +1,271 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+#include "HAPPlatformBLEPeripheralManager+Init.h"
+#include "HAPPlatformBLEPeripheralManager+Test.h"
+
+#include "Harness/HAPBLETestAccessory.c"
+#include "Harness/TemplateDB.c"
+
+/** Same accessory with a different GATT database layout. */
+static const HAPAccessory changedAccessory = { .aid = 1,
+                                               .category = kHAPAccessoryCategory_Other,
+                                               .name = "Acme Test",
+                                               .manufacturer = "Acme",
+                                               .model = "Test1,1",
+                                               .serialNumber = "099DB48E9E28",
+                                               .firmwareVersion = "1",
+                                               .hardwareVersion = "1",
+                                               .services =
+                                                       (const HAPService* const[]) { &accessoryInformationService,
+                                                                                     &hapProtocolInformationService,
+                                                                                     &pairingService,
+                                                                                     NULL },
+                                               .callbacks = { .identify = HAPBLETestAccessoryIdentify } };
+
+/** Number of GATT attributes that are published for a number of services and characteristics. */
+#define NumGATTDatabaseAttributes(numAttributes) \
+    (kHAPBLEGATTDatabase_NumAttributesPerGATTTableElement * (numAttributes))
+
+static HAPAccessoryServerRef accessoryServer;
+
+/**
+ * Gets the attribute handles of the published GATT database.
+ *
+ * @param[out] handles              Attribute handles, one per GATT attribute.
+ * @param      numGATTAttributes    Number of GATT attributes that are expected to be published.
+ */
+static void GetAttributeHandles(HAPPlatformBLEPeripheralManagerAttributeHandle* handles, size_t numGATTAttributes) {
+    const HAPPlatformBLEPeripheralManager* blePeripheralManager = HAPNonnull(platform.ble.blePeripheralManager);
+    HAPAssert(blePeripheralManager->didPublishAttributes);
+    HAPAssert(numGATTAttributes < blePeripheralManager->numAttributes);
+
+    for (size_t i = 0; i < numGATTAttributes; i++) {
+        const HAPPlatformBLEPeripheralManagerAttribute* attribute = &blePeripheralManager->attributes[i];
+        switch (attribute->type) {
+            case kHAPPlatformBLEPeripheralManagerAttributeType_None: {
+                HAPFatalError();
+            }
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Service: {
+                handles[i] = attribute->_.service.handle;
+            } break;
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Characteristic: {
+                handles[i] = attribute->_.characteristic.valueHandle;
+            } break;
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Descriptor: {
+                handles[i] = attribute->_.descriptor.handle;
+            } break;
+        }
+    }
+    HAPAssert(blePeripheralManager->attributes[numGATTAttributes].type ==
+              kHAPPlatformBLEPeripheralManagerAttributeType_None);
+}
+
+/**
+ * Resolves every published attribute handle that is linked to a BLE GATT table element.
+ *
+ * @param      numInstanceIDHandles Number of Instance ID characteristics and descriptors that are expected.
+ */
+static void ResolveAttributeHandles(size_t numInstanceIDHandles) {
+    HAPPlatformBLEPeripheralManager* blePeripheralManager = HAPNonnull(platform.ble.blePeripheralManager);
+
+    HAPError err;
+
+    // Connect central.
+    HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle = 1;
+    blePeripheralManager->delegate.handleConnectedCentral(
+            blePeripheralManager, connectionHandle, blePeripheralManager->delegate.context);
+
+    // Write to the Instance ID characteristics and descriptors and enable and disable indications.
+    // Attribute handles that are not linked to the BLE GATT table fail a precondition.
+    size_t numResolvedHandles = 0;
+    for (size_t i = 0; i < blePeripheralManager->numAttributes; i++) {
+        const HAPPlatformBLEPeripheralManagerAttribute* attribute = &blePeripheralManager->attributes[i];
+        uint8_t bytes[2];
+        HAPPlatformBLEPeripheralManagerAttributeHandle instanceIDHandle = 0;
+        switch (attribute->type) {
+            case kHAPPlatformBLEPeripheralManagerAttributeType_None:
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Service: {
+            } break;
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Characteristic: {
+                if (!attribute->_.characteristic.properties.write) {
+                    // Service Instance ID characteristic.
+                    instanceIDHandle = attribute->_.characteristic.valueHandle;
+                }
+                if (attribute->_.characteristic.cccDescriptorHandle) {
+                    HAPWriteLittleUInt16(bytes, 0x0002);
+                    err = blePeripheralManager->delegate.handleWriteRequest(
+                            blePeripheralManager,
+                            connectionHandle,
+                            attribute->_.characteristic.cccDescriptorHandle,
+                            bytes,
+                            sizeof bytes,
+                            blePeripheralManager->delegate.context);
+                    HAPAssert(!err);
+                    HAPWriteLittleUInt16(bytes, 0);
+                    err = blePeripheralManager->delegate.handleWriteRequest(
+                            blePeripheralManager,
+                            connectionHandle,
+                            attribute->_.characteristic.cccDescriptorHandle,
+                            bytes,
+                            sizeof bytes,
+                            blePeripheralManager->delegate.context);
+                    HAPAssert(!err);
+                }
+            } break;
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Descriptor: {
+                // Characteristic Instance ID descriptor.
+                instanceIDHandle = attribute->_.descriptor.handle;
+            } break;
+        }
+        if (instanceIDHandle) {
+            HAPWriteLittleUInt16(bytes, 0);
+            err = blePeripheralManager->delegate.handleWriteRequest(
+                    blePeripheralManager,
+                    connectionHandle,
+                    instanceIDHandle,
+                    bytes,
+                    sizeof bytes,
+                    blePeripheralManager->delegate.context);
+            HAPAssert(err == kHAPError_InvalidState);
+            numResolvedHandles++;
+        }
+    }
+    HAPAssert(numResolvedHandles == numInstanceIDHandles);
+
+    // Disconnect central.
+    blePeripheralManager->delegate.handleDisconnectedCentral(
+            blePeripheralManager, connectionHandle, blePeripheralManager->delegate.context);
+    HAPPlatformClockAdvance(0);
+}
+
+/**
+ * Gets the GATT database fingerprint from the key-value store.
+ */
+static void GetStoredFingerprint(HAPPlatformBLEPeripheralManagerDatabaseFingerprint* fingerprint) {
+    HAPError err;
+
+    bool found;
+    size_t numBytes;
+    err = HAPPlatformKeyValueStoreGet(
+            platform.keyValueStore,
+            kHAPKeyValueStoreDomain_Configuration,
+            kHAPKeyValueStoreKey_Configuration_BLEGATTDatabaseFingerprint,
+            fingerprint->bytes,
+            sizeof fingerprint->bytes,
+            &numBytes,
+            &found);
+    HAPAssert(!err);
+    HAPAssert(found);
+    HAPAssert(numBytes == sizeof fingerprint->bytes);
+}
+
+static void StartAccessoryServer(const HAPAccessory* accessory_) {
+    HAPAccessoryServerStart(&accessoryServer, accessory_);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+}
+
+static void StopAccessoryServer(void) {
+    HAPAccessoryServerStop(&accessoryServer);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Idle);
+}
+
+int main() {
+    HAPPlatformCreate();
+    HAPPlatformBLEPeripheralManagerRef blePeripheralManager = HAPNonnull(platform.ble.blePeripheralManager);
+
+    // Prepare accessory server storage.
+    static HAPBLEGATTTableElementRef gattTableElements[kHAPBLETestAccessory_NumAttributes];
+    static HAPPlatformBLEPeripheralManagerGATTAttribute
+            gattDatabaseAttributes[kHAPBLEGATTDatabase_NumAttributesPerGATTTableElement *
+                                   kHAPBLETestAccessory_NumAttributes];
+    static HAPBLESessionCacheElementRef sessionCacheElements[kHAPBLESessionCache_MinElements];
+    static HAPSessionRef session;
+    static uint8_t procedureBytes[2048];
+    static HAPBLEProcedureRef procedures[1];
+    static HAPBLEAccessoryServerStorage bleAccessoryServerStorage = {
+        .gattTableElements = gattTableElements,
+        .numGATTTableElements = HAPArrayCount(gattTableElements),
+        .gattDatabaseAttributes = gattDatabaseAttributes,
+        .numGATTDatabaseAttributes = HAPArrayCount(gattDatabaseAttributes),
+        .sessionCacheElements = sessionCacheElements,
+        .numSessionCacheElements = HAPArrayCount(sessionCacheElements),
+        .session = &session,
+        .procedures = procedures,
+        .numProcedures = HAPArrayCount(procedures),
+        .procedureBuffer = { .bytes = procedureBytes, .numBytes = sizeof procedureBytes },
+    };
+    const HAPAccessoryServerOptions options = {
+        .maxPairings = kHAPPairingStorage_MinElements,
+        .ble = { .transport = &kHAPAccessoryServerTransport_BLE,
+                 .accessoryServerStorage = &bleAccessoryServerStorage,
+                 .preferredAdvertisingInterval = kHAPBLEAdvertisingInterval_Minimum,
+                 .preferredNotificationDuration = kHAPBLENotification_MinDuration }
+    };
+    const HAPAccessoryServerCallbacks callbacks = { .handleUpdatedState = HAPBLETestAccessoryHandleUpdatedState };
+
+    // Initialize accessory server.
+    HAPAccessoryServerCreate(&accessoryServer, &options, &platform, &callbacks, /* context: */ NULL);
+
+    // The GATT database is published in a single registration, and its fingerprint is stored.
+    size_t numRegistrations = HAPPlatformBLEPeripheralManagerGetNumDatabaseRegistrations(blePeripheralManager);
+    StartAccessoryServer(&bleTestAccessory);
+    HAPAssert(HAPPlatformBLEPeripheralManagerGetNumDatabaseRegistrations(blePeripheralManager) == numRegistrations + 1);
+    static HAPPlatformBLEPeripheralManagerAttributeHandle
+            handles[NumGATTDatabaseAttributes(kHAPBLETestAccessory_NumAttributes)];
+    GetAttributeHandles(handles, HAPArrayCount(handles));
+    ResolveAttributeHandles(kHAPBLETestAccessory_NumAttributes);
+    HAPPlatformBLEPeripheralManagerDatabaseFingerprint fingerprint;
+    GetStoredFingerprint(&fingerprint);
+
+    // The GATT database is kept while the accessory server is stopped.
+    // Restarting with an unchanged layout does not register it again and keeps all attribute handles.
+    for (int i = 0; i < 3; i++) {
+        StopAccessoryServer();
+        HAPAssert(blePeripheralManager->didPublishAttributes);
+        StartAccessoryServer(&bleTestAccessory);
+        HAPAssert(
+                HAPPlatformBLEPeripheralManagerGetNumDatabaseRegistrations(blePeripheralManager) ==
+                numRegistrations + 1);
+        static HAPPlatformBLEPeripheralManagerAttributeHandle restartedHandles[HAPArrayCount(handles)];
+        GetAttributeHandles(restartedHandles, HAPArrayCount(restartedHandles));
+        HAPAssert(HAPRawBufferAreEqual(restartedHandles, handles, sizeof handles));
+        ResolveAttributeHandles(kHAPBLETestAccessory_NumAttributes);
+        HAPPlatformBLEPeripheralManagerDatabaseFingerprint storedFingerprint;
+        GetStoredFingerprint(&storedFingerprint);
+        HAPAssert(HAPRawBufferAreEqual(storedFingerprint.bytes, fingerprint.bytes, sizeof fingerprint.bytes));
+    }
+
+    // A changed layout is registered again, and the new fingerprint is stored.
+    StopAccessoryServer();
+    StartAccessoryServer(&changedAccessory);
+    HAPAssert(HAPPlatformBLEPeripheralManagerGetNumDatabaseRegistrations(blePeripheralManager) == numRegistrations + 2);
+    GetAttributeHandles(handles, NumGATTDatabaseAttributes(kAttributeCount));
+    ResolveAttributeHandles(kAttributeCount);
+    HAPPlatformBLEPeripheralManagerDatabaseFingerprint changedFingerprint;
+    GetStoredFingerprint(&changedFingerprint);
+    HAPAssert(!HAPRawBufferAreEqual(changedFingerprint.bytes, fingerprint.bytes, sizeof fingerprint.bytes));
+
+    // Releasing the accessory server removes the GATT database.
+    // The BLE peripheral manager holds it in RAM, so it is registered again even though the fingerprint matches.
+    StopAccessoryServer();
+    HAPAccessoryServerRelease(&accessoryServer);
+    HAPAssert(!blePeripheralManager->didPublishAttributes);
+    HAPAccessoryServerCreate(&accessoryServer, &options, &platform, &callbacks, /* context: */ NULL);
+    StartAccessoryServer(&changedAccessory);
+    HAPAssert(HAPPlatformBLEPeripheralManagerGetNumDatabaseRegistrations(blePeripheralManager) == numRegistrations + 3);
+    GetAttributeHandles(handles, NumGATTDatabaseAttributes(kAttributeCount));
+    ResolveAttributeHandles(kAttributeCount);
+    HAPPlatformBLEPeripheralManagerDatabaseFingerprint storedFingerprint;
+    GetStoredFingerprint(&storedFingerprint);
+    HAPAssert(HAPRawBufferAreEqual(storedFingerprint.bytes, changedFingerprint.bytes, sizeof fingerprint.bytes));
+
+    return 0;
+}
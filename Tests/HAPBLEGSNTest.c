@@ -0,0 +1,182 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+#include "HAPPlatformBLEPeripheralManager+Init.h"
+
+#include "Harness/HAPBLETestAccessory.c"
+#include "Harness/TemplateDB.c"
+
+/**
+ * Reads the GSN that is stored in the key-value store.
+ *
+ * @param[out] isReserved           Whether the stored GSN is a reserved GSN.
+ *
+ * @return Stored GSN.
+ */
+static uint16_t GetStoredGSN(bool* isReserved) {
+    HAPError err;
+
+    bool found;
+    size_t numBytes;
+    uint8_t gsnBytes[3];
+    err = HAPPlatformKeyValueStoreGet(
+            platform.keyValueStore,
+            kHAPKeyValueStoreDomain_Configuration,
+            kHAPKeyValueStoreKey_Configuration_BLEGSN,
+            gsnBytes,
+            sizeof gsnBytes,
+            &numBytes,
+            &found);
+    HAPAssert(!err);
+    HAPAssert(found);
+    HAPAssert(numBytes == sizeof gsnBytes);
+    *isReserved = (gsnBytes[2] & 0x02U) == 0x02U;
+    return HAPReadLittleUInt16(&gsnBytes[0]);
+}
+
+/**
+ * Changes the characteristic value while disconnected and cycles a connection to allow the next GSN increment.
+ */
+static void RaiseDisconnectedEvent(HAPAccessoryServerRef* accessoryServer) {
+    HAPAccessoryServerRaiseEvent(accessoryServer, &lightBulbOnCharacteristic, &lightBulbService, &bleTestAccessory);
+
+    HAPPlatformBLEPeripheralManager* blePeripheralManager = HAPNonnull(platform.ble.blePeripheralManager);
+    HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle = 1;
+    blePeripheralManager->delegate.handleConnectedCentral(
+            blePeripheralManager, connectionHandle, blePeripheralManager->delegate.context);
+    blePeripheralManager->delegate.handleDisconnectedCentral(
+            blePeripheralManager, connectionHandle, blePeripheralManager->delegate.context);
+}
+
+int main() {
+    HAPError err;
+    HAPPlatformCreate();
+
+    // Prepare accessory server storage.
+    static HAPBLEGATTTableElementRef gattTableElements[kHAPBLETestAccessory_NumAttributes];
+    static HAPBLESessionCacheElementRef sessionCacheElements[kHAPBLESessionCache_MinElements];
+    static HAPSessionRef session;
+    static uint8_t procedureBytes[2048];
+    static HAPBLEProcedureRef procedures[1];
+    static HAPBLEAccessoryServerStorage bleAccessoryServerStorage = {
+        .gattTableElements = gattTableElements,
+        .numGATTTableElements = HAPArrayCount(gattTableElements),
+        .sessionCacheElements = sessionCacheElements,
+        .numSessionCacheElements = HAPArrayCount(sessionCacheElements),
+        .session = &session,
+        .procedures = procedures,
+        .numProcedures = HAPArrayCount(procedures),
+        .procedureBuffer = { .bytes = procedureBytes, .numBytes = sizeof procedureBytes },
+    };
+
+    // Initialize accessory server.
+    static HAPAccessoryServerRef accessoryServer;
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ble = { .transport = &kHAPAccessoryServerTransport_BLE,
+                             .accessoryServerStorage = &bleAccessoryServerStorage,
+                             .preferredAdvertisingInterval = kHAPBLEAdvertisingInterval_Minimum,
+                             .preferredNotificationDuration = kHAPBLENotification_MinDuration } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HAPBLETestAccessoryHandleUpdatedState },
+            /* context: */ NULL);
+
+    // Start accessory server.
+    HAPAccessoryServerStart(&accessoryServer, &bleTestAccessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+
+    HAPBLEAccessoryServerGSN gsn;
+    HAPBLEAccessoryServerGetGSN(&accessoryServer, &gsn);
+    HAPAssert(gsn.gsn == 1);
+
+    // The first increment reserves GSN values in the key-value store.
+    bool isReserved;
+    RaiseDisconnectedEvent(&accessoryServer);
+    HAPBLEAccessoryServerGetGSN(&accessoryServer, &gsn);
+    HAPAssert(gsn.gsn == 2);
+    HAPAssert(GetStoredGSN(&isReserved) == 1 + kHAPBLEAccessoryServer_NumReservedGSNIncrements);
+    HAPAssert(isReserved);
+
+    // The key-value store is not updated until the reserved GSN values are used up.
+    for (uint16_t i = 1; i < kHAPBLEAccessoryServer_NumReservedGSNIncrements; i++) {
+        RaiseDisconnectedEvent(&accessoryServer);
+        HAPAssert(GetStoredGSN(&isReserved) == 1 + kHAPBLEAccessoryServer_NumReservedGSNIncrements);
+        HAPAssert(isReserved);
+    }
+    HAPBLEAccessoryServerGetGSN(&accessoryServer, &gsn);
+    HAPAssert(gsn.gsn == 1 + kHAPBLEAccessoryServer_NumReservedGSNIncrements);
+    RaiseDisconnectedEvent(&accessoryServer);
+    HAPBLEAccessoryServerGetGSN(&accessoryServer, &gsn);
+    HAPAssert(gsn.gsn == 2 + kHAPBLEAccessoryServer_NumReservedGSNIncrements);
+    HAPAssert(GetStoredGSN(&isReserved) == 1 + 2 * kHAPBLEAccessoryServer_NumReservedGSNIncrements);
+    HAPAssert(isReserved);
+
+    // Stopping the accessory server stores the current GSN.
+    HAPAccessoryServerStop(&accessoryServer);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Idle);
+    HAPAssert(GetStoredGSN(&isReserved) == 2 + kHAPBLEAccessoryServer_NumReservedGSNIncrements);
+    HAPAssert(!isReserved);
+
+    HAPAccessoryServerStart(&accessoryServer, &bleTestAccessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+    HAPBLEAccessoryServerGetGSN(&accessoryServer, &gsn);
+    HAPAssert(gsn.gsn == 2 + kHAPBLEAccessoryServer_NumReservedGSNIncrements);
+    HAPAccessoryServerStop(&accessoryServer);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Idle);
+
+    // Simulate a power loss: The key-value store holds a reserved GSN,
+    // and the broadcast encryption key expires within the skipped range of GSN values.
+    const uint16_t reservedGSN = 100;
+    uint8_t gsnBytes[] = { HAPExpandLittleUInt16(reservedGSN), 0x03 };
+    err = HAPPlatformKeyValueStoreSet(
+            platform.keyValueStore,
+            kHAPKeyValueStoreDomain_Configuration,
+            kHAPKeyValueStoreKey_Configuration_BLEGSN,
+            gsnBytes,
+            sizeof gsnBytes);
+    HAPAssert(!err);
+    uint8_t parametersBytes
+            [sizeof(uint16_t) + sizeof(HAPBLEAccessoryServerBroadcastEncryptionKey) + sizeof(uint8_t) +
+             sizeof(HAPDeviceID)];
+    HAPRawBufferZero(parametersBytes, sizeof parametersBytes);
+    HAPWriteLittleUInt16(&parametersBytes[0], reservedGSN - 1);
+    parametersBytes[2] = 0xAA;
+    err = HAPPlatformKeyValueStoreSet(
+            platform.keyValueStore,
+            kHAPKeyValueStoreDomain_Configuration,
+            kHAPKeyValueStoreKey_Configuration_BLEBroadcastParameters,
+            parametersBytes,
+            sizeof parametersBytes);
+    HAPAssert(!err);
+
+    HAPAccessoryServerStart(&accessoryServer, &bleTestAccessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+    HAPBLEAccessoryServerGetGSN(&accessoryServer, &gsn);
+    HAPAssert(gsn.gsn == reservedGSN);
+    HAPAssert(!gsn.didIncrement);
+    uint16_t keyExpirationGSN;
+    err = HAPBLEAccessoryServerBroadcastGetParameters(&accessoryServer, &keyExpirationGSN, NULL, NULL);
+    HAPAssert(!err);
+    HAPAssert(!keyExpirationGSN);
+
+    // GSN values continue after the reserved GSN.
+    RaiseDisconnectedEvent(&accessoryServer);
+    HAPBLEAccessoryServerGetGSN(&accessoryServer, &gsn);
+    HAPAssert(gsn.gsn == reservedGSN + 1);
+    HAPAssert(GetStoredGSN(&isReserved) == reservedGSN + kHAPBLEAccessoryServer_NumReservedGSNIncrements);
+    HAPAssert(isReserved);
+
+    return 0;
+}
@@ -0,0 +1,195 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+#include "HAPPlatformBLEPeripheralManager+Init.h"
+#include "HAPPlatformBLEPeripheralManager+Test.h"
+
+#include "Harness/HAPBLETestAccessory.c"
+#include "Harness/TemplateDB.c"
+
+/**
+ * Finds the Characteristic Value declaration of a characteristic in the GATT database.
+ */
+static const HAPPlatformBLEPeripheralManagerCharacteristic* FindCharacteristic(
+        HAPPlatformBLEPeripheralManager* blePeripheralManager,
+        const HAPBaseCharacteristic* characteristic) {
+    for (size_t i = 0; i < blePeripheralManager->numAttributes; i++) {
+        const HAPPlatformBLEPeripheralManagerAttribute* attribute = &blePeripheralManager->attributes[i];
+        if (attribute->type == kHAPPlatformBLEPeripheralManagerAttributeType_Characteristic &&
+            HAPRawBufferAreEqual(
+                    attribute->_.characteristic.type.bytes,
+                    characteristic->characteristicType->bytes,
+                    sizeof attribute->_.characteristic.type.bytes)) {
+            return &attribute->_.characteristic;
+        }
+    }
+    HAPFatalError();
+}
+
+int main() {
+    HAPError err;
+    HAPPlatformCreate();
+
+    // Prepare accessory server storage.
+    static HAPBLEGATTTableElementRef gattTableElements[kHAPBLETestAccessory_NumAttributes];
+    static uint16_t characteristicIndex[kHAPBLETestAccessory_NumAttributes];
+    static HAPBLESessionCacheElementRef sessionCacheElements[kHAPBLESessionCache_MinElements];
+    static HAPSessionRef session;
+    static uint8_t procedureBytes[2048];
+    static HAPBLEProcedureRef procedures[1];
+    static HAPBLEAccessoryServerStorage bleAccessoryServerStorage = {
+        .gattTableElements = gattTableElements,
+        .numGATTTableElements = HAPArrayCount(gattTableElements),
+        .characteristicIndex = characteristicIndex,
+        .numCharacteristicIndexElements = HAPArrayCount(characteristicIndex),
+        .sessionCacheElements = sessionCacheElements,
+        .numSessionCacheElements = HAPArrayCount(sessionCacheElements),
+        .session = &session,
+        .procedures = procedures,
+        .numProcedures = HAPArrayCount(procedures),
+        .procedureBuffer = { .bytes = procedureBytes, .numBytes = sizeof procedureBytes },
+    };
+
+    // Initialize accessory server.
+    static HAPAccessoryServerRef accessoryServer;
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ble = { .transport = &kHAPAccessoryServerTransport_BLE,
+                             .accessoryServerStorage = &bleAccessoryServerStorage,
+                             .preferredAdvertisingInterval = kHAPBLEAdvertisingInterval_Minimum,
+                             .preferredNotificationDuration = kHAPBLENotification_MinDuration } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HAPBLETestAccessoryHandleUpdatedState },
+            /* context: */ NULL);
+
+    // Start accessory server.
+    HAPAccessoryServerStart(&accessoryServer, &bleTestAccessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+
+    // Events are resolved through the characteristic index.
+    {
+        size_t numCharacteristics = 0;
+        for (size_t i = 0; bleTestAccessory.services[i]; i++) {
+            for (size_t j = 0; bleTestAccessory.services[i]->characteristics[j]; j++) {
+                numCharacteristics++;
+            }
+        }
+        const HAPAccessoryServer* server = (const HAPAccessoryServer*) &accessoryServer;
+        HAPAssert(server->ble.characteristicIndex.numElements == numCharacteristics);
+    }
+
+    // Register admin pairing.
+    uint8_t pairingBytes[sizeof(HAPPairingID) + sizeof(uint8_t) + sizeof(HAPPairingPublicKey) + sizeof(uint8_t)];
+    HAPRawBufferZero(pairingBytes, sizeof pairingBytes);
+    pairingBytes[sizeof(HAPPairingID)] = 1;
+    pairingBytes[sizeof pairingBytes - 1] = 0x01;
+    err = HAPPlatformKeyValueStoreSet(
+            platform.keyValueStore, kHAPKeyValueStoreDomain_Pairings, 0, pairingBytes, sizeof pairingBytes);
+    HAPAssert(!err);
+
+    // Connect central.
+    HAPPlatformBLEPeripheralManager* blePeripheralManager = HAPNonnull(platform.ble.blePeripheralManager);
+    HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle = 1;
+    blePeripheralManager->delegate.handleConnectedCentral(
+            blePeripheralManager, connectionHandle, blePeripheralManager->delegate.context);
+
+    // Establish security session as if Pair Verify had completed.
+    HAPSession* accessorySession = (HAPSession*) &session;
+    accessorySession->hap.active = true;
+    accessorySession->hap.pairingID = 0;
+    HAPAssert(HAPSessionIsSecured(&session));
+
+    // Enable events.
+    const HAPBaseCharacteristic* const characteristics[] = {
+        (const HAPBaseCharacteristic*) &lightBulbOnCharacteristic,
+        (const HAPBaseCharacteristic*) &lightBulbBrightnessCharacteristic,
+        (const HAPBaseCharacteristic*) &lightBulbHueCharacteristic
+    };
+    HAPPlatformBLEPeripheralManagerAttributeHandle valueHandles[HAPArrayCount(characteristics)];
+    for (size_t i = 0; i < HAPArrayCount(characteristics); i++) {
+        const HAPPlatformBLEPeripheralManagerCharacteristic* gattCharacteristic =
+                FindCharacteristic(blePeripheralManager, characteristics[i]);
+        HAPAssert(gattCharacteristic->cccDescriptorHandle);
+        valueHandles[i] = gattCharacteristic->valueHandle;
+
+        uint8_t bytes[2];
+        HAPWriteLittleUInt16(bytes, 0x0002);
+        err = blePeripheralManager->delegate.handleWriteRequest(
+                blePeripheralManager,
+                connectionHandle,
+                gattCharacteristic->cccDescriptorHandle,
+                bytes,
+                sizeof bytes,
+                blePeripheralManager->delegate.context);
+        HAPAssert(!err);
+    }
+    HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle;
+    HAPAssert(!HAPPlatformBLEPeripheralManagerGetPendingHandleValueIndication(blePeripheralManager, &valueHandle));
+
+    // Raise a burst of events. Only one indication may await confirmation at a time.
+    // Events are delivered in the order in which they were raised, and only once per characteristic.
+    static const size_t raised[] = { 2, 1, 0, 1, 2 };
+    for (size_t i = 0; i < HAPArrayCount(raised); i++) {
+        HAPAccessoryServerRaiseEvent(
+                &accessoryServer, characteristics[raised[i]], &lightBulbService, &bleTestAccessory);
+        HAPPlatformClockAdvance(0);
+    }
+    static const size_t expected[] = { 2, 1, 0, 2 };
+    for (size_t i = 0; i < HAPArrayCount(expected); i++) {
+        HAPAssert(HAPPlatformBLEPeripheralManagerGetPendingHandleValueIndication(blePeripheralManager, &valueHandle));
+        HAPAssert(valueHandle == valueHandles[expected[i]]);
+        HAPPlatformBLEPeripheralManagerConfirmHandleValueIndication(blePeripheralManager);
+        HAPPlatformClockAdvance(0);
+    }
+    HAPAssert(!HAPPlatformBLEPeripheralManagerGetPendingHandleValueIndication(blePeripheralManager, &valueHandle));
+
+    // Events of characteristics without subscription stay pending until events are enabled.
+    {
+        const HAPPlatformBLEPeripheralManagerCharacteristic* gattCharacteristic =
+                FindCharacteristic(blePeripheralManager, characteristics[0]);
+        uint8_t bytes[2];
+        HAPWriteLittleUInt16(bytes, 0);
+        err = blePeripheralManager->delegate.handleWriteRequest(
+                blePeripheralManager,
+                connectionHandle,
+                gattCharacteristic->cccDescriptorHandle,
+                bytes,
+                sizeof bytes,
+                blePeripheralManager->delegate.context);
+        HAPAssert(!err);
+
+        HAPAccessoryServerRaiseEvent(&accessoryServer, characteristics[0], &lightBulbService, &bleTestAccessory);
+        HAPAccessoryServerRaiseEvent(&accessoryServer, characteristics[1], &lightBulbService, &bleTestAccessory);
+        HAPPlatformClockAdvance(0);
+        HAPAssert(HAPPlatformBLEPeripheralManagerGetPendingHandleValueIndication(blePeripheralManager, &valueHandle));
+        HAPAssert(valueHandle == valueHandles[1]);
+        HAPPlatformBLEPeripheralManagerConfirmHandleValueIndication(blePeripheralManager);
+        HAPPlatformClockAdvance(0);
+        HAPAssert(!HAPPlatformBLEPeripheralManagerGetPendingHandleValueIndication(blePeripheralManager, &valueHandle));
+
+        HAPWriteLittleUInt16(bytes, 0x0002);
+        err = blePeripheralManager->delegate.handleWriteRequest(
+                blePeripheralManager,
+                connectionHandle,
+                gattCharacteristic->cccDescriptorHandle,
+                bytes,
+                sizeof bytes,
+                blePeripheralManager->delegate.context);
+        HAPAssert(!err);
+        HAPAssert(HAPPlatformBLEPeripheralManagerGetPendingHandleValueIndication(blePeripheralManager, &valueHandle));
+        HAPAssert(valueHandle == valueHandles[0]);
+        HAPPlatformBLEPeripheralManagerConfirmHandleValueIndication(blePeripheralManager);
+        HAPPlatformClockAdvance(0);
+        HAPAssert(!HAPPlatformBLEPeripheralManagerGetPendingHandleValueIndication(blePeripheralManager, &valueHandle));
+    }
+
+    return 0;
+}
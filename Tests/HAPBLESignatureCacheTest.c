@@ -0,0 +1,188 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+#include "Harness/HAPBLETestAccessory.c"
+#include "Harness/TemplateDB.c"
+
+/**
+ * Serializes a signature and compares it against a signature that is serialized without the signature cache.
+ *
+ * @param      server_              Accessory server.
+ * @param      characteristic       Characteristic. NULL to serialize the signature of the service.
+ * @param      service              The service that contains the characteristic.
+ *
+ * @return true                     If the signature was served from the signature cache.
+ * @return false                    Otherwise.
+ */
+static bool VerifySignature(
+        HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* _Nullable characteristic,
+        const HAPService* service) {
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPError err;
+
+    uint64_t iid = characteristic ? ((const HAPBaseCharacteristic*) characteristic)->iid : service->iid;
+    uint8_t cachedBytes[256];
+    HAPTLVWriterRef writer;
+    HAPTLVWriterCreate(&writer, cachedBytes, sizeof cachedBytes);
+    bool found;
+    err = HAPBLESignatureCacheGet(server_, iid, &writer, &found);
+    HAPAssert(!err);
+
+    HAPTLVWriterCreate(&writer, cachedBytes, sizeof cachedBytes);
+    err = characteristic ? HAPBLECharacteristicGetSignatureReadResponse(server_, characteristic, service, &writer) :
+                           HAPBLEServiceGetSignatureReadResponse(server_, service, &writer);
+    HAPAssert(!err);
+    void* bytes;
+    size_t numCachedBytes;
+    HAPTLVWriterGetBuffer(&writer, &bytes, &numCachedBytes);
+
+    // Serialize signature without signature cache.
+    size_t numEntries = server->ble.signatureCache.numEntries;
+    server->ble.signatureCache.numEntries = 0;
+    uint8_t expectedBytes[256];
+    HAPTLVWriterCreate(&writer, expectedBytes, sizeof expectedBytes);
+    err = characteristic ? HAPBLECharacteristicGetSignatureReadResponse(server_, characteristic, service, &writer) :
+                           HAPBLEServiceGetSignatureReadResponse(server_, service, &writer);
+    HAPAssert(!err);
+    size_t numExpectedBytes;
+    HAPTLVWriterGetBuffer(&writer, &bytes, &numExpectedBytes);
+    server->ble.signatureCache.numEntries = numEntries;
+
+    HAPAssert(numCachedBytes == numExpectedBytes);
+    HAPAssert(HAPRawBufferAreEqual(cachedBytes, expectedBytes, numExpectedBytes));
+    return found;
+}
+
+/**
+ * Verifies the signatures of all services and characteristics of the accessory.
+ *
+ * @return Number of signatures that were served from the signature cache.
+ */
+static size_t VerifySignatures(HAPAccessoryServerRef* server) {
+    size_t numCachedSignatures = 0;
+    for (size_t i = 0; bleTestAccessory.services[i]; i++) {
+        const HAPService* service = bleTestAccessory.services[i];
+        numCachedSignatures += VerifySignature(server, NULL, service);
+        if (service->characteristics) {
+            for (size_t j = 0; service->characteristics[j]; j++) {
+                numCachedSignatures += VerifySignature(server, service->characteristics[j], service);
+            }
+        }
+    }
+    return numCachedSignatures;
+}
+
+int main() {
+    HAPError err;
+    HAPPlatformCreate();
+
+    // Prepare accessory server storage.
+    static HAPBLEGATTTableElementRef gattTableElements[kHAPBLETestAccessory_NumAttributes];
+    static uint8_t signatureBytes[kHAPBLESignatureBuffer_NumBytesPerGATTTableElement * HAPArrayCount(gattTableElements)];
+    static HAPBLESessionCacheElementRef sessionCacheElements[kHAPBLESessionCache_MinElements];
+    static HAPSessionRef session;
+    static uint8_t procedureBytes[2048];
+    static HAPBLEProcedureRef procedures[1];
+    static HAPBLEAccessoryServerStorage bleAccessoryServerStorage = {
+        .gattTableElements = gattTableElements,
+        .numGATTTableElements = HAPArrayCount(gattTableElements),
+        .signatureBuffer = { .bytes = signatureBytes, .numBytes = sizeof signatureBytes },
+        .sessionCacheElements = sessionCacheElements,
+        .numSessionCacheElements = HAPArrayCount(sessionCacheElements),
+        .session = &session,
+        .procedures = procedures,
+        .numProcedures = HAPArrayCount(procedures),
+        .procedureBuffer = { .bytes = procedureBytes, .numBytes = sizeof procedureBytes },
+    };
+
+    // Initialize accessory server.
+    static HAPAccessoryServerRef accessoryServer;
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ble = { .transport = &kHAPAccessoryServerTransport_BLE,
+                             .accessoryServerStorage = &bleAccessoryServerStorage,
+                             .preferredAdvertisingInterval = kHAPBLEAdvertisingInterval_Minimum,
+                             .preferredNotificationDuration = kHAPBLENotification_MinDuration } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HAPBLETestAccessoryHandleUpdatedState },
+            /* context: */ NULL);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) &accessoryServer;
+
+    // Start accessory server.
+    HAPAccessoryServerStart(&accessoryServer, &bleTestAccessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+
+    // All signatures are cached and match the serialized signatures.
+    size_t numSignatures = server->ble.signatureCache.numEntries;
+    HAPAssert(numSignatures == kHAPBLETestAccessory_NumAttributes);
+    HAPAssert(VerifySignatures(&accessoryServer) == numSignatures);
+
+    // Unknown instance IDs are not cached.
+    {
+        uint8_t bytes[256];
+        HAPTLVWriterRef writer;
+        HAPTLVWriterCreate(&writer, bytes, sizeof bytes);
+        bool found;
+        err = HAPBLESignatureCacheGet(&accessoryServer, 0xFFFF, &writer, &found);
+        HAPAssert(!err);
+        HAPAssert(!found);
+        err = HAPBLESignatureCacheGet(&accessoryServer, UINT64_MAX, &writer, &found);
+        HAPAssert(!err);
+        HAPAssert(!found);
+    }
+
+    // Service signatures for invalid instance IDs are not cached.
+    {
+        uint8_t bytes[256];
+        HAPTLVWriterRef writer;
+        HAPTLVWriterCreate(&writer, bytes, sizeof bytes);
+        err = HAPBLEServiceGetSignatureReadResponse(&accessoryServer, NULL, &writer);
+        HAPAssert(!err);
+    }
+
+    // Cached signatures that do not fit into the response are rejected.
+    {
+        uint8_t bytes[4];
+        HAPTLVWriterRef writer;
+        HAPTLVWriterCreate(&writer, bytes, sizeof bytes);
+        err = HAPBLECharacteristicGetSignatureReadResponse(
+                &accessoryServer, &lightBulbBrightnessCharacteristic, &lightBulbService, &writer);
+        HAPAssert(err == kHAPError_OutOfResources);
+    }
+
+    // Restart with a small signature buffer. Only some signatures are cached.
+    HAPAccessoryServerStop(&accessoryServer);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Idle);
+    bleAccessoryServerStorage.signatureBuffer.numBytes = 7 * numSignatures + 64;
+    HAPAccessoryServerStart(&accessoryServer, &bleTestAccessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+    HAPAssert(server->ble.signatureCache.numEntries);
+    HAPAssert(server->ble.signatureCache.numEntries < numSignatures);
+    HAPAssert(VerifySignatures(&accessoryServer) == server->ble.signatureCache.numEntries);
+
+    // Restart without a signature buffer. No signatures are cached.
+    HAPAccessoryServerStop(&accessoryServer);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Idle);
+    bleAccessoryServerStorage.signatureBuffer.bytes = NULL;
+    bleAccessoryServerStorage.signatureBuffer.numBytes = 0;
+    HAPAccessoryServerStart(&accessoryServer, &bleTestAccessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+    HAPAssert(!server->ble.signatureCache.numEntries);
+    HAPAssert(!VerifySignatures(&accessoryServer));
+
+    return 0;
+}
@@ -0,0 +1,350 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+
+static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .category = "TestController" };
+
+/**
+ * ATT_MTUs to test. From the Bluetooth 4.0 default to the Bluetooth 4.2 / 5 maximum.
+ */
+static const uint16_t testMTUs[] = { 23, 27, 64, 104, 185, 247, 251, 512, 517 };
+
+/**
+ * Maximum length of an attribute value.
+ *
+ * @see Bluetooth Core Specification Version 5
+ *      Vol 3, Part F, Section 3.2.9 Long Attribute Values
+ */
+#define kMaxAttributeBytes ((size_t) 512)
+
+/** Size of the procedure scratch buffer. */
+#define kNumScratchBytes ((size_t) 2048)
+
+/**
+ * Test body.
+ */
+typedef struct {
+    /** Description. */
+    const char* description;
+
+    /** TLV types. */
+    const HAPTLVType* types;
+
+    /** TLV value lengths. */
+    const size_t* lengths;
+
+    /** Number of TLVs. */
+    size_t numTLVs;
+
+    /** Serialized TLV body. */
+    uint8_t bytes[kNumScratchBytes];
+    size_t numBytes;
+} TestBody;
+
+/**
+ * Serializes a TLV body. Values are filled with a pattern that depends on the TLV index.
+ *
+ * @param      body                 Body.
+ * @param      writer               Writer.
+ */
+static void SerializeBody(const TestBody* body, HAPTLVWriterRef* writer) {
+    HAPError err;
+
+    static uint8_t valueBytes[kNumScratchBytes];
+    for (size_t i = 0; i < body->numTLVs; i++) {
+        HAPAssert(body->lengths[i] <= sizeof valueBytes);
+        for (size_t j = 0; j < body->lengths[i]; j++) {
+            valueBytes[j] = (uint8_t)(i * 31 + j);
+        }
+        err = HAPTLVWriterAppend(
+                writer,
+                &(const HAPTLV) { .type = body->types[i],
+                                  .value = { .bytes = valueBytes, .numBytes = body->lengths[i] } });
+        HAPAssert(!err);
+    }
+}
+
+/**
+ * Initializes a body that consists of TLVs with the given types and lengths.
+ *
+ * @param[out] body                 Body.
+ * @param      description          Description.
+ * @param      types                TLV types.
+ * @param      lengths              TLV value lengths.
+ * @param      numTLVs              Number of TLVs.
+ */
+static void MakeBody(
+        TestBody* body,
+        const char* description,
+        const HAPTLVType* types,
+        const size_t* lengths,
+        size_t numTLVs) {
+    body->description = description;
+    body->types = types;
+    body->lengths = lengths;
+    body->numTLVs = numTLVs;
+
+    HAPTLVWriterRef writer;
+    HAPTLVWriterCreate(&writer, body->bytes, sizeof body->bytes);
+    SerializeBody(body, &writer);
+    void* bytes;
+    HAPTLVWriterGetBuffer(&writer, &bytes, &body->numBytes);
+    HAPAssert(bytes == body->bytes);
+}
+
+/**
+ * Returns the number of fragments that are needed to transfer a body.
+ *
+ * @param      numBodyBytes         Length of the body.
+ * @param      numFirstBodyBytes    Number of body bytes that fit into the first fragment.
+ * @param      numContinuationBodyBytes Number of body bytes that fit into a continuation fragment.
+ *
+ * @return Number of fragments.
+ */
+HAP_RESULT_USE_CHECK
+static size_t GetNumFragments(size_t numBodyBytes, size_t numFirstBodyBytes, size_t numContinuationBodyBytes) {
+    if (numBodyBytes <= numFirstBodyBytes) {
+        return 1;
+    }
+    size_t numRemainingBytes = numBodyBytes - numFirstBodyBytes;
+    return 1 + (numRemainingBytes + numContinuationBodyBytes - 1) / numContinuationBodyBytes;
+}
+
+/**
+ * Writes a request through a transaction, using fragments that fit into a single ATT Write Request,
+ * then reads the response using fragments that fit into a single ATT Read Response.
+ *
+ * @param      body                 Request and response body.
+ * @param      mtu                  ATT_MTU.
+ */
+static void TestTransaction(const TestBody* body, uint16_t mtu) {
+    HAPError err;
+
+    static uint8_t scratchBytes[kNumScratchBytes];
+    HAPRawBufferZero(scratchBytes, sizeof scratchBytes);
+    HAPBLETransaction transaction;
+    HAPBLETransactionCreate(&transaction, scratchBytes, sizeof scratchBytes);
+
+    const uint8_t tid = 0x42;
+    const uint16_t iid = 0x0022;
+
+    // Write request.
+    // See Bluetooth Core Specification Version 5
+    // Vol 3, Part F, Section 3.4.5.1 Write Request
+    size_t maxWriteBytes = HAPMin((size_t)(mtu - 3), kMaxAttributeBytes);
+    size_t numWrites = 0;
+    size_t numWriteBytes = 0;
+    {
+        uint8_t fragmentBytes[kMaxAttributeBytes];
+        size_t bodyOffset = 0;
+        do {
+            size_t o = 0;
+            if (!bodyOffset) {
+                fragmentBytes[o++] = 0x00; // First Fragment, Request, 1 Byte Control Field.
+                fragmentBytes[o++] = kHAPPDUOpcode_CharacteristicWrite;
+                fragmentBytes[o++] = tid;
+                HAPWriteLittleUInt16(&fragmentBytes[o], iid);
+                o += 2;
+                HAPWriteLittleUInt16(&fragmentBytes[o], body->numBytes);
+                o += 2;
+            } else {
+                fragmentBytes[o++] = 0x80; // Continuation, Request, 1 Byte Control Field.
+                fragmentBytes[o++] = tid;
+            }
+            size_t numFragmentBytes = HAPMin(maxWriteBytes - o, body->numBytes - bodyOffset);
+            HAPRawBufferCopyBytes(&fragmentBytes[o], &body->bytes[bodyOffset], numFragmentBytes);
+            o += numFragmentBytes;
+            bodyOffset += numFragmentBytes;
+
+            HAPAssert(!HAPBLETransactionIsRequestAvailable(&transaction));
+            err = HAPBLETransactionHandleWrite(&transaction, fragmentBytes, o);
+            HAPAssert(!err);
+            numWrites++;
+            numWriteBytes += o;
+        } while (bodyOffset < body->numBytes);
+    }
+    HAPAssert(
+            numWrites == GetNumFragments(
+                                 body->numBytes,
+                                 maxWriteBytes - kHAPBLEPDU_NumRequestHeaderBytes - kHAPBLEPDU_NumBodyHeaderBytes,
+                                 maxWriteBytes - kHAPBLEPDU_NumContinuationHeaderBytes));
+
+    // Get request. The body has been assembled in place in the scratch buffer.
+    HAPAssert(HAPBLETransactionIsRequestAvailable(&transaction));
+    HAPBLETransactionRequest request;
+    err = HAPBLETransactionGetRequest(&transaction, &request);
+    HAPAssert(!err);
+    HAPAssert(request.opcode == kHAPPDUOpcode_CharacteristicWrite);
+    HAPAssert(request.iid == iid);
+    HAPAssert(HAPRawBufferAreEqual(scratchBytes, body->bytes, body->numBytes));
+    for (;;) {
+        bool found;
+        HAPTLV tlv;
+        err = HAPTLVReaderGetNext(&request.bodyReader, &found, &tlv);
+        HAPAssert(!err);
+        if (!found) {
+            break;
+        }
+        HAPAssert(!tlv.value.numBytes || tlv.value.bytes);
+        HAPAssert(!tlv.value.bytes || (const uint8_t*) tlv.value.bytes >= scratchBytes);
+        HAPAssert(!tlv.value.bytes || (const uint8_t*) tlv.value.bytes < &scratchBytes[sizeof scratchBytes]);
+    }
+
+    // Set response. Like the procedure, the response body is serialized into the scratch buffer.
+    HAPTLVWriterRef writer;
+    HAPTLVWriterCreate(&writer, scratchBytes, sizeof scratchBytes);
+    SerializeBody(body, &writer);
+    HAPBLETransactionSetResponse(&transaction, kHAPBLEPDUStatus_Success, &writer);
+
+    // Read response.
+    // See Bluetooth Core Specification Version 5
+    // Vol 3, Part F, Section 3.4.4.4 Read Response
+    size_t maxReadBytes = HAPMin((size_t)(mtu - 1), kMaxAttributeBytes);
+    size_t numReads = 0;
+    size_t numReadBytes = 0;
+    {
+        static uint8_t responseBodyBytes[kNumScratchBytes];
+        size_t numResponseBodyBytes = 0;
+        bool isFinalFragment;
+        do {
+            uint8_t fragmentBytes[kMaxAttributeBytes];
+            size_t numBytes;
+            err = HAPBLETransactionHandleRead(&transaction, fragmentBytes, maxReadBytes, &numBytes, &isFinalFragment);
+            HAPAssert(!err);
+            HAPAssert(numBytes <= maxReadBytes);
+
+            size_t o = 0;
+            if (!numReads) {
+                HAPAssert(numBytes >= kHAPBLEPDU_NumResponseHeaderBytes + kHAPBLEPDU_NumBodyHeaderBytes);
+                HAPAssert(fragmentBytes[o++] == 0x02); // First Fragment, Response, 1 Byte Control Field.
+                HAPAssert(fragmentBytes[o++] == tid);
+                HAPAssert(fragmentBytes[o++] == kHAPBLEPDUStatus_Success);
+                HAPAssert(HAPReadLittleUInt16(&fragmentBytes[o]) == body->numBytes);
+                o += 2;
+            } else {
+                HAPAssert(numBytes > kHAPBLEPDU_NumContinuationHeaderBytes);
+                HAPAssert(fragmentBytes[o++] == 0x82); // Continuation, Response, 1 Byte Control Field.
+                HAPAssert(fragmentBytes[o++] == tid);
+            }
+            HAPAssert(numResponseBodyBytes + numBytes - o <= sizeof responseBodyBytes);
+            HAPRawBufferCopyBytes(&responseBodyBytes[numResponseBodyBytes], &fragmentBytes[o], numBytes - o);
+            numResponseBodyBytes += numBytes - o;
+            numReads++;
+            numReadBytes += numBytes;
+        } while (!isFinalFragment);
+        HAPAssert(numResponseBodyBytes == body->numBytes);
+        HAPAssert(HAPRawBufferAreEqual(responseBodyBytes, body->bytes, body->numBytes));
+    }
+    HAPAssert(
+            numReads == GetNumFragments(
+                                body->numBytes,
+                                maxReadBytes - kHAPBLEPDU_NumResponseHeaderBytes - kHAPBLEPDU_NumBodyHeaderBytes,
+                                maxReadBytes - kHAPBLEPDU_NumContinuationHeaderBytes));
+
+    // Report throughput in body bytes per GATT request.
+    HAPLog(&logObject,
+           "%s (%zu bytes), ATT_MTU %u: %zu writes (%zu%% payload), %zu reads (%zu%% payload).",
+           body->description,
+           body->numBytes,
+           mtu,
+           numWrites,
+           numWriteBytes ? 100 * body->numBytes / numWriteBytes : 0,
+           numReads,
+           numReadBytes ? 100 * body->numBytes / numReadBytes : 0);
+}
+
+/**
+ * Checks that malformed continuations are rejected.
+ */
+static void TestMalformedContinuations(void) {
+    HAPError err;
+
+    static uint8_t scratchBytes[kNumScratchBytes];
+    HAPBLETransaction transaction;
+
+    const uint8_t firstFragmentBytes[] = { 0x00, kHAPPDUOpcode_CharacteristicWrite, 0x42, 0x22, 0x00, 0x04, 0x00, 0x01, 0x02 };
+    const uint8_t wrongTIDBytes[] = { 0x80, 0x43, 0x03, 0x04 };
+    const uint8_t wrongTypeBytes[] = { 0x82, 0x42, 0x03, 0x04 };
+    const uint8_t reservedBitsBytes[] = { 0x90, 0x42, 0x03, 0x04 };
+    const uint8_t excessBodyBytes[] = { 0x80, 0x42, 0x03, 0x04, 0x05 };
+    const uint8_t truncatedBytes[] = { 0x80 };
+    const struct {
+        const uint8_t* bytes;
+        size_t numBytes;
+    } continuations[] = {
+        { wrongTIDBytes, sizeof wrongTIDBytes },         { wrongTypeBytes, sizeof wrongTypeBytes },
+        { reservedBitsBytes, sizeof reservedBitsBytes }, { excessBodyBytes, sizeof excessBodyBytes },
+        { truncatedBytes, sizeof truncatedBytes },
+    };
+    for (size_t i = 0; i < HAPArrayCount(continuations); i++) {
+        HAPBLETransactionCreate(&transaction, scratchBytes, sizeof scratchBytes);
+        err = HAPBLETransactionHandleWrite(&transaction, firstFragmentBytes, sizeof firstFragmentBytes);
+        HAPAssert(!err);
+        err = HAPBLETransactionHandleWrite(&transaction, continuations[i].bytes, continuations[i].numBytes);
+        HAPAssert(err == kHAPError_InvalidData);
+    }
+
+    // Empty continuations are accepted.
+    HAPBLETransactionCreate(&transaction, scratchBytes, sizeof scratchBytes);
+    err = HAPBLETransactionHandleWrite(&transaction, firstFragmentBytes, sizeof firstFragmentBytes);
+    HAPAssert(!err);
+    err = HAPBLETransactionHandleWrite(&transaction, (const uint8_t[]) { 0x80, 0x42 }, 2);
+    HAPAssert(!err);
+    HAPAssert(!HAPBLETransactionIsRequestAvailable(&transaction));
+    err = HAPBLETransactionHandleWrite(&transaction, (const uint8_t[]) { 0x80, 0x42, 0x03, 0x04 }, 4);
+    HAPAssert(!err);
+    HAPAssert(HAPBLETransactionIsRequestAvailable(&transaction));
+    HAPAssert(HAPRawBufferAreEqual(scratchBytes, ((const uint8_t[]) { 0x01, 0x02, 0x03, 0x04 }), 4));
+}
+
+int main() {
+    static TestBody bodies[4];
+
+    // HAP-Characteristic-Signature-Read-Response.
+    // See HomeKit Accessory Protocol Specification R14
+    // Section 7.3.4.2 HAP-Characteristic-Signature-Read-Response
+    MakeBody(
+            &bodies[0],
+            "Signature Read",
+            (const HAPTLVType[]) { 0x04, 0x07, 0x06, 0x0A, 0x0B, 0x0C, 0x0D },
+            (const size_t[]) { 16, 2, 16, 2, 32, 7, 12 },
+            7);
+
+    // Pair Setup M2: State, Salt, Public Key.
+    // See HomeKit Accessory Protocol Specification R14
+    // Section 5.6.2 M2: Accessory -> iOS Device -- `SRP Start Response'
+    MakeBody(
+            &bodies[1],
+            "Pair Setup M2",
+            (const HAPTLVType[]) { 0x06, 0x02, 0x03 },
+            (const size_t[]) { 1, 16, 384 },
+            3);
+
+    // Pair Setup M3: State, Public Key, Proof.
+    // See HomeKit Accessory Protocol Specification R14
+    // Section 5.6.3 M3: iOS Device -> Accessory -- `SRP Verify Request'
+    MakeBody(
+            &bodies[2],
+            "Pair Setup M3",
+            (const HAPTLVType[]) { 0x06, 0x03, 0x04 },
+            (const size_t[]) { 1, 384, 64 },
+            3);
+
+    // Large body close to the scratch buffer size.
+    MakeBody(&bodies[3], "Large TLV", (const HAPTLVType[]) { 0x01, 0x02 }, (const size_t[]) { 1500, 400 }, 2);
+    HAPAssert(bodies[3].numBytes <= kNumScratchBytes);
+
+    for (size_t i = 0; i < HAPArrayCount(bodies); i++) {
+        for (size_t j = 0; j < HAPArrayCount(testMTUs); j++) {
+            TestTransaction(&bodies[i], testMTUs[j]);
+        }
+    }
+
+    TestMalformedContinuations();
+
+    return 0;
+}
@@ -0,0 +1,297 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+#include "Harness/TemplateDB.c"
+
+#define kIID_LightBulb           ((uint64_t) 0x0030)
+#define kIID_LightBulbOn         ((uint64_t) 0x0031)
+#define kIID_LightBulbBrightness ((uint64_t) 0x0032)
+
+/** Number of attributes of the light bulb service. */
+#define kLightBulbAttributeCount ((size_t) 3)
+
+/** State of the test. */
+static struct {
+    bool on;
+    int32_t brightness;
+    size_t numOnReads;
+    size_t numBrightnessReads;
+
+    /** Whether writes to the On characteristic are deferred. */
+    bool isDeferring;
+
+    /** Value of the deferred write. */
+    bool pendingOn;
+} test;
+
+HAP_RESULT_USE_CHECK
+static HAPError IdentifyAccessory(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPAccessoryIdentifyRequest* request HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleOnRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPBoolCharacteristicReadRequest* request HAP_UNUSED,
+        bool* value,
+        void* _Nullable context HAP_UNUSED) {
+    test.numOnReads++;
+    *value = test.on;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleOnWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPBoolCharacteristicWriteRequest* request HAP_UNUSED,
+        bool value,
+        void* _Nullable context HAP_UNUSED) {
+    if (test.isDeferring) {
+        test.pendingOn = value;
+        return kHAPError_InProgress;
+    }
+    test.on = value;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleBrightnessRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPIntCharacteristicReadRequest* request HAP_UNUSED,
+        int32_t* value,
+        void* _Nullable context HAP_UNUSED) {
+    test.numBrightnessReads++;
+    *value = test.brightness;
+    return kHAPError_None;
+}
+
+static const HAPBoolCharacteristic onCharacteristic = {
+    .format = kHAPCharacteristicFormat_Bool,
+    .iid = kIID_LightBulbOn,
+    .characteristicType = &kHAPCharacteristicType_On,
+    .debugDescription = kHAPCharacteristicDebugDescription_On,
+    .properties = { .readable = true, .writable = true, .supportsEventNotification = true },
+    .callbacks = { .handleRead = HandleOnRead, .handleWrite = HandleOnWrite }
+};
+
+static const HAPIntCharacteristic brightnessCharacteristic = {
+    .format = kHAPCharacteristicFormat_Int,
+    .iid = kIID_LightBulbBrightness,
+    .characteristicType = &kHAPCharacteristicType_Brightness,
+    .debugDescription = kHAPCharacteristicDebugDescription_Brightness,
+    .properties = { .readable = true, .supportsEventNotification = true },
+    .units = kHAPCharacteristicUnits_Percentage,
+    .constraints = { .minimumValue = 0, .maximumValue = 100, .stepValue = 1 },
+    .callbacks = { .handleRead = HandleBrightnessRead }
+};
+
+static const HAPService lightBulbService = {
+    .iid = kIID_LightBulb,
+    .serviceType = &kHAPServiceType_LightBulb,
+    .debugDescription = kHAPServiceDebugDescription_LightBulb,
+    .properties = { .primaryService = true },
+    .characteristics = (const HAPCharacteristic* const[]) { &onCharacteristic, &brightnessCharacteristic, NULL }
+};
+
+static const HAPAccessory accessory = { .aid = 1,
+                                        .category = kHAPAccessoryCategory_Lighting,
+                                        .name = "Acme Test",
+                                        .manufacturer = "Acme",
+                                        .model = "Test1,1",
+                                        .serialNumber = "099DB48E9E28",
+                                        .firmwareVersion = "1",
+                                        .hardwareVersion = "1",
+                                        .services = (const HAPService* const[]) { &accessoryInformationService,
+                                                                                  &hapProtocolInformationService,
+                                                                                  &pairingService,
+                                                                                  &lightBulbService,
+                                                                                  NULL },
+                                        .callbacks = { .identify = IdentifyAccessory } };
+
+static void HandleUpdatedAccessoryServerState(HAPAccessoryServerRef* server HAP_UNUSED, void* _Nullable context HAP_UNUSED) {
+}
+
+/** Accessory server. */
+static HAPAccessoryServerRef accessoryServer;
+
+/**
+ * Writes the On characteristic.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError WriteOn(HAPSessionRef* session, bool value) {
+    return HAPBoolCharacteristicHandleWrite(
+            &accessoryServer,
+            &(const HAPBoolCharacteristicWriteRequest) { .transportType = kHAPTransportType_IP,
+                                                         .session = session,
+                                                         .characteristic = &onCharacteristic,
+                                                         .service = &lightBulbService,
+                                                         .accessory = &accessory },
+            value,
+            NULL);
+}
+
+/**
+ * Reads the On characteristic.
+ */
+HAP_RESULT_USE_CHECK
+static bool ReadOn(void) {
+    HAPError err;
+
+    bool value;
+    err = HAPBoolCharacteristicHandleRead(
+            &accessoryServer,
+            &(const HAPBoolCharacteristicReadRequest) { .transportType = kHAPTransportType_IP,
+                                                        .characteristic = &onCharacteristic,
+                                                        .service = &lightBulbService,
+                                                        .accessory = &accessory },
+            &value,
+            NULL);
+    HAPAssert(!err);
+    return value;
+}
+
+/**
+ * Reads the Brightness characteristic.
+ */
+HAP_RESULT_USE_CHECK
+static int32_t ReadBrightness(void) {
+    HAPError err;
+
+    int32_t value;
+    err = HAPIntCharacteristicHandleRead(
+            &accessoryServer,
+            &(const HAPIntCharacteristicReadRequest) { .transportType = kHAPTransportType_IP,
+                                                       .characteristic = &brightnessCharacteristic,
+                                                       .service = &lightBulbService,
+                                                       .accessory = &accessory },
+            &value,
+            NULL);
+    HAPAssert(!err);
+    return value;
+}
+
+int main() {
+    HAPError err;
+    HAPPlatformCreate();
+
+    // Prepare accessory server storage.
+    static HAPIPSession ipSessions[1];
+    static HAPIPSessionSlotRef ipSessionSlots[HAPArrayCount(ipSessions)];
+    static uint8_t ipInboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultInboundBufferSize];
+    static uint8_t ipOutboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultOutboundBufferSize];
+    static HAPIPEventNotificationRef
+            ipEventNotifications[HAPArrayCount(ipSessions)][kAttributeCount + kLightBulbAttributeCount];
+    for (size_t i = 0; i < HAPArrayCount(ipSessions); i++) {
+        ipSessions[i].inboundBuffer.bytes = ipInboundBuffers[i];
+        ipSessions[i].inboundBuffer.numBytes = sizeof ipInboundBuffers[i];
+        ipSessions[i].outboundBuffer.bytes = ipOutboundBuffers[i];
+        ipSessions[i].outboundBuffer.numBytes = sizeof ipOutboundBuffers[i];
+        ipSessions[i].eventNotifications = ipEventNotifications[i];
+        ipSessions[i].numEventNotifications = HAPArrayCount(ipEventNotifications[i]);
+    }
+    static HAPIPReadContextRef ipReadContexts[kAttributeCount + kLightBulbAttributeCount];
+    static HAPIPWriteContextRef ipWriteContexts[kAttributeCount + kLightBulbAttributeCount];
+    static uint8_t ipScratchBuffer[kHAPIPSession_DefaultScratchBufferSize];
+    static HAPIPAccessoryServerStorage ipAccessoryServerStorage = {
+        .sessions = ipSessions,
+        .numSessions = HAPArrayCount(ipSessions),
+        .sessionSlots = ipSessionSlots,
+        .readContexts = ipReadContexts,
+        .numReadContexts = HAPArrayCount(ipReadContexts),
+        .writeContexts = ipWriteContexts,
+        .numWriteContexts = HAPArrayCount(ipWriteContexts),
+        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer }
+    };
+
+    // Cache On until it changes, and Brightness for 10 seconds.
+    static HAPCharacteristicValueCacheEntry cacheEntries[] = {
+        { .characteristic = &onCharacteristic, .accessory = &accessory },
+        { .characteristic = &brightnessCharacteristic, .accessory = &accessory, .maxAge = 10 * HAPSecond }
+    };
+
+    // Initialize accessory server.
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ip = { .transport = &kHAPAccessoryServerTransport_IP,
+                            .accessoryServerStorage = &ipAccessoryServerStorage },
+                    .characteristicValueCache = { .entries = cacheEntries,
+                                                  .numEntries = HAPArrayCount(cacheEntries) } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+
+    // Start accessory server.
+    HAPAccessoryServerStart(&accessoryServer, &accessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+
+    HAPCharacteristicValueCacheStatistics statistics;
+
+    // The first read invokes the read handler. Subsequent reads are served from the cache.
+    test.brightness = 42;
+    HAPAssert(ReadBrightness() == 42);
+    test.brightness = 43;
+    HAPAssert(ReadBrightness() == 42);
+    HAPAssert(test.numBrightnessReads == 1);
+    HAPAccessoryServerGetCharacteristicValueCacheStatistics(&accessoryServer, &statistics);
+    HAPAssert(statistics.numHits == 1);
+    HAPAssert(statistics.numMisses == 1);
+
+    // Cached values expire after their maximum age.
+    HAPPlatformClockAdvance(10 * HAPSecond);
+    HAPAssert(ReadBrightness() == 42);
+    HAPPlatformClockAdvance(1);
+    HAPAssert(ReadBrightness() == 43);
+    HAPAssert(test.numBrightnessReads == 2);
+
+    // Raising an event discards the cached value.
+    test.brightness = 44;
+    HAPAccessoryServerRaiseEvent(&accessoryServer, &brightnessCharacteristic, &lightBulbService, &accessory);
+    HAPAssert(ReadBrightness() == 44);
+    HAPAssert(test.numBrightnessReads == 3);
+
+    // Values without maximum age remain cached until they change.
+    HAPAssert(!ReadOn());
+    HAPPlatformClockAdvance(HAPMinute);
+    HAPAssert(!ReadOn());
+    HAPAssert(test.numOnReads == 1);
+
+    // Writes discard the cached value.
+    static HAPSessionRef session;
+    HAPSessionCreate(&accessoryServer, &session, kHAPTransportType_IP);
+    err = WriteOn(&session, true);
+    HAPAssert(!err);
+    HAPAssert(ReadOn());
+    HAPAssert(test.numOnReads == 2);
+
+    // Values that are read while a write is deferred are discarded when the write is completed.
+    test.isDeferring = true;
+    err = WriteOn(&session, false);
+    HAPAssert(err == kHAPError_InProgress);
+    HAPAssert(ReadOn());
+    HAPAssert(ReadOn());
+    HAPAssert(test.numOnReads == 3);
+    test.on = test.pendingOn;
+    HAPAccessoryServerCompleteRequest(
+            &accessoryServer, &onCharacteristic, &lightBulbService, &accessory, &session, kHAPError_None);
+    HAPAssert(!ReadOn());
+    HAPAssert(test.numOnReads == 4);
+    HAPSessionRelease(&accessoryServer, &session);
+
+    HAPAccessoryServerGetCharacteristicValueCacheStatistics(&accessoryServer, &statistics);
+    HAPAssert(statistics.numHits == 4);
+    HAPAssert(statistics.numMisses == 7);
+
+    return 0;
+}
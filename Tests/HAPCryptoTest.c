@@ -162,6 +162,26 @@ static const uint8_t chacha20_poly1305_ct[] = {
     HAPAssert(!memcmp(t, tag, sizeof tag)); \
     }
 
+// HAP uses 64-bit nonces. They are equivalent to 96-bit nonces that are padded with leading zeros.
+#define test_chacha20_poly1305_short_nonce(key, pt, aad) \
+    { \
+        static const uint8_t n8[] = { 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47 }; \
+        static const uint8_t n12[] = { 0x00, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47 }; \
+        uint8_t t8[CHACHA20_POLY1305_TAG_BYTES]; \
+        uint8_t t12[CHACHA20_POLY1305_TAG_BYTES]; \
+        uint8_t c8[300]; \
+        uint8_t c12[300]; \
+        size_t pt_len = sizeof pt - 1; \
+        HAP_chacha20_poly1305_encrypt_aad(t8, c8, pt, pt_len, aad, sizeof aad, n8, sizeof n8, key); \
+        HAP_chacha20_poly1305_encrypt_aad(t12, c12, pt, pt_len, aad, sizeof aad, n12, sizeof n12, key); \
+        HAPAssert(!memcmp(c8, c12, pt_len)); \
+        HAPAssert(!memcmp(t8, t12, sizeof t8)); \
+        uint8_t m[300]; \
+        int ret = HAP_chacha20_poly1305_decrypt_aad(t12, m, c12, pt_len, aad, sizeof aad, n8, sizeof n8, key); \
+        HAPAssert(!ret); \
+        HAPAssert(!memcmp(m, pt, pt_len)); \
+    }
+
 // https://github.com/wolfSSL/wolfssl/issues/18#issuecomment-83941582
 
 static const uint8_t srp_salt[] = { 0xBE, 0xB2, 0x53, 0x79, 0xD1, 0xA8, 0x58, 0x1E,
@@ -487,6 +507,7 @@ int main() {
             chacha20_poly1305_aad,
             chacha20_poly1305_tag,
             chacha20_poly1305_ct);
+    test_chacha20_poly1305_short_nonce(chacha20_poly1305_key, chacha20_poly1305_pt, chacha20_poly1305_aad);
 #if HAP_IP
     test_chacha20_poly1305_inc(
             chacha20_poly1305_key,
@@ -0,0 +1,363 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+#include "Harness/HAPIPTestSession.c"
+#include "Harness/TemplateDB.c"
+
+#define kIID_LightBulb           ((uint64_t) 0x0030)
+#define kIID_LightBulbOn         ((uint64_t) 0x0031)
+#define kIID_LightBulbBrightness ((uint64_t) 0x0032)
+#define kIID_LightBulbHue        ((uint64_t) 0x0033)
+#define kIID_LightBulbLabel      ((uint64_t) 0x0034)
+
+/** Number of attributes of the light bulb service. */
+#define kLightBulbAttributeCount ((size_t) 5)
+
+/** State of the test. */
+static struct {
+    size_t numIdentifies;
+    size_t numBatchWrites;
+    size_t numWrites;
+    bool on;
+    int32_t brightness;
+    float hue;
+    char label[16];
+
+    /** Status that is reported for the On characteristic. */
+    HAPError onStatus;
+
+    /** Whether events are raised for On and Hue while handling the batch write. */
+    bool raiseEvents;
+} test;
+
+HAP_RESULT_USE_CHECK
+static HAPError IdentifyAccessory(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPAccessoryIdentifyRequest* request HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    test.numIdentifies++;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleOnRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPBoolCharacteristicReadRequest* request HAP_UNUSED,
+        bool* value,
+        void* _Nullable context HAP_UNUSED) {
+    *value = test.on;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleOnWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPBoolCharacteristicWriteRequest* request HAP_UNUSED,
+        bool value HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    // Writes over IP are handled by the batch write handler.
+    HAPFatalError();
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleBrightnessRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPIntCharacteristicReadRequest* request HAP_UNUSED,
+        int32_t* value,
+        void* _Nullable context HAP_UNUSED) {
+    *value = test.brightness;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleBrightnessWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPIntCharacteristicWriteRequest* request HAP_UNUSED,
+        int32_t value HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    HAPFatalError();
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleHueRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPFloatCharacteristicReadRequest* request HAP_UNUSED,
+        float* value,
+        void* _Nullable context HAP_UNUSED) {
+    *value = test.hue;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleHueWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPFloatCharacteristicWriteRequest* request HAP_UNUSED,
+        float value HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    HAPFatalError();
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleLabelRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPStringCharacteristicReadRequest* request HAP_UNUSED,
+        char* value,
+        size_t maxValueBytes,
+        void* _Nullable context HAP_UNUSED) {
+    size_t numBytes = HAPStringGetNumBytes(test.label);
+    HAPAssert(numBytes < maxValueBytes);
+    HAPRawBufferCopyBytes(value, test.label, numBytes + 1);
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleLabelWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPStringCharacteristicWriteRequest* request HAP_UNUSED,
+        const char* value HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    HAPFatalError();
+}
+
+static const HAPBoolCharacteristic onCharacteristic = {
+    .format = kHAPCharacteristicFormat_Bool,
+    .iid = kIID_LightBulbOn,
+    .characteristicType = &kHAPCharacteristicType_On,
+    .debugDescription = kHAPCharacteristicDebugDescription_On,
+    .properties = { .readable = true, .writable = true, .supportsEventNotification = true },
+    .callbacks = { .handleRead = HandleOnRead, .handleWrite = HandleOnWrite }
+};
+
+static const HAPIntCharacteristic brightnessCharacteristic = {
+    .format = kHAPCharacteristicFormat_Int,
+    .iid = kIID_LightBulbBrightness,
+    .characteristicType = &kHAPCharacteristicType_Brightness,
+    .debugDescription = kHAPCharacteristicDebugDescription_Brightness,
+    .properties = { .readable = true, .writable = true, .supportsEventNotification = true },
+    .units = kHAPCharacteristicUnits_Percentage,
+    .constraints = { .minimumValue = 0, .maximumValue = 100, .stepValue = 1 },
+    .callbacks = { .handleRead = HandleBrightnessRead, .handleWrite = HandleBrightnessWrite }
+};
+
+static const HAPFloatCharacteristic hueCharacteristic = {
+    .format = kHAPCharacteristicFormat_Float,
+    .iid = kIID_LightBulbHue,
+    .characteristicType = &kHAPCharacteristicType_Hue,
+    .debugDescription = kHAPCharacteristicDebugDescription_Hue,
+    .properties = { .readable = true, .writable = true, .supportsEventNotification = true },
+    .units = kHAPCharacteristicUnits_ArcDegrees,
+    .constraints = { .minimumValue = 0, .maximumValue = 360, .stepValue = 1 },
+    .callbacks = { .handleRead = HandleHueRead, .handleWrite = HandleHueWrite }
+};
+
+static const HAPStringCharacteristic labelCharacteristic = {
+    .format = kHAPCharacteristicFormat_String,
+    .iid = kIID_LightBulbLabel,
+    .characteristicType = &kHAPCharacteristicType_Name,
+    .debugDescription = kHAPCharacteristicDebugDescription_Name,
+    .properties = { .readable = true, .writable = true },
+    .constraints = { .maxLength = sizeof test.label - 1 },
+    .callbacks = { .handleRead = HandleLabelRead, .handleWrite = HandleLabelWrite }
+};
+
+static const HAPService lightBulbService;
+
+static const HAPAccessory accessory;
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleLightBulbBatchWrite(
+        HAPAccessoryServerRef* server,
+        const HAPServiceRequest* request,
+        HAPCharacteristicBatchWrite* writes,
+        size_t numWrites,
+        void* _Nullable context HAP_UNUSED) {
+    HAPAssert(request->transportType == kHAPTransportType_IP);
+    HAPAssert(request->service == &lightBulbService);
+    HAPAssert(request->accessory == &accessory);
+
+    test.numBatchWrites++;
+    test.numWrites = numWrites;
+    for (size_t i = 0; i < numWrites; i++) {
+        HAPCharacteristicBatchWrite* write = &writes[i];
+        HAPAssert(write->status == kHAPError_None);
+        if (write->characteristic == &onCharacteristic) {
+            if (test.onStatus) {
+                write->status = test.onStatus;
+            } else {
+                test.on = write->value.boolValue;
+            }
+        } else if (write->characteristic == &brightnessCharacteristic) {
+            test.brightness = write->value.intValue;
+        } else if (write->characteristic == &hueCharacteristic) {
+            test.hue = write->value.floatValue;
+        } else if (write->characteristic == &labelCharacteristic) {
+            size_t numBytes = HAPStringGetNumBytes(write->value.stringValue);
+            HAPAssert(numBytes < sizeof test.label);
+            HAPRawBufferCopyBytes(test.label, write->value.stringValue, numBytes + 1);
+        } else {
+            HAPFatalError();
+        }
+    }
+
+    if (test.raiseEvents) {
+        HAPAccessoryServerRaiseEvent(server, &onCharacteristic, &lightBulbService, &accessory);
+        HAPAccessoryServerRaiseEvent(server, &hueCharacteristic, &lightBulbService, &accessory);
+    }
+    return kHAPError_None;
+}
+
+static const HAPService lightBulbService = {
+    .iid = kIID_LightBulb,
+    .serviceType = &kHAPServiceType_LightBulb,
+    .debugDescription = kHAPServiceDebugDescription_LightBulb,
+    .properties = { .primaryService = true },
+    .characteristics = (const HAPCharacteristic* const[]) { &onCharacteristic,
+                                                            &brightnessCharacteristic,
+                                                            &hueCharacteristic,
+                                                            &labelCharacteristic,
+                                                            NULL },
+    .callbacks = { .handleBatchWrite = HandleLightBulbBatchWrite }
+};
+
+static const HAPAccessory accessory = { .aid = 1,
+                                        .category = kHAPAccessoryCategory_Lighting,
+                                        .name = "Acme Test",
+                                        .manufacturer = "Acme",
+                                        .model = "Test1,1",
+                                        .serialNumber = "099DB48E9E28",
+                                        .firmwareVersion = "1",
+                                        .hardwareVersion = "1",
+                                        .services = (const HAPService* const[]) { &accessoryInformationService,
+                                                                                  &hapProtocolInformationService,
+                                                                                  &pairingService,
+                                                                                  &lightBulbService,
+                                                                                  NULL },
+                                        .callbacks = { .identify = IdentifyAccessory } };
+
+static void HandleUpdatedAccessoryServerState(HAPAccessoryServerRef* server HAP_UNUSED, void* _Nullable context HAP_UNUSED) {
+}
+
+/** Accessory server. */
+static HAPAccessoryServerRef accessoryServer;
+
+int main() {
+    HAPPlatformCreate();
+
+    // Prepare accessory server storage.
+    static HAPIPSession ipSessions[1];
+    static HAPIPSessionSlotRef ipSessionSlots[HAPArrayCount(ipSessions)];
+    static uint8_t ipInboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultInboundBufferSize];
+    static uint8_t ipOutboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultOutboundBufferSize];
+    static HAPIPEventNotificationRef
+            ipEventNotifications[HAPArrayCount(ipSessions)][kAttributeCount + kLightBulbAttributeCount];
+    for (size_t i = 0; i < HAPArrayCount(ipSessions); i++) {
+        ipSessions[i].inboundBuffer.bytes = ipInboundBuffers[i];
+        ipSessions[i].inboundBuffer.numBytes = sizeof ipInboundBuffers[i];
+        ipSessions[i].outboundBuffer.bytes = ipOutboundBuffers[i];
+        ipSessions[i].outboundBuffer.numBytes = sizeof ipOutboundBuffers[i];
+        ipSessions[i].eventNotifications = ipEventNotifications[i];
+        ipSessions[i].numEventNotifications = HAPArrayCount(ipEventNotifications[i]);
+    }
+    static HAPIPReadContextRef ipReadContexts[kAttributeCount + kLightBulbAttributeCount];
+    static HAPIPWriteContextRef ipWriteContexts[kAttributeCount + kLightBulbAttributeCount];
+    static uint8_t ipScratchBuffer[kHAPIPSession_DefaultScratchBufferSize];
+    static HAPIPAccessoryServerStorage ipAccessoryServerStorage = {
+        .sessions = ipSessions,
+        .numSessions = HAPArrayCount(ipSessions),
+        .sessionSlots = ipSessionSlots,
+        .readContexts = ipReadContexts,
+        .numReadContexts = HAPArrayCount(ipReadContexts),
+        .writeContexts = ipWriteContexts,
+        .numWriteContexts = HAPArrayCount(ipWriteContexts),
+        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer }
+    };
+
+    // Initialize accessory server.
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ip = { .transport = &kHAPAccessoryServerTransport_IP,
+                            .accessoryServerStorage = &ipAccessoryServerStorage } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+
+    // Start accessory server.
+    HAPAccessoryServerStart(&accessoryServer, &accessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+
+    // Register a paired admin controller.
+    HAPIPTestSessionAddPairing(&accessoryServer, /* key: */ 0, /* isAdmin: */ true);
+
+    // Connect and establish a security session as if Pair Verify had completed.
+    static HAPIPTestSession controller;
+    HAPIPTestSessionOpen(&controller, &accessoryServer, /* pairingID: */ 0);
+
+    static char response[4096];
+
+    // Subscribe to On and Hue. Subscriptions are handled without invoking the batch write handler.
+    HAPIPTestSessionSendWriteRequest(
+            &controller,
+            "{\"characteristics\":["
+            "{\"aid\":1,\"iid\":49,\"ev\":true},"
+            "{\"aid\":1,\"iid\":51,\"ev\":true}]}");
+    HAPIPTestSessionReceiveResponse(&controller, response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 204 ", 13));
+    HAPAssert(test.numBatchWrites == 0);
+
+    // Writes to the light bulb service are handed over together. Other writes are handled individually.
+    HAPIPTestSessionSendWriteRequest(
+            &controller,
+            "{\"characteristics\":["
+            "{\"aid\":1,\"iid\":49,\"value\":true},"
+            "{\"aid\":1,\"iid\":2,\"value\":true},"
+            "{\"aid\":1,\"iid\":50,\"value\":42},"
+            "{\"aid\":1,\"iid\":51,\"value\":120},"
+            "{\"aid\":1,\"iid\":52,\"value\":\"Kitchen\"}]}");
+    HAPIPTestSessionReceiveResponse(&controller, response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 204 ", 13));
+    HAPAssert(test.numIdentifies == 1);
+    HAPAssert(test.numBatchWrites == 1);
+    HAPAssert(test.numWrites == 4);
+    HAPAssert(test.on);
+    HAPAssert(test.brightness == 42);
+    HAPAssert(test.hue == 120);
+    HAPAssert(HAPStringAreEqual(test.label, "Kitchen"));
+
+    // Values that violate constraints are rejected before the batch write handler is invoked.
+    // Per-write statuses are reported in a Multi-Status response.
+    // The writing controller is only notified about values that it did not write.
+    test.onStatus = kHAPError_Busy;
+    test.raiseEvents = true;
+    HAPIPTestSessionSendWriteRequest(
+            &controller,
+            "{\"characteristics\":["
+            "{\"aid\":1,\"iid\":49,\"value\":false},"
+            "{\"aid\":1,\"iid\":50,\"value\":200}]}");
+    HAPIPTestSessionReceiveResponse(&controller, response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 207 ", 13));
+    HAPAssert(HAPIPTestStringContains(response, "{\"aid\":1,\"iid\":49,\"status\":-70403}"));
+    HAPAssert(HAPIPTestStringContains(response, "{\"aid\":1,\"iid\":50,\"status\":-70410}"));
+    HAPAssert(test.numBatchWrites == 2);
+    HAPAssert(test.numWrites == 1);
+    HAPAssert(test.on);
+    HAPAssert(test.brightness == 42);
+
+    HAPPlatformClockAdvance(HAPSecond * 5);
+    HAPIPTestSessionReceiveResponse(&controller, response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "EVENT/1.0 200 OK", 16));
+    HAPAssert(HAPIPTestStringContains(response, "\"iid\":51"));
+    HAPAssert(!HAPIPTestStringContains(response, "\"iid\":49"));
+
+    HAPIPTestSessionClose(&controller);
+
+    return 0;
+}
@@ -0,0 +1,211 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+#include "Harness/TemplateDB.c"
+
+HAP_RESULT_USE_CHECK
+static HAPError IdentifyAccessory(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPAccessoryIdentifyRequest* request HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    return kHAPError_None;
+}
+
+static const HAPAccessory accessory = { .aid = 1,
+                                        .category = kHAPAccessoryCategory_Other,
+                                        .name = "Acme Test",
+                                        .manufacturer = "Acme",
+                                        .model = "Test1,1",
+                                        .serialNumber = "099DB48E9E28",
+                                        .firmwareVersion = "1",
+                                        .hardwareVersion = "1",
+                                        .services = (const HAPService* const[]) { &accessoryInformationService,
+                                                                                  &hapProtocolInformationService,
+                                                                                  &pairingService,
+                                                                                  NULL },
+                                        .callbacks = { .identify = IdentifyAccessory } };
+
+/** Size of the inbound and outbound buffers of each session. */
+#define kSessionBufferSize ((size_t) 1024)
+
+/** Size of each buffer pool block. */
+#define kBufferPoolBlockSize ((size_t) 16384)
+
+static void HandleUpdatedAccessoryServerState(HAPAccessoryServerRef* server HAP_UNUSED, void* _Nullable context HAP_UNUSED) {
+}
+
+/**
+ * Sends data to the accessory server, running the accessory server while the stream buffer is full.
+ * Stops early if the accessory server closes the connection.
+ */
+static void SendBytes(HAPPlatformTCPStreamRef tcpStream, const void* bytes, size_t numBytes) {
+    HAPError err;
+
+    const uint8_t* b = bytes;
+    while (numBytes) {
+        size_t numBytesWritten;
+        err = HAPPlatformTCPStreamClientWrite(
+                HAPNonnull(platform.ip.tcpStreamManager), tcpStream, b, numBytes, &numBytesWritten);
+        if (err == kHAPError_Busy) {
+            numBytesWritten = 0;
+        } else {
+            HAPAssert(!err);
+            if (!numBytesWritten) {
+                // Connection has been closed by the accessory server.
+                break;
+            }
+        }
+        b += numBytesWritten;
+        numBytes -= numBytesWritten;
+        HAPPlatformClockAdvance(0);
+    }
+}
+
+/**
+ * Sends a PUT /characteristics request with a body of the given size.
+ */
+static void SendLargeRequest(HAPPlatformTCPStreamRef tcpStream, size_t numBodyBytes) {
+    HAPError err;
+
+    char header[128];
+    err = HAPStringWithFormat(
+            header,
+            sizeof header,
+            "PUT /characteristics HTTP/1.1\r\n"
+            "Content-Type: application/hap+json\r\n"
+            "Content-Length: %lu\r\n\r\n",
+            (unsigned long) numBodyBytes);
+    HAPAssert(!err);
+    SendBytes(tcpStream, header, HAPStringGetNumBytes(header));
+
+    static char body[kBufferPoolBlockSize];
+    HAPAssert(numBodyBytes <= sizeof body);
+    for (size_t i = 0; i < numBodyBytes; i++) {
+        body[i] = ' ';
+    }
+    SendBytes(tcpStream, body, numBodyBytes);
+}
+
+/**
+ * Receives a response from the accessory server.
+ *
+ * @return Number of bytes received. 0 if the connection has been closed.
+ */
+HAP_RESULT_USE_CHECK
+static size_t ReceiveBytes(HAPPlatformTCPStreamRef tcpStream, char* bytes, size_t maxBytes) {
+    HAPError err;
+
+    HAPPlatformClockAdvance(0);
+    size_t numBytes;
+    err = HAPPlatformTCPStreamClientRead(
+            HAPNonnull(platform.ip.tcpStreamManager), tcpStream, bytes, maxBytes - 1, &numBytes);
+    HAPAssert(!err);
+    bytes[numBytes] = '\0';
+    return numBytes;
+}
+
+int main() {
+    HAPError err;
+    HAPPlatformCreate();
+
+    // Prepare accessory server storage.
+    static HAPIPSession ipSessions[2];
+    static HAPIPSessionSlotRef ipSessionSlots[HAPArrayCount(ipSessions)];
+    static uint8_t ipInboundBuffers[HAPArrayCount(ipSessions)][kSessionBufferSize];
+    static uint8_t ipOutboundBuffers[HAPArrayCount(ipSessions)][kSessionBufferSize];
+    static HAPIPEventNotificationRef ipEventNotifications[HAPArrayCount(ipSessions)][kAttributeCount];
+    for (size_t i = 0; i < HAPArrayCount(ipSessions); i++) {
+        ipSessions[i].inboundBuffer.bytes = ipInboundBuffers[i];
+        ipSessions[i].inboundBuffer.numBytes = sizeof ipInboundBuffers[i];
+        ipSessions[i].outboundBuffer.bytes = ipOutboundBuffers[i];
+        ipSessions[i].outboundBuffer.numBytes = sizeof ipOutboundBuffers[i];
+        ipSessions[i].eventNotifications = ipEventNotifications[i];
+        ipSessions[i].numEventNotifications = HAPArrayCount(ipEventNotifications[i]);
+    }
+    static HAPIPReadContextRef ipReadContexts[kAttributeCount];
+    static HAPIPWriteContextRef ipWriteContexts[kAttributeCount];
+    static uint8_t ipScratchBuffer[kHAPIPSession_DefaultScratchBufferSize];
+    static uint8_t ipBufferPool[1][kBufferPoolBlockSize];
+    static HAPIPAccessoryServerStorage ipAccessoryServerStorage = {
+        .sessions = ipSessions,
+        .numSessions = HAPArrayCount(ipSessions),
+        .sessionSlots = ipSessionSlots,
+        .readContexts = ipReadContexts,
+        .numReadContexts = HAPArrayCount(ipReadContexts),
+        .writeContexts = ipWriteContexts,
+        .numWriteContexts = HAPArrayCount(ipWriteContexts),
+        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer },
+        .bufferPool = { .bytes = ipBufferPool,
+                        .numBytesPerBlock = sizeof ipBufferPool[0],
+                        .numBlocks = HAPArrayCount(ipBufferPool) }
+    };
+
+    // Initialize accessory server.
+    static HAPAccessoryServerRef accessoryServer;
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ip = { .transport = &kHAPAccessoryServerTransport_IP,
+                            .accessoryServerStorage = &ipAccessoryServerStorage } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) &accessoryServer;
+
+    // Start accessory server.
+    HAPAccessoryServerStart(&accessoryServer, &accessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+
+    char response[512];
+    size_t numResponseBytes;
+
+    // A request that exceeds the inbound buffer of the session is received using a buffer pool block.
+    {
+        HAPPlatformTCPStreamRef tcpStream;
+        err = HAPPlatformTCPStreamManagerConnectToListener(HAPNonnull(platform.ip.tcpStreamManager), &tcpStream);
+        HAPAssert(!err);
+        HAPPlatformClockAdvance(0);
+
+        SendLargeRequest(tcpStream, 8 * kSessionBufferSize);
+        numResponseBytes = ReceiveBytes(tcpStream, response, sizeof response);
+        HAPAssert(numResponseBytes);
+        HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 470 ", 13));
+        HAPAssert(!server->ip.bufferPoolBlocksInUse);
+
+        // Subsequent small requests are served from the session's own buffers.
+        static const char request[] = "POST /identify HTTP/1.1\r\nContent-Length: 0\r\n\r\n";
+        SendBytes(tcpStream, request, sizeof request - 1);
+        numResponseBytes = ReceiveBytes(tcpStream, response, sizeof response);
+        HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 204 ", 13));
+        HAPAssert(!server->ip.bufferPoolBlocksInUse);
+
+        HAPPlatformTCPStreamManagerClientClose(HAPNonnull(platform.ip.tcpStreamManager), tcpStream);
+        HAPPlatformClockAdvance(0);
+    }
+
+    // A request that exceeds the buffer pool block closes the connection and returns the block.
+    {
+        HAPPlatformTCPStreamRef tcpStream;
+        err = HAPPlatformTCPStreamManagerConnectToListener(HAPNonnull(platform.ip.tcpStreamManager), &tcpStream);
+        HAPAssert(!err);
+        HAPPlatformClockAdvance(0);
+
+        SendLargeRequest(tcpStream, kBufferPoolBlockSize);
+        numResponseBytes = ReceiveBytes(tcpStream, response, sizeof response);
+        HAPAssert(!numResponseBytes);
+        HAPAssert(!server->ip.bufferPoolBlocksInUse);
+
+        HAPPlatformTCPStreamManagerClientClose(HAPNonnull(platform.ip.tcpStreamManager), tcpStream);
+        HAPPlatformClockAdvance(0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,592 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+#include "Harness/HAPIPTestSession.c"
+#include "Harness/TemplateDB.c"
+
+#define kIID_LightBulb           ((uint64_t) 0x0030)
+#define kIID_LightBulbOn         ((uint64_t) 0x0031)
+#define kIID_LightBulbBrightness ((uint64_t) 0x0032)
+#define kIID_LightBulbLabel      ((uint64_t) 0x0033)
+#define kIID_LightBulbScene      ((uint64_t) 0x0034)
+#define kIID_LightBulbSchedule   ((uint64_t) 0x0035)
+
+/** Number of attributes of the light bulb service. */
+#define kLightBulbAttributeCount ((size_t) 6)
+
+/** Number of connected controllers. */
+#define kNumControllers ((size_t) 2)
+
+/** State of the test. */
+static struct {
+    bool on;
+    int32_t brightness;
+
+    /** Whether the On characteristic defers reads and writes. */
+    bool isDeferring;
+
+    size_t numOnReads;
+    size_t numOnWrites;
+
+    /** Value of the deferred write. */
+    bool pendingOn;
+
+    /** Whether the On characteristic completes deferred writes from within the write handler. */
+    bool isCompletingSynchronously;
+
+    char label[64];
+    size_t numLabelWrites;
+
+    uint8_t scene[8];
+    size_t numSceneBytes;
+    size_t numSceneWrites;
+
+    uint8_t scheduleType;
+    uint8_t scheduleValue;
+    size_t numScheduleWrites;
+
+    /** Session of the deferred request. */
+    HAPSessionRef* _Nullable session;
+} test;
+
+HAP_RESULT_USE_CHECK
+static HAPError IdentifyAccessory(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPAccessoryIdentifyRequest* request HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleOnRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPBoolCharacteristicReadRequest* request,
+        bool* value,
+        void* _Nullable context HAP_UNUSED) {
+    test.numOnReads++;
+    if (test.isDeferring) {
+        test.session = request->session;
+        return kHAPError_InProgress;
+    }
+    *value = test.on;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleOnWrite(
+        HAPAccessoryServerRef* server,
+        const HAPBoolCharacteristicWriteRequest* request,
+        bool value,
+        void* _Nullable context HAP_UNUSED) {
+    test.numOnWrites++;
+    if (test.isDeferring) {
+        test.session = request->session;
+        test.pendingOn = value;
+        if (test.isCompletingSynchronously) {
+            test.on = value;
+            HAPAccessoryServerCompleteRequest(
+                    server,
+                    request->characteristic,
+                    request->service,
+                    request->accessory,
+                    request->session,
+                    kHAPError_None);
+        }
+        return kHAPError_InProgress;
+    }
+    test.on = value;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleBrightnessRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPIntCharacteristicReadRequest* request HAP_UNUSED,
+        int32_t* value,
+        void* _Nullable context HAP_UNUSED) {
+    *value = test.brightness;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleBrightnessWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPIntCharacteristicWriteRequest* request HAP_UNUSED,
+        int32_t value,
+        void* _Nullable context HAP_UNUSED) {
+    test.brightness = value;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleLabelRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPStringCharacteristicReadRequest* request HAP_UNUSED,
+        char* value,
+        size_t maxValueBytes,
+        void* _Nullable context HAP_UNUSED) {
+    size_t numBytes = HAPStringGetNumBytes(test.label);
+    HAPAssert(numBytes < maxValueBytes);
+    HAPRawBufferCopyBytes(value, test.label, numBytes + 1);
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleLabelWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPStringCharacteristicWriteRequest* request HAP_UNUSED,
+        const char* value,
+        void* _Nullable context HAP_UNUSED) {
+    test.numLabelWrites++;
+    size_t numBytes = HAPStringGetNumBytes(value);
+    HAPAssert(numBytes < sizeof test.label);
+    HAPRawBufferCopyBytes(test.label, value, numBytes + 1);
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleSceneRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPDataCharacteristicReadRequest* request HAP_UNUSED,
+        void* valueBytes,
+        size_t maxValueBytes,
+        size_t* numValueBytes,
+        void* _Nullable context HAP_UNUSED) {
+    HAPAssert(test.numSceneBytes <= maxValueBytes);
+    HAPRawBufferCopyBytes(valueBytes, test.scene, test.numSceneBytes);
+    *numValueBytes = test.numSceneBytes;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleSceneWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPDataCharacteristicWriteRequest* request HAP_UNUSED,
+        const void* valueBytes,
+        size_t numValueBytes,
+        void* _Nullable context HAP_UNUSED) {
+    test.numSceneWrites++;
+    HAPAssert(numValueBytes <= sizeof test.scene);
+    HAPRawBufferCopyBytes(test.scene, valueBytes, numValueBytes);
+    test.numSceneBytes = numValueBytes;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleScheduleWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPTLV8CharacteristicWriteRequest* request HAP_UNUSED,
+        HAPTLVReaderRef* requestReader,
+        void* _Nullable context HAP_UNUSED) {
+    HAPError err;
+
+    test.numScheduleWrites++;
+    bool found;
+    HAPTLV tlv;
+    err = HAPTLVReaderGetNext(requestReader, &found, &tlv);
+    HAPAssert(!err && found && tlv.value.numBytes == 1);
+    test.scheduleType = tlv.type;
+    test.scheduleValue = ((const uint8_t*) tlv.value.bytes)[0];
+    return kHAPError_None;
+}
+
+static const HAPUUID kCharacteristicType_Scene = { { 0x91, 0x52, 0x76, 0xBB, 0x26, 0x00, 0x00, 0x80,
+                                                     0x00, 0x10, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00 } };
+
+static const HAPUUID kCharacteristicType_Schedule = { { 0x91, 0x52, 0x76, 0xBB, 0x26, 0x00, 0x00, 0x80,
+                                                        0x00, 0x10, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00 } };
+
+static const HAPBoolCharacteristic onCharacteristic = {
+    .format = kHAPCharacteristicFormat_Bool,
+    .iid = kIID_LightBulbOn,
+    .characteristicType = &kHAPCharacteristicType_On,
+    .debugDescription = kHAPCharacteristicDebugDescription_On,
+    .properties = { .readable = true, .writable = true, .supportsEventNotification = true },
+    .callbacks = { .handleRead = HandleOnRead, .handleWrite = HandleOnWrite }
+};
+
+static const HAPIntCharacteristic brightnessCharacteristic = {
+    .format = kHAPCharacteristicFormat_Int,
+    .iid = kIID_LightBulbBrightness,
+    .characteristicType = &kHAPCharacteristicType_Brightness,
+    .debugDescription = kHAPCharacteristicDebugDescription_Brightness,
+    .properties = { .readable = true, .writable = true, .supportsEventNotification = true },
+    .units = kHAPCharacteristicUnits_Percentage,
+    .constraints = { .minimumValue = 0, .maximumValue = 100, .stepValue = 1 },
+    .callbacks = { .handleRead = HandleBrightnessRead, .handleWrite = HandleBrightnessWrite }
+};
+
+static const HAPStringCharacteristic labelCharacteristic = {
+    .format = kHAPCharacteristicFormat_String,
+    .iid = kIID_LightBulbLabel,
+    .characteristicType = &kHAPCharacteristicType_Name,
+    .debugDescription = kHAPCharacteristicDebugDescription_Name,
+    .properties = { .readable = true, .writable = true, .ip = { .supportsWriteResponse = true } },
+    .constraints = { .maxLength = sizeof test.label - 1 },
+    .callbacks = { .handleRead = HandleLabelRead, .handleWrite = HandleLabelWrite }
+};
+
+static const HAPDataCharacteristic sceneCharacteristic = {
+    .format = kHAPCharacteristicFormat_Data,
+    .iid = kIID_LightBulbScene,
+    .characteristicType = &kCharacteristicType_Scene,
+    .debugDescription = "scene",
+    .properties = { .readable = true, .writable = true },
+    .constraints = { .maxLength = sizeof test.scene },
+    .callbacks = { .handleRead = HandleSceneRead, .handleWrite = HandleSceneWrite }
+};
+
+static const HAPTLV8Characteristic scheduleCharacteristic = {
+    .format = kHAPCharacteristicFormat_TLV8,
+    .iid = kIID_LightBulbSchedule,
+    .characteristicType = &kCharacteristicType_Schedule,
+    .debugDescription = "schedule",
+    .properties = { .writable = true },
+    .callbacks = { .handleWrite = HandleScheduleWrite }
+};
+
+static const HAPService lightBulbService = {
+    .iid = kIID_LightBulb,
+    .serviceType = &kHAPServiceType_LightBulb,
+    .debugDescription = kHAPServiceDebugDescription_LightBulb,
+    .properties = { .primaryService = true },
+    .characteristics = (const HAPCharacteristic* const[]) { &onCharacteristic,
+                                                            &brightnessCharacteristic,
+                                                            &labelCharacteristic,
+                                                            &sceneCharacteristic,
+                                                            &scheduleCharacteristic,
+                                                            NULL }
+};
+
+static const HAPAccessory accessory = { .aid = 1,
+                                        .category = kHAPAccessoryCategory_Lighting,
+                                        .name = "Acme Test",
+                                        .manufacturer = "Acme",
+                                        .model = "Test1,1",
+                                        .serialNumber = "099DB48E9E28",
+                                        .firmwareVersion = "1",
+                                        .hardwareVersion = "1",
+                                        .services = (const HAPService* const[]) { &accessoryInformationService,
+                                                                                  &hapProtocolInformationService,
+                                                                                  &pairingService,
+                                                                                  &lightBulbService,
+                                                                                  NULL },
+                                        .callbacks = { .identify = IdentifyAccessory } };
+
+static void HandleUpdatedAccessoryServerState(HAPAccessoryServerRef* server HAP_UNUSED, void* _Nullable context HAP_UNUSED) {
+}
+
+/** Accessory server. */
+static HAPAccessoryServerRef accessoryServer;
+
+int main() {
+    HAPPlatformCreate();
+
+    // Prepare accessory server storage.
+    static HAPIPSession ipSessions[kNumControllers];
+    static HAPIPSessionSlotRef ipSessionSlots[HAPArrayCount(ipSessions)];
+    static uint8_t ipInboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultInboundBufferSize];
+    static uint8_t ipOutboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultOutboundBufferSize];
+    static HAPIPEventNotificationRef
+            ipEventNotifications[HAPArrayCount(ipSessions)][kAttributeCount + kLightBulbAttributeCount];
+    for (size_t i = 0; i < HAPArrayCount(ipSessions); i++) {
+        ipSessions[i].inboundBuffer.bytes = ipInboundBuffers[i];
+        ipSessions[i].inboundBuffer.numBytes = sizeof ipInboundBuffers[i];
+        ipSessions[i].outboundBuffer.bytes = ipOutboundBuffers[i];
+        ipSessions[i].outboundBuffer.numBytes = sizeof ipOutboundBuffers[i];
+        ipSessions[i].eventNotifications = ipEventNotifications[i];
+        ipSessions[i].numEventNotifications = HAPArrayCount(ipEventNotifications[i]);
+    }
+    static HAPIPReadContextRef ipReadContexts[kAttributeCount + kLightBulbAttributeCount];
+    static HAPIPWriteContextRef ipWriteContexts[kAttributeCount + kLightBulbAttributeCount];
+    static uint8_t ipScratchBuffer[kHAPIPSession_DefaultScratchBufferSize];
+    static HAPIPAccessoryServerStorage ipAccessoryServerStorage = {
+        .sessions = ipSessions,
+        .numSessions = HAPArrayCount(ipSessions),
+        .sessionSlots = ipSessionSlots,
+        .readContexts = ipReadContexts,
+        .numReadContexts = HAPArrayCount(ipReadContexts),
+        .writeContexts = ipWriteContexts,
+        .numWriteContexts = HAPArrayCount(ipWriteContexts),
+        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer }
+    };
+
+    // Initialize accessory server.
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ip = { .transport = &kHAPAccessoryServerTransport_IP,
+                            .accessoryServerStorage = &ipAccessoryServerStorage } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+
+    // Start accessory server.
+    HAPAccessoryServerStart(&accessoryServer, &accessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+
+    // Register a paired admin controller.
+    HAPIPTestSessionAddPairing(&accessoryServer, /* key: */ 0, /* isAdmin: */ true);
+
+    // Connect controllers and establish security sessions as if Pair Verify had completed.
+    static HAPIPTestSession controllers[kNumControllers];
+    for (size_t i = 0; i < HAPArrayCount(controllers); i++) {
+        HAPIPTestSessionOpen(&controllers[i], &accessoryServer, /* pairingID: */ 0);
+    }
+
+    static char response[4096];
+    test.brightness = 42;
+
+    // A deferred read holds back the response of its transaction.
+    test.isDeferring = true;
+    HAPIPTestSessionSendRequest(&controllers[0], "GET /characteristics?id=1.49,1.50 HTTP/1.1\r\n\r\n");
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(!response[0]);
+    HAPAssert(test.numOnReads == 1);
+    HAPAssert(test.session);
+
+    // Other controllers are still served.
+    HAPIPTestSessionSendRequest(&controllers[1], "GET /characteristics?id=1.50 HTTP/1.1\r\n\r\n");
+    HAPIPTestSessionReceiveResponse(&controllers[1], response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 200 ", 13));
+    HAPAssert(HAPIPTestStringContains(response, "{\"aid\":1,\"iid\":50,\"value\":42}"));
+
+    // Completions for requests that are not pending are ignored.
+    HAPAccessoryServerCompleteRequest(
+            &accessoryServer,
+            &brightnessCharacteristic,
+            &lightBulbService,
+            &accessory,
+            HAPNonnull(test.session),
+            kHAPError_None);
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(!response[0]);
+
+    // Once the read is completed, the read handler provides the value synchronously.
+    test.isDeferring = false;
+    test.on = true;
+    HAPAccessoryServerCompleteRequest(
+            &accessoryServer,
+            &onCharacteristic,
+            &lightBulbService,
+            &accessory,
+            HAPNonnull(test.session),
+            kHAPError_None);
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 200 ", 13));
+    HAPAssert(HAPIPTestStringContains(response, "{\"aid\":1,\"iid\":49,\"value\":1}"));
+    HAPAssert(HAPIPTestStringContains(response, "{\"aid\":1,\"iid\":50,\"value\":42}"));
+    HAPAssert(test.numOnReads == 2);
+
+    // A deferred write is not passed to the write handler again when the transaction is resumed.
+    // Other writes of the transaction are only applied once.
+    test.isDeferring = true;
+    test.session = NULL;
+    HAPIPTestSessionSendWriteRequest(
+            &controllers[0],
+            "{\"characteristics\":["
+            "{\"aid\":1,\"iid\":49,\"value\":false},"
+            "{\"aid\":1,\"iid\":50,\"value\":10}]}");
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(!response[0]);
+    HAPAssert(test.numOnWrites == 1);
+    HAPAssert(test.brightness == 10);
+    test.brightness = 20;
+    test.on = test.pendingOn;
+    HAPAccessoryServerCompleteRequest(
+            &accessoryServer,
+            &onCharacteristic,
+            &lightBulbService,
+            &accessory,
+            HAPNonnull(test.session),
+            kHAPError_None);
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 204 ", 13));
+    HAPAssert(test.numOnWrites == 1);
+    HAPAssert(test.brightness == 20);
+    HAPAssert(!test.on);
+
+    // Errors of deferred writes are reported in a Multi-Status response.
+    test.session = NULL;
+    HAPIPTestSessionSendWriteRequest(
+            &controllers[0],
+            "{\"characteristics\":["
+            "{\"aid\":1,\"iid\":49,\"value\":true},"
+            "{\"aid\":1,\"iid\":50,\"value\":30}]}");
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(!response[0]);
+    HAPAccessoryServerCompleteRequest(
+            &accessoryServer,
+            &onCharacteristic,
+            &lightBulbService,
+            &accessory,
+            HAPNonnull(test.session),
+            kHAPError_Busy);
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 207 ", 13));
+    HAPAssert(HAPIPTestStringContains(response, "{\"aid\":1,\"iid\":49,\"status\":-70403}"));
+    HAPAssert(HAPIPTestStringContains(response, "{\"aid\":1,\"iid\":50,\"status\":0}"));
+    HAPAssert(test.numOnWrites == 2);
+    HAPAssert(test.brightness == 30);
+    HAPAssert(!test.on);
+
+    // Late completions are ignored.
+    HAPAccessoryServerCompleteRequest(
+            &accessoryServer,
+            &onCharacteristic,
+            &lightBulbService,
+            &accessory,
+            HAPNonnull(test.session),
+            kHAPError_None);
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(!response[0]);
+
+    // Deferred read errors are reported in a Multi-Status response.
+    HAPIPTestSessionSendRequest(&controllers[0], "GET /characteristics?id=1.49 HTTP/1.1\r\n\r\n");
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(!response[0]);
+    HAPAccessoryServerCompleteRequest(
+            &accessoryServer,
+            &onCharacteristic,
+            &lightBulbService,
+            &accessory,
+            HAPNonnull(test.session),
+            kHAPError_Unknown);
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 207 ", 13));
+    HAPAssert(HAPIPTestStringContains(response, "{\"aid\":1,\"iid\":49,\"status\":-70402}"));
+
+    // Values that have been decoded in place are not parsed again when the transaction is resumed.
+    test.isDeferring = true;
+    test.session = NULL;
+    HAPIPTestSessionSendWriteRequest(
+            &controllers[0],
+            "{\"characteristics\":["
+            "{\"aid\":1,\"iid\":49,\"value\":true},"
+            "{\"aid\":1,\"iid\":51,\"value\":\"Desk \\\"Lamp\\\" \\u00e9\"},"
+            "{\"aid\":1,\"iid\":52,\"value\":\"AQID\"},"
+            "{\"aid\":1,\"iid\":53,\"value\":\"AQEq\"}]}");
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(!response[0]);
+    HAPAssert(test.numOnWrites == 3);
+    HAPAssert(test.numLabelWrites == 1);
+    HAPAssert(HAPStringAreEqual(test.label, "Desk \"Lamp\" \xC3\xA9"));
+    HAPAssert(test.numSceneWrites == 1);
+    HAPAssert(test.numSceneBytes == 3);
+    HAPAssert(HAPRawBufferAreEqual(test.scene, ((const uint8_t[]) { 0x01, 0x02, 0x03 }), 3));
+    HAPAssert(test.numScheduleWrites == 1);
+    HAPAssert(test.scheduleType == 0x01);
+    HAPAssert(test.scheduleValue == 0x2A);
+    test.on = test.pendingOn;
+    HAPAccessoryServerCompleteRequest(
+            &accessoryServer,
+            &onCharacteristic,
+            &lightBulbService,
+            &accessory,
+            HAPNonnull(test.session),
+            kHAPError_None);
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 204 ", 13));
+    HAPAssert(test.numOnWrites == 3);
+    HAPAssert(test.numLabelWrites == 1);
+    HAPAssert(test.numSceneWrites == 1);
+    HAPAssert(test.numScheduleWrites == 1);
+    HAPAssert(test.on);
+
+    // Write responses are read back once the transaction is resumed.
+    test.session = NULL;
+    HAPIPTestSessionSendWriteRequest(
+            &controllers[0],
+            "{\"characteristics\":["
+            "{\"aid\":1,\"iid\":49,\"value\":false},"
+            "{\"aid\":1,\"iid\":51,\"value\":\"\\\"Ceiling\\\"\",\"r\":true}]}");
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(!response[0]);
+    HAPAssert(HAPStringAreEqual(test.label, "\"Ceiling\""));
+    HAPAccessoryServerCompleteRequest(
+            &accessoryServer,
+            &onCharacteristic,
+            &lightBulbService,
+            &accessory,
+            HAPNonnull(test.session),
+            kHAPError_None);
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 207 ", 13));
+    HAPAssert(HAPIPTestStringContains(response, "{\"aid\":1,\"iid\":49,\"status\":0}"));
+    HAPAssert(HAPIPTestStringContains(
+            response, "{\"aid\":1,\"iid\":51,\"status\":0,\"value\":\"\\\"Ceiling\\\"\"}"));
+    HAPAssert(test.numOnWrites == 4);
+    HAPAssert(test.numLabelWrites == 2);
+
+    // Reads that are deferred again when the transaction is resumed are reported as busy without waiting again.
+    test.session = NULL;
+    size_t numOnReads = test.numOnReads;
+    HAPIPTestSessionSendRequest(&controllers[0], "GET /characteristics?id=1.49,1.50 HTTP/1.1\r\n\r\n");
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(!response[0]);
+    HAPAssert(test.numOnReads == numOnReads + 1);
+    HAPAccessoryServerCompleteRequest(
+            &accessoryServer,
+            &onCharacteristic,
+            &lightBulbService,
+            &accessory,
+            HAPNonnull(test.session),
+            kHAPError_None);
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 207 ", 13));
+    HAPAssert(HAPIPTestStringContains(response, "{\"aid\":1,\"iid\":49,\"status\":-70403}"));
+    HAPAssert(HAPIPTestStringContains(response, "{\"aid\":1,\"iid\":50,\"status\":0,\"value\":30}"));
+    HAPAssert(test.numOnReads == numOnReads + 2);
+    HAPIPTestSessionSendRequest(&controllers[0], "GET /characteristics?id=1.50 HTTP/1.1\r\n\r\n");
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 200 ", 13));
+
+    // Deferred writes that are completed from within the write handler are answered without waiting for the timeout.
+    test.session = NULL;
+    test.isCompletingSynchronously = true;
+    HAPIPTestSessionSendWriteRequest(&controllers[0], "{\"characteristics\":[{\"aid\":1,\"iid\":49,\"value\":true}]}");
+    HAPAssert(test.numOnWrites == 5);
+    HAPAssert(test.on);
+    HAPPlatformClockAdvance(0);
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 204 ", 13));
+    HAPAssert(test.numOnWrites == 5);
+    test.isCompletingSynchronously = false;
+
+    // Deferred requests that are not completed in time are reported as busy.
+    test.session = NULL;
+    HAPIPTestSessionSendRequest(&controllers[0], "GET /characteristics?id=1.49 HTTP/1.1\r\n\r\n");
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(!response[0]);
+    HAPAssert(test.session);
+    HAPPlatformClockAdvance(10 * HAPSecond - 1);
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(!response[0]);
+    HAPPlatformClockAdvance(1);
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(HAPRawBufferAreEqual(response, "HTTP/1.1 207 ", 13));
+    HAPAssert(HAPIPTestStringContains(response, "{\"aid\":1,\"iid\":49,\"status\":-70403}"));
+    HAPAccessoryServerCompleteRequest(
+            &accessoryServer,
+            &onCharacteristic,
+            &lightBulbService,
+            &accessory,
+            HAPNonnull(test.session),
+            kHAPError_None);
+    HAPIPTestSessionReceiveResponse(&controllers[0], response, sizeof response);
+    HAPAssert(!response[0]);
+
+    for (size_t i = 0; i < HAPArrayCount(controllers); i++) {
+        HAPIPTestSessionClose(&controllers[i]);
+    }
+
+    return 0;
+}
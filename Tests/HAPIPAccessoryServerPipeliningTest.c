@@ -0,0 +1,149 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+#include "Harness/TemplateDB.c"
+
+HAP_RESULT_USE_CHECK
+static HAPError IdentifyAccessory(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPAccessoryIdentifyRequest* request HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    return kHAPError_None;
+}
+
+static const HAPAccessory accessory = { .aid = 1,
+                                        .category = kHAPAccessoryCategory_Other,
+                                        .name = "Acme Test",
+                                        .manufacturer = "Acme",
+                                        .model = "Test1,1",
+                                        .serialNumber = "099DB48E9E28",
+                                        .firmwareVersion = "1",
+                                        .hardwareVersion = "1",
+                                        .services = (const HAPService* const[]) { &accessoryInformationService,
+                                                                                  &hapProtocolInformationService,
+                                                                                  &pairingService,
+                                                                                  NULL },
+                                        .callbacks = { .identify = IdentifyAccessory } };
+
+/** Size of the inbound and outbound buffers of each session. */
+#define kSessionBufferSize ((size_t) 256)
+
+/** Number of requests that are sent back-to-back. */
+#define kNumRequests ((size_t) 32)
+
+static void HandleUpdatedAccessoryServerState(HAPAccessoryServerRef* server HAP_UNUSED, void* _Nullable context HAP_UNUSED) {
+}
+
+int main() {
+    HAPError err;
+    HAPPlatformCreate();
+
+    // Prepare accessory server storage.
+    static HAPIPSession ipSessions[1];
+    static uint8_t ipInboundBuffers[HAPArrayCount(ipSessions)][kSessionBufferSize];
+    static uint8_t ipOutboundBuffers[HAPArrayCount(ipSessions)][kSessionBufferSize];
+    static HAPIPEventNotificationRef ipEventNotifications[HAPArrayCount(ipSessions)][kAttributeCount];
+    for (size_t i = 0; i < HAPArrayCount(ipSessions); i++) {
+        ipSessions[i].inboundBuffer.bytes = ipInboundBuffers[i];
+        ipSessions[i].inboundBuffer.numBytes = sizeof ipInboundBuffers[i];
+        ipSessions[i].outboundBuffer.bytes = ipOutboundBuffers[i];
+        ipSessions[i].outboundBuffer.numBytes = sizeof ipOutboundBuffers[i];
+        ipSessions[i].eventNotifications = ipEventNotifications[i];
+        ipSessions[i].numEventNotifications = HAPArrayCount(ipEventNotifications[i]);
+    }
+    static HAPIPReadContextRef ipReadContexts[kAttributeCount];
+    static HAPIPWriteContextRef ipWriteContexts[kAttributeCount];
+    static uint8_t ipScratchBuffer[kHAPIPSession_DefaultScratchBufferSize];
+    // Session slots are not provided and are taken from the scratch buffer.
+    static HAPIPAccessoryServerStorage ipAccessoryServerStorage = {
+        .sessions = ipSessions,
+        .numSessions = HAPArrayCount(ipSessions),
+        .readContexts = ipReadContexts,
+        .numReadContexts = HAPArrayCount(ipReadContexts),
+        .writeContexts = ipWriteContexts,
+        .numWriteContexts = HAPArrayCount(ipWriteContexts),
+        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer }
+    };
+
+    // Initialize accessory server.
+    static HAPAccessoryServerRef accessoryServer;
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ip = { .transport = &kHAPAccessoryServerTransport_IP,
+                            .accessoryServerStorage = &ipAccessoryServerStorage } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+
+    // Start accessory server.
+    HAPAccessoryServerStart(&accessoryServer, &accessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+
+    HAPPlatformTCPStreamRef tcpStream;
+    err = HAPPlatformTCPStreamManagerConnectToListener(HAPNonnull(platform.ip.tcpStreamManager), &tcpStream);
+    HAPAssert(!err);
+    HAPPlatformClockAdvance(0);
+
+    // Pipelined requests exceed the inbound buffer of the session. Requests that straddle the end of the buffer
+    // are moved to the start of the buffer once they are received completely.
+    static const char request[] = "POST /identify HTTP/1.1\r\nContent-Length: 0\r\n\r\n";
+    static char requests[kNumRequests * (sizeof request - 1)];
+    for (size_t i = 0; i < kNumRequests; i++) {
+        HAPRawBufferCopyBytes(&requests[i * (sizeof request - 1)], request, sizeof request - 1);
+    }
+
+    static const char response[] = "HTTP/1.1 204 ";
+    size_t numRequestBytesWritten = 0;
+    size_t numResponses = 0;
+    size_t numMatchedResponseBytes = 0;
+    for (size_t i = 0; i < 1000 && numResponses < kNumRequests; i++) {
+        if (numRequestBytesWritten < sizeof requests) {
+            size_t numBytes;
+            err = HAPPlatformTCPStreamClientWrite(
+                    HAPNonnull(platform.ip.tcpStreamManager),
+                    tcpStream,
+                    &requests[numRequestBytesWritten],
+                    sizeof requests - numRequestBytesWritten,
+                    &numBytes);
+            HAPAssert(!err || err == kHAPError_Busy);
+            if (!err) {
+                HAPAssert(numBytes);
+                numRequestBytesWritten += numBytes;
+            }
+        }
+        HAPPlatformClockAdvance(0);
+
+        char bytes[128];
+        size_t numBytes;
+        err = HAPPlatformTCPStreamClientRead(
+                HAPNonnull(platform.ip.tcpStreamManager), tcpStream, bytes, sizeof bytes, &numBytes);
+        HAPAssert(!err);
+        for (size_t j = 0; j < numBytes; j++) {
+            if (bytes[j] == response[numMatchedResponseBytes]) {
+                numMatchedResponseBytes++;
+                if (numMatchedResponseBytes == sizeof response - 1) {
+                    numResponses++;
+                    numMatchedResponseBytes = 0;
+                }
+            } else {
+                numMatchedResponseBytes = bytes[j] == response[0] ? 1 : 0;
+            }
+        }
+    }
+    HAPAssert(numRequestBytesWritten == sizeof requests);
+    HAPAssert(numResponses == kNumRequests);
+
+    HAPPlatformTCPStreamManagerClientClose(HAPNonnull(platform.ip.tcpStreamManager), tcpStream);
+    HAPPlatformClockAdvance(0);
+
+    return 0;
+}
@@ -0,0 +1,395 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+#include "Harness/TemplateDB.c"
+
+HAP_RESULT_USE_CHECK
+static HAPError IdentifyAccessory(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPAccessoryIdentifyRequest* request HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    return kHAPError_None;
+}
+
+static const HAPAccessory accessory = { .aid = 1,
+                                        .category = kHAPAccessoryCategory_Other,
+                                        .name = "Acme Test",
+                                        .manufacturer = "Acme",
+                                        .model = "Test1,1",
+                                        .serialNumber = "099DB48E9E28",
+                                        .firmwareVersion = "1",
+                                        .hardwareVersion = "1",
+                                        .services = (const HAPService* const[]) { &accessoryInformationService,
+                                                                                  &hapProtocolInformationService,
+                                                                                  &pairingService,
+                                                                                  NULL },
+                                        .callbacks = { .identify = IdentifyAccessory } };
+
+/** Number of sessions in each session chunk. */
+#define kNumSessionsPerChunk ((size_t) 2)
+
+/** Size of the inbound and outbound buffers of each session. */
+#define kSessionBufferSize ((size_t) 1024)
+
+static void HandleUpdatedAccessoryServerState(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+}
+
+/**
+ * Prepares sessions for use with the accessory server.
+ *
+ * @param      ipSessions           Sessions.
+ * @param      ipInboundBuffers     Inbound buffers.
+ * @param      ipOutboundBuffers    Outbound buffers.
+ * @param      ipEventNotifications Event notifications.
+ */
+static void PrepareSessions(
+        HAPIPSession ipSessions[kNumSessionsPerChunk],
+        uint8_t ipInboundBuffers[kNumSessionsPerChunk][kSessionBufferSize],
+        uint8_t ipOutboundBuffers[kNumSessionsPerChunk][kSessionBufferSize],
+        HAPIPEventNotificationRef ipEventNotifications[kNumSessionsPerChunk][kAttributeCount]) {
+    for (size_t i = 0; i < kNumSessionsPerChunk; i++) {
+        ipSessions[i].inboundBuffer.bytes = ipInboundBuffers[i];
+        ipSessions[i].inboundBuffer.numBytes = kSessionBufferSize;
+        ipSessions[i].outboundBuffer.bytes = ipOutboundBuffers[i];
+        ipSessions[i].outboundBuffer.numBytes = kSessionBufferSize;
+        ipSessions[i].eventNotifications = ipEventNotifications[i];
+        ipSessions[i].numEventNotifications = kAttributeCount;
+    }
+}
+
+/** Number of session chunks that have been allocated. */
+static size_t numAllocatedChunks;
+
+/** Sessions of the additional session chunk. */
+static HAPIPSession chunkSessions[kNumSessionsPerChunk];
+
+/** Inbound buffers of the additional sessions. Returned as allocation pointer of the chunk. */
+static uint8_t chunkInboundBuffers[kNumSessionsPerChunk][kSessionBufferSize];
+
+/**
+ * Allocates a single chunk of additional sessions.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError AllocateSessionChunk(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        size_t numSessions,
+        HAPIPSession* _Nullable* _Nonnull sessions,
+        HAPIPSessionSlotRef* _Nullable* _Nonnull sessionSlots,
+        void* _Nullable* _Nonnull allocation,
+        void* _Nullable context HAP_UNUSED) {
+    HAPAssert(numSessions == kNumSessionsPerChunk);
+
+    static HAPIPSessionSlotRef ipSessionSlots[kNumSessionsPerChunk];
+    static uint8_t ipOutboundBuffers[kNumSessionsPerChunk][kSessionBufferSize];
+    static HAPIPEventNotificationRef ipEventNotifications[kNumSessionsPerChunk][kAttributeCount];
+
+    if (numAllocatedChunks) {
+        return kHAPError_OutOfResources;
+    }
+    numAllocatedChunks++;
+
+    PrepareSessions(chunkSessions, chunkInboundBuffers, ipOutboundBuffers, ipEventNotifications);
+    *sessions = chunkSessions;
+    *sessionSlots = ipSessionSlots;
+    *allocation = chunkInboundBuffers;
+    return kHAPError_None;
+}
+
+/**
+ * Releases the chunk of additional sessions.
+ */
+static void ReleaseSessionChunk(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        size_t numSessions,
+        HAPIPSession* sessions,
+        HAPIPSessionSlotRef* sessionSlots HAP_UNUSED,
+        void* _Nullable allocation,
+        void* _Nullable context HAP_UNUSED) {
+    HAPAssert(numSessions == kNumSessionsPerChunk);
+    HAPAssert(sessions == chunkSessions);
+    HAPAssert(allocation == chunkInboundBuffers);
+    HAPAssert(numAllocatedChunks);
+    numAllocatedChunks--;
+}
+
+/**
+ * Opens a connection to the accessory server.
+ *
+ * @return TCP stream.
+ */
+HAP_RESULT_USE_CHECK
+static HAPPlatformTCPStreamRef Connect(void) {
+    HAPError err;
+
+    HAPPlatformTCPStreamRef tcpStream;
+    err = HAPPlatformTCPStreamManagerConnectToListener(HAPNonnull(platform.ip.tcpStreamManager), &tcpStream);
+    HAPAssert(!err);
+    HAPPlatformClockAdvance(0);
+    return tcpStream;
+}
+
+/**
+ * Sends data to the accessory server.
+ */
+static void SendBytes(HAPPlatformTCPStreamRef tcpStream, const char* bytes) {
+    HAPError err;
+
+    size_t numBytes = HAPStringGetNumBytes(bytes);
+    size_t numBytesWritten;
+    err = HAPPlatformTCPStreamClientWrite(
+            HAPNonnull(platform.ip.tcpStreamManager), tcpStream, bytes, numBytes, &numBytesWritten);
+    HAPAssert(!err);
+    HAPAssert(numBytesWritten == numBytes);
+    HAPPlatformClockAdvance(0);
+}
+
+/**
+ * Checks whether a connection has been closed by the accessory server.
+ */
+HAP_RESULT_USE_CHECK
+static bool IsClosed(HAPPlatformTCPStreamRef tcpStream) {
+    HAPError err;
+
+    char bytes[256];
+    size_t numBytes;
+    err = HAPPlatformTCPStreamClientRead(
+            HAPNonnull(platform.ip.tcpStreamManager), tcpStream, bytes, sizeof bytes, &numBytes);
+    if (err == kHAPError_Busy) {
+        return false;
+    }
+    HAPAssert(!err);
+    return !numBytes;
+}
+
+/**
+ * Checks that a connection is served by the accessory server.
+ */
+static void AssertIsServed(HAPPlatformTCPStreamRef tcpStream) {
+    HAPError err;
+
+    SendBytes(tcpStream, "POST /identify HTTP/1.1\r\nContent-Length: 0\r\n\r\n");
+
+    char bytes[256];
+    size_t numBytes;
+    err = HAPPlatformTCPStreamClientRead(
+            HAPNonnull(platform.ip.tcpStreamManager), tcpStream, bytes, sizeof bytes, &numBytes);
+    HAPAssert(!err);
+    HAPAssert(numBytes >= 13);
+    HAPAssert(HAPRawBufferAreEqual(bytes, "HTTP/1.1 204 ", 13));
+}
+
+/** Sessions of the accessory server storage. */
+static HAPIPSession ipSessions[kNumSessionsPerChunk];
+
+/**
+ * Marks the session of a connection as secured by a controller without admin permissions.
+ */
+static void SecureSession(HAPPlatformTCPStreamRef tcpStream) {
+    for (size_t i = 0; i < 2 * kNumSessionsPerChunk; i++) {
+        HAPIPSession* ipSession = i < kNumSessionsPerChunk ? &ipSessions[i] : &chunkSessions[i - kNumSessionsPerChunk];
+        HAPIPSessionDescriptor* descriptor = (HAPIPSessionDescriptor*) &ipSession->descriptor;
+        if (!descriptor->tcpStreamIsOpen || descriptor->tcpStream != tcpStream) {
+            continue;
+        }
+        HAPAssert(descriptor->securitySession.isOpen);
+        HAPSession* session = (HAPSession*) &descriptor->securitySession._.hap;
+        session->hap.active = true;
+        session->hap.pairingID = 0;
+        descriptor->securitySession.isSecured = true;
+        HAPAssert(!HAPSessionControllerIsAdmin(&descriptor->securitySession._.hap));
+        return;
+    }
+    HAPFatalError();
+}
+
+int main() {
+    HAPError err;
+
+    HAPPlatformCreate();
+
+    // Prepare accessory server storage.
+    static HAPIPSessionSlotRef ipSessionSlots[HAPArrayCount(ipSessions)];
+    static uint8_t ipInboundBuffers[HAPArrayCount(ipSessions)][kSessionBufferSize];
+    static uint8_t ipOutboundBuffers[HAPArrayCount(ipSessions)][kSessionBufferSize];
+    static HAPIPEventNotificationRef ipEventNotifications[HAPArrayCount(ipSessions)][kAttributeCount];
+    PrepareSessions(ipSessions, ipInboundBuffers, ipOutboundBuffers, ipEventNotifications);
+    static HAPIPReadContextRef ipReadContexts[kAttributeCount];
+    static HAPIPWriteContextRef ipWriteContexts[kAttributeCount];
+    static uint8_t ipScratchBuffer[kHAPIPSession_DefaultScratchBufferSize];
+    static HAPIPAccessoryServerStorage ipAccessoryServerStorage = {
+        .sessions = ipSessions,
+        .numSessions = HAPArrayCount(ipSessions),
+        .sessionSlots = ipSessionSlots,
+        .readContexts = ipReadContexts,
+        .numReadContexts = HAPArrayCount(ipReadContexts),
+        .writeContexts = ipWriteContexts,
+        .numWriteContexts = HAPArrayCount(ipWriteContexts),
+        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer },
+        .sessionChunks = { .allocate = AllocateSessionChunk, .release = ReleaseSessionChunk }
+    };
+
+    // Initialize accessory server.
+    static HAPAccessoryServerRef accessoryServer;
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ip = { .transport = &kHAPAccessoryServerTransport_IP,
+                            .accessoryServerStorage = &ipAccessoryServerStorage } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) &accessoryServer;
+
+    // Start accessory server.
+    HAPAccessoryServerStart(&accessoryServer, &accessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+
+    // Fill the initial sessions.
+    HAPPlatformTCPStreamRef tcpStreams[6];
+    for (size_t i = 0; i < kNumSessionsPerChunk; i++) {
+        tcpStreams[i] = Connect();
+        HAPPlatformClockAdvance(HAPSecond);
+    }
+    HAPAssert(server->ip.numSessions == kNumSessionsPerChunk);
+    HAPAssert(server->ip.numSessionChunks == 1);
+
+    // Additional sessions are allocated when all sessions are in use.
+    for (size_t i = kNumSessionsPerChunk; i < 2 * kNumSessionsPerChunk; i++) {
+        tcpStreams[i] = Connect();
+        HAPPlatformClockAdvance(HAPSecond);
+    }
+    HAPAssert(server->ip.numSessions == 2 * kNumSessionsPerChunk);
+    HAPAssert(server->ip.numSessionChunks == 2);
+    HAPAssert(numAllocatedChunks == 1);
+    for (size_t i = 0; i < 2 * kNumSessionsPerChunk; i++) {
+        HAPAssert(!IsClosed(tcpStreams[i]));
+    }
+
+    // The oldest session has a request in progress and is kept open.
+    SendBytes(tcpStreams[0], "POST /identify HTTP/1.1\r\n");
+    HAPPlatformClockAdvance(HAPSecond);
+
+    // When no more sessions can be allocated, the least recently used idle session is closed.
+    tcpStreams[4] = Connect();
+    HAPAssert(server->ip.numSessions == 2 * kNumSessionsPerChunk);
+    HAPAssert(!IsClosed(tcpStreams[0]));
+    HAPAssert(IsClosed(tcpStreams[1]));
+    for (size_t i = 2; i < 2 * kNumSessionsPerChunk; i++) {
+        HAPAssert(!IsClosed(tcpStreams[i]));
+    }
+    AssertIsServed(tcpStreams[4]);
+    HAPPlatformTCPStreamManagerClientClose(HAPNonnull(platform.ip.tcpStreamManager), tcpStreams[1]);
+    HAPPlatformClockAdvance(0);
+
+    // Sessions that have been used more recently are closed last.
+    AssertIsServed(tcpStreams[2]);
+    HAPPlatformClockAdvance(HAPSecond);
+    tcpStreams[5] = Connect();
+    HAPAssert(!IsClosed(tcpStreams[2]));
+    HAPAssert(IsClosed(tcpStreams[3]));
+    AssertIsServed(tcpStreams[5]);
+
+    // Close all connections.
+    for (size_t i = 0; i < HAPArrayCount(tcpStreams); i++) {
+        if (i != 1) {
+            HAPPlatformTCPStreamManagerClientClose(HAPNonnull(platform.ip.tcpStreamManager), tcpStreams[i]);
+        }
+    }
+    HAPPlatformClockAdvance(0);
+    HAPAssert(server->ip.numSessions == 0);
+
+    // Sessions that have just been opened are not closed to make room for new connections,
+    // even if nothing has been received on them yet.
+    for (size_t i = 0; i < 2 * kNumSessionsPerChunk; i++) {
+        tcpStreams[i] = Connect();
+    }
+    HAPAssert(server->ip.numSessions == 2 * kNumSessionsPerChunk);
+    tcpStreams[4] = Connect();
+    HAPAssert(IsClosed(tcpStreams[4]));
+    HAPPlatformTCPStreamManagerClientClose(HAPNonnull(platform.ip.tcpStreamManager), tcpStreams[4]);
+    HAPPlatformClockAdvance(0);
+    for (size_t i = 0; i < 2 * kNumSessionsPerChunk; i++) {
+        HAPAssert(!IsClosed(tcpStreams[i]));
+    }
+
+    // Once they have stayed idle for a while, the least recently used one is closed.
+    HAPPlatformClockAdvance(2 * HAPSecond);
+    tcpStreams[4] = Connect();
+    HAPAssert(IsClosed(tcpStreams[0]));
+    for (size_t i = 1; i < 2 * kNumSessionsPerChunk; i++) {
+        HAPAssert(!IsClosed(tcpStreams[i]));
+    }
+    AssertIsServed(tcpStreams[4]);
+    for (size_t i = 0; i <= 2 * kNumSessionsPerChunk; i++) {
+        HAPPlatformTCPStreamManagerClientClose(HAPNonnull(platform.ip.tcpStreamManager), tcpStreams[i]);
+    }
+    HAPPlatformClockAdvance(0);
+    HAPAssert(server->ip.numSessions == 0);
+
+    // Register a paired controller without admin permissions.
+    {
+        uint8_t pairingBytes[sizeof(HAPPairingID) + sizeof(uint8_t) + sizeof(HAPPairingPublicKey) + sizeof(uint8_t)];
+        HAPRawBufferZero(pairingBytes, sizeof pairingBytes);
+        pairingBytes[sizeof(HAPPairingID)] = 1;
+        err = HAPPlatformKeyValueStoreSet(
+                platform.keyValueStore,
+                kHAPKeyValueStoreDomain_Pairings,
+                /* key: */ 0,
+                pairingBytes,
+                sizeof pairingBytes);
+        HAPAssert(!err);
+    }
+
+    // The controller connects first. Attackers fill the remaining sessions with partially sent requests.
+    tcpStreams[0] = Connect();
+    SecureSession(tcpStreams[0]);
+    HAPPlatformClockAdvance(HAPSecond);
+    for (size_t i = 1; i < 2 * kNumSessionsPerChunk; i++) {
+        tcpStreams[i] = Connect();
+        SendBytes(tcpStreams[i], "POST /identify HTTP/1.1\r\n");
+        HAPPlatformClockAdvance(HAPSecond);
+    }
+    HAPAssert(server->ip.numSessions == 2 * kNumSessionsPerChunk);
+
+    // Further connections are rejected while the partially sent requests are recent.
+    // The secured session of the controller is not closed to make room for them.
+    tcpStreams[4] = Connect();
+    HAPAssert(IsClosed(tcpStreams[4]));
+    HAPPlatformTCPStreamManagerClientClose(HAPNonnull(platform.ip.tcpStreamManager), tcpStreams[4]);
+    HAPPlatformClockAdvance(0);
+    for (size_t i = 0; i < 2 * kNumSessionsPerChunk; i++) {
+        HAPAssert(!IsClosed(tcpStreams[i]));
+    }
+
+    // Once stalled, the oldest session with a partially sent request is closed. The controller stays connected.
+    HAPPlatformClockAdvance(10 * HAPSecond);
+    tcpStreams[4] = Connect();
+    HAPAssert(!IsClosed(tcpStreams[0]));
+    HAPAssert(IsClosed(tcpStreams[1]));
+    for (size_t i = 2; i < 2 * kNumSessionsPerChunk; i++) {
+        HAPAssert(!IsClosed(tcpStreams[i]));
+    }
+    HAPAssert(!IsClosed(tcpStreams[4]));
+    HAPAssert(server->ip.numSessions == 2 * kNumSessionsPerChunk);
+
+    // Releasing the accessory server releases the additional sessions.
+    // Sessions with partially sent requests are closed once they time out.
+    HAPAccessoryServerStop(&accessoryServer);
+    while (server->state != kHAPAccessoryServerState_Idle) {
+        HAPPlatformClockAdvance(HAPSecond);
+    }
+    HAPAccessoryServerRelease(&accessoryServer);
+    HAPAssert(numAllocatedChunks == 0);
+
+    return 0;
+}
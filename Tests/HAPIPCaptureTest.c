@@ -0,0 +1,202 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+#include "Harness/TemplateDB.c"
+
+HAP_RESULT_USE_CHECK
+static HAPError IdentifyAccessory(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPAccessoryIdentifyRequest* request HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    return kHAPError_None;
+}
+
+static const HAPAccessory accessory = { .aid = 1,
+                                        .category = kHAPAccessoryCategory_Other,
+                                        .name = "Acme Test",
+                                        .manufacturer = "Acme",
+                                        .model = "Test1,1",
+                                        .serialNumber = "099DB48E9E28",
+                                        .firmwareVersion = "1",
+                                        .hardwareVersion = "1",
+                                        .services = (const HAPService* const[]) { &accessoryInformationService,
+                                                                                  &hapProtocolInformationService,
+                                                                                  &pairingService,
+                                                                                  NULL },
+                                        .callbacks = { .identify = IdentifyAccessory } };
+
+static void HandleUpdatedAccessoryServerState(HAPAccessoryServerRef* server HAP_UNUSED, void* _Nullable context HAP_UNUSED) {
+}
+
+/** Capture. */
+static struct {
+    uint8_t bytes[1024];
+    size_t numBytes;
+} capture;
+
+static void HandleCapture(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const void* bytes,
+        size_t numBytes,
+        void* _Nullable context HAP_UNUSED) {
+    HAPAssert(numBytes <= sizeof capture.bytes - capture.numBytes);
+    HAPRawBufferCopyBytes(&capture.bytes[capture.numBytes], bytes, numBytes);
+    capture.numBytes += numBytes;
+}
+
+int main() {
+    HAPError err;
+    HAPPlatformCreate();
+
+    // Prepare accessory server storage.
+    static HAPIPSession ipSessions[kHAPIPSessionStorage_DefaultNumElements];
+    static HAPIPSessionSlotRef ipSessionSlots[HAPArrayCount(ipSessions)];
+    static uint8_t ipInboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultInboundBufferSize];
+    static uint8_t ipOutboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultOutboundBufferSize];
+    static HAPIPEventNotificationRef ipEventNotifications[HAPArrayCount(ipSessions)][kAttributeCount];
+    for (size_t i = 0; i < HAPArrayCount(ipSessions); i++) {
+        ipSessions[i].inboundBuffer.bytes = ipInboundBuffers[i];
+        ipSessions[i].inboundBuffer.numBytes = sizeof ipInboundBuffers[i];
+        ipSessions[i].outboundBuffer.bytes = ipOutboundBuffers[i];
+        ipSessions[i].outboundBuffer.numBytes = sizeof ipOutboundBuffers[i];
+        ipSessions[i].eventNotifications = ipEventNotifications[i];
+        ipSessions[i].numEventNotifications = HAPArrayCount(ipEventNotifications[i]);
+    }
+    static HAPIPReadContextRef ipReadContexts[kAttributeCount];
+    static HAPIPWriteContextRef ipWriteContexts[kAttributeCount];
+    static uint8_t ipScratchBuffer[kHAPIPSession_DefaultScratchBufferSize];
+    static HAPIPAccessoryServerStorage ipAccessoryServerStorage = {
+        .sessions = ipSessions,
+        .numSessions = HAPArrayCount(ipSessions),
+        .sessionSlots = ipSessionSlots,
+        .readContexts = ipReadContexts,
+        .numReadContexts = HAPArrayCount(ipReadContexts),
+        .writeContexts = ipWriteContexts,
+        .numWriteContexts = HAPArrayCount(ipWriteContexts),
+        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer }
+    };
+
+    // Initialize accessory server with capturing enabled.
+    static HAPAccessoryServerRef accessoryServer;
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ip = { .transport = &kHAPAccessoryServerTransport_IP,
+                            .accessoryServerStorage = &ipAccessoryServerStorage,
+                            .capture = { .callback = HandleCapture } } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+
+    // Start accessory server.
+    HAPAccessoryServerStart(&accessoryServer, &accessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+
+    // Register admin pairing.
+    uint8_t pairingBytes[sizeof(HAPPairingID) + sizeof(uint8_t) + sizeof(HAPPairingPublicKey) + sizeof(uint8_t)];
+    HAPRawBufferZero(pairingBytes, sizeof pairingBytes);
+    pairingBytes[sizeof(HAPPairingID)] = 1;
+    pairingBytes[sizeof pairingBytes - 1] = 0x01;
+    err = HAPPlatformKeyValueStoreSet(
+            platform.keyValueStore, kHAPKeyValueStoreDomain_Pairings, 0, pairingBytes, sizeof pairingBytes);
+    HAPAssert(!err);
+
+    // Unsecured traffic is not captured.
+    HAPPlatformTCPStreamRef tcpStream;
+    err = HAPPlatformTCPStreamManagerConnectToListener(HAPNonnull(platform.ip.tcpStreamManager), &tcpStream);
+    HAPAssert(!err);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(!capture.numBytes);
+
+    // Establish security session as if Pair Verify had completed.
+    HAPIPSessionDescriptor* descriptor = NULL;
+    for (size_t i = 0; i < HAPArrayCount(ipSessions); i++) {
+        HAPIPSessionDescriptor* t = (HAPIPSessionDescriptor*) &ipSessions[i].descriptor;
+        if (t->tcpStreamIsOpen && t->tcpStream == tcpStream) {
+            descriptor = t;
+        }
+    }
+    HAPAssert(descriptor && descriptor->securitySession.isOpen);
+    HAPSession* accessorySession = (HAPSession*) &HAPNonnull(descriptor)->securitySession._.hap;
+    accessorySession->hap.active = true;
+    accessorySession->hap.pairingID = 0;
+    static HAPSessionRef controllerSessionRef;
+    HAPSession* controllerSession = (HAPSession*) &controllerSessionRef;
+    controllerSession->hap.active = true;
+
+    // Send two requests. The second request is split across writes.
+    static const char request[] = "GET /characteristics?id=1.2 HTTP/1.1\r\n\r\n";
+    static const size_t splits[] = { sizeof request - 1, 10, sizeof request - 1 - 10 };
+    size_t o = 0;
+    for (size_t i = 0; i < HAPArrayCount(splits); i++) {
+        uint8_t bytes[256];
+        HAPRawBufferCopyBytes(bytes, &request[o % (sizeof request - 1)], splits[i]);
+        o += splits[i];
+        HAPIPByteBuffer buffer = { .data = (char*) bytes, .capacity = sizeof bytes, .limit = splits[i] };
+        HAPIPSecurityProtocolEncryptData(&accessoryServer, &controllerSessionRef, &buffer);
+        size_t numBytes;
+        err = HAPPlatformTCPStreamClientWrite(
+                HAPNonnull(platform.ip.tcpStreamManager), tcpStream, bytes, buffer.limit, &numBytes);
+        HAPAssert(!err && numBytes == buffer.limit);
+        HAPPlatformClockAdvance(5 * HAPMillisecond);
+    }
+    HAPPlatformTCPStreamManagerClientClose(HAPNonnull(platform.ip.tcpStreamManager), tcpStream);
+    HAPPlatformClockAdvance(0);
+
+    // Parse capture.
+    err = HAPIPCaptureValidateHeader(capture.bytes, capture.numBytes);
+    HAPAssert(!err);
+    size_t offset = kHAPIPCapture_NumHeaderBytes;
+    bool found;
+    HAPIPCaptureRecord record;
+
+    err = HAPIPCaptureGetNextRecord(capture.bytes, capture.numBytes, &offset, &found, &record);
+    HAPAssert(!err && found);
+    HAPAssert(record.type == kHAPIPCaptureRecordType_Open);
+    uint16_t sessionID = record.sessionID;
+    HAPAssert(sessionID);
+
+    o = 0;
+    for (size_t i = 0; i < HAPArrayCount(splits); i++) {
+        err = HAPIPCaptureGetNextRecord(capture.bytes, capture.numBytes, &offset, &found, &record);
+        HAPAssert(!err && found);
+        HAPAssert(record.type == kHAPIPCaptureRecordType_Data);
+        HAPAssert(record.sessionID == sessionID);
+        HAPAssert(record.delay == (i ? 5 : 0));
+        HAPAssert(record.numBytes == splits[i]);
+        HAPAssert(HAPRawBufferAreEqual(HAPNonnull(record.bytes), &request[o % (sizeof request - 1)], splits[i]));
+        o += splits[i];
+    }
+
+    err = HAPIPCaptureGetNextRecord(capture.bytes, capture.numBytes, &offset, &found, &record);
+    HAPAssert(!err && found);
+    HAPAssert(record.type == kHAPIPCaptureRecordType_Close);
+    HAPAssert(record.sessionID == sessionID);
+    HAPAssert(record.delay == 5);
+
+    err = HAPIPCaptureGetNextRecord(capture.bytes, capture.numBytes, &offset, &found, &record);
+    HAPAssert(!err && !found);
+
+    // Truncated captures are rejected.
+    offset = kHAPIPCapture_NumHeaderBytes;
+    err = HAPIPCaptureGetNextRecord(capture.bytes, capture.numBytes - 1, &offset, &found, &record);
+    HAPAssert(!err && found);
+    for (size_t i = 0; i < HAPArrayCount(splits); i++) {
+        err = HAPIPCaptureGetNextRecord(capture.bytes, capture.numBytes - 1, &offset, &found, &record);
+        HAPAssert(!err && found);
+    }
+    err = HAPIPCaptureGetNextRecord(capture.bytes, capture.numBytes - 1, &offset, &found, &record);
+    HAPAssert(err == kHAPError_InvalidData);
+    err = HAPIPCaptureValidateHeader("HAPTRACE\x01\x00\x00\x00\x00\x00\x00\x00", kHAPIPCapture_NumHeaderBytes);
+    HAPAssert(err == kHAPError_InvalidData);
+
+    return 0;
+}
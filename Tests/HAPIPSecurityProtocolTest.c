@@ -0,0 +1,94 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+/** Number of plaintext bytes that are sent. Spans two complete frames and one partial frame. */
+#define kNumPlaintextBytes ((size_t) 2500)
+
+/** Number of bytes of the last frame that are withheld in the first decryption pass. */
+#define kNumWithheldBytes ((size_t) 10)
+
+int main() {
+    HAPError err;
+    HAPPlatformCreate();
+
+    static HAPAccessoryServerRef server;
+
+    // Sender and receiver share the controller to accessory key.
+    static HAPSessionRef senderSession;
+    static HAPSessionRef receiverSession;
+    {
+        HAPSession* sender = (HAPSession*) &senderSession;
+        HAPSession* receiver = (HAPSession*) &receiverSession;
+        sender->hap.active = true;
+        receiver->hap.active = true;
+        for (size_t i = 0; i < sizeof(HAPSessionKey); i++) {
+            sender->hap.accessoryToController.controlChannel.key.bytes[i] = (uint8_t) i;
+            receiver->hap.controllerToAccessory.controlChannel.key.bytes[i] = (uint8_t) i;
+        }
+    }
+
+    static uint8_t plaintext[kNumPlaintextBytes];
+    for (size_t i = 0; i < sizeof plaintext; i++) {
+        plaintext[i] = (uint8_t)(i * 7);
+    }
+
+    // Encrypt.
+    static uint8_t encryptedBytes[4096];
+    size_t numEncryptedBytes = HAPIPSecurityProtocolGetNumEncryptedBytes(sizeof plaintext);
+    HAPAssert(numEncryptedBytes <= sizeof encryptedBytes);
+    HAPRawBufferCopyBytes(encryptedBytes, plaintext, sizeof plaintext);
+    HAPIPByteBuffer buffer = { .data = (char*) encryptedBytes,
+                               .capacity = sizeof encryptedBytes,
+                               .limit = sizeof plaintext };
+    HAPIPSecurityProtocolEncryptData(&server, &senderSession, &buffer);
+    HAPAssert(buffer.position == 0);
+    HAPAssert(buffer.limit == numEncryptedBytes);
+
+    // Decrypt while the last frame is incomplete.
+    static uint8_t bytes[4096];
+    HAPRawBufferCopyBytes(bytes, encryptedBytes, numEncryptedBytes - kNumWithheldBytes);
+    buffer = (HAPIPByteBuffer) {
+        .data = (char*) bytes, .capacity = sizeof bytes, .limit = numEncryptedBytes - kNumWithheldBytes
+    };
+    err = HAPIPSecurityProtocolDecryptData(&server, &receiverSession, &buffer);
+    HAPAssert(!err);
+    HAPAssert(buffer.position == 2 * kHAPIPSecurityProtocol_MaxFrameBytes);
+    HAPAssert(HAPRawBufferAreEqual(bytes, plaintext, buffer.position));
+
+    // The incomplete frame is stored directly behind the plaintext.
+    size_t numCompleteFrameBytes = 2 * (sizeof(uint16_t) + kHAPIPSecurityProtocol_MaxFrameBytes +
+                                        CHACHA20_POLY1305_TAG_BYTES);
+    HAPAssert(buffer.limit - buffer.position == numEncryptedBytes - numCompleteFrameBytes - kNumWithheldBytes);
+    HAPAssert(HAPRawBufferAreEqual(
+            &bytes[buffer.position],
+            &encryptedBytes[numCompleteFrameBytes],
+            numEncryptedBytes - numCompleteFrameBytes - kNumWithheldBytes));
+
+    // Receive the withheld bytes behind the incomplete frame.
+    HAPRawBufferCopyBytes(
+            &bytes[buffer.limit], &encryptedBytes[numEncryptedBytes - kNumWithheldBytes], kNumWithheldBytes);
+    buffer.limit += kNumWithheldBytes;
+    err = HAPIPSecurityProtocolDecryptData(&server, &receiverSession, &buffer);
+    HAPAssert(!err);
+    HAPAssert(buffer.position == sizeof plaintext);
+    HAPAssert(buffer.limit == sizeof plaintext);
+    HAPAssert(HAPRawBufferAreEqual(bytes, plaintext, sizeof plaintext));
+
+    // A corrupted frame is rejected.
+    {
+        HAPRawBufferCopyBytes(bytes, plaintext, 100);
+        buffer = (HAPIPByteBuffer) { .data = (char*) bytes, .capacity = sizeof bytes, .limit = 100 };
+        HAPIPSecurityProtocolEncryptData(&server, &senderSession, &buffer);
+        bytes[50] ^= 1;
+        err = HAPIPSecurityProtocolDecryptData(&server, &receiverSession, &buffer);
+        HAPAssert(err == kHAPError_InvalidData);
+    }
+
+    return 0;
+}
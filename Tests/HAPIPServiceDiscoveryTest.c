@@ -0,0 +1,192 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+#include "HAPPlatformServiceDiscovery+Test.h"
+
+#include "Harness/TemplateDB.c"
+
+HAP_RESULT_USE_CHECK
+static HAPError IdentifyAccessory(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPAccessoryIdentifyRequest* request HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    return kHAPError_None;
+}
+
+static const HAPAccessory accessory = { .aid = 1,
+                                        .category = kHAPAccessoryCategory_Other,
+                                        .name = "Acme Test",
+                                        .manufacturer = "Acme",
+                                        .model = "Test1,1",
+                                        .serialNumber = "099DB48E9E28",
+                                        .firmwareVersion = "1",
+                                        .hardwareVersion = "1",
+                                        .services = (const HAPService* const[]) { &accessoryInformationService,
+                                                                                  &hapProtocolInformationService,
+                                                                                  &pairingService,
+                                                                                  NULL },
+                                        .callbacks = { .identify = IdentifyAccessory } };
+
+static void HandleUpdatedAccessoryServerState(HAPAccessoryServerRef* server HAP_UNUSED, void* _Nullable context HAP_UNUSED) {
+}
+
+typedef struct {
+    const char* key;
+    const char* _Nullable value;
+} FindTXTRecordContext;
+
+static void FindTXTRecordCallback(
+        void* _Nullable context_,
+        HAPPlatformServiceDiscoveryRef serviceDiscovery HAP_UNUSED,
+        const char* key,
+        const void* valueBytes,
+        size_t numValueBytes HAP_UNUSED,
+        bool* shouldContinue) {
+    FindTXTRecordContext* context = context_;
+    HAPPrecondition(context);
+
+    if (HAPStringAreEqual(key, context->key)) {
+        context->value = valueBytes;
+        *shouldContinue = false;
+    }
+}
+
+/**
+ * Returns the value of the TXT record with the given key that is currently advertised.
+ */
+HAP_RESULT_USE_CHECK
+static const char* GetTXTRecordValue(const char* key) {
+    FindTXTRecordContext context = { .key = key };
+    HAPPlatformServiceDiscoveryEnumerateTXTRecords(
+            HAPNonnull(platform.ip.serviceDiscovery), FindTXTRecordCallback, &context);
+    HAPAssert(context.value);
+    return HAPNonnull(context.value);
+}
+
+/**
+ * Stops the accessory server and runs it until the shutdown has completed.
+ */
+static void StopAccessoryServer(HAPAccessoryServerRef* server_) {
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) server_;
+
+    HAPAccessoryServerStop(server_);
+    while (server->state != kHAPAccessoryServerState_Idle) {
+        HAPPlatformClockAdvance(0);
+    }
+}
+
+int main() {
+    HAPError err;
+    HAPPlatformCreate();
+
+    HAPPlatformServiceDiscoveryRef serviceDiscovery = HAPNonnull(platform.ip.serviceDiscovery);
+
+    // Prepare accessory server storage.
+    static HAPIPSession ipSessions[1];
+    static uint8_t ipInboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultInboundBufferSize];
+    static uint8_t ipOutboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultOutboundBufferSize];
+    static HAPIPEventNotificationRef ipEventNotifications[HAPArrayCount(ipSessions)][kAttributeCount];
+    for (size_t i = 0; i < HAPArrayCount(ipSessions); i++) {
+        ipSessions[i].inboundBuffer.bytes = ipInboundBuffers[i];
+        ipSessions[i].inboundBuffer.numBytes = sizeof ipInboundBuffers[i];
+        ipSessions[i].outboundBuffer.bytes = ipOutboundBuffers[i];
+        ipSessions[i].outboundBuffer.numBytes = sizeof ipOutboundBuffers[i];
+        ipSessions[i].eventNotifications = ipEventNotifications[i];
+        ipSessions[i].numEventNotifications = HAPArrayCount(ipEventNotifications[i]);
+    }
+    static HAPIPSessionSlotRef ipSessionSlots[HAPArrayCount(ipSessions)];
+    static HAPIPReadContextRef ipReadContexts[kAttributeCount];
+    static HAPIPWriteContextRef ipWriteContexts[kAttributeCount];
+    static uint8_t ipScratchBuffer[kHAPIPSession_DefaultScratchBufferSize];
+    static HAPIPAccessoryServerStorage ipAccessoryServerStorage = {
+        .sessions = ipSessions,
+        .numSessions = HAPArrayCount(ipSessions),
+        .sessionSlots = ipSessionSlots,
+        .readContexts = ipReadContexts,
+        .numReadContexts = HAPArrayCount(ipReadContexts),
+        .writeContexts = ipWriteContexts,
+        .numWriteContexts = HAPArrayCount(ipWriteContexts),
+        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer }
+    };
+
+    // Initialize accessory server.
+    static HAPAccessoryServerRef accessoryServer;
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ip = { .transport = &kHAPAccessoryServerTransport_IP,
+                            .accessoryServerStorage = &ipAccessoryServerStorage } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+
+    // Start accessory server. The _hap service is registered with its initial TXT records, without any update.
+    HAPAccessoryServerStart(&accessoryServer, &accessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+    HAPAssert(HAPPlatformServiceDiscoveryIsAdvertising(serviceDiscovery));
+    HAPAssert(HAPStringAreEqual(HAPPlatformServiceDiscoveryGetProtocol(serviceDiscovery), "_hap._tcp"));
+    HAPAssert(HAPPlatformServiceDiscoveryGetNumTXTRecordUpdates(serviceDiscovery) == 0);
+    HAPAssert(HAPStringAreEqual(GetTXTRecordValue("c#"), "1"));
+    HAPAssert(HAPStringAreEqual(GetTXTRecordValue("sf"), "1"));
+
+    // Refreshing the service with unchanged TXT records does not republish them.
+    HAPIPServiceDiscoverySetHAPService(&accessoryServer);
+    HAPIPServiceDiscoverySetHAPService(&accessoryServer);
+    HAPAssert(HAPPlatformServiceDiscoveryGetNumTXTRecordUpdates(serviceDiscovery) == 0);
+
+    // A configuration change updates the TXT records once.
+    err = HAPAccessoryServerIncrementCN(platform.keyValueStore);
+    HAPAssert(!err);
+    HAPIPServiceDiscoverySetHAPService(&accessoryServer);
+    HAPAssert(HAPPlatformServiceDiscoveryGetNumTXTRecordUpdates(serviceDiscovery) == 1);
+    HAPAssert(HAPStringAreEqual(GetTXTRecordValue("c#"), "2"));
+    HAPIPServiceDiscoverySetHAPService(&accessoryServer);
+    HAPAssert(HAPPlatformServiceDiscoveryGetNumTXTRecordUpdates(serviceDiscovery) == 1);
+
+    // A pairing state change updates the TXT records once.
+    {
+        uint8_t pairingBytes[sizeof(HAPPairingID) + sizeof(uint8_t) + sizeof(HAPPairingPublicKey) + sizeof(uint8_t)];
+        HAPRawBufferZero(pairingBytes, sizeof pairingBytes);
+        pairingBytes[sizeof(HAPPairingID)] = 1;
+        pairingBytes[sizeof pairingBytes - 1] = 0x01;
+        err = HAPPlatformKeyValueStoreSet(
+                platform.keyValueStore,
+                kHAPKeyValueStoreDomain_Pairings,
+                /* key: */ 0,
+                pairingBytes,
+                sizeof pairingBytes);
+        HAPAssert(!err);
+    }
+    HAPIPServiceDiscoverySetHAPService(&accessoryServer);
+    HAPAssert(HAPPlatformServiceDiscoveryGetNumTXTRecordUpdates(serviceDiscovery) == 2);
+    HAPAssert(HAPStringAreEqual(GetTXTRecordValue("sf"), "0"));
+    HAPIPServiceDiscoverySetHAPService(&accessoryServer);
+    HAPAssert(HAPPlatformServiceDiscoveryGetNumTXTRecordUpdates(serviceDiscovery) == 2);
+
+    // Stopping the accessory server withdraws the service.
+    StopAccessoryServer(&accessoryServer);
+    HAPAssert(!HAPPlatformServiceDiscoveryIsAdvertising(serviceDiscovery));
+
+    // Restarting the accessory server registers the service again, even though the TXT records did not change.
+    HAPAccessoryServerStart(&accessoryServer, &accessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+    HAPAssert(HAPPlatformServiceDiscoveryIsAdvertising(serviceDiscovery));
+    HAPAssert(HAPPlatformServiceDiscoveryGetNumTXTRecordUpdates(serviceDiscovery) == 0);
+    HAPAssert(HAPStringAreEqual(GetTXTRecordValue("c#"), "2"));
+    HAPAssert(HAPStringAreEqual(GetTXTRecordValue("sf"), "0"));
+    HAPIPServiceDiscoverySetHAPService(&accessoryServer);
+    HAPAssert(HAPPlatformServiceDiscoveryGetNumTXTRecordUpdates(serviceDiscovery) == 0);
+
+    StopAccessoryServer(&accessoryServer);
+    HAPAccessoryServerRelease(&accessoryServer);
+
+    return 0;
+}
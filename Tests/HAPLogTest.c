@@ -0,0 +1,112 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+static const HAPLogObject logObject = { .subsystem = "com.apple.mfi.HomeKit.Core.Test", .category = "LogTest" };
+
+/**
+ * Checks that formatting a deferred message yields the same result as formatting it directly.
+ */
+HAP_PRINTFLIKE(1, 2)
+static void TestDeferredMessage(const char* format, ...) {
+    HAPError err;
+
+    char expected[256];
+    va_list args;
+    va_start(args, format);
+    err = HAPStringWithFormatAndArguments(expected, sizeof expected, format, args);
+    va_end(args);
+    HAPAssert(!err);
+
+    HAPLogDeferredMessage message;
+    va_start(args, format);
+    err = HAPLogDeferredMessageCreate(&message, format, args);
+    va_end(args);
+    HAPAssert(!err);
+
+    char actual[256];
+    err = HAPLogDeferredMessageGetDescription(&message, actual, sizeof actual);
+    HAPAssert(!err);
+    HAPAssert(HAPStringAreEqual(actual, expected));
+
+    // Buffer that is exactly large enough.
+    size_t numBytes = HAPStringGetNumBytes(expected);
+    err = HAPLogDeferredMessageGetDescription(&message, actual, numBytes + 1);
+    HAPAssert(!err);
+    HAPAssert(HAPStringAreEqual(actual, expected));
+
+    // Buffer that is too small.
+    err = HAPLogDeferredMessageGetDescription(&message, actual, numBytes);
+    HAPAssert(err == kHAPError_OutOfResources);
+}
+
+/**
+ * Checks that creating a deferred message fails.
+ */
+HAP_PRINTFLIKE(1, 2)
+static void TestDeferredMessageTooLarge(const char* format, ...) {
+    HAPLogDeferredMessage message;
+    va_list args;
+    va_start(args, format);
+    HAPError err = HAPLogDeferredMessageCreate(&message, format, args);
+    va_end(args);
+    HAPAssert(err == kHAPError_OutOfResources);
+}
+
+int main() {
+    // Enabled types. The Mock PAL enables all log types.
+    HAPAssert(!HAPLogIsTypeEnabled(NULL, kHAPLogType_Fault));
+    for (int i = 0; i < 2; i++) {
+        HAPAssert(HAPLogIsTypeEnabled(&logObject, kHAPLogType_Debug));
+        HAPAssert(HAPLogIsTypeEnabled(&logObject, kHAPLogType_Info));
+        HAPAssert(HAPLogIsTypeEnabled(&logObject, kHAPLogType_Default));
+        HAPAssert(HAPLogIsTypeEnabled(&logObject, kHAPLogType_Error));
+        HAPAssert(HAPLogIsTypeEnabled(&logObject, kHAPLogType_Fault));
+        HAPAssert(HAPLogIsTypeEnabled(&kHAPLog_Default, kHAPLogType_Debug));
+    }
+    HAPLogInvalidateEnabledTypes();
+    HAPAssert(HAPLogIsTypeEnabled(&logObject, kHAPLogType_Debug));
+
+    // Log arguments are not evaluated when the log type is disabled at compile time.
+    int numEvaluations = 0;
+    HAPLogDebug(&logObject, "%d", numEvaluations++);
+    HAPAssert(numEvaluations == (HAP_LOG_LEVEL >= 3 ? 1 : 0));
+
+    // Deferred messages.
+    TestDeferredMessage("No arguments");
+    TestDeferredMessage("100%% literal");
+    TestDeferredMessage("%d %i %d", 0, -42, INT32_MAX);
+    TestDeferredMessage("%ld %lld %zd", (long) -1, (long long) INT64_MIN, (size_t) 7);
+    TestDeferredMessage("%u %lu %llu %zu", 1U, 2UL, (unsigned long long) UINT64_MAX, (size_t) 4);
+    TestDeferredMessage("%x %X %08x %lx %llX", 0xABCDU, 0xABCDU, 0x12U, 0xFFUL, 0xDEADBEEFCAFEULL);
+    TestDeferredMessage("%+d % d %5d %05u", 3, 4, -5, 6U);
+    TestDeferredMessage("%p %p", (void*) &logObject, (void*) NULL);
+    TestDeferredMessage("%s/%s/%s", "a", "", "string");
+    TestDeferredMessage("%c%c%c", 'H', 'A', 'P');
+    TestDeferredMessage("%g %g", 1.5, -0.25);
+    TestDeferredMessage(
+            "%s:%d:%s - %s @ %s:%d", "Message", 5, "Input/output error", "main", "Tests/HAPLogTest.c", __LINE__);
+    TestDeferredMessage("%d %d %d %d %d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12);
+
+    // Deferred messages that are too large.
+    TestDeferredMessageTooLarge("%d %d %d %d %d %d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13);
+    // Strings are stored including their NULL-terminator.
+    char longString[kHAPLogDeferredMessage_MaxStringBytes + 1];
+    for (size_t i = 0; i < sizeof longString - 1; i++) {
+        longString[i] = 'x';
+    }
+    longString[sizeof longString - 1] = '\0';
+    TestDeferredMessageTooLarge("%s", longString);
+    longString[sizeof longString - 2] = '\0';
+    TestDeferredMessage("%s", longString);
+
+    // Flushing deferred logs is always possible.
+    HAPLogFlushDeferred();
+
+    return 0;
+}
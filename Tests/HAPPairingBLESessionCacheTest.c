@@ -0,0 +1,178 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+static void HandleUpdatedAccessoryServerState(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+}
+
+/** Number of session cache elements. Well above the minimum. */
+#define kNumSessionCacheElements ((size_t) 64)
+
+/** Number of pairings that sessions are distributed across. */
+#define kNumPairings ((int) 5)
+
+/**
+ * Creates a session ID.
+ *
+ * @param[out] sessionID            Session ID.
+ * @param      hash                 Bytes that determine the hash table slot.
+ * @param      index                Bytes that make the session ID unique.
+ */
+static void MakeSessionID(HAPPairingBLESessionID* sessionID, uint32_t hash, uint32_t index) {
+    HAPWriteLittleUInt32(&sessionID->value[0], hash);
+    HAPWriteLittleUInt32(&sessionID->value[4], index);
+}
+
+static void MakeSharedSecret(uint8_t sharedSecret[X25519_SCALAR_BYTES], uint32_t index) {
+    HAPRawBufferZero(sharedSecret, X25519_SCALAR_BYTES);
+    HAPWriteLittleUInt32(sharedSecret, index);
+    sharedSecret[X25519_SCALAR_BYTES - 1] = 0xA5;
+}
+
+static void Save(HAPAccessoryServerRef* server, uint32_t hash, uint32_t index, int pairingID) {
+    HAPPairingBLESessionID sessionID;
+    MakeSessionID(&sessionID, hash, index);
+    uint8_t sharedSecret[X25519_SCALAR_BYTES];
+    MakeSharedSecret(sharedSecret, index);
+    HAPPairingBLESessionCacheSave(server, &sessionID, sharedSecret, pairingID);
+}
+
+/**
+ * Fetches a session and checks its contents.
+ *
+ * @return Pairing ID. -1, if the session was not found.
+ */
+HAP_RESULT_USE_CHECK
+static int Fetch(HAPAccessoryServerRef* server, uint32_t hash, uint32_t index) {
+    HAPPairingBLESessionID sessionID;
+    MakeSessionID(&sessionID, hash, index);
+    uint8_t sharedSecret[X25519_SCALAR_BYTES];
+    int pairingID;
+    HAPPairingBLESessionCacheFetch(server, &sessionID, sharedSecret, &pairingID);
+    if (pairingID >= 0) {
+        uint8_t expectedSharedSecret[X25519_SCALAR_BYTES];
+        MakeSharedSecret(expectedSharedSecret, index);
+        HAPAssert(HAPRawBufferAreEqual(sharedSecret, expectedSharedSecret, sizeof sharedSecret));
+    }
+    return pairingID;
+}
+
+int main() {
+    HAPPlatformCreate();
+
+    // Prepare accessory server storage.
+    static HAPBLEGATTTableElementRef gattTableElements[1];
+    static HAPBLESessionCacheElementRef sessionCacheElements[kNumSessionCacheElements];
+    static HAPSessionRef session;
+    static uint8_t procedureBytes[2048];
+    static HAPBLEProcedureRef procedures[1];
+    static HAPBLEAccessoryServerStorage bleAccessoryServerStorage = {
+        .gattTableElements = gattTableElements,
+        .numGATTTableElements = HAPArrayCount(gattTableElements),
+        .sessionCacheElements = sessionCacheElements,
+        .numSessionCacheElements = HAPArrayCount(sessionCacheElements),
+        .session = &session,
+        .procedures = procedures,
+        .numProcedures = HAPArrayCount(procedures),
+        .procedureBuffer = { .bytes = procedureBytes, .numBytes = sizeof procedureBytes },
+    };
+
+    // Initialize accessory server.
+    static HAPAccessoryServerRef accessoryServer;
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ble = { .transport = &kHAPAccessoryServerTransport_BLE,
+                             .accessoryServerStorage = &bleAccessoryServerStorage,
+                             .preferredAdvertisingInterval = kHAPBLEAdvertisingInterval_Minimum,
+                             .preferredNotificationDuration = kHAPBLENotification_MinDuration } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+    HAPAccessoryServerRef* server = &accessoryServer;
+
+    // Unknown sessions are not found.
+    HAPAssert(Fetch(server, 0, 0) == -1);
+
+    // Fill the cache. Half of the sessions share a hash table slot to exercise probing.
+    for (uint32_t i = 0; i < kNumSessionCacheElements; i++) {
+        Save(server, i % 2 ? 7 : i, i, (int) i % kNumPairings);
+    }
+
+    // Sessions are fetched once. Fetching out of insertion order removes entries from the middle of probe sequences.
+    for (uint32_t i = 0; i < kNumSessionCacheElements; i += 3) {
+        HAPAssert(Fetch(server, i % 2 ? 7 : i, i) == (int) i % kNumPairings);
+        HAPAssert(Fetch(server, i % 2 ? 7 : i, i) == -1);
+    }
+    for (uint32_t i = 0; i < kNumSessionCacheElements; i++) {
+        if (i % 3) {
+            HAPAssert(Fetch(server, i % 2 ? 7 : i, i) == (int) i % kNumPairings);
+        }
+    }
+    for (uint32_t i = 0; i < kNumSessionCacheElements; i++) {
+        HAPAssert(Fetch(server, i % 2 ? 7 : i, i) == -1);
+    }
+
+    // Fetched entries are reused without evicting other sessions.
+    for (uint32_t i = 0; i < kNumSessionCacheElements; i++) {
+        Save(server, i, 100 + i, 0);
+    }
+    for (uint32_t i = 0; i < kNumSessionCacheElements; i += 2) {
+        HAPAssert(Fetch(server, i, 100 + i) == 0);
+    }
+    for (uint32_t i = 0; i < kNumSessionCacheElements; i += 2) {
+        Save(server, i, 200 + i, 1);
+    }
+    for (uint32_t i = 0; i < kNumSessionCacheElements; i++) {
+        HAPAssert(Fetch(server, i, i % 2 ? 100 + i : 200 + i) == (i % 2 ? 0 : 1));
+    }
+
+    // The least recently saved sessions are evicted once the cache is full.
+    const uint32_t numEvicted = 10;
+    for (uint32_t i = 0; i < kNumSessionCacheElements + numEvicted; i++) {
+        Save(server, 3 * i, 300 + i, (int) i % kNumPairings);
+    }
+    for (uint32_t i = 0; i < kNumSessionCacheElements + numEvicted; i++) {
+        int expectedPairingID = i < numEvicted ? -1 : (int) i % kNumPairings;
+        HAPAssert(Fetch(server, 3 * i, 300 + i) == expectedPairingID);
+    }
+
+    // Saving a session ID again replaces the session.
+    Save(server, 5, 400, 1);
+    Save(server, 5, 400, 2);
+    HAPAssert(Fetch(server, 5, 400) == 2);
+    HAPAssert(Fetch(server, 5, 400) == -1);
+
+    // Invalidating a pairing only removes its sessions. Pairing IDs that share a bucket are kept.
+    int sharedBucketPairingID = 3 + (int) kNumSessionCacheElements;
+    for (uint32_t i = 0; i < kNumSessionCacheElements; i++) {
+        Save(server, i % 4 ? i : 11, 500 + i, i % 2 ? 3 : sharedBucketPairingID);
+    }
+    HAPPairingBLESessionCacheInvalidateEntriesForPairing(server, 3);
+    for (uint32_t i = 0; i < kNumSessionCacheElements; i++) {
+        HAPAssert(Fetch(server, i % 4 ? i : 11, 500 + i) == (i % 2 ? -1 : sharedBucketPairingID));
+    }
+
+    // After invalidation, the full capacity is available again.
+    for (uint32_t i = 0; i < kNumSessionCacheElements; i++) {
+        Save(server, i, 600 + i, 4);
+    }
+    HAPPairingBLESessionCacheInvalidateEntriesForPairing(server, 4);
+    for (uint32_t i = 0; i < kNumSessionCacheElements; i++) {
+        Save(server, i, 700 + i, 0);
+    }
+    for (uint32_t i = 0; i < kNumSessionCacheElements; i++) {
+        HAPAssert(Fetch(server, i, 600 + i) == -1);
+        HAPAssert(Fetch(server, i, 700 + i) == 0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+HAP_STATIC_ASSERT(HAP_TRACE, TracingEnabledForTests);
+
+/**
+ * Checks a serialized record.
+ */
+static void CheckRecord(
+        const uint8_t* recordBytes,
+        HAPTime timestamp,
+        uint32_t sequenceNumber,
+        HAPTraceEvent event,
+        HAPTracePhase phase,
+        uint32_t arg0,
+        uint32_t arg1) {
+    HAPAssert(HAPReadLittleUInt64(&recordBytes[0]) == timestamp);
+    HAPAssert(HAPReadLittleUInt32(&recordBytes[8]) == sequenceNumber);
+    HAPAssert(HAPReadLittleUInt16(&recordBytes[12]) == event);
+    HAPAssert(recordBytes[14] == phase);
+    HAPAssert(!recordBytes[15]);
+    HAPAssert(HAPReadLittleUInt32(&recordBytes[16]) == arg0);
+    HAPAssert(HAPReadLittleUInt32(&recordBytes[20]) == arg1);
+}
+
+static uint8_t bytes[kHAPTrace_MaxBytes];
+
+int main() {
+    HAPError err;
+    size_t numBytes;
+
+    HAPPlatformCreate();
+
+    // Empty trace.
+    HAPTraceReset();
+    err = HAPTraceSerialize(bytes, sizeof bytes, &numBytes);
+    HAPAssert(!err);
+    HAPAssert(numBytes == kHAPTrace_NumHeaderBytes);
+    HAPAssert(HAPRawBufferAreEqual(bytes, "HAPTRACE", 8));
+    HAPAssert(HAPReadLittleUInt32(&bytes[8]) == kHAPTrace_Version);
+    HAPAssert(HAPReadLittleUInt32(&bytes[12]) == 0);
+
+    // Record a few events.
+    HAPTime startTime = HAPPlatformClockGetCurrent();
+    HAPTraceBegin(kHAPTraceEvent_HTTPRequest, 1, 2);
+    HAPPlatformClockAdvance(5 * HAPMillisecond);
+    HAPTraceInstant(kHAPTraceEvent_Encrypt, 3, 0);
+    HAPTraceEnd(kHAPTraceEvent_HTTPRequest, 0xFFFFFFFF, 4);
+
+    err = HAPTraceSerialize(bytes, sizeof bytes, &numBytes);
+    HAPAssert(!err);
+    HAPAssert(numBytes == kHAPTrace_NumHeaderBytes + 3 * kHAPTrace_NumRecordBytes);
+    HAPAssert(HAPReadLittleUInt32(&bytes[12]) == 3);
+    CheckRecord(
+            &bytes[kHAPTrace_NumHeaderBytes + 0 * kHAPTrace_NumRecordBytes],
+            startTime,
+            0,
+            kHAPTraceEvent_HTTPRequest,
+            kHAPTracePhase_Begin,
+            1,
+            2);
+    CheckRecord(
+            &bytes[kHAPTrace_NumHeaderBytes + 1 * kHAPTrace_NumRecordBytes],
+            startTime + 5 * HAPMillisecond,
+            1,
+            kHAPTraceEvent_Encrypt,
+            kHAPTracePhase_Instant,
+            3,
+            0);
+    CheckRecord(
+            &bytes[kHAPTrace_NumHeaderBytes + 2 * kHAPTrace_NumRecordBytes],
+            startTime + 5 * HAPMillisecond,
+            2,
+            kHAPTraceEvent_HTTPRequest,
+            kHAPTracePhase_End,
+            0xFFFFFFFF,
+            4);
+
+    // Buffer too small.
+    err = HAPTraceSerialize(bytes, kHAPTrace_NumHeaderBytes + 3 * kHAPTrace_NumRecordBytes - 1, &numBytes);
+    HAPAssert(err == kHAPError_OutOfResources);
+
+    // Wrap around. Only the most recent records are kept, oldest first.
+    HAPTraceReset();
+    uint32_t numRecords = HAP_TRACE_NUM_RECORDS + HAP_TRACE_NUM_RECORDS / 2 + 1;
+    for (uint32_t i = 0; i < numRecords; i++) {
+        HAPTraceInstant(kHAPTraceEvent_KeyValueStoreGet, i, ~i);
+    }
+    err = HAPTraceSerialize(bytes, sizeof bytes, &numBytes);
+    HAPAssert(!err);
+    HAPAssert(numBytes == kHAPTrace_MaxBytes);
+    HAPAssert(HAPReadLittleUInt32(&bytes[12]) == HAP_TRACE_NUM_RECORDS);
+    for (uint32_t i = 0; i < HAP_TRACE_NUM_RECORDS; i++) {
+        uint32_t sequenceNumber = numRecords - HAP_TRACE_NUM_RECORDS + i;
+        CheckRecord(
+                &bytes[kHAPTrace_NumHeaderBytes + i * kHAPTrace_NumRecordBytes],
+                startTime + 5 * HAPMillisecond,
+                sequenceNumber,
+                kHAPTraceEvent_KeyValueStoreGet,
+                kHAPTracePhase_Instant,
+                sequenceNumber,
+                ~sequenceNumber);
+    }
+
+    // Event names.
+    for (HAPTraceEvent event = kHAPTraceEvent_RunLoopTimer; event <= kHAPTraceEvent_KeyValueStorePurgeDomain;
+         event++) {
+        HAPAssert(HAPTraceEventGetName(event));
+    }
+    HAPAssert(!HAPTraceEventGetName(0));
+
+    // Reset.
+    HAPTraceReset();
+    err = HAPTraceSerialize(bytes, sizeof bytes, &numBytes);
+    HAPAssert(!err);
+    HAPAssert(numBytes == kHAPTrace_NumHeaderBytes);
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAPBLETestAccessory.h"
+
+void HAPBLETestAccessoryHandleUpdatedState(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPBLETestAccessoryIdentify(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPAccessoryIdentifyRequest* request HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    HAPFatalError();
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleOnRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPBoolCharacteristicReadRequest* request HAP_UNUSED,
+        bool* value,
+        void* _Nullable context HAP_UNUSED) {
+    *value = false;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleOnWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPBoolCharacteristicWriteRequest* request HAP_UNUSED,
+        bool value HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    HAPFatalError();
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleBrightnessRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPIntCharacteristicReadRequest* request HAP_UNUSED,
+        int32_t* value,
+        void* _Nullable context HAP_UNUSED) {
+    *value = 0;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleBrightnessWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPIntCharacteristicWriteRequest* request HAP_UNUSED,
+        int32_t value HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    HAPFatalError();
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleHueRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPFloatCharacteristicReadRequest* request HAP_UNUSED,
+        float* value,
+        void* _Nullable context HAP_UNUSED) {
+    *value = 0;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleHueWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPFloatCharacteristicWriteRequest* request HAP_UNUSED,
+        float value HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    HAPFatalError();
+}
+
+const HAPBoolCharacteristic lightBulbOnCharacteristic = {
+    .format = kHAPCharacteristicFormat_Bool,
+    .iid = 0x31,
+    .characteristicType = &kHAPCharacteristicType_On,
+    .debugDescription = kHAPCharacteristicDebugDescription_On,
+    .manufacturerDescription = "Power",
+    .properties = { .readable = true,
+                    .writable = true,
+                    .supportsEventNotification = true,
+                    .ble = { .supportsBroadcastNotification = true, .supportsDisconnectedNotification = true } },
+    .callbacks = { .handleRead = HandleOnRead, .handleWrite = HandleOnWrite }
+};
+
+const HAPIntCharacteristic lightBulbBrightnessCharacteristic = {
+    .format = kHAPCharacteristicFormat_Int,
+    .iid = 0x32,
+    .characteristicType = &kHAPCharacteristicType_Brightness,
+    .debugDescription = kHAPCharacteristicDebugDescription_Brightness,
+    .properties = { .readable = true,
+                    .writable = true,
+                    .supportsEventNotification = true,
+                    .ble = { .supportsBroadcastNotification = true, .supportsDisconnectedNotification = true } },
+    .units = kHAPCharacteristicUnits_Percentage,
+    .constraints = { .minimumValue = 0, .maximumValue = 100, .stepValue = 1 },
+    .callbacks = { .handleRead = HandleBrightnessRead, .handleWrite = HandleBrightnessWrite }
+};
+
+const HAPFloatCharacteristic lightBulbHueCharacteristic = {
+    .format = kHAPCharacteristicFormat_Float,
+    .iid = 0x33,
+    .characteristicType = &kHAPCharacteristicType_Hue,
+    .debugDescription = kHAPCharacteristicDebugDescription_Hue,
+    .properties = { .readable = true,
+                    .writable = true,
+                    .supportsEventNotification = true,
+                    .ble = { .supportsBroadcastNotification = true, .supportsDisconnectedNotification = true } },
+    .units = kHAPCharacteristicUnits_ArcDegrees,
+    .constraints = { .minimumValue = 0, .maximumValue = 360, .stepValue = 1 },
+    .callbacks = { .handleRead = HandleHueRead, .handleWrite = HandleHueWrite }
+};
+
+const HAPService lightBulbService = {
+    .iid = 0x30,
+    .serviceType = &kHAPServiceType_LightBulb,
+    .debugDescription = kHAPServiceDebugDescription_LightBulb,
+    .properties = { .primaryService = true },
+    .characteristics = (const HAPCharacteristic* const[]) { &lightBulbOnCharacteristic,
+                                                            &lightBulbBrightnessCharacteristic,
+                                                            &lightBulbHueCharacteristic,
+                                                            NULL }
+};
+
+const HAPAccessory bleTestAccessory = { .aid = 1,
+                                        .category = kHAPAccessoryCategory_Lighting,
+                                        .name = "Acme Test",
+                                        .manufacturer = "Acme",
+                                        .model = "Test1,1",
+                                        .serialNumber = "099DB48E9E28",
+                                        .firmwareVersion = "1",
+                                        .hardwareVersion = "1",
+                                        .services = (const HAPService* const[]) { &accessoryInformationService,
+                                                                                  &hapProtocolInformationService,
+                                                                                  &pairingService,
+                                                                                  &lightBulbService,
+                                                                                  NULL },
+                                        .callbacks = { .identify = HAPBLETestAccessoryIdentify } };
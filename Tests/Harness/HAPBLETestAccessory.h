@@ -0,0 +1,79 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#ifndef HAP_BLE_TEST_ACCESSORY_H
+#define HAP_BLE_TEST_ACCESSORY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "HAP+Internal.h"
+
+#include "TemplateDB.h"
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull begin
+#endif
+
+/**
+ * Number of services and characteristics of the BLE test accessory.
+ */
+#define kHAPBLETestAccessory_NumAttributes (kAttributeCount + 4)
+
+/**
+ * Light Bulb service of the BLE test accessory.
+ *
+ * - All characteristics are readable and writable, support event notifications, broadcast notifications and
+ *   disconnected notifications, and read as 0. Writes are not expected.
+ * - The On characteristic has a manufacturer description.
+ */
+extern const HAPService lightBulbService;
+
+/**
+ * Characteristics of the Light Bulb service.
+ */
+extern const HAPBoolCharacteristic lightBulbOnCharacteristic;
+extern const HAPIntCharacteristic lightBulbBrightnessCharacteristic;
+extern const HAPFloatCharacteristic lightBulbHueCharacteristic;
+
+/**
+ * BLE test accessory: The template services and the Light Bulb service.
+ */
+extern const HAPAccessory bleTestAccessory;
+
+/**
+ * Accessory server state callback that ignores all state changes.
+ *
+ * @param      server               Accessory server.
+ * @param      context              Context.
+ */
+void HAPBLETestAccessoryHandleUpdatedState(HAPAccessoryServerRef* server, void* _Nullable context);
+
+/**
+ * Identify routine of the BLE test accessory. Identify requests are not expected.
+ *
+ * @param      server               Accessory server.
+ * @param      request              Request.
+ * @param      context              Context.
+ *
+ * @return Does not return.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPBLETestAccessoryIdentify(
+        HAPAccessoryServerRef* server,
+        const HAPAccessoryIdentifyRequest* request,
+        void* _Nullable context);
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull end
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
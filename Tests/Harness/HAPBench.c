@@ -0,0 +1,65 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "HAPBench.h"
+
+uint64_t HAPBenchGetNanoseconds(void) {
+    struct timespec t;
+    int e = clock_gettime(CLOCK_MONOTONIC, &t);
+    HAPBenchExpect(!e, "clock_gettime failed.");
+    return (uint64_t) t.tv_sec * 1000000000 + (uint64_t) t.tv_nsec;
+}
+
+void HAPBenchExpect(bool condition, const char* description) {
+    if (!condition) {
+        fprintf(stderr, "Benchmark failed: %s\n", description);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void HAPBenchRun(
+        const char* benchmark,
+        const char* _Nullable backend,
+        const char* name,
+        size_t numBytes,
+        HAPBenchFunction function,
+        void* _Nullable context) {
+    // Warm up caches and lazily initialized state.
+    function(context);
+
+    uint64_t numIterations = 1;
+    uint64_t duration;
+    for (;;) {
+        uint64_t startTime = HAPBenchGetNanoseconds();
+        for (uint64_t i = 0; i < numIterations; i++) {
+            function(context);
+        }
+        duration = HAPBenchGetNanoseconds() - startTime;
+        if (duration >= kHAPBench_MinDuration) {
+            break;
+        }
+        numIterations *= 2;
+    }
+
+    double nsPerOp = (double) duration / (double) numIterations;
+    printf("{\"benchmark\":\"%s\",", benchmark);
+    if (backend) {
+        printf("\"backend\":\"%s\",", backend);
+    }
+    printf("\"name\":\"%s\",\"iterations\":%llu,\"nsPerOp\":%.1f",
+           name,
+           (unsigned long long) numIterations,
+           nsPerOp);
+    if (numBytes) {
+        printf(",\"bytesPerOp\":%lu,\"mbPerSecond\":%.1f", (unsigned long) numBytes, (double) numBytes * 1e3 / nsPerOp);
+    }
+    printf("}\n");
+    fflush(stdout);
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#ifndef HAP_BENCH_H
+#define HAP_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "HAP+Internal.h"
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull begin
+#endif
+
+/**
+ * Minimum duration of a measurement, in nanoseconds.
+ */
+#define kHAPBench_MinDuration ((uint64_t) 100 * 1000 * 1000)
+
+/**
+ * Runs one iteration of a benchmark.
+ *
+ * @param      context              Context.
+ */
+typedef void (*HAPBenchFunction)(void* _Nullable context);
+
+/**
+ * Gets the current time of a monotonic clock.
+ *
+ * @return Current time in nanoseconds.
+ */
+HAP_RESULT_USE_CHECK
+uint64_t HAPBenchGetNanoseconds(void);
+
+/**
+ * Measures a benchmark and prints the result as a single line JSON object.
+ *
+ * - The number of iterations is doubled until the measurement takes at least kHAPBench_MinDuration.
+ *
+ * @param      benchmark            Name of the benchmark suite.
+ * @param      backend              Name of the backend under test. NULL if not applicable.
+ * @param      name                 Name of the measured operation.
+ * @param      numBytes             Number of bytes processed per iteration. 0 if not applicable.
+ * @param      function             Function to measure.
+ * @param      context              Context that is passed to the function.
+ */
+void HAPBenchRun(
+        const char* benchmark,
+        const char* _Nullable backend,
+        const char* name,
+        size_t numBytes,
+        HAPBenchFunction function,
+        void* _Nullable context);
+
+/**
+ * Aborts the benchmark if a condition does not hold.
+ *
+ * - HAPAssert is compiled out in Release builds, in which benchmarks are built.
+ *
+ * @param      condition            Condition.
+ * @param      description          Description that is printed if the condition does not hold.
+ */
+void HAPBenchExpect(bool condition, const char* description);
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull end
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,177 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAPPlatformTCPStreamManager+Test.h"
+
+#include "HAPIPTestSession.h"
+
+/**
+ * Accessory server that is used for controller side encryption.
+ *
+ * - Has no metrics storage so that controller traffic is not recorded in the metrics of the accessory server.
+ */
+static HAPAccessoryServerRef controllerServer;
+
+void HAPIPTestSessionAddPairing(HAPAccessoryServerRef* server_, HAPPlatformKeyValueStoreKey key, bool isAdmin) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    HAPError err;
+
+    uint8_t pairingBytes[sizeof(HAPPairingID) + sizeof(uint8_t) + sizeof(HAPPairingPublicKey) + sizeof(uint8_t)];
+    HAPRawBufferZero(pairingBytes, sizeof pairingBytes);
+    pairingBytes[sizeof(HAPPairingID)] = 1;
+    pairingBytes[sizeof pairingBytes - 1] = isAdmin ? 0x01 : 0x00;
+    err = HAPPlatformKeyValueStoreSet(
+            server->platform.keyValueStore, kHAPKeyValueStoreDomain_Pairings, key, pairingBytes, sizeof pairingBytes);
+    HAPAssert(!err);
+}
+
+void HAPIPTestSessionOpen(HAPIPTestSession* session, HAPAccessoryServerRef* server_, int pairingID) {
+    HAPPrecondition(session);
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(server->ip.storage);
+
+    HAPError err;
+
+    HAPRawBufferZero(session, sizeof *session);
+    session->server = server_;
+    err = HAPPlatformTCPStreamManagerConnectToListener(
+            HAPNonnull(server->platform.ip.tcpStreamManager), &session->tcpStream);
+    HAPAssert(!err);
+    HAPPlatformClockAdvance(0);
+
+    // Find the accessory side of the connection.
+    HAPIPSessionDescriptor* descriptor = NULL;
+    size_t sessionIndex = 0;
+    for (size_t i = 0; !descriptor && i < server->ip.numSessionChunks; i++) {
+        for (size_t j = 0; !descriptor && j < HAPNonnull(server->ip.storage)->numSessions; j++) {
+            HAPIPSessionDescriptor* t =
+                    (HAPIPSessionDescriptor*) &HAPNonnull(server->ip.sessionChunks[i].sessions)[j].descriptor;
+            if (t->tcpStreamIsOpen && t->tcpStream == session->tcpStream) {
+                descriptor = t;
+            } else {
+                sessionIndex++;
+            }
+        }
+    }
+    HAPAssert(descriptor);
+    HAPAssert(descriptor->securitySession.isOpen);
+
+    // Derive distinct keys for each IP session.
+    HAPSession* accessorySession = (HAPSession*) &descriptor->securitySession._.hap;
+    HAPSession* controllerSession = (HAPSession*) &session->session;
+    accessorySession->hap.active = true;
+    accessorySession->hap.pairingID = pairingID;
+    controllerSession->hap.active = true;
+    for (size_t i = 0; i < sizeof(HAPSessionKey); i++) {
+        accessorySession->hap.controllerToAccessory.controlChannel.key.bytes[i] = (uint8_t)(sessionIndex + i);
+        accessorySession->hap.accessoryToController.controlChannel.key.bytes[i] = (uint8_t)(0x80 + sessionIndex + i);
+        // The controller encrypts with the keys of the opposite direction.
+        controllerSession->hap.accessoryToController.controlChannel.key.bytes[i] = (uint8_t)(sessionIndex + i);
+        controllerSession->hap.controllerToAccessory.controlChannel.key.bytes[i] = (uint8_t)(0x80 + sessionIndex + i);
+    }
+}
+
+void HAPIPTestSessionClose(HAPIPTestSession* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) HAPNonnull(session->server);
+
+    HAPPlatformTCPStreamManagerClientClose(HAPNonnull(server->platform.ip.tcpStreamManager), session->tcpStream);
+    HAPPlatformClockAdvance(0);
+}
+
+void HAPIPTestSessionSendRequest(HAPIPTestSession* session, const char* request) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) HAPNonnull(session->server);
+    HAPPrecondition(request);
+
+    HAPError err;
+
+    static uint8_t bytes[4096];
+    size_t numRequestBytes = HAPStringGetNumBytes(request);
+    HAPAssert(HAPIPSecurityProtocolGetNumEncryptedBytes(numRequestBytes) <= sizeof bytes);
+    HAPRawBufferCopyBytes(bytes, request, numRequestBytes);
+    session->numRequestBytes += numRequestBytes;
+    HAPIPByteBuffer buffer = { .data = (char*) bytes, .capacity = sizeof bytes, .limit = numRequestBytes };
+    HAPIPSecurityProtocolEncryptData(&controllerServer, &session->session, &buffer);
+
+    size_t numBytesWritten;
+    err = HAPPlatformTCPStreamClientWrite(
+            HAPNonnull(server->platform.ip.tcpStreamManager),
+            session->tcpStream,
+            bytes,
+            buffer.limit,
+            &numBytesWritten);
+    HAPAssert(!err);
+    HAPAssert(numBytesWritten == buffer.limit);
+}
+
+void HAPIPTestSessionSendWriteRequest(HAPIPTestSession* session, const char* body) {
+    HAPPrecondition(session);
+    HAPPrecondition(body);
+
+    HAPError err;
+
+    static char request[1024];
+    err = HAPStringWithFormat(
+            request,
+            sizeof request,
+            "PUT /characteristics HTTP/1.1\r\n"
+            "Content-Type: application/hap+json\r\n"
+            "Content-Length: %lu\r\n\r\n"
+            "%s",
+            (unsigned long) HAPStringGetNumBytes(body),
+            body);
+    HAPAssert(!err);
+    HAPIPTestSessionSendRequest(session, request);
+}
+
+void HAPIPTestSessionReceiveResponse(HAPIPTestSession* session, char* response, size_t maxResponseBytes) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) HAPNonnull(session->server);
+    HAPPrecondition(response);
+    HAPPrecondition(maxResponseBytes);
+
+    HAPError err;
+
+    HAPPlatformClockAdvance(0);
+    static uint8_t bytes[4096];
+    size_t numBytes;
+    err = HAPPlatformTCPStreamClientRead(
+            HAPNonnull(server->platform.ip.tcpStreamManager), session->tcpStream, bytes, sizeof bytes, &numBytes);
+    if (err == kHAPError_Busy) {
+        response[0] = '\0';
+        return;
+    }
+    HAPAssert(!err);
+    HAPIPByteBuffer buffer = { .data = (char*) bytes, .capacity = sizeof bytes, .limit = numBytes };
+    err = HAPIPSecurityProtocolDecryptData(&controllerServer, &session->session, &buffer);
+    HAPAssert(!err);
+    HAPAssert(buffer.position == buffer.limit);
+    HAPAssert(buffer.position < maxResponseBytes);
+    HAPRawBufferCopyBytes(response, bytes, buffer.position);
+    response[buffer.position] = '\0';
+    session->numResponseBytes += buffer.position;
+}
+
+bool HAPIPTestStringContains(const char* string, const char* substring) {
+    HAPPrecondition(string);
+    HAPPrecondition(substring);
+
+    size_t numStringBytes = HAPStringGetNumBytes(string);
+    size_t numSubstringBytes = HAPStringGetNumBytes(substring);
+    for (size_t i = 0; i + numSubstringBytes <= numStringBytes; i++) {
+        if (HAPRawBufferAreEqual(&string[i], substring, numSubstringBytes)) {
+            return true;
+        }
+    }
+    return false;
+}
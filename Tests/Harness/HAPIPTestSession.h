@@ -0,0 +1,116 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#ifndef HAP_IP_TEST_SESSION_H
+#define HAP_IP_TEST_SESSION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "HAP+Internal.h"
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull begin
+#endif
+
+/**
+ * Controller that is connected to an IP accessory server over a secured session.
+ *
+ * - The security session is established as if Pair Verify had completed, using fixed session keys.
+ */
+typedef struct {
+    /** Accessory server. */
+    HAPAccessoryServerRef* _Nullable server;
+
+    /** TCP stream to the accessory server. */
+    HAPPlatformTCPStreamRef tcpStream;
+
+    /** Controller side of the security session. */
+    HAPSessionRef session;
+
+    /** Number of plaintext bytes that have been sent. */
+    size_t numRequestBytes;
+
+    /** Number of plaintext bytes that have been received. */
+    size_t numResponseBytes;
+} HAPIPTestSession;
+
+/**
+ * Registers a paired controller in the key-value store of an accessory server.
+ *
+ * - The pairing ID of the paired controller is a single byte with value 0.
+ *
+ * @param      server               Accessory server.
+ * @param      key                  Key-value store key of the pairing.
+ * @param      isAdmin              Whether the paired controller has admin permissions.
+ */
+void HAPIPTestSessionAddPairing(HAPAccessoryServerRef* server, HAPPlatformKeyValueStoreKey key, bool isAdmin);
+
+/**
+ * Connects to an accessory server and establishes a security session.
+ *
+ * @param[out] session              Controller.
+ * @param      server               Accessory server. Must be running and have a free IP session.
+ * @param      pairingID            Key-value store key of the pairing that is used for the security session.
+ */
+void HAPIPTestSessionOpen(HAPIPTestSession* session, HAPAccessoryServerRef* server, int pairingID);
+
+/**
+ * Closes the connection to the accessory server.
+ *
+ * @param      session              Controller.
+ */
+void HAPIPTestSessionClose(HAPIPTestSession* session);
+
+/**
+ * Sends an encrypted request to the accessory server.
+ *
+ * @param      session              Controller.
+ * @param      request              NULL-terminated request.
+ */
+void HAPIPTestSessionSendRequest(HAPIPTestSession* session, const char* request);
+
+/**
+ * Sends a PUT /characteristics request with the given body.
+ *
+ * @param      session              Controller.
+ * @param      body                 NULL-terminated JSON body.
+ */
+void HAPIPTestSessionSendWriteRequest(HAPIPTestSession* session, const char* body);
+
+/**
+ * Runs the accessory server, then receives and decrypts all pending data from it.
+ *
+ * - If no data is pending, an empty response is returned.
+ *
+ * @param      session              Controller.
+ * @param[out] response             NULL-terminated response.
+ * @param      maxResponseBytes     Capacity of the response buffer.
+ */
+void HAPIPTestSessionReceiveResponse(HAPIPTestSession* session, char* response, size_t maxResponseBytes);
+
+/**
+ * Returns whether a string contains a substring.
+ *
+ * @param      string               String.
+ * @param      substring            Substring to search for.
+ *
+ * @return true                     If the string contains the substring.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+bool HAPIPTestStringContains(const char* string, const char* substring);
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull end
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,602 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+// Drives the BLE peripheral manager for POSIX through its Unix domain socket.
+// The central side of the link is served by the same run loop, so the test is single-threaded.
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "HAPPlatform+Init.h"
+#include "HAPPlatformBLEPeripheralManager+Init.h"
+#include "HAPPlatformFileHandle.h"
+#include "HAPPlatformKeyValueStore+Init.h"
+#include "HAPPlatformRunLoop+Init.h"
+
+/** Path of the socket of the BLE peripheral manager. */
+#define kSocketPath ".HAPPlatformBLEPeripheralManagerTest.socket"
+
+/** Maximum time to wait for the BLE peripheral manager. */
+#define kTimeout ((HAPTime)(5 * HAPSecond))
+
+/** Length of the value of the test characteristic. Longer than a single Read response. */
+#define kNumValueBytes ((size_t) 300)
+
+/**
+ * Central side of the link.
+ */
+typedef struct {
+    int fileDescriptor;
+    HAPPlatformFileHandleRef fileHandle;
+
+    uint8_t bytes[kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes +
+                  kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes];
+    size_t numBytes;
+
+    /** Whether a complete frame has been received. */
+    bool hasFrame : 1;
+
+    /** Whether the BLE peripheral manager has closed the socket. */
+    bool isClosed : 1;
+} Central;
+
+/**
+ * Frame that has been received from the BLE peripheral manager.
+ */
+typedef struct {
+    uint8_t opcode;
+    uint8_t bytes[kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes];
+    size_t numBytes;
+} Frame;
+
+static struct {
+    HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle;
+    size_t numConnects;
+    size_t numDisconnects;
+
+    uint8_t value[kNumValueBytes];
+    size_t numReads;
+    size_t numWrites;
+} test;
+
+static const HAPPlatformBLEPeripheralManagerUUID serviceType = {
+    { 0x91, 0x52, 0x76, 0xBB, 0x26, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00, 0x3E, 0x00, 0x00, 0x00 }
+};
+
+static const HAPPlatformBLEPeripheralManagerUUID characteristicType = {
+    { 0x91, 0x52, 0x76, 0xBB, 0x26, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00, 0x23, 0x00, 0x00, 0x00 }
+};
+
+static const HAPPlatformBLEPeripheralManagerUUID descriptorType = {
+    { 0xD2, 0x96, 0x0F, 0x8A, 0xC5, 0x69, 0x47, 0x66, 0x9A, 0x8F, 0xEA, 0x44, 0x4C, 0x1A, 0x0D, 0xDC }
+};
+
+static void HandleConnectedCentral(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager HAP_UNUSED,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        void* _Nullable context HAP_UNUSED) {
+    test.connectionHandle = connectionHandle;
+    test.numConnects++;
+}
+
+static void HandleDisconnectedCentral(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager HAP_UNUSED,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        void* _Nullable context HAP_UNUSED) {
+    HAPAssert(connectionHandle == test.connectionHandle);
+    test.numDisconnects++;
+    HAPPlatformRunLoopStop();
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleReadRequest(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager HAP_UNUSED,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle HAP_UNUSED,
+        void* bytes,
+        size_t maxBytes,
+        size_t* numBytes,
+        void* _Nullable context HAP_UNUSED) {
+    HAPAssert(connectionHandle == test.connectionHandle);
+    HAPAssert(maxBytes >= sizeof test.value);
+    HAPRawBufferCopyBytes(bytes, test.value, sizeof test.value);
+    *numBytes = sizeof test.value;
+    test.numReads++;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleWriteRequest(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager HAP_UNUSED,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle HAP_UNUSED,
+        void* bytes,
+        size_t numBytes,
+        void* _Nullable context HAP_UNUSED) {
+    HAPAssert(connectionHandle == test.connectionHandle);
+    HAPAssert(numBytes <= sizeof test.value);
+    HAPRawBufferCopyBytes(test.value, bytes, numBytes);
+    test.numWrites++;
+    return kHAPError_None;
+}
+
+static void HandleTimeout(HAPPlatformTimerRef timer HAP_UNUSED, void* _Nullable context HAP_UNUSED) {
+    HAPLogError(&kHAPLog_Default, "Timed out waiting for the BLE peripheral manager.");
+    HAPFatalError();
+}
+
+static void HandleCentralFileHandleCallback(
+        HAPPlatformFileHandleRef fileHandle,
+        HAPPlatformFileHandleEvent fileHandleEvents,
+        void* _Nullable context) {
+    HAPPrecondition(context);
+    Central* central = context;
+    HAPPrecondition(fileHandle == central->fileHandle);
+
+    if (!fileHandleEvents.isReadyForReading) {
+        return;
+    }
+    HAPAssert(central->numBytes < sizeof central->bytes);
+    ssize_t n;
+    do {
+        n = recv(
+                central->fileDescriptor,
+                &central->bytes[central->numBytes],
+                sizeof central->bytes - central->numBytes,
+                0);
+    } while (n == -1 && errno == EINTR);
+    HAPAssert(n >= 0);
+    if (!n) {
+        HAPPlatformFileHandleDeregister(central->fileHandle);
+        central->fileHandle = 0;
+        central->isClosed = true;
+        HAPPlatformRunLoopStop();
+        return;
+    }
+    central->numBytes += (size_t) n;
+
+    if (central->numBytes >= kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes &&
+        central->numBytes >= kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes +
+                                     HAPReadLittleUInt16(&central->bytes[1])) {
+        central->hasFrame = true;
+        HAPPlatformRunLoopStop();
+    }
+}
+
+/**
+ * Runs the run loop until the condition is met.
+ */
+#define RUN_UNTIL(condition) \
+    do { \
+        HAPError err_; \
+        HAPPlatformTimerRef timer_; \
+        err_ = HAPPlatformTimerRegister(&timer_, HAPPlatformClockGetCurrent() + kTimeout, HandleTimeout, NULL); \
+        HAPAssert(!err_); \
+        while (!(condition)) { \
+            HAPPlatformRunLoopRun(); \
+        } \
+        HAPPlatformTimerDeregister(timer_); \
+    } while (0)
+
+static void HandleRunOnceTimerExpired(HAPPlatformTimerRef timer HAP_UNUSED, void* _Nullable context HAP_UNUSED) {
+    HAPPlatformRunLoopStop();
+}
+
+/**
+ * Runs a single iteration of the run loop. File handles that are ready are processed.
+ */
+static void RunOnce(void) {
+    HAPError err;
+
+    HAPPlatformTimerRef timer;
+    err = HAPPlatformTimerRegister(&timer, /* deadline: */ 0, HandleRunOnceTimerExpired, NULL);
+    HAPAssert(!err);
+    HAPPlatformRunLoopRun();
+}
+
+static void CentralOpen(Central* central) {
+    HAPPrecondition(central);
+
+    HAPError err;
+
+    HAPRawBufferZero(central, sizeof *central);
+    central->fileDescriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+    HAPAssert(central->fileDescriptor != -1);
+    struct sockaddr_un sun;
+    HAPRawBufferZero(&sun, sizeof sun);
+    sun.sun_family = AF_UNIX;
+    HAPRawBufferCopyBytes(sun.sun_path, kSocketPath, sizeof kSocketPath);
+    int e = connect(central->fileDescriptor, (struct sockaddr*) &sun, sizeof sun);
+    HAPAssert(!e);
+
+    err = HAPPlatformFileHandleRegister(
+            &central->fileHandle,
+            central->fileDescriptor,
+            (HAPPlatformFileHandleEvent) {
+                    .isReadyForReading = true, .isReadyForWriting = false, .hasErrorConditionPending = false },
+            HandleCentralFileHandleCallback,
+            central);
+    HAPAssert(!err);
+}
+
+static void CentralClose(Central* central) {
+    HAPPrecondition(central);
+
+    if (central->fileHandle) {
+        HAPPlatformFileHandleDeregister(central->fileHandle);
+        central->fileHandle = 0;
+    }
+    int e = close(central->fileDescriptor);
+    HAPAssert(!e);
+    central->fileDescriptor = -1;
+}
+
+static void CentralSendBytes(Central* central, const void* bytes, size_t numBytes) {
+    HAPPrecondition(central);
+    HAPPrecondition(bytes);
+
+    ssize_t n;
+    do {
+        n = send(central->fileDescriptor, bytes, numBytes, 0);
+    } while (n == -1 && errno == EINTR);
+    HAPAssert(n >= 0 && (size_t) n == numBytes);
+}
+
+static void CentralSendFrame(Central* central, uint8_t opcode, const void* _Nullable bytes, size_t numBytes) {
+    HAPPrecondition(central);
+    HAPPrecondition(!numBytes || bytes);
+    HAPPrecondition(numBytes <= kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes);
+
+    uint8_t frameBytes[kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes +
+                       kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes];
+    frameBytes[0] = opcode;
+    HAPWriteLittleUInt16(&frameBytes[1], numBytes);
+    if (numBytes) {
+        HAPRawBufferCopyBytes(
+                &frameBytes[kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes], HAPNonnullVoid(bytes), numBytes);
+    }
+    CentralSendBytes(central, frameBytes, kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes + numBytes);
+}
+
+static void CentralReceiveFrame(Central* central, Frame* frame) {
+    HAPPrecondition(central);
+    HAPPrecondition(frame);
+
+    RUN_UNTIL(central->hasFrame);
+    size_t numPayloadBytes = HAPReadLittleUInt16(&central->bytes[1]);
+    size_t numFrameBytes = kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes + numPayloadBytes;
+    frame->opcode = central->bytes[0];
+    HAPRawBufferCopyBytes(
+            frame->bytes, &central->bytes[kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes], numPayloadBytes);
+    frame->numBytes = numPayloadBytes;
+
+    // Only one request is outstanding at a time.
+    HAPAssert(central->numBytes == numFrameBytes);
+    central->numBytes = 0;
+    central->hasFrame = false;
+}
+
+/**
+ * Sends a request and receives its response.
+ *
+ * @return Status of the response.
+ */
+HAP_RESULT_USE_CHECK
+static HAPPlatformBLEPeripheralManagerSocketStatus CentralTransact(
+        Central* central,
+        uint8_t opcode,
+        const void* _Nullable bytes,
+        size_t numBytes,
+        Frame* response) {
+    HAPPrecondition(central);
+    HAPPrecondition(response);
+
+    CentralSendFrame(central, opcode, bytes, numBytes);
+    CentralReceiveFrame(central, response);
+    HAPAssert(response->opcode == (opcode | kHAPPlatformBLEPeripheralManagerSocketOpcode_Response));
+    HAPAssert(response->numBytes >= 1);
+    return (HAPPlatformBLEPeripheralManagerSocketStatus) response->bytes[0];
+}
+
+HAP_RESULT_USE_CHECK
+static HAPPlatformBLEPeripheralManagerSocketStatus CentralRead(
+        Central* central,
+        HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle,
+        size_t offset,
+        Frame* response) {
+    uint8_t bytes[4];
+    HAPWriteLittleUInt16(&bytes[0], attributeHandle);
+    HAPWriteLittleUInt16(&bytes[2], offset);
+    return CentralTransact(central, kHAPPlatformBLEPeripheralManagerSocketOpcode_Read, bytes, sizeof bytes, response);
+}
+
+int main() {
+    HAPError err;
+
+    static HAPPlatformKeyValueStore keyValueStore;
+    HAPPlatformKeyValueStoreCreate(
+            &keyValueStore, &(const HAPPlatformKeyValueStoreOptions) { .rootDirectory = ".HomeKitStore" });
+    HAPPlatformRunLoopCreate(&(const HAPPlatformRunLoopOptions) { .keyValueStore = &keyValueStore });
+
+    // Publish a GATT database with one service, one characteristic and one descriptor.
+    static HAPPlatformBLEPeripheralManager blePeripheralManager;
+    HAPPlatformBLEPeripheralManagerCreate(
+            &blePeripheralManager, &(const HAPPlatformBLEPeripheralManagerOptions) { .socketPath = kSocketPath });
+    HAPPlatformBLEPeripheralManagerSetDelegate(
+            &blePeripheralManager,
+            &(const HAPPlatformBLEPeripheralManagerDelegate) {
+                    .handleConnectedCentral = HandleConnectedCentral,
+                    .handleDisconnectedCentral = HandleDisconnectedCentral,
+                    .handleReadRequest = HandleReadRequest,
+                    .handleWriteRequest = HandleWriteRequest });
+    HAPPlatformBLEPeripheralManagerSetDeviceAddress(
+            &blePeripheralManager,
+            &(const HAPPlatformBLEPeripheralManagerDeviceAddress) { { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 } });
+    err = HAPPlatformBLEPeripheralManagerAddService(&blePeripheralManager, &serviceType, /* isPrimary: */ true);
+    HAPAssert(!err);
+    HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle;
+    err = HAPPlatformBLEPeripheralManagerAddCharacteristic(
+            &blePeripheralManager,
+            &characteristicType,
+            (HAPPlatformBLEPeripheralManagerCharacteristicProperties) { .read = true, .write = true },
+            /* constBytes: */ NULL,
+            /* constNumBytes: */ 0,
+            &valueHandle,
+            /* cccDescriptorHandle: */ NULL);
+    HAPAssert(!err);
+    static const uint8_t descriptorBytes[] = { 0x01, 0x02 };
+    HAPPlatformBLEPeripheralManagerAttributeHandle descriptorHandle;
+    err = HAPPlatformBLEPeripheralManagerAddDescriptor(
+            &blePeripheralManager,
+            &descriptorType,
+            (HAPPlatformBLEPeripheralManagerDescriptorProperties) { .read = true },
+            descriptorBytes,
+            sizeof descriptorBytes,
+            &descriptorHandle);
+    HAPAssert(!err);
+    HAPPlatformBLEPeripheralManagerPublishServices(&blePeripheralManager);
+    HAPAssert(valueHandle == 3);
+    HAPAssert(descriptorHandle == 4);
+
+    static const uint8_t advertisingBytes[] = { 0x02, 0x01, 0x06 };
+    HAPPlatformBLEPeripheralManagerStartAdvertising(
+            &blePeripheralManager,
+            HAPBLEAdvertisingIntervalCreateFromMilliseconds(20),
+            advertisingBytes,
+            sizeof advertisingBytes,
+            /* scanResponseBytes: */ NULL,
+            /* numScanResponseBytes: */ 0);
+
+    for (size_t i = 0; i < sizeof test.value; i++) {
+        test.value[i] = (uint8_t) i;
+    }
+
+    static Central central;
+    static Frame response;
+    CentralOpen(&central);
+
+    // The advertisement can be fetched, but GATT requests are rejected before connecting.
+    {
+        HAPPlatformBLEPeripheralManagerSocketStatus status = CentralTransact(
+                &central, kHAPPlatformBLEPeripheralManagerSocketOpcode_GetAdvertisement, NULL, 0, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_Success);
+        HAPAssert(response.numBytes == 1 + 2 + 1 + sizeof advertisingBytes + 1);
+        HAPAssert(HAPReadLittleUInt16(&response.bytes[1]) == HAPBLEAdvertisingIntervalCreateFromMilliseconds(20));
+        HAPAssert(response.bytes[3] == sizeof advertisingBytes);
+        HAPAssert(HAPRawBufferAreEqual(&response.bytes[4], advertisingBytes, sizeof advertisingBytes));
+
+        status = CentralRead(&central, valueHandle, 0, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_RequestNotSupported);
+        HAPAssert(!test.numReads);
+    }
+
+    // Connect.
+    {
+        HAPPlatformBLEPeripheralManagerSocketStatus status = CentralTransact(
+                &central, kHAPPlatformBLEPeripheralManagerSocketOpcode_Connect, NULL, 0, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_Success);
+        HAPAssert(response.numBytes == 1 + 2);
+        HAPAssert(test.numConnects == 1);
+        HAPAssert(HAPReadLittleUInt16(&response.bytes[1]) == test.connectionHandle);
+
+        // There is only one link.
+        status = CentralTransact(&central, kHAPPlatformBLEPeripheralManagerSocketOpcode_Connect, NULL, 0, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_RequestNotSupported);
+        HAPAssert(test.numConnects == 1);
+    }
+
+    // Discover the GATT database.
+    {
+        uint8_t bytes[2];
+        HAPWriteLittleUInt16(bytes, 1);
+        HAPPlatformBLEPeripheralManagerSocketStatus status = CentralTransact(
+                &central, kHAPPlatformBLEPeripheralManagerSocketOpcode_Discover, bytes, sizeof bytes, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_Success);
+        HAPAssert(response.numBytes == 1 + 3 * kHAPPlatformBLEPeripheralManagerSocket_NumDiscoverEntryBytes);
+
+        const uint8_t* entry = &response.bytes[1];
+        HAPAssert(entry[0] == kHAPPlatformBLEPeripheralManagerSocketAttributeKind_Service);
+        HAPAssert(HAPReadLittleUInt16(&entry[1]) == 1);
+        HAPAssert(HAPRawBufferAreEqual(&entry[3], serviceType.bytes, sizeof serviceType.bytes));
+        HAPAssert(entry[19] & kHAPPlatformBLEPeripheralManagerSocketProperty_Primary);
+
+        entry += kHAPPlatformBLEPeripheralManagerSocket_NumDiscoverEntryBytes;
+        HAPAssert(entry[0] == kHAPPlatformBLEPeripheralManagerSocketAttributeKind_Characteristic);
+        HAPAssert(HAPReadLittleUInt16(&entry[1]) == 2);
+        HAPAssert(HAPRawBufferAreEqual(&entry[3], characteristicType.bytes, sizeof characteristicType.bytes));
+        HAPAssert(entry[19] & kHAPPlatformBLEPeripheralManagerSocketProperty_Read);
+        HAPAssert(entry[19] & kHAPPlatformBLEPeripheralManagerSocketProperty_Write);
+        HAPAssert(HAPReadLittleUInt16(&entry[20]) == valueHandle);
+        HAPAssert(!HAPReadLittleUInt16(&entry[22]));
+
+        entry += kHAPPlatformBLEPeripheralManagerSocket_NumDiscoverEntryBytes;
+        HAPAssert(entry[0] == kHAPPlatformBLEPeripheralManagerSocketAttributeKind_Descriptor);
+        HAPAssert(HAPReadLittleUInt16(&entry[1]) == descriptorHandle);
+        HAPAssert(HAPRawBufferAreEqual(&entry[3], descriptorType.bytes, sizeof descriptorType.bytes));
+
+        // The end of the GATT database has been reached.
+        HAPWriteLittleUInt16(bytes, descriptorHandle + 1);
+        status = CentralTransact(
+                &central, kHAPPlatformBLEPeripheralManagerSocketOpcode_Discover, bytes, sizeof bytes, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_Success);
+        HAPAssert(response.numBytes == 1);
+    }
+
+    // Read a value that is longer than ATT_MTU - 1 in parts.
+    {
+        HAPPlatformBLEPeripheralManagerSocketStatus status;
+        size_t mtu = kHAPPlatformBLEPeripheralManagerSocket_DefaultMTU;
+        uint8_t bytes[kNumValueBytes];
+        size_t numBytes = 0;
+        while (numBytes < sizeof bytes) {
+            status = CentralRead(&central, valueHandle, numBytes, &response);
+            HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_Success);
+            HAPAssert(response.numBytes - 1 == HAPMin(sizeof bytes - numBytes, mtu - 1));
+            HAPRawBufferCopyBytes(&bytes[numBytes], &response.bytes[1], response.numBytes - 1);
+            numBytes += response.numBytes - 1;
+        }
+        HAPAssert(HAPRawBufferAreEqual(bytes, test.value, sizeof test.value));
+        HAPAssert(test.numReads == 1);
+
+        // Reading past the end of the value fails.
+        status = CentralRead(&central, valueHandle, sizeof bytes + 1, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_InvalidOffset);
+
+        // Constant values are served without the delegate.
+        status = CentralRead(&central, descriptorHandle, 0, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_Success);
+        HAPAssert(response.numBytes == 1 + sizeof descriptorBytes);
+        HAPAssert(HAPRawBufferAreEqual(&response.bytes[1], descriptorBytes, sizeof descriptorBytes));
+        HAPAssert(test.numReads == 1);
+
+        status = CentralRead(&central, descriptorHandle + 1, 0, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_InvalidHandle);
+    }
+
+    // Exchange MTU.
+    {
+        uint8_t bytes[2];
+        HAPWriteLittleUInt16(bytes, 185);
+        HAPPlatformBLEPeripheralManagerSocketStatus status = CentralTransact(
+                &central, kHAPPlatformBLEPeripheralManagerSocketOpcode_ExchangeMTU, bytes, sizeof bytes, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_Success);
+        HAPAssert(response.numBytes == 1 + 2);
+        HAPAssert(HAPReadLittleUInt16(&response.bytes[1]) == kHAPPlatformBLEPeripheralManagerSocket_MaxMTU);
+
+        status = CentralRead(&central, valueHandle, 0, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_Success);
+        HAPAssert(response.numBytes == 1 + 185 - 1);
+    }
+
+    // Write.
+    {
+        uint8_t bytes[2 + 185 - 3];
+        HAPWriteLittleUInt16(bytes, valueHandle);
+        for (size_t i = 2; i < sizeof bytes; i++) {
+            bytes[i] = (uint8_t) ~i;
+        }
+        HAPPlatformBLEPeripheralManagerSocketStatus status = CentralTransact(
+                &central, kHAPPlatformBLEPeripheralManagerSocketOpcode_Write, bytes, sizeof bytes, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_Success);
+        HAPAssert(response.numBytes == 1);
+        HAPAssert(test.numWrites == 1);
+        HAPAssert(HAPRawBufferAreEqual(test.value, &bytes[2], sizeof bytes - 2));
+
+        // Values longer than ATT_MTU - 3 require Prepare Write requests.
+        uint8_t longBytes[sizeof bytes + 1];
+        HAPRawBufferZero(longBytes, sizeof longBytes);
+        HAPWriteLittleUInt16(longBytes, valueHandle);
+        status = CentralTransact(
+                &central, kHAPPlatformBLEPeripheralManagerSocketOpcode_Write, longBytes, sizeof longBytes, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_InvalidAttributeValueLength);
+        HAPAssert(test.numWrites == 1);
+
+        // Constant values cannot be written.
+        HAPWriteLittleUInt16(bytes, descriptorHandle);
+        status = CentralTransact(&central, kHAPPlatformBLEPeripheralManagerSocketOpcode_Write, bytes, 3, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_WriteNotPermitted);
+        HAPAssert(test.numWrites == 1);
+    }
+
+    // Malformed frames are rejected without affecting the connection.
+    {
+        uint8_t bytes[3];
+        HAPWriteLittleUInt16(bytes, valueHandle);
+        bytes[2] = 0;
+        HAPPlatformBLEPeripheralManagerSocketStatus status = CentralTransact(
+                &central, kHAPPlatformBLEPeripheralManagerSocketOpcode_Read, bytes, sizeof bytes, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_UnlikelyError);
+
+        status = CentralTransact(&central, kHAPPlatformBLEPeripheralManagerSocketOpcode_Write, bytes, 1, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_UnlikelyError);
+
+        status = CentralTransact(&central, 0x42, NULL, 0, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_RequestNotSupported);
+
+        // A frame that is split across multiple writes is handled once it is complete.
+        uint8_t frameBytes[kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes + 4];
+        frameBytes[0] = kHAPPlatformBLEPeripheralManagerSocketOpcode_Read;
+        HAPWriteLittleUInt16(&frameBytes[1], 4);
+        HAPWriteLittleUInt16(&frameBytes[3], descriptorHandle);
+        HAPWriteLittleUInt16(&frameBytes[5], 0);
+        for (size_t i = 0; i < sizeof frameBytes - 1; i++) {
+            CentralSendBytes(&central, &frameBytes[i], 1);
+            RunOnce();
+            HAPAssert(blePeripheralManager.central.numInboundBytes == i + 1);
+            HAPAssert(!central.hasFrame);
+        }
+        CentralSendBytes(&central, &frameBytes[sizeof frameBytes - 1], 1);
+        CentralReceiveFrame(&central, &response);
+        HAPAssert(response.opcode == (kHAPPlatformBLEPeripheralManagerSocketOpcode_Read |
+                                      kHAPPlatformBLEPeripheralManagerSocketOpcode_Response));
+        HAPAssert(response.bytes[0] == kHAPPlatformBLEPeripheralManagerSocketStatus_Success);
+        HAPAssert(HAPRawBufferAreEqual(&response.bytes[1], descriptorBytes, sizeof descriptorBytes));
+
+        HAPAssert(test.numConnects == 1);
+        HAPAssert(!test.numDisconnects);
+        HAPAssert(!central.isClosed);
+    }
+
+    // A frame that is too long terminates the connection.
+    {
+        uint8_t headerBytes[kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes];
+        headerBytes[0] = kHAPPlatformBLEPeripheralManagerSocketOpcode_Write;
+        HAPWriteLittleUInt16(&headerBytes[1], kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes + 1);
+        CentralSendBytes(&central, headerBytes, sizeof headerBytes);
+        RUN_UNTIL(central.isClosed && test.numDisconnects == 1);
+        HAPAssert(!central.hasFrame);
+        HAPAssert(test.numWrites == 1);
+        CentralClose(&central);
+    }
+
+    // The BLE peripheral manager accepts a new central. Closing the socket terminates the connection.
+    {
+        HAPPlatformBLEPeripheralManagerConnectionHandle previousConnectionHandle = test.connectionHandle;
+        CentralOpen(&central);
+        HAPPlatformBLEPeripheralManagerSocketStatus status = CentralTransact(
+                &central, kHAPPlatformBLEPeripheralManagerSocketOpcode_Connect, NULL, 0, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_Success);
+        HAPAssert(test.numConnects == 2);
+        HAPAssert(test.connectionHandle != previousConnectionHandle);
+
+        // The read value is fetched again on the new connection.
+        status = CentralRead(&central, valueHandle, 0, &response);
+        HAPAssert(status == kHAPPlatformBLEPeripheralManagerSocketStatus_Success);
+        HAPAssert(response.numBytes == 1 + kHAPPlatformBLEPeripheralManagerSocket_DefaultMTU - 1);
+        HAPAssert(test.numReads == 3);
+
+        CentralClose(&central);
+        RUN_UNTIL(test.numDisconnects == 2);
+    }
+
+    HAPPlatformBLEPeripheralManagerRelease(&blePeripheralManager);
+    HAPAssert(access(kSocketPath, F_OK) == -1);
+    HAPPlatformRunLoopRelease();
+
+    return 0;
+}
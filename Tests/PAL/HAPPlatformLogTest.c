@@ -0,0 +1,245 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+// Captures the output of the log for POSIX by redirecting stderr into a temporary file.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "HAPPlatform+Init.h"
+#include "HAPPlatformLog+Init.h"
+
+static const HAPLogObject logObject = { .subsystem = "com.apple.mfi.HomeKit.Platform.Test", .category = "LogTest" };
+
+/** Number of threads that log concurrently. */
+#define kNumThreads ((size_t) 4)
+
+/** Number of records that are logged by each thread. */
+#define kNumRecordsPerThread ((size_t) 1000)
+
+/**
+ * Number of records after which each thread waits until the queue has been written.
+ *
+ * - Bounds the number of queued records to kNumThreads * kNumRecordsPerFlush, so that no records are dropped.
+ */
+#define kNumRecordsPerFlush ((size_t) 16)
+
+/** Maximum number of records that are logged per second while testing rate limiting. */
+#define kMaxRecordsPerSecond ((uint32_t) 10)
+
+/**
+ * Captured output.
+ */
+static struct {
+    /** File into which stderr is redirected. */
+    FILE* _Nullable file;
+
+    /** Original stderr. */
+    int stderrFileDescriptor;
+
+    /** Captured bytes. NULL-terminated. */
+    char bytes[1024 * 1024];
+
+    /** Number of captured bytes. */
+    size_t numBytes;
+} capture;
+
+/**
+ * Starts redirecting stderr into a temporary file.
+ */
+static void BeginCapture(void) {
+    HAPPrecondition(!capture.file);
+
+    capture.file = tmpfile();
+    HAPAssert(capture.file);
+    capture.stderrFileDescriptor = dup(STDERR_FILENO);
+    HAPAssert(capture.stderrFileDescriptor >= 0);
+    int e = dup2(fileno(HAPNonnull(capture.file)), STDERR_FILENO);
+    HAPAssert(e == STDERR_FILENO);
+}
+
+/**
+ * Restores stderr and reads the captured output.
+ *
+ * - The log is not flushed. Records that are still queued are not captured.
+ */
+static void EndCapture(void) {
+    HAPPrecondition(capture.file);
+
+    int e = dup2(capture.stderrFileDescriptor, STDERR_FILENO);
+    HAPAssert(e == STDERR_FILENO);
+    close(capture.stderrFileDescriptor);
+
+    e = fseek(HAPNonnull(capture.file), 0, SEEK_SET);
+    HAPAssert(!e);
+    capture.numBytes = fread(capture.bytes, 1, sizeof capture.bytes - 1, HAPNonnull(capture.file));
+    HAPAssert(capture.numBytes < sizeof capture.bytes - 1);
+    capture.bytes[capture.numBytes] = '\0';
+    fclose(HAPNonnull(capture.file));
+    capture.file = NULL;
+}
+
+/**
+ * Returns the next captured line, without the prefix of the journal format.
+ *
+ * @param[in,out] position          Position in the captured output.
+ * @param[out] line                 Line. NULL-terminated.
+ * @param      maxLineBytes         Capacity of line.
+ *
+ * @return true                     If a line has been returned.
+ * @return false                    If all lines have been returned.
+ */
+HAP_RESULT_USE_CHECK
+static bool GetNextLine(size_t* position, char* line, size_t maxLineBytes) {
+    HAPPrecondition(position);
+    HAPPrecondition(line);
+
+    if (*position == capture.numBytes) {
+        return false;
+    }
+    const char* start = &capture.bytes[*position];
+    const char* end = strchr(start, '\n');
+    HAPAssert(end);
+    *position += (size_t)(end - start) + 1;
+
+    // Skip "<severity>[subsystem:category] ".
+    if (*start == '<') {
+        const char* message = strstr(start, "] ");
+        HAPAssert(message && message < end);
+        start = message + 2;
+    }
+    size_t numBytes = (size_t)(end - start);
+    HAPAssert(numBytes < maxLineBytes);
+    HAPRawBufferCopyBytes(line, start, numBytes);
+    line[numBytes] = '\0';
+    return true;
+}
+
+/**
+ * Waits until a new second starts on the clock that is used for rate limiting.
+ */
+static void WaitForNextSecond(void) {
+    struct timespec start;
+    int e = clock_gettime(CLOCK_MONOTONIC, &start);
+    HAPAssert(!e);
+    for (;;) {
+        struct timespec now;
+        e = clock_gettime(CLOCK_MONOTONIC, &now);
+        HAPAssert(!e);
+        if (now.tv_sec != start.tv_sec) {
+            return;
+        }
+        usleep(1000);
+    }
+}
+
+static void* _Nullable LogRecords(void* _Nullable context) {
+    HAPPrecondition(context);
+    unsigned long thread = (unsigned long) *(const size_t*) context;
+
+    for (size_t i = 0; i < kNumRecordsPerThread; i++) {
+        HAPLog(&logObject, "Thread %lu record %lu.", thread, (unsigned long) i);
+        if ((i + 1) % kNumRecordsPerFlush == 0) {
+            HAPPlatformLogFlush();
+        }
+    }
+    return NULL;
+}
+
+int main() {
+    char line[256];
+    size_t position;
+
+    // Records that are logged concurrently are written completely and in order per thread.
+    HAPPlatformLogCreate(&(const HAPPlatformLogOptions) { .format = kHAPPlatformLogFormat_Journal,
+                                                          .useBackgroundWriter = true });
+    BeginCapture();
+    {
+        pthread_t threads[kNumThreads];
+        size_t threadIndices[kNumThreads];
+        for (size_t i = 0; i < kNumThreads; i++) {
+            threadIndices[i] = i;
+            int e = pthread_create(&threads[i], /* attr: */ NULL, LogRecords, &threadIndices[i]);
+            HAPAssert(!e);
+        }
+        for (size_t i = 0; i < kNumThreads; i++) {
+            int e = pthread_join(threads[i], NULL);
+            HAPAssert(!e);
+        }
+    }
+    HAPPlatformLogFlush();
+    EndCapture();
+    {
+        size_t numRecords[kNumThreads];
+        HAPRawBufferZero(numRecords, sizeof numRecords);
+        position = 0;
+        while (GetNextLine(&position, line, sizeof line)) {
+            unsigned long thread;
+            unsigned long record;
+            int n = sscanf(line, "Thread %lu record %lu.", &thread, &record);
+            HAPAssert(n == 2);
+            HAPAssert(thread < kNumThreads);
+            HAPAssert(record == numRecords[thread]);
+            numRecords[thread]++;
+        }
+        for (size_t i = 0; i < kNumThreads; i++) {
+            HAPAssert(numRecords[i] == kNumRecordsPerThread);
+        }
+    }
+
+    // Fault records bypass the queue. They are written before logging returns, after all queued records.
+    BeginCapture();
+    for (size_t i = 0; i < kNumRecordsPerFlush; i++) {
+        HAPLog(&logObject, "Queued record %lu.", (unsigned long) i);
+    }
+    HAPLogFault(&logObject, "Fault.");
+    EndCapture();
+    position = 0;
+    for (size_t i = 0; i < kNumRecordsPerFlush; i++) {
+        unsigned long record;
+        HAPAssert(GetNextLine(&position, line, sizeof line));
+        HAPAssert(sscanf(line, "Queued record %lu.", &record) == 1);
+        HAPAssert(record == i);
+    }
+    HAPAssert(GetNextLine(&position, line, sizeof line));
+    HAPAssert(HAPStringAreEqual(line, "Fault."));
+    HAPAssert(!GetNextLine(&position, line, sizeof line));
+    HAPPlatformLogRelease();
+
+    // Records that exceed the rate limit are dropped and reported with the next record that is written.
+    // Fault records are not rate limited.
+    HAPPlatformLogCreate(&(const HAPPlatformLogOptions) { .format = kHAPPlatformLogFormat_Journal,
+                                                          .maxRecordsPerSecond = kMaxRecordsPerSecond });
+    BeginCapture();
+    WaitForNextSecond();
+    for (size_t i = 0; i < 2 * kMaxRecordsPerSecond; i++) {
+        HAPLog(&logObject, "Limited record %lu.", (unsigned long) i);
+    }
+    HAPLogFault(&logObject, "Fault.");
+    WaitForNextSecond();
+    HAPLog(&logObject, "Next second.");
+    EndCapture();
+    position = 0;
+    for (size_t i = 0; i < kMaxRecordsPerSecond; i++) {
+        unsigned long record;
+        HAPAssert(GetNextLine(&position, line, sizeof line));
+        HAPAssert(sscanf(line, "Limited record %lu.", &record) == 1);
+        HAPAssert(record == i);
+    }
+    HAPAssert(GetNextLine(&position, line, sizeof line));
+    HAPAssert(HAPStringAreEqual(line, "Fault."));
+    HAPAssert(GetNextLine(&position, line, sizeof line));
+    HAPAssert(HAPStringAreEqual(line, "[10 log records dropped]"));
+    HAPAssert(GetNextLine(&position, line, sizeof line));
+    HAPAssert(HAPStringAreEqual(line, "Next second."));
+    HAPAssert(!GetNextLine(&position, line, sizeof line));
+    HAPPlatformLogRelease();
+
+    return 0;
+}
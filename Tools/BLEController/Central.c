@@ -0,0 +1,603 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+// GATT client for the socket of the POSIX BLE peripheral manager.
+// All operations block until the response has been received. Handle Value Indications are confirmed and counted.
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Central.h"
+
+/** UUID of the Characteristic Instance ID descriptor. */
+static const HAPUUID kDescriptorUUID_CharacteristicInstanceID = {
+    { 0x9A, 0x93, 0x96, 0xD7, 0xBD, 0x6A, 0xD9, 0xB5, 0x16, 0x46, 0xD2, 0x81, 0xFE, 0xF0, 0x46, 0xDC }
+};
+
+/** UUID of the Service Instance ID characteristic. */
+static const HAPUUID kCharacteristicUUID_ServiceInstanceID = {
+    { 0xD1, 0xA0, 0x83, 0x50, 0x00, 0xAA, 0xD3, 0x87, 0x17, 0x48, 0x59, 0xA7, 0x5D, 0xE9, 0x04, 0xE6 }
+};
+
+/**
+ * Sends a frame.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError SendFrame(Central* central, uint8_t opcode, const void* _Nullable bytes, size_t numBytes) {
+    HAPPrecondition(central);
+    HAPPrecondition(!numBytes || bytes);
+    HAPPrecondition(numBytes <= kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes);
+
+    if (central->fd == -1) {
+        return kHAPError_Unknown;
+    }
+
+    uint8_t frameBytes[kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes +
+                       kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes];
+    frameBytes[0] = opcode;
+    HAPWriteLittleUInt16(&frameBytes[1], numBytes);
+    if (numBytes) {
+        HAPRawBufferCopyBytes(
+                &frameBytes[kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes], HAPNonnullVoid(bytes), numBytes);
+    }
+    size_t numFrameBytes = kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes + numBytes;
+    size_t o = 0;
+    while (o < numFrameBytes) {
+        ssize_t n = send(central->fd, &frameBytes[o], numFrameBytes - o, MSG_NOSIGNAL);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            perror("send");
+            return kHAPError_Unknown;
+        }
+        o += (size_t) n;
+    }
+    return kHAPError_None;
+}
+
+/**
+ * Receives exactly the requested number of bytes.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If the connection failed or timed out.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError ReceiveBytes(Central* central, void* bytes_, size_t numBytes) {
+    HAPPrecondition(central);
+    HAPPrecondition(bytes_);
+    uint8_t* bytes = bytes_;
+
+    size_t o = 0;
+    while (o < numBytes) {
+        struct pollfd pfd = { .fd = central->fd, .events = POLLIN };
+        int e = poll(&pfd, 1, central->timeout);
+        if (e == -1 && errno == EINTR) {
+            continue;
+        }
+        if (e <= 0) {
+            fprintf(stderr, "Timed out waiting for the peripheral.\n");
+            return kHAPError_Unknown;
+        }
+        ssize_t n = recv(central->fd, &bytes[o], numBytes - o, 0);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            if (n == -1) {
+                perror("recv");
+            }
+            return kHAPError_Unknown;
+        }
+        o += (size_t) n;
+    }
+    return kHAPError_None;
+}
+
+/**
+ * Sends a request and waits for its response. Handle Value Indications that arrive in the meantime are confirmed.
+ *
+ * @param      central              Central.
+ * @param      opcode               Opcode.
+ * @param      bytes                Request payload.
+ * @param      numBytes             Length of request payload.
+ * @param[out] responseBytes        Response payload following the status.
+ * @param      maxResponseBytes     Capacity of the response buffer.
+ * @param[out] numResponseBytes     Length of the response payload following the status.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidState   If the response has an error status.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError Request(
+        Central* central,
+        HAPPlatformBLEPeripheralManagerSocketOpcode opcode,
+        const void* _Nullable bytes,
+        size_t numBytes,
+        void* _Nullable responseBytes,
+        size_t maxResponseBytes,
+        size_t* _Nullable numResponseBytes) {
+    HAPPrecondition(central);
+    HAPPrecondition(!maxResponseBytes || responseBytes);
+
+    HAPError err;
+
+    err = SendFrame(central, opcode, bytes, numBytes);
+    if (err) {
+        return err;
+    }
+    central->numGATTRequests++;
+
+    for (;;) {
+        uint8_t header[kHAPPlatformBLEPeripheralManagerSocket_NumHeaderBytes];
+        err = ReceiveBytes(central, header, sizeof header);
+        if (err) {
+            return err;
+        }
+        size_t numPayloadBytes = HAPReadLittleUInt16(&header[1]);
+        if (numPayloadBytes > kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes) {
+            fprintf(stderr, "Received frame that is too long.\n");
+            return kHAPError_Unknown;
+        }
+        uint8_t payload[kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes];
+        err = ReceiveBytes(central, payload, numPayloadBytes);
+        if (err) {
+            return err;
+        }
+
+        if (header[0] == kHAPPlatformBLEPeripheralManagerSocketOpcode_Indication) {
+            central->numIndications++;
+            err = SendFrame(central, kHAPPlatformBLEPeripheralManagerSocketOpcode_Confirmation, NULL, 0);
+            if (err) {
+                return err;
+            }
+            continue;
+        }
+        if (header[0] != (opcode | kHAPPlatformBLEPeripheralManagerSocketOpcode_Response) || !numPayloadBytes) {
+            fprintf(stderr, "Received unexpected frame 0x%02x.\n", header[0]);
+            return kHAPError_Unknown;
+        }
+        if (payload[0] != kHAPPlatformBLEPeripheralManagerSocketStatus_Success) {
+            return kHAPError_InvalidState;
+        }
+        if (numPayloadBytes - 1 > maxResponseBytes) {
+            fprintf(stderr, "Received response that is too long.\n");
+            return kHAPError_Unknown;
+        }
+        if (numPayloadBytes > 1) {
+            HAPRawBufferCopyBytes(HAPNonnullVoid(responseBytes), &payload[1], numPayloadBytes - 1);
+        }
+        if (numResponseBytes) {
+            *numResponseBytes = numPayloadBytes - 1;
+        }
+        return kHAPError_None;
+    }
+}
+
+void CentralCreate(Central* central, int timeout) {
+    HAPPrecondition(central);
+
+    HAPRawBufferZero(central, sizeof *central);
+    central->fd = -1;
+    central->mtu = kHAPPlatformBLEPeripheralManagerSocket_DefaultMTU;
+    central->timeout = timeout;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError CentralOpen(Central* central, const char* socketPath) {
+    HAPPrecondition(central);
+    HAPPrecondition(central->fd == -1);
+    HAPPrecondition(socketPath);
+
+    struct sockaddr_un sun;
+    HAPRawBufferZero(&sun, sizeof sun);
+    sun.sun_family = AF_UNIX;
+    size_t numSocketPathBytes = HAPStringGetNumBytes(socketPath);
+    if (numSocketPathBytes >= sizeof sun.sun_path) {
+        fprintf(stderr, "Socket path too long.\n");
+        return kHAPError_Unknown;
+    }
+    HAPRawBufferCopyBytes(sun.sun_path, socketPath, numSocketPathBytes);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        perror("socket");
+        return kHAPError_Unknown;
+    }
+    if (connect(fd, (const struct sockaddr*) &sun, sizeof sun) == -1) {
+        perror("connect");
+        (void) close(fd);
+        return kHAPError_Unknown;
+    }
+    central->fd = fd;
+    central->mtu = kHAPPlatformBLEPeripheralManagerSocket_DefaultMTU;
+    return kHAPError_None;
+}
+
+void CentralClose(Central* central) {
+    HAPPrecondition(central);
+
+    if (central->fd != -1) {
+        (void) close(central->fd);
+        central->fd = -1;
+    }
+    central->connectionHandle = 0;
+    central->mtu = kHAPPlatformBLEPeripheralManagerSocket_DefaultMTU;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError CentralGetAdvertisement(
+        Central* central,
+        HAPBLEAdvertisingInterval* advertisingInterval,
+        uint8_t* bytes,
+        size_t* numBytes) {
+    HAPPrecondition(central);
+    HAPPrecondition(advertisingInterval);
+    HAPPrecondition(bytes);
+    HAPPrecondition(numBytes);
+
+    HAPError err;
+
+    uint8_t responseBytes[2 + 1 + 31 + 1 + 31];
+    size_t numResponseBytes;
+    err = Request(
+            central,
+            kHAPPlatformBLEPeripheralManagerSocketOpcode_GetAdvertisement,
+            NULL,
+            0,
+            responseBytes,
+            sizeof responseBytes,
+            &numResponseBytes);
+    if (err) {
+        return err;
+    }
+    if (numResponseBytes < 3 || responseBytes[2] > 31 || numResponseBytes < 3 + (size_t) responseBytes[2]) {
+        fprintf(stderr, "Malformed advertisement.\n");
+        return kHAPError_Unknown;
+    }
+    *advertisingInterval = HAPReadLittleUInt16(&responseBytes[0]);
+    *numBytes = responseBytes[2];
+    HAPRawBufferCopyBytes(bytes, &responseBytes[3], *numBytes);
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError CentralConnect(Central* central, uint16_t mtu) {
+    HAPPrecondition(central);
+
+    HAPError err;
+
+    uint8_t bytes[2];
+    size_t numBytes;
+    err = Request(
+            central, kHAPPlatformBLEPeripheralManagerSocketOpcode_Connect, NULL, 0, bytes, sizeof bytes, &numBytes);
+    if (err) {
+        return err;
+    }
+    if (numBytes != sizeof bytes) {
+        return kHAPError_Unknown;
+    }
+    central->connectionHandle = HAPReadLittleUInt16(bytes);
+
+    uint8_t requestBytes[2];
+    HAPWriteLittleUInt16(requestBytes, mtu);
+    err = Request(
+            central,
+            kHAPPlatformBLEPeripheralManagerSocketOpcode_ExchangeMTU,
+            requestBytes,
+            sizeof requestBytes,
+            bytes,
+            sizeof bytes,
+            &numBytes);
+    if (err) {
+        return err;
+    }
+    if (numBytes != sizeof bytes) {
+        return kHAPError_Unknown;
+    }
+    uint16_t serverMTU = HAPReadLittleUInt16(bytes);
+    central->mtu = HAPMax(kHAPPlatformBLEPeripheralManagerSocket_DefaultMTU, HAPMin(mtu, serverMTU));
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError CentralDiscover(Central* central) {
+    HAPPrecondition(central);
+
+    HAPError err;
+
+    central->numAttributes = 0;
+    uint16_t startHandle = 1;
+    for (;;) {
+        uint8_t requestBytes[2];
+        HAPWriteLittleUInt16(requestBytes, startHandle);
+        uint8_t bytes[kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes];
+        size_t numBytes;
+        err = Request(
+                central,
+                kHAPPlatformBLEPeripheralManagerSocketOpcode_Discover,
+                requestBytes,
+                sizeof requestBytes,
+                bytes,
+                sizeof bytes,
+                &numBytes);
+        if (err) {
+            return err;
+        }
+        if (!numBytes) {
+            return kHAPError_None;
+        }
+        if (numBytes % kHAPPlatformBLEPeripheralManagerSocket_NumDiscoverEntryBytes) {
+            fprintf(stderr, "Malformed Discover response.\n");
+            return kHAPError_Unknown;
+        }
+        for (size_t o = 0; o < numBytes; o += kHAPPlatformBLEPeripheralManagerSocket_NumDiscoverEntryBytes) {
+            if (central->numAttributes == HAPArrayCount(central->attributes)) {
+                return kHAPError_OutOfResources;
+            }
+            CentralAttribute* attribute = &central->attributes[central->numAttributes];
+            attribute->kind = bytes[o];
+            attribute->handle = HAPReadLittleUInt16(&bytes[o + 1]);
+            HAPRawBufferCopyBytes(attribute->type.bytes, &bytes[o + 3], sizeof attribute->type.bytes);
+            attribute->properties = bytes[o + 19];
+            attribute->valueHandle = HAPReadLittleUInt16(&bytes[o + 20]);
+            attribute->cccDescriptorHandle = HAPReadLittleUInt16(&bytes[o + 22]);
+            if (attribute->handle < startHandle) {
+                fprintf(stderr, "Discover response not in ascending order.\n");
+                return kHAPError_Unknown;
+            }
+            startHandle = (uint16_t)(attribute->handle + 1);
+            central->numAttributes++;
+        }
+    }
+}
+
+HAP_RESULT_USE_CHECK
+HAPError CentralGetCharacteristics(
+        Central* central,
+        CentralCharacteristic* characteristics,
+        size_t maxCharacteristics,
+        size_t* numCharacteristics) {
+    HAPPrecondition(central);
+    HAPPrecondition(characteristics);
+    HAPPrecondition(numCharacteristics);
+
+    HAPError err;
+
+    *numCharacteristics = 0;
+    const CentralAttribute* characteristic = NULL;
+    for (size_t i = 0; i < central->numAttributes; i++) {
+        const CentralAttribute* attribute = &central->attributes[i];
+        if (attribute->kind == kHAPPlatformBLEPeripheralManagerSocketAttributeKind_Characteristic) {
+            characteristic = HAPUUIDAreEqual(&attribute->type, &kCharacteristicUUID_ServiceInstanceID) ? NULL :
+                                                                                                         attribute;
+            continue;
+        }
+        if (attribute->kind != kHAPPlatformBLEPeripheralManagerSocketAttributeKind_Descriptor || !characteristic ||
+            !HAPUUIDAreEqual(&attribute->type, &kDescriptorUUID_CharacteristicInstanceID)) {
+            continue;
+        }
+        if (*numCharacteristics == maxCharacteristics) {
+            return kHAPError_OutOfResources;
+        }
+        uint8_t iidBytes[2];
+        size_t numIIDBytes;
+        err = CentralReadValue(central, attribute->handle, iidBytes, sizeof iidBytes, &numIIDBytes);
+        if (err) {
+            return err;
+        }
+        if (numIIDBytes != sizeof iidBytes) {
+            return kHAPError_Unknown;
+        }
+        CentralCharacteristic* c = &characteristics[*numCharacteristics];
+        c->type = HAPNonnull(characteristic)->type;
+        c->valueHandle = HAPNonnull(characteristic)->valueHandle;
+        c->iid = HAPReadLittleUInt16(iidBytes);
+        (*numCharacteristics)++;
+        characteristic = NULL;
+    }
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError CentralReadValue(Central* central, uint16_t handle, void* bytes_, size_t maxBytes, size_t* numBytes) {
+    HAPPrecondition(central);
+    HAPPrecondition(bytes_);
+    HAPPrecondition(numBytes);
+    uint8_t* bytes = bytes_;
+
+    HAPError err;
+
+    *numBytes = 0;
+    for (;;) {
+        if (*numBytes > UINT16_MAX) {
+            return kHAPError_OutOfResources;
+        }
+        uint8_t requestBytes[4];
+        HAPWriteLittleUInt16(&requestBytes[0], handle);
+        HAPWriteLittleUInt16(&requestBytes[2], *numBytes);
+        uint8_t partBytes[kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes];
+        size_t numPartBytes;
+        err = Request(
+                central,
+                kHAPPlatformBLEPeripheralManagerSocketOpcode_Read,
+                requestBytes,
+                sizeof requestBytes,
+                partBytes,
+                sizeof partBytes,
+                &numPartBytes);
+        if (err) {
+            return err;
+        }
+        if (numPartBytes > maxBytes - *numBytes) {
+            return kHAPError_OutOfResources;
+        }
+        HAPRawBufferCopyBytes(&bytes[*numBytes], partBytes, numPartBytes);
+        *numBytes += numPartBytes;
+
+        // A part shorter than ATT_MTU - 1 bytes ends the value.
+        if (numPartBytes < (size_t) central->mtu - 1) {
+            return kHAPError_None;
+        }
+    }
+}
+
+HAP_RESULT_USE_CHECK
+HAPError CentralWriteValue(Central* central, uint16_t handle, const void* bytes_, size_t numBytes) {
+    HAPPrecondition(central);
+    HAPPrecondition(bytes_);
+    const uint8_t* bytes = bytes_;
+
+    HAPError err;
+
+    uint8_t requestBytes[kHAPPlatformBLEPeripheralManagerSocket_MaxPayloadBytes];
+    if (numBytes <= (size_t) central->mtu - 3) {
+        HAPWriteLittleUInt16(&requestBytes[0], handle);
+        HAPRawBufferCopyBytes(&requestBytes[2], bytes, numBytes);
+        return Request(
+                central, kHAPPlatformBLEPeripheralManagerSocketOpcode_Write, requestBytes, 2 + numBytes, NULL, 0, NULL);
+    }
+
+    for (size_t o = 0; o < numBytes;) {
+        size_t numPartBytes = HAPMin(numBytes - o, (size_t) central->mtu - 5);
+        HAPWriteLittleUInt16(&requestBytes[0], handle);
+        HAPWriteLittleUInt16(&requestBytes[2], o);
+        HAPRawBufferCopyBytes(&requestBytes[4], &bytes[o], numPartBytes);
+        err = Request(
+                central,
+                kHAPPlatformBLEPeripheralManagerSocketOpcode_PrepareWrite,
+                requestBytes,
+                4 + numPartBytes,
+                NULL,
+                0,
+                NULL);
+        if (err) {
+            return err;
+        }
+        o += numPartBytes;
+    }
+    requestBytes[0] = 0x01;
+    return Request(central, kHAPPlatformBLEPeripheralManagerSocketOpcode_ExecuteWrite, requestBytes, 1, NULL, 0, NULL);
+}
+
+HAP_RESULT_USE_CHECK
+HAPError CentralTransact(
+        Central* central,
+        const CentralCharacteristic* characteristic,
+        HAPPDUOpcode opcode,
+        uint16_t iid,
+        const void* _Nullable bodyBytes_,
+        size_t numBodyBytes,
+        CentralResponse* response) {
+    HAPPrecondition(central);
+    HAPPrecondition(characteristic);
+    HAPPrecondition(!numBodyBytes || bodyBytes_);
+    HAPPrecondition(numBodyBytes <= UINT16_MAX);
+    HAPPrecondition(response);
+    const uint8_t* bodyBytes = bodyBytes_;
+
+    HAPError err;
+
+    uint8_t tid = central->tid++;
+    size_t maxFragmentBytes = (size_t) central->mtu - 3;
+    uint8_t bytes[kHAPBLEPDU_NumRequestHeaderBytes + kHAPBLEPDU_NumBodyHeaderBytes +
+                  kHAPPlatformBLEPeripheralManager_MaxAttributeBytes];
+    HAPAssert(maxFragmentBytes <= sizeof bytes);
+
+    // Write request.
+    size_t o = 0;
+    do {
+        HAPBLEPDU pdu;
+        HAPRawBufferZero(&pdu, sizeof pdu);
+        pdu.controlField.type = kHAPBLEPDUType_Request;
+        pdu.controlField.length = kHAPBLEPDUControlFieldLength_1Byte;
+        size_t maxBodyFragmentBytes;
+        if (!o) {
+            pdu.controlField.fragmentationStatus = kHAPBLEPDUFragmentationStatus_FirstFragment;
+            pdu.fixedParams.request.opcode = opcode;
+            pdu.fixedParams.request.tid = tid;
+            pdu.fixedParams.request.iid = iid;
+            maxBodyFragmentBytes = maxFragmentBytes - kHAPBLEPDU_NumRequestHeaderBytes - kHAPBLEPDU_NumBodyHeaderBytes;
+        } else {
+            pdu.controlField.fragmentationStatus = kHAPBLEPDUFragmentationStatus_Continuation;
+            pdu.fixedParams.continuation.tid = tid;
+            maxBodyFragmentBytes = maxFragmentBytes - kHAPBLEPDU_NumContinuationHeaderBytes;
+        }
+        if (numBodyBytes) {
+            size_t numBodyFragmentBytes = HAPMin(numBodyBytes - o, maxBodyFragmentBytes);
+            pdu.body.totalBodyBytes = (uint16_t) numBodyBytes;
+            pdu.body.bytes = &bodyBytes[o];
+            pdu.body.numBytes = (uint16_t) numBodyFragmentBytes;
+            o += numBodyFragmentBytes;
+        }
+        size_t numBytes;
+        err = HAPBLEPDUSerialize(&pdu, bytes, maxFragmentBytes, &numBytes);
+        HAPAssert(!err);
+        err = CentralWriteValue(central, characteristic->valueHandle, bytes, numBytes);
+        if (err) {
+            return err;
+        }
+    } while (o < numBodyBytes);
+
+    // Read response.
+    response->numBytes = 0;
+    size_t totalBodyBytes = 0;
+    bool isFirstFragment = true;
+    do {
+        size_t numBytes;
+        err = CentralReadValue(central, characteristic->valueHandle, bytes, sizeof bytes, &numBytes);
+        if (err) {
+            return err;
+        }
+        HAPBLEPDU pdu;
+        if (isFirstFragment) {
+            err = HAPBLEPDUDeserialize(&pdu, bytes, numBytes);
+            if (err || pdu.controlField.type != kHAPBLEPDUType_Response ||
+                pdu.controlField.fragmentationStatus != kHAPBLEPDUFragmentationStatus_FirstFragment ||
+                pdu.fixedParams.response.tid != tid) {
+                fprintf(stderr, "Malformed HAP-BLE response.\n");
+                return kHAPError_InvalidData;
+            }
+            response->status = pdu.fixedParams.response.status;
+            totalBodyBytes = pdu.body.totalBodyBytes;
+            isFirstFragment = false;
+        } else {
+            err = HAPBLEPDUDeserializeContinuation(
+                    &pdu,
+                    bytes,
+                    numBytes,
+                    kHAPBLEPDUType_Response,
+                    totalBodyBytes - response->numBytes,
+                    response->numBytes);
+            if (err || pdu.fixedParams.continuation.tid != tid) {
+                fprintf(stderr, "Malformed HAP-BLE response continuation.\n");
+                return kHAPError_InvalidData;
+            }
+        }
+        if (pdu.body.numBytes > sizeof response->bytes - response->numBytes) {
+            return kHAPError_OutOfResources;
+        }
+        if (pdu.body.numBytes) {
+            HAPRawBufferCopyBytes(
+                    &response->bytes[response->numBytes], HAPNonnullVoid(pdu.body.bytes), pdu.body.numBytes);
+        }
+        response->numBytes += pdu.body.numBytes;
+        if (!pdu.body.numBytes && response->numBytes < totalBodyBytes) {
+            fprintf(stderr, "HAP-BLE response fragment without body.\n");
+            return kHAPError_InvalidData;
+        }
+    } while (response->numBytes < totalBodyBytes);
+    return kHAPError_None;
+}
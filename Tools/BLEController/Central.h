@@ -0,0 +1,271 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#ifndef CENTRAL_H
+#define CENTRAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "HAP+Internal.h"
+#include "HAPPlatformBLEPeripheralManager+Socket.h"
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull begin
+#endif
+
+/**
+ * Maximum number of GATT attributes that are discovered.
+ */
+#define kCentral_MaxAttributes ((size_t) 256)
+
+/**
+ * Maximum length of a HAP-BLE PDU body that is sent or received.
+ */
+#define kCentral_MaxBodyBytes ((size_t) 4096)
+
+/**
+ * GATT attribute, as discovered.
+ */
+typedef struct {
+    /** Kind. */
+    HAPPlatformBLEPeripheralManagerSocketAttributeKind kind;
+
+    /** Attribute handle of the declaration. */
+    uint16_t handle;
+
+    /** UUID. */
+    HAPUUID type;
+
+    /** Properties. */
+    HAPPlatformBLEPeripheralManagerSocketProperty properties;
+
+    /** Value handle. Only characteristics. */
+    uint16_t valueHandle;
+
+    /** Client Characteristic Configuration descriptor handle. Only characteristics, 0 if none. */
+    uint16_t cccDescriptorHandle;
+} CentralAttribute;
+
+/**
+ * HAP characteristic, as discovered.
+ */
+typedef struct {
+    /** Characteristic type. */
+    HAPUUID type;
+
+    /** Value handle. */
+    uint16_t valueHandle;
+
+    /** Characteristic instance ID. */
+    uint16_t iid;
+} CentralCharacteristic;
+
+/**
+ * Connection from a central to the BLE peripheral manager socket.
+ */
+typedef struct {
+    /** Socket. -1 if the connection is closed. */
+    int fd;
+
+    /** Negotiated ATT_MTU. */
+    uint16_t mtu;
+
+    /** Connection handle. */
+    uint16_t connectionHandle;
+
+    /** Next HAP-BLE transaction identifier. */
+    uint8_t tid;
+
+    /** Discovered GATT attributes. */
+    CentralAttribute attributes[kCentral_MaxAttributes];
+    size_t numAttributes;
+
+    /** Number of GATT requests that have been sent. */
+    size_t numGATTRequests;
+
+    /** Number of Handle Value Indications that have been received. */
+    size_t numIndications;
+
+    /** Maximum time to wait for a response, in milliseconds. */
+    int timeout;
+} Central;
+
+/**
+ * HAP-BLE response.
+ */
+typedef struct {
+    /** HAP Status. */
+    HAPBLEPDUStatus status;
+
+    /** Body. */
+    uint8_t bytes[kCentral_MaxBodyBytes];
+    size_t numBytes;
+} CentralResponse;
+
+/**
+ * Initializes a central. The socket is closed.
+ *
+ * @param[out] central              Central.
+ * @param      timeout              Maximum time to wait for a response, in milliseconds.
+ */
+void CentralCreate(Central* central, int timeout);
+
+/**
+ * Opens the BLE peripheral manager socket.
+ *
+ * - Discovered attributes and counters are kept.
+ *
+ * @param      central              Central. The socket must be closed.
+ * @param      socketPath           Path of the socket.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If the socket could not be opened.
+ */
+HAP_RESULT_USE_CHECK
+HAPError CentralOpen(Central* central, const char* socketPath);
+
+/**
+ * Closes the socket. This disconnects the central. Has no effect if the socket is already closed.
+ *
+ * @param      central              Central.
+ */
+void CentralClose(Central* central);
+
+/**
+ * Fetches the advertisement.
+ *
+ * @param      central              Central.
+ * @param[out] advertisingInterval  Advertising interval.
+ * @param[out] bytes                Advertising data. At least 31 bytes.
+ * @param[out] numBytes             Length of the advertising data.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidState   If the peripheral is not advertising.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+HAPError CentralGetAdvertisement(
+        Central* central,
+        HAPBLEAdvertisingInterval* advertisingInterval,
+        uint8_t* bytes,
+        size_t* numBytes);
+
+/**
+ * Connects to the peripheral and exchanges the MTU.
+ *
+ * @param      central              Central.
+ * @param      mtu                  Client Rx MTU.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidState   If the peripheral is not connectable.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+HAPError CentralConnect(Central* central, uint16_t mtu);
+
+/**
+ * Discovers all GATT attributes.
+ *
+ * @param      central              Central.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If the GATT database has too many attributes.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+HAPError CentralDiscover(Central* central);
+
+/**
+ * Enumerates the HAP characteristics among the discovered GATT attributes and reads their instance IDs.
+ *
+ * @param      central              Central.
+ * @param[out] characteristics      HAP characteristics.
+ * @param      maxCharacteristics   Capacity of the characteristics array.
+ * @param[out] numCharacteristics   Number of HAP characteristics.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If there are too many HAP characteristics.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+HAPError CentralGetCharacteristics(
+        Central* central,
+        CentralCharacteristic* characteristics,
+        size_t maxCharacteristics,
+        size_t* numCharacteristics);
+
+/**
+ * Reads a GATT attribute, using multiple reads if the value is longer than ATT_MTU - 1 bytes.
+ *
+ * @param      central              Central.
+ * @param      handle               Attribute handle.
+ * @param[out] bytes                Value.
+ * @param      maxBytes             Capacity of the value buffer.
+ * @param[out] numBytes             Length of the value.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidState   If the peripheral rejected the request.
+ * @return kHAPError_OutOfResources If the value buffer is too small.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+HAPError CentralReadValue(Central* central, uint16_t handle, void* bytes, size_t maxBytes, size_t* numBytes);
+
+/**
+ * Writes a GATT attribute, using Prepare Write requests if the value is longer than ATT_MTU - 3 bytes.
+ *
+ * @param      central              Central.
+ * @param      handle               Attribute handle.
+ * @param      bytes                Value.
+ * @param      numBytes             Length of the value.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidState   If the peripheral rejected the request.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+HAPError CentralWriteValue(Central* central, uint16_t handle, const void* bytes, size_t numBytes);
+
+/**
+ * Runs a HAP-BLE transaction: Writes a HAP-BLE request and reads the HAP-BLE response.
+ *
+ * - PDUs are fragmented so that every fragment fits into a single GATT request.
+ *
+ * @param      central              Central.
+ * @param      characteristic       HAP characteristic.
+ * @param      opcode               HAP Opcode.
+ * @param      iid                  Characteristic or service instance ID.
+ * @param      bodyBytes            Request body. NULL if the request has no body.
+ * @param      numBodyBytes         Length of the request body.
+ * @param[out] response             Response.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidState   If the peripheral rejected a GATT request.
+ * @return kHAPError_InvalidData    If the response is malformed.
+ * @return kHAPError_OutOfResources If the response is too long.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+HAPError CentralTransact(
+        Central* central,
+        const CentralCharacteristic* characteristic,
+        HAPPDUOpcode opcode,
+        uint16_t iid,
+        const void* _Nullable bodyBytes,
+        size_t numBodyBytes,
+        CentralResponse* response);
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull end
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,446 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+// Drives a BLE accessory server through the socket of the POSIX BLE peripheral manager.
+//
+// 1. Fetch the advertisement, connect and discover the GATT database.
+// 2. For every ATT_MTU, reconnect and run HAP-Characteristic-Signature-Read procedures
+//    on all HAP characteristics round-robin. GATT requests per procedure are counted.
+// 3. Reconnect for every Pair Verify M1 and measure the time until M2 has been read.
+//    Pair Verify is not completed, so this also works with an unpaired accessory.
+//
+// Results are printed as one JSON object per line. Latencies are in microseconds.
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Central.h"
+
+/** Maximum number of ATT_MTUs. */
+#define kMaxMTUs ((size_t) 8)
+
+/** Maximum number of HAP characteristics. */
+#define kMaxCharacteristics ((size_t) 128)
+
+/** Number of connection attempts while the accessory server has not resumed advertising. */
+#define kMaxConnectAttempts ((size_t) 100)
+
+/**
+ * Options.
+ */
+typedef struct {
+    const char* socketPath;
+    uint16_t mtus[kMaxMTUs];
+    size_t numMTUs;
+    size_t numReads;
+    size_t numPairVerifies;
+    int timeout;
+} Options;
+
+/**
+ * Latency samples of a phase.
+ */
+typedef struct {
+    uint32_t* samples;
+    size_t numSamples;
+    size_t numErrors;
+} Statistics;
+
+/**
+ * Gets the current time of a monotonic clock.
+ *
+ * @return Current time in microseconds.
+ */
+HAP_RESULT_USE_CHECK
+static uint64_t GetMicroseconds(void) {
+    struct timespec t;
+    int e = clock_gettime(CLOCK_MONOTONIC, &t);
+    HAPAssert(!e);
+    return (uint64_t) t.tv_sec * 1000000 + (uint64_t) t.tv_nsec / 1000;
+}
+
+static void PrintUsage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "\n"
+            "Options:\n"
+            "  --socket=<path>                BLE peripheral manager socket. Default: %s.\n"
+            "  --mtu=<n>,...                  ATT_MTUs to measure (%u-%u). Default: 23,185,517.\n"
+            "  --reads=<n>                    Signature reads per ATT_MTU. Default: 1000.\n"
+            "  --pair-verifies=<n>            Pair Verify M1 / M2 exchanges. Default: 100.\n"
+            "  --timeout=<ms>                 Maximum time to wait for a response. Default: 5000.\n",
+            program,
+            kHAPPlatformBLEPeripheralManagerSocket_DefaultPath,
+            kHAPPlatformBLEPeripheralManagerSocket_DefaultMTU,
+            kHAPPlatformBLEPeripheralManagerSocket_MaxMTU);
+}
+
+/**
+ * Parses an unsigned decimal number.
+ *
+ * @return true                     If successful.
+ * @return false                    If the string is not a number or the number is out of range.
+ */
+HAP_RESULT_USE_CHECK
+static bool ParseNumber(const char* string, unsigned long minValue, unsigned long maxValue, unsigned long* value) {
+    char* end;
+    *value = strtoul(string, &end, 10);
+    return end != string && !*end && *value >= minValue && *value <= maxValue;
+}
+
+/**
+ * Parses a comma separated list of ATT_MTUs.
+ *
+ * @return true                     If successful.
+ * @return false                    If the list is malformed.
+ */
+HAP_RESULT_USE_CHECK
+static bool ParseMTUs(const char* string, Options* options) {
+    options->numMTUs = 0;
+    while (*string) {
+        char* end;
+        unsigned long mtu = strtoul(string, &end, 10);
+        if (end == string || mtu < kHAPPlatformBLEPeripheralManagerSocket_DefaultMTU ||
+            mtu > kHAPPlatformBLEPeripheralManagerSocket_MaxMTU || (*end && *end != ',') ||
+            options->numMTUs == kMaxMTUs) {
+            return false;
+        }
+        options->mtus[options->numMTUs++] = (uint16_t) mtu;
+        string = *end ? end + 1 : end;
+    }
+    return options->numMTUs != 0;
+}
+
+/**
+ * Parses the command line.
+ *
+ * @return true                     If successful.
+ * @return false                    If the command line is invalid.
+ */
+HAP_RESULT_USE_CHECK
+static bool ParseOptions(int argc, char* argv[], Options* options) {
+    HAPRawBufferZero(options, sizeof *options);
+    options->socketPath = kHAPPlatformBLEPeripheralManagerSocket_DefaultPath;
+    options->mtus[0] = 23;
+    options->mtus[1] = 185;
+    options->mtus[2] = 517;
+    options->numMTUs = 3;
+    options->numReads = 1000;
+    options->numPairVerifies = 100;
+    options->timeout = 5000;
+
+    for (int i = 1; i < argc; i++) {
+        const char* argument = argv[i];
+        const char* value = strchr(argument, '=');
+        if (!value) {
+            return false;
+        }
+        size_t numNameBytes = (size_t)(value - argument);
+        value++;
+#define IS_OPTION(name) (numNameBytes == sizeof(name) - 1 && !strncmp(argument, (name), numNameBytes))
+        unsigned long number;
+        if (IS_OPTION("--socket")) {
+            options->socketPath = value;
+        } else if (IS_OPTION("--mtu")) {
+            if (!ParseMTUs(value, options)) {
+                return false;
+            }
+        } else if (IS_OPTION("--reads")) {
+            if (!ParseNumber(value, 0, 10000000, &number)) {
+                return false;
+            }
+            options->numReads = number;
+        } else if (IS_OPTION("--pair-verifies")) {
+            if (!ParseNumber(value, 0, 100000, &number)) {
+                return false;
+            }
+            options->numPairVerifies = number;
+        } else if (IS_OPTION("--timeout")) {
+            if (!ParseNumber(value, 1, 3600000, &number)) {
+                return false;
+            }
+            options->timeout = (int) number;
+        } else {
+            return false;
+        }
+#undef IS_OPTION
+    }
+    return true;
+}
+
+static int CompareSamples(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*) a;
+    uint32_t y = *(const uint32_t*) b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/**
+ * Prints the latency distribution of a set of samples. The closing brace is left to the caller.
+ */
+static void PrintStatistics(const char* phase, unsigned int mtu, Statistics* statistics) {
+    qsort(statistics->samples, statistics->numSamples, sizeof statistics->samples[0], CompareSamples);
+    printf("{\"phase\":\"%s\",\"mtu\":%u,\"count\":%lu,\"errors\":%lu",
+           phase,
+           mtu,
+           (unsigned long) statistics->numSamples,
+           (unsigned long) statistics->numErrors);
+    if (statistics->numSamples) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < statistics->numSamples; i++) {
+            sum += statistics->samples[i];
+        }
+        size_t n = statistics->numSamples;
+        printf(",\"meanUs\":%llu,\"p50Us\":%lu,\"p90Us\":%lu,\"p99Us\":%lu,\"maxUs\":%lu",
+               (unsigned long long) (sum / n),
+               (unsigned long) statistics->samples[n * 50 / 100],
+               (unsigned long) statistics->samples[n * 90 / 100],
+               (unsigned long) statistics->samples[n * 99 / 100],
+               (unsigned long) statistics->samples[n - 1]);
+    }
+}
+
+/**
+ * Opens the socket and connects. Retries while the accessory server has not resumed advertising.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If the connection could not be established.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError Connect(Central* central, const Options* options, uint16_t mtu) {
+    HAPError err;
+
+    for (size_t i = 0; i < kMaxConnectAttempts; i++) {
+        err = CentralOpen(central, options->socketPath);
+        if (err) {
+            return err;
+        }
+        err = CentralConnect(central, mtu);
+        if (err != kHAPError_InvalidState) {
+            if (err) {
+                CentralClose(central);
+            }
+            return err;
+        }
+        CentralClose(central);
+        (void) poll(NULL, 0, 10);
+    }
+    fprintf(stderr, "Accessory server is not connectable.\n");
+    return kHAPError_Unknown;
+}
+
+int main(int argc, char* argv[]) {
+    HAPError err;
+
+    Options options;
+    if (!ParseOptions(argc, argv, &options)) {
+        PrintUsage(argc ? argv[0] : "BLEController");
+        return EXIT_FAILURE;
+    }
+
+    Central* central = calloc(1, sizeof *central);
+    CentralResponse* response = calloc(1, sizeof *response);
+    CentralCharacteristic* characteristics = calloc(kMaxCharacteristics, sizeof *characteristics);
+    size_t maxSamples = HAPMax(options.numReads, options.numPairVerifies);
+    Statistics statistics = { .samples = calloc(maxSamples ? maxSamples : 1, sizeof(uint32_t)) };
+    if (!central || !response || !characteristics || !statistics.samples) {
+        fprintf(stderr, "Out of memory.\n");
+        return EXIT_FAILURE;
+    }
+
+    CentralCreate(central, options.timeout);
+
+    // Advertisement, connection and discovery.
+    size_t numCharacteristics;
+    {
+        err = CentralOpen(central, options.socketPath);
+        if (err) {
+            fprintf(stderr, "Failed to open %s. Is a BLE accessory server running?\n", options.socketPath);
+            return EXIT_FAILURE;
+        }
+        HAPBLEAdvertisingInterval advertisingInterval;
+        uint8_t advertisingBytes[31];
+        size_t numAdvertisingBytes;
+        err = CentralGetAdvertisement(central, &advertisingInterval, advertisingBytes, &numAdvertisingBytes);
+        if (err) {
+            fprintf(stderr, "Failed to fetch advertisement.\n");
+            return EXIT_FAILURE;
+        }
+        CentralClose(central);
+        printf("{\"phase\":\"advertisement\",\"intervalMs\":%.1f,\"bytes\":%lu}\n",
+               (double) HAPBLEAdvertisingIntervalGetMilliseconds(advertisingInterval),
+               (unsigned long) numAdvertisingBytes);
+
+        uint64_t startTime = GetMicroseconds();
+        err = Connect(central, &options, kHAPPlatformBLEPeripheralManagerSocket_MaxMTU);
+        if (err) {
+            return EXIT_FAILURE;
+        }
+        uint64_t connectTime = GetMicroseconds();
+        err = CentralDiscover(central);
+        if (!err) {
+            err = CentralGetCharacteristics(central, characteristics, kMaxCharacteristics, &numCharacteristics);
+        }
+        if (err) {
+            fprintf(stderr, "Discovery failed: %u.\n", err);
+            return EXIT_FAILURE;
+        }
+        printf("{\"phase\":\"discovery\",\"attributes\":%lu,\"characteristics\":%lu,\"gattRequests\":%lu,"
+               "\"connectUs\":%llu,\"discoveryUs\":%llu}\n",
+               (unsigned long) central->numAttributes,
+               (unsigned long) numCharacteristics,
+               (unsigned long) central->numGATTRequests,
+               (unsigned long long) (connectTime - startTime),
+               (unsigned long long) (GetMicroseconds() - connectTime));
+        fflush(stdout);
+        CentralClose(central);
+        if (!numCharacteristics) {
+            fprintf(stderr, "No HAP characteristics found.\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    // HAP-Characteristic-Signature-Read throughput.
+    for (size_t m = 0; m < options.numMTUs; m++) {
+        err = Connect(central, &options, options.mtus[m]);
+        if (err) {
+            return EXIT_FAILURE;
+        }
+        statistics.numSamples = 0;
+        statistics.numErrors = 0;
+        size_t numBodyBytes = 0;
+        size_t numGATTRequests = central->numGATTRequests;
+        uint64_t startTime = GetMicroseconds();
+        for (size_t i = 0; i < options.numReads; i++) {
+            const CentralCharacteristic* characteristic = &characteristics[i % numCharacteristics];
+            uint64_t requestTime = GetMicroseconds();
+            err = CentralTransact(
+                    central,
+                    characteristic,
+                    kHAPPDUOpcode_CharacteristicSignatureRead,
+                    characteristic->iid,
+                    NULL,
+                    0,
+                    response);
+            if (err == kHAPError_Unknown) {
+                fprintf(stderr, "Connection failed.\n");
+                return EXIT_FAILURE;
+            }
+            if (err || response->status != kHAPBLEPDUStatus_Success) {
+                statistics.numErrors++;
+                continue;
+            }
+            statistics.samples[statistics.numSamples++] = (uint32_t)(GetMicroseconds() - requestTime);
+            numBodyBytes += response->numBytes;
+        }
+        uint64_t duration = GetMicroseconds() - startTime;
+        numGATTRequests = central->numGATTRequests - numGATTRequests;
+        PrintStatistics("signatureRead", central->mtu, &statistics);
+        printf(",\"gattRequestsPerRead\":%.2f,\"bodyBytesPerSecond\":%.0f,\"readsPerSecond\":%.1f}\n",
+               options.numReads ? (double) numGATTRequests / (double) options.numReads : 0.0,
+               duration ? (double) numBodyBytes * 1e6 / (double) duration : 0.0,
+               duration ? (double) options.numReads * 1e6 / (double) duration : 0.0);
+        fflush(stdout);
+        CentralClose(central);
+    }
+
+    // Pair Verify M1 / M2 round trip.
+    const CentralCharacteristic* pairVerify = NULL;
+    for (size_t i = 0; i < numCharacteristics; i++) {
+        if (HAPUUIDAreEqual(&characteristics[i].type, &kHAPCharacteristicType_PairVerify)) {
+            pairVerify = &characteristics[i];
+        }
+    }
+    if (pairVerify && options.numPairVerifies) {
+        statistics.numSamples = 0;
+        statistics.numErrors = 0;
+        uint16_t mtu = kHAPPlatformBLEPeripheralManagerSocket_MaxMTU;
+        for (size_t i = 0; i < options.numPairVerifies; i++) {
+            err = Connect(central, &options, kHAPPlatformBLEPeripheralManagerSocket_MaxMTU);
+            if (err) {
+                return EXIT_FAILURE;
+            }
+            mtu = central->mtu;
+
+            // M1: Verify Start Request.
+            uint8_t cvSK[X25519_SCALAR_BYTES];
+            uint8_t cvPK[X25519_BYTES];
+            HAPPlatformRandomNumberFill(cvSK, sizeof cvSK);
+            HAP_X25519_scalarmult_base(cvPK, cvSK);
+            uint8_t pairingBytes[3 + 2 + X25519_BYTES];
+            uint8_t bodyBytes[2 + sizeof pairingBytes + 3];
+            {
+                const uint8_t state = 1;
+                HAPTLVWriterRef writer;
+                HAPTLVWriterCreate(&writer, pairingBytes, sizeof pairingBytes);
+                err = HAPTLVWriterAppend(
+                        &writer,
+                        &(const HAPTLV) { .type = kHAPPairingTLVType_State,
+                                          .value = { .bytes = &state, .numBytes = sizeof state } });
+                HAPAssert(!err);
+                err = HAPTLVWriterAppend(
+                        &writer,
+                        &(const HAPTLV) { .type = kHAPPairingTLVType_PublicKey,
+                                          .value = { .bytes = cvPK, .numBytes = sizeof cvPK } });
+                HAPAssert(!err);
+                void* pairingTLVBytes;
+                size_t numPairingTLVBytes;
+                HAPTLVWriterGetBuffer(&writer, &pairingTLVBytes, &numPairingTLVBytes);
+
+                const uint8_t returnResponse = 1;
+                HAPTLVWriterCreate(&writer, bodyBytes, sizeof bodyBytes);
+                err = HAPTLVWriterAppend(
+                        &writer,
+                        &(const HAPTLV) { .type = kHAPBLEPDUTLVType_Value,
+                                          .value = { .bytes = pairingTLVBytes, .numBytes = numPairingTLVBytes } });
+                HAPAssert(!err);
+                err = HAPTLVWriterAppend(
+                        &writer,
+                        &(const HAPTLV) { .type = kHAPBLEPDUTLVType_ReturnResponse,
+                                          .value = { .bytes = &returnResponse, .numBytes = sizeof returnResponse } });
+                HAPAssert(!err);
+                void* bytes;
+                size_t numBytes;
+                HAPTLVWriterGetBuffer(&writer, &bytes, &numBytes);
+                HAPAssert(bytes == bodyBytes && numBytes == sizeof bodyBytes);
+            }
+
+            // M2: Verify Start Response.
+            uint64_t requestTime = GetMicroseconds();
+            err = CentralTransact(
+                    central,
+                    pairVerify,
+                    kHAPPDUOpcode_CharacteristicWrite,
+                    pairVerify->iid,
+                    bodyBytes,
+                    sizeof bodyBytes,
+                    response);
+            uint32_t latency = (uint32_t)(GetMicroseconds() - requestTime);
+            if (err || response->status != kHAPBLEPDUStatus_Success || !response->numBytes) {
+                statistics.numErrors++;
+            } else {
+                statistics.samples[statistics.numSamples++] = latency;
+            }
+            CentralClose(central);
+        }
+        PrintStatistics("pairVerifyM1M2", mtu, &statistics);
+        printf("}\n");
+        fflush(stdout);
+    }
+
+    printf("{\"phase\":\"total\",\"gattRequests\":%lu,\"indications\":%lu}\n",
+           (unsigned long) central->numGATTRequests,
+           (unsigned long) central->numIndications);
+    fflush(stdout);
+
+    free(statistics.samples);
+    free(characteristics);
+    free(response);
+    free(central);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,473 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+// Replays a HAP over IP session traffic capture against the Lightbulb application on the Mock PAL.
+//
+// Captures are recorded by accessories that are built with USE_IP_CAPTURE=1. Each captured session is replayed
+// over a separate connection of the Mock TCP stream manager. Its security session is established with fixed session
+// keys as if Pair Verify had completed, and the captured requests are encrypted and sent in their original order.
+// The Mock clock is advanced by the captured delay before each record, so that timers such as the event notification
+// coalescing and the maximum idle time behave as they did on the accessory. Responses and event notifications are
+// received and decrypted, but not checked.
+//
+// Usage: CaptureReplay [--iterations=<n>] <capture file>
+//
+// Results are printed as one JSON object per iteration. Build with BUILD_TYPE=Release to measure without logging.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "HAP+Internal.h"
+
+// Tools are not compiled against the Mock PAL, so the Mock PAL headers are not on the include path.
+#include "../../PAL/Mock/HAPPlatform+Init.h"
+
+#include "../../Applications/Lightbulb/App.c"
+#include "../../Applications/Lightbulb/DB.c"
+
+/** Maximum number of concurrently replayed sessions. Limited by the number of Mock TCP streams. */
+#define kMaxSessions ((size_t) kHAPIPSessionStorage_DefaultNumElements)
+
+/** Maximum number of plaintext bytes that are encrypted at once. */
+#define kMaxPlaintextBytes ((size_t) 4096)
+
+/** Maximum number of iterations. */
+#define kMaxIterations ((size_t) 10000)
+
+/**
+ * Replayed session.
+ */
+typedef struct {
+    /** Capture session ID. 0 if unused. */
+    uint16_t captureSessionID;
+
+    /** Whether or not the accessory server has closed the connection. */
+    bool isClosedByServer;
+
+    /** Connection to the accessory server. */
+    HAPPlatformTCPStreamRef tcpStream;
+
+    /** Controller side of the security session. */
+    HAPSessionRef session;
+
+    /** Received bytes. Frames that have not been received completely are kept at the start. */
+    uint8_t bytes[8 * 1024];
+
+    /** Number of received bytes. */
+    size_t numBytes;
+} Session;
+
+/** Replayed sessions. */
+static Session sessions[kMaxSessions];
+
+/** Replay statistics of one iteration. */
+static struct {
+    size_t numSessions;
+    size_t numRequestRecords;
+    size_t numRequestBytes;
+    size_t numResponseBytes;
+    size_t numDroppedRecords;
+    size_t numSessionsClosedByServer;
+    uint64_t virtualDuration;
+} stats;
+
+/** Accessory server. */
+static HAPAccessoryServerRef accessoryServer;
+
+/** Accessory server that is used for controller side encryption. Does not record metrics. */
+static HAPAccessoryServerRef controllerServer;
+
+/** Performance metrics of the accessory server. */
+static HAPAccessoryServerMetrics metrics;
+
+/**
+ * Aborts the replay if a condition does not hold.
+ *
+ * - HAPAssert is compiled out in Release builds.
+ */
+static void Expect(bool condition, const char* description) {
+    if (!condition) {
+        fprintf(stderr, "Replay failed: %s\n", description);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static uint64_t GetNanoseconds(void) {
+    struct timespec t;
+    int e = clock_gettime(CLOCK_MONOTONIC, &t);
+    Expect(!e, "clock_gettime failed.");
+    return (uint64_t) t.tv_sec * 1000000000 + (uint64_t) t.tv_nsec;
+}
+
+/**
+ * Finds the replayed session of a capture session.
+ *
+ * @param      captureSessionID     Capture session ID. 0 to find an unused session.
+ *
+ * @return Replayed session, or NULL if not found.
+ */
+HAP_RESULT_USE_CHECK
+static Session* _Nullable FindSession(uint16_t captureSessionID) {
+    for (size_t i = 0; i < HAPArrayCount(sessions); i++) {
+        if (sessions[i].captureSessionID == captureSessionID) {
+            return &sessions[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Releases a replayed session and closes its connection.
+ */
+static void CloseSession(Session* session) {
+    HAPPlatformTCPStreamManagerClientClose(HAPNonnull(platform.ip.tcpStreamManager), session->tcpStream);
+    HAPRawBufferZero(session, sizeof *session);
+}
+
+/**
+ * Receives and decrypts all data that is available on the connections of the replayed sessions.
+ *
+ * @return true                     If any data has been received.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool ReceiveResponses(void) {
+    HAPError err;
+
+    bool hasProgress = false;
+    for (size_t i = 0; i < HAPArrayCount(sessions); i++) {
+        Session* session = &sessions[i];
+        if (!session->captureSessionID || session->isClosedByServer) {
+            continue;
+        }
+        for (;;) {
+            size_t numBytes;
+            err = HAPPlatformTCPStreamClientRead(
+                    HAPNonnull(platform.ip.tcpStreamManager),
+                    session->tcpStream,
+                    &session->bytes[session->numBytes],
+                    sizeof session->bytes - session->numBytes,
+                    &numBytes);
+            if (err == kHAPError_Busy) {
+                break;
+            }
+            hasProgress = true;
+            if (err || !numBytes) {
+                session->isClosedByServer = true;
+                stats.numSessionsClosedByServer++;
+                break;
+            }
+            session->numBytes += numBytes;
+
+            HAPIPByteBuffer buffer = { .data = (char*) session->bytes,
+                                       .capacity = sizeof session->bytes,
+                                       .limit = session->numBytes };
+            err = HAPIPSecurityProtocolDecryptData(&controllerServer, &session->session, &buffer);
+            Expect(!err, "Decryption failed.");
+            stats.numResponseBytes += buffer.position;
+            HAPRawBufferCopyBytes(session->bytes, &session->bytes[buffer.position], buffer.limit - buffer.position);
+            session->numBytes = buffer.limit - buffer.position;
+        }
+    }
+    return hasProgress;
+}
+
+/**
+ * Lets the accessory server process all pending input and receives its responses.
+ */
+static void Synchronize(void) {
+    do {
+        HAPPlatformClockAdvance(0);
+    } while (ReceiveResponses());
+}
+
+/**
+ * Connects a replayed session and establishes its security session as if Pair Verify had completed.
+ */
+static void OpenSession(Session* session, uint16_t captureSessionID) {
+    HAPError err;
+
+    HAPRawBufferZero(session, sizeof *session);
+    err = HAPPlatformTCPStreamManagerConnectToListener(HAPNonnull(platform.ip.tcpStreamManager), &session->tcpStream);
+    Expect(!err, "Connection failed.");
+    HAPPlatformClockAdvance(0);
+
+    HAPAccessoryServer* server = (HAPAccessoryServer*) &accessoryServer;
+    HAPIPSessionDescriptor* descriptor = NULL;
+    for (size_t i = 0; i < HAPNonnull(server->ip.storage)->numSessions; i++) {
+        HAPIPSessionDescriptor* t =
+                (HAPIPSessionDescriptor*) &HAPNonnull(server->ip.storage)->sessions[i].descriptor;
+        if (t->tcpStreamIsOpen && t->tcpStream == session->tcpStream) {
+            descriptor = t;
+        }
+    }
+    Expect(descriptor && descriptor->securitySession.isOpen, "Connection not accepted.");
+    HAPSession* accessorySession = (HAPSession*) &HAPNonnull(descriptor)->securitySession._.hap;
+    HAPSession* controllerSession = (HAPSession*) &session->session;
+    accessorySession->hap.active = true;
+    accessorySession->hap.pairingID = 0;
+    controllerSession->hap.active = true;
+    for (size_t i = 0; i < sizeof(HAPSessionKey); i++) {
+        accessorySession->hap.controllerToAccessory.controlChannel.key.bytes[i] = (uint8_t)(captureSessionID + i);
+        accessorySession->hap.accessoryToController.controlChannel.key.bytes[i] = (uint8_t)(0x80 + captureSessionID + i);
+        // The controller encrypts with the keys of the opposite direction.
+        controllerSession->hap.accessoryToController.controlChannel.key.bytes[i] = (uint8_t)(captureSessionID + i);
+        controllerSession->hap.controllerToAccessory.controlChannel.key.bytes[i] =
+                (uint8_t)(0x80 + captureSessionID + i);
+    }
+    session->captureSessionID = captureSessionID;
+    stats.numSessions++;
+}
+
+/**
+ * Encrypts captured request data and sends it to the accessory server.
+ */
+static void SendData(Session* session, const uint8_t* bytes, size_t numBytes) {
+    HAPError err;
+
+    static uint8_t encryptedBytes[kMaxPlaintextBytes + (kMaxPlaintextBytes / kHAPIPSecurityProtocol_MaxFrameBytes + 1) *
+                                                                (2 + CHACHA20_POLY1305_TAG_BYTES)];
+    while (numBytes && !session->isClosedByServer) {
+        size_t numPlaintextBytes = HAPMin(numBytes, kMaxPlaintextBytes);
+        HAPAssert(HAPIPSecurityProtocolGetNumEncryptedBytes(numPlaintextBytes) <= sizeof encryptedBytes);
+        HAPRawBufferCopyBytes(encryptedBytes, bytes, numPlaintextBytes);
+        HAPIPByteBuffer buffer = { .data = (char*) encryptedBytes,
+                                   .capacity = sizeof encryptedBytes,
+                                   .limit = numPlaintextBytes };
+        HAPIPSecurityProtocolEncryptData(&controllerServer, &session->session, &buffer);
+
+        // The Mock TCP stream buffers are small, so the accessory server has to consume data in between.
+        size_t o = 0;
+        while (o < buffer.limit && !session->isClosedByServer) {
+            size_t numBytesWritten;
+            err = HAPPlatformTCPStreamClientWrite(
+                    HAPNonnull(platform.ip.tcpStreamManager),
+                    session->tcpStream,
+                    &encryptedBytes[o],
+                    buffer.limit - o,
+                    &numBytesWritten);
+            if (err == kHAPError_Busy) {
+                numBytesWritten = 0;
+            } else {
+                Expect(!err, "Request could not be written.");
+            }
+            o += numBytesWritten;
+            Synchronize();
+        }
+        bytes += numPlaintextBytes;
+        numBytes -= numPlaintextBytes;
+    }
+}
+
+/**
+ * Replays all records of a capture once.
+ */
+static void Replay(const uint8_t* bytes, size_t numBytes) {
+    HAPError err;
+
+    size_t offset = kHAPIPCapture_NumHeaderBytes;
+    for (;;) {
+        bool found;
+        HAPIPCaptureRecord record;
+        err = HAPIPCaptureGetNextRecord(bytes, numBytes, &offset, &found, &record);
+        Expect(!err, "Capture is malformed.");
+        if (!found) {
+            break;
+        }
+
+        HAPPlatformClockAdvance((HAPTime) record.delay * HAPMillisecond);
+        stats.virtualDuration += (uint64_t) record.delay * HAPMillisecond;
+        Synchronize();
+
+        Session* _Nullable session = FindSession(record.sessionID);
+        switch (record.type) {
+            case kHAPIPCaptureRecordType_Open: {
+                Expect(!session, "Capture session ID is reused while the session is open.");
+                session = FindSession(0);
+                if (!session) {
+                    stats.numDroppedRecords++;
+                    break;
+                }
+                OpenSession(HAPNonnull(session), record.sessionID);
+            } break;
+            case kHAPIPCaptureRecordType_Data: {
+                if (!session || HAPNonnull(session)->isClosedByServer) {
+                    stats.numDroppedRecords++;
+                    break;
+                }
+                stats.numRequestRecords++;
+                stats.numRequestBytes += record.numBytes;
+                SendData(HAPNonnull(session), HAPNonnull(record.bytes), record.numBytes);
+            } break;
+            case kHAPIPCaptureRecordType_Close: {
+                if (!session) {
+                    stats.numDroppedRecords++;
+                    break;
+                }
+                CloseSession(HAPNonnull(session));
+            } break;
+        }
+        Synchronize();
+    }
+
+    // Close sessions that were still open at the end of the capture.
+    for (size_t i = 0; i < HAPArrayCount(sessions); i++) {
+        if (sessions[i].captureSessionID) {
+            CloseSession(&sessions[i]);
+        }
+    }
+    Synchronize();
+}
+
+static void HandleUpdatedAccessoryServerState(HAPAccessoryServerRef* server, void* _Nullable context) {
+    AccessoryServerHandleUpdatedState(server, context);
+}
+
+HAP_RESULT_USE_CHECK
+static bool HasPrefix(const char* string, const char* prefix) {
+    return strncmp(string, prefix, HAPStringGetNumBytes(prefix)) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    HAPError err;
+
+    size_t numIterations = 1;
+    const char* _Nullable path = NULL;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool isValid;
+        if (HasPrefix(arg, "--iterations=")) {
+            uint64_t value;
+            err = HAPUInt64FromString(&arg[sizeof "--iterations=" - 1], &value);
+            isValid = !err && value >= 1 && value <= kMaxIterations;
+            numIterations = (size_t) value;
+        } else {
+            isValid = !path && !HasPrefix(arg, "--");
+            path = arg;
+        }
+        if (!isValid) {
+            path = NULL;
+            break;
+        }
+    }
+    if (!path) {
+        fprintf(stderr,
+                "Usage: %s [--iterations=1...%lu] <capture file>\n",
+                argc ? argv[0] : "CaptureReplay",
+                (unsigned long) kMaxIterations);
+        return EXIT_FAILURE;
+    }
+
+    // Read capture.
+    FILE* file = fopen(HAPNonnull(path), "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s.\n", path);
+        return EXIT_FAILURE;
+    }
+    size_t numBytes = 0;
+    size_t maxBytes = 64 * 1024;
+    uint8_t* bytes = malloc(maxBytes);
+    Expect(bytes, "Out of memory.");
+    for (;;) {
+        numBytes += fread(&bytes[numBytes], 1, maxBytes - numBytes, file);
+        if (numBytes < maxBytes) {
+            break;
+        }
+        maxBytes *= 2;
+        bytes = realloc(bytes, maxBytes);
+        Expect(bytes, "Out of memory.");
+    }
+    Expect(!ferror(file), "Failed to read capture.");
+    fclose(file);
+    err = HAPIPCaptureValidateHeader(bytes, numBytes);
+    if (err) {
+        fprintf(stderr, "%s is not a supported capture file.\n", path);
+        return EXIT_FAILURE;
+    }
+
+    HAPPlatformCreate();
+
+    // Prepare accessory server storage.
+    static HAPIPSession ipSessions[kMaxSessions];
+    static HAPIPSessionSlotRef ipSessionSlots[HAPArrayCount(ipSessions)];
+    static uint8_t ipInboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultInboundBufferSize];
+    static uint8_t ipOutboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultOutboundBufferSize];
+    static HAPIPEventNotificationRef ipEventNotifications[HAPArrayCount(ipSessions)][kAttributeCount];
+    for (size_t i = 0; i < HAPArrayCount(ipSessions); i++) {
+        ipSessions[i].inboundBuffer.bytes = ipInboundBuffers[i];
+        ipSessions[i].inboundBuffer.numBytes = sizeof ipInboundBuffers[i];
+        ipSessions[i].outboundBuffer.bytes = ipOutboundBuffers[i];
+        ipSessions[i].outboundBuffer.numBytes = sizeof ipOutboundBuffers[i];
+        ipSessions[i].eventNotifications = ipEventNotifications[i];
+        ipSessions[i].numEventNotifications = HAPArrayCount(ipEventNotifications[i]);
+    }
+    static HAPIPReadContextRef ipReadContexts[kAttributeCount];
+    static HAPIPWriteContextRef ipWriteContexts[kAttributeCount];
+    static uint8_t ipScratchBuffer[kHAPIPSession_DefaultScratchBufferSize];
+    static HAPIPAccessoryServerStorage ipAccessoryServerStorage = {
+        .sessions = ipSessions,
+        .numSessions = HAPArrayCount(ipSessions),
+        .sessionSlots = ipSessionSlots,
+        .readContexts = ipReadContexts,
+        .numReadContexts = HAPArrayCount(ipReadContexts),
+        .writeContexts = ipWriteContexts,
+        .numWriteContexts = HAPArrayCount(ipWriteContexts),
+        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer }
+    };
+
+    // Initialize and start accessory server.
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ip = { .transport = &kHAPAccessoryServerTransport_IP,
+                            .accessoryServerStorage = &ipAccessoryServerStorage },
+                    .metrics = &metrics },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+    AppCreate(&accessoryServer, platform.keyValueStore);
+    AppAccessoryServerStart();
+    HAPPlatformClockAdvance(0);
+    Expect(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running, "Server not running.");
+
+    // Register the admin pairing that is used by all replayed sessions.
+    uint8_t pairingBytes[sizeof(HAPPairingID) + sizeof(uint8_t) + sizeof(HAPPairingPublicKey) + sizeof(uint8_t)];
+    HAPRawBufferZero(pairingBytes, sizeof pairingBytes);
+    pairingBytes[sizeof(HAPPairingID)] = 1;
+    pairingBytes[sizeof pairingBytes - 1] = 0x01;
+    err = HAPPlatformKeyValueStoreSet(
+            platform.keyValueStore, kHAPKeyValueStoreDomain_Pairings, 0, pairingBytes, sizeof pairingBytes);
+    Expect(!err, "Pairing could not be stored.");
+
+    for (size_t i = 0; i < numIterations; i++) {
+        HAPRawBufferZero(&stats, sizeof stats);
+        HAPAccessoryServerMetrics startMetrics = metrics;
+        uint64_t startTime = GetNanoseconds();
+        Replay(bytes, numBytes);
+        uint64_t totalNanoseconds = GetNanoseconds() - startTime;
+
+        printf("{\"tool\":\"CaptureReplay\",\"iteration\":%lu,\"numSessions\":%lu,\"numRequestRecords\":%lu,"
+               "\"numRequestBytes\":%lu,\"numResponseBytes\":%lu,\"numDroppedRecords\":%lu,"
+               "\"numSessionsClosedByServer\":%lu,",
+               (unsigned long) i,
+               (unsigned long) stats.numSessions,
+               (unsigned long) stats.numRequestRecords,
+               (unsigned long) stats.numRequestBytes,
+               (unsigned long) stats.numResponseBytes,
+               (unsigned long) stats.numDroppedRecords,
+               (unsigned long) stats.numSessionsClosedByServer);
+        printf("\"numEventNotifications\":%lu,\"virtualDurationMs\":%llu,\"wallTimeUs\":%.1f}\n",
+               (unsigned long) (metrics.eventNotifications.numSent - startMetrics.eventNotifications.numSent),
+               (unsigned long long) (stats.virtualDuration / HAPMillisecond),
+               (double) totalNanoseconds / 1e3);
+    }
+
+    free(bytes);
+    return 0;
+}
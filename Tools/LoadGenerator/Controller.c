@@ -0,0 +1,1377 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+// Controller side of the HAP IP transport: plain TCP connections, Pair Setup with a setup code, Pair Verify,
+// Add / Remove Pairing and the encrypted session framing of HomeKit Accessory Protocol Specification R14
+// Section 6.5.2 Session Security.
+
+#include <errno.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Controller.h"
+
+static const HAPLogObject logObject = { .subsystem = "com.apple.mfi.HomeKit.Tools", .category = "Controller" };
+
+/** Length of the length prefix of an encrypted frame. */
+#define kFrameLengthBytes ((size_t) 2)
+
+/** Maximum length of a serialized pairing request or response. */
+#define kMaxPairingTLVBytes ((size_t) 1024)
+
+/** SRP user name for Pair Setup. */
+static const uint8_t kPairSetupUserName[] = "Pair-Setup";
+
+/**
+ * Gets the current time of a monotonic clock.
+ *
+ * @return Current time in milliseconds.
+ */
+HAP_RESULT_USE_CHECK
+static uint64_t GetMilliseconds(void) {
+    struct timespec t;
+    int e = clock_gettime(CLOCK_MONOTONIC, &t);
+    HAPAssert(!e);
+    return (uint64_t) t.tv_sec * 1000 + (uint64_t) t.tv_nsec / 1000000;
+}
+
+void ControllerIdentityCreate(ControllerIdentity* identity) {
+    HAPPrecondition(identity);
+
+    HAPRawBufferZero(identity, sizeof *identity);
+
+    // Controllers use upper case UUIDs as their pairing identifier.
+    uint8_t uuid[16];
+    HAPPlatformRandomNumberFill(uuid, sizeof uuid);
+    HAPError err = HAPStringWithFormat(
+            identity->pairingID,
+            sizeof identity->pairingID,
+            "%02X%02X%02X%02X-%02X%02X-%02X%02X-%02X%02X-%02X%02X%02X%02X%02X%02X",
+            uuid[0],
+            uuid[1],
+            uuid[2],
+            uuid[3],
+            uuid[4],
+            uuid[5],
+            uuid[6],
+            uuid[7],
+            uuid[8],
+            uuid[9],
+            uuid[10],
+            uuid[11],
+            uuid[12],
+            uuid[13],
+            uuid[14],
+            uuid[15]);
+    HAPAssert(!err);
+
+    HAPPlatformRandomNumberFill(identity->ltsk, sizeof identity->ltsk);
+    HAP_ed25519_public_key(identity->ltpk, identity->ltsk);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+HAPError ConnectionOpen(Connection* connection, const struct sockaddr_in* address) {
+    HAPPrecondition(connection);
+    HAPPrecondition(address);
+
+    HAPRawBufferZero(connection, sizeof *connection);
+
+    connection->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (connection->fd == -1) {
+        int _errno = errno;
+        HAPLogError(&logObject, "socket failed: %d.", _errno);
+        return kHAPError_Unknown;
+    }
+    int e = connect(connection->fd, (const struct sockaddr*) address, sizeof *address);
+    if (e) {
+        int _errno = errno;
+        HAPLog(&logObject, "connect failed: %d.", _errno);
+        ConnectionClose(connection);
+        return kHAPError_Unknown;
+    }
+
+    // Requests are small and latency sensitive.
+    int optionValue = 1;
+    e = setsockopt(connection->fd, IPPROTO_TCP, TCP_NODELAY, &optionValue, sizeof optionValue);
+    if (e) {
+        int _errno = errno;
+        HAPLog(&logObject, "setsockopt TCP_NODELAY failed: %d.", _errno);
+    }
+    return kHAPError_None;
+}
+
+void ConnectionClose(Connection* connection) {
+    HAPPrecondition(connection);
+
+    if (connection->fd != -1) {
+        (void) close(connection->fd);
+        connection->fd = -1;
+    }
+    connection->isSecured = false;
+}
+
+/**
+ * Writes all bytes to a connection.
+ *
+ * @param      connection           Connection.
+ * @param      bytes                Bytes.
+ * @param      numBytes             Number of bytes.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError SendBytes(Connection* connection, const void* bytes, size_t numBytes) {
+    HAPPrecondition(connection);
+    HAPPrecondition(connection->fd != -1);
+    HAPPrecondition(bytes);
+
+    size_t numBytesWritten = 0;
+    while (numBytesWritten < numBytes) {
+        ssize_t n = send(
+                connection->fd, &((const uint8_t*) bytes)[numBytesWritten], numBytes - numBytesWritten, MSG_NOSIGNAL);
+        if (n < 0) {
+            int _errno = errno;
+            if (_errno == EINTR) {
+                continue;
+            }
+            HAPLog(&logObject, "send failed: %d.", _errno);
+            return kHAPError_Unknown;
+        }
+        numBytesWritten += (size_t) n;
+    }
+    return kHAPError_None;
+}
+
+HAPError ConnectionSendRequest(
+        Connection* connection,
+        const char* method,
+        const char* path,
+        const char* _Nullable contentType,
+        const void* _Nullable body,
+        size_t numBodyBytes) {
+    HAPPrecondition(connection);
+    HAPPrecondition(method);
+    HAPPrecondition(path);
+    HAPPrecondition(!numBodyBytes || body);
+
+    HAPError err;
+
+    char request[kConnection_MaxRequestBytes];
+    if (contentType) {
+        err = HAPStringWithFormat(
+                request,
+                sizeof request,
+                "%s %s HTTP/1.1\r\n"
+                "Content-Type: %s\r\n"
+                "Content-Length: %lu\r\n"
+                "\r\n",
+                method,
+                path,
+                contentType,
+                (unsigned long) numBodyBytes);
+    } else {
+        err = HAPStringWithFormat(request, sizeof request, "%s %s HTTP/1.1\r\n\r\n", method, path);
+    }
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        return err;
+    }
+    size_t numRequestBytes = HAPStringGetNumBytes(request);
+    if (numBodyBytes > sizeof request - numRequestBytes) {
+        return kHAPError_OutOfResources;
+    }
+    if (numBodyBytes) {
+        HAPRawBufferCopyBytes(&request[numRequestBytes], HAPNonnullVoid(body), numBodyBytes);
+        numRequestBytes += numBodyBytes;
+    }
+
+    if (!connection->isSecured) {
+        return SendBytes(connection, request, numRequestBytes);
+    }
+
+    // See HomeKit Accessory Protocol Specification R14
+    // Section 6.5.2 Session Security
+    uint8_t frame[kFrameLengthBytes + kHAPIPSecurityProtocol_MaxFrameBytes + CHACHA20_POLY1305_TAG_BYTES];
+    for (size_t position = 0; position < numRequestBytes;) {
+        size_t numFrameBytes = HAPMin(numRequestBytes - position, kHAPIPSecurityProtocol_MaxFrameBytes);
+        HAPWriteLittleUInt16(frame, numFrameBytes);
+        uint8_t nonce[] = { HAPExpandLittleUInt64(connection->controllerToAccessory.nonce) };
+        HAP_chacha20_poly1305_encrypt_aad(
+                &frame[kFrameLengthBytes + numFrameBytes],
+                &frame[kFrameLengthBytes],
+                (const uint8_t*) &request[position],
+                numFrameBytes,
+                frame,
+                kFrameLengthBytes,
+                nonce,
+                sizeof nonce,
+                connection->controllerToAccessory.key);
+        connection->controllerToAccessory.nonce++;
+
+        err = SendBytes(connection, frame, kFrameLengthBytes + numFrameBytes + CHACHA20_POLY1305_TAG_BYTES);
+        if (err) {
+            return err;
+        }
+        position += numFrameBytes;
+    }
+    return kHAPError_None;
+}
+
+/**
+ * Discards the message that has been returned last by ConnectionGetMessage.
+ *
+ * @param      connection           Connection.
+ */
+static void ConsumeMessage(Connection* connection) {
+    HAPPrecondition(connection);
+    HAPPrecondition(connection->numMessageBytes <= connection->numBytes);
+
+    if (!connection->numMessageBytes) {
+        return;
+    }
+    connection->numBytes -= connection->numMessageBytes;
+    HAPRawBufferCopyBytes(
+            connection->bytes, &connection->bytes[connection->numMessageBytes], connection->numBytes);
+    connection->numMessageBytes = 0;
+}
+
+HAPError ConnectionReceive(Connection* connection) {
+    HAPPrecondition(connection);
+    HAPPrecondition(connection->fd != -1);
+
+    ConsumeMessage(connection);
+
+    uint8_t bytes[4096];
+    ssize_t n;
+    do {
+        n = recv(connection->fd, bytes, sizeof bytes, 0);
+    } while (n == -1 && errno == EINTR);
+    if (n < 0) {
+        int _errno = errno;
+        HAPLog(&logObject, "recv failed: %d.", _errno);
+        return kHAPError_Unknown;
+    }
+    if (!n) {
+        return kHAPError_InvalidState;
+    }
+    size_t numBytes = (size_t) n;
+
+    if (!connection->isSecured) {
+        if (numBytes > sizeof connection->bytes - connection->numBytes) {
+            HAPLog(&logObject, "Message exceeds %lu bytes.", (unsigned long) sizeof connection->bytes);
+            return kHAPError_OutOfResources;
+        }
+        HAPRawBufferCopyBytes(&connection->bytes[connection->numBytes], bytes, numBytes);
+        connection->numBytes += numBytes;
+        return kHAPError_None;
+    }
+
+    // Reassemble and decrypt frames.
+    for (size_t i = 0; i < numBytes;) {
+        size_t numFrameBytes = 0;
+        size_t numMissingBytes = kFrameLengthBytes - connection->numFrameBytes;
+        if (connection->numFrameBytes >= kFrameLengthBytes) {
+            numFrameBytes = HAPReadLittleUInt16(connection->frameBytes);
+            if (numFrameBytes > kHAPIPSecurityProtocol_MaxFrameBytes) {
+                HAPLog(&logObject, "Frame length %lu exceeds maximum.", (unsigned long) numFrameBytes);
+                return kHAPError_InvalidData;
+            }
+            numMissingBytes =
+                    kFrameLengthBytes + numFrameBytes + CHACHA20_POLY1305_TAG_BYTES - connection->numFrameBytes;
+        }
+        size_t numCopiedBytes = HAPMin(numMissingBytes, numBytes - i);
+        HAPRawBufferCopyBytes(&connection->frameBytes[connection->numFrameBytes], &bytes[i], numCopiedBytes);
+        connection->numFrameBytes += numCopiedBytes;
+        i += numCopiedBytes;
+        if (connection->numFrameBytes <= kFrameLengthBytes ||
+            connection->numFrameBytes < kFrameLengthBytes + numFrameBytes + CHACHA20_POLY1305_TAG_BYTES) {
+            continue;
+        }
+
+        if (numFrameBytes > sizeof connection->bytes - connection->numBytes) {
+            HAPLog(&logObject, "Message exceeds %lu bytes.", (unsigned long) sizeof connection->bytes);
+            return kHAPError_OutOfResources;
+        }
+        uint8_t nonce[] = { HAPExpandLittleUInt64(connection->accessoryToController.nonce) };
+        int e = HAP_chacha20_poly1305_decrypt_aad(
+                &connection->frameBytes[kFrameLengthBytes + numFrameBytes],
+                &connection->bytes[connection->numBytes],
+                &connection->frameBytes[kFrameLengthBytes],
+                numFrameBytes,
+                connection->frameBytes,
+                kFrameLengthBytes,
+                nonce,
+                sizeof nonce,
+                connection->accessoryToController.key);
+        if (e) {
+            HAPLog(&logObject,
+                   "Decryption of frame %llu failed.",
+                   (unsigned long long) connection->accessoryToController.nonce);
+            return kHAPError_InvalidData;
+        }
+        connection->accessoryToController.nonce++;
+        connection->numBytes += numFrameBytes;
+        connection->numFrameBytes = 0;
+    }
+    return kHAPError_None;
+}
+
+/**
+ * Determines the length of a chunked body.
+ *
+ * @param      bytes                Received body.
+ * @param      numBytes             Length of received body.
+ * @param[out] found                Whether or not the terminating chunk has been received.
+ * @param[out] numBodyBytes         Length of the chunked body including the terminating chunk, if found.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidData    If the body is malformed.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError GetChunkedBodyLength(const uint8_t* bytes, size_t numBytes, bool* found, size_t* numBodyBytes) {
+    HAPPrecondition(bytes);
+    HAPPrecondition(found);
+    HAPPrecondition(numBodyBytes);
+
+    *found = false;
+    size_t i = 0;
+    for (;;) {
+        size_t numChunkBytes = 0;
+        size_t numDigits = 0;
+        for (; i < numBytes; i++, numDigits++) {
+            uint8_t c = bytes[i];
+            if (c >= '0' && c <= '9') {
+                numChunkBytes = numChunkBytes * 16 + (size_t)(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                numChunkBytes = numChunkBytes * 16 + (size_t)(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                numChunkBytes = numChunkBytes * 16 + (size_t)(c - 'A' + 10);
+            } else {
+                break;
+            }
+            if (numDigits >= 8) {
+                return kHAPError_InvalidData;
+            }
+        }
+        if (i + 2 > numBytes) {
+            return kHAPError_None;
+        }
+        if (!numDigits || !HAPRawBufferAreEqual(&bytes[i], "\r\n", 2)) {
+            return kHAPError_InvalidData;
+        }
+        i += 2;
+        if (numChunkBytes > numBytes - i || numBytes - i - numChunkBytes < 2) {
+            return kHAPError_None;
+        }
+        i += numChunkBytes;
+        if (!HAPRawBufferAreEqual(&bytes[i], "\r\n", 2)) {
+            return kHAPError_InvalidData;
+        }
+        i += 2;
+        if (!numChunkBytes) {
+            *found = true;
+            *numBodyBytes = i;
+            return kHAPError_None;
+        }
+    }
+}
+
+HAPError ConnectionGetMessage(Connection* connection, bool* found, ConnectionMessage* message) {
+    HAPPrecondition(connection);
+    HAPPrecondition(found);
+    HAPPrecondition(message);
+
+    HAPError err;
+
+    ConsumeMessage(connection);
+    *found = false;
+
+    const uint8_t* bytes = connection->bytes;
+    size_t numBytes = connection->numBytes;
+
+    size_t numHeaderBytes = 0;
+    for (size_t i = 0; i + 4 <= numBytes; i++) {
+        if (HAPRawBufferAreEqual(&bytes[i], "\r\n\r\n", 4)) {
+            numHeaderBytes = i + 4;
+            break;
+        }
+    }
+    if (!numHeaderBytes) {
+        return kHAPError_None;
+    }
+
+    // Status line.
+    static const char httpStatusLine[] = "HTTP/1.1 ";
+    static const char eventStatusLine[] = "EVENT/1.0 ";
+    size_t i;
+    if (HAPRawBufferAreEqual(bytes, httpStatusLine, sizeof httpStatusLine - 1)) {
+        message->isEvent = false;
+        i = sizeof httpStatusLine - 1;
+    } else if (HAPRawBufferAreEqual(bytes, eventStatusLine, sizeof eventStatusLine - 1)) {
+        message->isEvent = true;
+        i = sizeof eventStatusLine - 1;
+    } else {
+        HAPLog(&logObject, "Malformed status line.");
+        return kHAPError_InvalidData;
+    }
+    message->status = 0;
+    for (size_t j = 0; j < 3; j++, i++) {
+        if (bytes[i] < '0' || bytes[i] > '9') {
+            HAPLog(&logObject, "Malformed status code.");
+            return kHAPError_InvalidData;
+        }
+        message->status = message->status * 10 + (unsigned int) (bytes[i] - '0');
+    }
+
+    // Header fields. The accessory server always uses the same spelling.
+    static const char contentLength[] = "\r\nContent-Length: ";
+    static const char chunked[] = "\r\nTransfer-Encoding: chunked\r\n";
+    size_t numBodyBytes = 0;
+    bool isChunked = false;
+    for (; i + 2 < numHeaderBytes; i++) {
+        if (i + sizeof contentLength - 1 <= numHeaderBytes &&
+            HAPRawBufferAreEqual(&bytes[i], contentLength, sizeof contentLength - 1)) {
+            size_t j = i + sizeof contentLength - 1;
+            for (; j < numHeaderBytes && bytes[j] >= '0' && bytes[j] <= '9'; j++) {
+                numBodyBytes = numBodyBytes * 10 + (size_t)(bytes[j] - '0');
+                if (numBodyBytes > sizeof connection->bytes) {
+                    HAPLog(&logObject, "Message exceeds %lu bytes.", (unsigned long) sizeof connection->bytes);
+                    return kHAPError_InvalidData;
+                }
+            }
+        }
+        if (i + sizeof chunked - 1 <= numHeaderBytes &&
+            HAPRawBufferAreEqual(&bytes[i], chunked, sizeof chunked - 1)) {
+            isChunked = true;
+        }
+    }
+
+    if (isChunked) {
+        bool isComplete;
+        err = GetChunkedBodyLength(&bytes[numHeaderBytes], numBytes - numHeaderBytes, &isComplete, &numBodyBytes);
+        if (err) {
+            HAPAssert(err == kHAPError_InvalidData);
+            HAPLog(&logObject, "Malformed chunked body.");
+            return err;
+        }
+        if (!isComplete) {
+            return kHAPError_None;
+        }
+    } else if (numBodyBytes > numBytes - numHeaderBytes) {
+        return kHAPError_None;
+    }
+
+    message->body = &bytes[numHeaderBytes];
+    message->numBodyBytes = numBodyBytes;
+    connection->numMessageBytes = numHeaderBytes + numBodyBytes;
+    *found = true;
+    return kHAPError_None;
+}
+
+HAPError ConnectionWaitForResponse(Connection* connection, int timeout, ConnectionMessage* message) {
+    HAPPrecondition(connection);
+    HAPPrecondition(connection->fd != -1);
+    HAPPrecondition(timeout >= 0);
+    HAPPrecondition(message);
+
+    HAPError err;
+
+    uint64_t deadline = GetMilliseconds() + (uint64_t) timeout;
+    for (;;) {
+        bool found;
+        err = ConnectionGetMessage(connection, &found, message);
+        if (err) {
+            return err;
+        }
+        if (found) {
+            if (message->isEvent) {
+                continue;
+            }
+            return kHAPError_None;
+        }
+
+        uint64_t now = GetMilliseconds();
+        if (now >= deadline) {
+            return kHAPError_Busy;
+        }
+        struct pollfd pollFD = { .fd = connection->fd, .events = POLLIN };
+        int e = poll(&pollFD, 1, (int) (deadline - now));
+        if (e < 0) {
+            int _errno = errno;
+            if (_errno == EINTR) {
+                continue;
+            }
+            HAPLog(&logObject, "poll failed: %d.", _errno);
+            return kHAPError_Unknown;
+        }
+        if (!e) {
+            return kHAPError_Busy;
+        }
+        err = ConnectionReceive(connection);
+        if (err) {
+            return err;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Sends a pairing request and receives the response.
+ *
+ * @param      connection           Connection.
+ * @param      path                 Request target.
+ * @param      requestWriter        Writer containing the request TLVs.
+ * @param[out] responseBytes        Buffer that the response TLVs are copied to.
+ * @param      maxResponseBytes     Capacity of the response buffer.
+ * @param[out] responseReader       Reader for the response TLVs.
+ * @param      timeout              Maximum time to wait for the response, in milliseconds.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidData    If the accessory sent an invalid response.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError ExchangeTLVs(
+        Connection* connection,
+        const char* path,
+        HAPTLVWriterRef* requestWriter,
+        void* responseBytes,
+        size_t maxResponseBytes,
+        HAPTLVReaderRef* responseReader,
+        int timeout) {
+    HAPPrecondition(connection);
+    HAPPrecondition(path);
+    HAPPrecondition(requestWriter);
+    HAPPrecondition(responseBytes);
+    HAPPrecondition(responseReader);
+
+    HAPError err;
+
+    void* requestBytes;
+    size_t numRequestBytes;
+    HAPTLVWriterGetBuffer(requestWriter, &requestBytes, &numRequestBytes);
+    err = ConnectionSendRequest(
+            connection, "POST", path, "application/pairing+tlv8", requestBytes, numRequestBytes);
+    if (err) {
+        return kHAPError_Unknown;
+    }
+
+    ConnectionMessage response;
+    err = ConnectionWaitForResponse(connection, timeout, &response);
+    if (err) {
+        HAPLog(&logObject, "%s: No response received (%u).", path, err);
+        return err == kHAPError_InvalidData || err == kHAPError_OutOfResources ? kHAPError_InvalidData :
+                                                                                  kHAPError_Unknown;
+    }
+    if (response.status != 200) {
+        HAPLog(&logObject, "%s: Unexpected status %u.", path, response.status);
+        return kHAPError_InvalidData;
+    }
+    if (response.numBodyBytes > maxResponseBytes) {
+        HAPLog(&logObject, "%s: Response too long.", path);
+        return kHAPError_InvalidData;
+    }
+    HAPRawBufferCopyBytes(responseBytes, response.body, response.numBodyBytes);
+    HAPTLVReaderCreate(responseReader, responseBytes, response.numBodyBytes);
+    return kHAPError_None;
+}
+
+/**
+ * Validates the kTLVType_State and kTLVType_Error items of a pairing response.
+ *
+ * @param      path                 Request target, for logging.
+ * @param      stateTLV             kTLVType_State.
+ * @param      errorTLV             kTLVType_Error.
+ * @param      expectedState        Expected state.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_NotAuthorized  If the accessory reported an error.
+ * @return kHAPError_InvalidData    If the state is invalid.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError ValidateResponseState(
+        const char* path,
+        const HAPTLV* stateTLV,
+        const HAPTLV* errorTLV,
+        uint8_t expectedState) {
+    HAPPrecondition(path);
+    HAPPrecondition(stateTLV);
+    HAPPrecondition(errorTLV);
+
+    if (!stateTLV->value.bytes || stateTLV->value.numBytes != 1 ||
+        ((const uint8_t*) stateTLV->value.bytes)[0] != expectedState) {
+        HAPLog(&logObject, "%s M%u: kTLVType_State missing or invalid.", path, expectedState);
+        return kHAPError_InvalidData;
+    }
+    if (errorTLV->value.bytes) {
+        HAPLog(&logObject,
+               "%s M%u: Accessory reported error %u.",
+               path,
+               expectedState,
+               errorTLV->value.numBytes == 1 ? ((const uint8_t*) errorTLV->value.bytes)[0] : 0);
+        return kHAPError_NotAuthorized;
+    }
+    return kHAPError_None;
+}
+
+/**
+ * Appends a TLV item to a request. The request buffers are sized for the largest request.
+ */
+static void AppendTLV(HAPTLVWriterRef* writer, HAPTLVType type, const void* bytes, size_t numBytes) {
+    HAPError err = HAPTLVWriterAppend(writer, &(const HAPTLV) { .type = type, .value = { .bytes = bytes, .numBytes = numBytes } });
+    HAPAssert(!err);
+}
+
+/**
+ * Builds, signs and encrypts the sub-TLV that proves the identity of a controller.
+ *
+ * @param[out] bytes                Buffer for the encrypted sub-TLV, including the authentication tag.
+ * @param      maxBytes             Capacity of the buffer.
+ * @param[out] numBytes             Length of the encrypted sub-TLV.
+ * @param      controller           Controller identity.
+ * @param      publicKey            Public key to include. NULL to omit kTLVType_PublicKey.
+ * @param      infoBytes            Data to sign.
+ * @param      numInfoBytes         Length of the data to sign.
+ * @param      nonce                Nonce.
+ * @param      key                  Encryption key.
+ */
+static void CreateEncryptedSubTLV(
+        uint8_t* bytes,
+        size_t maxBytes,
+        size_t* numBytes,
+        const ControllerIdentity* controller,
+        const uint8_t* _Nullable publicKey,
+        const uint8_t* infoBytes,
+        size_t numInfoBytes,
+        const char* nonce,
+        const uint8_t key[CHACHA20_POLY1305_KEY_BYTES]) {
+    uint8_t signature[ED25519_BYTES];
+    HAP_ed25519_sign(signature, infoBytes, numInfoBytes, controller->ltsk, controller->ltpk);
+
+    HAPTLVWriterRef subWriter;
+    HAPTLVWriterCreate(&subWriter, bytes, maxBytes - CHACHA20_POLY1305_TAG_BYTES);
+    AppendTLV(&subWriter, kHAPPairingTLVType_Identifier, controller->pairingID, HAPStringGetNumBytes(controller->pairingID));
+    if (publicKey) {
+        AppendTLV(&subWriter, kHAPPairingTLVType_PublicKey, publicKey, ED25519_PUBLIC_KEY_BYTES);
+    }
+    AppendTLV(&subWriter, kHAPPairingTLVType_Signature, signature, sizeof signature);
+
+    void* subBytes;
+    size_t numSubBytes;
+    HAPTLVWriterGetBuffer(&subWriter, &subBytes, &numSubBytes);
+    HAPAssert(subBytes == bytes);
+    HAP_chacha20_poly1305_encrypt(
+            &bytes[numSubBytes],
+            bytes,
+            bytes,
+            numSubBytes,
+            (const uint8_t*) nonce,
+            HAPStringGetNumBytes(nonce),
+            key);
+    *numBytes = numSubBytes + CHACHA20_POLY1305_TAG_BYTES;
+}
+
+/**
+ * Decrypts the sub-TLV that proves the identity of an accessory and extracts its items.
+ *
+ * @param      encryptedDataTLV     kTLVType_EncryptedData. Decrypted in place.
+ * @param      nonce                Nonce.
+ * @param      key                  Encryption key.
+ * @param[in,out] identifierTLV     kTLVType_Identifier.
+ * @param[in,out] publicKeyTLV      kTLVType_PublicKey. NULL if not expected.
+ * @param[in,out] signatureTLV      kTLVType_Signature.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidData    If decryption failed or the sub-TLV is malformed.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError DecryptSubTLV(
+        const HAPTLV* encryptedDataTLV,
+        const char* nonce,
+        const uint8_t key[CHACHA20_POLY1305_KEY_BYTES],
+        HAPTLV* identifierTLV,
+        HAPTLV* _Nullable publicKeyTLV,
+        HAPTLV* signatureTLV) {
+    HAPError err;
+
+    if (!encryptedDataTLV->value.bytes || encryptedDataTLV->value.numBytes < CHACHA20_POLY1305_TAG_BYTES) {
+        HAPLog(&logObject, "kTLVType_EncryptedData missing or invalid.");
+        return kHAPError_InvalidData;
+    }
+    uint8_t* bytes = (uint8_t*) (uintptr_t) encryptedDataTLV->value.bytes;
+    size_t numBytes = encryptedDataTLV->value.numBytes - CHACHA20_POLY1305_TAG_BYTES;
+    int e = HAP_chacha20_poly1305_decrypt(
+            &bytes[numBytes], bytes, bytes, numBytes, (const uint8_t*) nonce, HAPStringGetNumBytes(nonce), key);
+    if (e) {
+        HAPLog(&logObject, "Failed to decrypt kTLVType_EncryptedData.");
+        return kHAPError_InvalidData;
+    }
+
+    identifierTLV->type = kHAPPairingTLVType_Identifier;
+    signatureTLV->type = kHAPPairingTLVType_Signature;
+    if (publicKeyTLV) {
+        publicKeyTLV->type = kHAPPairingTLVType_PublicKey;
+    }
+    HAPTLVReaderRef subReader;
+    HAPTLVReaderCreate(&subReader, bytes, numBytes);
+    err = HAPTLVReaderGetAll(&subReader, (HAPTLV* const[]) { identifierTLV, signatureTLV, publicKeyTLV, NULL });
+    if (err) {
+        HAPAssert(err == kHAPError_InvalidData);
+        return err;
+    }
+    if (!identifierTLV->value.bytes || identifierTLV->value.numBytes >= sizeof(HAPDeviceIDString)) {
+        HAPLog(&logObject, "kTLVType_Identifier missing or invalid.");
+        return kHAPError_InvalidData;
+    }
+    if (!signatureTLV->value.bytes || signatureTLV->value.numBytes != ED25519_BYTES) {
+        HAPLog(&logObject, "kTLVType_Signature missing or invalid.");
+        return kHAPError_InvalidData;
+    }
+    if (publicKeyTLV && (!publicKeyTLV->value.bytes || publicKeyTLV->value.numBytes != ED25519_PUBLIC_KEY_BYTES)) {
+        HAPLog(&logObject, "kTLVType_PublicKey missing or invalid.");
+        return kHAPError_InvalidData;
+    }
+    return kHAPError_None;
+}
+
+/**
+ * SRP 3072-bit prime N of RFC 5054 Appendix A, big-endian.
+ */
+static const uint8_t kSRPPrime[SRP_PRIME_BYTES] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc9, 0x0f, 0xda, 0xa2, 0x21, 0x68, 0xc2, 0x34, 0xc4, 0xc6, 0x62,
+    0x8b, 0x80, 0xdc, 0x1c, 0xd1, 0x29, 0x02, 0x4e, 0x08, 0x8a, 0x67, 0xcc, 0x74, 0x02, 0x0b, 0xbe, 0xa6, 0x3b, 0x13,
+    0x9b, 0x22, 0x51, 0x4a, 0x08, 0x79, 0x8e, 0x34, 0x04, 0xdd, 0xef, 0x95, 0x19, 0xb3, 0xcd, 0x3a, 0x43, 0x1b, 0x30,
+    0x2b, 0x0a, 0x6d, 0xf2, 0x5f, 0x14, 0x37, 0x4f, 0xe1, 0x35, 0x6d, 0x6d, 0x51, 0xc2, 0x45, 0xe4, 0x85, 0xb5, 0x76,
+    0x62, 0x5e, 0x7e, 0xc6, 0xf4, 0x4c, 0x42, 0xe9, 0xa6, 0x37, 0xed, 0x6b, 0x0b, 0xff, 0x5c, 0xb6, 0xf4, 0x06, 0xb7,
+    0xed, 0xee, 0x38, 0x6b, 0xfb, 0x5a, 0x89, 0x9f, 0xa5, 0xae, 0x9f, 0x24, 0x11, 0x7c, 0x4b, 0x1f, 0xe6, 0x49, 0x28,
+    0x66, 0x51, 0xec, 0xe4, 0x5b, 0x3d, 0xc2, 0x00, 0x7c, 0xb8, 0xa1, 0x63, 0xbf, 0x05, 0x98, 0xda, 0x48, 0x36, 0x1c,
+    0x55, 0xd3, 0x9a, 0x69, 0x16, 0x3f, 0xa8, 0xfd, 0x24, 0xcf, 0x5f, 0x83, 0x65, 0x5d, 0x23, 0xdc, 0xa3, 0xad, 0x96,
+    0x1c, 0x62, 0xf3, 0x56, 0x20, 0x85, 0x52, 0xbb, 0x9e, 0xd5, 0x29, 0x07, 0x70, 0x96, 0x96, 0x6d, 0x67, 0x0c, 0x35,
+    0x4e, 0x4a, 0xbc, 0x98, 0x04, 0xf1, 0x74, 0x6c, 0x08, 0xca, 0x18, 0x21, 0x7c, 0x32, 0x90, 0x5e, 0x46, 0x2e, 0x36,
+    0xce, 0x3b, 0xe3, 0x9e, 0x77, 0x2c, 0x18, 0x0e, 0x86, 0x03, 0x9b, 0x27, 0x83, 0xa2, 0xec, 0x07, 0xa2, 0x8f, 0xb5,
+    0xc5, 0x5d, 0xf0, 0x6f, 0x4c, 0x52, 0xc9, 0xde, 0x2b, 0xcb, 0xf6, 0x95, 0x58, 0x17, 0x18, 0x39, 0x95, 0x49, 0x7c,
+    0xea, 0x95, 0x6a, 0xe5, 0x15, 0xd2, 0x26, 0x18, 0x98, 0xfa, 0x05, 0x10, 0x15, 0x72, 0x8e, 0x5a, 0x8a, 0xaa, 0xc4,
+    0x2d, 0xad, 0x33, 0x17, 0x0d, 0x04, 0x50, 0x7a, 0x33, 0xa8, 0x55, 0x21, 0xab, 0xdf, 0x1c, 0xba, 0x64, 0xec, 0xfb,
+    0x85, 0x04, 0x58, 0xdb, 0xef, 0x0a, 0x8a, 0xea, 0x71, 0x57, 0x5d, 0x06, 0x0c, 0x7d, 0xb3, 0x97, 0x0f, 0x85, 0xa6,
+    0xe1, 0xe4, 0xc7, 0xab, 0xf5, 0xae, 0x8c, 0xdb, 0x09, 0x33, 0xd7, 0x1e, 0x8c, 0x94, 0xe0, 0x4a, 0x25, 0x61, 0x9d,
+    0xce, 0xe3, 0xd2, 0x26, 0x1a, 0xd2, 0xee, 0x6b, 0xf1, 0x2f, 0xfa, 0x06, 0xd9, 0x8a, 0x08, 0x64, 0xd8, 0x76, 0x02,
+    0x73, 0x3e, 0xc8, 0x6a, 0x64, 0x52, 0x1f, 0x2b, 0x18, 0x17, 0x7b, 0x20, 0x0c, 0xbb, 0xe1, 0x17, 0x57, 0x7a, 0x61,
+    0x5d, 0x6c, 0x77, 0x09, 0x88, 0xc0, 0xba, 0xd9, 0x46, 0xe2, 0x08, 0xe2, 0x4f, 0xa0, 0x74, 0xe5, 0xab, 0x31, 0x43,
+    0xdb, 0x5b, 0xfc, 0xe0, 0xfd, 0x10, 0x8e, 0x4b, 0x82, 0xd1, 0x20, 0xa9, 0x3a, 0xd2, 0xca, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff,
+};
+HAP_STATIC_ASSERT(SRP_PUBLIC_KEY_BYTES == SRP_PRIME_BYTES, SRPPublicKeyIsPrimeSized);
+HAP_STATIC_ASSERT(SRP_VERIFIER_BYTES == SRP_PRIME_BYTES, SRPVerifierIsPrimeSized);
+HAP_STATIC_ASSERT(SRP_PREMASTER_SECRET_BYTES == SRP_PRIME_BYTES, SRPPremasterSecretIsPrimeSized);
+HAP_STATIC_ASSERT(SRP_SCRAMBLING_PARAMETER_BYTES == SHA512_BYTES, SRPScramblingParameterIsSHA512Sized);
+HAP_STATIC_ASSERT(SRP_SECRET_KEY_BYTES <= SRP_SCRAMBLING_PARAMETER_BYTES, SRPSecretKeyFitsExponent);
+
+/**
+ * Computes r = (a - b) % N for big-endian numbers a, b < N.
+ *
+ * @param[out] r                    Result. May alias a or b.
+ * @param      a                    Minuend.
+ * @param      b                    Subtrahend.
+ */
+static void SubtractModPrime(
+        uint8_t r[SRP_PRIME_BYTES],
+        const uint8_t a[SRP_PRIME_BYTES],
+        const uint8_t b[SRP_PRIME_BYTES]) {
+    int borrow = 0;
+    for (size_t i = SRP_PRIME_BYTES; i--;) {
+        int d = a[i] - b[i] - borrow;
+        borrow = d < 0;
+        r[i] = (uint8_t)(d + (borrow << 8));
+    }
+    if (borrow) {
+        int carry = 0;
+        for (size_t i = SRP_PRIME_BYTES; i--;) {
+            int s = r[i] + kSRPPrime[i] + carry;
+            carry = s >> 8;
+            r[i] = (uint8_t) s;
+        }
+    }
+}
+
+/**
+ * Computes the SRP premaster secret of the controller: S = (B - k * g^x) ^ (a + u * x) % N.
+ *
+ * The crypto layer only provides the accessory side of SRP. The controller side is assembled from it:
+ * - HAP_srp_verifier yields v = g^x and HAP_srp_public_key with a zero secret key yields k * v + 1.
+ * - HAP_srp_premaster_secret computes (A * v^u)^b, which serves as modular multiplication and exponentiation
+ *   when the unused operands are 1 (or u is 0). It also rejects B % N == 0.
+ *
+ * @param[out] s                    Premaster secret.
+ * @param      pub_b                Public key of the accessory.
+ * @param      priv_a               Secret key of the controller.
+ * @param      u                    Scrambling parameter.
+ * @param      salt                 Salt.
+ * @param      user                 User name.
+ * @param      user_len             Length of the user name.
+ * @param      pass                 Password (setup code).
+ * @param      pass_len             Length of the password.
+ *
+ * @return 0                        If successful.
+ * @return 1                        If the public key of the accessory is invalid.
+ */
+HAP_RESULT_USE_CHECK
+static int SRPClientPremasterSecret(
+        uint8_t s[SRP_PREMASTER_SECRET_BYTES],
+        const uint8_t pub_b[SRP_PUBLIC_KEY_BYTES],
+        const uint8_t priv_a[SRP_SECRET_KEY_BYTES],
+        const uint8_t u[SRP_SCRAMBLING_PARAMETER_BYTES],
+        const uint8_t salt[SRP_SALT_BYTES],
+        const uint8_t* user,
+        size_t user_len,
+        const uint8_t* pass,
+        size_t pass_len) {
+    uint8_t one[SRP_PRIME_BYTES];
+    HAPRawBufferZero(one, sizeof one);
+    one[sizeof one - 1] = 1;
+    // Zero exponent. Its prefix also serves as zero secret key.
+    uint8_t zero[SRP_SCRAMBLING_PARAMETER_BYTES];
+    HAPRawBufferZero(zero, sizeof zero);
+    const uint8_t* oneSecretKey = &one[sizeof one - SRP_SECRET_KEY_BYTES];
+
+    // x = H(salt | H(user | ":" | pass)).
+    uint8_t x[SHA512_BYTES];
+    {
+        uint8_t bytes[SRP_SALT_BYTES + SHA512_BYTES];
+        HAPPrecondition(user_len + 1 + pass_len <= sizeof bytes);
+        HAPRawBufferCopyBytes(bytes, user, user_len);
+        bytes[user_len] = ':';
+        HAPRawBufferCopyBytes(&bytes[user_len + 1], pass, pass_len);
+        HAP_sha512(x, bytes, user_len + 1 + pass_len);
+        HAPRawBufferCopyBytes(&bytes[SRP_SALT_BYTES], x, sizeof x);
+        HAPRawBufferCopyBytes(bytes, salt, SRP_SALT_BYTES);
+        HAP_sha512(x, bytes, sizeof bytes);
+    }
+
+    // base = (B - k * v) % N = (B % N - (k * v + 1) + 1) % N.
+    uint8_t base[SRP_PRIME_BYTES];
+    {
+        if (HAP_srp_premaster_secret(base, pub_b, oneSecretKey, zero, one)) {
+            return 1;
+        }
+        uint8_t v[SRP_VERIFIER_BYTES];
+        HAP_srp_verifier(v, salt, user, user_len, pass, pass_len);
+        uint8_t kv1[SRP_PUBLIC_KEY_BYTES];
+        HAP_srp_public_key(kv1, zero, v);
+        SubtractModPrime(base, base, kv1);
+        // Adding 1 is subtracting N - 1.
+        uint8_t primeMinusOne[SRP_PRIME_BYTES];
+        HAPRawBufferCopyBytes(primeMinusOne, kSRPPrime, sizeof primeMinusOne);
+        primeMinusOne[sizeof primeMinusOne - 1]--;
+        SubtractModPrime(base, base, primeMinusOne);
+    }
+
+    // S = (base^u)^x * base^a.
+    uint8_t a[SRP_SCRAMBLING_PARAMETER_BYTES];
+    HAPRawBufferZero(a, sizeof a - SRP_SECRET_KEY_BYTES);
+    HAPRawBufferCopyBytes(&a[sizeof a - SRP_SECRET_KEY_BYTES], priv_a, SRP_SECRET_KEY_BYTES);
+    uint8_t baseU[SRP_PRIME_BYTES];
+    uint8_t baseUX[SRP_PRIME_BYTES];
+    if (HAP_srp_premaster_secret(baseU, one, oneSecretKey, u, base) ||
+        HAP_srp_premaster_secret(baseUX, one, oneSecretKey, x, baseU) ||
+        HAP_srp_premaster_secret(s, baseUX, oneSecretKey, a, base)) {
+        return 1;
+    }
+    return 0;
+}
+
+HAPError ControllerPairSetup(
+        Connection* connection,
+        const char* setupCode,
+        const ControllerIdentity* controller,
+        AccessoryIdentity* accessory,
+        int timeout) {
+    HAPPrecondition(connection);
+    HAPPrecondition(!connection->isSecured);
+    HAPPrecondition(setupCode);
+    HAPPrecondition(controller);
+    HAPPrecondition(accessory);
+
+    HAPError err;
+
+    static const char path[] = "/pair-setup";
+    uint8_t requestBytes[kMaxPairingTLVBytes];
+    uint8_t responseBytes[kMaxPairingTLVBytes];
+    HAPTLVWriterRef requestWriter;
+    HAPTLVReaderRef responseReader;
+
+    // M1: SRP Start Request.
+    {
+        const uint8_t state = 1;
+        const uint8_t method = kHAPPairingMethod_PairSetup;
+        HAPTLVWriterCreate(&requestWriter, requestBytes, sizeof requestBytes);
+        AppendTLV(&requestWriter, kHAPPairingTLVType_State, &state, sizeof state);
+        AppendTLV(&requestWriter, kHAPPairingTLVType_Method, &method, sizeof method);
+    }
+    err = ExchangeTLVs(
+            connection, path, &requestWriter, responseBytes, sizeof responseBytes, &responseReader, timeout);
+    if (err) {
+        return err;
+    }
+
+    // M2: SRP Start Response.
+    uint8_t salt[SRP_SALT_BYTES];
+    uint8_t B[SRP_PUBLIC_KEY_BYTES];
+    {
+        HAPTLV stateTLV, errorTLV, publicKeyTLV, saltTLV;
+        stateTLV.type = kHAPPairingTLVType_State;
+        errorTLV.type = kHAPPairingTLVType_Error;
+        publicKeyTLV.type = kHAPPairingTLVType_PublicKey;
+        saltTLV.type = kHAPPairingTLVType_Salt;
+        err = HAPTLVReaderGetAll(
+                &responseReader, (HAPTLV* const[]) { &stateTLV, &errorTLV, &publicKeyTLV, &saltTLV, NULL });
+        if (err) {
+            return err;
+        }
+        err = ValidateResponseState(path, &stateTLV, &errorTLV, 2);
+        if (err) {
+            return err;
+        }
+        if (!publicKeyTLV.value.bytes || publicKeyTLV.value.numBytes > sizeof B || !saltTLV.value.bytes ||
+            saltTLV.value.numBytes != sizeof salt) {
+            HAPLog(&logObject, "%s M2: kTLVType_PublicKey or kTLVType_Salt missing or invalid.", path);
+            return kHAPError_InvalidData;
+        }
+        // Zero-extend big-endian.
+        HAPRawBufferZero(B, sizeof B - publicKeyTLV.value.numBytes);
+        HAPRawBufferCopyBytes(
+                &B[sizeof B - publicKeyTLV.value.numBytes], publicKeyTLV.value.bytes, publicKeyTLV.value.numBytes);
+        HAPRawBufferCopyBytes(salt, saltTLV.value.bytes, sizeof salt);
+    }
+
+    // Derive the SRP session key and the controller proof.
+    uint8_t A[SRP_PUBLIC_KEY_BYTES];
+    uint8_t K[SRP_SESSION_KEY_BYTES];
+    uint8_t M1[SRP_PROOF_BYTES];
+    {
+        uint8_t a[SRP_SECRET_KEY_BYTES];
+        HAPPlatformRandomNumberFill(a, sizeof a);
+        // With a zero verifier the public key is g^a.
+        uint8_t zeroVerifier[SRP_VERIFIER_BYTES];
+        HAPRawBufferZero(zeroVerifier, sizeof zeroVerifier);
+        HAP_srp_public_key(A, a, zeroVerifier);
+
+        uint8_t u[SRP_SCRAMBLING_PARAMETER_BYTES];
+        HAP_srp_scrambling_parameter(u, A, B);
+        uint8_t S[SRP_PREMASTER_SECRET_BYTES];
+        int e = SRPClientPremasterSecret(
+                S,
+                B,
+                a,
+                u,
+                salt,
+                kPairSetupUserName,
+                sizeof kPairSetupUserName - 1,
+                (const uint8_t*) setupCode,
+                HAPStringGetNumBytes(setupCode));
+        if (e) {
+            HAPLog(&logObject, "%s M2: Illegal key B.", path);
+            return kHAPError_InvalidData;
+        }
+        HAP_srp_session_key(K, S);
+        HAP_srp_proof_m1(M1, kPairSetupUserName, sizeof kPairSetupUserName - 1, salt, A, B, K);
+    }
+
+    // M3: SRP Verify Request.
+    {
+        const uint8_t state = 3;
+        // Skip leading zeros.
+        size_t numABytes = sizeof A;
+        const uint8_t* ABytes = A;
+        while (numABytes && !*ABytes) {
+            ABytes++;
+            numABytes--;
+        }
+        HAPTLVWriterCreate(&requestWriter, requestBytes, sizeof requestBytes);
+        AppendTLV(&requestWriter, kHAPPairingTLVType_State, &state, sizeof state);
+        AppendTLV(&requestWriter, kHAPPairingTLVType_PublicKey, ABytes, numABytes);
+        AppendTLV(&requestWriter, kHAPPairingTLVType_Proof, M1, sizeof M1);
+    }
+    err = ExchangeTLVs(
+            connection, path, &requestWriter, responseBytes, sizeof responseBytes, &responseReader, timeout);
+    if (err) {
+        return err;
+    }
+
+    // M4: SRP Verify Response.
+    {
+        HAPTLV stateTLV, errorTLV, proofTLV;
+        stateTLV.type = kHAPPairingTLVType_State;
+        errorTLV.type = kHAPPairingTLVType_Error;
+        proofTLV.type = kHAPPairingTLVType_Proof;
+        err = HAPTLVReaderGetAll(&responseReader, (HAPTLV* const[]) { &stateTLV, &errorTLV, &proofTLV, NULL });
+        if (err) {
+            return err;
+        }
+        err = ValidateResponseState(path, &stateTLV, &errorTLV, 4);
+        if (err) {
+            return err;
+        }
+        uint8_t M2[SRP_PROOF_BYTES];
+        HAP_srp_proof_m2(M2, A, M1, K);
+        if (!proofTLV.value.bytes || proofTLV.value.numBytes != sizeof M2 ||
+            !HAPRawBufferAreEqual(proofTLV.value.bytes, M2, sizeof M2)) {
+            HAPLog(&logObject, "%s M4: Accessory proof is incorrect.", path);
+            return kHAPError_InvalidData;
+        }
+    }
+
+    uint8_t sessionKey[CHACHA20_POLY1305_KEY_BYTES];
+    {
+        static const uint8_t salt_[] = "Pair-Setup-Encrypt-Salt";
+        static const uint8_t info[] = "Pair-Setup-Encrypt-Info";
+        HAP_hkdf_sha512(sessionKey, sizeof sessionKey, K, sizeof K, salt_, sizeof salt_ - 1, info, sizeof info - 1);
+    }
+
+    // M5: Exchange Request.
+    {
+        // iOSDeviceInfo: iOSDeviceX, iOSDevicePairingID, iOSDeviceLTPK.
+        size_t numPairingIDBytes = HAPStringGetNumBytes(controller->pairingID);
+        uint8_t info[32 + sizeof controller->pairingID + ED25519_PUBLIC_KEY_BYTES];
+        static const uint8_t salt_[] = "Pair-Setup-Controller-Sign-Salt";
+        static const uint8_t info_[] = "Pair-Setup-Controller-Sign-Info";
+        HAP_hkdf_sha512(info, 32, K, sizeof K, salt_, sizeof salt_ - 1, info_, sizeof info_ - 1);
+        HAPRawBufferCopyBytes(&info[32], controller->pairingID, numPairingIDBytes);
+        HAPRawBufferCopyBytes(&info[32 + numPairingIDBytes], controller->ltpk, sizeof controller->ltpk);
+
+        uint8_t encryptedBytes[256];
+        size_t numEncryptedBytes;
+        CreateEncryptedSubTLV(
+                encryptedBytes,
+                sizeof encryptedBytes,
+                &numEncryptedBytes,
+                controller,
+                controller->ltpk,
+                info,
+                32 + numPairingIDBytes + ED25519_PUBLIC_KEY_BYTES,
+                "PS-Msg05",
+                sessionKey);
+
+        const uint8_t state = 5;
+        HAPTLVWriterCreate(&requestWriter, requestBytes, sizeof requestBytes);
+        AppendTLV(&requestWriter, kHAPPairingTLVType_State, &state, sizeof state);
+        AppendTLV(&requestWriter, kHAPPairingTLVType_EncryptedData, encryptedBytes, numEncryptedBytes);
+    }
+    err = ExchangeTLVs(
+            connection, path, &requestWriter, responseBytes, sizeof responseBytes, &responseReader, timeout);
+    if (err) {
+        return err;
+    }
+
+    // M6: Exchange Response.
+    {
+        HAPTLV stateTLV, errorTLV, encryptedDataTLV;
+        stateTLV.type = kHAPPairingTLVType_State;
+        errorTLV.type = kHAPPairingTLVType_Error;
+        encryptedDataTLV.type = kHAPPairingTLVType_EncryptedData;
+        err = HAPTLVReaderGetAll(
+                &responseReader, (HAPTLV* const[]) { &stateTLV, &errorTLV, &encryptedDataTLV, NULL });
+        if (err) {
+            return err;
+        }
+        err = ValidateResponseState(path, &stateTLV, &errorTLV, 6);
+        if (err) {
+            return err;
+        }
+        HAPTLV identifierTLV, publicKeyTLV, signatureTLV;
+        err = DecryptSubTLV(&encryptedDataTLV, "PS-Msg06", sessionKey, &identifierTLV, &publicKeyTLV, &signatureTLV);
+        if (err) {
+            return err;
+        }
+
+        // AccessoryInfo: AccessoryX, AccessoryPairingID, AccessoryLTPK.
+        uint8_t info[32 + sizeof accessory->pairingID + ED25519_PUBLIC_KEY_BYTES];
+        static const uint8_t salt_[] = "Pair-Setup-Accessory-Sign-Salt";
+        static const uint8_t info_[] = "Pair-Setup-Accessory-Sign-Info";
+        HAP_hkdf_sha512(info, 32, K, sizeof K, salt_, sizeof salt_ - 1, info_, sizeof info_ - 1);
+        HAPRawBufferCopyBytes(&info[32], identifierTLV.value.bytes, identifierTLV.value.numBytes);
+        HAPRawBufferCopyBytes(
+                &info[32 + identifierTLV.value.numBytes], publicKeyTLV.value.bytes, ED25519_PUBLIC_KEY_BYTES);
+        int e = HAP_ed25519_verify(
+                signatureTLV.value.bytes,
+                info,
+                32 + identifierTLV.value.numBytes + ED25519_PUBLIC_KEY_BYTES,
+                publicKeyTLV.value.bytes);
+        if (e) {
+            HAPLog(&logObject, "%s M6: AccessoryInfo signature is incorrect.", path);
+            return kHAPError_InvalidData;
+        }
+
+        HAPRawBufferZero(accessory, sizeof *accessory);
+        HAPRawBufferCopyBytes(accessory->pairingID, identifierTLV.value.bytes, identifierTLV.value.numBytes);
+        HAPRawBufferCopyBytes(accessory->ltpk, publicKeyTLV.value.bytes, sizeof accessory->ltpk);
+    }
+    return kHAPError_None;
+}
+
+HAPError ControllerPairVerify(
+        Connection* connection,
+        const ControllerIdentity* controller,
+        const AccessoryIdentity* accessory,
+        int timeout) {
+    HAPPrecondition(connection);
+    HAPPrecondition(!connection->isSecured);
+    HAPPrecondition(controller);
+    HAPPrecondition(accessory);
+
+    HAPError err;
+
+    static const char path[] = "/pair-verify";
+    uint8_t requestBytes[kMaxPairingTLVBytes];
+    uint8_t responseBytes[kMaxPairingTLVBytes];
+    HAPTLVWriterRef requestWriter;
+    HAPTLVReaderRef responseReader;
+
+    // M1: Verify Start Request.
+    uint8_t cvSK[X25519_SCALAR_BYTES];
+    uint8_t cvPK[X25519_BYTES];
+    HAPPlatformRandomNumberFill(cvSK, sizeof cvSK);
+    HAP_X25519_scalarmult_base(cvPK, cvSK);
+    {
+        const uint8_t state = 1;
+        HAPTLVWriterCreate(&requestWriter, requestBytes, sizeof requestBytes);
+        AppendTLV(&requestWriter, kHAPPairingTLVType_State, &state, sizeof state);
+        AppendTLV(&requestWriter, kHAPPairingTLVType_PublicKey, cvPK, sizeof cvPK);
+    }
+    err = ExchangeTLVs(
+            connection, path, &requestWriter, responseBytes, sizeof responseBytes, &responseReader, timeout);
+    if (err) {
+        return err;
+    }
+
+    // M2: Verify Start Response.
+    uint8_t accessoryCvPK[X25519_BYTES];
+    uint8_t sharedSecret[X25519_BYTES];
+    uint8_t sessionKey[CHACHA20_POLY1305_KEY_BYTES];
+    {
+        HAPTLV stateTLV, errorTLV, publicKeyTLV, encryptedDataTLV;
+        stateTLV.type = kHAPPairingTLVType_State;
+        errorTLV.type = kHAPPairingTLVType_Error;
+        publicKeyTLV.type = kHAPPairingTLVType_PublicKey;
+        encryptedDataTLV.type = kHAPPairingTLVType_EncryptedData;
+        err = HAPTLVReaderGetAll(
+                &responseReader,
+                (HAPTLV* const[]) { &stateTLV, &errorTLV, &publicKeyTLV, &encryptedDataTLV, NULL });
+        if (err) {
+            return err;
+        }
+        err = ValidateResponseState(path, &stateTLV, &errorTLV, 2);
+        if (err) {
+            return err;
+        }
+        if (!publicKeyTLV.value.bytes || publicKeyTLV.value.numBytes != sizeof accessoryCvPK) {
+            HAPLog(&logObject, "%s M2: kTLVType_PublicKey missing or invalid.", path);
+            return kHAPError_InvalidData;
+        }
+        HAPRawBufferCopyBytes(accessoryCvPK, publicKeyTLV.value.bytes, sizeof accessoryCvPK);
+
+        HAP_X25519_scalarmult(sharedSecret, cvSK, accessoryCvPK);
+        static const uint8_t salt[] = "Pair-Verify-Encrypt-Salt";
+        static const uint8_t info[] = "Pair-Verify-Encrypt-Info";
+        HAP_hkdf_sha512(
+                sessionKey,
+                sizeof sessionKey,
+                sharedSecret,
+                sizeof sharedSecret,
+                salt,
+                sizeof salt - 1,
+                info,
+                sizeof info - 1);
+
+        HAPTLV identifierTLV, signatureTLV;
+        err = DecryptSubTLV(&encryptedDataTLV, "PV-Msg02", sessionKey, &identifierTLV, NULL, &signatureTLV);
+        if (err) {
+            return err;
+        }
+        if (identifierTLV.value.numBytes != HAPStringGetNumBytes(accessory->pairingID) ||
+            !HAPRawBufferAreEqual(identifierTLV.value.bytes, accessory->pairingID, identifierTLV.value.numBytes)) {
+            HAPLog(&logObject, "%s M2: Unexpected accessory pairing identifier.", path);
+            return kHAPError_InvalidData;
+        }
+
+        // AccessoryInfo: AccessoryCvPK, AccessoryPairingID, iOSDeviceCvPK.
+        uint8_t info_[X25519_BYTES + sizeof accessory->pairingID + X25519_BYTES];
+        HAPRawBufferCopyBytes(info_, accessoryCvPK, X25519_BYTES);
+        HAPRawBufferCopyBytes(&info_[X25519_BYTES], identifierTLV.value.bytes, identifierTLV.value.numBytes);
+        HAPRawBufferCopyBytes(&info_[X25519_BYTES + identifierTLV.value.numBytes], cvPK, X25519_BYTES);
+        int e = HAP_ed25519_verify(
+                signatureTLV.value.bytes,
+                info_,
+                X25519_BYTES + identifierTLV.value.numBytes + X25519_BYTES,
+                accessory->ltpk);
+        if (e) {
+            HAPLog(&logObject, "%s M2: AccessoryInfo signature is incorrect.", path);
+            return kHAPError_InvalidData;
+        }
+    }
+
+    // M3: Verify Finish Request.
+    {
+        // iOSDeviceInfo: iOSDeviceCvPK, iOSDevicePairingID, AccessoryCvPK.
+        size_t numPairingIDBytes = HAPStringGetNumBytes(controller->pairingID);
+        uint8_t info[X25519_BYTES + sizeof controller->pairingID + X25519_BYTES];
+        HAPRawBufferCopyBytes(info, cvPK, X25519_BYTES);
+        HAPRawBufferCopyBytes(&info[X25519_BYTES], controller->pairingID, numPairingIDBytes);
+        HAPRawBufferCopyBytes(&info[X25519_BYTES + numPairingIDBytes], accessoryCvPK, X25519_BYTES);
+
+        uint8_t encryptedBytes[256];
+        size_t numEncryptedBytes;
+        CreateEncryptedSubTLV(
+                encryptedBytes,
+                sizeof encryptedBytes,
+                &numEncryptedBytes,
+                controller,
+                NULL,
+                info,
+                X25519_BYTES + numPairingIDBytes + X25519_BYTES,
+                "PV-Msg03",
+                sessionKey);
+
+        const uint8_t state = 3;
+        HAPTLVWriterCreate(&requestWriter, requestBytes, sizeof requestBytes);
+        AppendTLV(&requestWriter, kHAPPairingTLVType_State, &state, sizeof state);
+        AppendTLV(&requestWriter, kHAPPairingTLVType_EncryptedData, encryptedBytes, numEncryptedBytes);
+    }
+    err = ExchangeTLVs(
+            connection, path, &requestWriter, responseBytes, sizeof responseBytes, &responseReader, timeout);
+    if (err) {
+        return err;
+    }
+
+    // M4: Verify Finish Response.
+    {
+        HAPTLV stateTLV, errorTLV;
+        stateTLV.type = kHAPPairingTLVType_State;
+        errorTLV.type = kHAPPairingTLVType_Error;
+        err = HAPTLVReaderGetAll(&responseReader, (HAPTLV* const[]) { &stateTLV, &errorTLV, NULL });
+        if (err) {
+            return err;
+        }
+        err = ValidateResponseState(path, &stateTLV, &errorTLV, 4);
+        if (err) {
+            return err;
+        }
+    }
+
+    // Derive the session keys. The accessory derives the same keys with swapped roles.
+    static const uint8_t salt[] = "Control-Salt";
+    static const uint8_t writeInfo[] = "Control-Write-Encryption-Key";
+    static const uint8_t readInfo[] = "Control-Read-Encryption-Key";
+    HAP_hkdf_sha512(
+            connection->controllerToAccessory.key,
+            sizeof connection->controllerToAccessory.key,
+            sharedSecret,
+            sizeof sharedSecret,
+            salt,
+            sizeof salt - 1,
+            writeInfo,
+            sizeof writeInfo - 1);
+    HAP_hkdf_sha512(
+            connection->accessoryToController.key,
+            sizeof connection->accessoryToController.key,
+            sharedSecret,
+            sizeof sharedSecret,
+            salt,
+            sizeof salt - 1,
+            readInfo,
+            sizeof readInfo - 1);
+    connection->controllerToAccessory.nonce = 0;
+    connection->accessoryToController.nonce = 0;
+    connection->isSecured = true;
+    return kHAPError_None;
+}
+
+/**
+ * Sends a /pairings request and validates the response.
+ *
+ * @param      connection           Secured connection of an admin controller.
+ * @param      requestWriter        Writer containing the request TLVs.
+ * @param      timeout              Maximum time to wait for the response, in milliseconds.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_NotAuthorized  If the accessory rejected the request.
+ * @return kHAPError_InvalidData    If the accessory sent an invalid response.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError ExchangePairingsTLVs(Connection* connection, HAPTLVWriterRef* requestWriter, int timeout) {
+    HAPError err;
+
+    static const char path[] = "/pairings";
+    uint8_t responseBytes[kMaxPairingTLVBytes];
+    HAPTLVReaderRef responseReader;
+    err = ExchangeTLVs(connection, path, requestWriter, responseBytes, sizeof responseBytes, &responseReader, timeout);
+    if (err) {
+        return err;
+    }
+
+    HAPTLV stateTLV, errorTLV;
+    stateTLV.type = kHAPPairingTLVType_State;
+    errorTLV.type = kHAPPairingTLVType_Error;
+    err = HAPTLVReaderGetAll(&responseReader, (HAPTLV* const[]) { &stateTLV, &errorTLV, NULL });
+    if (err) {
+        return err;
+    }
+    return ValidateResponseState(path, &stateTLV, &errorTLV, 2);
+}
+
+HAPError ControllerAddPairing(
+        Connection* connection,
+        const ControllerIdentity* controller,
+        bool isAdmin,
+        int timeout) {
+    HAPPrecondition(connection);
+    HAPPrecondition(connection->isSecured);
+    HAPPrecondition(controller);
+
+    uint8_t requestBytes[kMaxPairingTLVBytes];
+    HAPTLVWriterRef requestWriter;
+    const uint8_t state = 1;
+    const uint8_t method = kHAPPairingMethod_AddPairing;
+    const uint8_t permissions = isAdmin ? 0x01 : 0x00;
+    HAPTLVWriterCreate(&requestWriter, requestBytes, sizeof requestBytes);
+    AppendTLV(&requestWriter, kHAPPairingTLVType_State, &state, sizeof state);
+    AppendTLV(&requestWriter, kHAPPairingTLVType_Method, &method, sizeof method);
+    AppendTLV(
+            &requestWriter,
+            kHAPPairingTLVType_Identifier,
+            controller->pairingID,
+            HAPStringGetNumBytes(controller->pairingID));
+    AppendTLV(&requestWriter, kHAPPairingTLVType_PublicKey, controller->ltpk, sizeof controller->ltpk);
+    AppendTLV(&requestWriter, kHAPPairingTLVType_Permissions, &permissions, sizeof permissions);
+    return ExchangePairingsTLVs(connection, &requestWriter, timeout);
+}
+
+HAPError ControllerRemovePairing(Connection* connection, const ControllerIdentity* controller, int timeout) {
+    HAPPrecondition(connection);
+    HAPPrecondition(connection->isSecured);
+    HAPPrecondition(controller);
+
+    uint8_t requestBytes[kMaxPairingTLVBytes];
+    HAPTLVWriterRef requestWriter;
+    const uint8_t state = 1;
+    const uint8_t method = kHAPPairingMethod_RemovePairing;
+    HAPTLVWriterCreate(&requestWriter, requestBytes, sizeof requestBytes);
+    AppendTLV(&requestWriter, kHAPPairingTLVType_State, &state, sizeof state);
+    AppendTLV(&requestWriter, kHAPPairingTLVType_Method, &method, sizeof method);
+    AppendTLV(
+            &requestWriter,
+            kHAPPairingTLVType_Identifier,
+            controller->pairingID,
+            HAPStringGetNumBytes(controller->pairingID));
+    return ExchangePairingsTLVs(connection, &requestWriter, timeout);
+}
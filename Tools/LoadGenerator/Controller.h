@@ -0,0 +1,294 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <netinet/in.h>
+
+#include "HAP+Internal.h"
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull begin
+#endif
+
+/**
+ * Maximum length of a decrypted inbound message.
+ *
+ * - Must be large enough to hold the GET /accessories response of the accessory under test.
+ */
+#define kConnection_MaxMessageBytes ((size_t) 64 * 1024)
+
+/**
+ * Maximum length of an outbound request.
+ */
+#define kConnection_MaxRequestBytes ((size_t) 4096)
+
+/**
+ * Long-term identity of a controller.
+ */
+typedef struct {
+    /** Pairing identifier. NULL-terminated. */
+    char pairingID[sizeof(HAPPairingID) + 1];
+
+    /** Long-term secret key. */
+    uint8_t ltsk[ED25519_SECRET_KEY_BYTES];
+
+    /** Long-term public key. */
+    uint8_t ltpk[ED25519_PUBLIC_KEY_BYTES];
+} ControllerIdentity;
+
+/**
+ * Long-term identity of an accessory, as learned during Pair Setup.
+ */
+typedef struct {
+    /** Pairing identifier. NULL-terminated. */
+    char pairingID[sizeof(HAPDeviceIDString)];
+
+    /** Long-term public key. */
+    uint8_t ltpk[ED25519_PUBLIC_KEY_BYTES];
+} AccessoryIdentity;
+
+/**
+ * Connection from a controller to an accessory server.
+ */
+typedef struct {
+    /** Socket. -1 if the connection is closed. */
+    int fd;
+
+    /** Whether or not a HAP session has been established through Pair Verify. */
+    bool isSecured;
+
+    /** Controller to accessory channel. */
+    struct {
+        uint8_t key[CHACHA20_POLY1305_KEY_BYTES]; /**< Encryption key. */
+        uint64_t nonce;                           /**< Next nonce. */
+    } controllerToAccessory;
+
+    /** Accessory to controller channel. */
+    struct {
+        uint8_t key[CHACHA20_POLY1305_KEY_BYTES]; /**< Encryption key. */
+        uint64_t nonce;                           /**< Next nonce. */
+    } accessoryToController;
+
+    /** Received bytes that do not yet form a complete frame. Only used once the connection is secured. */
+    uint8_t frameBytes[kHAPIPSecurityProtocol_MaxFrameBytes + 2 + CHACHA20_POLY1305_TAG_BYTES];
+    size_t numFrameBytes;
+
+    /** Received plaintext. */
+    uint8_t bytes[kConnection_MaxMessageBytes];
+    size_t numBytes;
+
+    /** Length of the message at the start of the received plaintext that has been returned last. */
+    size_t numMessageBytes;
+} Connection;
+
+/**
+ * HTTP message received over a connection.
+ */
+typedef struct {
+    /** Whether or not the message is an event notification. */
+    bool isEvent;
+
+    /** HTTP status code. */
+    unsigned int status;
+
+    /** Body. Chunked bodies are returned without being decoded. */
+    const uint8_t* body;
+
+    /** Length of the body. */
+    size_t numBodyBytes;
+} ConnectionMessage;
+
+/**
+ * Generates a new controller identity with a random pairing identifier and key pair.
+ *
+ * @param[out] identity             Controller identity.
+ */
+void ControllerIdentityCreate(ControllerIdentity* identity);
+
+/**
+ * Opens a TCP connection to an accessory server.
+ *
+ * @param[out] connection           Connection.
+ * @param      address              Address of the accessory server.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If the connection could not be established.
+ */
+HAP_RESULT_USE_CHECK
+HAPError ConnectionOpen(Connection* connection, const struct sockaddr_in* address);
+
+/**
+ * Closes a connection. Has no effect if the connection is already closed.
+ *
+ * @param      connection           Connection.
+ */
+void ConnectionClose(Connection* connection);
+
+/**
+ * Sends an HTTP request. The request is encrypted if the connection is secured.
+ *
+ * @param      connection           Connection.
+ * @param      method               HTTP method.
+ * @param      path                 Request target.
+ * @param      contentType          Content type of the body. NULL if there is no body.
+ * @param      body                 Body.
+ * @param      numBodyBytes         Length of the body.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If the request is too long.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+HAPError ConnectionSendRequest(
+        Connection* connection,
+        const char* method,
+        const char* path,
+        const char* _Nullable contentType,
+        const void* _Nullable body,
+        size_t numBodyBytes);
+
+/**
+ * Reads the data that is available on a connection without blocking and decrypts all complete frames.
+ *
+ * - Must only be called when the socket is readable.
+ *
+ * @param      connection           Connection.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidState   If the accessory server closed the connection.
+ * @return kHAPError_InvalidData    If a frame could not be decrypted.
+ * @return kHAPError_OutOfResources If the inbound buffer is full.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+HAPError ConnectionReceive(Connection* connection);
+
+/**
+ * Gets the next complete message from the received plaintext.
+ *
+ * - The message stays valid until the next call to this function or to ConnectionReceive.
+ *
+ * @param      connection           Connection.
+ * @param[out] found                Whether or not a complete message has been received.
+ * @param[out] message              Message, if found.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidData    If the received data is malformed.
+ */
+HAP_RESULT_USE_CHECK
+HAPError ConnectionGetMessage(Connection* connection, bool* found, ConnectionMessage* message);
+
+/**
+ * Waits until a response is received, skipping event notifications.
+ *
+ * @param      connection           Connection.
+ * @param      timeout              Maximum time to wait, in milliseconds.
+ * @param[out] message              Response.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Busy           If no response has been received within the timeout.
+ * @return kHAPError_InvalidState   If the accessory server closed the connection.
+ * @return kHAPError_InvalidData    If the received data is malformed.
+ * @return kHAPError_OutOfResources If the response is too long.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+HAPError ConnectionWaitForResponse(Connection* connection, int timeout, ConnectionMessage* message);
+
+/**
+ * Pairs a controller with an unpaired accessory server through Pair Setup with a setup code.
+ *
+ * @param      connection           Unsecured connection.
+ * @param      setupCode            Setup code of the accessory (XXX-XX-XXX).
+ * @param      controller           Identity of the controller that becomes the admin.
+ * @param[out] accessory            Identity of the accessory.
+ * @param      timeout              Maximum time to wait for each response, in milliseconds.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_NotAuthorized  If the accessory rejected the setup code or is already paired.
+ * @return kHAPError_InvalidData    If the accessory sent an invalid response.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+HAPError ControllerPairSetup(
+        Connection* connection,
+        const char* setupCode,
+        const ControllerIdentity* controller,
+        AccessoryIdentity* accessory,
+        int timeout);
+
+/**
+ * Establishes a HAP session through Pair Verify. On success the connection is secured.
+ *
+ * @param      connection           Unsecured connection.
+ * @param      controller           Identity of a paired controller.
+ * @param      accessory            Identity of the accessory.
+ * @param      timeout              Maximum time to wait for each response, in milliseconds.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_NotAuthorized  If the accessory rejected the controller.
+ * @return kHAPError_InvalidData    If the accessory sent an invalid response.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+HAPError ControllerPairVerify(
+        Connection* connection,
+        const ControllerIdentity* controller,
+        const AccessoryIdentity* accessory,
+        int timeout);
+
+/**
+ * Adds a pairing through a secured connection of an admin controller.
+ *
+ * @param      connection           Secured connection of an admin controller.
+ * @param      controller           Identity of the controller to add.
+ * @param      isAdmin              Whether or not the added controller has admin permissions.
+ * @param      timeout              Maximum time to wait for the response, in milliseconds.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_NotAuthorized  If the accessory rejected the request.
+ * @return kHAPError_InvalidData    If the accessory sent an invalid response.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+HAPError ControllerAddPairing(
+        Connection* connection,
+        const ControllerIdentity* controller,
+        bool isAdmin,
+        int timeout);
+
+/**
+ * Removes a pairing through a secured connection of an admin controller.
+ *
+ * - Removing the last admin pairing removes all pairings and the accessory becomes unpaired.
+ *
+ * @param      connection           Secured connection of an admin controller.
+ * @param      controller           Identity of the controller to remove.
+ * @param      timeout              Maximum time to wait for the response, in milliseconds.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_NotAuthorized  If the accessory rejected the request.
+ * @return kHAPError_InvalidData    If the accessory sent an invalid response.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+HAPError ControllerRemovePairing(Connection* connection, const ControllerIdentity* controller, int timeout);
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull end
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,639 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+// Drives an unpaired accessory server over TCP with many concurrent controller sessions.
+//
+// 1. Pair Setup with the first controller, then Add Pairing for the remaining controllers.
+// 2. Open the sessions one after another. Each session is assigned a controller round-robin and runs Pair Verify.
+// 3. Every session issues a fixed number of requests, drawn from a weighted mix of operations.
+//    Each session has one request in flight at a time. Event notifications are counted.
+// 4. Remove the pairing of the first controller. This unpairs the accessory so that the run can be repeated.
+//
+// Results are printed as one JSON object per line. Latencies are in microseconds.
+// Sessions that time out or are closed by the accessory server count as errors and are not used further.
+
+#include <arpa/inet.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Controller.h"
+
+/** Maximum number of controllers. HomeKit Accessory Protocol Specification R14 requires support for 16 pairings. */
+#define kMaxControllers ((size_t) 16)
+
+/**
+ * Operation.
+ */
+HAP_ENUM_BEGIN(uint8_t, Operation) { /** GET /characteristics. */
+                                     kOperation_Get,
+
+                                     /** PUT /characteristics with a value. */
+                                     kOperation_Put,
+
+                                     /** GET /accessories. */
+                                     kOperation_Accessories,
+
+                                     /** PUT /characteristics that toggles event notifications. */
+                                     kOperation_Subscribe
+} HAP_ENUM_END(uint8_t, Operation);
+
+#define kNumOperations ((size_t) 4)
+
+static const char* const operationNames[kNumOperations] = { "get", "put", "accessories", "subscribe" };
+
+/**
+ * Options.
+ */
+typedef struct {
+    struct sockaddr_in address;
+    const char* setupCode;
+    size_t numSessions;
+    size_t numControllers;
+    size_t numRequestsPerSession;
+    unsigned int weights[kNumOperations];
+    unsigned long aid;
+    unsigned long iid;
+    int timeout;
+} Options;
+
+/**
+ * Session.
+ */
+typedef struct {
+    /** Connection. Closed if the session failed. */
+    Connection* connection;
+
+    /** Number of requests that have been sent. */
+    size_t numRequests;
+
+    /** Whether or not a request is in flight. */
+    bool isRequestInFlight;
+
+    /** Operation of the request in flight. */
+    Operation operation;
+
+    /** Time when the request in flight was sent, in microseconds. */
+    uint64_t requestTime;
+
+    /** Whether or not event notifications are enabled. */
+    bool isSubscribed;
+
+    /** Value that is written by the next PUT. */
+    bool value;
+
+    /** State of the operation mix. */
+    uint32_t randomState;
+} Session;
+
+/**
+ * Latency samples of an operation.
+ */
+typedef struct {
+    uint32_t* samples;
+    size_t numSamples;
+    size_t numErrors;
+} Statistics;
+
+/**
+ * Gets the current time of a monotonic clock.
+ *
+ * @return Current time in microseconds.
+ */
+HAP_RESULT_USE_CHECK
+static uint64_t GetMicroseconds(void) {
+    struct timespec t;
+    int e = clock_gettime(CLOCK_MONOTONIC, &t);
+    HAPAssert(!e);
+    return (uint64_t) t.tv_sec * 1000000 + (uint64_t) t.tv_nsec / 1000;
+}
+
+static void PrintUsage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s --port=<port> [options]\n"
+            "\n"
+            "Options:\n"
+            "  --host=<IPv4 address>          Accessory server address. Default: 127.0.0.1.\n"
+            "  --port=<port>                  Accessory server port.\n"
+            "  --setup-code=<XXX-XX-XXX>      Setup code. Default: 111-22-333.\n"
+            "  --sessions=<n>                 Number of concurrent sessions. Default: 8.\n"
+            "  --controllers=<n>              Number of paired controllers (1-%lu). Default: 1.\n"
+            "  --requests=<n>                 Requests per session. Default: 1000.\n"
+            "  --mix=<operation>:<weight>,... Weights of get, put, accessories and subscribe.\n"
+            "                                 Default: get:60,put:30,accessories:5,subscribe:5.\n"
+            "  --characteristic=<aid>.<iid>   Boolean characteristic that is read, written and subscribed to.\n"
+            "                                 Default: 1.51 (Light Bulb On of the Lightbulb application).\n"
+            "  --timeout=<ms>                 Maximum time to wait for a response. Default: 5000.\n",
+            program,
+            (unsigned long) kMaxControllers);
+}
+
+/**
+ * Parses an unsigned decimal number.
+ *
+ * @return true                     If successful.
+ * @return false                    If the string is not a number or the number is out of range.
+ */
+HAP_RESULT_USE_CHECK
+static bool ParseNumber(const char* string, unsigned long minValue, unsigned long maxValue, unsigned long* value) {
+    char* end;
+    *value = strtoul(string, &end, 10);
+    return end != string && !*end && *value >= minValue && *value <= maxValue;
+}
+
+/**
+ * Parses the operation mix.
+ *
+ * @return true                     If successful.
+ * @return false                    If the mix is malformed.
+ */
+HAP_RESULT_USE_CHECK
+static bool ParseMix(const char* string, unsigned int weights[kNumOperations]) {
+    HAPRawBufferZero(weights, kNumOperations * sizeof weights[0]);
+    unsigned int totalWeight = 0;
+    while (*string) {
+        size_t i;
+        size_t numNameBytes = 0;
+        for (i = 0; i < kNumOperations; i++) {
+            numNameBytes = HAPStringGetNumBytes(operationNames[i]);
+            if (!strncmp(string, operationNames[i], numNameBytes) && string[numNameBytes] == ':') {
+                break;
+            }
+        }
+        if (i == kNumOperations) {
+            return false;
+        }
+        string += numNameBytes + 1;
+        char* end;
+        unsigned long weight = strtoul(string, &end, 10);
+        if (end == string || weight > 1000 || (*end && *end != ',')) {
+            return false;
+        }
+        weights[i] = (unsigned int) weight;
+        totalWeight += weights[i];
+        string = *end ? end + 1 : end;
+    }
+    return totalWeight != 0;
+}
+
+/**
+ * Parses the command line.
+ *
+ * @return true                     If successful.
+ * @return false                    If the command line is invalid.
+ */
+HAP_RESULT_USE_CHECK
+static bool ParseOptions(int argc, char* argv[], Options* options) {
+    HAPRawBufferZero(options, sizeof *options);
+    options->address.sin_family = AF_INET;
+    options->address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    options->setupCode = "111-22-333";
+    options->numSessions = 8;
+    options->numControllers = 1;
+    options->numRequestsPerSession = 1000;
+    options->weights[kOperation_Get] = 60;
+    options->weights[kOperation_Put] = 30;
+    options->weights[kOperation_Accessories] = 5;
+    options->weights[kOperation_Subscribe] = 5;
+    options->aid = 1;
+    options->iid = 51;
+    options->timeout = 5000;
+
+    bool hasPort = false;
+    for (int i = 1; i < argc; i++) {
+        const char* argument = argv[i];
+        const char* value = strchr(argument, '=');
+        if (!value) {
+            return false;
+        }
+        size_t numNameBytes = (size_t)(value - argument);
+        value++;
+#define IS_OPTION(name) (numNameBytes == sizeof(name) - 1 && !strncmp(argument, (name), numNameBytes))
+        unsigned long number;
+        if (IS_OPTION("--host")) {
+            if (inet_pton(AF_INET, value, &options->address.sin_addr) != 1) {
+                return false;
+            }
+        } else if (IS_OPTION("--port")) {
+            if (!ParseNumber(value, 1, UINT16_MAX, &number)) {
+                return false;
+            }
+            options->address.sin_port = htons((uint16_t) number);
+            hasPort = true;
+        } else if (IS_OPTION("--setup-code")) {
+            if (!HAPAccessorySetupIsValidSetupCode(value)) {
+                return false;
+            }
+            options->setupCode = value;
+        } else if (IS_OPTION("--sessions")) {
+            if (!ParseNumber(value, 1, 1024, &number)) {
+                return false;
+            }
+            options->numSessions = number;
+        } else if (IS_OPTION("--controllers")) {
+            if (!ParseNumber(value, 1, kMaxControllers, &number)) {
+                return false;
+            }
+            options->numControllers = number;
+        } else if (IS_OPTION("--requests")) {
+            if (!ParseNumber(value, 0, 10000000, &number)) {
+                return false;
+            }
+            options->numRequestsPerSession = number;
+        } else if (IS_OPTION("--mix")) {
+            if (!ParseMix(value, options->weights)) {
+                return false;
+            }
+        } else if (IS_OPTION("--characteristic")) {
+            char* end;
+            options->aid = strtoul(value, &end, 10);
+            if (end == value || *end != '.' || !ParseNumber(end + 1, 1, ULONG_MAX, &options->iid)) {
+                return false;
+            }
+        } else if (IS_OPTION("--timeout")) {
+            if (!ParseNumber(value, 1, 3600000, &number)) {
+                return false;
+            }
+            options->timeout = (int) number;
+        } else {
+            return false;
+        }
+#undef IS_OPTION
+    }
+    return hasPort;
+}
+
+/**
+ * Picks the next operation of a session according to the weights.
+ *
+ * - A xorshift generator seeded with the session index keeps the sequence of operations reproducible.
+ */
+HAP_RESULT_USE_CHECK
+static Operation PickOperation(Session* session, const unsigned int weights[kNumOperations]) {
+    uint32_t x = session->randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    session->randomState = x;
+
+    unsigned int totalWeight = 0;
+    for (size_t i = 0; i < kNumOperations; i++) {
+        totalWeight += weights[i];
+    }
+    unsigned int r = x % totalWeight;
+    for (size_t i = 0; i < kNumOperations; i++) {
+        if (r < weights[i]) {
+            return (Operation) i;
+        }
+        r -= weights[i];
+    }
+    HAPFatalError();
+}
+
+/**
+ * Sends the next request of a session.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If the connection failed.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError SendNextRequest(Session* session, const Options* options) {
+    HAPError err;
+
+    Operation operation = PickOperation(session, options->weights);
+    char bytes[256];
+    switch (operation) {
+        case kOperation_Get: {
+            err = HAPStringWithFormat(bytes, sizeof bytes, "/characteristics?id=%lu.%lu", options->aid, options->iid);
+            HAPAssert(!err);
+            session->requestTime = GetMicroseconds();
+            err = ConnectionSendRequest(session->connection, "GET", bytes, NULL, NULL, 0);
+        } break;
+        case kOperation_Put:
+        case kOperation_Subscribe: {
+            bool isPut = operation == kOperation_Put;
+            err = HAPStringWithFormat(
+                    bytes,
+                    sizeof bytes,
+                    "{\"characteristics\":[{\"aid\":%lu,\"iid\":%lu,\"%s\":%s}]}",
+                    options->aid,
+                    options->iid,
+                    isPut ? "value" : "ev",
+                    (isPut ? session->value : !session->isSubscribed) ? "true" : "false");
+            HAPAssert(!err);
+            if (isPut) {
+                session->value = !session->value;
+            } else {
+                session->isSubscribed = !session->isSubscribed;
+            }
+            session->requestTime = GetMicroseconds();
+            err = ConnectionSendRequest(
+                    session->connection,
+                    "PUT",
+                    "/characteristics",
+                    "application/hap+json",
+                    bytes,
+                    HAPStringGetNumBytes(bytes));
+        } break;
+        case kOperation_Accessories: {
+            session->requestTime = GetMicroseconds();
+            err = ConnectionSendRequest(session->connection, "GET", "/accessories", NULL, NULL, 0);
+        } break;
+        default:
+            HAPFatalError();
+    }
+    if (err) {
+        return kHAPError_Unknown;
+    }
+    session->operation = operation;
+    session->isRequestInFlight = true;
+    session->numRequests++;
+    return kHAPError_None;
+}
+
+static int CompareSamples(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*) a;
+    uint32_t y = *(const uint32_t*) b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/**
+ * Prints the latency distribution of a set of samples.
+ */
+static void PrintStatistics(const char* phase, const char* _Nullable operation, Statistics* statistics) {
+    qsort(statistics->samples, statistics->numSamples, sizeof statistics->samples[0], CompareSamples);
+    printf("{\"phase\":\"%s\",", phase);
+    if (operation) {
+        printf("\"operation\":\"%s\",", operation);
+    }
+    printf("\"count\":%lu,\"errors\":%lu",
+           (unsigned long) statistics->numSamples,
+           (unsigned long) statistics->numErrors);
+    if (statistics->numSamples) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < statistics->numSamples; i++) {
+            sum += statistics->samples[i];
+        }
+        size_t n = statistics->numSamples;
+        printf(",\"meanUs\":%llu,\"p50Us\":%lu,\"p90Us\":%lu,\"p99Us\":%lu,\"maxUs\":%lu",
+               (unsigned long long) (sum / n),
+               (unsigned long) statistics->samples[n * 50 / 100],
+               (unsigned long) statistics->samples[n * 90 / 100],
+               (unsigned long) statistics->samples[n * 99 / 100],
+               (unsigned long) statistics->samples[n - 1]);
+    }
+    printf("}\n");
+    fflush(stdout);
+}
+
+/**
+ * Opens a connection and establishes a HAP session.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If the session could not be established.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError OpenSession(
+        Connection* connection,
+        const Options* options,
+        const ControllerIdentity* controller,
+        const AccessoryIdentity* accessory) {
+    HAPError err;
+
+    err = ConnectionOpen(connection, &options->address);
+    if (err) {
+        return kHAPError_Unknown;
+    }
+    err = ControllerPairVerify(connection, controller, accessory, options->timeout);
+    if (err) {
+        fprintf(stderr, "Pair Verify failed: %u.\n", err);
+        ConnectionClose(connection);
+        return kHAPError_Unknown;
+    }
+    return kHAPError_None;
+}
+
+int main(int argc, char* argv[]) {
+    HAPError err;
+
+    Options options;
+    if (!ParseOptions(argc, argv, &options)) {
+        PrintUsage(argc ? argv[0] : "LoadGenerator");
+        return EXIT_FAILURE;
+    }
+
+    ControllerIdentity controllers[kMaxControllers];
+    for (size_t i = 0; i < options.numControllers; i++) {
+        ControllerIdentityCreate(&controllers[i]);
+    }
+    AccessoryIdentity accessory;
+
+    // Pair the admin controller and add the other controllers through it.
+    Connection* adminConnection = calloc(1, sizeof *adminConnection);
+    if (!adminConnection) {
+        fprintf(stderr, "Out of memory.\n");
+        return EXIT_FAILURE;
+    }
+    {
+        uint64_t startTime = GetMicroseconds();
+        err = ConnectionOpen(adminConnection, &options.address);
+        if (err) {
+            fprintf(stderr, "Failed to connect to the accessory server.\n");
+            return EXIT_FAILURE;
+        }
+        err = ControllerPairSetup(adminConnection, options.setupCode, &controllers[0], &accessory, options.timeout);
+        if (err) {
+            fprintf(stderr, "Pair Setup failed: %u. Is the accessory unpaired and the setup code correct?\n", err);
+            return EXIT_FAILURE;
+        }
+        printf("{\"phase\":\"pairSetup\",\"accessory\":\"%s\",\"durationUs\":%llu}\n",
+               accessory.pairingID,
+               (unsigned long long) (GetMicroseconds() - startTime));
+        fflush(stdout);
+        ConnectionClose(adminConnection);
+
+        err = OpenSession(adminConnection, &options, &controllers[0], &accessory);
+        if (err) {
+            return EXIT_FAILURE;
+        }
+        for (size_t i = 1; i < options.numControllers; i++) {
+            err = ControllerAddPairing(adminConnection, &controllers[i], /* isAdmin: */ false, options.timeout);
+            if (err) {
+                fprintf(stderr, "Add Pairing failed: %u.\n", err);
+                return EXIT_FAILURE;
+            }
+        }
+        ConnectionClose(adminConnection);
+    }
+
+    Session* sessions = calloc(options.numSessions, sizeof *sessions);
+    struct pollfd* pollFDs = calloc(options.numSessions, sizeof *pollFDs);
+    size_t* pollSessions = calloc(options.numSessions, sizeof *pollSessions);
+    Statistics setupStatistics = { .samples = calloc(options.numSessions, sizeof(uint32_t)) };
+    Statistics operationStatistics[kNumOperations];
+    HAPRawBufferZero(operationStatistics, sizeof operationStatistics);
+    size_t maxSamples = options.numSessions * options.numRequestsPerSession;
+    for (size_t i = 0; i < kNumOperations; i++) {
+        operationStatistics[i].samples = calloc(maxSamples ? maxSamples : 1, sizeof(uint32_t));
+        if (!operationStatistics[i].samples) {
+            fprintf(stderr, "Out of memory.\n");
+            return EXIT_FAILURE;
+        }
+    }
+    if (!sessions || !pollFDs || !pollSessions || !setupStatistics.samples) {
+        fprintf(stderr, "Out of memory.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Establish the sessions one after another so that the setup times are not skewed by the load.
+    for (size_t i = 0; i < options.numSessions; i++) {
+        Session* session = &sessions[i];
+        session->randomState = (uint32_t)(i + 1) * 2654435761U;
+        session->connection = calloc(1, sizeof *session->connection);
+        if (!session->connection) {
+            fprintf(stderr, "Out of memory.\n");
+            return EXIT_FAILURE;
+        }
+        session->connection->fd = -1;
+        uint64_t startTime = GetMicroseconds();
+        err = OpenSession(
+                session->connection, &options, &controllers[i % options.numControllers], &accessory);
+        if (err) {
+            setupStatistics.numErrors++;
+            continue;
+        }
+        setupStatistics.samples[setupStatistics.numSamples++] = (uint32_t)(GetMicroseconds() - startTime);
+    }
+    PrintStatistics("connectionSetup", NULL, &setupStatistics);
+
+    // Load phase.
+    size_t numEvents = 0;
+    uint64_t loadStartTime = GetMicroseconds();
+    for (;;) {
+        uint64_t now = GetMicroseconds();
+        size_t numPollFDs = 0;
+        for (size_t i = 0; i < options.numSessions; i++) {
+            Session* session = &sessions[i];
+            if (session->connection->fd == -1) {
+                continue;
+            }
+            if (session->isRequestInFlight && now - session->requestTime > (uint64_t) options.timeout * 1000) {
+                operationStatistics[session->operation].numErrors++;
+                ConnectionClose(session->connection);
+                continue;
+            }
+            if (!session->isRequestInFlight && session->numRequests < options.numRequestsPerSession) {
+                err = SendNextRequest(session, &options);
+                if (err) {
+                    operationStatistics[session->operation].numErrors++;
+                    ConnectionClose(session->connection);
+                    continue;
+                }
+            }
+            if (!session->isRequestInFlight) {
+                continue;
+            }
+            pollFDs[numPollFDs] = (struct pollfd) { .fd = session->connection->fd, .events = POLLIN };
+            pollSessions[numPollFDs] = i;
+            numPollFDs++;
+        }
+        if (!numPollFDs) {
+            break;
+        }
+
+        int e = poll(pollFDs, (nfds_t) numPollFDs, 100);
+        if (e < 0) {
+            continue;
+        }
+        for (size_t j = 0; j < numPollFDs; j++) {
+            if (!pollFDs[j].revents) {
+                continue;
+            }
+            Session* session = &sessions[pollSessions[j]];
+            err = ConnectionReceive(session->connection);
+            for (;;) {
+                if (err) {
+                    operationStatistics[session->operation].numErrors++;
+                    ConnectionClose(session->connection);
+                    session->isRequestInFlight = false;
+                    break;
+                }
+                bool found;
+                ConnectionMessage message;
+                err = ConnectionGetMessage(session->connection, &found, &message);
+                if (err) {
+                    continue;
+                }
+                if (!found) {
+                    break;
+                }
+                if (message.isEvent) {
+                    numEvents++;
+                    continue;
+                }
+                if (!session->isRequestInFlight || (message.status != 200 && message.status != 204)) {
+                    err = kHAPError_InvalidData;
+                    continue;
+                }
+                Statistics* statistics = &operationStatistics[session->operation];
+                HAPAssert(statistics->numSamples < maxSamples);
+                statistics->samples[statistics->numSamples++] = (uint32_t)(GetMicroseconds() - session->requestTime);
+                session->isRequestInFlight = false;
+            }
+        }
+    }
+    uint64_t loadDuration = GetMicroseconds() - loadStartTime;
+
+    size_t numRequests = 0;
+    size_t numErrors = setupStatistics.numErrors;
+    for (size_t i = 0; i < kNumOperations; i++) {
+        PrintStatistics("load", operationNames[i], &operationStatistics[i]);
+        numRequests += operationStatistics[i].numSamples + operationStatistics[i].numErrors;
+        numErrors += operationStatistics[i].numErrors;
+    }
+    printf("{\"phase\":\"total\",\"sessions\":%lu,\"requests\":%lu,\"errors\":%lu,\"errorRate\":%.4f,"
+           "\"requestsPerSecond\":%.1f,\"eventsReceived\":%lu,\"durationUs\":%llu}\n",
+           (unsigned long) options.numSessions,
+           (unsigned long) numRequests,
+           (unsigned long) numErrors,
+           numRequests + setupStatistics.numErrors ?
+                   (double) numErrors / (double) (numRequests + setupStatistics.numErrors) :
+                   0.0,
+           loadDuration ? (double) numRequests * 1e6 / (double) loadDuration : 0.0,
+           (unsigned long) numEvents,
+           (unsigned long long) loadDuration);
+    fflush(stdout);
+
+    for (size_t i = 0; i < options.numSessions; i++) {
+        ConnectionClose(sessions[i].connection);
+        free(sessions[i].connection);
+    }
+
+    // Unpair so that the next run starts from a clean state.
+    int status = EXIT_SUCCESS;
+    err = OpenSession(adminConnection, &options, &controllers[0], &accessory);
+    if (!err) {
+        err = ControllerRemovePairing(adminConnection, &controllers[0], options.timeout);
+        ConnectionClose(adminConnection);
+    }
+    if (err) {
+        fprintf(stderr, "Failed to unpair the accessory.\n");
+        status = EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < kNumOperations; i++) {
+        free(operationStatistics[i].samples);
+    }
+    free(setupStatistics.samples);
+    free(pollSessions);
+    free(pollFDs);
+    free(sessions);
+    free(adminConnection);
+    return status;
+}
@@ -0,0 +1,95 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+// Converts a trace that has been serialized with HAPTraceSerialize to the Chrome trace event JSON format.
+// The output can be loaded into chrome://tracing or https://ui.perfetto.dev.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "HAP+Internal.h"
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <trace file>\n", argc ? argv[0] : "TraceDump");
+        return EXIT_FAILURE;
+    }
+
+    FILE* file = fopen(argv[1], "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    uint8_t header[kHAPTrace_NumHeaderBytes];
+    if (fread(header, 1, sizeof header, file) != sizeof header || !HAPRawBufferAreEqual(header, "HAPTRACE", 8)) {
+        fprintf(stderr, "%s is not a trace file.\n", argv[1]);
+        fclose(file);
+        return EXIT_FAILURE;
+    }
+    uint32_t version = HAPReadLittleUInt32(&header[8]);
+    if (version != kHAPTrace_Version) {
+        fprintf(stderr, "Unsupported trace version %lu.\n", (unsigned long) version);
+        fclose(file);
+        return EXIT_FAILURE;
+    }
+    uint32_t numRecords = HAPReadLittleUInt32(&header[12]);
+
+    printf("{\"traceEvents\":[");
+    bool isFirstEvent = true;
+    for (uint32_t i = 0; i < numRecords; i++) {
+        uint8_t recordBytes[kHAPTrace_NumRecordBytes];
+        if (fread(recordBytes, 1, sizeof recordBytes, file) != sizeof recordBytes) {
+            fprintf(stderr, "Trace file is truncated after %lu records.\n", (unsigned long) i);
+            break;
+        }
+        HAPTime timestamp = HAPReadLittleUInt64(&recordBytes[0]);
+        uint32_t sequenceNumber = HAPReadLittleUInt32(&recordBytes[8]);
+        uint16_t event = HAPReadLittleUInt16(&recordBytes[12]);
+        HAPTracePhase phase = recordBytes[14];
+        uint32_t arg0 = HAPReadLittleUInt32(&recordBytes[16]);
+        uint32_t arg1 = HAPReadLittleUInt32(&recordBytes[20]);
+
+        const char* phaseString;
+        switch (phase) {
+            case kHAPTracePhase_Begin: {
+                phaseString = "B";
+            } break;
+            case kHAPTracePhase_End: {
+                phaseString = "E";
+            } break;
+            case kHAPTracePhase_Instant: {
+                phaseString = "i";
+            } break;
+            default: {
+                fprintf(stderr, "Skipping record %lu with unknown phase %u.\n", (unsigned long) sequenceNumber, phase);
+                continue;
+            }
+        }
+        const char* _Nullable name = event <= UINT8_MAX ? HAPTraceEventGetName((HAPTraceEvent) event) : NULL;
+
+        // Timestamps are in milliseconds. Chrome expects microseconds.
+        printf("%s\n{\"name\":", isFirstEvent ? "" : ",");
+        isFirstEvent = false;
+        if (name) {
+            printf("\"%s\"", name);
+        } else {
+            printf("\"Event%u\"", event);
+        }
+        printf(",\"ph\":\"%s\",\"ts\":%" PRIu64 ",\"pid\":1,\"tid\":1,"
+               "\"args\":{\"seq\":%lu,\"arg0\":%lu,\"arg1\":%lu}}",
+               phaseString,
+               timestamp * 1000,
+               (unsigned long) sequenceNumber,
+               (unsigned long) arg0,
+               (unsigned long) arg1);
+    }
+    printf("\n]}\n");
+
+    fclose(file);
+    return EXIT_SUCCESS;
+}